@@ -58,6 +58,7 @@ HEADERS += \
     ../../../src/libtsduck/tsBetterSystemRandomGenerator.h \
     ../../../src/libtsduck/tsBinaryTable.h \
     ../../../src/libtsduck/tsBitRateRegulator.h \
+    ../../../src/libtsduck/tsBitrateTimeSeries.h \
     ../../../src/libtsduck/tsBitStream.h \
     ../../../src/libtsduck/tsBlockCipher.h \
     ../../../src/libtsduck/tsBouquetNameDescriptor.h \
@@ -178,6 +179,7 @@ HEADERS += \
     ../../../src/libtsduck/tsIntegerUtils.h \
     ../../../src/libtsduck/tsIntegerUtilsTemplate.h \
     ../../../src/libtsduck/tsInterruptHandler.h \
+    ../../../src/libtsduck/tsIOUring.h \
     ../../../src/libtsduck/tsIPAddress.h \
     ../../../src/libtsduck/tsIPAddressMask.h \
     ../../../src/libtsduck/tsIPMACGenericStreamLocationDescriptor.h \
@@ -193,6 +195,7 @@ HEADERS += \
     ../../../src/libtsduck/tsLinkageDescriptor.h \
     ../../../src/libtsduck/tsLNB.h \
     ../../../src/libtsduck/tsLocalTimeOffsetDescriptor.h \
+    ../../../src/libtsduck/tsLogHistogram.h \
     ../../../src/libtsduck/tsLogicalChannelNumberDescriptor.h \
     ../../../src/libtsduck/tsMACAddress.h \
     ../../../src/libtsduck/tsMain.h \
@@ -204,6 +207,9 @@ HEADERS += \
     ../../../src/libtsduck/tsMessagePriorityQueueTemplate.h \
     ../../../src/libtsduck/tsMessageQueue.h \
     ../../../src/libtsduck/tsMessageQueueTemplate.h \
+    ../../../src/libtsduck/tsMetricsProviderInterface.h \
+    ../../../src/libtsduck/tsMetricsServer.h \
+    ../../../src/libtsduck/tsMetricsWriter.h \
     ../../../src/libtsduck/tsMJD.h \
     ../../../src/libtsduck/tsModulation.h \
     ../../../src/libtsduck/tsMonotonic.h \
@@ -238,6 +244,7 @@ HEADERS += \
     ../../../src/libtsduck/tsParentalRatingDescriptor.h \
     ../../../src/libtsduck/tsPartialTransportStreamDescriptor.h \
     ../../../src/libtsduck/tsPAT.h \
+    ../../../src/libtsduck/tsPcapFile.h \
     ../../../src/libtsduck/tsPCR.h \
     ../../../src/libtsduck/tsPCRAnalyzer.h \
     ../../../src/libtsduck/tsPCRRegulator.h \
@@ -277,6 +284,7 @@ HEADERS += \
     ../../../src/libtsduck/tsResidentBufferTemplate.h \
     ../../../src/libtsduck/tsRingNode.h \
     ../../../src/libtsduck/tsRST.h \
+    ../../../src/libtsduck/tsRTPReorderBuffer.h \
     ../../../src/libtsduck/tsS2SatelliteDeliverySystemDescriptor.h \
     ../../../src/libtsduck/tsSafePtr.h \
     ../../../src/libtsduck/tsSafePtrTemplate.h \
@@ -305,6 +313,7 @@ HEADERS += \
     ../../../src/libtsduck/tsSHA256.h \
     ../../../src/libtsduck/tsSHA512.h \
     ../../../src/libtsduck/tsSharedLibrary.h \
+    ../../../src/libtsduck/tsSharedMemoryRing.h \
     ../../../src/libtsduck/tsShortEventDescriptor.h \
     ../../../src/libtsduck/tsSimpleApplicationBoundaryDescriptor.h \
     ../../../src/libtsduck/tsSimpleApplicationLocationDescriptor.h \
@@ -398,6 +407,8 @@ HEADERS += \
     ../../../src/libtsduck/tstlvStreamMessage.h \
     ../../../src/libtsduck/tsTLVSyntax.h \
     ../../../src/libtsduck/tsTOT.h \
+    ../../../src/libtsduck/tsTR101290Analyzer.h \
+    ../../../src/libtsduck/tsTR101290HandlerInterface.h \
     ../../../src/libtsduck/tsTransportProtocolDescriptor.h \
     ../../../src/libtsduck/tsTransportStreamDescriptor.h \
     ../../../src/libtsduck/tsTransportStreamId.h \
@@ -409,11 +420,17 @@ HEADERS += \
     ../../../src/libtsduck/tsTSFileInputBuffered.h \
     ../../../src/libtsduck/tsTSFileOutput.h \
     ../../../src/libtsduck/tsTSFileOutputResync.h \
+    ../../../src/libtsduck/tsTSFileRecorder.h \
     ../../../src/libtsduck/tsTSPacket.h \
+    ../../../src/libtsduck/tsTSPacketIndex.h \
     ../../../src/libtsduck/tsTSPacketQueue.h \
     ../../../src/libtsduck/tsTSScanner.h \
     ../../../src/libtsduck/tsTSScrambling.h \
+    ../../../src/libtsduck/tsTSSparseDecoder.h \
+    ../../../src/libtsduck/tsTSSparseEncoder.h \
     ../../../src/libtsduck/tsTSSpeedMetrics.h \
+    ../../../src/libtsduck/tsTSTDAnalyzer.h \
+    ../../../src/libtsduck/tsTSTDHandlerInterface.h \
     ../../../src/libtsduck/tsTuner.h \
     ../../../src/libtsduck/tsTunerArgs.h \
     ../../../src/libtsduck/tsTunerParameters.h \
@@ -509,6 +526,7 @@ SOURCES += \
     ../../../src/libtsduck/tsBetterSystemRandomGenerator.cpp \
     ../../../src/libtsduck/tsBinaryTable.cpp \
     ../../../src/libtsduck/tsBitRateRegulator.cpp \
+    ../../../src/libtsduck/tsBitrateTimeSeries.cpp \
     ../../../src/libtsduck/tsBlockCipher.cpp \
     ../../../src/libtsduck/tsBouquetNameDescriptor.cpp \
     ../../../src/libtsduck/tsByteBlock.cpp \
@@ -600,6 +618,7 @@ SOURCES += \
     ../../../src/libtsduck/tsInputRedirector.cpp \
     ../../../src/libtsduck/tsINT.cpp \
     ../../../src/libtsduck/tsIntegerUtils.cpp \
+    ../../../src/libtsduck/tsIOUring.cpp \
     ../../../src/libtsduck/tsIPAddress.cpp \
     ../../../src/libtsduck/tsIPAddressMask.cpp \
     ../../../src/libtsduck/tsIPMACGenericStreamLocationDescriptor.cpp \
@@ -615,12 +634,15 @@ SOURCES += \
     ../../../src/libtsduck/tsLinkageDescriptor.cpp \
     ../../../src/libtsduck/tsLNB.cpp \
     ../../../src/libtsduck/tsLocalTimeOffsetDescriptor.cpp \
+    ../../../src/libtsduck/tsLogHistogram.cpp \
     ../../../src/libtsduck/tsLogicalChannelNumberDescriptor.cpp \
     ../../../src/libtsduck/tsMACAddress.cpp \
     ../../../src/libtsduck/tsMaximumBitrateDescriptor.cpp \
     ../../../src/libtsduck/tsMD5.cpp \
     ../../../src/libtsduck/tsMemoryUtils.cpp \
     ../../../src/libtsduck/tsMessageDescriptor.cpp \
+    ../../../src/libtsduck/tsMetricsServer.cpp \
+    ../../../src/libtsduck/tsMetricsWriter.cpp \
     ../../../src/libtsduck/tsMJD.cpp \
     ../../../src/libtsduck/tsModulation.cpp \
     ../../../src/libtsduck/tsMonotonic.cpp \
@@ -652,6 +674,7 @@ SOURCES += \
     ../../../src/libtsduck/tsParentalRatingDescriptor.cpp \
     ../../../src/libtsduck/tsPartialTransportStreamDescriptor.cpp \
     ../../../src/libtsduck/tsPAT.cpp \
+    ../../../src/libtsduck/tsPcapFile.cpp \
     ../../../src/libtsduck/tsPCR.cpp \
     ../../../src/libtsduck/tsPCRAnalyzer.cpp \
     ../../../src/libtsduck/tsPCRRegulator.cpp \
@@ -680,6 +703,7 @@ SOURCES += \
     ../../../src/libtsduck/tsReportWithPrefix.cpp \
     ../../../src/libtsduck/tsRingNode.cpp \
     ../../../src/libtsduck/tsRST.cpp \
+    ../../../src/libtsduck/tsRTPReorderBuffer.cpp \
     ../../../src/libtsduck/tsS2SatelliteDeliverySystemDescriptor.cpp \
     ../../../src/libtsduck/tsSatelliteDeliverySystemDescriptor.cpp \
     ../../../src/libtsduck/tsScramblingDescriptor.cpp \
@@ -701,6 +725,7 @@ SOURCES += \
     ../../../src/libtsduck/tsSHA256.cpp \
     ../../../src/libtsduck/tsSHA512.cpp \
     ../../../src/libtsduck/tsSharedLibrary.cpp \
+    ../../../src/libtsduck/tsSharedMemoryRing.cpp \
     ../../../src/libtsduck/tsShortEventDescriptor.cpp \
     ../../../src/libtsduck/tsSimpleApplicationBoundaryDescriptor.cpp \
     ../../../src/libtsduck/tsSimpleApplicationLocationDescriptor.cpp \
@@ -779,6 +804,7 @@ SOURCES += \
     ../../../src/libtsduck/tstlvSerializer.cpp \
     ../../../src/libtsduck/tsTLVSyntax.cpp \
     ../../../src/libtsduck/tsTOT.cpp \
+    ../../../src/libtsduck/tsTR101290Analyzer.cpp \
     ../../../src/libtsduck/tsTransportProtocolDescriptor.cpp \
     ../../../src/libtsduck/tsTransportStreamDescriptor.cpp \
     ../../../src/libtsduck/tsTSAnalyzer.cpp \
@@ -789,11 +815,16 @@ SOURCES += \
     ../../../src/libtsduck/tsTSFileInputBuffered.cpp \
     ../../../src/libtsduck/tsTSFileOutput.cpp \
     ../../../src/libtsduck/tsTSFileOutputResync.cpp \
+    ../../../src/libtsduck/tsTSFileRecorder.cpp \
     ../../../src/libtsduck/tsTSPacket.cpp \
+    ../../../src/libtsduck/tsTSPacketIndex.cpp \
     ../../../src/libtsduck/tsTSPacketQueue.cpp \
     ../../../src/libtsduck/tsTSScanner.cpp \
     ../../../src/libtsduck/tsTSScrambling.cpp \
+    ../../../src/libtsduck/tsTSSparseDecoder.cpp \
+    ../../../src/libtsduck/tsTSSparseEncoder.cpp \
     ../../../src/libtsduck/tsTSSpeedMetrics.cpp \
+    ../../../src/libtsduck/tsTSTDAnalyzer.cpp \
     ../../../src/libtsduck/tsTunerArgs.cpp \
     ../../../src/libtsduck/tsTunerParameters.cpp \
     ../../../src/libtsduck/tsTunerParametersATSC.cpp \
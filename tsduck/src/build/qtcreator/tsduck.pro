@@ -71,6 +71,7 @@ SUBDIRS += \
     tsplugin_null \
     tsplugin_pat \
     tsplugin_pattern \
+    tsplugin_pcap \
     tsplugin_pcrbitrate \
     tsplugin_pcrextract \
     tsplugin_pcrverify \
@@ -86,6 +87,7 @@ SUBDIRS += \
     tsplugin_scrambler \
     tsplugin_sdt \
     tsplugin_sections \
+    tsplugin_shm \
     tsplugin_sifilter \
     tsplugin_skip \
     tsplugin_slice \
@@ -95,10 +97,13 @@ SUBDIRS += \
     tsplugin_svrename \
     tsplugin_t2mi \
     tsplugin_tables \
+    tsplugin_tcp \
     tsplugin_teletext \
     tsplugin_time \
     tsplugin_timeref \
+    tsplugin_tr101290 \
     tsplugin_tsrename \
+    tsplugin_tstd \
     tsplugin_until \
     tsplugin_zap \
     utest \
@@ -109,11 +114,13 @@ SUBDIRS += \
     tsdektec \
     tsdump \
     tsecmg \
+    tsecmgload \
     tsemmg \
     tsfixcc \
     tsftrunc \
     tsgenecm \
     tshides \
+    tsindex \
     tslsdvb \
     tsp \
     tspacketize \
@@ -0,0 +1,3 @@
+CONFIG += tstool
+TARGET = tsecmgload
+include(../tsduck.pri)
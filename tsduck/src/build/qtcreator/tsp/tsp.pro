@@ -6,6 +6,7 @@ SOURCES += \
     ../../../src/tstools/tspInputExecutor.cpp \
     ../../../src/tstools/tspJointTermination.cpp \
     ../../../src/tstools/tspOptions.cpp \
+    ../../../src/tstools/tspOutputBranch.cpp \
     ../../../src/tstools/tspOutputExecutor.cpp \
     ../../../src/tstools/tspPluginExecutor.cpp \
     ../../../src/tstools/tspProcessorExecutor.cpp
@@ -14,6 +15,7 @@ HEADERS += \
     ../../../src/tstools/tspInputExecutor.h \
     ../../../src/tstools/tspJointTermination.h \
     ../../../src/tstools/tspOptions.h \
+    ../../../src/tstools/tspOutputBranch.h \
     ../../../src/tstools/tspOutputExecutor.h \
     ../../../src/tstools/tspPluginExecutor.h \
     ../../../src/tstools/tspProcessorExecutor.h
@@ -0,0 +1,3 @@
+CONFIG += tsplugin
+TARGET = tsplugin_tr101290
+include(../tsduck.pri)
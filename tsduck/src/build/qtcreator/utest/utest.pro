@@ -17,6 +17,7 @@ SOURCES += \
     ../../../src/utest/utestAlgorithm.cpp \
     ../../../src/utest/utestArgs.cpp \
     ../../../src/utest/utestBitStream.cpp \
+    ../../../src/utest/utestBitrateTimeSeries.cpp \
     ../../../src/utest/utestByteBlock.cpp \
     ../../../src/utest/utestConfig.cpp \
     ../../../src/utest/utestCppUnitMain.cpp \
@@ -33,15 +34,20 @@ SOURCES += \
     ../../../src/utest/utestGuard.cpp \
     ../../../src/utest/utestInterrupt.cpp \
     ../../../src/utest/utestJSON.cpp \
+    ../../../src/utest/utestLogHistogram.cpp \
     ../../../src/utest/utestMessageQueue.cpp \
     ../../../src/utest/utestMPEPacket.cpp \
+    ../../../src/utest/utestMetricsWriter.cpp \
     ../../../src/utest/utestMonotonic.cpp \
     ../../../src/utest/utestMutex.cpp \
     ../../../src/utest/utestNames.cpp \
     ../../../src/utest/utestNetworking.cpp \
+    ../../../src/utest/utestPCRAnalyzer.cpp \
     ../../../src/utest/utestPacketizer.cpp \
+    ../../../src/utest/utestPcapFile.cpp \
     ../../../src/utest/utestPlatform.cpp \
     ../../../src/utest/utestPlugin.cpp \
+    ../../../src/utest/utestRTPReorderBuffer.cpp \
     ../../../src/utest/utestReport.cpp \
     ../../../src/utest/utestResidentBuffer.cpp \
     ../../../src/utest/utestRing.cpp \
@@ -49,10 +55,17 @@ SOURCES += \
     ../../../src/utest/utestScrambling.cpp \
     ../../../src/utest/utestSection.cpp \
     ../../../src/utest/utestSectionFile.cpp \
+    ../../../src/utest/utestSharedMemoryRing.cpp \
     ../../../src/utest/utestSingleton.cpp \
     ../../../src/utest/utestStaticInstance.cpp \
     ../../../src/utest/utestSystemRandomGenerator.cpp \
     ../../../src/utest/utestSysUtils.cpp \
+    ../../../src/utest/utestTR101290Analyzer.cpp \
+    ../../../src/utest/utestTSAnalyzer.cpp \
+    ../../../src/utest/utestTSFile.cpp \
+    ../../../src/utest/utestTSPacketQueue.cpp \
+    ../../../src/utest/utestTSSparse.cpp \
+    ../../../src/utest/utestTSTDAnalyzer.cpp \
     ../../../src/utest/utestTable.cpp \
     ../../../src/utest/utestTablesFactory.cpp \
     ../../../src/utest/utestTagLengthValue.cpp \
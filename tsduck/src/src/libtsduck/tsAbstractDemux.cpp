@@ -123,6 +123,10 @@ void ts::AbstractDemux::immediateReset()
 {
 }
 
+void ts::AbstractDemux::syncLost()
+{
+}
+
 void ts::AbstractDemux::immediateResetPID(PID pid)
 {
 }
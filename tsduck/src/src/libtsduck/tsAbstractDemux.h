@@ -124,6 +124,14 @@ namespace ts {
         //!
         virtual void resetPID(PID pid);
 
+        //!
+        //! Declare that the packet synchronization is lost on all PID's.
+        //! Useful when packets were skipped: the continuity counters may look
+        //! correct across the gap. Forget all partially demuxed data on all PID's
+        //! but keep the other PID contexts. Not to be invoked in a handler.
+        //!
+        virtual void syncLost();
+
         //!
         //! Set some arbitrary "demux id" value.
         //! This value is chosen and set by the application.
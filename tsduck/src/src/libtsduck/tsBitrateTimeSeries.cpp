@@ -0,0 +1,474 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsBitrateTimeSeries.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::BitrateTimeSeries::DEFAULT_MAX_SERIES;
+const size_t ts::BitrateTimeSeries::DEFAULT_SECONDS;
+const size_t ts::BitrateTimeSeries::DEFAULT_MINUTES;
+const size_t ts::BitrateTimeSeries::DEFAULT_HOURS;
+const ts::BitrateTimeSeries::SeriesIndex ts::BitrateTimeSeries::NO_SERIES;
+#endif
+
+const ts::Enumeration ts::BitrateTimeSeries::ResolutionNames({
+    {u"seconds", ts::BitrateTimeSeries::SECONDS},
+    {u"minutes", ts::BitrateTimeSeries::MINUTES},
+    {u"hours",   ts::BitrateTimeSeries::HOURS},
+});
+
+const ts::Enumeration ts::BitrateTimeSeries::SeriesTypeNames({
+    {u"ts",      ts::BitrateTimeSeries::TS_SERIES},
+    {u"pid",     ts::BitrateTimeSeries::PID_SERIES},
+    {u"service", ts::BitrateTimeSeries::SERVICE_SERIES},
+});
+
+
+//----------------------------------------------------------------------------
+// Constructors.
+//----------------------------------------------------------------------------
+
+ts::BitrateTimeSeries::Accumulator::Accumulator() :
+    sum(0),
+    min_bitrate(0),
+    max_bitrate(0)
+{
+}
+
+ts::BitrateTimeSeries::Series::Series() :
+    type(TS_SERIES),
+    id(0),
+    pids(),
+    packets(0),
+    first(0),
+    acc()
+{
+}
+
+ts::BitrateTimeSeries::Level::Level() :
+    depth(0),
+    offset(0),
+    next(0)
+{
+}
+
+ts::BitrateTimeSeries::BitrateTimeSeries(size_t max_series, size_t seconds, size_t minutes, size_t hours) :
+    _max_series(max_series),
+    _series_size(0),
+    _auto_pids(false),
+    _start(),
+    _second(0),
+    _merged(),
+    _completed(),
+    _levels(),
+    _series(),
+    _buckets(),
+    _services(),
+    _pid_series()
+{
+    // Layout of the ring buffers of one series: all seconds, all minutes, all hours.
+    _levels[SECONDS].depth = std::max<size_t>(1, seconds);
+    _levels[MINUTES].depth = std::max<size_t>(1, minutes);
+    _levels[HOURS].depth = std::max<size_t>(1, hours);
+    for (size_t res = 0; res < RESOLUTION_COUNT; ++res) {
+        _levels[res].offset = _series_size;
+        _series_size += _levels[res].depth;
+    }
+
+    // Allocate everything now, the TS series is always present.
+    _series.reserve(_max_series + 1);
+    _services.reserve(_max_series);
+    _buckets.resize((_max_series + 1) * _series_size);
+    reset();
+}
+
+
+//----------------------------------------------------------------------------
+// Static properties of resolutions.
+//----------------------------------------------------------------------------
+
+ts::MilliSecond ts::BitrateTimeSeries::BucketDuration(Resolution res)
+{
+    switch (res) {
+        case SECONDS: return MilliSecPerSec;
+        case MINUTES: return MilliSecPerMin;
+        case HOURS: return MilliSecPerHour;
+        case RESOLUTION_COUNT:
+        default: return 0;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Reset all series.
+//----------------------------------------------------------------------------
+
+void ts::BitrateTimeSeries::reset(const Time& start)
+{
+    _start = start;
+    _second = 0;
+    for (size_t res = 0; res < RESOLUTION_COUNT; ++res) {
+        _merged[res] = 0;
+        _completed[res] = 0;
+        _levels[res].next = 0;
+    }
+    _series.clear();
+    _series.push_back(Series());
+    _services.clear();
+    std::fill(_buckets.begin(), _buckets.end(), Bucket());
+    std::fill(_pid_series, _pid_series + PID_MAX, NO_SERIES);
+}
+
+
+//----------------------------------------------------------------------------
+// Allocate a new series.
+//----------------------------------------------------------------------------
+
+ts::BitrateTimeSeries::SeriesIndex ts::BitrateTimeSeries::newSeries(SeriesType type, uint16_t id)
+{
+    if (_series.size() > _max_series) {
+        return NO_SERIES;
+    }
+    else {
+        // Within reserved capacity, no reallocation.
+        const SeriesIndex index = SeriesIndex(_series.size());
+        _series.push_back(Series());
+        _series[index].type = type;
+        _series[index].id = id;
+        // When packets were already counted in the current second, start at the next one.
+        _series[index].first = _series[0].packets == 0 ? _second : _second + 1;
+        return index;
+    }
+}
+
+bool ts::BitrateTimeSeries::addPID(PID pid)
+{
+    if (pid >= PID_MAX) {
+        return false;
+    }
+    if (_pid_series[pid] == NO_SERIES) {
+        _pid_series[pid] = newSeries(PID_SERIES, pid);
+    }
+    return _pid_series[pid] != NO_SERIES;
+}
+
+bool ts::BitrateTimeSeries::setService(uint16_t service_id, const PIDSet& pids)
+{
+    SeriesIndex index = serviceIndex(service_id);
+    if (index == NO_SERIES && (index = newSeries(SERVICE_SERIES, service_id)) != NO_SERIES) {
+        _services.push_back(index);
+    }
+    if (index != NO_SERIES) {
+        _series[index].pids = pids;
+    }
+    return index != NO_SERIES;
+}
+
+ts::BitrateTimeSeries::SeriesIndex ts::BitrateTimeSeries::serviceIndex(uint16_t service_id) const
+{
+    for (auto it = _services.begin(); it != _services.end(); ++it) {
+        if (_series[*it].id == service_id) {
+            return *it;
+        }
+    }
+    return NO_SERIES;
+}
+
+
+//----------------------------------------------------------------------------
+// Feed the time series.
+//----------------------------------------------------------------------------
+
+bool ts::BitrateTimeSeries::feedPacket(const TSPacket& pkt, MilliSecond time)
+{
+    const bool completed = advance(time);
+    const PID pid = pkt.getPID();
+
+    _series[0].packets++;
+    if (_pid_series[pid] == NO_SERIES && _auto_pids && addPID(pid)) {
+        // This is the first packet of the PID, no previous packet was missed.
+        _series[_pid_series[pid]].first = _second;
+    }
+    if (_pid_series[pid] != NO_SERIES && _series[_pid_series[pid]].first <= _second) {
+        _series[_pid_series[pid]].packets++;
+    }
+    for (auto it = _services.begin(); it != _services.end(); ++it) {
+        if (_series[*it].pids.test(pid) && _series[*it].first <= _second) {
+            _series[*it].packets++;
+        }
+    }
+    return completed;
+}
+
+bool ts::BitrateTimeSeries::advance(MilliSecond time)
+{
+    const MilliSecond second = time / MilliSecPerSec;
+    if (second <= _second) {
+        return false;
+    }
+
+    // Close the current second. All subsequent seconds up to the new one are empty.
+    closeSecond();
+    if (second > _second + 1) {
+        skipBuckets(SECONDS, size_t(second - _second - 1));
+    }
+    _second = second;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Close the current second and propagate to lower resolutions.
+//----------------------------------------------------------------------------
+
+void ts::BitrateTimeSeries::closeSecond()
+{
+    Level& level(_levels[SECONDS]);
+    for (size_t i = 0; i < _series.size(); ++i) {
+        Series& ser(_series[i]);
+        const BitRate bitrate = BitRate(ser.packets * PKT_SIZE_BITS);
+        Bucket& bk(_buckets[i * _series_size + level.offset + level.next]);
+        bk.bitrate = bk.min_bitrate = bk.max_bitrate = bitrate;
+        ser.packets = 0;
+
+        // Accumulate in current minute.
+        Accumulator& acc(ser.acc[MINUTES]);
+        acc.sum += bitrate;
+        acc.min_bitrate = _merged[MINUTES] == 0 ? bitrate : std::min(acc.min_bitrate, bitrate);
+        acc.max_bitrate = _merged[MINUTES] == 0 ? bitrate : std::max(acc.max_bitrate, bitrate);
+    }
+    level.next = (level.next + 1) % level.depth;
+    _completed[SECONDS]++;
+
+    if (++_merged[MINUTES] == 60) {
+        closeBucket(MINUTES);
+    }
+}
+
+void ts::BitrateTimeSeries::closeBucket(Resolution res)
+{
+    Level& level(_levels[res]);
+    const Resolution upper = Resolution(res + 1);
+    for (size_t i = 0; i < _series.size(); ++i) {
+        Series& ser(_series[i]);
+        Accumulator& acc(ser.acc[res]);
+        Bucket& bk(_buckets[i * _series_size + level.offset + level.next]);
+        bk.bitrate = BitRate(acc.sum / _merged[res]);
+        bk.min_bitrate = acc.min_bitrate;
+        bk.max_bitrate = acc.max_bitrate;
+        acc = Accumulator();
+
+        // Accumulate in the next resolution.
+        if (upper < RESOLUTION_COUNT) {
+            Accumulator& up(ser.acc[upper]);
+            up.sum += bk.bitrate;
+            up.min_bitrate = _merged[upper] == 0 ? bk.min_bitrate : std::min(up.min_bitrate, bk.min_bitrate);
+            up.max_bitrate = _merged[upper] == 0 ? bk.max_bitrate : std::max(up.max_bitrate, bk.max_bitrate);
+        }
+    }
+    level.next = (level.next + 1) % level.depth;
+    _completed[res]++;
+    _merged[res] = 0;
+
+    if (upper < RESOLUTION_COUNT && ++_merged[upper] == 60) {
+        closeBucket(upper);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Complete empty buckets after a long time without packet.
+// The result is identical to closing the empty buckets one by one.
+//----------------------------------------------------------------------------
+
+void ts::BitrateTimeSeries::skipBuckets(Resolution res, size_t count)
+{
+    // Clear the empty buckets in the ring buffers, at most the complete rings.
+    Level& level(_levels[res]);
+    const size_t clear = std::min(count, level.depth);
+    for (size_t i = 0; i < _series.size(); ++i) {
+        Bucket* const ring = &_buckets[i * _series_size + level.offset];
+        for (size_t k = 0; k < clear; ++k) {
+            ring[(level.next + k) % level.depth] = Bucket();
+        }
+    }
+    level.next = (level.next + count) % level.depth;
+    _completed[res] += count;
+
+    // Propagate to the next resolution: complete its current bucket, skip its
+    // subsequent empty buckets and start its new current bucket.
+    const Resolution upper = Resolution(res + 1);
+    if (upper < RESOLUTION_COUNT) {
+        const size_t first = std::min<size_t>(count, 60 - _merged[upper]);
+        addEmpty(upper, first);
+        count -= first;
+        if (_merged[upper] == 60) {
+            closeBucket(upper);
+        }
+        if (count >= 60) {
+            skipBuckets(upper, count / 60);
+        }
+        addEmpty(upper, count % 60);
+    }
+}
+
+void ts::BitrateTimeSeries::addEmpty(Resolution res, size_t count)
+{
+    if (count > 0) {
+        for (size_t i = 0; i < _series.size(); ++i) {
+            Accumulator& acc(_series[i].acc[res]);
+            acc.min_bitrate = 0;
+            acc.max_bitrate = _merged[res] == 0 ? 0 : acc.max_bitrate;
+        }
+        _merged[res] += count;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Access completed buckets.
+//----------------------------------------------------------------------------
+
+const ts::BitrateTimeSeries::Bucket& ts::BitrateTimeSeries::bucket(SeriesIndex index, Resolution res, size_t age) const
+{
+    const Level& level(_levels[res]);
+    return _buckets[index * _series_size + level.offset + (level.next + level.depth - 1 - age) % level.depth];
+}
+
+ts::BitRate ts::BitrateTimeSeries::averageBitrate(SeriesIndex index, Resolution res, size_t count) const
+{
+    count = std::min(count, bucketCount(res));
+    if (index == NO_SERIES || count == 0) {
+        return 0;
+    }
+    uint64_t sum = 0;
+    for (size_t age = 0; age < count; ++age) {
+        sum += bucket(index, res, age).bitrate;
+    }
+    return BitRate(sum / count);
+}
+
+ts::BitRate ts::BitrateTimeSeries::tsBitrate(Resolution res, size_t count) const
+{
+    return averageBitrate(0, res, count);
+}
+
+ts::BitRate ts::BitrateTimeSeries::pidBitrate(PID pid, Resolution res, size_t count) const
+{
+    return pid < PID_MAX ? averageBitrate(_pid_series[pid], res, count) : 0;
+}
+
+ts::BitRate ts::BitrateTimeSeries::serviceBitrate(uint16_t service_id, Resolution res, size_t count) const
+{
+    return averageBitrate(serviceIndex(service_id), res, count);
+}
+
+bool ts::BitrateTimeSeries::getPIDBuckets(std::vector<Bucket>& buckets, PID pid, Resolution res) const
+{
+    buckets.clear();
+    if (!hasPID(pid) || res >= RESOLUTION_COUNT) {
+        return false;
+    }
+    const size_t count = bucketCount(res);
+    buckets.reserve(count);
+    for (size_t age = count; age > 0; --age) {
+        buckets.push_back(bucket(_pid_series[pid], res, age - 1));
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Export all series.
+//----------------------------------------------------------------------------
+
+void ts::BitrateTimeSeries::reportCSV(std::ostream& strm, const UString& separator) const
+{
+    strm << "resolution" << separator << "time" << separator << "type" << separator << "id" << separator
+         << "bitrate" << separator << "min_bitrate" << separator << "max_bitrate" << std::endl;
+
+    for (size_t res = 0; res < RESOLUTION_COUNT; ++res) {
+        const size_t count = bucketCount(Resolution(res));
+        const MilliSecond duration = BucketDuration(Resolution(res));
+        const UString res_name(ResolutionNames.name(int(res)));
+        for (size_t age = count; age > 0; --age) {
+            // Start time of the bucket.
+            const Time time(_start + MilliSecond(_completed[res] - age) * duration);
+            const UString time_name(time.format(Time::DATE | Time::TIME));
+            for (size_t i = 0; i < _series.size(); ++i) {
+                const Bucket& bk(bucket(SeriesIndex(i), Resolution(res), age - 1));
+                strm << res_name << separator << time_name << separator
+                     << SeriesTypeNames.name(_series[i].type) << separator << _series[i].id << separator
+                     << bk.bitrate << separator << bk.min_bitrate << separator << bk.max_bitrate << std::endl;
+            }
+        }
+    }
+}
+
+ts::json::ValuePtr ts::BitrateTimeSeries::toJSON() const
+{
+    json::ValuePtr root(new json::Object);
+    root->add(u"start", json::ValuePtr(new json::String(_start.format(Time::DATE | Time::TIME))));
+
+    for (size_t res = 0; res < RESOLUTION_COUNT; ++res) {
+        const size_t count = bucketCount(Resolution(res));
+        const MilliSecond duration = BucketDuration(Resolution(res));
+
+        json::ValuePtr jres(new json::Object);
+        jres->add(u"duration-ms", json::ValuePtr(new json::Number(duration)));
+        jres->add(u"first-bucket", json::ValuePtr(new json::String((_start + MilliSecond(_completed[res] - count) * duration).format(Time::DATE | Time::TIME))));
+        jres->add(u"buckets", json::ValuePtr(new json::Number(int64_t(count))));
+
+        json::ValuePtr jseries(new json::Array);
+        for (size_t i = 0; i < _series.size(); ++i) {
+            json::ValuePtr jser(new json::Object);
+            json::ValuePtr jrate(new json::Array);
+            json::ValuePtr jmin(new json::Array);
+            json::ValuePtr jmax(new json::Array);
+            jser->add(u"type", json::ValuePtr(new json::String(SeriesTypeNames.name(_series[i].type))));
+            if (_series[i].type != TS_SERIES) {
+                jser->add(u"id", json::ValuePtr(new json::Number(_series[i].id)));
+            }
+            for (size_t age = count; age > 0; --age) {
+                const Bucket& bk(bucket(SeriesIndex(i), Resolution(res), age - 1));
+                jrate->set(json::ValuePtr(new json::Number(bk.bitrate)));
+                jmin->set(json::ValuePtr(new json::Number(bk.min_bitrate)));
+                jmax->set(json::ValuePtr(new json::Number(bk.max_bitrate)));
+            }
+            jser->add(u"bitrate", jrate);
+            jser->add(u"min-bitrate", jmin);
+            jser->add(u"max-bitrate", jmax);
+            jseries->set(jser);
+        }
+        jres->add(u"series", jseries);
+        root->add(ResolutionNames.name(int(res)), jres);
+    }
+    return root;
+}
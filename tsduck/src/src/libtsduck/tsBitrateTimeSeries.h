@@ -0,0 +1,337 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Per-PID and per-service bitrate time series with downsampling.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+#include "tsEnumeration.h"
+#include "tsTime.h"
+#include "tsjson.h"
+
+namespace ts {
+    //!
+    //! Per-PID and per-service bitrate time series with downsampling.
+    //! @ingroup mpeg
+    //!
+    //! The bitrates of the complete transport stream, of some PID's and of some services
+    //! are recorded in multi-resolution ring buffers: one bucket per second, per minute and
+    //! per hour. Each ring keeps a fixed number of buckets, the oldest ones are overwritten.
+    //! A minute bucket is built from 60 second buckets and an hour bucket from 60 minute
+    //! buckets. Each bucket keeps the average, minimum and maximum one-second bitrates
+    //! over its duration.
+    //!
+    //! All memory is allocated in the constructor, for a maximum number of series.
+    //! Feeding packets never allocates memory.
+    //!
+    //! The time line is provided by the application with each packet, in milliseconds
+    //! from an arbitrary origin, typically the wall clock time since the start of the
+    //! recording. The absolute start time is only used to time-stamp the exported series.
+    //!
+    class TSDUCKDLL BitrateTimeSeries
+    {
+    public:
+        //!
+        //! Resolutions of the time series.
+        //!
+        enum Resolution {
+            SECONDS,          //!< One bucket per second.
+            MINUTES,          //!< One bucket per minute.
+            HOURS,            //!< One bucket per hour.
+            RESOLUTION_COUNT  //!< Number of resolutions, not a valid resolution.
+        };
+
+        //!
+        //! Names of resolutions.
+        //!
+        static const Enumeration ResolutionNames;
+
+        //!
+        //! Get the duration of a bucket in a resolution.
+        //! @param [in] res A resolution.
+        //! @return The duration of one bucket in milliseconds.
+        //!
+        static MilliSecond BucketDuration(Resolution res);
+
+        //!
+        //! Types of series.
+        //!
+        enum SeriesType {
+            TS_SERIES,       //!< Complete transport stream.
+            PID_SERIES,      //!< One PID.
+            SERVICE_SERIES,  //!< All PID's of one service.
+        };
+
+        //!
+        //! Names of series types.
+        //!
+        static const Enumeration SeriesTypeNames;
+
+        //!
+        //! One bucket of a series.
+        //!
+        struct TSDUCKDLL Bucket
+        {
+            BitRate bitrate;      //!< Average bitrate over the bucket duration.
+            BitRate min_bitrate;  //!< Minimum one-second bitrate in the bucket.
+            BitRate max_bitrate;  //!< Maximum one-second bitrate in the bucket.
+
+            //!
+            //! Default constructor.
+            //!
+            Bucket() : bitrate(0), min_bitrate(0), max_bitrate(0) {}
+        };
+
+        //!
+        //! Default maximum number of PID and service series.
+        //!
+        static const size_t DEFAULT_MAX_SERIES = 128;
+
+        //!
+        //! Default number of one-second buckets: one hour.
+        //!
+        static const size_t DEFAULT_SECONDS = 3600;
+
+        //!
+        //! Default number of one-minute buckets: one day.
+        //!
+        static const size_t DEFAULT_MINUTES = 1440;
+
+        //!
+        //! Default number of one-hour buckets: one week.
+        //!
+        static const size_t DEFAULT_HOURS = 168;
+
+        //!
+        //! Constructor.
+        //! All memory is allocated here.
+        //! @param [in] max_series Maximum number of PID and service series, in addition to the transport stream series.
+        //! @param [in] seconds Number of one-second buckets.
+        //! @param [in] minutes Number of one-minute buckets.
+        //! @param [in] hours Number of one-hour buckets.
+        //!
+        BitrateTimeSeries(size_t max_series = DEFAULT_MAX_SERIES,
+                          size_t seconds = DEFAULT_SECONDS,
+                          size_t minutes = DEFAULT_MINUTES,
+                          size_t hours = DEFAULT_HOURS);
+
+        //!
+        //! Reset all series. The PID and service series are removed.
+        //! @param [in] start Absolute time of the origin of the time line.
+        //!
+        void reset(const Time& start = Time::CurrentUTC());
+
+        //!
+        //! Automatically create a series for each new PID, as long as the maximum number of series is not reached.
+        //! @param [in] on When true, new PID's are automatically recorded. Initially false.
+        //!
+        void setAutoPIDs(bool on) { _auto_pids = on; }
+
+        //!
+        //! Record the bitrate of a PID.
+        //! When the PID is added in the middle of a second, after some packets of that second
+        //! were already fed, its recording starts at the next second: its first bucket is never
+        //! a partial one.
+        //! @param [in] pid The PID to record.
+        //! @return True on success, false if the maximum number of series is reached.
+        //!
+        bool addPID(PID pid);
+
+        //!
+        //! Record the bitrate of a service or update the list of PID's of a service.
+        //! Like addPID(), a new service series starts at the next second when created
+        //! in the middle of a second.
+        //! @param [in] service_id The service id.
+        //! @param [in] pids The PID's of the service.
+        //! @return True on success, false if the maximum number of series is reached.
+        //!
+        bool setService(uint16_t service_id, const PIDSet& pids);
+
+        //!
+        //! Feed the time series with a TS packet.
+        //! @param [in] pkt A TS packet.
+        //! @param [in] time Time of the packet in milliseconds since the origin. Must not decrease.
+        //! @return True when at least one new one-second bucket was completed.
+        //!
+        bool feedPacket(const TSPacket& pkt, MilliSecond time);
+
+        //!
+        //! Advance the time line without packet.
+        //! After a long time without packet, all empty buckets are filled at once,
+        //! the processing time does not depend on the duration of the gap.
+        //! @param [in] time Current time in milliseconds since the origin. Must not decrease.
+        //! @return True when at least one new one-second bucket was completed.
+        //!
+        bool advance(MilliSecond time);
+
+        //!
+        //! Get the number of PID and service series.
+        //! @return The number of PID and service series.
+        //!
+        size_t seriesCount() const { return _series.size() - 1; }
+
+        //!
+        //! Check if a PID is recorded.
+        //! @param [in] pid The PID to check.
+        //! @return True if @a pid is recorded.
+        //!
+        bool hasPID(PID pid) const { return pid < PID_MAX && _pid_series[pid] != NO_SERIES; }
+
+        //!
+        //! Get the number of completed buckets in a resolution.
+        //! @param [in] res The resolution.
+        //! @return The number of completed buckets which are still in memory.
+        //!
+        size_t bucketCount(Resolution res) const { return res < RESOLUTION_COUNT ? std::min(_completed[res], _levels[res].depth) : 0; }
+
+        //!
+        //! Get the average bitrate of the transport stream over the last completed buckets.
+        //! @param [in] res The resolution.
+        //! @param [in] count Number of last completed buckets to average.
+        //! @return The average bitrate.
+        //!
+        BitRate tsBitrate(Resolution res = SECONDS, size_t count = 1) const;
+
+        //!
+        //! Get the average bitrate of a PID over the last completed buckets.
+        //! @param [in] pid The PID.
+        //! @param [in] res The resolution.
+        //! @param [in] count Number of last completed buckets to average.
+        //! @return The average bitrate, zero if the PID is not recorded.
+        //!
+        BitRate pidBitrate(PID pid, Resolution res = SECONDS, size_t count = 1) const;
+
+        //!
+        //! Get the average bitrate of a service over the last completed buckets.
+        //! @param [in] service_id The service id.
+        //! @param [in] res The resolution.
+        //! @param [in] count Number of last completed buckets to average.
+        //! @return The average bitrate, zero if the service is not recorded.
+        //!
+        BitRate serviceBitrate(uint16_t service_id, Resolution res = SECONDS, size_t count = 1) const;
+
+        //!
+        //! Get the completed buckets of a PID.
+        //! @param [out] buckets The completed buckets in memory, from oldest to newest.
+        //! @param [in] pid The PID.
+        //! @param [in] res The resolution.
+        //! @return True on success, false if the PID is not recorded.
+        //!
+        bool getPIDBuckets(std::vector<Bucket>& buckets, PID pid, Resolution res) const;
+
+        //!
+        //! Export all series in CSV format.
+        //! There is one line per bucket and per series, all resolutions.
+        //! @param [in,out] strm Output text stream.
+        //! @param [in] separator Field separator.
+        //!
+        void reportCSV(std::ostream& strm, const UString& separator = u",") const;
+
+        //!
+        //! Build a JSON description of all series.
+        //! @return A JSON object, one array of series per resolution.
+        //!
+        json::ValuePtr toJSON() const;
+
+    private:
+        // Series index in _series.
+        typedef uint16_t SeriesIndex;
+        static const SeriesIndex NO_SERIES = 0xFFFF;
+
+        // Current bucket of a series, being accumulated.
+        struct Accumulator
+        {
+            uint64_t sum;          // Sum of bitrates of sub-buckets.
+            BitRate  min_bitrate;  // Minimum one-second bitrate.
+            BitRate  max_bitrate;  // Maximum one-second bitrate.
+            Accumulator();
+        };
+
+        // Description of one series.
+        struct Series
+        {
+            SeriesType  type;
+            uint16_t    id;        // PID or service id.
+            PIDSet      pids;      // PID's of a service.
+            uint64_t    packets;   // Packets in current second.
+            MilliSecond first;     // Index of first recorded second since origin.
+            Accumulator acc[RESOLUTION_COUNT];  // Current minute and hour buckets.
+            Series();
+        };
+
+        // Description of one resolution.
+        struct Level
+        {
+            size_t depth;    // Number of buckets in ring.
+            size_t offset;   // Offset of first bucket of the level in a series.
+            size_t next;     // Index of next bucket to write in ring.
+            Level();
+        };
+
+        size_t                   _max_series;   // Maximum number of PID and service series.
+        size_t                   _series_size;  // Number of buckets of one series, all resolutions.
+        bool                     _auto_pids;    // Automatically add new PID's.
+        Time                     _start;        // Absolute time of origin.
+        MilliSecond              _second;       // Index of current second since origin.
+        size_t                   _merged[RESOLUTION_COUNT];     // Number of sub-buckets in current bucket.
+        size_t                   _completed[RESOLUTION_COUNT];  // Number of completed buckets since origin.
+        Level                    _levels[RESOLUTION_COUNT];     // Description of ring buffers.
+        std::vector<Series>      _series;       // Index 0 is the TS series.
+        std::vector<Bucket>      _buckets;      // Ring buffers of all series.
+        std::vector<SeriesIndex> _services;     // Indexes of service series.
+        SeriesIndex              _pid_series[PID_MAX];  // Index of series of each PID.
+
+        // Allocate a new series, return NO_SERIES if full.
+        SeriesIndex newSeries(SeriesType type, uint16_t id);
+
+        // Close the current second.
+        void closeSecond();
+
+        // Complete empty buckets of all series in a resolution, after the current one was closed.
+        void skipBuckets(Resolution res, size_t count);
+
+        // Add empty sub-buckets to the current bucket of all series in a resolution.
+        void addEmpty(Resolution res, size_t count);
+
+        // Complete the current bucket of all series in a resolution.
+        void closeBucket(Resolution res);
+
+        // Find the index of a service series.
+        SeriesIndex serviceIndex(uint16_t service_id) const;
+
+        // Average bitrate of a series over the last completed buckets.
+        BitRate averageBitrate(SeriesIndex index, Resolution res, size_t count) const;
+
+        // Access a completed bucket, age 0 is the last completed one.
+        const Bucket& bucket(SeriesIndex index, Resolution res, size_t age) const;
+    };
+}
@@ -205,6 +205,7 @@ namespace ts {
         tlv::Logger            _logger;
         tlv::Connection<Mutex> _connection;     // connection with MUX server
         UDPSocket              _udp_socket;     // where to send data_provision if UDP is used
+        ByteBlock              _udp_buffer;     // reused serialization buffer for UDP data_provision
         emmgmux::ChannelStatus _channel_status; // automatic response to channel_test
         emmgmux::StreamStatus  _stream_status;  // automatic response to stream_test
         Mutex                  _mutex;          // exclusive access to protected fields
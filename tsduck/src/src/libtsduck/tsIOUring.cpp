@@ -0,0 +1,373 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Asynchronous file I/O using the Linux io_uring interface.
+//
+//----------------------------------------------------------------------------
+
+#include "tsIOUring.h"
+#include "tsSysUtils.h"
+#include "tsMemoryUtils.h"
+#include "tsIntegerUtils.h"
+#include "tsNullReport.h"
+
+// The io_uring interface is used through direct system calls when available.
+#if defined(TS_LINUX)
+#include <linux/version.h>
+#include <sys/syscall.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,1,0) && defined(__NR_io_uring_setup)
+#define TS_IO_URING 1
+#include <linux/io_uring.h>
+#endif
+#endif
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::IOUring::BUFFER_ALIGNMENT;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructor.
+//----------------------------------------------------------------------------
+
+ts::IOUring::Buffer::Buffer() :
+    data(nullptr),
+    busy(false),
+    done(false),
+    result(0)
+{
+}
+
+ts::IOUring::IOUring() :
+    _fd(-1),
+    _buffer_size(0),
+    _busy_count(0),
+    _memory(nullptr),
+    _buffers()
+#if defined(TS_LINUX)
+    , _sq_ring(nullptr),
+    _cq_ring(nullptr),
+    _sqes(nullptr),
+    _sq_ring_size(0),
+    _cq_ring_size(0),
+    _sqes_size(0),
+    _sq_tail(nullptr),
+    _sq_mask(0),
+    _sq_array(nullptr),
+    _cq_head(nullptr),
+    _cq_tail(nullptr),
+    _cq_mask(0),
+    _cqes(nullptr),
+    _iovecs()
+#endif
+{
+}
+
+ts::IOUring::~IOUring()
+{
+    close(NULLREP);
+}
+
+
+//----------------------------------------------------------------------------
+// Check if the io_uring interface is supported by the system.
+//----------------------------------------------------------------------------
+
+bool ts::IOUring::IsSupported()
+{
+    IOUring ring;
+    return ring.open(1, BUFFER_ALIGNMENT, NULLREP);
+}
+
+
+//----------------------------------------------------------------------------
+// Create the io_uring and allocate the I/O buffers.
+//----------------------------------------------------------------------------
+
+bool ts::IOUring::open(size_t buffer_count, size_t buffer_size, Report& report)
+{
+    if (_fd >= 0) {
+        report.error(u"io_uring already open");
+        return false;
+    }
+    if (buffer_count == 0 || buffer_size == 0) {
+        report.error(u"invalid io_uring buffers: %d x %d bytes", {buffer_count, buffer_size});
+        return false;
+    }
+
+#if defined(TS_IO_URING)
+
+    // Create the io_uring. Some systems forbid it (seccomp in containers for instance).
+    ::io_uring_params params;
+    TS_ZERO(params);
+    _fd = int(::syscall(__NR_io_uring_setup, unsigned(buffer_count), &params));
+    if (_fd < 0) {
+        report.debug(u"io_uring_setup error: %s", {ErrorCodeMessage()});
+        return false;
+    }
+
+    // Map the submission and completion queues. Recent kernels use one single mapping for both rings.
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+    }
+    _sqes_size = params.sq_entries * sizeof(::io_uring_sqe);
+
+    _sq_ring = ::mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sq_ring == MAP_FAILED) {
+        _sq_ring = nullptr;
+    }
+    else if (single_mmap) {
+        _cq_ring = _sq_ring;
+    }
+    else {
+        _cq_ring = ::mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        if (_cq_ring == MAP_FAILED) {
+            _cq_ring = nullptr;
+        }
+    }
+    if (_cq_ring != nullptr) {
+        _sqes = ::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+        if (_sqes == MAP_FAILED) {
+            _sqes = nullptr;
+        }
+    }
+    if (_sqes == nullptr) {
+        report.error(u"error mapping io_uring queues: %s", {ErrorCodeMessage()});
+        close(report);
+        return false;
+    }
+
+    uint8_t* const sq = reinterpret_cast<uint8_t*>(_sq_ring);
+    uint8_t* const cq = reinterpret_cast<uint8_t*>(_cq_ring);
+    _sq_tail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    _sq_mask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    _sq_array = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    _cq_head = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    _cq_mask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    _cqes = cq + params.cq_off.cqes;
+
+    // Allocate all buffers in one aligned memory area.
+    _buffer_size = RoundUp(buffer_size, BUFFER_ALIGNMENT);
+    void* mem = nullptr;
+    if (::posix_memalign(&mem, BUFFER_ALIGNMENT, buffer_count * _buffer_size) != 0) {
+        report.error(u"cannot allocate %'d bytes of I/O buffers", {buffer_count * _buffer_size});
+        close(report);
+        return false;
+    }
+    _memory = reinterpret_cast<uint8_t*>(mem);
+    _buffers.resize(buffer_count);
+    _iovecs.resize(buffer_count);
+    for (size_t i = 0; i < buffer_count; ++i) {
+        _buffers[i] = Buffer();
+        _buffers[i].data = _memory + i * _buffer_size;
+    }
+    _busy_count = 0;
+    return true;
+
+#else
+    report.debug(u"io_uring is not supported on this system");
+    return false;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Close the io_uring and free the I/O buffers.
+//----------------------------------------------------------------------------
+
+void ts::IOUring::close(Report& report)
+{
+#if defined(TS_IO_URING)
+    // The buffers cannot be freed while the kernel may still access them.
+    for (size_t i = 0; _fd >= 0 && _sqes != nullptr && i < _buffers.size(); ++i) {
+        int result = 0;
+        if (_buffers[i].busy && !complete(i, result, report)) {
+            // Cannot wait for the operation, leak the memory rather than corrupting it.
+            _memory = nullptr;
+            break;
+        }
+    }
+    if (_sqes != nullptr) {
+        ::munmap(_sqes, _sqes_size);
+    }
+    if (_cq_ring != nullptr && _cq_ring != _sq_ring) {
+        ::munmap(_cq_ring, _cq_ring_size);
+    }
+    if (_sq_ring != nullptr) {
+        ::munmap(_sq_ring, _sq_ring_size);
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+    ::free(_memory);
+    _sq_ring = _cq_ring = _sqes = _cqes = nullptr;
+    _sq_tail = _cq_head = _cq_tail = nullptr;
+    _sq_array = nullptr;
+    _iovecs.clear();
+#endif
+
+    _fd = -1;
+    _memory = nullptr;
+    _buffers.clear();
+    _buffer_size = 0;
+    _busy_count = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Start read or write operations.
+//----------------------------------------------------------------------------
+
+bool ts::IOUring::read(size_t index, int fd, size_t size, uint64_t offset, Report& report)
+{
+#if defined(TS_IO_URING)
+    return submit(IORING_OP_READV, index, fd, size, offset, report);
+#else
+    return submit(0, index, fd, size, offset, report);
+#endif
+}
+
+bool ts::IOUring::write(size_t index, int fd, size_t size, uint64_t offset, Report& report)
+{
+#if defined(TS_IO_URING)
+    return submit(IORING_OP_WRITEV, index, fd, size, offset, report);
+#else
+    return submit(0, index, fd, size, offset, report);
+#endif
+}
+
+bool ts::IOUring::submit(uint8_t opcode, size_t index, int fd, size_t size, uint64_t offset, Report& report)
+{
+    if (_fd < 0 || index >= _buffers.size() || _buffers[index].busy || size > _buffer_size) {
+        report.error(u"invalid io_uring operation on buffer %d", {index});
+        return false;
+    }
+
+#if defined(TS_IO_URING)
+
+    // The I/O vector must remain valid until the operation completes on older kernels.
+    _iovecs[index].iov_base = _buffers[index].data;
+    _iovecs[index].iov_len = size;
+
+    // We are the only producer, the submission queue cannot be full since there is
+    // at most one operation per buffer and the queue has at least one entry per buffer.
+    const uint32_t tail = *_sq_tail;
+    const uint32_t slot = tail & _sq_mask;
+    ::io_uring_sqe* sqe = reinterpret_cast<::io_uring_sqe*>(_sqes) + slot;
+    TS_ZERO(*sqe);
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = uint64_t(reinterpret_cast<uintptr_t>(&_iovecs[index]));
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = index;
+    _sq_array[slot] = slot;
+    __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    // Submit the operation.
+    for (;;) {
+        const long ret = ::syscall(__NR_io_uring_enter, _fd, 1, 0, 0, nullptr, 0);
+        if (ret >= 0) {
+            break;
+        }
+        else if (errno != EINTR) {
+            report.error(u"io_uring_enter error: %s", {ErrorCodeMessage()});
+            return false;
+        }
+    }
+
+    _buffers[index].busy = true;
+    _buffers[index].done = false;
+    _buffers[index].result = 0;
+    _busy_count++;
+    return true;
+
+#else
+    report.error(u"io_uring is not supported on this system");
+    return false;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Collect all completed operations.
+//----------------------------------------------------------------------------
+
+void ts::IOUring::collect()
+{
+#if defined(TS_IO_URING)
+    uint32_t head = *_cq_head;
+    const uint32_t tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const ::io_uring_cqe* cqe = reinterpret_cast<const ::io_uring_cqe*>(_cqes) + (head & _cq_mask);
+        if (cqe->user_data < _buffers.size()) {
+            _buffers[size_t(cqe->user_data)].done = true;
+            _buffers[size_t(cqe->user_data)].result = cqe->res;
+        }
+        head++;
+    }
+    __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Wait for the completion of the operation on an I/O buffer.
+//----------------------------------------------------------------------------
+
+bool ts::IOUring::complete(size_t index, int& result, Report& report)
+{
+    result = 0;
+    if (_fd < 0 || index >= _buffers.size() || !_buffers[index].busy) {
+        report.error(u"no io_uring operation on buffer %d", {index});
+        return false;
+    }
+
+#if defined(TS_IO_URING)
+    // Wait for completions until the one for this buffer is found.
+    for (collect(); !_buffers[index].done; collect()) {
+        const long ret = ::syscall(__NR_io_uring_enter, _fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret < 0 && errno != EINTR) {
+            report.error(u"io_uring_enter error: %s", {ErrorCodeMessage()});
+            return false;
+        }
+    }
+#endif
+
+    result = _buffers[index].result;
+    _buffers[index].busy = false;
+    _buffers[index].done = false;
+    _busy_count--;
+    return true;
+}
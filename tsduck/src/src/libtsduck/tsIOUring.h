@@ -0,0 +1,210 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Asynchronous file I/O using the Linux io_uring interface.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsReport.h"
+#if defined(TS_LINUX)
+#include <sys/uio.h>
+#endif
+
+namespace ts {
+    //!
+    //! Asynchronous file I/O using the Linux io_uring interface.
+    //! @ingroup system
+    //!
+    //! This class manages a pool of I/O buffers, each of them being used by at most one
+    //! read or write operation at a time. Several operations can be in flight at the same
+    //! time, on any file. The operations may complete in any order. The buffers are aligned
+    //! on BUFFER_ALIGNMENT, making them suitable for direct I/O (O_DIRECT).
+    //!
+    //! The io_uring interface is directly used through system calls, without external
+    //! library. It is available on Linux kernels 5.1 and higher only. On other kernels
+    //! and other operating systems, open() fails and the application shall fall back
+    //! to synchronous I/O.
+    //!
+    class TSDUCKDLL IOUring
+    {
+    public:
+        //!
+        //! Alignment of the I/O buffers in memory, compatible with direct I/O.
+        //!
+        static const size_t BUFFER_ALIGNMENT = 4096;
+
+        //!
+        //! Constructor.
+        //!
+        IOUring();
+
+        //!
+        //! Destructor.
+        //!
+        ~IOUring();
+
+        //!
+        //! Check if the io_uring interface is supported by the system.
+        //! @return True if io_uring is supported.
+        //!
+        static bool IsSupported();
+
+        //!
+        //! Create the io_uring and allocate the I/O buffers.
+        //! @param [in] buffer_count Number of I/O buffers, ie. maximum number of operations in flight.
+        //! @param [in] buffer_size Size in bytes of each I/O buffer. Rounded up to BUFFER_ALIGNMENT.
+        //! @param [in,out] report Where to report errors. When io_uring is not supported
+        //! by the system, the reason is reported at debug level only.
+        //! @return True on success, false on error.
+        //!
+        bool open(size_t buffer_count, size_t buffer_size, Report& report);
+
+        //!
+        //! Close the io_uring and free the I/O buffers.
+        //! All operations in flight are waited for before freeing the buffers.
+        //! @param [in,out] report Where to report errors.
+        //!
+        void close(Report& report);
+
+        //!
+        //! Check if the io_uring is open.
+        //! @return True if the io_uring is open.
+        //!
+        bool isOpen() const { return _fd >= 0; }
+
+        //!
+        //! Get the number of I/O buffers.
+        //! @return The number of I/O buffers.
+        //!
+        size_t bufferCount() const { return _buffers.size(); }
+
+        //!
+        //! Get the size of each I/O buffer.
+        //! @return The size in bytes of each I/O buffer.
+        //!
+        size_t bufferSize() const { return _buffer_size; }
+
+        //!
+        //! Get the address of an I/O buffer.
+        //! @param [in] index Index of the buffer, from 0 to bufferCount() - 1.
+        //! @return The address of the buffer.
+        //!
+        uint8_t* buffer(size_t index) const { return _buffers[index].data; }
+
+        //!
+        //! Check if an I/O buffer is used by an operation in flight or not yet completed by complete().
+        //! @param [in] index Index of the buffer.
+        //! @return True if the buffer is busy.
+        //!
+        bool isBusy(size_t index) const { return _buffers[index].busy; }
+
+        //!
+        //! Get the number of operations in flight or not yet completed by complete().
+        //! @return The number of busy buffers.
+        //!
+        size_t busyCount() const { return _busy_count; }
+
+        //!
+        //! Start an asynchronous read operation into an I/O buffer.
+        //! @param [in] index Index of the buffer. It must not be busy.
+        //! @param [in] fd File descriptor to read.
+        //! @param [in] size Number of bytes to read, at most bufferSize().
+        //! @param [in] offset Offset in the file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool read(size_t index, int fd, size_t size, uint64_t offset, Report& report);
+
+        //!
+        //! Start an asynchronous write operation from an I/O buffer.
+        //! @param [in] index Index of the buffer. It must not be busy.
+        //! @param [in] fd File descriptor to write.
+        //! @param [in] size Number of bytes to write, at most bufferSize().
+        //! @param [in] offset Offset in the file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool write(size_t index, int fd, size_t size, uint64_t offset, Report& report);
+
+        //!
+        //! Wait for the completion of the operation on an I/O buffer.
+        //! The buffer is no longer busy after this call.
+        //! @param [in] index Index of the buffer.
+        //! @param [out] result Result of the operation: number of transferred bytes or negated errno value.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error (the operation itself may have failed, see @a result).
+        //!
+        bool complete(size_t index, int& result, Report& report);
+
+    private:
+        // Description of an I/O buffer.
+        struct Buffer
+        {
+            Buffer();
+            uint8_t* data;    // Aligned buffer address.
+            bool     busy;    // Operation in flight or not yet completed.
+            bool     done;    // Operation completed by the system.
+            int      result;  // Operation result.
+        };
+
+        int                 _fd;           // io_uring file descriptor.
+        size_t              _buffer_size;  // Size of each buffer.
+        size_t              _busy_count;   // Number of busy buffers.
+        uint8_t*            _memory;       // Memory area of all buffers.
+        std::vector<Buffer> _buffers;      // I/O buffers.
+#if defined(TS_LINUX)
+        void*               _sq_ring;      // Mapped submission queue ring.
+        void*               _cq_ring;      // Mapped completion queue ring (may be the same as _sq_ring).
+        void*               _sqes;         // Mapped submission queue entries.
+        size_t              _sq_ring_size; // Size of mapped submission queue ring.
+        size_t              _cq_ring_size; // Size of mapped completion queue ring.
+        size_t              _sqes_size;    // Size of mapped submission queue entries.
+        volatile uint32_t*  _sq_tail;      // Submission queue tail index.
+        uint32_t            _sq_mask;      // Submission queue index mask.
+        uint32_t*           _sq_array;     // Submission queue array of entry indexes.
+        volatile uint32_t*  _cq_head;      // Completion queue head index.
+        volatile uint32_t*  _cq_tail;      // Completion queue tail index.
+        uint32_t            _cq_mask;      // Completion queue index mask.
+        void*               _cqes;         // Completion queue entries.
+        std::vector<::iovec> _iovecs;      // One I/O vector per buffer.
+#endif
+
+        // Start an operation on a buffer.
+        bool submit(uint8_t opcode, size_t index, int fd, size_t size, uint64_t offset, Report& report);
+
+        // Collect all completed operations.
+        void collect();
+
+        // Inaccessible operations.
+        IOUring(const IOUring&) = delete;
+        IOUring& operator=(const IOUring&) = delete;
+    };
+}
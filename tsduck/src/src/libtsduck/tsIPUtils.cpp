@@ -33,6 +33,7 @@
 
 #include "tsIPUtils.h"
 #include "tsIPAddress.h"
+#include "tsMPEG.h"
 #if defined(TS_MAC)
 #include <ifaddrs.h>
 #endif
@@ -277,3 +278,118 @@ bool ts::UpdateIPHeaderChecksum(void* data, size_t size)
     }
     return ok;
 }
+
+
+//----------------------------------------------------------------------------
+// Locate the payload of an RTP message.
+//----------------------------------------------------------------------------
+
+bool ts::GetRTPPayload(const void* data, size_t size, size_t& payload_offset, size_t& payload_size, uint16_t& sequence)
+{
+    const uint8_t* rtp = reinterpret_cast<const uint8_t*>(data);
+    payload_offset = payload_size = 0;
+    sequence = 0;
+
+    // Check the version in the first byte. The rest of the first byte contains
+    // the padding and extension flags and the number of CSRC in the header.
+    if (rtp == nullptr || size < RTP_HEADER_SIZE || (rtp[0] >> 6) != RTP_VERSION) {
+        return false;
+    }
+
+    // Skip CSRC list and header extension.
+    size_t offset = RTP_HEADER_SIZE + 4 * size_t(rtp[0] & 0x0F);
+    if ((rtp[0] & 0x10) != 0) {
+        if (offset + 4 > size) {
+            return false;
+        }
+        offset += 4 + 4 * size_t(GetUInt16(rtp + offset + 2));
+    }
+
+    // Remove padding, the last byte is the padding size.
+    size_t end = size;
+    if ((rtp[0] & 0x20) != 0) {
+        end -= std::min<size_t>(end, rtp[size - 1]);
+    }
+    if (offset > end) {
+        return false;
+    }
+
+    payload_offset = offset;
+    payload_size = end - offset;
+    sequence = GetUInt16(rtp + 2);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Build a fixed RTP header.
+//----------------------------------------------------------------------------
+
+void ts::BuildRTPHeader(void* data, uint8_t payload_type, uint16_t sequence, uint32_t timestamp, uint32_t ssrc)
+{
+    uint8_t* rtp = reinterpret_cast<uint8_t*>(data);
+    rtp[0] = RTP_VERSION << 6;  // no padding, no extension, no CSRC
+    rtp[1] = payload_type & 0x7F;
+    PutUInt16(rtp + 2, sequence);
+    PutUInt32(rtp + 4, timestamp);
+    PutUInt32(rtp + 8, ssrc);
+}
+
+
+//----------------------------------------------------------------------------
+// Locate the TS packets in a UDP message.
+//----------------------------------------------------------------------------
+
+bool ts::LocateTSPackets(const void* addr, size_t size, size_t& start, size_t& count)
+{
+    const uint8_t* const data = reinterpret_cast<const uint8_t*>(addr);
+
+    // Locate the TS packets inside the UDP message. Basically, we
+    // expect the message to contain only TS packets. However, we
+    // will face the following situations:
+    // - Presence of a header preceeding the first TS packet (typically
+    //   when the TS packets are encapsulated in RTP).
+    // - Presence of a truncated packet at the end of message.
+
+    // To face the first situation, we look backward from the end of
+    // the message, looking for a 0x47 sync byte every 188 bytes, going
+    // backward.
+
+    const uint8_t* p;
+    for (p = data + size; p >= data + PKT_SIZE && p[-int(PKT_SIZE)] == SYNC_BYTE; p -= PKT_SIZE) {}
+
+    if (p < data + size) {
+        // Some packets were found
+        start = p - data;
+        count = (data + size - p) / PKT_SIZE;
+        return true;
+    }
+
+    // If no TS packet is found using the first method, we restart from
+    // the beginning of the message, looking for a 0x47 sync byte every
+    // 188 bytes, going forward. If we find this pattern, followed by
+    // less than 188 bytes, then we have found a sequence of TS packets.
+
+    if (size >= PKT_SIZE) {
+        const uint8_t* max = data + size - PKT_SIZE; // max address for a TS packet
+        for (p = data; p <= max; p++) {
+            if (*p == SYNC_BYTE) {
+                // Verify that we get a 0x47 sync byte every 188 bytes up
+                // to the end of message (not leaving more than one truncated
+                // TS packet at the end of the message).
+                const uint8_t* end;
+                for (end = p; end <= max && *end == SYNC_BYTE; end += PKT_SIZE) {}
+                if (end > max) {
+                    // Less than 188 bytes after last packet. Consider we are OK
+                    start = p - data;
+                    count = (end - p) / PKT_SIZE;
+                    return true;
+                }
+            }
+        }
+    }
+
+    // No TS packet found in UDP message.
+    start = count = 0;
+    return false;
+}
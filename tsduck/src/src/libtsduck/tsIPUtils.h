@@ -177,4 +177,56 @@ namespace ts {
     //! @return True if the checksum was update, false on incorrect buffer.
     //!
     TSDUCKDLL bool UpdateIPHeaderChecksum(void* data, size_t size);
+
+    //------------------------------------------------------------------------
+    // Internals of the RTP protocol (RFC 3550, RFC 2250).
+    //------------------------------------------------------------------------
+
+    const uint8_t  RTP_VERSION     =     2;   //!< Protocol version of RTP.
+    const size_t   RTP_HEADER_SIZE =    12;   //!< Size of a fixed RTP header, without CSRC list and extension.
+    const uint8_t  RTP_PT_MP2T     =    33;   //!< RTP payload type for MPEG-2 transport streams (RFC 3551).
+    const uint32_t RTP_RATE_MP2T   = 90000;   //!< RTP clock rate for MPEG-2 transport streams (RFC 3551).
+
+    //!
+    //! Locate the payload of an RTP message.
+    //!
+    //! The CSRC list, the header extension and the padding are skipped.
+    //!
+    //! @param [in] data Address of the RTP message (UDP payload).
+    //! @param [in] size Size of the RTP message.
+    //! @param [out] payload_offset Offset of the RTP payload in the message.
+    //! @param [out] payload_size Size of the RTP payload.
+    //! @param [out] sequence RTP sequence number of the message.
+    //! @return True if the message is a valid RTP message, false otherwise.
+    //!
+    TSDUCKDLL bool GetRTPPayload(const void* data, size_t size, size_t& payload_offset, size_t& payload_size, uint16_t& sequence);
+
+    //!
+    //! Build a fixed RTP header, without CSRC list and extension.
+    //!
+    //! @param [out] data Address of the header. It must be at least RTP_HEADER_SIZE bytes long.
+    //! @param [in] payload_type RTP payload type, 7 bits.
+    //! @param [in] sequence RTP sequence number.
+    //! @param [in] timestamp RTP timestamp.
+    //! @param [in] ssrc RTP synchronization source identifier.
+    //!
+    TSDUCKDLL void BuildRTPHeader(void* data, uint8_t payload_type, uint16_t sequence, uint32_t timestamp, uint32_t ssrc);
+
+    //------------------------------------------------------------------------
+    // Transport stream packets in UDP messages.
+    //------------------------------------------------------------------------
+
+    //!
+    //! Locate the TS packets in a UDP message.
+    //!
+    //! The message is expected to contain TS packets only. However, the packets
+    //! may be preceded by a header (typically RTP) and the last packet may be truncated.
+    //!
+    //! @param [in] data Address of the UDP message (UDP payload).
+    //! @param [in] size Size of the UDP message.
+    //! @param [out] start Offset of the first TS packet in the message.
+    //! @param [out] count Number of complete TS packets in the message.
+    //! @return True if TS packets were found, false otherwise.
+    //!
+    TSDUCKDLL bool LocateTSPackets(const void* data, size_t size, size_t& start, size_t& count);
 }
@@ -0,0 +1,182 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Constant-memory histogram with logarithmic buckets.
+//
+//----------------------------------------------------------------------------
+
+#include "tsLogHistogram.h"
+#include "tsMemoryUtils.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::LogHistogram::SUB_BITS;
+const size_t ts::LogHistogram::BUCKET_COUNT;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor and reset.
+//----------------------------------------------------------------------------
+
+ts::LogHistogram::LogHistogram() :
+    _count(0),
+    _min(0),
+    _max(0),
+    _sum(0.0),
+    _buckets()
+{
+    reset();
+}
+
+void ts::LogHistogram::reset()
+{
+    _count = 0;
+    _min = 0;
+    _max = 0;
+    _sum = 0.0;
+    TS_ZERO(_buckets);
+}
+
+
+//----------------------------------------------------------------------------
+// Bucket computations.
+//----------------------------------------------------------------------------
+
+size_t ts::LogHistogram::BucketIndex(uint64_t value)
+{
+    if (value < (uint64_t(1) << SUB_BITS)) {
+        // Small values are stored exactly.
+        return size_t(value);
+    }
+
+    // Locate the most significant bit.
+    size_t msb = 0;
+    for (uint64_t v = value >> 1; v != 0; v >>= 1) {
+        msb++;
+    }
+
+    // Keep SUB_BITS significant bits after the most significant one.
+    const size_t shift = msb - SUB_BITS;
+    const size_t sub = size_t(value >> shift) - (size_t(1) << SUB_BITS);
+    return ((shift + 1) << SUB_BITS) + sub;
+}
+
+uint64_t ts::LogHistogram::BucketLowerBound(size_t index)
+{
+    if (index < (size_t(1) << SUB_BITS)) {
+        return uint64_t(index);
+    }
+    const size_t shift = (index >> SUB_BITS) - 1;
+    const uint64_t sub = uint64_t(index & ((size_t(1) << SUB_BITS) - 1));
+    return ((uint64_t(1) << SUB_BITS) + sub) << shift;
+}
+
+uint64_t ts::LogHistogram::BucketUpperBound(size_t index)
+{
+    if (index < (size_t(1) << SUB_BITS)) {
+        return uint64_t(index);
+    }
+    const size_t shift = (index >> SUB_BITS) - 1;
+    return BucketLowerBound(index) + ((uint64_t(1) << shift) - 1);
+}
+
+
+//----------------------------------------------------------------------------
+// Add values in the histogram.
+//----------------------------------------------------------------------------
+
+void ts::LogHistogram::add(uint64_t value, uint64_t count)
+{
+    if (count > 0) {
+        if (_count == 0 || value < _min) {
+            _min = value;
+        }
+        if (value > _max) {
+            _max = value;
+        }
+        _count += count;
+        _sum += double(value) * double(count);
+        _buckets[BucketIndex(value)] += count;
+    }
+}
+
+void ts::LogHistogram::merge(const LogHistogram& other)
+{
+    if (other._count > 0) {
+        if (_count == 0 || other._min < _min) {
+            _min = other._min;
+        }
+        if (other._max > _max) {
+            _max = other._max;
+        }
+        _count += other._count;
+        _sum += other._sum;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            _buckets[i] += other._buckets[i];
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Statistics.
+//----------------------------------------------------------------------------
+
+double ts::LogHistogram::mean() const
+{
+    return _count == 0 ? 0.0 : _sum / double(_count);
+}
+
+uint64_t ts::LogHistogram::percentile(double percent) const
+{
+    if (_count == 0) {
+        return 0;
+    }
+
+    // Rank of the requested value, from 1 to _count.
+    uint64_t rank = uint64_t(percent * double(_count) / 100.0 + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    else if (rank > _count) {
+        rank = _count;
+    }
+
+    // Locate the bucket containing this rank.
+    uint64_t cumul = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        cumul += _buckets[i];
+        if (cumul >= rank) {
+            const uint64_t value = BucketUpperBound(i);
+            return value < _min ? _min : (value > _max ? _max : value);
+        }
+    }
+    return _max;
+}
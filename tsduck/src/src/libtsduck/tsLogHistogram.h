@@ -0,0 +1,155 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Constant-memory histogram with logarithmic buckets.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPlatform.h"
+
+namespace ts {
+    //!
+    //! Constant-memory histogram of unsigned integer values with logarithmic buckets.
+    //! @ingroup cpp
+    //!
+    //! This class is typically used to collect distributions of latencies, intervals
+    //! or jitters on long periods of time and compute percentiles without storing
+    //! all individual values. The memory footprint is fixed and no allocation is
+    //! performed after construction.
+    //!
+    //! Small values (less than 2 power SUB_BITS) are stored exactly. Larger values
+    //! are stored in buckets: each power of two is split into 2 power SUB_BITS
+    //! sub-buckets, giving a relative precision of about 6% on all values.
+    //!
+    class TSDUCKDLL LogHistogram
+    {
+    public:
+        //!
+        //! Number of bits of precision in each power of two.
+        //!
+        static const size_t SUB_BITS = 4;
+
+        //!
+        //! Total number of buckets in the histogram.
+        //!
+        static const size_t BUCKET_COUNT = (64 - SUB_BITS + 1) << SUB_BITS;
+
+        //!
+        //! Constructor.
+        //!
+        LogHistogram();
+
+        //!
+        //! Reset the content of the histogram.
+        //!
+        void reset();
+
+        //!
+        //! Add a value in the histogram.
+        //! @param [in] value The value to add.
+        //! @param [in] count Number of occurences of @a value.
+        //!
+        void add(uint64_t value, uint64_t count = 1);
+
+        //!
+        //! Merge the content of another histogram into this one.
+        //! @param [in] other Another histogram.
+        //!
+        void merge(const LogHistogram& other);
+
+        //!
+        //! Get the total number of values in the histogram.
+        //! @return The total number of values.
+        //!
+        uint64_t count() const { return _count; }
+
+        //!
+        //! Get the minimum value in the histogram.
+        //! @return The exact minimum value or zero if the histogram is empty.
+        //!
+        uint64_t minimum() const { return _count == 0 ? 0 : _min; }
+
+        //!
+        //! Get the maximum value in the histogram.
+        //! @return The exact maximum value or zero if the histogram is empty.
+        //!
+        uint64_t maximum() const { return _max; }
+
+        //!
+        //! Get the average value in the histogram.
+        //! @return The average value or zero if the histogram is empty.
+        //!
+        double mean() const;
+
+        //!
+        //! Get an approximate percentile of the values in the histogram.
+        //! @param [in] percent The percentile to compute, from 0.0 to 100.0 (e.g. 99.9).
+        //! @return The upper bound of the bucket containing the requested percentile,
+        //! bounded by the exact minimum and maximum values. Zero if the histogram is empty.
+        //!
+        uint64_t percentile(double percent) const;
+
+        //!
+        //! Get the number of values in a bucket.
+        //! @param [in] index Bucket index, from 0 to BUCKET_COUNT-1.
+        //! @return The number of values in the bucket.
+        //!
+        uint64_t bucketCount(size_t index) const { return index < BUCKET_COUNT ? _buckets[index] : 0; }
+
+        //!
+        //! Get the lowest value in a bucket.
+        //! @param [in] index Bucket index, from 0 to BUCKET_COUNT-1.
+        //! @return The lowest value which is stored in the bucket.
+        //!
+        static uint64_t BucketLowerBound(size_t index);
+
+        //!
+        //! Get the highest value in a bucket.
+        //! @param [in] index Bucket index, from 0 to BUCKET_COUNT-1.
+        //! @return The highest value which is stored in the bucket.
+        //!
+        static uint64_t BucketUpperBound(size_t index);
+
+        //!
+        //! Get the bucket index of a value.
+        //! @param [in] value A value.
+        //! @return The index of the bucket where @a value is stored.
+        //!
+        static size_t BucketIndex(uint64_t value);
+
+    private:
+        uint64_t _count;                  // Total number of values.
+        uint64_t _min;                    // Minimum value.
+        uint64_t _max;                    // Maximum value.
+        double   _sum;                    // Sum of all values, for mean value.
+        uint64_t _buckets[BUCKET_COUNT];  // Number of values per bucket.
+    };
+}
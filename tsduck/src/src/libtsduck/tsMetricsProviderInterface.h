@@ -0,0 +1,64 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Abstract interface to provide metrics to a metrics server.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsMetricsWriter.h"
+
+namespace ts {
+    //!
+    //! Abstract interface to provide metrics to a metrics server.
+    //! @ingroup net
+    //! @see MetricsServer
+    //!
+    class TSDUCKDLL MetricsProviderInterface
+    {
+    public:
+        //!
+        //! Invoked each time the metrics are collected.
+        //!
+        //! This method is invoked in the context of the metrics server thread.
+        //! Since the metrics are usually updated by other threads, the implementation
+        //! shall read them from atomic variables or from asynchronous snapshots. It shall
+        //! never wait for a lock which is held by a time-critical thread.
+        //!
+        //! @param [in,out] writer The metrics writer where the metrics shall be added.
+        //!
+        virtual void getMetrics(MetricsWriter& writer) = 0;
+
+        //!
+        //! Virtual destructor.
+        //!
+        virtual ~MetricsProviderInterface() {}
+    };
+}
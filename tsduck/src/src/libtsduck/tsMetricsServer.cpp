@@ -0,0 +1,229 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsMetricsServer.h"
+#include "tsNullReport.h"
+#include "tsNullMutex.h"
+#include "tsReportBuffer.h"
+TSDUCK_SOURCE;
+
+const char* const ts::MetricsServer::METRICS_PATH = "/metrics";
+
+// Maximum size of an HTTP request header. Larger requests are rejected.
+#define MAX_REQUEST_SIZE 8192
+
+// Maximum time to receive an HTTP request header, in milliseconds.
+#define REQUEST_TIMEOUT 5000
+
+
+//----------------------------------------------------------------------------
+// Constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::MetricsServer::MetricsServer(MetricsProviderInterface* provider, const UString& prefix, Report& report) :
+    Thread(ThreadAttributes().setStackSize(128 * 1024)),
+    _provider(provider),
+    _prefix(prefix),
+    _report(report),
+    _server(),
+    _client(),
+    _start(),
+    _terminate(false),
+    _requests(0)
+{
+}
+
+ts::MetricsServer::~MetricsServer()
+{
+    close();
+}
+
+
+//----------------------------------------------------------------------------
+// Open the server and start the server thread.
+//----------------------------------------------------------------------------
+
+bool ts::MetricsServer::open(const SocketAddress& address)
+{
+    if (_server.isOpen()) {
+        _report.error(u"metrics server already open");
+        return false;
+    }
+    if (!address.hasPort()) {
+        _report.error(u"missing port number for metrics server");
+        return false;
+    }
+
+    // Listen on the loopback interface by default.
+    SocketAddress local(address);
+    if (!local.hasAddress()) {
+        local.setAddress(IPAddress::LocalHost.address());
+    }
+
+    _terminate = false;
+    _start.getSystemTime();
+
+    if (!_server.open(_report)) {
+        return false;
+    }
+    if (!_server.reusePort(true, _report) || !_server.bind(local, _report) || !_server.listen(5, _report) || !start()) {
+        _server.close(NULLREP);
+        return false;
+    }
+
+    _report.verbose(u"metrics server listening on http://%s%s", {local, METRICS_PATH});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Close the server and wait for the termination of the server thread.
+//----------------------------------------------------------------------------
+
+void ts::MetricsServer::close()
+{
+    if (_server.isOpen()) {
+        // Closing the server socket unblocks the server thread in accept().
+        // The client connection is owned by the server thread. A pending
+        // request is bounded by the request timeout.
+        _terminate = true;
+        _server.close(NULLREP);
+        waitForTermination();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Server thread.
+//----------------------------------------------------------------------------
+
+void ts::MetricsServer::main()
+{
+    _report.debug(u"metrics server thread started");
+
+    // Get accept errors in a buffer since an error is normal when the server is closed.
+    ReportBuffer<NullMutex> error(_report.maxSeverity());
+    SocketAddress peer;
+
+    while (!_terminate && _server.accept(_client, peer, error)) {
+        if (!_terminate) {
+            _report.debug(u"metrics request from %s", {peer});
+            processRequest();
+        }
+        _client.disconnect(NULLREP);
+        _client.close(NULLREP);
+    }
+
+    if (!_terminate && !error.emptyMessages()) {
+        _report.error(error.getMessages());
+    }
+
+    _report.debug(u"metrics server thread terminated");
+}
+
+
+//----------------------------------------------------------------------------
+// Process one request on the current client connection.
+//----------------------------------------------------------------------------
+
+void ts::MetricsServer::processRequest()
+{
+    // Read the request header, up to the first empty line.
+    // Slow or silent clients are dropped when the request timeout expires.
+    Monotonic deadline(true);
+    deadline += REQUEST_TIMEOUT * NanoSecPerMilliSec;
+    std::string request;
+    char buffer[1024];
+    size_t size = 0;
+    bool complete = false;
+    while (!complete && !_terminate && request.size() < MAX_REQUEST_SIZE) {
+        const MilliSecond remain = (deadline - Monotonic(true)) / NanoSecPerMilliSec;
+        if (remain <= 0 || !_client.setReceiveTimeout(remain, NULLREP) || !_client.receive(buffer, sizeof(buffer), size, nullptr, NULLREP)) {
+            break;
+        }
+        request.append(buffer, size);
+        complete = request.find("\r\n\r\n") != std::string::npos || request.find("\n\n") != std::string::npos;
+    }
+    if (!complete) {
+        // Client disconnected, timeout, termination or request too large, nothing to answer.
+        return;
+    }
+
+    // Parse the request line: method, path, protocol.
+    const size_t eol = request.find_first_of("\r\n");
+    UStringVector fields;
+    UString::FromUTF8(request.substr(0, eol)).split(fields, u' ', true, true);
+    if (fields.size() < 2) {
+        sendResponse("400 Bad Request", "text/plain", "Bad request\n", true);
+        return;
+    }
+    const UString& method(fields[0]);
+    UString path(fields[1]);
+    const size_t query = path.find(u'?');
+    if (query != NPOS) {
+        path.resize(query);
+    }
+
+    if (method != u"GET" && method != u"HEAD") {
+        sendResponse("405 Method Not Allowed", "text/plain", "Method not allowed\n", true);
+    }
+    else if (path != UString::FromUTF8(METRICS_PATH)) {
+        sendResponse("404 Not Found", "text/plain", "Not found\n", method == u"GET");
+    }
+    else {
+        // Collect all metrics.
+        MetricsWriter writer(_prefix);
+        _provider->getMetrics(writer);
+        writer.clearLabels();
+        writer.gauge(u"uptime_seconds", u"Time since the metrics server was started.", double(Monotonic(true) - _start) / double(NanoSecPerSec));
+        writer.counter(u"metrics_requests_total", u"Number of metrics requests which were served.", ++_requests);
+        sendResponse("200 OK", MetricsWriter::CONTENT_TYPE, writer.toText(), method == u"GET");
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Send an HTTP response on the current client connection.
+//----------------------------------------------------------------------------
+
+void ts::MetricsServer::sendResponse(const char* status, const char* content_type, const std::string& body, bool with_body)
+{
+    std::string header("HTTP/1.0 ");
+    header.append(status);
+    header.append("\r\nContent-Type: ");
+    header.append(content_type);
+    header.append("\r\nContent-Length: ");
+    header.append(std::to_string(body.size()));
+    header.append("\r\nConnection: close\r\nCache-Control: no-cache\r\n\r\n");
+
+    if (_client.send(header.data(), header.size(), NULLREP) && with_body && !body.empty()) {
+        _client.send(body.data(), body.size(), NULLREP);
+    }
+    _client.closeWriter(NULLREP);
+}
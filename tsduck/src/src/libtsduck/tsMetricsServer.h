@@ -0,0 +1,128 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Minimal HTTP server which exposes metrics in Prometheus text format.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsMetricsProviderInterface.h"
+#include "tsTCPServer.h"
+#include "tsTCPConnection.h"
+#include "tsMonotonic.h"
+#include "tsThread.h"
+#include <atomic>
+
+namespace ts {
+    //!
+    //! Minimal HTTP server which exposes metrics in Prometheus text format.
+    //! @ingroup net
+    //!
+    //! The server runs in its own thread and serves one client at a time.
+    //! Each request for the path @c /metrics collects the metrics from a
+    //! MetricsProviderInterface and returns them in Prometheus text format.
+    //! There is no other dependency than the TSDuck sockets. The server is
+    //! designed for scraping by a local monitoring agent, not for public
+    //! exposure: by default, it listens on the loopback interface only. A client
+    //! which does not send its request within a few seconds is disconnected.
+    //!
+    class TSDUCKDLL MetricsServer: private Thread
+    {
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] provider The object which provides the metrics.
+        //! @param [in] prefix Prefix of all metric names, typically the application name.
+        //! @param [in,out] report Where to report errors. Must be thread-safe since
+        //! messages are reported in the context of the server thread.
+        //!
+        MetricsServer(MetricsProviderInterface* provider, const UString& prefix, Report& report);
+
+        //!
+        //! Destructor.
+        //! The server is closed and the server thread terminated.
+        //!
+        virtual ~MetricsServer() override;
+
+        //!
+        //! Open the server and start the server thread.
+        //! @param [in] address Local socket address to listen to. The port is mandatory.
+        //! If the IP address is unspecified, the server listens on the loopback interface.
+        //! @return True on success, false on error.
+        //!
+        bool open(const SocketAddress& address);
+
+        //!
+        //! Close the server and wait for the termination of the server thread.
+        //!
+        void close();
+
+        //!
+        //! Check if the server is open.
+        //! @return True if the server is open.
+        //!
+        bool isOpen() const { return _server.isOpen(); }
+
+        //!
+        //! Get the number of served metrics requests.
+        //! @return The number of served metrics requests.
+        //!
+        uint64_t requestCount() const { return _requests; }
+
+        //!
+        //! URL path of the metrics.
+        //!
+        static const char* const METRICS_PATH;
+
+    private:
+        MetricsProviderInterface* _provider;  // Provides the metrics.
+        UString                   _prefix;    // Prefix of all metric names.
+        Report&                   _report;    // Where to report errors.
+        TCPServer                 _server;    // Listening socket.
+        TCPConnection             _client;    // Current client connection.
+        Monotonic                 _start;     // Server start time.
+        std::atomic<bool>         _terminate; // Terminate the server thread.
+        std::atomic<uint64_t>     _requests;  // Number of served metrics requests.
+
+        // Implementation of Thread.
+        virtual void main() override;
+
+        // Process one request on the current client connection.
+        void processRequest();
+
+        // Send an HTTP response on the current client connection.
+        void sendResponse(const char* status, const char* content_type, const std::string& body, bool with_body);
+
+        // Inaccessible operations.
+        MetricsServer() = delete;
+        MetricsServer(const MetricsServer&) = delete;
+        MetricsServer& operator=(const MetricsServer&) = delete;
+    };
+}
@@ -0,0 +1,193 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsMetricsWriter.h"
+TSDUCK_SOURCE;
+
+const char* const ts::MetricsWriter::CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::MetricsWriter::MetricsWriter(const UString& prefix) :
+    _prefix(prefix),
+    _labels(),
+    _families(),
+    _names(),
+    _index()
+{
+    if (!_prefix.empty()) {
+        _prefix.append(u'_');
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Clear all metrics and common labels.
+//----------------------------------------------------------------------------
+
+void ts::MetricsWriter::clear()
+{
+    _labels.clear();
+    _families.clear();
+    _names.clear();
+    _index.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Set a label which is added to all subsequent samples.
+//----------------------------------------------------------------------------
+
+void ts::MetricsWriter::setLabel(const UString& name, const UString& value)
+{
+    for (auto it = _labels.begin(); it != _labels.end(); ++it) {
+        if (it->first == name) {
+            it->second = value;
+            return;
+        }
+    }
+    _labels.push_back(std::make_pair(name, value));
+}
+
+
+//----------------------------------------------------------------------------
+// Escape a label value (quote is true) or a help text.
+//----------------------------------------------------------------------------
+
+ts::UString ts::MetricsWriter::Escape(const UString& str, bool quote)
+{
+    UString res;
+    res.reserve(str.size());
+    for (size_t i = 0; i < str.size(); ++i) {
+        const UChar c = str[i];
+        if (c == u'\\') {
+            res.append(u"\\\\");
+        }
+        else if (c == u'\n') {
+            res.append(u"\\n");
+        }
+        else if (c == u'"' && quote) {
+            res.append(u"\\\"");
+        }
+        else {
+            res.append(c);
+        }
+    }
+    return res;
+}
+
+
+//----------------------------------------------------------------------------
+// Format a floating-point value.
+//----------------------------------------------------------------------------
+
+ts::UString ts::MetricsWriter::Float(double value)
+{
+    // Use a representation without loss of precision. The tools do not change
+    // the C locale, the decimal separator is always a dot.
+    char buf[64];
+    ::snprintf(buf, sizeof(buf), "%.15g", value);
+    buf[sizeof(buf) - 1] = '\0';
+    return UString::FromUTF8(buf);
+}
+
+
+//----------------------------------------------------------------------------
+// Add a sample of a metric.
+//----------------------------------------------------------------------------
+
+void ts::MetricsWriter::add(MetricType type, const UString& name, const UString& help, const UString& value)
+{
+    const UString full_name(_prefix + name);
+
+    // Locate or create the metric family.
+    size_t index = 0;
+    const auto it = _index.find(full_name);
+    if (it != _index.end()) {
+        index = it->second;
+    }
+    else {
+        index = _families.size();
+        _index.insert(std::make_pair(full_name, index));
+        _names.push_back(full_name);
+        _families.push_back(Family());
+        _families.back().type = type;
+        _families.back().help = help;
+    }
+
+    // Format the sample line.
+    UString line(full_name);
+    if (!_labels.empty()) {
+        line.append(u'{');
+        for (auto lab = _labels.begin(); lab != _labels.end(); ++lab) {
+            if (lab != _labels.begin()) {
+                line.append(u',');
+            }
+            line.append(lab->first);
+            line.append(u"=\"");
+            line.append(Escape(lab->second, true));
+            line.append(u'"');
+        }
+        line.append(u'}');
+    }
+    line.append(u' ');
+    line.append(value);
+    _families[index].samples.push_back(line);
+}
+
+
+//----------------------------------------------------------------------------
+// Build the text representation of all metrics.
+//----------------------------------------------------------------------------
+
+std::string ts::MetricsWriter::toText() const
+{
+    UString text;
+    for (size_t fi = 0; fi < _families.size(); ++fi) {
+        const Family& fam(_families[fi]);
+        if (!fam.help.empty()) {
+            text.append(u"# HELP ");
+            text.append(_names[fi]);
+            text.append(u' ');
+            text.append(Escape(fam.help, false));
+            text.append(u'\n');
+        }
+        text.append(u"# TYPE ");
+        text.append(_names[fi]);
+        text.append(fam.type == COUNTER ? u" counter\n" : u" gauge\n");
+        for (auto it = fam.samples.begin(); it != fam.samples.end(); ++it) {
+            text.append(*it);
+            text.append(u'\n');
+        }
+    }
+    return text.toUTF8();
+}
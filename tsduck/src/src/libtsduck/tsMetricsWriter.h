@@ -0,0 +1,188 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Build a set of metrics in Prometheus text exposition format.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsUString.h"
+
+namespace ts {
+    //!
+    //! Build a set of metrics in Prometheus text exposition format.
+    //! @ingroup net
+    //!
+    //! Samples are added in any order. Samples with the same metric name are
+    //! grouped in one metric family which is described once, as required by the
+    //! text format, regardless of the order of insertion. A common set of labels,
+    //! typically identifying the source of the metrics, is added to all samples.
+    //!
+    //! The text format is described at
+    //! https://prometheus.io/docs/instrumenting/exposition_formats/
+    //!
+    class TSDUCKDLL MetricsWriter
+    {
+    public:
+        //!
+        //! Type of a metric.
+        //!
+        enum MetricType {
+            COUNTER,  //!< Monotonic counter.
+            GAUGE,    //!< Instantaneous value which can go up and down.
+        };
+
+        //!
+        //! Constructor.
+        //! @param [in] prefix Prefix to add to all metric names. Typically the application name.
+        //! An underscore is added between the prefix and the metric names.
+        //!
+        explicit MetricsWriter(const UString& prefix = UString());
+
+        //!
+        //! Clear all metrics and common labels.
+        //!
+        void clear();
+
+        //!
+        //! Set a label which is added to all subsequent samples.
+        //! @param [in] name Label name.
+        //! @param [in] value Label value. If the label already exists, its value is replaced.
+        //!
+        void setLabel(const UString& name, const UString& value);
+
+        //!
+        //! Set an integer label which is added to all subsequent samples.
+        //! @param [in] name Label name.
+        //! @param [in] value Label value. If the label already exists, its value is replaced.
+        //!
+        void setLabel(const UString& name, int64_t value) { setLabel(name, UString::Decimal(value, 0, true, UString())); }
+
+        //!
+        //! Remove all common labels.
+        //!
+        void clearLabels() { _labels.clear(); }
+
+        //!
+        //! Add a sample of a counter.
+        //! @param [in] name Metric name, without prefix. By convention, counters end with "_total".
+        //! @param [in] help Description of the metric.
+        //! @param [in] value Value of the counter.
+        //!
+        void counter(const UString& name, const UString& help, uint64_t value)
+        {
+            add(COUNTER, name, help, UString::Decimal(value, 0, true, UString()));
+        }
+
+        //!
+        //! Add a sample of a floating-point counter.
+        //! @param [in] name Metric name, without prefix. By convention, counters end with "_total".
+        //! @param [in] help Description of the metric.
+        //! @param [in] value Value of the counter.
+        //!
+        void counter(const UString& name, const UString& help, double value)
+        {
+            add(COUNTER, name, help, Float(value));
+        }
+
+        //!
+        //! Add a sample of an integer gauge.
+        //! @param [in] name Metric name, without prefix.
+        //! @param [in] help Description of the metric.
+        //! @param [in] value Value of the gauge.
+        //!
+        void gauge(const UString& name, const UString& help, int64_t value)
+        {
+            add(GAUGE, name, help, UString::Decimal(value, 0, true, UString()));
+        }
+
+        //!
+        //! Add a sample of a floating-point gauge.
+        //! @param [in] name Metric name, without prefix.
+        //! @param [in] help Description of the metric.
+        //! @param [in] value Value of the gauge.
+        //!
+        void gauge(const UString& name, const UString& help, double value)
+        {
+            add(GAUGE, name, help, Float(value));
+        }
+
+        //!
+        //! Add a sample of a metric.
+        //! @param [in] type Type of metric. If the metric family already exists, its type is unchanged.
+        //! @param [in] name Metric name, without prefix.
+        //! @param [in] help Description of the metric. If the metric family already exists, its help is unchanged.
+        //! @param [in] value Value of the sample, already formatted.
+        //!
+        void add(MetricType type, const UString& name, const UString& help, const UString& value);
+
+        //!
+        //! Get the number of metric families.
+        //! @return The number of metric families.
+        //!
+        size_t familyCount() const { return _families.size(); }
+
+        //!
+        //! Build the text representation of all metrics.
+        //! @return The metrics in Prometheus text exposition format, UTF-8 encoded.
+        //!
+        std::string toText() const;
+
+        //!
+        //! MIME type of the Prometheus text exposition format, for use in HTTP responses.
+        //!
+        static const char* const CONTENT_TYPE;
+
+    private:
+        // Description of a metric family.
+        struct Family
+        {
+            MetricType    type;
+            UString       help;
+            UStringVector samples;  // Formatted "name{labels} value".
+        };
+
+        // Families are output in order of first insertion.
+        typedef std::map<UString, size_t> FamilyIndex;
+        typedef std::vector<std::pair<UString, UString>> LabelList;
+
+        UString             _prefix;
+        LabelList           _labels;
+        std::vector<Family> _families;
+        UStringVector       _names;      // Family names, in same order as _families.
+        FamilyIndex         _index;      // Family name => index in _families.
+
+        // Escape a label value or a help text.
+        static UString Escape(const UString& str, bool quote);
+
+        // Format a floating-point value.
+        static UString Float(double value);
+    };
+}
@@ -35,6 +35,58 @@
 #include "tsMemoryUtils.h"
 TSDUCK_SOURCE;
 
+namespace {
+    // Percentiles which are reported in PCR statistics.
+    const struct {
+        double           value;
+        const ts::UChar* name;
+    } REPORTED_PERCENTILES[] = {
+        {50.0, u"50"},
+        {90.0, u"90"},
+        {99.0, u"99"},
+        {99.9, u"99.9"},
+    };
+
+    // One line of text report for a PCR statistics histogram.
+    ts::UString HistogramLine(const ts::UString& title, const ts::LogHistogram& hist)
+    {
+        if (hist.count() == 0) {
+            return title + u" not available";
+        }
+        ts::UString line(ts::UString::Format(u"%s min %'d, mean %'d", {title, hist.minimum(), uint64_t(hist.mean())}));
+        for (size_t i = 0; i < sizeof(REPORTED_PERCENTILES) / sizeof(REPORTED_PERCENTILES[0]); ++i) {
+            line.append(ts::UString::Format(u", %s%% %'d", {REPORTED_PERCENTILES[i].name, hist.percentile(REPORTED_PERCENTILES[i].value)}));
+        }
+        line.append(ts::UString::Format(u", max %'d", {hist.maximum()}));
+        return line;
+    }
+
+    // JSON description of a PCR statistics histogram. Only non-empty buckets are listed.
+    ts::json::ValuePtr HistogramJSON(const ts::LogHistogram& hist)
+    {
+        ts::json::ValuePtr obj(new ts::json::Object);
+        obj->add(u"count", ts::json::ValuePtr(new ts::json::Number(int64_t(hist.count()))));
+        obj->add(u"min", ts::json::ValuePtr(new ts::json::Number(int64_t(hist.minimum()))));
+        obj->add(u"mean", ts::json::ValuePtr(new ts::json::Number(int64_t(hist.mean()))));
+        obj->add(u"max", ts::json::ValuePtr(new ts::json::Number(int64_t(hist.maximum()))));
+        for (size_t i = 0; i < sizeof(REPORTED_PERCENTILES) / sizeof(REPORTED_PERCENTILES[0]); ++i) {
+            obj->add(ts::UString(u"p") + REPORTED_PERCENTILES[i].name, ts::json::ValuePtr(new ts::json::Number(int64_t(hist.percentile(REPORTED_PERCENTILES[i].value)))));
+        }
+        ts::json::ValuePtr buckets(new ts::json::Array);
+        for (size_t i = 0; i < ts::LogHistogram::BUCKET_COUNT; ++i) {
+            if (hist.bucketCount(i) > 0) {
+                ts::json::ValuePtr bucket(new ts::json::Array);
+                bucket->set(ts::json::ValuePtr(new ts::json::Number(int64_t(ts::LogHistogram::BucketLowerBound(i)))));
+                bucket->set(ts::json::ValuePtr(new ts::json::Number(int64_t(ts::LogHistogram::BucketUpperBound(i)))));
+                bucket->set(ts::json::ValuePtr(new ts::json::Number(int64_t(hist.bucketCount(i)))));
+                buckets->set(bucket);
+            }
+        }
+        obj->add(u"buckets", buckets);
+        return obj;
+    }
+}
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -45,6 +97,7 @@ TSDUCK_SOURCE;
 ts::PCRAnalyzer::PCRAnalyzer(size_t min_pid, size_t min_pcr) :
     _use_dts(false),
     _ignore_errors(false),
+    _statistics(false),
     _min_pid(std::max<size_t>(1, min_pid)),
     _min_pcr(std::max<size_t>(1, min_pcr)),
     _bitrate_valid(false),
@@ -78,12 +131,28 @@ ts::PCRAnalyzer::PIDAnalysis::PIDAnalysis() :
     cur_continuity(0),
     last_pcr_value(0),
     last_pcr_packet(0),
+    last_pcr_arrival(-1),
     ts_bitrate_188(0),
     ts_bitrate_204(0),
-    ts_bitrate_cnt(0)
+    ts_bitrate_cnt(0),
+    stats(nullptr),
+    period(nullptr)
 {
 }
 
+ts::PCRAnalyzer::PIDAnalysis::~PIDAnalysis()
+{
+    delete stats;
+    delete period;
+}
+
+void ts::PCRAnalyzer::PCRStatistics::reset()
+{
+    interval.reset();
+    accuracy.reset();
+    jitter.reset();
+}
+
 
 //----------------------------------------------------------------------------
 // PCRAnalyzez::Status constructors
@@ -247,7 +316,7 @@ void ts::PCRAnalyzer::getStatus(Status& stat) const
 // Return true if we have collected enough packet to evaluate TS bitrate.
 //----------------------------------------------------------------------------
 
-bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
+bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt, NanoSecond arrival)
 {
     // Count one more packet in the TS
     _ts_pkt_cnt++;
@@ -312,6 +381,11 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
         // If last PCR valid, compute transport rate between the two
         if (ps->last_pcr_value != 0 && ps->last_pcr_value < pcr) {
 
+            // Collect PCR statistics, based on previous bitrate evaluations.
+            if (_statistics && !_use_dts) {
+                addStatistics(*ps, pcr, arrival);
+            }
+
             // Compute transport rate in b/s since last PCR
             uint64_t ts_bitrate_188 =
                 ((_ts_pkt_cnt - ps->last_pcr_packet) * SYSTEM_CLOCK_FREQ * PKT_SIZE * 8) /
@@ -345,8 +419,102 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
         if (ps->last_pcr_value != pcr) {
             ps->last_pcr_value = pcr;
             ps->last_pcr_packet = _ts_pkt_cnt;
+            ps->last_pcr_arrival = arrival;
         }
     }
 
     return _bitrate_valid;
 }
+
+
+//----------------------------------------------------------------------------
+// Add a PCR measurement in the statistics of a PID.
+//----------------------------------------------------------------------------
+
+void ts::PCRAnalyzer::addStatistics(PIDAnalysis& ps, uint64_t pcr, NanoSecond arrival)
+{
+    // Histograms are allocated on PID's with PCR only.
+    if (ps.stats == nullptr) {
+        ps.stats = new PCRStatistics;
+        ps.period = new PCRStatistics;
+    }
+
+    // PCR interval, 1 PCR unit = 1000/27 ns.
+    const uint64_t pcr_interval = pcr - ps.last_pcr_value;
+    const uint64_t interval = (pcr_interval * 1000) / (SYSTEM_CLOCK_FREQ / 1000000);
+    ps.stats->interval.add(interval);
+    ps.period->interval.add(interval);
+
+    // PCR accuracy: compare with the PCR interval which is expected from the average TS bitrate.
+    if (_ts_bitrate_cnt > 0) {
+        const double bitrate = double(_ts_bitrate_188) / double(_ts_bitrate_cnt);
+        const double expected = double(_ts_pkt_cnt - ps.last_pcr_packet) * PKT_SIZE_BITS * SYSTEM_CLOCK_FREQ / bitrate;
+        const double error = std::abs(double(pcr_interval) - expected) * 1000.0 / (SYSTEM_CLOCK_FREQ / 1000000);
+        ps.stats->accuracy.add(uint64_t(error));
+        ps.period->accuracy.add(uint64_t(error));
+    }
+
+    // PCR jitter: compare the PCR interval with the arrival interval.
+    if (arrival >= 0 && ps.last_pcr_arrival >= 0 && arrival >= ps.last_pcr_arrival) {
+        const NanoSecond arrival_interval = arrival - ps.last_pcr_arrival;
+        const uint64_t jitter = uint64_t(arrival_interval > NanoSecond(interval) ? arrival_interval - NanoSecond(interval) : NanoSecond(interval) - arrival_interval);
+        ps.stats->jitter.add(jitter);
+        ps.period->jitter.add(jitter);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Access to PCR statistics.
+//----------------------------------------------------------------------------
+
+const ts::PCRAnalyzer::PCRStatistics* ts::PCRAnalyzer::statistics(PID pid, bool period) const
+{
+    return (pid >= PID_MAX || _pid[pid] == nullptr) ? nullptr : (period ? _pid[pid]->period : _pid[pid]->stats);
+}
+
+void ts::PCRAnalyzer::restartPeriod()
+{
+    for (size_t i = 0; i < PID_MAX; ++i) {
+        if (_pid[i] != nullptr && _pid[i]->period != nullptr) {
+            _pid[i]->period->reset();
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Export PCR statistics.
+//----------------------------------------------------------------------------
+
+void ts::PCRAnalyzer::reportStatistics(std::ostream& strm, bool period, const PIDSet& pids, const UString& margin) const
+{
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        const PCRStatistics* st = pids.test(pid) ? statistics(pid, period) : nullptr;
+        if (st != nullptr) {
+            strm << margin << UString::Format(u"PID 0x%X (%d), %'d PCR intervals", {pid, pid, st->interval.count()}) << std::endl
+                 << margin << HistogramLine(u"  PCR interval (ns):", st->interval) << std::endl
+                 << margin << HistogramLine(u"  PCR accuracy (ns):", st->accuracy) << std::endl
+                 << margin << HistogramLine(u"  PCR jitter (ns):  ", st->jitter) << std::endl;
+        }
+    }
+}
+
+ts::json::ValuePtr ts::PCRAnalyzer::jsonStatistics(bool period, const PIDSet& pids) const
+{
+    json::ValuePtr root(new json::Array);
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        const PCRStatistics* st = pids.test(pid) ? statistics(pid, period) : nullptr;
+        if (st != nullptr) {
+            json::ValuePtr obj(new json::Object);
+            obj->add(u"pid", json::ValuePtr(new json::Number(pid)));
+            obj->add(u"interval-ns", HistogramJSON(st->interval));
+            obj->add(u"accuracy-ns", HistogramJSON(st->accuracy));
+            if (st->jitter.count() > 0) {
+                obj->add(u"jitter-ns", HistogramJSON(st->jitter));
+            }
+            root->set(obj);
+        }
+    }
+    return root;
+}
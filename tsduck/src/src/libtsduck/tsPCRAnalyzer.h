@@ -35,12 +35,17 @@
 #pragma once
 #include "tsMPEG.h"
 #include "tsTSPacket.h"
+#include "tsLogHistogram.h"
+#include "tsjson.h"
 
 namespace ts {
     //!
     //! PCR statistics analysis.
     //! @ingroup mpeg
     //!
+    //! Optionally, the distributions of the PCR repetition intervals, PCR accuracy and
+    //! PCR arrival jitter are collected on each PID, see setStatistics().
+    //!
     class TSDUCKDLL PCRAnalyzer
     {
     public:
@@ -100,12 +105,29 @@ namespace ts {
         //!
         void setIgnoreErrors(bool ignore);
 
+        //!
+        //! Collect the distributions of PCR measurements on each PID.
+        //! By default, only bitrates are evaluated. When enabled, per-PID histograms
+        //! are allocated on PID's with PCR's. This is ignored when DTS are used.
+        //! @param [in] on When true, collect PCR statistics.
+        //!
+        void setStatistics(bool on) { _statistics = on; }
+
         //!
         //! The following method feeds the analyzer with a TS packet.
         //! @param [in] pkt A new transport stream packet.
         //! @return True if we have collected enough packet to evaluate TS bitrate.
         //!
-        bool feedPacket(const TSPacket& pkt);
+        bool feedPacket(const TSPacket& pkt) { return feedPacket(pkt, -1); }
+
+        //!
+        //! The following method feeds the analyzer with a TS packet and its arrival time.
+        //! @param [in] pkt A new transport stream packet.
+        //! @param [in] arrival Arrival time of the packet in nanoseconds, from any fixed origin.
+        //! Negative if unknown. The arrival time is used to evaluate the PCR jitter.
+        //! @return True if we have collected enough packet to evaluate TS bitrate.
+        //!
+        bool feedPacket(const TSPacket& pkt, NanoSecond arrival);
 
         //!
         //! Check if we have collected enough packet to evaluate TS bitrate.
@@ -177,6 +199,55 @@ namespace ts {
         //!
         void getStatus(Status& status) const;
 
+        //!
+        //! Distributions of PCR measurements on one PID.
+        //! All values are in nanoseconds.
+        //!
+        struct TSDUCKDLL PCRStatistics
+        {
+            LogHistogram interval;  //!< Interval between two consecutive PCR's.
+            LogHistogram accuracy;  //!< PCR accuracy: absolute difference with the PCR value which is expected at the average TS bitrate.
+            LogHistogram jitter;    //!< PCR jitter: absolute difference between the PCR interval and the arrival interval of the PCR packets.
+
+            //!
+            //! Reset all distributions.
+            //!
+            void reset();
+        };
+
+        //!
+        //! Get the PCR statistics of a PID.
+        //! @param [in] pid The PID to get.
+        //! @param [in] period If true, get the statistics since the last call to restartPeriod().
+        //! Otherwise, get the statistics since the beginning of the analysis.
+        //! @return A pointer to the statistics of @a pid or a null pointer if there is none.
+        //!
+        const PCRStatistics* statistics(PID pid, bool period = false) const;
+
+        //!
+        //! Start a new period of PCR statistics.
+        //! The per-period statistics are used to report rolling values on successive periods of time.
+        //!
+        void restartPeriod();
+
+        //!
+        //! Display the PCR statistics of all PID's.
+        //! @param [in,out] strm Output text stream.
+        //! @param [in] period If true, report the statistics since the last call to restartPeriod().
+        //! @param [in] pids Report these PID's only.
+        //! @param [in] margin Left margin of all lines.
+        //!
+        void reportStatistics(std::ostream& strm, bool period = false, const PIDSet& pids = AllPIDs, const UString& margin = UString()) const;
+
+        //!
+        //! Build a JSON description of the PCR statistics of all PID's.
+        //! @param [in] period If true, report the statistics since the last call to restartPeriod().
+        //! @param [in] pids Report these PID's only.
+        //! @return A JSON array, one object per PID. The PCR jitter is omitted when
+        //! it was not measured, when the packet arrival times are unknown.
+        //!
+        json::ValuePtr jsonStatistics(bool period = false, const PIDSet& pids = AllPIDs) const;
+
     private:
         // Process a discontinuity in the transport stream
         void processDiscountinuity();
@@ -184,21 +255,32 @@ namespace ts {
         // Analysis of one PID
         struct PIDAnalysis
         {
-            // Constructor:
+            // Constructor and destructor:
             PIDAnalysis();
+            ~PIDAnalysis();
             // Members:
-            uint64_t ts_pkt_cnt;       // Count of TS packets
-            uint8_t  cur_continuity;   // Current continuity counter
-            uint64_t last_pcr_value;   // Last PCR value in this PID
-            uint64_t last_pcr_packet;  // Packet index containing last PCR
-            uint64_t ts_bitrate_188;   // Sum of all computed TS bitrates (188-byte)
-            uint64_t ts_bitrate_204;   // Sum of all computed TS bitrates (204-byte)
-            uint64_t ts_bitrate_cnt;   // Count of computed TS bitrates
+            uint64_t       ts_pkt_cnt;        // Count of TS packets
+            uint8_t        cur_continuity;    // Current continuity counter
+            uint64_t       last_pcr_value;    // Last PCR value in this PID
+            uint64_t       last_pcr_packet;   // Packet index containing last PCR
+            NanoSecond     last_pcr_arrival;  // Arrival time of packet containing last PCR, negative if unknown
+            uint64_t       ts_bitrate_188;    // Sum of all computed TS bitrates (188-byte)
+            uint64_t       ts_bitrate_204;    // Sum of all computed TS bitrates (204-byte)
+            uint64_t       ts_bitrate_cnt;    // Count of computed TS bitrates
+            PCRStatistics* stats;             // PCR statistics since beginning, allocated on first PCR interval
+            PCRStatistics* period;            // PCR statistics since beginning of period
+        private:
+            PIDAnalysis(const PIDAnalysis&) = delete;
+            PIDAnalysis& operator=(const PIDAnalysis&) = delete;
         };
 
+        // Add a PCR measurement in the statistics of a PID.
+        void addStatistics(PIDAnalysis& ps, uint64_t pcr, NanoSecond arrival);
+
         // Private members:
         bool     _use_dts;            // Use DTS instead of PCR
         bool     _ignore_errors;      // Ignore TS errors such as discontinuities.
+        bool     _statistics;         // Collect PCR statistics.
         size_t   _min_pid;            // Min # of PID
         size_t   _min_pcr;            // Min # of PCR per PID
         bool     _bitrate_valid;      // Bitrate evaluation is valid
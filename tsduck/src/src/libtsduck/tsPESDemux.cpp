@@ -119,6 +119,15 @@ void ts::PESDemux::immediateResetPID(PID pid)
     _stream_types.erase(pid);
 }
 
+void ts::PESDemux::syncLost()
+{
+    SuperClass::syncLost();
+    _section_demux.syncLost();
+    for (auto it = _pids.begin(); it != _pids.end(); ++it) {
+        it->second.syncLost();
+    }
+}
+
 
 //----------------------------------------------------------------------------
 // Get current audio/video attributes on the specified PID.
@@ -69,6 +69,7 @@ namespace ts {
 
         // Inherited methods
         virtual void feedPacket(const TSPacket& pkt) override;
+        virtual void syncLost() override;
 
         //!
         //! Replace the PES packet handler.
@@ -0,0 +1,524 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Read UDP datagrams from a pcap or pcap-ng capture file.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPcapFile.h"
+#include "tsIPUtils.h"
+#include "tsIntegerUtils.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+// Magic numbers of pcap files (read in little endian) and pcap-ng blocks.
+#define PCAP_MAGIC_US_LE   0xA1B2C3D4  // pcap, microseconds, little endian
+#define PCAP_MAGIC_US_BE   0xD4C3B2A1  // pcap, microseconds, big endian
+#define PCAP_MAGIC_NS_LE   0xA1B23C4D  // pcap, nanoseconds, little endian
+#define PCAP_MAGIC_NS_BE   0x4D3CB2A1  // pcap, nanoseconds, big endian
+#define PCAP_HEADER_SIZE   24          // pcap file header
+#define PCAP_RECORD_SIZE   16          // pcap record header
+
+#define PCAPNG_SHB         0x0A0D0D0A  // Section header block
+#define PCAPNG_IDB         0x00000001  // Interface description block
+#define PCAPNG_OPB         0x00000002  // Obsolete packet block
+#define PCAPNG_SPB         0x00000003  // Simple packet block
+#define PCAPNG_EPB         0x00000006  // Enhanced packet block
+#define PCAPNG_ORDER_MAGIC 0x1A2B3C4D  // Byte order magic in section header block
+#define PCAPNG_TSRESOL     9           // Option code of if_tsresol in interface description block
+
+#define MAX_BLOCK_SIZE     (16 * 1024 * 1024)  // Sanity check on frame and block sizes
+
+// Ethernet types.
+#define ETHERTYPE_IPv4     0x0800
+#define ETHERTYPE_VLAN     0x8100
+#define ETHERTYPE_QINQ     0x88A8
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::PcapFile::PcapFile() :
+    _in(nullptr),
+    _file(),
+    _name(),
+    _ng(false),
+    _be(false),
+    _nano(false),
+    _if(),
+    _block(),
+    _last_ts(0),
+    _frames(0),
+    _skipped(0)
+{
+}
+
+ts::PcapFile::~PcapFile()
+{
+    close();
+}
+
+
+//----------------------------------------------------------------------------
+// Open the file for reading.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::open(const UString& filename, Report& report)
+{
+    if (_in != nullptr) {
+        report.error(u"capture file %s is already open", {_name});
+        return false;
+    }
+
+    // Reset the state.
+    _ng = _be = _nano = false;
+    _if.clear();
+    _block.clear();
+    _last_ts = 0;
+    _frames = _skipped = 0;
+
+    if (filename.empty()) {
+        _name = u"standard input";
+        if (!SetBinaryModeStdin(report)) {
+            return false;
+        }
+        _in = &std::cin;
+    }
+    else {
+        _name = filename;
+        _file.open(filename.toUTF8().c_str(), std::ios::in | std::ios::binary);
+        if (!_file) {
+            report.error(u"cannot open %s", {_name});
+            return false;
+        }
+        _in = &_file;
+    }
+
+    // Read the first 4 bytes to identify the file format.
+    if (!readData(4, report)) {
+        close();
+        return false;
+    }
+
+    const uint32_t magic = GetUInt32LE(_block.data());
+    if (magic == PCAPNG_SHB) {
+        // Read the rest of the initial section header block. Subsequent blocks are read by readFrame().
+        _ng = true;
+        if (!readData(8, report) || !readSectionHeader(_block.data(), _block.size(), report)) {
+            close();
+            return false;
+        }
+    }
+    else if (magic == PCAP_MAGIC_US_LE || magic == PCAP_MAGIC_US_BE || magic == PCAP_MAGIC_NS_LE || magic == PCAP_MAGIC_NS_BE) {
+        _be = magic == PCAP_MAGIC_US_BE || magic == PCAP_MAGIC_NS_BE;
+        _nano = magic == PCAP_MAGIC_NS_LE || magic == PCAP_MAGIC_NS_BE;
+        if (!readData(PCAP_HEADER_SIZE - 4, report)) {
+            close();
+            return false;
+        }
+        // The upper bits of the link type contain optional FCS information.
+        _if.push_back(Interface(get32(_block.data() + 20) & 0xFFFF));
+        report.debug(u"%s: pcap format %d.%d, link type %d", {_name, get16(_block.data() + 4), get16(_block.data() + 6), _if.front().link_type});
+    }
+    else {
+        report.error(u"%s is not a pcap or pcap-ng file", {_name});
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Close the file.
+//----------------------------------------------------------------------------
+
+void ts::PcapFile::close()
+{
+    if (_file.is_open()) {
+        _file.close();
+    }
+    _file.clear();
+    _in = nullptr;
+}
+
+
+//----------------------------------------------------------------------------
+// Read exactly size bytes, append to _block.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::readData(size_t size, Report& report, bool eof_ok)
+{
+    if (_in == nullptr) {
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+
+    const size_t previous = _block.size();
+    _block.resize(previous + size);
+    _in->read(reinterpret_cast<char*>(_block.data() + previous), std::streamsize(size));
+    const size_t insize = size_t(_in->gcount());
+
+    if (insize < size) {
+        _block.resize(previous + insize);
+        if (!eof_ok || insize > 0) {
+            report.error(u"%s: truncated capture file", {_name});
+        }
+        return false;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Process a pcap-ng section header block. The block contains at least
+// the block type, the block length and the byte order magic.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::readSectionHeader(const uint8_t* block, size_t size, Report& report)
+{
+    assert(size >= 12);
+
+    // The byte order magic defines the byte order of the whole section.
+    if (GetUInt32LE(block + 8) == PCAPNG_ORDER_MAGIC) {
+        _be = false;
+    }
+    else if (GetUInt32BE(block + 8) == PCAPNG_ORDER_MAGIC) {
+        _be = true;
+    }
+    else {
+        report.error(u"%s: invalid pcap-ng section header", {_name});
+        return false;
+    }
+
+    // Read the rest of the block (we do not use its content).
+    const uint32_t length = get32(block + 4);
+    if (length < 28 || length % 4 != 0 || length > MAX_BLOCK_SIZE) {
+        report.error(u"%s: invalid pcap-ng section header length %d", {_name, length});
+        return false;
+    }
+    if (!readData(length - size, report)) {
+        return false;
+    }
+
+    // A new section has its own interfaces.
+    _if.clear();
+    report.debug(u"%s: pcap-ng section, format %d.%d, %s endian", {_name, get16(_block.data() + 12), get16(_block.data() + 14), _be ? u"big" : u"little"});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Process a pcap-ng interface description block.
+//----------------------------------------------------------------------------
+
+void ts::PcapFile::readInterfaceDescription(const uint8_t* body, size_t size)
+{
+    Interface itf(size >= 2 ? uint32_t(get16(body)) : uint32_t(LINKTYPE_ETHERNET));
+
+    // Look for the timestamp resolution option.
+    for (size_t offset = 8; offset + 4 <= size; ) {
+        const uint16_t code = get16(body + offset);
+        const size_t len = get16(body + offset + 2);
+        if (code == 0 || offset + 4 + len > size) {
+            break; // end of options
+        }
+        if (code == PCAPNG_TSRESOL && len >= 1) {
+            itf.power2 = (body[offset + 4] & 0x80) != 0;
+            itf.resolution = body[offset + 4] & 0x7F;
+        }
+        offset += 4 + RoundUp<size_t>(len, 4);
+    }
+    _if.push_back(itf);
+}
+
+
+//----------------------------------------------------------------------------
+// Convert a timestamp in interface units to microseconds.
+//----------------------------------------------------------------------------
+
+ts::MicroSecond ts::PcapFile::ToMicroSecond(uint64_t value, const Interface& itf)
+{
+    uint64_t factor = 1;
+    if (itf.power2) {
+        // Resolution is 2^-n second. The fraction of second is multiplied by 10^6 < 2^20.
+        // Above 2^-44, drop the sub-microsecond bits first to avoid a 64-bit overflow.
+        const uint8_t n = std::min<uint8_t>(itf.resolution, 63);
+        const uint8_t drop = n > 44 ? n - 44 : 0;
+        const uint64_t mask = (uint64_t(1) << n) - 1;
+        return MicroSecond((value >> n) * MicroSecPerSec + ((((value & mask) >> drop) * MicroSecPerSec) >> (n - drop)));
+    }
+    else if (itf.resolution <= 6) {
+        // Resolution is 10^-n second, with n <= 6.
+        for (uint8_t n = itf.resolution; n < 6; ++n) {
+            factor *= 10;
+        }
+        return MicroSecond(value * factor);
+    }
+    else {
+        // Resolution is finer than microsecond.
+        for (uint8_t n = 6; n < itf.resolution && n < 25; ++n) {
+            factor *= 10;
+        }
+        return MicroSecond(value / factor);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Read the next captured frame.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::readFrame(const uint8_t*& frame, size_t& size, uint32_t& link_type, MicroSecond& timestamp, Report& report)
+{
+    for (;;) {
+        _block.clear();
+
+        if (!_ng) {
+            // Read one pcap record.
+            if (!readData(PCAP_RECORD_SIZE, report, true)) {
+                return false;
+            }
+            const uint32_t sec = get32(_block.data());
+            const uint32_t frac = get32(_block.data() + 4);
+            const uint32_t caplen = get32(_block.data() + 8);
+            if (caplen > MAX_BLOCK_SIZE) {
+                report.error(u"%s: invalid captured frame size %'d", {_name, caplen});
+                return false;
+            }
+            if (!readData(caplen, report)) {
+                return false;
+            }
+            frame = _block.data() + PCAP_RECORD_SIZE;
+            size = caplen;
+            link_type = _if.front().link_type;
+            timestamp = MicroSecond(sec) * MicroSecPerSec + (_nano ? frac / 1000 : frac);
+            _frames++;
+            return true;
+        }
+
+        // Read the header of the next pcap-ng block.
+        if (!readData(8, report, true)) {
+            return false;
+        }
+        const uint32_t type = get32(_block.data());
+
+        // A section header block may change the byte order, read the byte order magic first.
+        if (type == PCAPNG_SHB) {
+            if (!readData(4, report) || !readSectionHeader(_block.data(), _block.size(), report)) {
+                return false;
+            }
+            continue;
+        }
+
+        // Read the rest of the block.
+        const uint32_t length = get32(_block.data() + 4);
+        if (length < 12 || length % 4 != 0 || length > MAX_BLOCK_SIZE) {
+            report.error(u"%s: invalid pcap-ng block length %d", {_name, length});
+            return false;
+        }
+        if (!readData(length - 8, report)) {
+            return false;
+        }
+        const uint8_t* body = _block.data() + 8;
+        const size_t body_size = length - 12;
+
+        // Process the content of the block.
+        uint32_t ifindex = 0;
+        uint64_t ts = 0;
+        size_t caplen = 0;
+        size_t header_size = 0;
+        switch (type) {
+            case PCAPNG_IDB:
+                readInterfaceDescription(body, body_size);
+                continue;
+            case PCAPNG_EPB:
+                if (body_size < 20) {
+                    continue;
+                }
+                ifindex = get32(body);
+                ts = (uint64_t(get32(body + 4)) << 32) | get32(body + 8);
+                caplen = get32(body + 12);
+                header_size = 20;
+                break;
+            case PCAPNG_OPB:
+                if (body_size < 20) {
+                    continue;
+                }
+                ifindex = get16(body);
+                ts = (uint64_t(get32(body + 4)) << 32) | get32(body + 8);
+                caplen = get32(body + 12);
+                header_size = 20;
+                break;
+            case PCAPNG_SPB:
+                // No interface index (always the first one) and no timestamp (use the last one).
+                if (body_size < 4) {
+                    continue;
+                }
+                caplen = std::min<size_t>(get32(body), body_size - 4);
+                header_size = 4;
+                break;
+            default:
+                // Ignore all other block types.
+                continue;
+        }
+
+        // Skip packets with invalid interface or size.
+        if (ifindex >= _if.size() || header_size + caplen > body_size) {
+            report.debug(u"%s: invalid pcap-ng packet block, interface %d, captured size %d", {_name, ifindex, caplen});
+            _frames++;
+            _skipped++;
+            continue;
+        }
+
+        frame = body + header_size;
+        size = caplen;
+        link_type = _if[ifindex].link_type;
+        if (type != PCAPNG_SPB) {
+            _last_ts = ToMicroSecond(ts, _if[ifindex]);
+        }
+        timestamp = _last_ts;
+        _frames++;
+        return true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Locate the IPv4 packet in a frame.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::LocateIPv4(const uint8_t*& data, size_t& size, uint32_t link_type)
+{
+    size_t offset = 0;
+
+    switch (link_type) {
+        case LINKTYPE_NULL:
+            // Protocol family is in the byte order of the capturing host, AF_INET is 2 everywhere.
+            if (size < 4 || (GetUInt32LE(data) != 2 && GetUInt32BE(data) != 2)) {
+                return false;
+            }
+            offset = 4;
+            break;
+        case LINKTYPE_ETHERNET: {
+            if (size < 14) {
+                return false;
+            }
+            uint16_t ethertype = GetUInt16BE(data + 12);
+            offset = 14;
+            // Skip VLAN tags.
+            while ((ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ) && offset + 4 <= size) {
+                ethertype = GetUInt16BE(data + offset + 2);
+                offset += 4;
+            }
+            if (ethertype != ETHERTYPE_IPv4) {
+                return false;
+            }
+            break;
+        }
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+            break;
+        case LINKTYPE_LINUX_SLL:
+            if (size < 16 || GetUInt16BE(data + 14) != ETHERTYPE_IPv4) {
+                return false;
+            }
+            offset = 16;
+            break;
+        case LINKTYPE_LINUX_SLL2:
+            if (size < 20 || GetUInt16BE(data) != ETHERTYPE_IPv4) {
+                return false;
+            }
+            offset = 20;
+            break;
+        default:
+            return false;
+    }
+
+    // Check that we have an IPv4 packet.
+    if (offset >= size || (data[offset] >> 4) != IPv4_VERSION) {
+        return false;
+    }
+    data += offset;
+    size -= offset;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Read the next IPv4 packet from the capture file.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::readIPv4(const uint8_t*& packet, size_t& size, MicroSecond& timestamp, Report& report)
+{
+    uint32_t link_type = 0;
+    while (readFrame(packet, size, link_type, timestamp, report)) {
+        if (LocateIPv4(packet, size, link_type) && IPHeaderSize(packet, size) > 0) {
+            // Remove the link layer padding after the IP packet, if any.
+            size = std::min<size_t>(size, GetUInt16BE(packet + 2));
+            return true;
+        }
+        _skipped++;
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Read the next UDP datagram from the capture file.
+//----------------------------------------------------------------------------
+
+bool ts::PcapFile::readUDP(SocketAddress& source, SocketAddress& destination, const uint8_t*& payload, size_t& size, MicroSecond& timestamp, Report& report)
+{
+    const uint8_t* ip = nullptr;
+    size_t ip_size = 0;
+
+    while (readIPv4(ip, ip_size, timestamp, report)) {
+        // Skip non-UDP packets and fragments (more fragments flag or non-zero fragment offset).
+        const size_t header_size = IPHeaderSize(ip, ip_size);
+        if (ip[IPv4_PROTOCOL_OFFSET] != IPv4_PROTO_UDP || (GetUInt16BE(ip + 6) & 0x3FFF) != 0 || header_size + UDP_HEADER_SIZE > ip_size) {
+            continue;
+        }
+        const uint8_t* udp = ip + header_size;
+        const size_t udp_size = GetUInt16BE(udp + 4);
+        if (udp_size < UDP_HEADER_SIZE) {
+            continue;
+        }
+        source = SocketAddress(GetUInt32BE(ip + IPv4_SRC_ADDR_OFFSET), GetUInt16BE(udp));
+        destination = SocketAddress(GetUInt32BE(ip + IPv4_DEST_ADDR_OFFSET), GetUInt16BE(udp + 2));
+        payload = udp + UDP_HEADER_SIZE;
+        // The captured frame may be truncated (snapshot length).
+        size = std::min(udp_size, ip_size - header_size) - UDP_HEADER_SIZE;
+        return true;
+    }
+    return false;
+}
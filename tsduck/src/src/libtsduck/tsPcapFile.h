@@ -0,0 +1,190 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Read UDP datagrams from a pcap or pcap-ng capture file.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsMPEG.h"
+#include "tsSocketAddress.h"
+#include "tsByteBlock.h"
+#include "tsReport.h"
+
+namespace ts {
+    //!
+    //! Read UDP datagrams from a pcap or pcap-ng capture file.
+    //! @ingroup net
+    //!
+    //! The pcap format is the traditional format of libpcap and tcpdump, with
+    //! microsecond or nanosecond timestamps, in any byte order. The pcap-ng format
+    //! is the default format of Wireshark. All pcap-ng sections and interfaces are
+    //! supported, with their own link type and timestamp resolution.
+    //!
+    //! Only IPv4 packets are extracted from the captured frames. The supported link
+    //! types are Ethernet (with or without VLAN tags), raw IPv4, BSD loopback and
+    //! Linux cooked captures (SLL and SLL2). Other frames and fragmented IP datagrams
+    //! are skipped.
+    //!
+    class TSDUCKDLL PcapFile
+    {
+    public:
+        //!
+        //! Link types (LINKTYPE_ values of libpcap) which are recognized.
+        //!
+        enum : uint32_t {
+            LINKTYPE_NULL       = 0,    //!< BSD loopback, 4-byte protocol family in host byte order.
+            LINKTYPE_ETHERNET   = 1,    //!< Ethernet II frames.
+            LINKTYPE_RAW        = 101,  //!< Raw IPv4 or IPv6 packets.
+            LINKTYPE_LINUX_SLL  = 113,  //!< Linux cooked capture, version 1.
+            LINKTYPE_IPV4       = 228,  //!< Raw IPv4 packets.
+            LINKTYPE_LINUX_SLL2 = 276,  //!< Linux cooked capture, version 2.
+        };
+
+        //!
+        //! Default constructor.
+        //!
+        PcapFile();
+
+        //!
+        //! Destructor.
+        //!
+        ~PcapFile();
+
+        //!
+        //! Open a capture file for reading.
+        //! @param [in] filename Name of the file to read. If empty, use the standard input.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool open(const UString& filename, Report& report);
+
+        //!
+        //! Close the file.
+        //!
+        void close();
+
+        //!
+        //! Check if the file is open.
+        //! @return True if the file is open.
+        //!
+        bool isOpen() const { return _in != nullptr; }
+
+        //!
+        //! Check if the file uses the pcap-ng format.
+        //! @return True for pcap-ng, false for pcap.
+        //!
+        bool isPcapNG() const { return _ng; }
+
+        //!
+        //! Read the next IPv4 packet from the capture file.
+        //! Frames which do not contain an IPv4 packet are skipped.
+        //! @param [out] packet Address of the IPv4 packet, starting with the IP header.
+        //! The data remain valid until the next read operation.
+        //! @param [out] size Size in bytes of the IPv4 packet.
+        //! @param [out] timestamp Capture timestamp in microseconds since the Unix epoch.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error or end of file.
+        //!
+        bool readIPv4(const uint8_t*& packet, size_t& size, MicroSecond& timestamp, Report& report);
+
+        //!
+        //! Read the next UDP datagram from the capture file.
+        //! All other packets are skipped.
+        //! @param [out] source Source socket address.
+        //! @param [out] destination Destination socket address.
+        //! @param [out] payload Address of the UDP payload.
+        //! The data remain valid until the next read operation.
+        //! @param [out] size Size in bytes of the UDP payload.
+        //! @param [out] timestamp Capture timestamp in microseconds since the Unix epoch.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error or end of file.
+        //!
+        bool readUDP(SocketAddress& source, SocketAddress& destination, const uint8_t*& payload, size_t& size, MicroSecond& timestamp, Report& report);
+
+        //!
+        //! Get the number of captured frames which were read so far.
+        //! @return The number of captured frames.
+        //!
+        PacketCounter frameCount() const { return _frames; }
+
+        //!
+        //! Get the number of captured frames which were skipped because they did not contain IPv4 packets.
+        //! @return The number of skipped frames.
+        //!
+        PacketCounter skippedFrames() const { return _skipped; }
+
+    private:
+        // Description of a capture interface (only one in pcap files).
+        struct Interface
+        {
+            uint32_t link_type;  // Link type.
+            bool     power2;     // Timestamp resolution is a power of 2 instead of 10.
+            uint8_t  resolution; // Exponent of timestamp resolution (default: 6, microseconds).
+            Interface(uint32_t type = LINKTYPE_ETHERNET) : link_type(type), power2(false), resolution(6) {}
+        };
+
+        std::istream*          _in;       // Input stream, file or standard input.
+        std::ifstream          _file;     // Input file.
+        UString                _name;     // File name for error messages.
+        bool                   _ng;       // The file format is pcap-ng.
+        bool                   _be;       // The current file or section is big endian.
+        bool                   _nano;     // Nanosecond timestamps (pcap only).
+        std::vector<Interface> _if;       // Interfaces in current section (pcap: one only).
+        ByteBlock              _block;    // Last read frame or block.
+        MicroSecond            _last_ts;  // Last timestamp (for pcap-ng blocks without timestamp).
+        PacketCounter          _frames;   // Number of read frames.
+        PacketCounter          _skipped;  // Number of skipped frames.
+
+        // Read exactly size bytes, append to _block. Return false on error or end of file.
+        bool readData(size_t size, Report& report, bool eof_ok = false);
+
+        // Get 16/32-bit integers using the current byte order.
+        uint16_t get16(const uint8_t* p) const { return _be ? GetUInt16BE(p) : GetUInt16LE(p); }
+        uint32_t get32(const uint8_t* p) const { return _be ? GetUInt32BE(p) : GetUInt32LE(p); }
+
+        // Read the next captured frame. Return false on error or end of file.
+        bool readFrame(const uint8_t*& frame, size_t& size, uint32_t& link_type, MicroSecond& timestamp, Report& report);
+
+        // Process pcap-ng blocks which do not contain frames.
+        bool readSectionHeader(const uint8_t* block, size_t size, Report& report);
+        void readInterfaceDescription(const uint8_t* body, size_t size);
+
+        // Convert a timestamp in interface units to microseconds.
+        static MicroSecond ToMicroSecond(uint64_t value, const Interface& itf);
+
+        // Locate the IPv4 packet in a frame. Return false if there is none.
+        static bool LocateIPv4(const uint8_t*& data, size_t& size, uint32_t link_type);
+
+        // Inaccessible operations.
+        PcapFile(const PcapFile&) = delete;
+        PcapFile& operator=(const PcapFile&) = delete;
+    };
+}
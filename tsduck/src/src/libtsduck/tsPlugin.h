@@ -38,6 +38,7 @@
 #include "tsReport.h"
 #include "tsTSPacket.h"
 #include "tsEnumeration.h"
+#include "tsMetricsWriter.h"
 
 namespace ts {
 
@@ -103,7 +104,7 @@ namespace ts {
         //! @c int data named @c tspInterfaceVersion which contains the current
         //! interface version at the time the library is built.
         //!
-        static const int API_VERSION = 8;
+        static const int API_VERSION = 9;
 
         //!
         //! Get the current input bitrate in bits/seconds.
@@ -270,6 +271,22 @@ namespace ts {
         //!
         virtual bool isRealTime() {return false;}
 
+        //!
+        //! Collect plugin-specific metrics.
+        //!
+        //! The main application may provide a metrics server. This method is
+        //! invoked in the context of the metrics server thread, concurrently with
+        //! the plugin thread. The implementation shall read only atomic variables
+        //! or data which are otherwise safe to read from another thread. It shall
+        //! never wait for a lock which is held in the packet path. The labels which
+        //! identify the plugin in the application are already set in @a writer.
+        //!
+        //! Optionally implemented by subclasses. By default, there is no plugin-specific metrics.
+        //!
+        //! @param [in,out] writer The metrics writer where the metrics shall be added.
+        //!
+        virtual void getMetrics(MetricsWriter& writer) {}
+
         //!
         //! Get the plugin type.
         //! @return The plugin type.
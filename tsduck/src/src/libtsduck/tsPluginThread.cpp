@@ -42,7 +42,11 @@ ts::PluginThread::PluginThread(Report* report, const UString& appName, const Plu
     _report(report),
     _name(options.name),
     _logname(),
-    _shlib(nullptr)
+    _shlib(nullptr),
+    _metric_packets(0),
+    _metric_dropped(0),
+    _metric_buffered(0),
+    _metric_bitrate(0)
 {
     const UChar* shellOpt = nullptr;
 
@@ -120,3 +124,19 @@ void ts::PluginThread::writeLog(int severity, const UString& msg)
 {
     _report->log(severity, u"%s: %s", {_logname.empty() ? _name : _logname, msg});
 }
+
+
+//----------------------------------------------------------------------------
+// Collect the metrics of the plugin thread and its plugin.
+//----------------------------------------------------------------------------
+
+void ts::PluginThread::getMetrics(MetricsWriter& writer)
+{
+    writer.counter(u"plugin_packets_total", u"Number of TS packets processed by the plugin.", _metric_packets.load(std::memory_order_relaxed));
+    writer.counter(u"plugin_dropped_packets_total", u"Number of TS packets dropped by the plugin or its executor.", _metric_dropped.load(std::memory_order_relaxed));
+    writer.gauge(u"plugin_buffered_packets", u"Number of TS packets currently buffered for the plugin.", int64_t(_metric_buffered.load(std::memory_order_relaxed)));
+    writer.gauge(u"plugin_bitrate_bps", u"Bitrate as seen by the plugin, in bits/second, zero if unknown.", int64_t(_metric_bitrate.load(std::memory_order_relaxed)));
+    if (_shlib != nullptr) {
+        _shlib->getMetrics(writer);
+    }
+}
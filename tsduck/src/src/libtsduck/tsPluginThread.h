@@ -36,6 +36,8 @@
 #include "tsThread.h"
 #include "tsPlugin.h"
 #include "tsPluginOptions.h"
+#include "tsMetricsProviderInterface.h"
+#include <atomic>
 
 namespace ts {
     //!
@@ -43,7 +45,12 @@ namespace ts {
     //! The subclasses shall implement the TSP interface.
     //! @ingroup plugin
     //!
-    class TSDUCKDLL PluginThread: public Thread, public TSP
+    //! A plugin thread also maintains a few statistics which can be collected
+    //! by a metrics server. The subclasses publish them in their packet path
+    //! using lock-free atomic updates. The metrics server reads them from
+    //! another thread without locking.
+    //!
+    class TSDUCKDLL PluginThread: public Thread, public TSP, public MetricsProviderInterface
     {
     public:
         //!
@@ -108,15 +115,51 @@ namespace ts {
             _logname = name;
         }
 
+        //!
+        //! Collect the metrics of the plugin thread and its plugin.
+        //! The common labels which identify the plugin in the application shall be
+        //! set in @a writer by the caller. This method is thread-safe and lock-free.
+        //! @param [in,out] writer The metrics writer where the metrics are added.
+        //!
+        virtual void getMetrics(MetricsWriter& writer) override;
+
     protected:
         // Inherited from Report (via TSP)
         virtual void writeLog(int severity, const UString& msg) override;
 
+        //!
+        //! Publish the total number of packets which were processed by the plugin.
+        //! @param [in] count Total number of packets.
+        //!
+        void publishPacketCount(PacketCounter count) { _metric_packets.store(count, std::memory_order_relaxed); }
+
+        //!
+        //! Publish the total number of packets which were dropped by the plugin or its executor.
+        //! @param [in] count Total number of dropped packets.
+        //!
+        void publishDroppedCount(PacketCounter count) { _metric_dropped.store(count, std::memory_order_relaxed); }
+
+        //!
+        //! Publish the number of packets which are currently buffered for the plugin.
+        //! @param [in] count Number of buffered packets.
+        //!
+        void publishBufferedCount(size_t count) { _metric_buffered.store(count, std::memory_order_relaxed); }
+
+        //!
+        //! Publish the current bitrate, as seen by the plugin.
+        //! @param [in] bitrate Bitrate in bits/second, zero if unknown.
+        //!
+        void publishBitrate(BitRate bitrate) { _metric_bitrate.store(bitrate, std::memory_order_relaxed); }
+
     private:
         Report* _report;  // Common report interface for all plugins
         UString _name;    // Plugin name.
         UString _logname; // Plugin name as displayed in log messages.
         Plugin* _shlib;   // Shared library API.
+        std::atomic<PacketCounter> _metric_packets;   // Published total number of packets.
+        std::atomic<PacketCounter> _metric_dropped;   // Published number of dropped packets.
+        std::atomic<size_t>        _metric_buffered;  // Published number of buffered packets.
+        std::atomic<BitRate>       _metric_bitrate;   // Published bitrate.
 
         // Inaccessible operations.
         PluginThread() = delete;
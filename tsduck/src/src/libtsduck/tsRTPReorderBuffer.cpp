@@ -0,0 +1,367 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Reordering buffer for RTP messages.
+//
+//----------------------------------------------------------------------------
+
+#include "tsRTPReorderBuffer.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::RTPReorderBuffer::DEFAULT_CAPACITY;
+#endif
+
+// The capacity is a power of two, dividing the range of sequence numbers.
+#define MAX_CAPACITY 0x8000
+
+
+//----------------------------------------------------------------------------
+// Constructors.
+//----------------------------------------------------------------------------
+
+ts::RTPReorderBuffer::Statistics::Statistics() :
+    received(0),
+    delivered(0),
+    lost(0),
+    reordered(0),
+    duplicated(0),
+    late(0),
+    discarded(0),
+    resync(0)
+{
+}
+
+ts::RTPReorderBuffer::Slot::Slot() :
+    used(false),
+    sequence(0),
+    arrival(),
+    data()
+{
+}
+
+ts::RTPReorderBuffer::RTPReorderBuffer(size_t capacity, NanoSecond latency) :
+    _slots(),
+    _latency(0),
+    _started(false),
+    _next(0),
+    _highest(0),
+    _head(0),
+    _head_valid(false),
+    _count(0),
+    _pending(),
+    _pending_resync(false),
+    _stats()
+{
+    reset(capacity, latency);
+}
+
+
+//----------------------------------------------------------------------------
+// Round a capacity to the next power of two. This ensures that all sequence
+// numbers in a window of the buffer capacity use distinct slots.
+//----------------------------------------------------------------------------
+
+namespace {
+    size_t RoundCapacity(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity && size < MAX_CAPACITY) {
+            size *= 2;
+        }
+        return size;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the buffer with new parameters.
+//----------------------------------------------------------------------------
+
+void ts::RTPReorderBuffer::reset(size_t capacity, NanoSecond latency)
+{
+    // Don't reallocate the slots when the capacity is unchanged.
+    const size_t size = RoundCapacity(capacity);
+    if (_slots.size() != size) {
+        _slots.resize(size);
+    }
+    for (auto it = _slots.begin(); it != _slots.end(); ++it) {
+        it->used = false;
+    }
+
+    _latency = latency;
+    _started = false;
+    _next = _highest = _head = 0;
+    _head_valid = false;
+    _count = 0;
+    _pending.used = false;
+    _pending_resync = false;
+    _stats = Statistics();
+}
+
+
+//----------------------------------------------------------------------------
+// Increase the capacity of the buffer, keeping the waiting messages.
+//----------------------------------------------------------------------------
+
+void ts::RTPReorderBuffer::growCapacity(size_t capacity)
+{
+    const size_t size = RoundCapacity(capacity);
+    if (size > _slots.size()) {
+        // All waiting messages are in a window of the old capacity, they use distinct new slots.
+        std::vector<Slot> slots(size);
+        for (auto it = _slots.begin(); it != _slots.end(); ++it) {
+            if (it->used) {
+                Slot& sl(slots[it->sequence % size]);
+                sl.used = true;
+                sl.sequence = it->sequence;
+                sl.arrival = it->arrival;
+                sl.data.swap(it->data);
+            }
+        }
+        _slots.swap(slots);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the first waiting sequence number.
+//----------------------------------------------------------------------------
+
+uint16_t ts::RTPReorderBuffer::head()
+{
+    // The scan is done once per gap in the sequence numbers, the result is
+    // kept until the head message is delivered.
+    assert(_count > 0);
+    if (!_head_valid) {
+        _head = _next;
+        while (!slot(_head).used) {
+            _head++;
+        }
+        _head_valid = true;
+    }
+    return _head;
+}
+
+
+//----------------------------------------------------------------------------
+// Discard waiting messages.
+//----------------------------------------------------------------------------
+
+void ts::RTPReorderBuffer::discardAll()
+{
+    if (_count > 0) {
+        for (auto it = _slots.begin(); it != _slots.end(); ++it) {
+            it->used = false;
+        }
+        _stats.discarded += _count;
+        _count = 0;
+    }
+    _head_valid = false;
+}
+
+void ts::RTPReorderBuffer::discardBefore(uint16_t sequence)
+{
+    for (auto it = _slots.begin(); _count > 0 && it != _slots.end(); ++it) {
+        if (it->used && distance(it->sequence) < distance(sequence)) {
+            it->used = false;
+            _stats.discarded++;
+            _count--;
+        }
+    }
+    _head_valid = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Move the pending message in the buffer.
+//----------------------------------------------------------------------------
+
+void ts::RTPReorderBuffer::enterPending()
+{
+    // First sequence number in the window of the pending message.
+    const uint16_t base = uint16_t(_pending.sequence - _slots.size() + 1);
+
+    if (int16_t(uint16_t(base - _next)) > 0) {
+        if (_pending_resync && _count == 0) {
+            // Discontinuity, restart from the pending message.
+            _next = _pending.sequence;
+        }
+        else {
+            // All missing messages before the window are lost.
+            if (!_pending_resync) {
+                _stats.lost += uint16_t(base - _next);
+            }
+            _next = base;
+        }
+    }
+
+    // No waiting message is before the window, the slot is free.
+    Slot& sl(slot(_pending.sequence));
+    assert(!sl.used);
+    sl.used = true;
+    sl.sequence = _pending.sequence;
+    sl.arrival = _pending.arrival;
+    sl.data.swap(_pending.data);
+    _pending.used = false;
+    _count++;
+    _head_valid = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Insert a received message in the buffer.
+//----------------------------------------------------------------------------
+
+bool ts::RTPReorderBuffer::insert(uint16_t sequence, const void* data, size_t size, const Monotonic& arrival)
+{
+    const int window = int(_slots.size());
+    const uint8_t* const bytes = reinterpret_cast<const uint8_t*>(data);
+
+    // The first message defines the initial sequence number.
+    if (!_started) {
+        _started = true;
+        _next = _highest = sequence;
+    }
+
+    // The messages before a previous pending message were not extracted, drop them.
+    if (_pending.used) {
+        discardBefore(uint16_t(_pending.sequence - window + 1));
+        enterPending();
+    }
+
+    // Position of the message, relatively to the next one to deliver.
+    const int delta = int16_t(uint16_t(sequence - _next));
+
+    if (delta < 0 && delta >= -window) {
+        // Sequence number already delivered or declared lost.
+        _stats.late++;
+        return false;
+    }
+    else if (delta < 0) {
+        // Backward discontinuity in the sequence numbers, restart from this message.
+        _stats.resync++;
+        discardAll();
+        _next = _highest = sequence;
+    }
+    else if (delta >= window) {
+        // Beyond the capacity of the buffer. The message is kept aside until next() delivers
+        // the waiting messages before its window, without waiting for the missing ones.
+        _pending_resync = delta >= 2 * window;
+        if (_pending_resync) {
+            _stats.resync++;
+        }
+        _pending.used = true;
+        _pending.sequence = _highest = sequence;
+        _pending.arrival = arrival;
+        _pending.data.assign(bytes, bytes + size);
+        _stats.received++;
+        if (_count == 0) {
+            enterPending();
+        }
+        return true;
+    }
+
+    Slot& sl(slot(sequence));
+    if (sl.used) {
+        // In the window of the buffer, a used slot necessarily has the same sequence number.
+        _stats.duplicated++;
+        return false;
+    }
+
+    // A message which is older than the highest received one was reordered.
+    if (int16_t(uint16_t(sequence - _highest)) < 0) {
+        _stats.reordered++;
+    }
+    else {
+        _highest = sequence;
+    }
+
+    sl.used = true;
+    sl.sequence = sequence;
+    sl.arrival = arrival;
+    sl.data.assign(bytes, bytes + size);
+    if (_head_valid && distance(sequence) < distance(_head)) {
+        _head = sequence;
+    }
+    _count++;
+    _stats.received++;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Extract the next message in sequence order.
+//----------------------------------------------------------------------------
+
+bool ts::RTPReorderBuffer::next(const uint8_t*& data, size_t& size, const Monotonic& now)
+{
+    data = nullptr;
+    size = 0;
+
+    if (_pending.used) {
+        const uint16_t base = uint16_t(_pending.sequence - _slots.size() + 1);
+        if (_count > 0 && int16_t(uint16_t(base - _next)) > 0 && distance(head()) < distance(base)) {
+            // Deliver the waiting messages before the window of the pending message, without waiting.
+            _stats.lost += distance(_head);
+            _next = _head;
+        }
+        else {
+            enterPending();
+        }
+    }
+
+    if (_count == 0) {
+        return false;
+    }
+
+    // When the next message is missing, skip the missing ones if the first waiting message exceeded the latency.
+    if (!slot(_next).used) {
+        const uint16_t first = head();
+        if (now - slot(first).arrival < _latency) {
+            return false;
+        }
+        _stats.lost += distance(first);
+        _next = first;
+    }
+
+    // Deliver the next message.
+    Slot& sl(slot(_next));
+    assert(sl.used);
+    sl.used = false;
+    if (_head_valid && _head == _next) {
+        _head_valid = false;
+    }
+    _count--;
+    _next++;
+    _stats.delivered++;
+    data = sl.data.data();
+    size = sl.data.size();
+    return true;
+}
@@ -0,0 +1,192 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Reordering buffer for RTP messages.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsByteBlock.h"
+#include "tsMonotonic.h"
+
+namespace ts {
+    //!
+    //! Reordering buffer for RTP messages, based on their sequence numbers.
+    //! @ingroup net
+    //!
+    //! RTP messages are inserted in their order of reception and extracted in the
+    //! order of their sequence numbers. When a message is missing, the following
+    //! messages are held in the buffer, waiting for the missing one, at most during
+    //! a given latency. After that latency, the missing message is considered as lost.
+    //! A message which arrives after its sequence number was delivered or declared
+    //! lost is dropped.
+    //!
+    //! The latency is evaluated only when messages are inserted or extracted. There is
+    //! no timer: the buffer is designed for continuous streams of messages. The latency
+    //! of a missing message is evaluated from the arrival of the first waiting message
+    //! after it.
+    //!
+    //! When a message arrives beyond the capacity of the buffer, the missing messages
+    //! before its window are declared lost and the waiting messages before its window
+    //! are immediately delivered in order. When the distance exceeds twice the capacity
+    //! (typically when the sender restarts), this is counted as a discontinuity instead
+    //! of lost messages. After a backward discontinuity in the sequence numbers, the
+    //! waiting messages are discarded and the buffer restarts from the new sequence number.
+    //!
+    //! The memory of the buffer is reused: after the initial growth of each slot to
+    //! the message size, there is no memory allocation.
+    //!
+    class TSDUCKDLL RTPReorderBuffer
+    {
+    public:
+        //!
+        //! Default capacity of the buffer in number of messages.
+        //!
+        static const size_t DEFAULT_CAPACITY = 1024;
+
+        //!
+        //! Statistics of the reordering buffer.
+        //!
+        struct TSDUCKDLL Statistics
+        {
+            Statistics();           //!< Constructor.
+            uint64_t received;      //!< Number of valid messages which were inserted.
+            uint64_t delivered;     //!< Number of messages which were extracted.
+            uint64_t lost;          //!< Number of missing sequence numbers which were skipped.
+            uint64_t reordered;     //!< Number of messages which were received out of order.
+            uint64_t duplicated;    //!< Number of duplicated messages which were dropped.
+            uint64_t late;          //!< Number of messages which were dropped because they arrived too late.
+            uint64_t discarded;     //!< Number of waiting messages which were discarded after a discontinuity.
+            uint64_t resync;        //!< Number of discontinuities in the sequence numbers.
+        };
+
+        //!
+        //! Constructor.
+        //! @param [in] capacity Maximum number of messages in the buffer.
+        //! @param [in] latency Maximum time a message is held while waiting for missing messages.
+        //!
+        RTPReorderBuffer(size_t capacity = DEFAULT_CAPACITY, NanoSecond latency = 0);
+
+        //!
+        //! Reset the buffer with new parameters.
+        //! All messages are dropped and the statistics are reset.
+        //! @param [in] capacity Maximum number of messages in the buffer.
+        //! @param [in] latency Maximum time a message is held while waiting for missing messages.
+        //!
+        void reset(size_t capacity, NanoSecond latency);
+
+        //!
+        //! Increase the capacity of the buffer, keeping the waiting messages.
+        //! Nothing is done if the buffer is already large enough.
+        //! @param [in] capacity New minimum number of messages in the buffer.
+        //!
+        void growCapacity(size_t capacity);
+
+        //!
+        //! Get the capacity of the buffer.
+        //! @return The maximum number of messages in the buffer.
+        //!
+        size_t capacity() const { return _slots.size(); }
+
+        //!
+        //! Insert a received message in the buffer.
+        //! The message data are copied into the buffer.
+        //! @param [in] sequence RTP sequence number of the message.
+        //! @param [in] data Address of the message data, typically the RTP payload.
+        //! @param [in] size Size in bytes of the message data.
+        //! @param [in] arrival Reception time of the message.
+        //! @return True if the message was stored, false if it was dropped (late or duplicated).
+        //!
+        bool insert(uint16_t sequence, const void* data, size_t size, const Monotonic& arrival);
+
+        //!
+        //! Extract the next message in sequence order.
+        //! After the insertion of a message beyond the capacity of the buffer, this method shall be
+        //! called until it returns false before inserting another message, otherwise the waiting
+        //! messages before the window of that message are discarded.
+        //! @param [out] data Address of the message data inside the buffer. It remains valid until the next call to insert().
+        //! @param [out] size Size in bytes of the message data.
+        //! @param [in] now Current time, used to check the latency of waiting messages.
+        //! @return True if a message is returned, false if no message is available yet.
+        //!
+        bool next(const uint8_t*& data, size_t& size, const Monotonic& now);
+
+        //!
+        //! Get the number of messages which are currently in the buffer.
+        //! @return The number of messages in the buffer.
+        //!
+        size_t count() const { return _count; }
+
+        //!
+        //! Get the statistics of the buffer.
+        //! @return A constant reference to the statistics.
+        //!
+        const Statistics& statistics() const { return _stats; }
+
+    private:
+        // Description of a message slot, indexed by sequence number modulo capacity.
+        struct Slot
+        {
+            Slot();
+            bool      used;      // Slot contains a message to deliver.
+            uint16_t  sequence;  // Sequence number of the message.
+            Monotonic arrival;   // Reception time of the message.
+            ByteBlock data;      // Message data, the capacity is reused.
+        };
+
+        std::vector<Slot> _slots;    // Message slots.
+        NanoSecond _latency;         // Maximum latency of waiting messages.
+        bool       _started;         // A first message was received.
+        uint16_t   _next;            // Next sequence number to deliver.
+        uint16_t   _highest;         // Highest received sequence number.
+        uint16_t   _head;            // First waiting sequence number, when _head_valid.
+        bool       _head_valid;      // _head is up to date.
+        size_t     _count;           // Number of messages in the buffer, without _pending.
+        Slot       _pending;         // Message beyond the capacity, waiting for the flush of the buffer.
+        bool       _pending_resync;  // The pending message is a discontinuity, not a loss.
+        Statistics _stats;           // Buffer statistics.
+
+        // Get the slot of a sequence number.
+        Slot& slot(uint16_t sequence) { return _slots[sequence % _slots.size()]; }
+
+        // Distance of a sequence number from the next one to deliver.
+        uint16_t distance(uint16_t sequence) const { return uint16_t(sequence - _next); }
+
+        // Compute the first waiting sequence number. The buffer must not be empty.
+        uint16_t head();
+
+        // Discard all waiting messages, or only the ones before a sequence number.
+        void discardAll();
+        void discardBefore(uint16_t sequence);
+
+        // Move the pending message in the buffer, when no waiting message is before its window.
+        void enterPending();
+    };
+}
@@ -227,6 +227,14 @@ void ts::SectionDemux::immediateResetPID(PID pid)
     _pids.erase(pid);
 }
 
+void ts::SectionDemux::syncLost()
+{
+    SuperClass::syncLost();
+    for (auto it = _pids.begin(); it != _pids.end(); ++it) {
+        it->second.syncLost();
+    }
+}
+
 
 //----------------------------------------------------------------------------
 // Feed the depacketizer with a TS packet.
@@ -72,6 +72,7 @@ namespace ts {
 
         // Inherited methods
         virtual void feedPacket(const TSPacket& pkt) override;
+        virtual void syncLost() override;
 
         //!
         //! Pack sections and in all incomplete tables and notify these rebuilt tables.
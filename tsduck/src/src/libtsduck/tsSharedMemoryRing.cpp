@@ -0,0 +1,736 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsSharedMemoryRing.h"
+#include "tsSysUtils.h"
+#include "tsNullReport.h"
+#include <atomic>
+#if defined(TS_UNIX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#endif
+#if defined(TS_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::SharedMemoryRing::DEFAULT_SIZE;
+const size_t ts::SharedMemoryRing::DEFAULT_MAX_READERS;
+#endif
+
+namespace {
+    // Identification of a ring in shared memory.
+    const uint32_t RING_MAGIC = 0x54535352;  // "TSSR"
+    const uint32_t RING_VERSION = 2;
+
+    // Size of a cache line, to avoid false sharing between writer and readers.
+    const size_t CACHE_LINE = 64;
+
+    // Timeout when waiting for the other side, to check abort conditions.
+    const ts::MilliSecond WAIT_TIMEOUT = 100;
+
+    // A process which did not update its heartbeat for this time is possibly dead.
+    // This is also the time before a purged reader slot can be reused.
+    const ts::MilliSecond HEARTBEAT_TIMEOUT = 1000;
+
+    // Current time in milliseconds on a system-wide monotonic clock, used as heartbeat.
+    // Unlike process ids, this clock is common to all PID namespaces of the system.
+    uint64_t HeartbeatTime()
+    {
+#if defined(TS_UNIX)
+        ::timespec now;
+        ::clock_gettime(CLOCK_MONOTONIC, &now);
+        return uint64_t(now.tv_sec) * ts::MilliSecPerSec + uint64_t(now.tv_nsec) / ts::NanoSecPerMilliSec;
+#else
+        return 0;
+#endif
+    }
+
+    // Check if a process is dead, based on its process id and heartbeat.
+    // A process in another PID namespace is not visible but still updates its heartbeat.
+    bool ProcessIsDead(uint32_t pid, uint64_t heartbeat, uint64_t now)
+    {
+#if defined(TS_UNIX)
+        return now >= heartbeat + HEARTBEAT_TIMEOUT && ::kill(pid_t(pid), 0) < 0 && errno == ESRCH;
+#else
+        return false;
+#endif
+    }
+
+    // Wait until the value at an address is no longer the expected one.
+    // Return false on timeout. Without futex, simply sleep for a short time.
+    bool WaitValue(std::atomic<uint32_t>& value, uint32_t expected, ts::MilliSecond timeout)
+    {
+#if defined(TS_LINUX)
+        ::timespec delay;
+        delay.tv_sec = time_t(timeout / ts::MilliSecPerSec);
+        delay.tv_nsec = long((timeout % ts::MilliSecPerSec) * ts::NanoSecPerMilliSec);
+        return ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAIT, expected, &delay, nullptr, 0) == 0 || errno != ETIMEDOUT;
+#else
+        if (value.load() == expected) {
+            ts::SleepThread(1);
+        }
+        return false;
+#endif
+    }
+
+    // Wake up all processes which wait on a value.
+    void WakeValue(std::atomic<uint32_t>& value)
+    {
+#if defined(TS_LINUX)
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&value), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    // Round a size up to the next cache line.
+    inline size_t CacheRound(size_t size)
+    {
+        return ((size + CACHE_LINE - 1) / CACHE_LINE) * CACHE_LINE;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Structures in shared memory.
+// Fields which are modified by the writer and the readers are in distinct
+// cache lines. The shared memory is initially zeroed by the system.
+//----------------------------------------------------------------------------
+
+struct ts::SharedMemoryRing::SharedHeader
+{
+    uint32_t magic;                          // RING_MAGIC when the ring is initialized.
+    uint32_t version;                        // RING_VERSION.
+    uint32_t size;                           // Ring size in packets.
+    uint32_t max_readers;                    // Number of reader slots.
+    std::atomic<uint32_t> writer_pid;        // Process id of the writer.
+    std::atomic<uint64_t> writer_heartbeat;  // Last activity time of the writer (HeartbeatTime).
+    alignas(CACHE_LINE) std::atomic<uint64_t> write_index;  // Total number of written packets.
+    std::atomic<uint64_t> write_limit;       // Write index after the write in progress, set before copying.
+    std::atomic<uint32_t> data_seq;          // Incremented when packets are written, futex for readers.
+    std::atomic<uint32_t> readers_waiting;   // Some reader waits on data_seq.
+    std::atomic<uint32_t> bitrate;           // Bitrate from the writer, zero if unknown.
+    std::atomic<uint32_t> eof;               // Writer closed the ring.
+    alignas(CACHE_LINE) std::atomic<uint32_t> space_seq;    // Incremented when packets are read, futex for the writer.
+    std::atomic<uint32_t> writer_waiting;    // The writer waits on space_seq.
+};
+
+struct ts::SharedMemoryRing::SharedReader
+{
+    alignas(CACHE_LINE) std::atomic<uint32_t> state;  // Slot generation and SLOT_xxx, see SlotWord().
+    std::atomic<uint32_t> pid;               // Process id of the reader.
+    std::atomic<uint64_t> read_index;        // Total number of packets read.
+    std::atomic<uint64_t> heartbeat;         // Last activity time of the reader, purge time when purged.
+};
+
+namespace {
+    // States of a reader slot.
+    enum : uint32_t {
+        SLOT_FREE     = 0,  // Unused slot.
+        SLOT_CLAIMED  = 1,  // Reader is attaching.
+        SLOT_ACTIVE   = 2,  // Reader is attached.
+        SLOT_PURGED   = 3,  // Reader was detached by the writer, not reusable before HEARTBEAT_TIMEOUT.
+        SLOT_MASK     = 3,
+    };
+
+    // The state word of a reader slot contains a generation in the upper bits, incremented
+    // each time the slot is claimed. A reader owns its slot as long as the state word is
+    // unchanged since its activation. A state word is never zero for an active slot.
+    inline uint32_t SlotWord(uint32_t generation, uint32_t state) { return (generation << 2) | state; }
+    inline uint32_t SlotState(uint32_t word) { return word & SLOT_MASK; }
+    inline uint32_t SlotGeneration(uint32_t word) { return word >> 2; }
+}
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::SharedMemoryRing::SharedMemoryRing() :
+    _name(),
+    _writer(false),
+    _fd(-1),
+    _memory(nullptr),
+    _memory_size(0),
+    _header(nullptr),
+    _readers(nullptr),
+    _packets(nullptr),
+    _size(0),
+    _max_readers(0),
+    _slot(0),
+    _slot_word(0),
+    _read_index(0),
+    _lost_packets(0),
+    _pcr()
+{
+}
+
+ts::SharedMemoryRing::~SharedMemoryRing()
+{
+    close(NULLREP);
+}
+
+
+//----------------------------------------------------------------------------
+// Build the system name of a shared memory segment.
+//----------------------------------------------------------------------------
+
+ts::UString ts::SharedMemoryRing::SystemName(const UString& name)
+{
+    return name.startWith(u"/") ? name : u"/" + name;
+}
+
+
+//----------------------------------------------------------------------------
+// Map the shared memory segment, compute the addresses of the ring.
+//----------------------------------------------------------------------------
+
+bool ts::SharedMemoryRing::map(size_t size, Report& report)
+{
+#if defined(TS_UNIX)
+    void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (addr == MAP_FAILED) {
+        report.error(u"error mapping shared memory %s: %s", {_name, ErrorCodeMessage()});
+        return false;
+    }
+    _memory = addr;
+    _memory_size = size;
+    _header = reinterpret_cast<SharedHeader*>(addr);
+    _readers = reinterpret_cast<SharedReader*>(reinterpret_cast<uint8_t*>(addr) + CacheRound(sizeof(SharedHeader)));
+    _packets = reinterpret_cast<TSPacket*>(reinterpret_cast<uint8_t*>(_readers) + CacheRound(_max_readers * sizeof(SharedReader)));
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Unmap the shared memory segment.
+//----------------------------------------------------------------------------
+
+void ts::SharedMemoryRing::unmap()
+{
+#if defined(TS_UNIX)
+    if (_memory != nullptr) {
+        ::munmap(_memory, _memory_size);
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+#endif
+    _fd = -1;
+    _memory = nullptr;
+    _memory_size = 0;
+    _header = nullptr;
+    _readers = nullptr;
+    _packets = nullptr;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the writer process of an existing segment, zero if unknown.
+//----------------------------------------------------------------------------
+
+#if defined(TS_UNIX)
+pid_t ts::SharedMemoryRing::WriterProcess(const std::string& sname, uint64_t& heartbeat)
+{
+    pid_t pid = 0;
+    heartbeat = 0;
+    const int fd = ::shm_open(sname.c_str(), O_RDONLY, 0);
+    struct ::stat st;
+    if (fd >= 0 && ::fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(SharedHeader)) {
+        void* addr = ::mmap(nullptr, sizeof(SharedHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (addr != MAP_FAILED) {
+            const SharedHeader* header = reinterpret_cast<const SharedHeader*>(addr);
+            if (header->magic == RING_MAGIC) {
+                pid = pid_t(header->writer_pid.load());
+                heartbeat = header->writer_heartbeat.load();
+            }
+            ::munmap(addr, sizeof(SharedHeader));
+        }
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    return pid;
+}
+#endif
+
+
+//----------------------------------------------------------------------------
+// Create a ring as writer.
+//----------------------------------------------------------------------------
+
+bool ts::SharedMemoryRing::create(const UString& name, size_t size, size_t max_readers, Report& report)
+{
+    if (isOpen()) {
+        report.error(u"shared memory ring %s already open", {_name});
+        return false;
+    }
+    if (size == 0 || size > 0xFFFFFFFF || max_readers == 0) {
+        report.error(u"invalid shared memory ring size");
+        return false;
+    }
+
+#if defined(TS_UNIX)
+    _name = SystemName(name);
+    _writer = true;
+    _size = size;
+    _max_readers = max_readers;
+    _read_index = 0;
+    const std::string sname(_name.toUTF8());
+
+    // Create the segment. If it already exists, replace it when its writer is dead.
+    _fd = ::shm_open(sname.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (_fd < 0 && errno == EEXIST) {
+        uint64_t heartbeat = 0;
+        const pid_t pid = WriterProcess(sname, heartbeat);
+        if (pid != 0 && !ProcessIsDead(uint32_t(pid), heartbeat, HeartbeatTime())) {
+            report.error(u"shared memory ring %s is already used by process %d", {_name, pid});
+            return false;
+        }
+        report.verbose(u"replacing stale shared memory ring %s", {_name});
+        ::shm_unlink(sname.c_str());
+        _fd = ::shm_open(sname.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    }
+    if (_fd < 0) {
+        report.error(u"error creating shared memory %s: %s", {_name, ErrorCodeMessage()});
+        return false;
+    }
+
+    // Allocate and map the segment.
+    const size_t total = CacheRound(sizeof(SharedHeader)) + CacheRound(_max_readers * sizeof(SharedReader)) + _size * PKT_SIZE;
+    if (::ftruncate(_fd, off_t(total)) < 0) {
+        report.error(u"error resizing shared memory %s: %s", {_name, ErrorCodeMessage()});
+        unmap();
+        ::shm_unlink(sname.c_str());
+        return false;
+    }
+    if (!map(total, report)) {
+        unmap();
+        ::shm_unlink(sname.c_str());
+        return false;
+    }
+
+    // Initialize the header. The magic number is set last, the ring is then ready for readers.
+    _header->version = RING_VERSION;
+    _header->size = uint32_t(_size);
+    _header->max_readers = uint32_t(_max_readers);
+    _header->writer_pid = uint32_t(::getpid());
+    _header->writer_heartbeat = HeartbeatTime();
+    std::atomic_thread_fence(std::memory_order_release);
+    _header->magic = RING_MAGIC;
+
+    report.debug(u"created shared memory ring %s, %d packets, %d readers max", {_name, _size, _max_readers});
+    return true;
+#else
+    report.error(u"shared memory rings are not supported on this system");
+    return false;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Attach to an existing ring as reader.
+//----------------------------------------------------------------------------
+
+bool ts::SharedMemoryRing::open(const UString& name, Report& report)
+{
+    if (isOpen()) {
+        report.error(u"shared memory ring %s already open", {_name});
+        return false;
+    }
+
+#if defined(TS_UNIX)
+    _name = SystemName(name);
+    _writer = false;
+    const std::string sname(_name.toUTF8());
+
+    _fd = ::shm_open(sname.c_str(), O_RDWR, 0);
+    if (_fd < 0) {
+        report.error(u"error opening shared memory %s: %s", {_name, ErrorCodeMessage()});
+        return false;
+    }
+
+    // Check that the segment is an initialized ring.
+    struct ::stat st;
+    _max_readers = 0;
+    if (::fstat(_fd, &st) < 0 || size_t(st.st_size) < sizeof(SharedHeader) || !map(size_t(st.st_size), report)) {
+        report.error(u"shared memory %s is not a ring of TS packets", {_name});
+        unmap();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_header->magic != RING_MAGIC || _header->version != RING_VERSION) {
+        report.error(u"shared memory %s is not a ring of TS packets or is not yet initialized", {_name});
+        unmap();
+        return false;
+    }
+
+    // Now compute the actual addresses in the ring.
+    _size = _header->size;
+    _max_readers = _header->max_readers;
+    _readers = reinterpret_cast<SharedReader*>(reinterpret_cast<uint8_t*>(_memory) + CacheRound(sizeof(SharedHeader)));
+    _packets = reinterpret_cast<TSPacket*>(reinterpret_cast<uint8_t*>(_readers) + CacheRound(_max_readers * sizeof(SharedReader)));
+    if (_size == 0 || reinterpret_cast<uint8_t*>(_packets + _size) > reinterpret_cast<uint8_t*>(_memory) + _memory_size) {
+        report.error(u"shared memory %s is too small for its ring", {_name});
+        unmap();
+        return false;
+    }
+
+    // Claim a free reader slot, with a new generation. A purged slot is reused after
+    // some time only, when its previous reader, if still alive, knows it is purged.
+    const uint64_t now = HeartbeatTime();
+    uint32_t generation = 0;
+    for (_slot = 0; _slot < _max_readers; ++_slot) {
+        uint32_t word = _readers[_slot].state.load();
+        generation = SlotGeneration(word) + 1;
+        const bool usable = SlotState(word) == SLOT_FREE || (SlotState(word) == SLOT_PURGED && now >= _readers[_slot].heartbeat.load() + HEARTBEAT_TIMEOUT);
+        if (usable && _readers[_slot].state.compare_exchange_strong(word, SlotWord(generation, SLOT_CLAIMED))) {
+            break;
+        }
+    }
+    if (_slot >= _max_readers) {
+        report.error(u"too many readers on shared memory ring %s", {_name});
+        unmap();
+        return false;
+    }
+
+    // Start at the current write position. The writer may move forward while we attach,
+    // the position is set again after activation and the writer clamps late readers.
+    SharedReader& reader(_readers[_slot]);
+    _read_index = _header->write_index.load();
+    reader.pid = uint32_t(::getpid());
+    reader.heartbeat = HeartbeatTime();
+    reader.read_index = _read_index;
+    _slot_word = SlotWord(generation, SLOT_ACTIVE);
+    reader.state = _slot_word;
+    _read_index = _header->write_index.load();
+    reader.read_index = _read_index;
+
+    // Notify a writer which waits for readers.
+    _header->space_seq++;
+    if (_header->writer_waiting.exchange(0) != 0) {
+        WakeValue(_header->space_seq);
+    }
+
+    _lost_packets = 0;
+    _pcr.reset();
+    report.debug(u"attached to shared memory ring %s, slot %d", {_name, _slot});
+    return true;
+#else
+    report.error(u"shared memory rings are not supported on this system");
+    return false;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Close the ring.
+//----------------------------------------------------------------------------
+
+bool ts::SharedMemoryRing::close(Report& report)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+#if defined(TS_UNIX)
+    if (_writer) {
+        // Signal the end of file to readers and delete the segment.
+        // The readers which are attached keep their mapping.
+        _header->eof = 1;
+        _header->data_seq++;
+        WakeValue(_header->data_seq);
+        ::shm_unlink(_name.toUTF8().c_str());
+    }
+    else {
+        // Release the reader slot, unless the writer purged it, and notify the writer which may wait for us.
+        uint32_t word = _slot_word;
+        if (word != 0 && _readers[_slot].state.compare_exchange_strong(word, SlotWord(SlotGeneration(word), SLOT_FREE))) {
+            _header->space_seq++;
+            if (_header->writer_waiting.exchange(0) != 0) {
+                WakeValue(_header->space_seq);
+            }
+        }
+        _slot_word = 0;
+    }
+#endif
+
+    unmap();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the number of attached readers.
+//----------------------------------------------------------------------------
+
+size_t ts::SharedMemoryRing::readerCount() const
+{
+    size_t count = 0;
+    for (size_t i = 0; isOpen() && i < _max_readers; ++i) {
+        if (SlotState(_readers[i].state.load()) == SLOT_ACTIVE) {
+            count++;
+        }
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the read index of the slowest reader.
+//----------------------------------------------------------------------------
+
+uint64_t ts::SharedMemoryRing::slowestReader(uint64_t write_index) const
+{
+    uint64_t index = write_index;
+    for (size_t i = 0; i < _max_readers; ++i) {
+        if (SlotState(_readers[i].state.load()) == SLOT_ACTIVE) {
+            // A reader which attached while we were moving forward may be too far behind.
+            index = std::min(index, std::max(_readers[i].read_index.load(), write_index >= _size ? write_index - _size : 0));
+        }
+    }
+    return index;
+}
+
+
+//----------------------------------------------------------------------------
+// Detach readers of dead processes.
+//----------------------------------------------------------------------------
+
+void ts::SharedMemoryRing::purgeReaders(Report& report)
+{
+#if defined(TS_UNIX)
+    const uint64_t now = HeartbeatTime();
+    for (size_t i = 0; i < _max_readers; ++i) {
+        SharedReader& reader(_readers[i]);
+        uint32_t word = reader.state.load();
+        if (SlotState(word) == SLOT_ACTIVE && ProcessIsDead(reader.pid.load(), reader.heartbeat.load(), now)) {
+            // The slot is not immediately reusable: if the reader is still alive (e.g. in another
+            // PID namespace and stalled), it must see that it no longer owns the slot before a new
+            // reader takes it. The reader checks its slot at least every WAIT_TIMEOUT.
+            reader.heartbeat = now;
+            if (reader.state.compare_exchange_strong(word, SlotWord(SlotGeneration(word), SLOT_PURGED))) {
+                report.verbose(u"reader process %d of shared memory ring %s disappeared", {reader.pid.load(), _name});
+            }
+        }
+    }
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Wait until a minimum number of readers are attached.
+//----------------------------------------------------------------------------
+
+bool ts::SharedMemoryRing::waitReaders(size_t count, Report& report, const AbortInterface* abort)
+{
+    if (!isWriter()) {
+        report.error(u"shared memory ring not open as writer");
+        return false;
+    }
+    while (readerCount() < count) {
+        _header->writer_heartbeat = HeartbeatTime();
+        if (abort != nullptr && abort->aborting()) {
+            return false;
+        }
+        const uint32_t seq = _header->space_seq.load();
+        _header->writer_waiting = 1;
+        if (readerCount() < count) {
+            WaitValue(_header->space_seq, seq, WAIT_TIMEOUT);
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Write packets into the ring.
+//----------------------------------------------------------------------------
+
+bool ts::SharedMemoryRing::write(const TSPacket* buffer, size_t count, BitRate bitrate, Report& report, const AbortInterface* abort)
+{
+    if (!isWriter()) {
+        report.error(u"shared memory ring not open as writer");
+        return false;
+    }
+
+    _header->bitrate = bitrate;
+
+    while (count > 0) {
+        _header->writer_heartbeat = HeartbeatTime();
+
+        // Only this process modifies the write index.
+        const uint64_t windex = _header->write_index.load(std::memory_order_relaxed);
+        const size_t room = _size - size_t(windex - slowestReader(windex));
+
+        if (room == 0) {
+            // The ring is full, wait for the slowest reader.
+            if (abort != nullptr && abort->aborting()) {
+                return false;
+            }
+            const uint32_t seq = _header->space_seq.load();
+            _header->writer_waiting = 1;
+            if (windex - slowestReader(windex) >= _size && !WaitValue(_header->space_seq, seq, WAIT_TIMEOUT)) {
+                // No progress from readers for some time, check if they are still alive.
+                purgeReaders(report);
+            }
+            continue;
+        }
+
+        // Copy packets up to the end of the ring. The end of the write in progress is
+        // published first: a reader which copies the same slots at the same time (after
+        // being purged) checks write_limit after its copy and detects the torn packets.
+        const size_t first = size_t(windex % _size);
+        const size_t n = std::min(std::min(count, room), _size - first);
+        _header->write_limit.store(windex + n);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        TSPacket::Copy(_packets + first, buffer, n);
+        buffer += n;
+        count -= n;
+
+        // Publish the packets and wake up readers if some of them are waiting.
+        _header->write_index.store(windex + n, std::memory_order_release);
+        _header->data_seq++;
+        if (_header->readers_waiting.exchange(0) != 0) {
+            WakeValue(_header->data_seq);
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Read packets from the ring.
+//----------------------------------------------------------------------------
+
+size_t ts::SharedMemoryRing::read(TSPacket* buffer, size_t max_count, Report& report, const AbortInterface* abort)
+{
+    if (!isOpen() || _writer) {
+        report.error(u"shared memory ring not open as reader");
+        return 0;
+    }
+
+    for (;;) {
+        // Check that we still own our slot. The writer may have purged it when we were
+        // considered as dead. Then, we continue without slot, the writer no longer waits for us.
+        if (_slot_word != 0) {
+            if (_readers[_slot].state.load() == _slot_word) {
+                _readers[_slot].heartbeat.store(HeartbeatTime(), std::memory_order_relaxed);
+            }
+            else {
+                report.warning(u"reader slot %d of shared memory ring %s was reclaimed by the writer", {_slot, _name});
+                _slot_word = 0;
+            }
+        }
+
+        const uint64_t windex = _header->write_index.load(std::memory_order_acquire);
+        const uint64_t wlimit = _header->write_limit.load(std::memory_order_acquire);
+
+        if (wlimit - _read_index > _size) {
+            // The writer has overwritten, or is overwriting, packets which were not yet read.
+            // This happens when this reader was considered as dead or attached while the writer
+            // was moving forward. Skip the lost packets, restart at the oldest packet in the ring.
+            const uint64_t lost = wlimit - _size - _read_index;
+            _lost_packets += lost;
+            _read_index = wlimit - _size;
+            report.warning(u"shared memory ring %s overrun, %'d packets lost", {_name, lost});
+        }
+
+        if (windex > _read_index) {
+            // Copy packets up to the end of the ring.
+            const size_t first = size_t(_read_index % _size);
+            const size_t n = std::min(std::min(max_count, size_t(windex - _read_index)), _size - first);
+            TSPacket::Copy(buffer, _packets + first, n);
+
+            // Check that the writer did not overwrite the packets while we copied them.
+            // If it did, the copied packets are dropped and the overrun is reported.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_header->write_limit.load() - _read_index > _size) {
+                continue;
+            }
+            _read_index += n;
+
+            // Release the space and wake up the writer if it is waiting.
+            // Never update a slot which was purged and possibly reassigned to another reader.
+            if (_slot_word != 0 && _readers[_slot].state.load() == _slot_word) {
+                _readers[_slot].read_index.store(_read_index, std::memory_order_release);
+                _header->space_seq++;
+                if (_header->writer_waiting.exchange(0) != 0) {
+                    WakeValue(_header->space_seq);
+                }
+            }
+
+            // When the writer did not specify a bitrate, analyze PCR's.
+            if (_header->bitrate.load() == 0) {
+                for (size_t i = 0; i < n; ++i) {
+                    _pcr.feedPacket(buffer[i]);
+                }
+            }
+            return n;
+        }
+        else if (_header->eof.load() != 0 || (abort != nullptr && abort->aborting())) {
+            return 0;
+        }
+
+        // Nothing to read, wait for the writer.
+        const uint32_t seq = _header->data_seq.load();
+        _header->readers_waiting = 1;
+        if (_header->write_index.load() == _read_index && _header->eof.load() == 0) {
+            WaitValue(_header->data_seq, seq, WAIT_TIMEOUT);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the input bitrate.
+//----------------------------------------------------------------------------
+
+ts::BitRate ts::SharedMemoryRing::bitrate() const
+{
+    if (!isOpen()) {
+        return 0;
+    }
+    else if (_header->bitrate.load() != 0) {
+        return _header->bitrate.load();
+    }
+    else if (_pcr.bitrateIsValid()) {
+        return _pcr.bitrate188();
+    }
+    else {
+        return 0;
+    }
+}
@@ -0,0 +1,233 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream packet ring in shared memory for inter-process communication.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+#include "tsPCRAnalyzer.h"
+#include "tsAbortInterface.h"
+#include "tsReport.h"
+
+namespace ts {
+    //!
+    //! Transport stream packet ring in shared memory for inter-process communication.
+    //! @ingroup system
+    //!
+    //! One writer process creates the ring in a named POSIX shared memory segment
+    //! and writes packets into it. One or more reader processes attach to the ring
+    //! and each of them receives all packets which are written after it attached.
+    //! The writer never overwrites packets which have not yet been read by all
+    //! attached readers: a slow reader slows down the writer. However, when a reader
+    //! is considered as dead, the writer no longer waits for it. If the reader is
+    //! still alive, it detects the overrun, skips the lost packets and reports them.
+    //!
+    //! A process is considered as dead when it did not access the ring for one second
+    //! and its process id no longer exists. The processes may run in distinct PID
+    //! namespaces (containers): an invisible process is still alive while it accesses
+    //! the ring. However, an idle writer or a stalled reader in another PID namespace
+    //! is considered as dead after one second. A reader which was considered as dead
+    //! continues without reader slot and the writer no longer waits for it.
+    //!
+    //! The read and write indexes are lock-free atomic counters in the shared memory.
+    //! On Linux, waiting processes sleep on futexes which are only signaled when a
+    //! process is actually waiting. On other UNIX systems, waiting processes poll.
+    //! Shared memory rings are not supported on Windows.
+    //!
+    //! The input bitrate, if known, is transmitted to the readers. If the writer is
+    //! aware of the exact bitrate, it passes it to write() and the specified value is
+    //! returned to the readers. If the input bitrate is unknown, each reader computes
+    //! it based on PCR's.
+    //!
+    class TSDUCKDLL SharedMemoryRing
+    {
+    public:
+        //!
+        //! Default size in packets of the ring.
+        //!
+        static const size_t DEFAULT_SIZE = 16384;
+
+        //!
+        //! Default maximum number of simultaneous readers.
+        //!
+        static const size_t DEFAULT_MAX_READERS = 8;
+
+        //!
+        //! Constructor.
+        //!
+        SharedMemoryRing();
+
+        //!
+        //! Destructor.
+        //!
+        ~SharedMemoryRing();
+
+        //!
+        //! Create a ring as writer.
+        //! If a ring with the same name exists and its writer process is dead, it is replaced.
+        //! @param [in] name Name of the ring. This is the name of the shared memory segment,
+        //! without leading slash.
+        //! @param [in] size Size of the ring in packets.
+        //! @param [in] max_readers Maximum number of simultaneous readers.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool create(const UString& name, size_t size, size_t max_readers, Report& report);
+
+        //!
+        //! Attach to an existing ring as reader.
+        //! The reader receives the packets which are written after this call.
+        //! @param [in] name Name of the ring.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool open(const UString& name, Report& report);
+
+        //!
+        //! Close the ring.
+        //! When the writer closes the ring, the readers get an end of file after
+        //! reading the remaining packets and the shared memory segment is deleted.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool close(Report& report);
+
+        //!
+        //! Check if the ring is open.
+        //! @return True if the ring is open.
+        //!
+        bool isOpen() const { return _memory != nullptr; }
+
+        //!
+        //! Check if the ring is open as writer.
+        //! @return True if the ring is open as writer.
+        //!
+        bool isWriter() const { return _memory != nullptr && _writer; }
+
+        //!
+        //! Get the number of attached readers.
+        //! @return The number of attached readers.
+        //!
+        size_t readerCount() const;
+
+        //!
+        //! Wait until a minimum number of readers are attached (writer only).
+        //! @param [in] count Minimum number of readers.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] abort If non-zero, invoked when waiting to check for abort.
+        //! @return True when the readers are attached, false on error or abort.
+        //!
+        bool waitReaders(size_t count, Report& report, const AbortInterface* abort = nullptr);
+
+        //!
+        //! Write packets into the ring (writer only).
+        //! Wait for free space when the slowest reader is late.
+        //! @param [in] buffer Address of packets to write.
+        //! @param [in] count Number of packets to write.
+        //! @param [in] bitrate Current bitrate or zero if unknown.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] abort If non-zero, invoked when waiting to check for abort.
+        //! @return True on success, false on error or abort.
+        //!
+        bool write(const TSPacket* buffer, size_t count, BitRate bitrate, Report& report, const AbortInterface* abort = nullptr);
+
+        //!
+        //! Read packets from the ring (reader only).
+        //! Wait until at least one packet is available. If the writer has overwritten
+        //! packets which were not yet read, they are skipped, a warning is reported
+        //! and the number of lost packets is accumulated in lostPackets().
+        //! @param [out] buffer Address of the buffer for packets.
+        //! @param [in] max_count Size of @a buffer in number of packets.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] abort If non-zero, invoked when waiting to check for abort.
+        //! @return The number of read packets, zero on end of file, error or abort.
+        //!
+        size_t read(TSPacket* buffer, size_t max_count, Report& report, const AbortInterface* abort = nullptr);
+
+        //!
+        //! Get the number of packets which were lost by this reader (reader only).
+        //! @return The number of packets which were overwritten by the writer before being read.
+        //!
+        PacketCounter lostPackets() const { return _lost_packets; }
+
+        //!
+        //! Get the input bitrate (reader only).
+        //! @return The bitrate which was reported by the writer or, if unknown,
+        //! the bitrate computed from the PCR's or zero if unknown.
+        //!
+        BitRate bitrate() const;
+
+    private:
+        struct SharedHeader;
+        struct SharedReader;
+
+        UString       _name;         // Shared memory segment name.
+        bool          _writer;       // Open as writer.
+        int           _fd;           // Shared memory file descriptor.
+        void*         _memory;       // Mapped shared memory.
+        size_t        _memory_size;  // Size of mapped shared memory.
+        SharedHeader* _header;       // Header of the ring in shared memory.
+        SharedReader* _readers;      // Reader slots in shared memory.
+        TSPacket*     _packets;      // Packet ring in shared memory.
+        size_t        _size;         // Ring size in packets.
+        size_t        _max_readers;  // Number of reader slots.
+        size_t        _slot;         // Reader slot of this reader.
+        uint32_t      _slot_word;    // State word of our slot while we own it, zero otherwise.
+        uint64_t      _read_index;   // Total number of packets read by this reader.
+        PacketCounter _lost_packets; // Total number of packets lost by this reader.
+        PCRAnalyzer   _pcr;          // Bitrate analysis when the writer does not know it.
+
+        // Build the system name of a shared memory segment.
+        static UString SystemName(const UString& name);
+
+#if defined(TS_UNIX)
+        // Get the writer process and heartbeat of an existing segment, zero if unknown.
+        static pid_t WriterProcess(const std::string& sname, uint64_t& heartbeat);
+#endif
+
+        // Map the shared memory segment, compute the addresses of the ring.
+        bool map(size_t size, Report& report);
+
+        // Unmap the shared memory segment.
+        void unmap();
+
+        // Get the read index of the slowest reader (writer only).
+        uint64_t slowestReader(uint64_t write_index) const;
+
+        // Detach readers of dead processes (writer only).
+        void purgeReaders(Report& report);
+
+        // Inaccessible operations.
+        SharedMemoryRing(const SharedMemoryRing&) = delete;
+        SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+    };
+}
@@ -90,6 +90,17 @@ void ts::T2MIDemux::immediateResetPID(PID pid)
     _pids.erase(pid);
 }
 
+void ts::T2MIDemux::syncLost()
+{
+    SuperClass::syncLost();
+    _psi_demux.syncLost();
+    for (auto it = _pids.begin(); it != _pids.end(); ++it) {
+        if (!it->second.isNull()) {
+            it->second->lostSync();
+        }
+    }
+}
+
 
 //----------------------------------------------------------------------------
 // Feed the demux with a TS packet.
@@ -75,6 +75,7 @@ namespace ts {
 
         // Inherited methods from AbstractDemux.
         virtual void feedPacket(const TSPacket& pkt) override;
+        virtual void syncLost() override;
 
         //!
         //! Replace the T2-MI handler.
@@ -172,6 +172,32 @@ bool ts::TCPSocket::setNoDelay(bool active, Report& report)
 }
 
 
+//----------------------------------------------------------------------------
+// Set the "cork" option.
+//----------------------------------------------------------------------------
+
+bool ts::TCPSocket::setCork(bool active, Report& report)
+{
+#if defined(TCP_CORK) || defined(TCP_NOPUSH)
+    int cork = int(active); // Actual socket option is an int.
+    report.debug(u"setting socket cork to %'d", {cork});
+#if defined(TCP_CORK)
+    const int opt = TCP_CORK;
+#else
+    const int opt = TCP_NOPUSH;
+#endif
+    if (::setsockopt(getSocket(), IPPROTO_TCP, opt, TS_SOCKOPT_T(&cork), sizeof(cork)) != 0) {
+        report.error(u"error setting socket TCP-cork: %s", {SocketErrorCodeMessage()});
+        return false;
+    }
+    return true;
+#else
+    report.error(u"TCP cork option not supported on this system");
+    return false;
+#endif
+}
+
+
 //----------------------------------------------------------------------------
 // Bind to a local address and port.
 //----------------------------------------------------------------------------
@@ -114,6 +114,17 @@ namespace ts {
         //!
         bool setNoDelay(bool active, Report& report = CERR);
 
+        //!
+        //! Set the "cork" option.
+        //! @param [in] active If true, the socket sends only full segments. Partial
+        //! segments are delayed until the option is removed or for a system-defined
+        //! maximum time (200 ms on Linux). This is the TCP_CORK option on Linux and
+        //! TCP_NOPUSH on BSD systems. This option is not supported on Windows.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //!
+        bool setCork(bool active, Report& report = CERR);
+
         //!
         //! Bind to a local address and port.
         //!
@@ -0,0 +1,923 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTR101290Analyzer.h"
+#include "tsTR101290HandlerInterface.h"
+#include "tsBinaryTable.h"
+#include "tsCADescriptor.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsCAT.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::NanoSecond ts::TR101290Analyzer::DEFAULT_HOLD_TIME;
+const ts::NanoSecond ts::TR101290Analyzer::DEFAULT_PID_TIMEOUT;
+#endif
+
+const ts::Enumeration ts::TR101290Analyzer::IndicatorNames({
+    {u"TS_sync_loss",                      ts::TR101290Analyzer::TS_SYNC_LOSS},
+    {u"Sync_byte_error",                   ts::TR101290Analyzer::SYNC_BYTE_ERROR},
+    {u"PAT_error",                         ts::TR101290Analyzer::PAT_ERROR},
+    {u"Continuity_count_error",            ts::TR101290Analyzer::CONTINUITY_COUNT_ERROR},
+    {u"PMT_error",                         ts::TR101290Analyzer::PMT_ERROR},
+    {u"PID_error",                         ts::TR101290Analyzer::PID_ERROR},
+    {u"Transport_error",                   ts::TR101290Analyzer::TRANSPORT_ERROR},
+    {u"CRC_error",                         ts::TR101290Analyzer::CRC_ERROR},
+    {u"PCR_repetition_error",              ts::TR101290Analyzer::PCR_REPETITION_ERROR},
+    {u"PCR_discontinuity_indicator_error", ts::TR101290Analyzer::PCR_DISCONTINUITY_ERROR},
+    {u"PCR_accuracy_error",                ts::TR101290Analyzer::PCR_ACCURACY_ERROR},
+    {u"PTS_error",                         ts::TR101290Analyzer::PTS_ERROR},
+    {u"CAT_error",                         ts::TR101290Analyzer::CAT_ERROR},
+    {u"NIT_error",                         ts::TR101290Analyzer::NIT_ERROR},
+    {u"SI_repetition_error",               ts::TR101290Analyzer::SI_REPETITION_ERROR},
+    {u"Unreferenced_PID",                  ts::TR101290Analyzer::UNREFERENCED_PID},
+    {u"SDT_error",                         ts::TR101290Analyzer::SDT_ERROR},
+    {u"EIT_error",                         ts::TR101290Analyzer::EIT_ERROR},
+    {u"RST_error",                         ts::TR101290Analyzer::RST_ERROR},
+    {u"TDT_error",                         ts::TR101290Analyzer::TDT_ERROR},
+});
+
+// Time limits from ETSI TR 101 290, section 5.2.
+namespace {
+    const ts::NanoSecond TICK_PERIOD       =  10 * ts::NanoSecPerMilliSec;  // Evaluation of timers.
+    const ts::NanoSecond PAT_PERIOD        = 500 * ts::NanoSecPerMilliSec;
+    const ts::NanoSecond PMT_PERIOD        = 500 * ts::NanoSecPerMilliSec;
+    const ts::NanoSecond PCR_PERIOD        =  40 * ts::NanoSecPerMilliSec;
+    const ts::NanoSecond PTS_PERIOD        = 700 * ts::NanoSecPerMilliSec;
+    const ts::NanoSecond UNREF_DELAY       = 500 * ts::NanoSecPerMilliSec;
+    const ts::NanoSecond SECTION_MIN_GAP   =  25 * ts::NanoSecPerMilliSec;
+    const ts::NanoSecond NIT_PERIOD        =  10 * ts::NanoSecPerSec;
+    const ts::NanoSecond SDT_PERIOD        =   2 * ts::NanoSecPerSec;
+    const ts::NanoSecond EIT_PERIOD        =   2 * ts::NanoSecPerSec;
+    const ts::NanoSecond TDT_PERIOD        =  30 * ts::NanoSecPerSec;
+    const ts::NanoSecond BAT_PERIOD        =  10 * ts::NanoSecPerSec;
+    const ts::NanoSecond TOT_PERIOD        =  30 * ts::NanoSecPerSec;
+    const uint64_t       PCR_MAX_INTERVAL  =  40 * (ts::SYSTEM_CLOCK_FREQ / 1000);  // In PCR units.
+    const uint64_t       PCR_MAX_JUMP      = 100 * (ts::SYSTEM_CLOCK_FREQ / 1000);  // In PCR units.
+    const double         PCR_MAX_ERROR     = 13.5;                                   // 500 ns in PCR units.
+
+    // Details of section errors, built only when an error is raised.
+    ts::UString BadTableId(ts::TID tid)
+    {
+        return ts::UString::Format(u"unexpected table id 0x%X", {tid});
+    }
+    ts::UString TooClose(ts::TID tid)
+    {
+        return ts::UString::Format(u"sections of table id 0x%X less than 25 ms apart", {tid});
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::TR101290Analyzer::Event::Event() :
+    indicator(INDICATOR_COUNT),
+    raised(false),
+    timestamp(0),
+    pid(PID_MAX),
+    service_id(0),
+    has_service(false),
+    details()
+{
+}
+
+ts::TR101290Analyzer::PIDState::PIDState() :
+    seen(false),
+    monitored(false),
+    referenced(false),
+    is_pmt(false),
+    pmt_seen(false),
+    check_pts(false),
+    has_service(false),
+    unref_done(false),
+    cc_valid(false),
+    cc(0),
+    dup_count(0),
+    service_id(0),
+    first_seen(0),
+    pcr_valid(false),
+    pcr(0),
+    pcr_index(0),
+    pcr_base(0),
+    pcr_base_index(0),
+    pmt_timer(),
+    pid_timer(),
+    pcr_timer(),
+    pts_timer()
+{
+}
+
+ts::TR101290Analyzer::TR101290Analyzer(TR101290HandlerInterface* handler) :
+    _handler(handler),
+    _pid_timeout(DEFAULT_PID_TIMEOUT),
+    _hold_time(DEFAULT_HOLD_TIME),
+    _enabled(),
+    _error_count(),
+    _packet_count(0),
+    _started(false),
+    _now(0),
+    _next_tick(0),
+    _bad_sync(0),
+    _good_sync(0),
+    _sync_lost(false),
+    _pat_seen(false),
+    _cat_seen(false),
+    _pmt_pending(0),
+    _psi_time(0),
+    _wrong_crc(0),
+    _demux(this, this),
+    _pat_timer(),
+    _nit_timer(),
+    _sdt_timer(),
+    _eit_timer(),
+    _tdt_timer(),
+    _bat_timer(),
+    _tot_timer(),
+    _last_section0(),
+    _monitored(),
+    _alarms(),
+    _pids()
+{
+    for (size_t i = 0; i < INDICATOR_COUNT; ++i) {
+        _enabled[i] = true;
+    }
+    reset();
+}
+
+ts::TR101290Analyzer::~TR101290Analyzer()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Get the priority of an indicator.
+//----------------------------------------------------------------------------
+
+int ts::TR101290Analyzer::Priority(Indicator indicator)
+{
+    if (indicator <= PID_ERROR) {
+        return 1;
+    }
+    else if (indicator <= CAT_ERROR) {
+        return 2;
+    }
+    else {
+        return 3;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check if a timer expired. Move the deadline to the next period.
+//----------------------------------------------------------------------------
+
+bool ts::TR101290Analyzer::Timer::fire(NanoSecond now)
+{
+    if (!armed || now < deadline) {
+        return false;
+    }
+    fired = true;
+    while (deadline <= now) {
+        deadline += period;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the analysis context.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::reset()
+{
+    for (size_t i = 0; i < INDICATOR_COUNT; ++i) {
+        _error_count[i] = 0;
+    }
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        _pids[pid] = PIDState();
+    }
+    _packet_count = 0;
+    _started = false;
+    _now = _next_tick = 0;
+    _bad_sync = _good_sync = 0;
+    _sync_lost = false;
+    _pat_seen = _cat_seen = false;
+    _pmt_pending = 0;
+    _psi_time = 0;
+    _wrong_crc = 0;
+    _pat_timer.disarm();
+    _nit_timer.disarm();
+    _sdt_timer.disarm();
+    _eit_timer.disarm();
+    _tdt_timer.disarm();
+    _bat_timer.disarm();
+    _tot_timer.disarm();
+    _last_section0.clear();
+    _monitored.clear();
+    _alarms.clear();
+
+    // Demux all PSI/SI PID's which are checked by TR 101 290. PMT PID's are added later.
+    _demux.reset();
+    _demux.setPIDFilter(NoPID);
+    _demux.addPID(PID_PAT);
+    _demux.addPID(PID_CAT);
+    for (PID pid = PID_NIT; pid <= PID_TDT; ++pid) {
+        _demux.addPID(pid);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check if there is at least one active alarm for an indicator.
+//----------------------------------------------------------------------------
+
+bool ts::TR101290Analyzer::isActive(Indicator indicator) const
+{
+    for (auto it = _alarms.begin(); it != _alarms.end(); ++it) {
+        if (it->indicator == indicator) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze a TS packet.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::feedPacket(const TSPacket& pkt, NanoSecond timestamp)
+{
+    _now = timestamp;
+    _packet_count++;
+
+    // Mandatory tables are expected from the beginning of the stream.
+    if (!_started) {
+        _started = true;
+        _next_tick = _now + TICK_PERIOD;
+        _pat_timer.arm(_now, PAT_PERIOD);
+        _nit_timer.arm(_now, NIT_PERIOD);
+        _sdt_timer.arm(_now, SDT_PERIOD);
+        _eit_timer.arm(_now, EIT_PERIOD);
+        _tdt_timer.arm(_now, TDT_PERIOD);
+    }
+
+    if (!pkt.hasValidSync()) {
+        // Two consecutive corrupted sync bytes mean a loss of synchronization.
+        _good_sync = 0;
+        raise(SYNC_BYTE_ERROR, PID_MAX, false, UString::Format(u"sync byte 0x%X", {pkt.b[0]}));
+        if (++_bad_sync >= 2 && !_sync_lost) {
+            _sync_lost = true;
+            raise(TS_SYNC_LOSS, PID_MAX, true);
+        }
+    }
+    else {
+        // Five consecutive correct sync bytes mean that the synchronization is recovered.
+        _bad_sync = 0;
+        if (_sync_lost && ++_good_sync >= 5) {
+            _sync_lost = false;
+            _good_sync = 0;
+            resolve(TS_SYNC_LOSS, PID_MAX);
+            // Continuity and PCR contexts are meaningless across a sync loss.
+            for (PID pid = 0; pid < PID_MAX; ++pid) {
+                _pids[pid].cc_valid = _pids[pid].pcr_valid = false;
+            }
+        }
+
+        const PID pid = pkt.getPID();
+        PIDState& ps(_pids[pid]);
+
+        if (!_sync_lost && pkt.getTEI()) {
+            // Do not analyze the content of a corrupted packet.
+            raise(TRANSPORT_ERROR, pid, false);
+        }
+        else if (!_sync_lost) {
+            if (!ps.seen) {
+                ps.seen = true;
+                ps.first_seen = _now;
+                if (pid >= 0x20 && pid != PID_NULL && !ps.referenced) {
+                    monitor(pid);
+                }
+            }
+
+            // Re-arm PID_error timer on referenced PID's.
+            if (ps.pid_timer.armed) {
+                if (ps.pid_timer.fired) {
+                    resolve(PID_ERROR, pid);
+                }
+                ps.pid_timer.arm(_now, _pid_timeout);
+            }
+
+            checkContinuity(ps, pkt);
+
+            if (pkt.isScrambled()) {
+                if (pid == PID_PAT) {
+                    raise(PAT_ERROR, pid, false, u"scrambled PAT packet");
+                }
+                else if (ps.is_pmt) {
+                    raise(PMT_ERROR, pid, false, u"scrambled PMT packet");
+                }
+                if (!_cat_seen && !refresh(CAT_ERROR, PID_CAT)) {
+                    raise(CAT_ERROR, PID_CAT, false, UString::Format(u"scrambled packet on PID 0x%X (%d) without CAT", {pid, pid}));
+                }
+                // PTS are not visible in scrambled streams.
+                ps.pts_timer.disarm();
+            }
+            else if (ps.check_pts && pkt.getPUSI() && pkt.hasPTS()) {
+                if (ps.pts_timer.fired) {
+                    resolve(PTS_ERROR, pid);
+                }
+                ps.pts_timer.arm(_now, PTS_PERIOD);
+            }
+
+            if (pkt.hasPCR()) {
+                checkPCR(ps, pkt);
+            }
+
+            // Analyze PSI/SI, detect CRC errors.
+            if (_demux.hasPID(pid)) {
+                _demux.feedPacket(pkt);
+                SectionDemux::Status status;
+                _demux.getStatus(status);
+                if (status.wrong_crc > _wrong_crc) {
+                    _wrong_crc = status.wrong_crc;
+                    raise(CRC_ERROR, pid, false);
+                }
+            }
+        }
+    }
+
+    if (_now >= _next_tick) {
+        tick();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check continuity counters.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::checkContinuity(PIDState& ps, const TSPacket& pkt)
+{
+    const uint8_t cc = pkt.getCC();
+
+    if (pkt.getPID() == PID_NULL) {
+        // Continuity counters of null packets are undefined.
+    }
+    else if (!ps.cc_valid || pkt.getDiscontinuityIndicator()) {
+        // First packet or declared discontinuity.
+        ps.cc_valid = true;
+        ps.cc = cc;
+        ps.dup_count = 0;
+    }
+    else if (pkt.hasPayload()) {
+        // The counter is incremented only in packets with payload. One duplicate packet is allowed.
+        if (cc == ps.cc) {
+            if (++ps.dup_count > 1) {
+                raise(CONTINUITY_COUNT_ERROR, pkt.getPID(), false, u"packet occurs more than twice");
+            }
+        }
+        else {
+            if (cc != ((ps.cc + 1) & CC_MASK)) {
+                raise(CONTINUITY_COUNT_ERROR, pkt.getPID(), false, UString::Format(u"expected CC %d, got %d", {(ps.cc + 1) & CC_MASK, cc}));
+            }
+            ps.dup_count = 0;
+        }
+        ps.cc = cc;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check PCR's.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::checkPCR(PIDState& ps, const TSPacket& pkt)
+{
+    const PID pid = pkt.getPID();
+    const uint64_t pcr = pkt.getPCR();
+
+    if (ps.pcr_timer.fired) {
+        // Already reported by the timer.
+        resolve(PCR_REPETITION_ERROR, pid);
+    }
+    else if (ps.pcr_valid) {
+        const uint64_t interval = (pcr + PCR_SCALE - ps.pcr) % PCR_SCALE;
+        if (interval > PCR_MAX_INTERVAL && !pkt.getDiscontinuityIndicator()) {
+            raise(PCR_REPETITION_ERROR, pid, false, UString::Format(u"PCR interval %'d ms", {interval / (SYSTEM_CLOCK_FREQ / 1000)}));
+        }
+    }
+    ps.pcr_timer.arm(_now, PCR_PERIOD);
+    monitor(pid);
+
+    if (ps.pcr_valid && !pkt.getDiscontinuityIndicator()) {
+        const uint64_t interval = (pcr + PCR_SCALE - ps.pcr) % PCR_SCALE;
+        if (interval > PCR_MAX_JUMP) {
+            // Backward jumps are seen as very large intervals modulo PCR_SCALE.
+            raise(PCR_DISCONTINUITY_ERROR, pid, false, UString::Format(u"PCR 0x%X after 0x%X", {pcr, ps.pcr}));
+            ps.pcr_valid = false;
+        }
+        else if (ps.pcr_index > ps.pcr_base_index) {
+            // Compare the PCR with the value which is extrapolated from the previous PCR's, at constant bitrate.
+            const double rate = double((ps.pcr + PCR_SCALE - ps.pcr_base) % PCR_SCALE) / double(ps.pcr_index - ps.pcr_base_index);
+            const double expected = rate * double(_packet_count - ps.pcr_base_index);
+            const double actual = double((pcr + PCR_SCALE - ps.pcr_base) % PCR_SCALE);
+            const double error = actual > expected ? actual - expected : expected - actual;
+            if (error > PCR_MAX_ERROR) {
+                raise(PCR_ACCURACY_ERROR, pid, false, UString::Format(u"PCR inaccuracy %'d ns", {int64_t(error * 1000 / (SYSTEM_CLOCK_FREQ / 1000000))}));
+                // Restart from this PCR to avoid reporting the same drift again.
+                ps.pcr_valid = false;
+            }
+        }
+    }
+    else {
+        ps.pcr_valid = false;
+    }
+
+    if (!ps.pcr_valid) {
+        ps.pcr_valid = true;
+        ps.pcr_base = pcr;
+        ps.pcr_base_index = _packet_count;
+    }
+    ps.pcr = pcr;
+    ps.pcr_index = _packet_count;
+}
+
+
+//----------------------------------------------------------------------------
+// Evaluate the timers at a given time, without packet.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::checkTimers(NanoSecond timestamp)
+{
+    if (_started && timestamp >= _now) {
+        _now = timestamp;
+        tick();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check the timers and the hold time of alarms.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::tick()
+{
+    _next_tick = _now + TICK_PERIOD;
+
+    // Mandatory and repeated tables.
+    if (_pat_timer.fire(_now)) {
+        raise(PAT_ERROR, PID_PAT, true, u"no PAT for more than 500 ms");
+    }
+    if (_nit_timer.fire(_now)) {
+        raise(NIT_ERROR, PID_NIT, true, u"no NIT actual for more than 10 s");
+    }
+    if (_sdt_timer.fire(_now)) {
+        raise(SDT_ERROR, PID_SDT, true, u"no SDT actual for more than 2 s");
+    }
+    if (_eit_timer.fire(_now)) {
+        raise(EIT_ERROR, PID_EIT, true, u"no EIT present/following actual for more than 2 s");
+    }
+    if (_tdt_timer.fire(_now)) {
+        raise(TDT_ERROR, PID_TDT, true, u"no TDT for more than 30 s");
+    }
+    if (_bat_timer.fire(_now)) {
+        raise(SI_REPETITION_ERROR, PID_BAT, true, u"no BAT for more than 10 s");
+    }
+    if (_tot_timer.fire(_now)) {
+        raise(SI_REPETITION_ERROR, PID_TOT, true, u"no TOT for more than 30 s");
+    }
+
+    // Timers on individual PID's.
+    const bool psi_complete = _pat_seen && _pmt_pending == 0;
+    for (auto it = _monitored.begin(); it != _monitored.end(); ++it) {
+        const PID pid = *it;
+        PIDState& ps(_pids[pid]);
+        if (ps.pmt_timer.fire(_now)) {
+            raise(PMT_ERROR, pid, true, u"no PMT for more than 500 ms");
+        }
+        if (ps.pid_timer.fire(_now)) {
+            raise(PID_ERROR, pid, true, UString::Format(u"no packet for more than %'d ms", {_pid_timeout / NanoSecPerMilliSec}));
+        }
+        if (ps.pcr_timer.fire(_now)) {
+            raise(PCR_REPETITION_ERROR, pid, true, u"no PCR for more than 40 ms");
+        }
+        if (ps.pts_timer.fire(_now)) {
+            raise(PTS_ERROR, pid, true, u"no PTS for more than 700 ms");
+        }
+        // A PID must be referenced within 0.5 s after all PMT's are known.
+        if (psi_complete && ps.seen && !ps.referenced && !ps.unref_done && _now - std::max(ps.first_seen, _psi_time) >= UNREF_DELAY) {
+            ps.unref_done = true;
+            raise(UNREFERENCED_PID, pid, true);
+        }
+    }
+
+    // Clear event-type alarms after the hold time.
+    for (auto it = _alarms.begin(); it != _alarms.end(); ) {
+        if (!it->persistent && _now - it->last_error >= _hold_time) {
+            const Indicator indicator = it->indicator;
+            const PID pid = it->pid;
+            it = _alarms.erase(it);
+            notify(indicator, pid, false, UString());
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Add a PID in the list of monitored PID's.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::monitor(PID pid)
+{
+    if (!_pids[pid].monitored) {
+        _pids[pid].monitored = true;
+        _monitored.push_back(pid);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Mark a PID as referenced.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::reference(PID pid, int service_id)
+{
+    if (pid < PID_MAX) {
+        PIDState& ps(_pids[pid]);
+        ps.referenced = true;
+        if (service_id >= 0) {
+            ps.service_id = uint16_t(service_id);
+            ps.has_service = true;
+        }
+        if (ps.unref_done) {
+            ps.unref_done = false;
+            resolve(UNREFERENCED_PID, pid);
+        }
+    }
+}
+
+void ts::TR101290Analyzer::referenceCA(const DescriptorList& descs, int service_id)
+{
+    for (size_t index = descs.search(DID_CA); index < descs.count(); index = descs.search(DID_CA, index + 1)) {
+        const CADescriptor ca(*descs[index]);
+        if (ca.isValid()) {
+            reference(ca.ca_pid, service_id);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check the minimum interval between two sections #0 of a table.
+//----------------------------------------------------------------------------
+
+bool ts::TR101290Analyzer::checkMinInterval(const Section& section)
+{
+    if (section.sectionNumber() != 0) {
+        return true;
+    }
+    const uint32_t key = (uint32_t(section.tableId()) << 16) | section.tableIdExtension();
+    const auto it = _last_section0.find(key);
+    const bool ok = it == _last_section0.end() || _now - it->second >= SECTION_MIN_GAP;
+    _last_section0[key] = _now;
+    return ok;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux for each section: check table ids and repetition.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::handleSection(SectionDemux& demux, const Section& section)
+{
+    const PID pid = section.sourcePID();
+    const TID tid = section.tableId();
+
+    switch (pid) {
+        case PID_PAT: {
+            if (tid != TID_PAT) {
+                raise(PAT_ERROR, pid, false, BadTableId(tid));
+            }
+            else {
+                if (_pat_timer.fired) {
+                    resolve(PAT_ERROR, pid);
+                }
+                _pat_timer.arm(_now, PAT_PERIOD);
+            }
+            break;
+        }
+        case PID_CAT: {
+            if (tid != TID_CAT) {
+                raise(CAT_ERROR, pid, false, BadTableId(tid));
+            }
+            break;
+        }
+        case PID_NIT: {
+            if (tid != TID_NIT_ACT && tid != TID_NIT_OTH && tid != TID_ST) {
+                raise(NIT_ERROR, pid, false, BadTableId(tid));
+            }
+            else if (tid == TID_NIT_ACT) {
+                if (!checkMinInterval(section)) {
+                    raise(NIT_ERROR, pid, false, TooClose(tid));
+                }
+                if (_nit_timer.fired) {
+                    resolve(NIT_ERROR, pid);
+                }
+                _nit_timer.arm(_now, NIT_PERIOD);
+            }
+            break;
+        }
+        case PID_SDT: {
+            if (tid != TID_SDT_ACT && tid != TID_SDT_OTH && tid != TID_BAT && tid != TID_ST) {
+                raise(SDT_ERROR, pid, false, BadTableId(tid));
+            }
+            else if (tid == TID_SDT_ACT) {
+                if (!checkMinInterval(section)) {
+                    raise(SDT_ERROR, pid, false, TooClose(tid));
+                }
+                if (_sdt_timer.fired) {
+                    resolve(SDT_ERROR, pid);
+                }
+                _sdt_timer.arm(_now, SDT_PERIOD);
+            }
+            else if (tid == TID_BAT) {
+                if (!checkMinInterval(section)) {
+                    raise(SI_REPETITION_ERROR, pid, false, TooClose(tid));
+                }
+                if (_bat_timer.fired) {
+                    resolve(SI_REPETITION_ERROR, pid);
+                }
+                _bat_timer.arm(_now, BAT_PERIOD);
+            }
+            break;
+        }
+        case PID_EIT: {
+            if ((tid < TID_EIT_MIN || tid > TID_EIT_MAX) && tid != TID_ST) {
+                raise(EIT_ERROR, pid, false, BadTableId(tid));
+            }
+            else if (tid == TID_EIT_PF_ACT) {
+                if (!checkMinInterval(section)) {
+                    raise(EIT_ERROR, pid, false, TooClose(tid));
+                }
+                if (_eit_timer.fired) {
+                    resolve(EIT_ERROR, pid);
+                }
+                _eit_timer.arm(_now, EIT_PERIOD);
+            }
+            break;
+        }
+        case PID_RST: {
+            if (tid != TID_RST && tid != TID_ST) {
+                raise(RST_ERROR, pid, false, BadTableId(tid));
+            }
+            else if (tid == TID_RST && !checkMinInterval(section)) {
+                raise(RST_ERROR, pid, false, TooClose(tid));
+            }
+            break;
+        }
+        case PID_TDT: {
+            if (tid != TID_TDT && tid != TID_TOT && tid != TID_ST) {
+                raise(TDT_ERROR, pid, false, BadTableId(tid));
+            }
+            else if (tid == TID_TDT) {
+                if (!checkMinInterval(section)) {
+                    raise(TDT_ERROR, pid, false, TooClose(tid));
+                }
+                if (_tdt_timer.fired) {
+                    resolve(TDT_ERROR, pid);
+                }
+                _tdt_timer.arm(_now, TDT_PERIOD);
+            }
+            else if (tid == TID_TOT) {
+                if (!checkMinInterval(section)) {
+                    raise(SI_REPETITION_ERROR, pid, false, TooClose(tid));
+                }
+                if (_tot_timer.fired) {
+                    resolve(SI_REPETITION_ERROR, pid);
+                }
+                _tot_timer.arm(_now, TOT_PERIOD);
+            }
+            break;
+        }
+        default: {
+            PIDState& ps(_pids[pid]);
+            if (ps.is_pmt && tid == TID_PMT) {
+                if (ps.pmt_timer.fired) {
+                    resolve(PMT_ERROR, pid);
+                }
+                ps.pmt_timer.arm(_now, PMT_PERIOD);
+            }
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux for each new table: collect PID references.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    switch (table.tableId()) {
+        case TID_PAT: {
+            const PAT pat(table);
+            if (pat.isValid() && table.sourcePID() == PID_PAT) {
+                _pat_seen = true;
+                // Forget PMT PID's which are no longer in the PAT.
+                for (auto it = _monitored.begin(); it != _monitored.end(); ++it) {
+                    PIDState& ps(_pids[*it]);
+                    if (ps.is_pmt) {
+                        bool found = false;
+                        for (auto it2 = pat.pmts.begin(); !found && it2 != pat.pmts.end(); ++it2) {
+                            found = it2->second == *it;
+                        }
+                        if (!found) {
+                            ps.is_pmt = false;
+                            ps.pmt_timer.disarm();
+                            resolve(PMT_ERROR, *it);
+                            _demux.removePID(*it);
+                            if (!ps.pmt_seen) {
+                                _pmt_pending--;
+                            }
+                        }
+                    }
+                }
+                // Start monitoring new PMT PID's.
+                for (auto it = pat.pmts.begin(); it != pat.pmts.end(); ++it) {
+                    const PID pmt_pid = it->second;
+                    PIDState& ps(_pids[pmt_pid]);
+                    if (!ps.is_pmt) {
+                        ps.is_pmt = true;
+                        ps.pmt_seen = false;
+                        _pmt_pending++;
+                        ps.pmt_timer.arm(_now, PMT_PERIOD);
+                        _demux.addPID(pmt_pid);
+                        monitor(pmt_pid);
+                    }
+                    reference(pmt_pid, it->first);
+                }
+                if (_pmt_pending == 0) {
+                    _psi_time = _now;
+                }
+            }
+            break;
+        }
+        case TID_CAT: {
+            const CAT cat(table);
+            if (cat.isValid() && table.sourcePID() == PID_CAT) {
+                _cat_seen = true;
+                resolve(CAT_ERROR, PID_CAT);
+                referenceCA(cat.descs, -1);
+            }
+            break;
+        }
+        case TID_PMT: {
+            const PMT pmt(table);
+            PIDState& pmt_ps(_pids[table.sourcePID()]);
+            if (!pmt.isValid() || !pmt_ps.is_pmt) {
+                break;
+            }
+            if (!pmt_ps.pmt_seen) {
+                pmt_ps.pmt_seen = true;
+                if (--_pmt_pending == 0) {
+                    _psi_time = _now;
+                }
+            }
+            // Stop monitoring components which were removed from the service.
+            for (auto it = _monitored.begin(); it != _monitored.end(); ++it) {
+                PIDState& ps(_pids[*it]);
+                if (ps.has_service && ps.service_id == pmt.service_id && !ps.is_pmt && pmt.streams.find(*it) == pmt.streams.end()) {
+                    ps.pid_timer.disarm();
+                    ps.pts_timer.disarm();
+                    resolve(PID_ERROR, *it);
+                    resolve(PTS_ERROR, *it);
+                }
+            }
+            // Monitor all components of the service.
+            for (auto it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
+                const PID pid = it->first;
+                PIDState& ps(_pids[pid]);
+                reference(pid, pmt.service_id);
+                if (!ps.pid_timer.armed) {
+                    ps.pid_timer.arm(_now, _pid_timeout);
+                }
+                ps.check_pts = IsVideoST(it->second.stream_type) || IsAudioST(it->second.stream_type);
+                if (ps.check_pts && !ps.pts_timer.armed) {
+                    ps.pts_timer.arm(_now, PTS_PERIOD);
+                }
+                monitor(pid);
+                referenceCA(it->second.descs, pmt.service_id);
+            }
+            if (pmt.pcr_pid != PID_NULL) {
+                reference(pmt.pcr_pid, pmt.service_id);
+                if (!_pids[pmt.pcr_pid].pcr_timer.armed) {
+                    _pids[pmt.pcr_pid].pcr_timer.arm(_now, PCR_PERIOD);
+                }
+                monitor(pmt.pcr_pid);
+            }
+            referenceCA(pmt.descs, pmt.service_id);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Alarm management.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Analyzer::raise(Indicator indicator, PID pid, bool persistent, const UString& details)
+{
+    if (!_enabled[indicator]) {
+        return;
+    }
+    _error_count[indicator]++;
+    for (auto it = _alarms.begin(); it != _alarms.end(); ++it) {
+        if (it->indicator == indicator && it->pid == pid) {
+            it->last_error = _now;
+            it->persistent = it->persistent || persistent;
+            return;
+        }
+    }
+    const Alarm alarm = {indicator, pid, _now, persistent};
+    _alarms.push_back(alarm);
+    notify(indicator, pid, true, details);
+}
+
+bool ts::TR101290Analyzer::refresh(Indicator indicator, PID pid)
+{
+    for (auto it = _alarms.begin(); it != _alarms.end(); ++it) {
+        if (it->indicator == indicator && it->pid == pid) {
+            it->last_error = _now;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ts::TR101290Analyzer::resolve(Indicator indicator, PID pid)
+{
+    for (auto it = _alarms.begin(); it != _alarms.end(); ++it) {
+        if (it->indicator == indicator && it->pid == pid) {
+            if (it->persistent) {
+                _alarms.erase(it);
+                notify(indicator, pid, false, UString());
+            }
+            return;
+        }
+    }
+}
+
+void ts::TR101290Analyzer::notify(Indicator indicator, PID pid, bool raised, const UString& details)
+{
+    if (_handler != nullptr) {
+        Event event;
+        event.indicator = indicator;
+        event.raised = raised;
+        event.timestamp = _now;
+        event.pid = pid;
+        if (pid < PID_MAX) {
+            event.service_id = _pids[pid].service_id;
+            event.has_service = _pids[pid].has_service;
+        }
+        event.details = details;
+        _handler->handleTR101290Event(*this, event);
+    }
+}
@@ -0,0 +1,348 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Real-time ETSI TR 101 290 monitoring engine.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsSectionDemux.h"
+#include "tsEnumeration.h"
+#include "tsTSPacket.h"
+
+namespace ts {
+
+    class TR101290HandlerInterface;
+
+    //!
+    //! Real-time ETSI TR 101 290 monitoring engine.
+    //! @ingroup mpeg
+    //!
+    //! This class implements the measurement indicators of ETSI TR 101 290
+    //! (first, second and third priorities) on a live transport stream.
+    //! Each indicator is either an alarm raised on a specific event (continuity
+    //! error, CRC error, etc.) or a timer which expires when an expected item
+    //! (PAT, PMT, PCR, etc.) is missing for too long.
+    //!
+    //! Alarms are reported as events to an application-defined handler. An alarm
+    //! is raised on the first error and is cleared when the condition disappears:
+    //! event-type alarms are cleared when no new error was detected during the
+    //! "hold time", timer-type alarms are cleared when the missing item reappears.
+    //!
+    //! The analyzer works on a time line which is provided by the application
+    //! with each packet. All timeouts are evaluated on this time line, typically
+    //! derived from the packet index and the transport stream bitrate. Timers are
+    //! evaluated periodically (every 10 ms of stream time) and not on each packet.
+    //!
+    //! The buffer-related indicators (Buffer_error, Empty_buffer_error, Data_delay_error)
+    //! require a T-STD simulation and are not implemented here, see TSTDAnalyzer.
+    //!
+    class TSDUCKDLL TR101290Analyzer: private TableHandlerInterface, private SectionHandlerInterface
+    {
+    public:
+        //!
+        //! TR 101 290 indicators.
+        //!
+        enum Indicator {
+            TS_SYNC_LOSS,            //!< 1.1 TS_sync_loss.
+            SYNC_BYTE_ERROR,         //!< 1.2 Sync_byte_error.
+            PAT_ERROR,               //!< 1.3 PAT_error_2.
+            CONTINUITY_COUNT_ERROR,  //!< 1.4 Continuity_count_error.
+            PMT_ERROR,               //!< 1.5 PMT_error_2.
+            PID_ERROR,               //!< 1.6 PID_error.
+            TRANSPORT_ERROR,         //!< 2.1 Transport_error.
+            CRC_ERROR,               //!< 2.2 CRC_error.
+            PCR_REPETITION_ERROR,    //!< 2.3a PCR_repetition_error.
+            PCR_DISCONTINUITY_ERROR, //!< 2.3b PCR_discontinuity_indicator_error.
+            PCR_ACCURACY_ERROR,      //!< 2.4 PCR_accuracy_error.
+            PTS_ERROR,               //!< 2.5 PTS_error.
+            CAT_ERROR,               //!< 2.6 CAT_error.
+            NIT_ERROR,               //!< 3.1 NIT_actual_error.
+            SI_REPETITION_ERROR,     //!< 3.2 SI_repetition_error.
+            UNREFERENCED_PID,        //!< 3.4 Unreferenced_PID.
+            SDT_ERROR,               //!< 3.5 SDT_actual_error.
+            EIT_ERROR,               //!< 3.6 EIT_actual_error.
+            RST_ERROR,               //!< 3.7 RST_error.
+            TDT_ERROR,               //!< 3.8 TDT_error.
+            INDICATOR_COUNT          //!< Number of indicators, not a valid indicator.
+        };
+
+        //!
+        //! Names of indicators, as in ETSI TR 101 290.
+        //!
+        static const Enumeration IndicatorNames;
+
+        //!
+        //! Get the priority of an indicator.
+        //! @param [in] indicator The indicator.
+        //! @return The TR 101 290 priority of the indicator, 1 to 3.
+        //!
+        static int Priority(Indicator indicator);
+
+        //!
+        //! Description of an alarm event.
+        //!
+        struct TSDUCKDLL Event
+        {
+            Indicator  indicator;  //!< Indicator of the alarm.
+            bool       raised;     //!< True when the alarm is raised, false when it is cleared.
+            NanoSecond timestamp;  //!< Time of the event on the stream time line.
+            PID        pid;        //!< PID of the alarm or PID_MAX if the alarm is not related to a PID.
+            uint16_t   service_id; //!< Service id of the PID, if known.
+            bool       has_service;//!< True when @a service_id is valid.
+            UString    details;    //!< Human-readable details on the first error of a raised alarm.
+
+            //!
+            //! Default constructor.
+            //!
+            Event();
+        };
+
+        //!
+        //! Default hold time of event-type alarms: 1 second.
+        //!
+        static const NanoSecond DEFAULT_HOLD_TIME = NanoSecPerSec;
+
+        //!
+        //! Default timeout for PID_error: 5 seconds.
+        //!
+        static const NanoSecond DEFAULT_PID_TIMEOUT = 5 * NanoSecPerSec;
+
+        //!
+        //! Constructor.
+        //! @param [in] handler The object to notify of alarm events.
+        //!
+        explicit TR101290Analyzer(TR101290HandlerInterface* handler = nullptr);
+
+        //!
+        //! Destructor.
+        //!
+        virtual ~TR101290Analyzer() override;
+
+        //!
+        //! Replace the event handler.
+        //! @param [in] handler The new handler.
+        //!
+        void setHandler(TR101290HandlerInterface* handler) { _handler = handler; }
+
+        //!
+        //! Set the timeout of PID_error, for PID's which are referenced in a PMT.
+        //! @param [in] timeout The timeout in nanoseconds.
+        //!
+        void setPIDTimeout(NanoSecond timeout) { _pid_timeout = timeout; }
+
+        //!
+        //! Set the hold time of event-type alarms.
+        //! @param [in] hold The duration without error after which an alarm is cleared.
+        //!
+        void setHoldTime(NanoSecond hold) { _hold_time = hold; }
+
+        //!
+        //! Enable or disable an indicator.
+        //! A disabled indicator never raises any alarm and its error counter is not incremented.
+        //! @param [in] indicator The indicator.
+        //! @param [in] enabled When false, disable the indicator.
+        //!
+        void setIndicator(Indicator indicator, bool enabled) { _enabled[indicator] = enabled; }
+
+        //!
+        //! Check if an indicator is enabled.
+        //! @param [in] indicator The indicator.
+        //! @return True if @a indicator is enabled.
+        //!
+        bool isEnabled(Indicator indicator) const { return _enabled[indicator]; }
+
+        //!
+        //! Get the number of errors which were detected for an indicator.
+        //! @param [in] indicator The indicator.
+        //! @return The number of errors.
+        //!
+        uint64_t errorCount(Indicator indicator) const { return _error_count[indicator]; }
+
+        //!
+        //! Check if there is at least one active alarm for an indicator.
+        //! @param [in] indicator The indicator.
+        //! @return True if @a indicator has at least one active alarm.
+        //!
+        bool isActive(Indicator indicator) const;
+
+        //!
+        //! Get the number of analyzed packets.
+        //! @return The number of analyzed packets.
+        //!
+        PacketCounter packetCount() const { return _packet_count; }
+
+        //!
+        //! Reset the analysis context. The configuration is preserved.
+        //! Active alarms are dropped without notification.
+        //!
+        void reset();
+
+        //!
+        //! Analyze a TS packet.
+        //! @param [in] pkt The TS packet.
+        //! @param [in] timestamp Time of the packet on the stream time line, in nanoseconds.
+        //! The time line must be monotonic.
+        //!
+        void feedPacket(const TSPacket& pkt, NanoSecond timestamp);
+
+        //!
+        //! Evaluate the timers at a given time, without packet.
+        //! This is automatically done when packets are analyzed. This method is
+        //! useful to detect timeouts when the stream is interrupted.
+        //! @param [in] timestamp Current time on the stream time line, in nanoseconds.
+        //!
+        void checkTimers(NanoSecond timestamp);
+
+    private:
+        // A timer which expires when an expected item is missing for too long.
+        struct Timer
+        {
+            bool       armed;     // Timer is running.
+            bool       fired;     // Timer expired since it was last armed.
+            NanoSecond deadline;  // Expiration time.
+            NanoSecond period;    // Repetition period.
+
+            Timer() : armed(false), fired(false), deadline(0), period(0) {}
+            void arm(NanoSecond now, NanoSecond per) { armed = true; fired = false; period = per; deadline = now + per; }
+            void disarm() { armed = fired = false; }
+            bool fire(NanoSecond now);
+        };
+
+        // Analysis state of one PID.
+        struct PIDState
+        {
+            bool          seen;        // PID was seen in the stream.
+            bool          monitored;   // PID is in the list of monitored PID's.
+            bool          referenced;  // PID is referenced in a PMT or is a PSI/SI PID.
+            bool          is_pmt;      // PID is a PMT PID.
+            bool          pmt_seen;    // A PMT was received on this PID.
+            bool          check_pts;   // PID is an audio or video PES PID.
+            bool          has_service; // Service id is known.
+            bool          unref_done;  // Unreferenced PID already reported.
+            bool          cc_valid;    // Last continuity counter is valid.
+            uint8_t       cc;          // Last continuity counter.
+            uint8_t       dup_count;   // Number of consecutive duplicate packets.
+            uint16_t      service_id;  // Service id of the PID.
+            NanoSecond    first_seen;  // Time of first packet.
+            bool          pcr_valid;   // Last PCR and base PCR are valid.
+            uint64_t      pcr;         // Last PCR value.
+            PacketCounter pcr_index;   // Packet index of last PCR.
+            uint64_t      pcr_base;    // First PCR after last discontinuity, base for accuracy.
+            PacketCounter pcr_base_index; // Packet index of base PCR.
+            Timer         pmt_timer;   // PMT_error timer.
+            Timer         pid_timer;   // PID_error timer.
+            Timer         pcr_timer;   // PCR_repetition_error timer.
+            Timer         pts_timer;   // PTS_error timer.
+
+            PIDState();
+        };
+
+        // An active alarm.
+        struct Alarm
+        {
+            Indicator  indicator;  // Indicator of the alarm.
+            PID        pid;        // Related PID or PID_MAX.
+            NanoSecond last_error; // Time of last error.
+            bool       persistent; // Active until explicitly resolved.
+        };
+
+        // Private members:
+        TR101290HandlerInterface* _handler;
+        NanoSecond                _pid_timeout;
+        NanoSecond                _hold_time;
+        bool                      _enabled[INDICATOR_COUNT];
+        uint64_t                  _error_count[INDICATOR_COUNT];
+        PacketCounter             _packet_count;
+        bool                      _started;       // At least one packet was analyzed.
+        NanoSecond                _now;           // Time of current packet.
+        NanoSecond                _next_tick;     // Next time to evaluate timers.
+        size_t                    _bad_sync;      // Consecutive packets with invalid sync byte.
+        size_t                    _good_sync;     // Consecutive packets with valid sync byte after a sync loss.
+        bool                      _sync_lost;     // TS_sync_loss is active.
+        bool                      _pat_seen;      // At least one valid PAT was received.
+        bool                      _cat_seen;      // At least one CAT was received.
+        size_t                    _pmt_pending;   // Number of PMT's which were never received.
+        NanoSecond                _psi_time;      // Time when all PMT's were received once.
+        uint64_t                  _wrong_crc;     // Last number of wrong CRC from demux.
+        SectionDemux              _demux;
+        Timer                     _pat_timer;
+        Timer                     _nit_timer;
+        Timer                     _sdt_timer;
+        Timer                     _eit_timer;
+        Timer                     _tdt_timer;
+        Timer                     _bat_timer;
+        Timer                     _tot_timer;
+        std::map<uint32_t, NanoSecond> _last_section0; // Last section #0, key=(tid << 16) | tid_ext.
+        std::vector<PID>          _monitored;     // PID's with per-PID timers.
+        std::vector<Alarm>        _alarms;        // Active alarms.
+        PIDState                  _pids[PID_MAX];
+
+        // Check the timers and the hold time of alarms.
+        void tick();
+
+        // Analyze packet content.
+        void checkContinuity(PIDState& ps, const TSPacket& pkt);
+        void checkPCR(PIDState& ps, const TSPacket& pkt);
+
+        // Add a PID in the list of monitored PID's.
+        void monitor(PID pid);
+
+        // Mark a PID as referenced, by a service when service_id is not negative.
+        void reference(PID pid, int service_id);
+
+        // Process CA descriptors, mark ECM/EMM PID's as referenced.
+        void referenceCA(const DescriptorList& descs, int service_id);
+
+        // Check the minimum interval between two sections #0 of a table.
+        bool checkMinInterval(const Section& section);
+
+        // Raise an error on an indicator. Update or create the alarm.
+        void raise(Indicator indicator, PID pid, bool persistent, const UString& details = UString());
+
+        // Refresh an active alarm without counting a new error. Return false if the alarm is not active.
+        bool refresh(Indicator indicator, PID pid);
+
+        // Resolve a persistent alarm: it is immediately cleared. Event-type alarms are not resolved,
+        // they are cleared by tick() after the hold time.
+        void resolve(Indicator indicator, PID pid);
+
+        // Notify an event to the handler.
+        void notify(Indicator indicator, PID pid, bool raised, const UString& details);
+
+        // Implementation of TableHandlerInterface and SectionHandlerInterface.
+        virtual void handleTable(SectionDemux& demux, const BinaryTable& table) override;
+        virtual void handleSection(SectionDemux& demux, const Section& section) override;
+
+        // Inaccessible operations.
+        TR101290Analyzer(const TR101290Analyzer&) = delete;
+        TR101290Analyzer& operator=(const TR101290Analyzer&) = delete;
+    };
+}
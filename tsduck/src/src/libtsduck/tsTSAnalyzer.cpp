@@ -85,14 +85,30 @@ ts::TSAnalyzer::TSAnalyzer(BitRate bitrate_hint) :
     _tid_present(),
     _pids(),
     _services(),
+    _delta_tracking(false),
+    _delta_pids(),
+    _delta_tables(),
+    _delta_services(),
+    _delta_ts_pkt_cnt(0),
+    _delta_invalid_sync(0),
+    _delta_transport_errors(0),
+    _delta_suspect_ignored(0),
     _modified(false),
+    _warming_up(false),
     _ts_bitrate_sum(0),
     _ts_bitrate_cnt(0),
+    _delta_bitrate_sum(0),
+    _delta_bitrate_cnt(0),
     _preceding_errors(0),
     _preceding_suspects(0),
     _min_error_before_suspect(1),
     _max_consecutive_suspects(1),
     _default_charset(nullptr),
+    _level(TSAnalyzerOptions::FULL_ANALYSIS),
+    _sampling_period(TSAnalyzerOptions::DEFAULT_SAMPLING_PERIOD),
+    _sampling_window(TSAnalyzerOptions::DEFAULT_SAMPLING_WINDOW),
+    _sampling(false),
+    _pid_cache(),
     _demux(this, this),
     _pes_demux(this),
     _t2mi_demux(this)
@@ -125,6 +141,7 @@ ts::TSAnalyzer::~TSAnalyzer()
 void ts::TSAnalyzer::reset()
 {
     _modified = false;
+    _warming_up = false;
     _ts_id = 0;
     _ts_id_valid = false;
     _ts_pkt_cnt = 0;
@@ -163,11 +180,22 @@ void ts::TSAnalyzer::reset()
     _scrambled_services_cnt = 0;
     _tid_present.reset();
     _pids.clear();
+    std::fill(_pid_cache, _pid_cache + PID_MAX, nullptr);
     _services.clear();
     _ts_bitrate_sum = 0;
     _ts_bitrate_cnt = 0;
+    _delta_pids.clear();
+    _delta_tables.clear();
+    _delta_services.clear();
+    _delta_ts_pkt_cnt = 0;
+    _delta_invalid_sync = 0;
+    _delta_transport_errors = 0;
+    _delta_suspect_ignored = 0;
+    _delta_bitrate_sum = 0;
+    _delta_bitrate_cnt = 0;
     _preceding_errors = 0;
     _preceding_suspects = 0;
+    _sampling = false;
     _demux.reset();
     _pes_demux.reset();
 
@@ -179,6 +207,18 @@ void ts::TSAnalyzer::reset()
 }
 
 
+//----------------------------------------------------------------------------
+// Set the analysis level.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::setAnalysisLevel(TSAnalyzerOptions::AnalysisLevel level, PacketCounter period, PacketCounter window)
+{
+    _level = level;
+    _sampling_period = std::max<PacketCounter>(period, 1);
+    _sampling_window = std::min(window, _sampling_period);
+}
+
+
 //----------------------------------------------------------------------------
 // Constructor for the PID context
 //----------------------------------------------------------------------------
@@ -233,7 +273,21 @@ ts::TSAnalyzer::PIDContext::PIDContext(PID pid_, const UString& description_) :
     last_pcr(0),
     last_pcr_pkt(0),
     ts_bitrate_sum(0),
-    ts_bitrate_cnt(0)
+    ts_bitrate_cnt(0),
+    first_continuity(0),
+    first_discontinuity(false),
+    first_payload(false),
+    first_pcr(0),
+    first_pcr_pkt(0),
+    first_pcr_broken(false),
+    delta_changed(false),
+    delta_reported(false),
+    delta_ts_pkt_cnt(0),
+    delta_unexp_discont(0),
+    delta_duplicated(0),
+    delta_ts_sc_cnt(0),
+    delta_inv_ts_sc_cnt(0),
+    delta_pcr_cnt(0)
 {
     // Guess the initial description, based on the PID
     // Global PID's (PAT, CAT, etc) are marked as "referenced" since they
@@ -353,7 +407,10 @@ ts::TSAnalyzer::ETIDContext::ETIDContext(const ETID& etid_) :
     last_version(0),
     versions(),
     first_pkt(0),
-    last_pkt(0)
+    last_pkt(0),
+    skipped_count(0),
+    skipped_ts(0),
+    delta_changed(false)
 {
 }
 
@@ -503,6 +560,11 @@ void ts::TSAnalyzer::PIDContext::addService(uint16_t service_id)
 
 void ts::TSAnalyzer::handleSection(SectionDemux&, const Section& section)
 {
+    // Sections before the analyzed part of the stream are not counted.
+    if (_warming_up) {
+        return;
+    }
+
     ETIDContextPtr etc(getETID(section));
     const uint8_t version = section.version();
 
@@ -511,6 +573,11 @@ void ts::TSAnalyzer::handleSection(SectionDemux&, const Section& section)
 
     // Section# 0 is used to track tables
     if (section.sectionNumber() == 0) {
+        // Record new tables and new versions for interval deltas.
+        if (_delta_tracking && !etc->delta_changed && (etc->table_count == 0 || (section.isLongSection() && version != etc->last_version))) {
+            etc->delta_changed = true;
+            _delta_tables.push_back(DeltaTable(section.sourcePID(), etc));
+        }
         if (etc->table_count++ == 0) {
             // First occurence of table
             etc->first_pkt = _ts_pkt_cnt;
@@ -520,9 +587,16 @@ void ts::TSAnalyzer::handleSection(SectionDemux&, const Section& section)
         }
         else {
             const uint64_t rep = _ts_pkt_cnt - etc->last_pkt;
-            if (etc->table_count == 2) {
+            if (_level == TSAnalyzerOptions::MINIMAL_ANALYSIS && crossesSamplingWindow(etc->last_pkt, _ts_pkt_cnt)) {
+                // With minimal analysis, the demux is fed during sampling windows only. The previous
+                // occurence was in a previous sampling window, occurences in the unsampled packets in
+                // between were not seen. This is not a repetition interval, record it separately.
+                etc->skipped_count++;
+                etc->skipped_ts += rep;
+            }
+            else if (etc->table_count - etc->skipped_count == 2) {
                 // First time we are able to compute an interval
-                etc->repetition_ts = etc->min_repetition_ts = etc->max_repetition_ts = rep;
+                etc->min_repetition_ts = etc->max_repetition_ts = rep;
             }
             else {
                 if (rep < etc->min_repetition_ts) {
@@ -531,8 +605,11 @@ void ts::TSAnalyzer::handleSection(SectionDemux&, const Section& section)
                 if (rep > etc->max_repetition_ts) {
                     etc->max_repetition_ts = rep;
                 }
-                assert(etc->table_count > 2);
-                etc->repetition_ts = (_ts_pkt_cnt - etc->first_pkt + (etc->table_count - 1) / 2) / (etc->table_count - 1);
+            }
+            // Average repetition interval, excluding the intervals which span unsampled packets.
+            const uint64_t intervals = etc->table_count - 1 - etc->skipped_count;
+            if (intervals > 0) {
+                etc->repetition_ts = (_ts_pkt_cnt - etc->first_pkt - etc->skipped_ts + intervals / 2) / intervals;
             }
         }
         etc->last_pkt = _ts_pkt_cnt;
@@ -633,6 +710,7 @@ void ts::TSAnalyzer::analyzePAT(const PAT& pat)
         // Describe the service
         ServiceContextPtr svp(getService(service_id));
         svp->pmt_pid = pmt_pid;
+        trackService(service_id);
     }
 }
 
@@ -656,10 +734,13 @@ void ts::TSAnalyzer::analyzePMT(PID pid, const PMT& pmt)
 {
     // Count the number of PMT's on this PID
     PIDContextPtr ps(getPID(pid));
-    ps->pmt_cnt++;
+    if (!_warming_up) {
+        ps->pmt_cnt++;
+    }
 
     // Get service description
     ServiceContextPtr svp(getService(pmt.service_id));
+    trackService(pmt.service_id);
 
     // Check that this PMT was expected on this PID
     if (svp->pmt_pid != pid) {
@@ -678,6 +759,7 @@ void ts::TSAnalyzer::analyzePMT(PID pid, const PMT& pmt)
         ps = getPID(pmt.pcr_pid, u"PCR (not otherwise referenced)");
         ps->is_pcr_pid = true;
         ps->addService(pmt.service_id);
+        trackPID(ps);
     }
 
     // Process "program info" list of descriptors.
@@ -698,6 +780,7 @@ void ts::TSAnalyzer::analyzePMT(PID pid, const PMT& pmt)
         }
         ps->description = names::StreamType(stream.stream_type);
         analyzeDescriptors(stream.descs, svp.pointer(), ps.pointer());
+        trackPID(ps);
     }
 }
 
@@ -712,6 +795,7 @@ void ts::TSAnalyzer::analyzeSDT(const SDT& sdt)
     for (SDT::ServiceMap::const_iterator it = sdt.services.begin(); it != sdt.services.end(); ++it) {
 
         ServiceContextPtr svp(getService(it->first)); // it->first = map key = service id
+        trackService(it->first);
         svp->orig_netw_id = sdt.onetw_id;
         svp->service_type = it->second.serviceType();
 
@@ -735,6 +819,9 @@ void ts::TSAnalyzer::analyzeSDT(const SDT& sdt)
 void ts::TSAnalyzer::analyzeTDT(const TDT& tdt)
 {
     // Keep first and last time stamps
+    if (_warming_up) {
+        return;
+    }
     if (_first_tdt == Time::Epoch) {
         _first_tdt = tdt.utc_time;
     }
@@ -749,7 +836,7 @@ void ts::TSAnalyzer::analyzeTDT(const TDT& tdt)
 void ts::TSAnalyzer::analyzeTOT(const TOT& tot)
 {
     // Keep first and last time stamps, country code of first region
-    if (!tot.regions.empty()) {
+    if (!_warming_up && !tot.regions.empty()) {
         _last_tot = tot.localTime(tot.regions[0]);
         if (_first_tot == Time::Epoch) {
             _country_code = tot.regions[0].country;
@@ -1248,7 +1335,9 @@ void ts::TSAnalyzer::handleT2MIPacket(T2MIDemux& demux, const T2MIPacket& pkt)
     PIDContextPtr pc(getPID(pkt.getSourcePID(), u"T2-MI"));
 
     // Count T2-MI packets.
-    pc->t2mi_cnt++;
+    if (!_warming_up) {
+        pc->t2mi_cnt++;
+    }
 
     // Process PLP (only in baseband frame).
     if (pkt.plpValid()) {
@@ -1271,7 +1360,10 @@ void ts::TSAnalyzer::handleTSPacket(T2MIDemux& demux, const T2MIPacket& t2mi, co
     PIDContextPtr pc(getPID(t2mi.getSourcePID(), u"T2-MI"));
 
     // Count demux'ed TS packets from this PLP.
-    pc->t2mi_plp_ts[t2mi.plp()]++;
+    uint64_t& count(pc->t2mi_plp_ts[t2mi.plp()]);
+    if (!_warming_up) {
+        count++;
+    }
 }
 
 
@@ -1327,14 +1419,40 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
     _preceding_errors = 0;
     _preceding_suspects = 0;
 
+    // Below the full analysis level, some demux are fed during sampling windows only.
+    if (_level != TSAnalyzerOptions::FULL_ANALYSIS) {
+        const bool in_window = (packet_index - 1) % _sampling_period < _sampling_window;
+        if (in_window && !_sampling) {
+            // Packets were skipped since the previous window, continuity counters
+            // may look correct across the gap, don't reassemble data across it.
+            _pes_demux.syncLost();
+            _t2mi_demux.syncLost();
+            if (_level == TSAnalyzerOptions::MINIMAL_ANALYSIS) {
+                _demux.syncLost();
+            }
+        }
+        _sampling = in_window;
+    }
+
     // Feed packets into the various demux
-    _demux.feedPacket(pkt);
-    _pes_demux.feedPacket(pkt);
-    _t2mi_demux.feedPacket(pkt);
+    if (_level != TSAnalyzerOptions::MINIMAL_ANALYSIS || _sampling) {
+        _demux.feedPacket(pkt);
+    }
+    if (_level == TSAnalyzerOptions::FULL_ANALYSIS || _sampling) {
+        _pes_demux.feedPacket(pkt);
+        _t2mi_demux.feedPacket(pkt);
+    }
 
-    // Get PID context
-    PIDContextPtr ps(getPID(pkt.getPID()));
+    // Get PID context. Use the direct access cache, the map is searched only once per PID.
+    const PID pid = pkt.getPID();
+    PIDContext* ps = _pid_cache[pid];
+    if (ps == nullptr) {
+        ps = _pid_cache[pid] = getPID(pid).pointer();
+    }
     ps->ts_pkt_cnt++;
+    if (_delta_tracking && !ps->delta_changed) {
+        trackPID(getPID(pid));
+    }
 
     // Accumulate stat from packet
     if (pkt.hasAF()) {
@@ -1381,6 +1499,9 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
         if (ps->ts_pkt_cnt == 1) {
             // First packet, initialize continuity
             ps->cur_continuity = pkt.getCC();
+            ps->first_continuity = pkt.getCC();
+            ps->first_discontinuity = pkt.getDiscontinuityIndicator();
+            ps->first_payload = pkt.hasPayload();
         }
         else if (pkt.getDiscontinuityIndicator()) {
             // Expected discontinuity
@@ -1411,9 +1532,15 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
     if (broken_rate) {
         // Suspected packet loss, forget last PCR.
         ps->last_pcr = 0;
+        ps->first_pcr_broken = ps->first_pcr_broken || ps->pcr_cnt == 0;
     }
     if (pkt.hasPCR()) {
         uint64_t pcr(pkt.getPCR());
+        // Keep first PCR to merge analyses of successive parts of a stream.
+        if (ps->pcr_cnt == 0) {
+            ps->first_pcr = pcr;
+            ps->first_pcr_pkt = packet_index;
+        }
         // Count PID's with PCR
         if (ps->pcr_cnt++ == 0)
             _pcr_pid_cnt++;
@@ -1481,6 +1608,328 @@ void ts::TSAnalyzer::feedPacket(const TSPacket& pkt)
 }
 
 
+//----------------------------------------------------------------------------
+// Analysis of a part of a stream.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::setPacketIndex(PacketCounter index)
+{
+    _ts_pkt_cnt = index;
+
+    // Sampling state of the previous packet, as in a single analysis of the stream,
+    // to detect the start of the next sampling window exactly at the same place.
+    _sampling = _level != TSAnalyzerOptions::FULL_ANALYSIS && index > 0 && (index - 1) % _sampling_period < _sampling_window;
+}
+
+void ts::TSAnalyzer::warmUp(const TSPacket& pkt)
+{
+    // Feed the demux only, the handlers do not count tables and packets while warming up.
+    if (pkt.hasValidSync() && !pkt.getTEI()) {
+        _warming_up = true;
+        _demux.feedPacket(pkt);
+        _pes_demux.feedPacket(pkt);
+        _t2mi_demux.feedPacket(pkt);
+        _warming_up = false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Merge the analysis of the next part of the stream.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::merge(TSAnalyzer& next)
+{
+    _modified = true;
+
+    // Global counters and state, next part follows this one.
+    _ts_pkt_cnt = std::max(_ts_pkt_cnt, next._ts_pkt_cnt);
+    _invalid_sync += next._invalid_sync;
+    _transport_errors += next._transport_errors;
+    _suspect_ignored += next._suspect_ignored;
+    _ts_bitrate_sum += next._ts_bitrate_sum;
+    _ts_bitrate_cnt += next._ts_bitrate_cnt;
+    _preceding_errors = next._preceding_errors;
+    _preceding_suspects = next._preceding_suspects;
+    _tid_present |= next._tid_present;
+    if (next._ts_id_valid) {
+        _ts_id = next._ts_id;
+        _ts_id_valid = true;
+    }
+
+    // Time stamps: first ones from this part, last ones from next part.
+    if (_first_utc == Time::Epoch) {
+        _first_utc = next._first_utc;
+        _first_local = next._first_local;
+    }
+    if (_first_tdt == Time::Epoch) {
+        _first_tdt = next._first_tdt;
+    }
+    if (next._last_tdt != Time::Epoch) {
+        _last_tdt = next._last_tdt;
+    }
+    if (_first_tot == Time::Epoch) {
+        _first_tot = next._first_tot;
+        _country_code = next._country_code;
+    }
+    if (next._last_tot != Time::Epoch) {
+        _last_tot = next._last_tot;
+    }
+
+    // Services: the most recent non-empty characteristics are kept.
+    for (ServiceContextMap::const_iterator it = next._services.begin(); it != next._services.end(); ++it) {
+        const ServiceContextMap::iterator cur(_services.find(it->first));
+        if (cur == _services.end()) {
+            _services.insert(*it);
+        }
+        else {
+            ServiceContext& sc(*cur->second);
+            const ServiceContext& nsc(*it->second);
+            if (nsc.orig_netw_id != 0) {
+                sc.orig_netw_id = nsc.orig_netw_id;
+            }
+            if (nsc.service_type != 0) {
+                sc.service_type = nsc.service_type;
+            }
+            if (!nsc.name.empty()) {
+                sc.name = nsc.name;
+            }
+            if (!nsc.provider.empty()) {
+                sc.provider = nsc.provider;
+            }
+            if (nsc.pmt_pid != 0) {
+                sc.pmt_pid = nsc.pmt_pid;
+            }
+            if (nsc.pcr_pid != 0) {
+                sc.pcr_pid = nsc.pcr_pid;
+            }
+            sc.carry_ssu = sc.carry_ssu || nsc.carry_ssu;
+            sc.carry_t2mi = sc.carry_t2mi || nsc.carry_t2mi;
+        }
+    }
+
+    // PID's.
+    for (PIDContextMap::const_iterator it = next._pids.begin(); it != next._pids.end(); ++it) {
+        const PIDContextMap::iterator cur(_pids.find(it->first));
+        if (cur != _pids.end()) {
+            mergePID(*cur->second, *it->second);
+        }
+        else {
+            _pids.insert(*it);
+            if (it->second->scrambled) {
+                _scrambled_pid_cnt++;
+            }
+            if (it->second->pcr_cnt > 0) {
+                _pcr_pid_cnt++;
+            }
+        }
+    }
+
+    // The contexts are now shared, the next analyzer must not use them.
+    next.reset();
+}
+
+
+//----------------------------------------------------------------------------
+// Check if a sampling window starts between two packet indexes.
+//----------------------------------------------------------------------------
+
+bool ts::TSAnalyzer::crossesSamplingWindow(PacketCounter from, PacketCounter to) const
+{
+    // Packet indexes start at 1, a sampling window starts at index 1 modulo the period.
+    return from < to && (from == 0 || (to - 1) / _sampling_period > (from - 1) / _sampling_period);
+}
+
+
+//----------------------------------------------------------------------------
+// Merge the context of a PID from the next part of the stream.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::mergePID(PIDContext& pc, const PIDContext& next)
+{
+    // Description from the most recent PSI/SI.
+    if (next.referenced) {
+        pc.description = next.description;
+        pc.comment = next.comment;
+    }
+    if (!next.language.empty()) {
+        pc.language = next.language;
+    }
+    for (UStringVector::const_iterator it = next.attributes.begin(); it != next.attributes.end(); ++it) {
+        AppendUnique(pc.attributes, *it);
+    }
+    pc.services.insert(next.services.begin(), next.services.end());
+    pc.referenced = pc.referenced || next.referenced;
+    pc.is_pmt_pid = pc.is_pmt_pid || next.is_pmt_pid;
+    pc.is_pcr_pid = pc.is_pcr_pid || next.is_pcr_pid;
+    pc.carry_pes = pc.carry_pes || next.carry_pes;
+    pc.carry_section = pc.carry_section || next.carry_section;
+    pc.carry_ecm = pc.carry_ecm || next.carry_ecm;
+    pc.carry_emm = pc.carry_emm || next.carry_emm;
+    pc.carry_audio = pc.carry_audio || next.carry_audio;
+    pc.carry_video = pc.carry_video || next.carry_video;
+    pc.carry_t2mi = pc.carry_t2mi || next.carry_t2mi;
+    if (next.scrambled && !pc.scrambled) {
+        pc.scrambled = true;
+        _scrambled_pid_cnt++;
+    }
+    if (next.pes_stream_id != 0) {
+        if (pc.pes_stream_id == 0) {
+            pc.pes_stream_id = next.pes_stream_id;
+            pc.same_stream_id = next.same_stream_id;
+        }
+        else if (next.pes_stream_id != pc.pes_stream_id || !next.same_stream_id) {
+            pc.same_stream_id = false;
+        }
+    }
+    if (next.cas_id != 0) {
+        pc.cas_id = next.cas_id;
+    }
+    pc.cas_operators.insert(next.cas_operators.begin(), next.cas_operators.end());
+    pc.ssu_oui.insert(next.ssu_oui.begin(), next.ssu_oui.end());
+    for (std::map<uint8_t,uint64_t>::const_iterator it = next.t2mi_plp_ts.begin(); it != next.t2mi_plp_ts.end(); ++it) {
+        pc.t2mi_plp_ts[it->first] += it->second;
+    }
+
+    // Continuity and PCR at the boundary, as if the first packet of next part followed this part.
+    if (pc.ts_pkt_cnt > 0 && next.ts_pkt_cnt > 0) {
+        bool broken_rate = false;
+        if (pc.pid != PID_NULL) {
+            if (next.first_discontinuity) {
+                pc.exp_discont++;
+                broken_rate = true;
+            }
+            else if (next.first_payload) {
+                if (next.first_continuity == pc.cur_continuity) {
+                    pc.duplicated++;
+                }
+                else if (next.first_continuity != (pc.cur_continuity + 1) % CC_MAX) {
+                    pc.unexp_discont++;
+                    broken_rate = true;
+                }
+            }
+            else if (next.first_continuity != pc.cur_continuity) {
+                pc.unexp_discont++;
+                broken_rate = true;
+            }
+        }
+        if (broken_rate || next.first_pcr_broken) {
+            pc.last_pcr = 0;
+        }
+        if (next.pcr_cnt > 0 && pc.last_pcr != 0 && pc.last_pcr < next.first_pcr) {
+            const uint64_t ts_bitrate =
+                (uint64_t(next.first_pcr_pkt - pc.last_pcr_pkt) * SYSTEM_CLOCK_FREQ * PKT_SIZE * 8) /
+                (next.first_pcr - pc.last_pcr);
+            pc.ts_bitrate_sum += ts_bitrate;
+            pc.ts_bitrate_cnt++;
+            _ts_bitrate_sum += ts_bitrate;
+            _ts_bitrate_cnt++;
+        }
+    }
+    else if (pc.ts_pkt_cnt == 0) {
+        pc.first_continuity = next.first_continuity;
+        pc.first_discontinuity = next.first_discontinuity;
+        pc.first_payload = next.first_payload;
+        pc.first_pcr = next.first_pcr;
+        pc.first_pcr_pkt = next.first_pcr_pkt;
+        pc.first_pcr_broken = next.first_pcr_broken;
+    }
+
+    // Analysis state after the next part.
+    if (next.ts_pkt_cnt > 0) {
+        pc.cur_continuity = next.cur_continuity;
+        pc.cur_ts_sc = next.cur_ts_sc;
+        pc.cur_ts_sc_pkt = next.cur_ts_sc_pkt;
+    }
+    if (next.pcr_cnt > 0) {
+        if (pc.pcr_cnt == 0) {
+            _pcr_pid_cnt++;
+        }
+        pc.last_pcr = next.last_pcr;
+        pc.last_pcr_pkt = next.last_pcr_pkt;
+    }
+
+    // Counters.
+    pc.ts_pkt_cnt += next.ts_pkt_cnt;
+    pc.ts_af_cnt += next.ts_af_cnt;
+    pc.unit_start_cnt += next.unit_start_cnt;
+    pc.pl_start_cnt += next.pl_start_cnt;
+    pc.pmt_cnt += next.pmt_cnt;
+    pc.unexp_discont += next.unexp_discont;
+    pc.exp_discont += next.exp_discont;
+    pc.duplicated += next.duplicated;
+    pc.ts_sc_cnt += next.ts_sc_cnt;
+    pc.inv_ts_sc_cnt += next.inv_ts_sc_cnt;
+    pc.inv_pes_start += next.inv_pes_start;
+    pc.t2mi_cnt += next.t2mi_cnt;
+    pc.pcr_cnt += next.pcr_cnt;
+    pc.ts_bitrate_sum += next.ts_bitrate_sum;
+    pc.ts_bitrate_cnt += next.ts_bitrate_cnt;
+    pc.cryptop_cnt += next.cryptop_cnt;
+    pc.cryptop_ts_cnt += next.cryptop_ts_cnt;
+
+    // Sections: repetition intervals across the boundary.
+    for (ETIDContextMap::const_iterator it = next.sections.begin(); it != next.sections.end(); ++it) {
+        const ETIDContextMap::iterator cur(pc.sections.find(it->first));
+        if (cur == pc.sections.end()) {
+            pc.sections.insert(*it);
+            continue;
+        }
+        ETIDContext& ec(*cur->second);
+        const ETIDContext& nec(*it->second);
+        if (nec.table_count > 0) {
+            if (ec.table_count == 0) {
+                ec.first_pkt = nec.first_pkt;
+                ec.first_version = nec.first_version;
+                ec.min_repetition_ts = nec.min_repetition_ts;
+                ec.max_repetition_ts = nec.max_repetition_ts;
+            }
+            else {
+                // Same rules as handleSection(): with minimal analysis, an interval which
+                // spans unsampled packets is not a repetition interval.
+                const uint64_t rep = nec.first_pkt - ec.last_pkt;
+                bool has_interval = ec.table_count - ec.skipped_count > 1;
+                if (_level == TSAnalyzerOptions::MINIMAL_ANALYSIS && crossesSamplingWindow(ec.last_pkt, nec.first_pkt)) {
+                    ec.skipped_count++;
+                    ec.skipped_ts += rep;
+                }
+                else if (!has_interval) {
+                    ec.min_repetition_ts = ec.max_repetition_ts = rep;
+                    has_interval = true;
+                }
+                else {
+                    ec.min_repetition_ts = std::min(ec.min_repetition_ts, rep);
+                    ec.max_repetition_ts = std::max(ec.max_repetition_ts, rep);
+                }
+                if (nec.table_count - nec.skipped_count > 1) {
+                    if (has_interval) {
+                        ec.min_repetition_ts = std::min(ec.min_repetition_ts, nec.min_repetition_ts);
+                        ec.max_repetition_ts = std::max(ec.max_repetition_ts, nec.max_repetition_ts);
+                    }
+                    else {
+                        ec.min_repetition_ts = nec.min_repetition_ts;
+                        ec.max_repetition_ts = nec.max_repetition_ts;
+                    }
+                }
+            }
+            if (nec.versions.any()) {
+                ec.last_version = nec.last_version;
+            }
+            ec.table_count += nec.table_count;
+            ec.last_pkt = nec.last_pkt;
+            ec.skipped_count += nec.skipped_count;
+            ec.skipped_ts += nec.skipped_ts;
+            const uint64_t intervals = ec.table_count - 1 - ec.skipped_count;
+            if (ec.table_count > 1 && intervals > 0) {
+                ec.repetition_ts = (ec.last_pkt - ec.first_pkt - ec.skipped_ts + intervals / 2) / intervals;
+            }
+        }
+        ec.section_count += nec.section_count;
+        ec.versions |= nec.versions;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Specify a "bitrate hint" for the analysis. It is the user-specified
 // bitrate in bits/seconds, based on 188-byte packets. The bitrate is
@@ -1494,6 +1943,71 @@ void ts::TSAnalyzer::setBitrateHint(BitRate bitrate)
 }
 
 
+//----------------------------------------------------------------------------
+// Interval deltas.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzer::setDeltaTracking(bool on)
+{
+    _delta_tracking = on;
+}
+
+void ts::TSAnalyzer::trackPID(const PIDContextPtr& pc)
+{
+    if (_delta_tracking && !pc->delta_changed) {
+        pc->delta_changed = true;
+        _delta_pids.push_back(pc);
+    }
+}
+
+void ts::TSAnalyzer::trackService(uint16_t service_id)
+{
+    if (_delta_tracking) {
+        _delta_services.insert(service_id);
+    }
+}
+
+ts::BitRate ts::TSAnalyzer::deltaBitrate() const
+{
+    if (_ts_user_bitrate != 0) {
+        return _ts_user_bitrate;
+    }
+    else if (_ts_bitrate_cnt > _delta_bitrate_cnt) {
+        return BitRate((_ts_bitrate_sum - _delta_bitrate_sum) / (_ts_bitrate_cnt - _delta_bitrate_cnt));
+    }
+    else {
+        return _ts_bitrate_cnt == 0 ? 0 : BitRate(_ts_bitrate_sum / _ts_bitrate_cnt);
+    }
+}
+
+void ts::TSAnalyzer::restartDelta()
+{
+    for (std::vector<PIDContextPtr>::const_iterator it = _delta_pids.begin(); it != _delta_pids.end(); ++it) {
+        PIDContext& pc(**it);
+        pc.delta_changed = false;
+        pc.delta_reported = true;
+        pc.delta_ts_pkt_cnt = pc.ts_pkt_cnt;
+        pc.delta_unexp_discont = pc.unexp_discont;
+        pc.delta_duplicated = pc.duplicated;
+        pc.delta_ts_sc_cnt = pc.ts_sc_cnt;
+        pc.delta_inv_ts_sc_cnt = pc.inv_ts_sc_cnt;
+        pc.delta_pcr_cnt = pc.pcr_cnt;
+    }
+    for (std::vector<DeltaTable>::const_iterator it = _delta_tables.begin(); it != _delta_tables.end(); ++it) {
+        it->second->delta_changed = false;
+    }
+    _delta_pids.clear();
+    _delta_tables.clear();
+    _delta_services.clear();
+    _delta_ts_pkt_cnt = _ts_pkt_cnt;
+    _delta_invalid_sync = _invalid_sync;
+    _delta_transport_errors = _transport_errors;
+    _delta_suspect_ignored = _suspect_ignored;
+    _delta_bitrate_sum = _ts_bitrate_sum;
+    _delta_bitrate_cnt = _ts_bitrate_cnt;
+}
+
+
 //----------------------------------------------------------------------------
 // Update the global statistics value if internal data were modified.
 //----------------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #pragma once
 #include "tsMPEG.h"
 #include "tsTSPacket.h"
+#include "tsTSAnalyzerOptions.h"
 #include "tsSectionDemux.h"
 #include "tsPESDemux.h"
 #include "tsT2MIDemux.h"
@@ -53,6 +54,16 @@ namespace ts {
     //! A class which analyzes a complete transport stream.
     //! @ingroup mpeg
     //!
+    //! A large stream can be analyzed in parallel, using one instance per chunk of
+    //! contiguous packets. Each instance is positioned using setPacketIndex() and
+    //! warmUp() before analyzing its chunk. The instances are then merged, in stream
+    //! order, using merge(). Counters, continuity errors, PCR-based bitrates and table
+    //! repetition intervals across chunk boundaries are merged as if the stream was
+    //! analyzed sequentially, provided that the warm-up period of each chunk contains
+    //! all PSI/SI tables. The following information may differ from a sequential
+    //! analysis: suspect packets after transport errors at the start of a chunk, the
+    //! average crypto-period when it spans a chunk boundary and the system times.
+    //!
     class TSDUCKDLL TSAnalyzer:
         private TableHandlerInterface,
         private SectionHandlerInterface,
@@ -86,6 +97,34 @@ namespace ts {
         //!
         void reset();
 
+        //!
+        //! Set the index in the stream of the next analyzed packet.
+        //! This is used when the analysis starts in the middle of the stream, typically
+        //! in a chunk of a large file which is analyzed in parallel. This must be called
+        //! before the first packet and after setting the analysis level.
+        //! @param [in] index Index in the stream of the next packet, counted from zero.
+        //!
+        void setPacketIndex(PacketCounter index);
+
+        //!
+        //! Feed the analyzer with a TS packet which precedes the analyzed part of the stream.
+        //! The packet is only used to collect the structure of the stream (PSI/SI, PES
+        //! attributes) and to synchronize the section demux. It is not counted.
+        //! @param [in] packet One TS packet from the stream, before the analyzed part.
+        //!
+        void warmUp(const TSPacket& packet);
+
+        //!
+        //! Merge the analysis of the next part of the stream.
+        //! Both analyzers shall have analyzed contiguous parts of the same stream,
+        //! @a next starting at the packet index following the last packet of this
+        //! analyzer (see setPacketIndex()). After merging, this object contains the
+        //! analysis of both parts and shall no longer be fed with packets.
+        //! @param [in,out] next The analyzer of the next part of the stream. Its content
+        //! is transferred into this object, it shall be reset or discarded after the call.
+        //!
+        void merge(TSAnalyzer& next);
+
         //!
         //! Specify a "bitrate hint" for the analysis.
         //! @param [in] bitrate_hint Optional bitrate "hint" for the analysis.
@@ -95,6 +134,15 @@ namespace ts {
         //!
         void setBitrateHint(BitRate bitrate_hint = 0);
 
+        //!
+        //! Enable or disable the tracking of changes between successive interval deltas.
+        //! When enabled, the analyzer records which PID's received packets and which services
+        //! and tables appeared or changed since the previous delta, so that a delta is built
+        //! without browsing all contexts. See TSAnalyzerReport::jsonDelta().
+        //! @param [in] on True to enable the tracking of changes.
+        //!
+        void setDeltaTracking(bool on);
+
         //!
         //! Set the number of consecutive packet errors threshold.
         //! @param [in] count The number of consecutive packet errors after which a packet is
@@ -118,6 +166,18 @@ namespace ts {
             _max_consecutive_suspects = count;
         }
 
+        //!
+        //! Set the analysis level.
+        //! Below the full level, some demuxes process packets during sampling windows only.
+        //! A sampling window of @a window packets starts every @a period packets.
+        //! @param [in] level The analysis level.
+        //! @param [in] period Distance in packets between the starts of two sampling windows.
+        //! @param [in] window Size in packets of a sampling window.
+        //!
+        void setAnalysisLevel(TSAnalyzerOptions::AnalysisLevel level,
+                              PacketCounter period = TSAnalyzerOptions::DEFAULT_SAMPLING_PERIOD,
+                              PacketCounter window = TSAnalyzerOptions::DEFAULT_SAMPLING_WINDOW);
+
         //!
         //! Set the default DVB character set to use (for incorrect signalization only).
         //! @param [in] charset The DVB character set to use when no charset code is
@@ -258,6 +318,10 @@ namespace ts {
             // Public members - Analysis data: Repetition interval evaluation:
             uint64_t   first_pkt;                 //!< Last packet index of first section# 0.
             uint64_t   last_pkt;                  //!< Last packet index of last section# 0.
+            uint64_t   skipped_count;             //!< Number of intervals between occurences of this table which span unsampled packets.
+            uint64_t   skipped_ts;                //!< Total number of TS packets in intervals which span unsampled packets.
+            // Public members - Analysis data: Interval deltas:
+            bool       delta_changed;             //!< Appeared or changed version since previous delta.
 
             //!
             //! Default constructor.
@@ -348,6 +412,22 @@ namespace ts {
             uint64_t       last_pcr_pkt;    //!< Index of packet with last PCR.
             uint64_t       ts_bitrate_sum;  //!< Sum of all computed TS bitrates.
             uint64_t       ts_bitrate_cnt;  //!< Number of computed TS bitrates.
+            // Public members - Analysis data: First packets, to merge analyses of successive parts of a stream.
+            uint8_t        first_continuity;     //!< Continuity counter of first packet.
+            bool           first_discontinuity;  //!< First packet has a discontinuity indicator.
+            bool           first_payload;        //!< First packet has a payload.
+            uint64_t       first_pcr;            //!< First PCR value.
+            uint64_t       first_pcr_pkt;        //!< Index of packet with first PCR.
+            bool           first_pcr_broken;     //!< A discontinuity precedes the first PCR.
+            // Public members - Analysis data: Counters at previous interval delta.
+            bool           delta_changed;        //!< Modified since previous delta.
+            bool           delta_reported;       //!< Already reported in a previous delta.
+            uint64_t       delta_ts_pkt_cnt;     //!< Number of TS packets at previous delta.
+            uint64_t       delta_unexp_discont;  //!< Number of unexpected discontinuities at previous delta.
+            uint64_t       delta_duplicated;     //!< Number of duplicated packets at previous delta.
+            uint64_t       delta_ts_sc_cnt;      //!< Number of scrambled packets at previous delta.
+            uint64_t       delta_inv_ts_sc_cnt;  //!< Number of invalid scrambling control at previous delta.
+            uint64_t       delta_pcr_cnt;        //!< Number of PCR's at previous delta.
 
             //!
             //! Default constructor.
@@ -443,12 +523,40 @@ namespace ts {
         PIDContextMap     _pids;        //!< Description of PIDs.
         ServiceContextMap _services;    //!< Description of services, map key: service id..
 
+        //!
+        //! A table which appeared or changed in an interval delta.
+        //!
+        typedef std::pair<PID, ETIDContextPtr> DeltaTable;
+
+        // Interval deltas, maintained when setDeltaTracking() is enabled.
+        bool                       _delta_tracking;          //!< Track changes since previous delta.
+        std::vector<PIDContextPtr> _delta_pids;              //!< PID's with packets or new description since previous delta.
+        std::vector<DeltaTable>    _delta_tables;            //!< Tables which appeared or changed version since previous delta.
+        ServiceIdSet               _delta_services;          //!< Services with new PSI/SI since previous delta.
+        uint64_t                   _delta_ts_pkt_cnt;        //!< Number of TS packets at previous delta.
+        uint64_t                   _delta_invalid_sync;      //!< Number of invalid sync at previous delta.
+        uint64_t                   _delta_transport_errors;  //!< Number of transport errors at previous delta.
+        uint64_t                   _delta_suspect_ignored;   //!< Number of suspect packets at previous delta.
+
+        //!
+        //! Get the TS bitrate since the previous interval delta.
+        //! @return The user-specified bitrate if there is one. Otherwise, the TS bitrate
+        //! from the PCR's since the previous delta or, if there was none, from all PCR's.
+        //!
+        BitRate deltaBitrate() const;
+
+        //!
+        //! Start a new interval delta: forget all changes and record the current counters.
+        //! Only the contexts which changed since the previous delta are updated.
+        //!
+        void restartDelta();
+
     private:
         // Constant string "Unreferenced"
         static const UString UNREFERENCED;
 
         // Check if a PID context exists.
-        bool pidExists(PID pid) const {return _pids.find(pid) != _pids.end();}
+        bool pidExists(PID pid) const {return _pid_cache[pid] != nullptr || _pids.find(pid) != _pids.end();}
 
         // Return a PID context. Allocate a new entry if PID not found.
         PIDContextPtr getPID(PID pid, const UString& description = UNREFERENCED);
@@ -459,6 +567,16 @@ namespace ts {
         // Return a service context. Allocate a new entry if service not found.
         ServiceContextPtr getService(uint16_t service_id);
 
+        // Merge the context of a PID from the next part of the stream.
+        void mergePID(PIDContext& pc, const PIDContext& next);
+
+        // Check if a sampling window starts after packet index 'from' and up to packet index 'to'.
+        bool crossesSamplingWindow(PacketCounter from, PacketCounter to) const;
+
+        // Record a PID or a service as changed since the previous interval delta.
+        void trackPID(const PIDContextPtr& pc);
+        void trackService(uint16_t service_id);
+
         // Analyze the various PSI tables
         void analyzePAT(const PAT&);
         void analyzeCAT(const CAT&);
@@ -497,13 +615,21 @@ namespace ts {
 
         // TSAnalyzer private members (state data, used during analysis):
         bool              _modified;                  // Internal data modified, need recomputeStatistics
+        bool              _warming_up;                // Packets are fed by warmUp(), don't count them
         uint64_t          _ts_bitrate_sum;            // Sum of all computed TS bitrates
         uint64_t          _ts_bitrate_cnt;            // Number of computed TS bitrates
+        uint64_t          _delta_bitrate_sum;         // Value of _ts_bitrate_sum at previous delta
+        uint64_t          _delta_bitrate_cnt;         // Value of _ts_bitrate_cnt at previous delta
         uint64_t          _preceding_errors;          // Number of contiguous invalid packets before current packet
         uint64_t          _preceding_suspects;        // Number of contiguous suspects packets before current packet
         uint64_t          _min_error_before_suspect;  // Required number of invalid packets before starting suspect
         uint64_t          _max_consecutive_suspects;  // Max number of consecutive suspect packets before clearing suspect
         const DVBCharset* _default_charset;           // Default DVB character set to use
+        TSAnalyzerOptions::AnalysisLevel _level;      // Analysis level
+        PacketCounter     _sampling_period;           // Distance between the starts of two sampling windows
+        PacketCounter     _sampling_window;           // Size of a sampling window
+        bool              _sampling;                  // Current packet is in a sampling window
+        PIDContext*       _pid_cache[PID_MAX];        // Direct access to the contexts in _pids, null if not yet known
         SectionDemux      _demux;                     // PSI tables analysis
         PESDemux          _pes_demux;                 // Audio/video analysis
         T2MIDemux         _t2mi_demux;                // T2-MI analysis
@@ -35,6 +35,17 @@
 #include "tsException.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::PacketCounter ts::TSAnalyzerOptions::DEFAULT_SAMPLING_PERIOD;
+const ts::PacketCounter ts::TSAnalyzerOptions::DEFAULT_SAMPLING_WINDOW;
+#endif
+
+const ts::Enumeration ts::TSAnalyzerOptions::AnalysisLevelNames({
+    {u"full",    ts::TSAnalyzerOptions::FULL_ANALYSIS},
+    {u"light",   ts::TSAnalyzerOptions::LIGHT_ANALYSIS},
+    {u"minimal", ts::TSAnalyzerOptions::MINIMAL_ANALYSIS},
+});
+
 
 //----------------------------------------------------------------------------
 // Constructor.
@@ -48,6 +59,7 @@ ts::TSAnalyzerOptions::TSAnalyzerOptions() :
     table_analysis(false),
     error_analysis(false),
     normalized(false),
+    json(false),
     service_list(false),
     pid_list(false),
     global_pid_list(false),
@@ -59,7 +71,10 @@ ts::TSAnalyzerOptions::TSAnalyzerOptions() :
     title(),
     suspect_min_error_count(1),
     suspect_max_consecutive(1),
-    default_charset(nullptr)
+    default_charset(nullptr),
+    analysis_level(FULL_ANALYSIS),
+    sampling_period(DEFAULT_SAMPLING_PERIOD),
+    sampling_window(DEFAULT_SAMPLING_WINDOW)
 {
 }
 
@@ -101,6 +116,11 @@ void ts::TSAnalyzerOptions::defineOptions(Args& args) const
               u"Complete report about the transport stream, the services and the "
               u"PID's in a normalized output format (useful for automatic analysis).");
 
+    args.option(u"json");
+    args.help(u"json",
+              u"Complete report about the transport stream, the services, the PID's and "
+              u"the tables in JSON format (useful for automatic analysis).");
+
     args.option(u"service-list");
     args.help(u"service-list", u"Report the list of all service ids.");
 
@@ -174,6 +194,28 @@ void ts::TSAnalyzerOptions::defineOptions(Args& args) const
               u"typically the usual local character table for the region. This option "
               u"forces a non-standard character table. The available table names are " +
               UString::Join(DVBCharset::GetAllNames()) + u".");
+
+    args.option(u"analysis-level", 0, AnalysisLevelNames);
+    args.help(u"analysis-level",
+              u"Specify the depth of the analysis. With \"full\" (the default), all packets "
+              u"are fully analyzed. With \"light\", the PSI/SI are analyzed on all packets but "
+              u"the audio/video attributes and the T2-MI encapsulation are analyzed during "
+              u"sampling windows only. With \"minimal\", only the packet counters, bitrates, "
+              u"continuity and transport errors are computed on all packets, all tables are "
+              u"analyzed during sampling windows only. The table counts and repetition rates "
+              u"are then computed on sampling windows only. "
+              u"See options --sampling-period and --sampling-window.");
+
+    args.option(u"sampling-period", 0, Args::POSITIVE);
+    args.help(u"sampling-period",
+              u"With --analysis-level light or minimal, specify the distance in packets between "
+              u"the starts of two sampling windows. "
+              u"The default is " + UString::Decimal(DEFAULT_SAMPLING_PERIOD) + u" packets.");
+
+    args.option(u"sampling-window", 0, Args::POSITIVE);
+    args.help(u"sampling-window",
+              u"With --analysis-level light or minimal, specify the size in packets of a sampling window. "
+              u"The default is " + UString::Decimal(DEFAULT_SAMPLING_WINDOW) + u" packets.");
 }
 
 
@@ -190,6 +232,7 @@ void ts::TSAnalyzerOptions::load(Args& args)
     table_analysis = args.present(u"table-analysis");
     error_analysis = args.present(u"error-analysis");
     normalized = args.present(u"normalized");
+    json = args.present(u"json");
     service_list = args.present(u"service-list");
     pid_list = args.present(u"pid-list");
     global_pid_list = args.present(u"global-pid-list");
@@ -208,6 +251,14 @@ void ts::TSAnalyzerOptions::load(Args& args)
         args.error(u"invalid character set name '%s", {csName});
     }
 
+    // Analysis level and sampling.
+    analysis_level = args.enumValue<AnalysisLevel>(u"analysis-level", FULL_ANALYSIS);
+    sampling_period = args.intValue<PacketCounter>(u"sampling-period", DEFAULT_SAMPLING_PERIOD);
+    sampling_window = args.intValue<PacketCounter>(u"sampling-window", std::min(DEFAULT_SAMPLING_WINDOW, sampling_period));
+    if (sampling_window > sampling_period) {
+        args.error(u"--sampling-window cannot be larger than --sampling-period");
+    }
+
     // Default: --ts-analysis --service-analysis --pid-analysis
     if (!ts_analysis &&
         !service_analysis &&
@@ -215,6 +266,7 @@ void ts::TSAnalyzerOptions::load(Args& args)
         !table_analysis &&
         !error_analysis &&
         !normalized &&
+        !json &&
         !service_list &&
         !pid_list &&
         !global_pid_list &&
@@ -35,6 +35,7 @@
 #pragma once
 #include "tsArgs.h"
 #include "tsDVBCharset.h"
+#include "tsEnumeration.h"
 
 namespace ts {
     //!
@@ -57,6 +58,30 @@ namespace ts {
         //!
         virtual ~TSAnalyzerOptions() {}
 
+        //!
+        //! Analysis levels, from the most complete to the cheapest.
+        //!
+        enum AnalysisLevel {
+            FULL_ANALYSIS,     //!< All packets are fully analyzed (the default).
+            LIGHT_ANALYSIS,    //!< PSI/SI on all packets, audio/video attributes and T2-MI in sampling windows only.
+            MINIMAL_ANALYSIS,  //!< Counters and errors on all packets, PSI/SI, audio/video and T2-MI in sampling windows only.
+        };
+
+        //!
+        //! Names of analysis levels, as used in command line options.
+        //!
+        static const Enumeration AnalysisLevelNames;
+
+        //!
+        //! Default distance between the starts of two sampling windows, in packets.
+        //!
+        static const PacketCounter DEFAULT_SAMPLING_PERIOD = 500000;
+
+        //!
+        //! Default size of a sampling window, in packets.
+        //!
+        static const PacketCounter DEFAULT_SAMPLING_WINDOW = 50000;
+
         // Full analysis options:
         bool ts_analysis;            //!< Option -\-ts-analysis
         bool service_analysis;       //!< Option -\-service-analysis
@@ -67,6 +92,7 @@ namespace ts {
 
         // Normalized output:
         bool normalized;             //!< Option -\-normalized
+        bool json;                   //!< Option -\-json
 
         // One-line report options:
         bool service_list;           //!< Option -\-service-list
@@ -88,6 +114,11 @@ namespace ts {
         // Table analysis options
         const DVBCharset* default_charset;  //!< Option -\-default-charset
 
+        // Analysis level
+        AnalysisLevel analysis_level;       //!< Option -\-analysis-level
+        PacketCounter sampling_period;      //!< Option -\-sampling-period
+        PacketCounter sampling_window;      //!< Option -\-sampling-window
+
         //!
         //! Define command line options in an Args.
         //! @param [in,out] args Command line arguments to update.
@@ -61,6 +61,45 @@ TSDUCK_SOURCE;
 #define WIDE_PID_COL3   14   // PID list, column 3 (bitrate).
 
 
+//----------------------------------------------------------------------------
+// Helpers to build JSON objects.
+//----------------------------------------------------------------------------
+
+namespace {
+    void AddNumber(ts::json::Value& obj, const ts::UString& name, int64_t value)
+    {
+        obj.add(name, ts::json::ValuePtr(new ts::json::Number(value)));
+    }
+
+    void AddString(ts::json::Value& obj, const ts::UString& name, const ts::UString& value)
+    {
+        obj.add(name, ts::json::ValuePtr(new ts::json::String(value)));
+    }
+
+    void AddBoolean(ts::json::Value& obj, const ts::UString& name, bool value)
+    {
+        obj.add(name, value ? ts::json::ValuePtr(new ts::json::True) : ts::json::ValuePtr(new ts::json::False));
+    }
+
+    void AddTime(ts::json::Value& obj, const ts::UString& name, const ts::Time& time)
+    {
+        if (time != ts::Time::Epoch) {
+            AddString(obj, name, time.format(ts::Time::DATE | ts::Time::TIME));
+        }
+    }
+
+    template <class CONTAINER>
+    ts::json::ValuePtr NumberArray(const CONTAINER& values)
+    {
+        ts::json::ValuePtr arr(new ts::json::Array);
+        for (typename CONTAINER::const_iterator it = values.begin(); it != values.end(); ++it) {
+            arr->set(ts::json::ValuePtr(new ts::json::Number(int64_t(*it))));
+        }
+        return arr;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Set analysis options. Must be set before feeding the first packet.
 //----------------------------------------------------------------------------
@@ -70,6 +109,7 @@ void ts::TSAnalyzerReport::setAnalysisOptions(const TSAnalyzerOptions& opt)
     setMinErrorCountBeforeSuspect(opt.suspect_min_error_count);
     setMaxConsecutiveSuspectCount(opt.suspect_max_consecutive);
     setDefaultCharacterSet(opt.default_charset);
+    setAnalysisLevel(opt.analysis_level, opt.sampling_period, opt.sampling_window);
 }
 
 
@@ -166,6 +206,11 @@ void ts::TSAnalyzerReport::report(std::ostream& stm, const TSAnalyzerOptions& op
     if (opt.normalized) {
         reportNormalized(stm, opt.title);
     }
+
+    // JSON report.
+    if (opt.json) {
+        reportJSON(stm, opt.title);
+    }
 }
 
 
@@ -1012,3 +1057,331 @@ void ts::TSAnalyzerReport::reportNormalized(std::ostream& stm, const UString& ti
         }
     }
 }
+
+
+//----------------------------------------------------------------------------
+// This method displays a JSON report.
+//----------------------------------------------------------------------------
+
+void ts::TSAnalyzerReport::reportJSON(std::ostream& stm, const UString& title)
+{
+    stm << jsonReport(title)->printed() << std::endl;
+}
+
+
+//----------------------------------------------------------------------------
+// Build a JSON description of the complete analysis.
+//----------------------------------------------------------------------------
+
+ts::json::ValuePtr ts::TSAnalyzerReport::jsonReport(const UString& title)
+{
+    // Update the global statistics value if internal data were modified.
+    recomputeStatistics();
+
+    json::ValuePtr root(new json::Object);
+    if (!title.empty()) {
+        AddString(*root, u"title", title);
+    }
+
+    // Transport stream description.
+    json::ValuePtr ts(new json::Object);
+    if (_ts_id_valid) {
+        AddNumber(*ts, u"id", _ts_id);
+    }
+    AddNumber(*ts, u"packets", _ts_pkt_cnt);
+    AddNumber(*ts, u"bytes", PKT_SIZE * _ts_pkt_cnt);
+    AddNumber(*ts, u"bitrate", _ts_bitrate);
+    AddNumber(*ts, u"bitrate-204", ToBitrate204(_ts_bitrate));
+    AddNumber(*ts, u"user-bitrate", _ts_user_bitrate);
+    AddNumber(*ts, u"pcr-bitrate", _ts_pcr_bitrate_188);
+    AddNumber(*ts, u"pcr-bitrate-204", _ts_pcr_bitrate_204);
+    AddNumber(*ts, u"duration-ms", _duration);
+    AddNumber(*ts, u"invalid-syncs", _invalid_sync);
+    AddNumber(*ts, u"transport-errors", _transport_errors);
+    AddNumber(*ts, u"suspect-ignored", _suspect_ignored);
+    AddNumber(*ts, u"services", _services.size());
+    AddNumber(*ts, u"scrambled-services", _scrambled_services_cnt);
+    AddNumber(*ts, u"pids", _pid_cnt);
+    AddNumber(*ts, u"scrambled-pids", _scrambled_pid_cnt);
+    AddNumber(*ts, u"pcr-pids", _pcr_pid_cnt);
+    AddNumber(*ts, u"unreferenced-pids", _unref_pid_cnt);
+    if (!_country_code.empty()) {
+        AddString(*ts, u"country", _country_code);
+    }
+    json::ValuePtr time(new json::Object);
+    AddTime(*time, u"tdt-first", _first_tdt);
+    AddTime(*time, u"tdt-last", _last_tdt);
+    AddTime(*time, u"tot-first", _first_tot);
+    AddTime(*time, u"tot-last", _last_tot);
+    AddTime(*time, u"system-utc-first", _first_utc);
+    AddTime(*time, u"system-utc-last", _last_utc);
+    AddTime(*time, u"system-local-first", _first_local);
+    AddTime(*time, u"system-local-last", _last_local);
+    ts->add(u"time", time);
+    root->add(u"ts", ts);
+
+    // Global and unreferenced PID's.
+    root->add(u"global", jsonPIDGroup(_global_pid_cnt, _global_scr_pids, _global_pkt_cnt, _global_bitrate, true));
+    root->add(u"unreferenced", jsonPIDGroup(_unref_pid_cnt, _unref_scr_pids, _unref_pkt_cnt, _unref_bitrate, false));
+
+    // Services.
+    json::ValuePtr services(new json::Array);
+    for (ServiceContextMap::const_iterator it = _services.begin(); it != _services.end(); ++it) {
+        services->set(jsonService(*it->second, true));
+    }
+    root->add(u"services", services);
+
+    // PID's.
+    json::ValuePtr pids(new json::Array);
+    for (PIDContextMap::const_iterator it = _pids.begin(); it != _pids.end(); ++it) {
+        const PIDContext& pc(*it->second);
+        if (pc.ts_pkt_cnt == 0 && pc.optional) {
+            continue;
+        }
+        json::ValuePtr pid(jsonPIDDescription(pc));
+        AddNumber(*pid, u"bitrate", pc.bitrate);
+        AddNumber(*pid, u"bitrate-204", ToBitrate204(pc.bitrate));
+        AddNumber(*pid, u"packets", pc.ts_pkt_cnt);
+        AddNumber(*pid, u"clear-packets", pc.ts_pkt_cnt - pc.ts_sc_cnt - pc.inv_ts_sc_cnt);
+        AddNumber(*pid, u"scrambled-packets", pc.ts_sc_cnt);
+        AddNumber(*pid, u"invalid-scrambling", pc.inv_ts_sc_cnt);
+        AddNumber(*pid, u"adaptation-fields", pc.ts_af_cnt);
+        AddNumber(*pid, u"pcr", pc.pcr_cnt);
+        AddNumber(*pid, u"discontinuities", pc.unexp_discont);
+        AddNumber(*pid, u"expected-discontinuities", pc.exp_discont);
+        AddNumber(*pid, u"duplicated", pc.duplicated);
+        if (pc.carry_pes) {
+            AddNumber(*pid, u"pes", pc.pl_start_cnt);
+            AddNumber(*pid, u"invalid-pes-prefix", pc.inv_pes_start);
+        }
+        else {
+            AddNumber(*pid, u"unit-start", pc.unit_start_cnt);
+        }
+        if (pc.crypto_period != 0 && _ts_bitrate != 0) {
+            AddNumber(*pid, u"crypto-period-ms", (pc.crypto_period * PKT_SIZE * 8 * 1000) / _ts_bitrate);
+        }
+        pids->set(pid);
+    }
+    root->add(u"pids", pids);
+
+    // Tables.
+    json::ValuePtr tables(new json::Array);
+    for (PIDContextMap::const_iterator pci = _pids.begin(); pci != _pids.end(); ++pci) {
+        const PIDContext& pc(*pci->second);
+        for (ETIDContextMap::const_iterator it = pc.sections.begin(); it != pc.sections.end(); ++it) {
+            const ETIDContext& etc(*it->second);
+            json::ValuePtr table(jsonTable(pc.pid, etc));
+            AddNumber(*table, u"repetition-pkt", etc.repetition_ts);
+            AddNumber(*table, u"min-repetition-pkt", etc.min_repetition_ts);
+            AddNumber(*table, u"max-repetition-pkt", etc.max_repetition_ts);
+            if (_ts_bitrate != 0) {
+                AddNumber(*table, u"repetition-ms", PacketInterval(_ts_bitrate, etc.repetition_ts));
+                AddNumber(*table, u"min-repetition-ms", PacketInterval(_ts_bitrate, etc.min_repetition_ts));
+                AddNumber(*table, u"max-repetition-ms", PacketInterval(_ts_bitrate, etc.max_repetition_ts));
+            }
+            tables->set(table);
+        }
+    }
+    root->add(u"tables", tables);
+
+    return root;
+}
+
+
+//----------------------------------------------------------------------------
+// Build a JSON description of the changes since the previous delta.
+//----------------------------------------------------------------------------
+
+ts::json::ValuePtr ts::TSAnalyzerReport::jsonDelta(const UString& title)
+{
+    const BitRate bitrate = deltaBitrate();
+    const uint64_t packets = _ts_pkt_cnt - _delta_ts_pkt_cnt;
+
+    json::ValuePtr root(new json::Object);
+    if (!title.empty()) {
+        AddString(*root, u"title", title);
+    }
+    AddTime(*root, u"time", Time::CurrentUTC());
+
+    // Transport stream counters during the interval.
+    json::ValuePtr ts(new json::Object);
+    if (_ts_id_valid) {
+        AddNumber(*ts, u"id", _ts_id);
+    }
+    AddNumber(*ts, u"packets", packets);
+    AddNumber(*ts, u"total-packets", _ts_pkt_cnt);
+    AddNumber(*ts, u"bitrate", bitrate);
+    AddNumber(*ts, u"invalid-syncs", _invalid_sync - _delta_invalid_sync);
+    AddNumber(*ts, u"transport-errors", _transport_errors - _delta_transport_errors);
+    AddNumber(*ts, u"suspect-ignored", _suspect_ignored - _delta_suspect_ignored);
+    root->add(u"ts", ts);
+
+    // PID's with packets or new description during the interval.
+    json::ValuePtr pids(new json::Array);
+    for (std::vector<PIDContextPtr>::const_iterator it = _delta_pids.begin(); it != _delta_pids.end(); ++it) {
+        const PIDContext& pc(**it);
+        const uint64_t count = pc.ts_pkt_cnt - pc.delta_ts_pkt_cnt;
+        json::ValuePtr pid(jsonPIDDescription(pc));
+        AddBoolean(*pid, u"new", !pc.delta_reported);
+        AddNumber(*pid, u"packets", count);
+        AddNumber(*pid, u"bitrate", packets == 0 ? 0 : (uint64_t(bitrate) * count) / packets);
+        AddNumber(*pid, u"scrambled-packets", pc.ts_sc_cnt - pc.delta_ts_sc_cnt);
+        AddNumber(*pid, u"invalid-scrambling", pc.inv_ts_sc_cnt - pc.delta_inv_ts_sc_cnt);
+        AddNumber(*pid, u"pcr", pc.pcr_cnt - pc.delta_pcr_cnt);
+        AddNumber(*pid, u"discontinuities", pc.unexp_discont - pc.delta_unexp_discont);
+        AddNumber(*pid, u"duplicated", pc.duplicated - pc.delta_duplicated);
+        pids->set(pid);
+    }
+    root->add(u"pids", pids);
+
+    // Services with new PSI/SI during the interval.
+    json::ValuePtr services(new json::Array);
+    for (ServiceIdSet::const_iterator it = _delta_services.begin(); it != _delta_services.end(); ++it) {
+        const ServiceContextMap::const_iterator sci(_services.find(*it));
+        if (sci != _services.end()) {
+            services->set(jsonService(*sci->second, false));
+        }
+    }
+    root->add(u"services", services);
+
+    // New tables and new versions of tables during the interval.
+    json::ValuePtr tables(new json::Array);
+    for (std::vector<DeltaTable>::const_iterator it = _delta_tables.begin(); it != _delta_tables.end(); ++it) {
+        json::ValuePtr table(jsonTable(it->first, *it->second));
+        AddBoolean(*table, u"new", it->second->first_pkt > _delta_ts_pkt_cnt);
+        tables->set(table);
+    }
+    root->add(u"tables", tables);
+
+    restartDelta();
+    return root;
+}
+
+
+//----------------------------------------------------------------------------
+// Build JSON descriptions of the analysis contexts.
+//----------------------------------------------------------------------------
+
+ts::json::ValuePtr ts::TSAnalyzerReport::jsonPIDGroup(size_t pid_cnt, size_t scr_pids, uint64_t pkt_cnt, BitRate bitrate, bool global) const
+{
+    json::ValuePtr group(new json::Object);
+    AddNumber(*group, u"pids", pid_cnt);
+    AddNumber(*group, u"clear-pids", pid_cnt - scr_pids);
+    AddNumber(*group, u"scrambled-pids", scr_pids);
+    AddNumber(*group, u"packets", pkt_cnt);
+    AddNumber(*group, u"bitrate", bitrate);
+    AddNumber(*group, u"bitrate-204", ToBitrate204(bitrate));
+    std::vector<PID> list;
+    for (PIDContextMap::const_iterator it = _pids.begin(); it != _pids.end(); ++it) {
+        const PIDContext& pc(*it->second);
+        if (pc.referenced == global && (!global || pc.services.empty()) && (pc.ts_pkt_cnt != 0 || !pc.optional)) {
+            list.push_back(pc.pid);
+        }
+    }
+    group->add(u"pid-list", NumberArray(list));
+    return group;
+}
+
+ts::json::ValuePtr ts::TSAnalyzerReport::jsonService(const ServiceContext& sv, bool statistics) const
+{
+    json::ValuePtr service(new json::Object);
+    AddNumber(*service, u"id", sv.service_id);
+    if (_ts_id_valid) {
+        AddNumber(*service, u"tsid", _ts_id);
+    }
+    AddNumber(*service, u"orig-network-id", sv.orig_netw_id);
+    AddNumber(*service, u"type", sv.service_type);
+    AddString(*service, u"name", sv.name);
+    AddString(*service, u"provider", sv.provider);
+    if (sv.pmt_pid != 0) {
+        AddNumber(*service, u"pmt-pid", sv.pmt_pid);
+    }
+    if (sv.pcr_pid != 0 && sv.pcr_pid != PID_NULL) {
+        AddNumber(*service, u"pcr-pid", sv.pcr_pid);
+    }
+    AddBoolean(*service, u"ssu", sv.carry_ssu);
+    AddBoolean(*service, u"t2mi", sv.carry_t2mi);
+
+    // Statistics are valid after recomputeStatistics() only.
+    if (statistics) {
+        AddBoolean(*service, u"scrambled", sv.scrambled_pid_cnt > 0);
+        AddNumber(*service, u"pids", sv.pid_cnt);
+        AddNumber(*service, u"scrambled-pids", sv.scrambled_pid_cnt);
+        AddNumber(*service, u"packets", sv.ts_pkt_cnt);
+        AddNumber(*service, u"bitrate", sv.bitrate);
+        AddNumber(*service, u"bitrate-204", ToBitrate204(sv.bitrate));
+        std::vector<PID> list;
+        for (PIDContextMap::const_iterator it = _pids.begin(); it != _pids.end(); ++it) {
+            if (it->second->services.count(sv.service_id) != 0) {
+                list.push_back(it->first);
+            }
+        }
+        service->add(u"pid-list", NumberArray(list));
+    }
+    return service;
+}
+
+ts::json::ValuePtr ts::TSAnalyzerReport::jsonPIDDescription(const PIDContext& pc) const
+{
+    json::ValuePtr pid(new json::Object);
+    AddNumber(*pid, u"id", pc.pid);
+    AddString(*pid, u"description", pc.fullDescription(true));
+    AddBoolean(*pid, u"referenced", pc.referenced);
+    AddBoolean(*pid, u"global", pc.referenced && pc.services.empty());
+    AddBoolean(*pid, u"scrambled", pc.scrambled);
+    AddBoolean(*pid, u"pmt", pc.is_pmt_pid);
+    AddBoolean(*pid, u"pcr-pid", pc.is_pcr_pid);
+    AddBoolean(*pid, u"ecm", pc.carry_ecm);
+    AddBoolean(*pid, u"emm", pc.carry_emm);
+    AddBoolean(*pid, u"audio", pc.carry_audio);
+    AddBoolean(*pid, u"video", pc.carry_video);
+    AddBoolean(*pid, u"t2mi", pc.carry_t2mi);
+    if (pc.cas_id != 0) {
+        AddNumber(*pid, u"cas", pc.cas_id);
+    }
+    if (!pc.cas_operators.empty()) {
+        pid->add(u"operators", NumberArray(pc.cas_operators));
+    }
+    if (pc.same_stream_id) {
+        AddNumber(*pid, u"stream-id", pc.pes_stream_id);
+    }
+    if (!pc.language.empty()) {
+        AddString(*pid, u"language", pc.language);
+    }
+    pid->add(u"services", NumberArray(pc.services));
+    if (!pc.ssu_oui.empty()) {
+        pid->add(u"ssu-oui", NumberArray(pc.ssu_oui));
+    }
+    if (!pc.t2mi_plp_ts.empty()) {
+        std::vector<uint8_t> plps;
+        for (std::map<uint8_t, uint64_t>::const_iterator it = pc.t2mi_plp_ts.begin(); it != pc.t2mi_plp_ts.end(); ++it) {
+            plps.push_back(it->first);
+        }
+        pid->add(u"plp", NumberArray(plps));
+    }
+    return pid;
+}
+
+ts::json::ValuePtr ts::TSAnalyzerReport::jsonTable(PID pid, const ETIDContext& etc) const
+{
+    json::ValuePtr table(new json::Object);
+    AddNumber(*table, u"pid", pid);
+    AddNumber(*table, u"tid", etc.etid.tid());
+    if (etc.etid.isLongSection()) {
+        AddNumber(*table, u"tid-ext", etc.etid.tidExt());
+    }
+    AddNumber(*table, u"tables", etc.table_count);
+    AddNumber(*table, u"sections", etc.section_count);
+    if (etc.versions.any()) {
+        AddNumber(*table, u"first-version", etc.first_version);
+        AddNumber(*table, u"last-version", etc.last_version);
+        std::vector<size_t> versions;
+        for (size_t i = 0; i < etc.versions.size(); ++i) {
+            if (etc.versions.test(i)) {
+                versions.push_back(i);
+            }
+        }
+        table->add(u"versions", NumberArray(versions));
+    }
+    return table;
+}
@@ -36,6 +36,7 @@
 #include "tsTSAnalyzer.h"
 #include "tsTSAnalyzerOptions.h"
 #include "tsGrid.h"
+#include "tsjson.h"
 
 namespace ts {
     //!
@@ -113,6 +114,31 @@ namespace ts {
         //!
         void reportNormalized(std::ostream& strm, const UString& title = UString());
 
+        //!
+        //! This methods displays a JSON report.
+        //! @param [in,out] strm Output text stream.
+        //! @param [in] title Title string to display.
+        //!
+        void reportJSON(std::ostream& strm, const UString& title = UString());
+
+        //!
+        //! Build a JSON description of the complete analysis.
+        //! @param [in] title Optional title string.
+        //! @return A JSON object.
+        //!
+        json::ValuePtr jsonReport(const UString& title = UString());
+
+        //!
+        //! Build a JSON description of the changes since the previous delta and start a new delta.
+        //! The delta contains the number of packets, bitrates and errors since the previous
+        //! delta for each PID which received packets and the new or changed services and tables.
+        //! The tracking of changes must be enabled using setDeltaTracking() before feeding the
+        //! first packet. Only the contexts which changed during the interval are browsed.
+        //! @param [in] title Optional title string.
+        //! @return A JSON object.
+        //!
+        json::ValuePtr jsonDelta(const UString& title = UString());
+
     private:
         // Display header of a service PID list.
         void reportServiceHeader(Grid& grid, const UString& usage, bool scrambled, BitRate bitrate, BitRate ts_bitrate, bool wide) const;
@@ -128,5 +154,11 @@ namespace ts {
 
         // Display one normalized line of a time value.
         static void reportNormalizedTime(std::ostream&, const Time&, const char* type, const UString& country = UString());
+
+        // Build JSON descriptions of the analysis contexts.
+        json::ValuePtr jsonPIDGroup(size_t pid_cnt, size_t scr_pids, uint64_t pkt_cnt, BitRate bitrate, bool global) const;
+        json::ValuePtr jsonService(const ServiceContext&, bool statistics) const;
+        json::ValuePtr jsonPIDDescription(const PIDContext&) const;
+        json::ValuePtr jsonTable(PID pid, const ETIDContext&) const;
     };
 }
@@ -34,8 +34,15 @@
 #include "tsTSFileInput.h"
 #include "tsNullReport.h"
 #include "tsSysUtils.h"
+#include "tsIntegerUtils.h"
+#include "tsSysInfo.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileInput::DEFAULT_ASYNC_BLOCK_SIZE;
+const size_t ts::TSFileInput::DEFAULT_MAP_WINDOW;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Default constructor.
@@ -52,11 +59,52 @@ ts::TSFileInput::TSFileInput() :
     _at_eof(false),
     _rewindable(false),
 #if defined(TS_WINDOWS)
-    _handle(INVALID_HANDLE_VALUE)
+    _handle(INVALID_HANDLE_VALUE),
 #else
-    _fd(-1)
+    _fd(-1),
 #endif
+    _async_depth(0),
+    _async_block(DEFAULT_ASYNC_BLOCK_SIZE),
+    _async_direct(false),
+    _uring(),
+    _async_offset(0),
+    _async_issue(0),
+    _async_next(0),
+    _async_skip(0),
+    _async_data(nullptr),
+    _async_size(0),
+    _async_eof(false),
+    _map_enabled(false),
+    _map_window(DEFAULT_MAP_WINDOW),
+    _map_base(nullptr),
+    _map_size(0),
+    _map_pos(0),
+    _map_ahead(0),
+    _map_buffer()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Use asynchronous read operations with io_uring.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::setAsyncIO(size_t depth, size_t block_size, bool direct)
 {
+    _async_depth = depth;
+    _async_block = std::max(block_size, PKT_SIZE);
+    _async_direct = direct;
+}
+
+
+//----------------------------------------------------------------------------
+// Read the file through a memory mapping.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::setMemoryMap(bool enable, size_t window)
+{
+    _map_enabled = enable;
+    _map_window = std::max(window, PKT_SIZE);
 }
 
 
@@ -169,13 +217,29 @@ bool ts::TSFileInput::openInternal (Report& report)
 
     // UNIX implementation
 
+    int flags = O_RDONLY | O_LARGEFILE;
+#if defined(TS_LINUX)
+    if (_async_depth > 0 && _async_direct) {
+        flags |= O_DIRECT;
+    }
+#endif
+
     if (_filename.empty()) {
         _fd = STDIN_FILENO;
     }
-    else if ((_fd = ::open(_filename.toUTF8().c_str(), O_RDONLY | O_LARGEFILE)) < 0) {
-        ErrorCode error_code = LastErrorCode();
-        report.log(_severity, u"cannot open file %s: %s", {_filename, ErrorCodeMessage(error_code)});
-        return false;
+    else {
+        _fd = ::open(_filename.toUTF8().c_str(), flags);
+#if defined(TS_LINUX)
+        // Some file systems do not support direct I/O.
+        if (_fd < 0 && (flags & O_DIRECT) != 0 && LastErrorCode() == EINVAL) {
+            _fd = ::open(_filename.toUTF8().c_str(), flags & ~O_DIRECT);
+        }
+#endif
+        if (_fd < 0) {
+            ErrorCode error_code = LastErrorCode();
+            report.log(_severity, u"cannot open file %s: %s", {_filename, ErrorCodeMessage(error_code)});
+            return false;
+        }
     }
 
     // If a repeat count or initial offset is specified, the input file
@@ -211,6 +275,12 @@ bool ts::TSFileInput::openInternal (Report& report)
         return false;
     }
 
+    // Use a memory mapping or asynchronous I/O when requested and possible.
+    startMap(report);
+    if (_map_base == nullptr) {
+        startAsync(report);
+    }
+
 #endif
 
     _is_open = true;
@@ -219,12 +289,251 @@ bool ts::TSFileInput::openInternal (Report& report)
 }
 
 
+//----------------------------------------------------------------------------
+// Start asynchronous I/O on the current file, if requested and possible.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::startAsync(Report& report)
+{
+#if defined(TS_UNIX)
+    if (_async_depth == 0 || _filename.empty()) {
+        return;
+    }
+
+    struct stat st;
+    if (::fstat(_fd, &st) == 0 && (S_ISREG(st.st_mode) || S_ISBLK(st.st_mode)) && _uring.open(_async_depth, _async_block, report)) {
+        report.debug(u"reading %s using io_uring, %d x %'d bytes", {_filename, _async_depth, _uring.bufferSize()});
+        resetAsync(_start_offset, report);
+        return;
+    }
+    report.verbose(u"asynchronous I/O not available on %s, using synchronous I/O", {_filename});
+
+#if defined(TS_LINUX)
+    // Synchronous reads at unaligned offsets are not possible with direct I/O.
+    const int flags = ::fcntl(_fd, F_GETFL);
+    if (_async_direct && flags >= 0 && (flags & O_DIRECT) != 0) {
+        ::fcntl(_fd, F_SETFL, flags & ~O_DIRECT);
+    }
+#endif
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Restart asynchronous reads at the specified file offset.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::resetAsync(uint64_t offset, Report& report)
+{
+    // Wait for all reads in flight, their data are no longer needed.
+    for (size_t i = 0; i < _uring.bufferCount(); ++i) {
+        int result = 0;
+        if (_uring.isBusy(i)) {
+            _uring.complete(i, result, report);
+        }
+    }
+
+    // Direct I/O requires aligned offsets, start reading on an aligned offset and skip the beginning.
+    _async_offset = RoundDown(offset, uint64_t(IOUring::BUFFER_ALIGNMENT));
+    _async_skip = size_t(offset - _async_offset);
+    _async_issue = _async_next = 0;
+    _async_data = nullptr;
+    _async_size = 0;
+    _async_eof = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Read data using asynchronous I/O. Same semantics as ::read().
+//----------------------------------------------------------------------------
+
+ssize_t ts::TSFileInput::readAsync(char* addr, size_t size)
+{
+    // Get the next buffer when the current one is exhausted.
+    while (_async_size == 0) {
+
+        // Start reads in all free buffers, in sequence, until end of file.
+        // The current buffer is exhausted and can be reused.
+        while (!_async_eof && !_uring.isBusy(_async_issue)) {
+            if (!_uring.read(_async_issue, _fd, _uring.bufferSize(), _async_offset, NULLREP)) {
+                errno = EIO;
+                return -1;
+            }
+            _async_offset += _uring.bufferSize();
+            _async_issue = (_async_issue + 1) % _uring.bufferCount();
+        }
+
+        // No more pending read, this is the end of file.
+        if (!_uring.isBusy(_async_next)) {
+            return 0;
+        }
+
+        // Wait for the next buffer in sequence.
+        const size_t index = _async_next;
+        int result = 0;
+        if (!_uring.complete(index, result, NULLREP)) {
+            errno = EIO;
+            return -1;
+        }
+        _async_next = (_async_next + 1) % _uring.bufferCount();
+        if (result < 0) {
+            errno = -result;
+            return -1;
+        }
+
+        // On regular files, a short read means end of file. All subsequent reads are beyond the end of file.
+        if (size_t(result) < _uring.bufferSize()) {
+            _async_eof = true;
+        }
+        const size_t skip = std::min(_async_skip, size_t(result));
+        _async_data = _uring.buffer(index) + skip;
+        _async_size = size_t(result) - skip;
+        _async_skip -= skip;
+    }
+
+    // Return data from current buffer.
+    const size_t count = std::min(size, _async_size);
+    ::memcpy(addr, _async_data, count);
+    _async_data += count;
+    _async_size -= count;
+    return ssize_t(count);
+}
+
+
+//----------------------------------------------------------------------------
+// Map the current file in memory, if requested and possible.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::startMap(Report& report)
+{
+#if defined(TS_UNIX)
+    if (!_map_enabled || _filename.empty()) {
+        return;
+    }
+
+    // Only non-empty regular files which fit in the address space can be mapped.
+    struct stat st;
+    if (::fstat(_fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || uint64_t(st.st_size) > uint64_t(std::numeric_limits<size_t>::max())) {
+        report.verbose(u"memory mapping not available on %s, using read operations", {_filename});
+        return;
+    }
+
+    // A shared read-only mapping uses the pages of the system cache, without copy.
+    void* addr = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, _fd, 0);
+    if (addr == MAP_FAILED) {
+        const ErrorCode error_code = LastErrorCode();
+        report.verbose(u"cannot map %s in memory, using read operations: %s", {_filename, ErrorCodeMessage(error_code)});
+        return;
+    }
+
+    _map_base = reinterpret_cast<uint8_t*>(addr);
+    _map_size = size_t(st.st_size);
+    _map_window = RoundUp(_map_window, SysInfo::Instance()->memoryPageSize());
+    _map_pos = size_t(std::min(_start_offset, uint64_t(_map_size)));
+    _map_ahead = RoundDown(_map_pos, _map_window);
+    report.debug(u"reading %s using a memory mapping, %'d bytes, read-ahead window: %'d bytes", {_filename, _map_size, _map_window});
+
+    // The file is read sequentially, pages can be freed after being read.
+    if (::madvise(_map_base, _map_size, MADV_SEQUENTIAL) < 0) {
+        const ErrorCode error_code = LastErrorCode();
+        report.debug(u"madvise error on %s: %s", {_filename, ErrorCodeMessage(error_code)});
+    }
+    adviseMap(report);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Unmap the current file.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::stopMap(Report& report)
+{
+#if defined(TS_UNIX)
+    if (_map_base != nullptr && ::munmap(_map_base, _map_size) < 0) {
+        const ErrorCode error_code = LastErrorCode();
+        report.log(_severity, u"error unmapping file %s: %s", {_filename, ErrorCodeMessage(error_code)});
+    }
+#endif
+    _map_base = nullptr;
+    _map_size = _map_pos = _map_ahead = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Prefetch the next window of the memory mapping.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInput::adviseMap(Report& report)
+{
+#if defined(TS_UNIX)
+    // Always keep the window after the current one in progress.
+    const size_t end = std::min(RoundDown(_map_pos, _map_window) + 2 * _map_window, _map_size);
+    if (_map_ahead < end) {
+        if (::madvise(_map_base + _map_ahead, end - _map_ahead, MADV_WILLNEED) < 0) {
+            const ErrorCode error_code = LastErrorCode();
+            report.debug(u"madvise error on %s: %s", {_filename, ErrorCodeMessage(error_code)});
+        }
+        _map_ahead = end;
+    }
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Get next packets in memory mapping. Handle repetition.
+//----------------------------------------------------------------------------
+
+size_t ts::TSFileInput::nextMapped(const TSPacket*& packets, size_t max_packets, Report& report)
+{
+    while (!_at_eof) {
+
+        // Return as many contiguous packets as possible.
+        const size_t count = std::min(max_packets, (_map_size - _map_pos) / PKT_SIZE);
+        if (count > 0) {
+            packets = reinterpret_cast<const TSPacket*>(_map_base + _map_pos);
+            _map_pos += count * PKT_SIZE;
+            adviseMap(report);
+            return count;
+        }
+        else if (max_packets == 0) {
+            break;
+        }
+
+        // At end of file, a trailing partial packet is ignored.
+        // Rewind to original start offset if the file must be repeated again.
+        _at_eof = true;
+        if ((_repeat == 0 || ++_counter < _repeat) && seekInternal(0, report) && _map_size - _map_pos < PKT_SIZE) {
+            // Nothing to read after start offset, avoid infinite loop.
+            _at_eof = true;
+        }
+    }
+    return 0;
+}
+
+
 //----------------------------------------------------------------------------
 // Internal seek. Rewind to specified start offset plus specified index.
 //----------------------------------------------------------------------------
 
 bool ts::TSFileInput::seekInternal(uint64_t index, Report& report)
 {
+    if (_map_base != nullptr) {
+        _map_pos = size_t(std::min(_start_offset + index, uint64_t(_map_size)));
+        _map_ahead = RoundDown(_map_pos, _map_window);
+        adviseMap(report);
+        _at_eof = false;
+        return true;
+    }
+
+#if defined(TS_UNIX)
+    if (_uring.isOpen()) {
+        resetAsync(_start_offset + index, report);
+        _at_eof = false;
+        return true;
+    }
+#endif
+
 #if defined (TS_WINDOWS)
     // In Win32, LARGE_INTEGER is a 64-bit structure, not an integer type
     uint64_t where = _start_offset + index;
@@ -276,6 +585,11 @@ bool ts::TSFileInput::close(Report& report)
         return false;
     }
 
+    // Wait for asynchronous reads in flight before closing the file.
+    _uring.close(report);
+    stopMap(report);
+    _map_buffer.clear();
+
     if (!_filename.empty()) {
 #if defined (TS_WINDOWS)
         ::CloseHandle(_handle);
@@ -308,6 +622,19 @@ size_t ts::TSFileInput::read(TSPacket* buffer, size_t max_packets, Report& repor
         return 0;
     }
 
+    // With a memory mapping, copy packets from the mapping.
+    if (_map_base != nullptr) {
+        size_t count = 0;
+        const TSPacket* packets = nullptr;
+        size_t got = 0;
+        while (count < max_packets && (got = nextMapped(packets, max_packets - count, report)) > 0) {
+            TSPacket::Copy(buffer + count, packets, got);
+            count += got;
+        }
+        _total_packets += count;
+        return count;
+    }
+
     char* data = reinterpret_cast <char*> (buffer);
     const size_t req_size = max_packets * PKT_SIZE;
     size_t got_size = 0;
@@ -333,7 +660,7 @@ size_t ts::TSFileInput::read(TSPacket* buffer, size_t max_packets, Report& repor
         }
 #else
         // UNIX implementation
-        ssize_t insize = ::read(_fd, data + got_size, req_size - got_size);
+        ssize_t insize = _uring.isOpen() ? readAsync(data + got_size, req_size - got_size) : ::read(_fd, data + got_size, req_size - got_size);
         if (insize > 0) {
             // Normal case: some data were read
             got_size += insize;
@@ -372,6 +699,32 @@ size_t ts::TSFileInput::read(TSPacket* buffer, size_t max_packets, Report& repor
     return count;
 }
 
+//----------------------------------------------------------------------------
+// Read TS packets without copy.
+//----------------------------------------------------------------------------
+
+size_t ts::TSFileInput::readMapped(const TSPacket*& packets, size_t max_packets, Report& report)
+{
+    if (!_is_open) {
+        report.log(_severity, u"not open");
+        return 0;
+    }
+    else if (_map_base == nullptr) {
+        // Not memory-mapped, read packets in the internal buffer.
+        if (_map_buffer.size() < max_packets) {
+            _map_buffer.resize(max_packets);
+        }
+        packets = _map_buffer.data();
+        return read(_map_buffer.data(), max_packets, report);
+    }
+    else {
+        const size_t count = nextMapped(packets, max_packets, report);
+        _total_packets += count;
+        return count;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Abort any currenly read operation in progress.
 //----------------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #pragma once
 #include "tsTSPacket.h"
 #include "tsReport.h"
+#include "tsIOUring.h"
 
 namespace ts {
     //!
@@ -44,6 +45,16 @@ namespace ts {
     class TSDUCKDLL TSFileInput
     {
     public:
+        //!
+        //! Default size in bytes of asynchronous read operations.
+        //!
+        static const size_t DEFAULT_ASYNC_BLOCK_SIZE = 1024 * 1024;
+
+        //!
+        //! Default size in bytes of the read-ahead window in memory-mapped mode.
+        //!
+        static const size_t DEFAULT_MAP_WINDOW = 8 * 1024 * 1024;
+
         //!
         //! Default constructor.
         //!
@@ -82,6 +93,41 @@ namespace ts {
         //!
         bool open(const UString& filename, uint64_t start_offset, Report& report);
 
+        //!
+        //! Use asynchronous read operations with io_uring (Linux only).
+        //! Several large read operations are kept in flight in the background.
+        //! This must be called before open(). Asynchronous I/O are used with regular files only.
+        //! When io_uring is not supported by the system, the synchronous I/O are used.
+        //! @param [in] depth Number of read operations in flight. Zero means synchronous I/O (the default).
+        //! @param [in] block_size Size in bytes of each read operation.
+        //! @param [in] direct Use direct I/O (O_DIRECT), bypassing the system cache.
+        //! If the file system does not support direct I/O, the system cache is used.
+        //!
+        void setAsyncIO(size_t depth, size_t block_size = DEFAULT_ASYNC_BLOCK_SIZE, bool direct = false);
+
+        //!
+        //! Read the file through a memory mapping (UNIX only).
+        //! The complete file is mapped in the virtual memory of the process. The kernel is
+        //! informed that the access is sequential and the next window is prefetched while
+        //! the current one is read. Packets can be accessed in the mapping using readMapped(),
+        //! without copy. This must be called before open() and takes precedence over setAsyncIO().
+        //! Memory mapping is used with regular files only, other files are read using read operations.
+        //! The size of the file is fixed when the file is opened, data which are appended later
+        //! by another process are ignored.
+        //! @param [in] enable When true, use a memory mapping.
+        //! @param [in] window Size in bytes of the read-ahead windows.
+        //!
+        void setMemoryMap(bool enable, size_t window = DEFAULT_MAP_WINDOW);
+
+        //!
+        //! Check if the file is currently read through a memory mapping.
+        //! @return True if the file is open and read through a memory mapping.
+        //!
+        bool isMemoryMapped() const
+        {
+            return _map_base != nullptr;
+        }
+
         //!
         //! Check if the file is open.
         //! @return True if the file is open.
@@ -137,6 +183,22 @@ namespace ts {
         //!
         size_t read(TSPacket* buffer, size_t max_packets, Report& report);
 
+        //!
+        //! Read TS packets without copy.
+        //! When the file is memory-mapped, the returned packets are directly located in the
+        //! mapping. Otherwise, the packets are read in an internal buffer. In both cases,
+        //! the returned packets remain valid until the next read operation or until the file
+        //! is closed. Returned packets are contiguous. At end of file, when the file is repeated,
+        //! the packets from the end of file and the packets from the start of the next iteration
+        //! are returned in distinct calls.
+        //! @param [out] packets Address of the first returned packet.
+        //! @param [in] max_packets Maximum number of packets to return.
+        //! @param [in,out] report Where to report errors.
+        //! @return The actual number of returned packets. Returning zero means
+        //! error or end of file repetition.
+        //!
+        size_t readMapped(const TSPacket*& packets, size_t max_packets, Report& report);
+
         //!
         //! Abort any currenly read operation in progress.
         //! The file is left in a broken state and can be only closed.
@@ -192,6 +254,24 @@ namespace ts {
 #else
         int           _fd;            //!< File descriptor
 #endif
+        size_t        _async_depth;   //!< Number of asynchronous reads in flight, zero for synchronous I/O
+        size_t        _async_block;   //!< Size of asynchronous reads
+        bool          _async_direct;  //!< Use direct I/O with asynchronous reads
+        IOUring       _uring;         //!< Asynchronous I/O, open when used on the current file
+        uint64_t      _async_offset;  //!< File offset of the next asynchronous read to start
+        size_t        _async_issue;   //!< Index of next buffer to start reading
+        size_t        _async_next;    //!< Index of next buffer to return data from
+        size_t        _async_skip;    //!< Number of bytes to skip in next buffer (unaligned start offset)
+        const uint8_t* _async_data;   //!< Next data to return in current buffer
+        size_t        _async_size;    //!< Remaining data size in current buffer
+        bool          _async_eof;     //!< End of file reached in asynchronous reads
+        bool          _map_enabled;   //!< Use a memory mapping when possible
+        size_t        _map_window;    //!< Size of read-ahead windows in memory mapping
+        uint8_t*      _map_base;      //!< Base address of memory mapping, null if not mapped
+        size_t        _map_size;      //!< Size of memory mapping (file size)
+        size_t        _map_pos;       //!< Offset of next packet to read in memory mapping
+        size_t        _map_ahead;     //!< End offset of the last read-ahead window
+        TSPacketVector _map_buffer;   //!< Intermediate buffer for readMapped() when not memory-mapped
 
         // Inaccessible operations
         TSFileInput(const TSFileInput&) = delete;
@@ -200,5 +280,12 @@ namespace ts {
         // Internal methods
         bool openInternal(Report& report);
         bool seekInternal(uint64_t, Report& report);
+        void startAsync(Report& report);
+        void resetAsync(uint64_t offset, Report& report);
+        ssize_t readAsync(char* addr, size_t size);
+        void startMap(Report& report);
+        void stopMap(Report& report);
+        void adviseMap(Report& report);
+        size_t nextMapped(const TSPacket*& packets, size_t max_packets, Report& report);
     };
 }
@@ -215,9 +215,54 @@ size_t ts::TSFileInputBuffered::read (TSPacket* user_buffer, size_t max_packets,
     _in_packets += user_count;
 
     // Finally, read back the rest into our buffer. We do the exchanges that way
-    // to optimize the transfer. If the number of read packets is greater than
-    // our buffer size, it would be pointless to do many intermediate copies
-    // into our buffer.
+    // to optimize the transfer.
+    savePackets(user_buffer, user_count);
+
+    assert (_first_index < buffer_size);
+    assert (_current_offset <= _total_count);
+    assert (_total_count <= buffer_size);
+
+    return _in_packets;
+}
+
+
+//----------------------------------------------------------------------------
+// Read TS packets without copy. Override TSFileInput::readMapped().
+//----------------------------------------------------------------------------
+
+size_t ts::TSFileInputBuffered::readMapped(const TSPacket*& packets, size_t max_packets, Report& report)
+{
+    if (!isOpen()) {
+        report.error(u"file not open");
+        return 0;
+    }
+
+    // After a backward seek, return contiguous packets from the buffer.
+    if (_current_offset < _total_count) {
+        const size_t current_index = (_first_index + _current_offset) % _buffer.size();
+        const size_t count = std::min(max_packets, std::min(_total_count - _current_offset, _buffer.size() - current_index));
+        packets = &_buffer[current_index];
+        _current_offset += count;
+        return count;
+    }
+
+    // Otherwise, read from the file and keep the last packets in the buffer.
+    const size_t count = TSFileInput::readMapped(packets, max_packets, report);
+    savePackets(packets, count);
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Save packets which were read from the file into the seekable buffer.
+//----------------------------------------------------------------------------
+
+void ts::TSFileInputBuffered::savePackets(const TSPacket* user_buffer, size_t user_count)
+{
+    const size_t buffer_size = _buffer.size();
+
+    // If the number of read packets is greater than our buffer size,
+    // it would be pointless to do many intermediate copies into our buffer.
     if (user_count >= buffer_size) {
         // Completely replace the buffer content.
         TSPacket::Copy(&_buffer[0], user_buffer + user_count - buffer_size, buffer_size);
@@ -252,9 +297,4 @@ size_t ts::TSFileInputBuffered::read (TSPacket* user_buffer, size_t max_packets,
         }
     }
 
-    assert (_first_index < buffer_size);
-    assert (_current_offset <= _total_count);
-    assert (_total_count <= buffer_size);
-
-    return _in_packets;
 }
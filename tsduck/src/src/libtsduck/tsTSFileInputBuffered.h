@@ -126,6 +126,19 @@ namespace ts {
         //!
         size_t read(TSPacket* buffer, size_t max_packets, Report& report);
 
+        //!
+        //! Read TS packets without copy.
+        //! Override TSFileInput::readMapped(). After a backward seek, the packets are
+        //! returned from the seekable buffer. Otherwise, they are returned from the
+        //! file and the last packets are also saved in the seekable buffer.
+        //! @param [out] packets Address of the first returned packet.
+        //! @param [in] max_packets Maximum number of packets to return.
+        //! @param [in,out] report Where to report errors.
+        //! @return The actual number of returned packets. Returning zero means
+        //! error or end of file repetition.
+        //!
+        size_t readMapped(const TSPacket*& packets, size_t max_packets, Report& report);
+
         //!
         //! Get the backward seekable distance inside the buffer.
         //! This is the minimum guaranteed seekable distance.
@@ -197,5 +210,8 @@ namespace ts {
         TSFileInputBuffered(const TSFileInputBuffered&) = delete;
         TSFileInputBuffered& operator=(const TSFileInputBuffered&) = delete;
         bool rewind(Report&);
+
+        // Save packets which were read from the file into the seekable buffer.
+        void savePackets(const TSPacket* packets, size_t count);
     };
 }
@@ -34,11 +34,16 @@
 #include "tsTSFileOutput.h"
 #include "tsNullReport.h"
 #include "tsSysUtils.h"
+#include "tsIntegerUtils.h"
 TSDUCK_SOURCE;
 
 // File string for standard output.
 const ts::UString ts::TSFileOutput::stdoutName(u"standard output");
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileOutput::DEFAULT_ASYNC_BLOCK_SIZE;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Default constructor.
@@ -50,14 +55,33 @@ ts::TSFileOutput::TSFileOutput() :
     _severity(Severity::Error),
     _total_packets(0),
 #if defined(TS_WINDOWS)
-    _handle(INVALID_HANDLE_VALUE)
+    _handle(INVALID_HANDLE_VALUE),
 #else
-    _fd(-1)
+    _fd(-1),
 #endif
+    _async_depth(0),
+    _async_block(DEFAULT_ASYNC_BLOCK_SIZE),
+    _async_direct(false),
+    _uring(),
+    _async_offset(0),
+    _async_index(0),
+    _async_fill(0)
 {
 }
 
 
+//----------------------------------------------------------------------------
+// Use asynchronous write operations with io_uring.
+//----------------------------------------------------------------------------
+
+void ts::TSFileOutput::setAsyncIO(size_t depth, size_t block_size, bool direct)
+{
+    _async_depth = depth;
+    _async_block = std::max(block_size, PKT_SIZE);
+    _async_direct = direct;
+}
+
+
 //----------------------------------------------------------------------------
 // Open method
 //----------------------------------------------------------------------------
@@ -110,26 +134,45 @@ bool ts::TSFileOutput::open(const UString& filename, bool append, bool keep, Rep
     int flags = O_CREAT | O_WRONLY | O_LARGEFILE;
     const mode_t mode = 0666; // -rw-rw-rw (minus umask)
 
+    // With asynchronous I/O, the writes are done at explicit offsets, O_APPEND cannot be used.
+    const bool async = _async_depth > 0 && !_filename.empty();
+
     if (keep) {
         flags |= O_EXCL;
     }
     else if (append) {
-        flags |= O_APPEND;
+        flags |= async ? 0 : O_APPEND;
     }
     else {
         flags |= O_TRUNC;
     }
+#if defined(TS_LINUX)
+    if (async && _async_direct) {
+        flags |= O_DIRECT;
+    }
+#endif
 
     if (_filename.empty()) {
         _fd = STDOUT_FILENO;
     }
     else {
         _fd = ::open(_filename.toUTF8().c_str(), flags, mode);
+#if defined(TS_LINUX)
+        // Some file systems do not support direct I/O.
+        if (_fd < 0 && (flags & O_DIRECT) != 0 && LastErrorCode() == EINVAL) {
+            _fd = ::open(_filename.toUTF8().c_str(), flags & ~O_DIRECT, mode);
+        }
+#endif
         got_error = _fd < 0;
         error_code = LastErrorCode();
         report.debug(u"creating file %s, fd=%d, error_code=%d", {filename, _fd, error_code});
     }
 
+    // Use asynchronous I/O when requested and possible.
+    if (!got_error && async) {
+        startAsync(append, report);
+    }
+
 #endif
 
     if (got_error) {
@@ -152,6 +195,9 @@ bool ts::TSFileOutput::close(Report& report)
         return false;
     }
 
+    // Flush asynchronous writes before closing the file.
+    const bool ok = !_uring.isOpen() || stopAsync(report);
+
     if (!_filename.empty()) {
 #if defined (TS_WINDOWS)
         ::CloseHandle(_handle);
@@ -161,7 +207,7 @@ bool ts::TSFileOutput::close(Report& report)
     }
 
     _is_open = false;
-    return true;
+    return ok;
 }
 
 
@@ -187,6 +233,9 @@ bool ts::TSFileOutput::write(const TSPacket* buffer, size_t packet_count, Report
         report.log(_severity, u"not open");
         return false;
     }
+    if (_uring.isOpen()) {
+        return writeAsync(buffer, packet_count, report);
+    }
 
     // Loop on write until everything is gone
 
@@ -258,3 +307,148 @@ bool ts::TSFileOutput::write(const TSPacket* buffer, size_t packet_count, Report
     _total_packets += (data - data_buffer) / PKT_SIZE;
     return !got_error;
 }
+
+
+//----------------------------------------------------------------------------
+// Start asynchronous I/O on the current file, if requested and possible.
+//----------------------------------------------------------------------------
+
+void ts::TSFileOutput::startAsync(bool append, Report& report)
+{
+#if defined(TS_UNIX)
+    // Without O_APPEND, the writes start at end of file when appending.
+    const off_t end = append ? ::lseek(_fd, 0, SEEK_END) : 0;
+
+    struct stat st;
+    if (end >= 0 && ::fstat(_fd, &st) == 0 && S_ISREG(st.st_mode) && _uring.open(_async_depth, _async_block, report)) {
+        report.debug(u"writing %s using io_uring, %d x %'d bytes", {_filename, _async_depth, _uring.bufferSize()});
+        _async_offset = uint64_t(end);
+        _async_index = 0;
+        _async_fill = 0;
+    }
+    else {
+        report.verbose(u"asynchronous I/O not available on %s, using synchronous I/O", {_filename});
+    }
+
+#if defined(TS_LINUX)
+    // Direct I/O requires aligned offsets. Appending to a file with an unaligned size
+    // or writing synchronously (unaligned sizes) is not possible with direct I/O.
+    const int flags = ::fcntl(_fd, F_GETFL);
+    if (_async_direct && flags >= 0 && (flags & O_DIRECT) != 0 && (!_uring.isOpen() || _async_offset % IOUring::BUFFER_ALIGNMENT != 0)) {
+        report.debug(u"direct I/O not used on %s", {_filename});
+        ::fcntl(_fd, F_SETFL, flags & ~O_DIRECT);
+    }
+#endif
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Write using asynchronous I/O.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutput::writeAsync(const TSPacket* buffer, size_t packet_count, Report& report)
+{
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer);
+    size_t remain = packet_count * PKT_SIZE;
+
+    while (remain > 0) {
+        // Before filling a buffer, wait for the completion of its previous write.
+        if (_async_fill == 0 && _uring.isBusy(_async_index) && !completeAsync(_async_index, report)) {
+            return false;
+        }
+
+        // Fill the current buffer.
+        const size_t size = std::min(remain, _uring.bufferSize() - _async_fill);
+        ::memcpy(_uring.buffer(_async_index) + _async_fill, data, size);
+        _async_fill += size;
+        data += size;
+        remain -= size;
+
+        // Write the buffer when full and move to next one.
+        if (_async_fill == _uring.bufferSize()) {
+            if (!_uring.write(_async_index, _fd, _async_fill, _async_offset, report)) {
+                return false;
+            }
+            _async_offset += _async_fill;
+            _async_index = (_async_index + 1) % _uring.bufferCount();
+            _async_fill = 0;
+        }
+    }
+
+    _total_packets += packet_count;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Wait for the completion of a write operation.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutput::completeAsync(size_t index, Report& report)
+{
+    int result = 0;
+    if (!_uring.complete(index, result, report)) {
+        return false;
+    }
+    else if (result < 0) {
+        report.log(_severity, u"error writing %s: %s (%d)", {getDisplayFileName(), ErrorCodeMessage(-result), -result});
+        return false;
+    }
+    else if (size_t(result) < _uring.bufferSize()) {
+        // On regular files, a short write means that the file system is full.
+        report.log(_severity, u"error writing %s: incomplete write, %'d bytes instead of %'d", {getDisplayFileName(), result, _uring.bufferSize()});
+        return false;
+    }
+    else {
+        return true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Terminate asynchronous I/O, write the last partial buffer.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileOutput::stopAsync(Report& report)
+{
+    bool ok = true;
+
+    // Wait for all writes in flight.
+    for (size_t i = 0; i < _uring.bufferCount(); ++i) {
+        if (_uring.isBusy(i)) {
+            ok = completeAsync(i, report) && ok;
+        }
+    }
+
+#if defined(TS_UNIX)
+    // The last partial buffer has an unaligned size, write it synchronously, without direct I/O.
+    if (ok && _async_fill > 0) {
+#if defined(TS_LINUX)
+        const int flags = ::fcntl(_fd, F_GETFL);
+        if (flags >= 0 && (flags & O_DIRECT) != 0) {
+            ::fcntl(_fd, F_SETFL, flags & ~O_DIRECT);
+        }
+#endif
+        const uint8_t* data = _uring.buffer(_async_index);
+        size_t remain = _async_fill;
+        while (ok && remain > 0) {
+            const ssize_t outsize = ::pwrite(_fd, data, remain, off_t(_async_offset));
+            if (outsize > 0) {
+                data += outsize;
+                remain -= size_t(outsize);
+                _async_offset += uint64_t(outsize);
+            }
+            else if (LastErrorCode() != EINTR) {
+                const ErrorCode error_code = LastErrorCode();
+                report.log(_severity, u"error writing %s: %s (%d)", {getDisplayFileName(), ErrorCodeMessage(error_code), error_code});
+                ok = false;
+            }
+        }
+    }
+#endif
+
+    _async_fill = 0;
+    _uring.close(report);
+    return ok;
+}
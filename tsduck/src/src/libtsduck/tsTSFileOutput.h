@@ -35,6 +35,7 @@
 #pragma once
 #include "tsTSPacket.h"
 #include "tsReport.h"
+#include "tsIOUring.h"
 
 namespace ts {
     //!
@@ -44,6 +45,11 @@ namespace ts {
     class TSDUCKDLL TSFileOutput
     {
     public:
+        //!
+        //! Default size in bytes of asynchronous write operations.
+        //!
+        static const size_t DEFAULT_ASYNC_BLOCK_SIZE = 1024 * 1024;
+
         //!
         //! Default constructor.
         //!
@@ -64,6 +70,19 @@ namespace ts {
         //!
         virtual bool open(const UString& filename, bool append, bool keep, Report& report);
 
+        //!
+        //! Use asynchronous write operations with io_uring (Linux only).
+        //! The packets are accumulated in large buffers which are written in the background.
+        //! This must be called before open(). Asynchronous I/O are used with regular files only.
+        //! When io_uring is not supported by the system, the synchronous I/O are used.
+        //! Write errors may be reported by a subsequent call to write() or by close().
+        //! @param [in] depth Number of write buffers. Zero means synchronous I/O (the default).
+        //! @param [in] block_size Size in bytes of each write operation.
+        //! @param [in] direct Use direct I/O (O_DIRECT), bypassing the system cache.
+        //! If the file system does not support direct I/O, the system cache is used.
+        //!
+        void setAsyncIO(size_t depth, size_t block_size = DEFAULT_ASYNC_BLOCK_SIZE, bool direct = false);
+
         //!
         //! Close the file.
         //! @param [in,out] report Where to report errors.
@@ -142,8 +161,27 @@ namespace ts {
 #else
         int           _fd;                // File descriptor
 #endif
+        size_t        _async_depth;       // Number of asynchronous write buffers, zero for synchronous I/O
+        size_t        _async_block;       // Size of asynchronous writes
+        bool          _async_direct;      // Use direct I/O with asynchronous writes
+        IOUring       _uring;             // Asynchronous I/O, open when used on the current file
+        uint64_t      _async_offset;      // File offset of the next asynchronous write
+        size_t        _async_index;       // Index of the buffer being filled
+        size_t        _async_fill;        // Number of bytes in the buffer being filled
         static const UString stdoutName;  // File string for standard output.
 
+        // Start asynchronous I/O on the current file, if requested and possible.
+        void startAsync(bool append, Report& report);
+
+        // Write using asynchronous I/O.
+        bool writeAsync(const TSPacket* buffer, size_t packet_count, Report& report);
+
+        // Wait for the completion of a write operation.
+        bool completeAsync(size_t index, Report& report);
+
+        // Terminate asynchronous I/O, write the last partial buffer.
+        bool stopAsync(Report& report);
+
         // Inaccessible operations
         TSFileOutput(const TSFileOutput&) = delete;
         TSFileOutput& operator=(const TSFileOutput&) = delete;
@@ -0,0 +1,475 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream recording into segmented files with write-behind.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSFileRecorder.h"
+#include "tsGuard.h"
+#include "tsMonotonic.h"
+#include "tsNullReport.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSFileRecorder::DEFAULT_BUFFER_SIZE;
+#endif
+
+// PCR values wrap up after 2**33 units of 90 kHz.
+#define PCR_WRAP (PTS_DTS_SCALE * SYSTEM_CLOCK_SUBFACTOR)
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::TSFileRecorder::Statistics::Statistics() :
+    packets(0),
+    units(0),
+    files(0),
+    write_latency(),
+    buffer_size(0),
+    high_water(0)
+{
+}
+
+ts::TSFileRecorder::TSFileRecorder() :
+    Thread(),
+    _max_size(0),
+    _max_duration(0),
+    _pcr_time(false),
+    _indexing(false),
+    _sparse(false),
+    _buffer_size(0),
+    _filename(),
+    _append(false),
+    _keep(false),
+    _report(nullptr),
+    _is_open(false),
+    _error(false),
+    _file(),
+    _segment_bytes(0),
+    _segment_start(),
+    _pcr_pid(PID_NULL),
+    _segment_pcr(0),
+    _segment_pcr_ok(false),
+    _index(),
+    _index_name(),
+    _encoder(),
+    _units(),
+    _queue(),
+    _chunk(),
+    _mutex(),
+    _stats()
+{
+}
+
+ts::TSFileRecorder::~TSFileRecorder()
+{
+    if (_is_open) {
+        close(NULLREP);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Configuration.
+//----------------------------------------------------------------------------
+
+void ts::TSFileRecorder::setSegmentation(uint64_t max_size, MilliSecond max_duration, bool pcr_time)
+{
+    _max_size = max_size;
+    _max_duration = std::max<MilliSecond>(max_duration, 0);
+    _pcr_time = pcr_time;
+}
+
+void ts::TSFileRecorder::setWriteBehind(size_t buffer_size)
+{
+    _buffer_size = buffer_size;
+}
+
+void ts::TSFileRecorder::setAsyncIO(size_t depth, size_t block_size, bool direct)
+{
+    _file.setAsyncIO(depth, block_size, direct);
+}
+
+void ts::TSFileRecorder::setSparse(bool sparse)
+{
+    _sparse = sparse;
+}
+
+void ts::TSFileRecorder::setIndex(bool enable, MilliSecond interval)
+{
+    _indexing = enable;
+    _index.reset(interval);
+}
+
+
+//----------------------------------------------------------------------------
+// Get the recording statistics.
+//----------------------------------------------------------------------------
+
+void ts::TSFileRecorder::getStatistics(Statistics& stats) const
+{
+    Guard lock(_mutex);
+    stats = _stats;
+    if (_buffer_size > 0) {
+        stats.high_water = _queue.highWaterMark();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Start the recording.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileRecorder::open(const UString& filename, bool append, bool keep, Report& report)
+{
+    if (_is_open) {
+        report.error(u"recording already started");
+        return false;
+    }
+    if (filename.empty() && isSegmented()) {
+        report.error(u"cannot split the recording into several files on standard output");
+        return false;
+    }
+    if (filename.empty() && _indexing) {
+        report.error(u"cannot index the recording on standard output");
+        return false;
+    }
+    if (_sparse && _indexing) {
+        report.error(u"cannot index a sparse recording");
+        return false;
+    }
+
+    _filename = filename;
+    _append = append;
+    _keep = keep;
+    _report = &report;
+    _error = false;
+    _pcr_pid = PID_NULL;
+    {
+        Guard lock(_mutex);
+        _stats = Statistics();
+        _stats.buffer_size = _buffer_size;
+    }
+
+    // Create the first file.
+    if (!nextFile(report)) {
+        return false;
+    }
+
+    // Start the background thread.
+    if (_buffer_size > 0) {
+        _queue.reset(_buffer_size);
+        _chunk.resize(std::max<size_t>(1, _buffer_size / 4));
+        if (!Thread::start()) {
+            report.error(u"cannot start write-behind thread");
+            _file.close(report);
+            return false;
+        }
+    }
+
+    _is_open = true;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop the recording.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileRecorder::close(Report& report)
+{
+    if (!_is_open) {
+        report.error(u"recording not started");
+        return false;
+    }
+
+    // Let the background thread write all buffered packets.
+    if (_buffer_size > 0) {
+        _queue.setEOF();
+        Thread::waitForTermination();
+    }
+
+    const bool ok = flushSparse(report) && _file.close(report) && !_error;
+    _is_open = false;
+    _report = nullptr;
+    return ok;
+}
+
+
+//----------------------------------------------------------------------------
+// Record TS packets.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileRecorder::write(const TSPacket* buffer, size_t packet_count, Report& report)
+{
+    if (!_is_open) {
+        report.error(u"recording not started");
+        return false;
+    }
+    else if (_buffer_size == 0) {
+        // Synchronous write.
+        return writePackets(buffer, packet_count, report);
+    }
+
+    // Copy the packets into the write-behind buffer. Wait when the buffer is full.
+    while (packet_count > 0) {
+        TSPacket* window = nullptr;
+        size_t window_size = 0;
+        if (_error || !_queue.lockWriteBuffer(window, window_size, packet_count)) {
+            // The background thread has already reported the error.
+            return false;
+        }
+        const size_t count = std::min(window_size, packet_count);
+        TSPacket::Copy(window, buffer, count);
+        _queue.releaseWriteBuffer(count);
+        buffer += count;
+        packet_count -= count;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Background thread: write the content of the buffer.
+//----------------------------------------------------------------------------
+
+void ts::TSFileRecorder::main()
+{
+    size_t count = 0;
+    BitRate bitrate = 0;
+
+    while (_queue.waitPackets(&_chunk[0], _chunk.size(), count, bitrate)) {
+        if (!writePackets(&_chunk[0], count, *_report)) {
+            // Unlock the application, the next write() will fail.
+            _error = true;
+            _queue.stop();
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Write packets in the current file, create new segments when necessary.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileRecorder::writePackets(const TSPacket* buffer, size_t packet_count, Report& report)
+{
+    while (packet_count > 0) {
+
+        // Create a new file when the current segment is full.
+        const size_t count = isSegmented() ? segmentCapacity(buffer, packet_count) : packet_count;
+        if (count == 0) {
+            if (!nextFile(report)) {
+                return false;
+            }
+            continue;
+        }
+
+        // Write packets, measure the latency of the write operation.
+        const Monotonic start(true);
+        if (!writeFile(buffer, count, report)) {
+            return false;
+        }
+        const NanoSecond latency = Monotonic(true) - start;
+
+        // Index the packets after writing them, the index never refers to unwritten packets.
+        if (_indexing && !indexPackets(buffer, count, report)) {
+            return false;
+        }
+
+        buffer += count;
+        packet_count -= count;
+
+        Guard lock(_mutex);
+        _stats.packets += count;
+        _stats.write_latency.add(uint64_t(std::max<NanoSecond>(latency, 0) / NanoSecPerMicroSec));
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Write packets in the current file, in plain or sparse format.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileRecorder::writeFile(const TSPacket* buffer, size_t packet_count, Report& report)
+{
+    if (!_sparse) {
+        _segment_bytes += packet_count * PKT_SIZE;
+        Guard lock(_mutex);
+        _stats.units += packet_count;
+        return _file.write(buffer, packet_count, report);
+    }
+
+    // The segment size includes the pending units, written when the segment is closed.
+    _units.clear();
+    _encoder.encode(buffer, packet_count, _units);
+    _segment_bytes = (_encoder.outputUnits() + _encoder.pendingUnits()) * PKT_SIZE;
+    {
+        Guard lock(_mutex);
+        _stats.units += _units.size();
+    }
+    return _units.empty() || _file.write(&_units[0], _units.size(), report);
+}
+
+
+//----------------------------------------------------------------------------
+// Write the pending sparse units in the current file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileRecorder::flushSparse(Report& report)
+{
+    if (!_sparse || !_file.isOpen()) {
+        return true;
+    }
+    _units.clear();
+    _encoder.flush(_units);
+    {
+        Guard lock(_mutex);
+        _stats.units += _units.size();
+    }
+    return _units.empty() || _file.write(&_units[0], _units.size(), report);
+}
+
+
+//----------------------------------------------------------------------------
+// Number of packets which can be written in the current segment.
+//----------------------------------------------------------------------------
+
+size_t ts::TSFileRecorder::segmentCapacity(const TSPacket* buffer, size_t packet_count)
+{
+    // An empty segment always accepts at least one packet.
+    size_t count = packet_count;
+
+    // Limit the segment size, on a packet boundary.
+    if (_max_size > 0) {
+        const uint64_t room = _max_size > _segment_bytes ? (_max_size - _segment_bytes) / PKT_SIZE : 0;
+        count = size_t(std::min(uint64_t(count), std::max<uint64_t>(room, _segment_bytes == 0 ? 1 : 0)));
+    }
+
+    // Limit the duration of the segment using the system time.
+    if (_max_duration > 0 && !_pcr_time && _segment_bytes > 0 && Time::CurrentUTC() - _segment_start >= _max_duration) {
+        count = 0;
+    }
+
+    // Limit the duration of the segment using PCR's. Cut before the first PCR after the duration.
+    if (_max_duration > 0 && _pcr_time) {
+        const uint64_t max_pcr = uint64_t(_max_duration) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+        for (size_t i = 0; i < count; ++i) {
+            const TSPacket& pkt(buffer[i]);
+            if (pkt.hasPCR() && (_pcr_pid == PID_NULL || pkt.getPID() == _pcr_pid)) {
+                _pcr_pid = pkt.getPID();
+                const uint64_t pcr = pkt.getPCR();
+                if (!_segment_pcr_ok) {
+                    _segment_pcr = pcr;
+                    _segment_pcr_ok = true;
+                }
+                else if ((pcr >= _segment_pcr ? pcr - _segment_pcr : PCR_WRAP + pcr - _segment_pcr) >= max_pcr && (i > 0 || _segment_bytes > 0)) {
+                    count = i;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Index written packets and append new index entries to the index file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileRecorder::indexPackets(const TSPacket* buffer, size_t packet_count, Report& report)
+{
+    for (size_t i = 0; i < packet_count; ++i) {
+        _index.feedPacket(buffer[i]);
+    }
+    if (_index.entries().empty()) {
+        return true;
+    }
+    ByteBlock data;
+    _index.serialize(data);
+    _index.clearEntries();
+    return data.appendToFile(_index_name, &report);
+}
+
+
+//----------------------------------------------------------------------------
+// Close the current file, if any, and create the next one.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileRecorder::nextFile(Report& report)
+{
+    if (_file.isOpen() && (!flushSparse(report) || !_file.close(report))) {
+        return false;
+    }
+
+    _encoder.reset();
+    _segment_bytes = 0;
+    _segment_start = Time::CurrentUTC();
+    _segment_pcr = 0;
+    _segment_pcr_ok = false;
+
+    // Build the file name of the next segment.
+    UString name(_filename);
+    if (isSegmented()) {
+        const Time::Fields now(_segment_start.UTCToLocal());
+        size_t index = 0;
+        {
+            Guard lock(_mutex);
+            index = _stats.files + 1;
+        }
+        name = UString::Format(u"%s-%04d%02d%02d-%02d%02d%02d-%06d%s", {PathPrefix(_filename), now.year, now.month, now.day, now.hour, now.minute, now.second, index, PathSuffix(_filename)});
+        report.verbose(u"creating %s", {name});
+    }
+
+    if (!_file.open(name, _append, _keep, report)) {
+        return false;
+    }
+
+    // Create the index file with an empty index.
+    if (_indexing) {
+        ByteBlock header;
+        TSPacketIndex::SerializeHeader(header);
+        _index_name = TSPacketIndex::IndexFileName(name);
+        _index.reset();
+        if (!header.saveToFile(_index_name, &report)) {
+            return false;
+        }
+    }
+
+    Guard lock(_mutex);
+    _stats.files++;
+    return true;
+}
@@ -0,0 +1,268 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream recording into segmented files with write-behind.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSFileOutput.h"
+#include "tsTSPacketQueue.h"
+#include "tsTSPacketIndex.h"
+#include "tsTSSparseEncoder.h"
+#include "tsLogHistogram.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsTime.h"
+
+namespace ts {
+    //!
+    //! Transport stream recording into segmented files with write-behind.
+    //! @ingroup mpeg
+    //!
+    //! The recording can be split into successive files ("segments") of limited size
+    //! or duration. The duration can be measured using the system time or the PCR's
+    //! from the transport stream. Files are always cut on a packet boundary. With
+    //! PCR-based segmentation, each segment starts with a packet containing a PCR.
+    //!
+    //! When segmentation is used, the specified file name is used as a template.
+    //! The local date and time of creation and a sequence number are inserted before
+    //! the file suffix. Example: with file name @c foo.ts, the segments are named like
+    //! @c foo-20181018-113500-000001.ts.
+    //!
+    //! Optionally, an index file is built for each file (see TSPacketIndex).
+    //! The index is incrementally written while the file is recorded.
+    //!
+    //! Optionally, the files are written in the sparse format, without null packets
+    //! (see TSSparseEncoder). Each segment is a complete sparse file. The maximum
+    //! size of segments applies to the sparse files.
+    //!
+    //! Optionally, the files are written in a background thread ("write-behind").
+    //! The packets are first copied into a bounded buffer which absorbs the latency
+    //! of the storage. The write() operation blocks only when the buffer is full.
+    //! In that mode, the Report object must be thread-safe since it is used from
+    //! the background thread.
+    //!
+    class TSDUCKDLL TSFileRecorder : private Thread
+    {
+    public:
+        //!
+        //! Default size in packets of the write-behind buffer.
+        //!
+        static const size_t DEFAULT_BUFFER_SIZE = 32768;
+
+        //!
+        //! Recording statistics.
+        //!
+        struct TSDUCKDLL Statistics
+        {
+            PacketCounter packets;        //!< Number of written packets.
+            PacketCounter units;          //!< Number of 188-byte units in the files, less than packets with sparse files.
+            size_t        files;          //!< Number of created files.
+            LogHistogram  write_latency;  //!< Latency of write operations in microseconds.
+            size_t        buffer_size;    //!< Size in packets of the write-behind buffer, zero if not used.
+            size_t        high_water;     //!< High-water mark of the write-behind buffer in packets.
+
+            //!
+            //! Constructor.
+            //!
+            Statistics();
+        };
+
+        //!
+        //! Default constructor.
+        //!
+        TSFileRecorder();
+
+        //!
+        //! Destructor.
+        //!
+        virtual ~TSFileRecorder();
+
+        //!
+        //! Set the segmentation of the recording.
+        //! This must be called before open().
+        //! @param [in] max_size Maximum size in bytes of each file. Zero means unlimited.
+        //! @param [in] max_duration Maximum duration in milliseconds of each file. Zero means unlimited.
+        //! @param [in] pcr_time If true, @a max_duration is measured using the PCR's from the
+        //! first PID carrying PCR's. Otherwise, it is measured using the system time.
+        //!
+        void setSegmentation(uint64_t max_size, MilliSecond max_duration, bool pcr_time = false);
+
+        //!
+        //! Check if the recording is segmented.
+        //! @return True if the recording is split into several files.
+        //!
+        bool isSegmented() const
+        {
+            return _max_size > 0 || _max_duration > 0;
+        }
+
+        //!
+        //! Write the files in a background thread.
+        //! This must be called before open().
+        //! @param [in] buffer_size Size in packets of the write-behind buffer.
+        //! Zero means that the files are synchronously written in write() (the default).
+        //!
+        void setWriteBehind(size_t buffer_size);
+
+        //!
+        //! Use asynchronous write operations with io_uring (Linux only).
+        //! This must be called before open().
+        //! @param [in] depth Number of write operations in flight. Zero means synchronous I/O (the default).
+        //! @param [in] block_size Size in bytes of each write operation.
+        //! @param [in] direct Use direct I/O (O_DIRECT), bypassing the system cache.
+        //! @see TSFileOutput::setAsyncIO()
+        //!
+        void setAsyncIO(size_t depth, size_t block_size = TSFileOutput::DEFAULT_ASYNC_BLOCK_SIZE, bool direct = false);
+
+        //!
+        //! Build an index file for each recorded file.
+        //! This must be called before open(). Indexing is not possible on standard output.
+        //! @param [in] enable When true, build index files.
+        //! @param [in] interval Interval in milliseconds between time entries in the index.
+        //! @see TSPacketIndex
+        //!
+        void setIndex(bool enable, MilliSecond interval = TSPacketIndex::DEFAULT_INTERVAL);
+
+        //!
+        //! Write sparse files, without null packets.
+        //! This must be called before open(). Sparse files cannot be indexed.
+        //! @param [in] sparse When true, write sparse files.
+        //! @see TSSparseEncoder
+        //!
+        void setSparse(bool sparse);
+
+        //!
+        //! Start the recording.
+        //! @param [in] filename File name. If empty, use standard output. Segmented
+        //! recording is not possible on standard output. When the recording is segmented,
+        //! this is the template for the file names.
+        //! @param [in] append If true, append packets to existing files.
+        //! @param [in] keep If true, keep previous files with the same name. Fail if they already exist.
+        //! @param [in,out] report Where to report errors. Must remain valid until close().
+        //! @return True on success, false on error.
+        //!
+        bool open(const UString& filename, bool append, bool keep, Report& report);
+
+        //!
+        //! Check if the recording is started.
+        //! @return True if the recording is started.
+        //!
+        bool isOpen() const
+        {
+            return _is_open;
+        }
+
+        //!
+        //! Stop the recording.
+        //! With write-behind, wait until all buffered packets are written.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error, including errors in the background thread.
+        //!
+        bool close(Report& report);
+
+        //!
+        //! Record TS packets.
+        //! @param [in] buffer Address of first packet to write.
+        //! @param [in] packet_count Number of packets to write.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error. With write-behind, an error
+        //! in the background thread is reported on the next write().
+        //!
+        bool write(const TSPacket* buffer, size_t packet_count, Report& report);
+
+        //!
+        //! Get the recording statistics.
+        //! @param [out] stats Returned statistics.
+        //!
+        void getStatistics(Statistics& stats) const;
+
+    private:
+        // Configuration.
+        uint64_t       _max_size;       // Maximum segment size in bytes.
+        MilliSecond    _max_duration;   // Maximum segment duration in milliseconds.
+        bool           _pcr_time;       // Segment duration is based on PCR.
+        bool           _indexing;       // Build index files.
+        bool           _sparse;         // Write sparse files.
+        size_t         _buffer_size;    // Write-behind buffer size in packets, zero if synchronous.
+        UString        _filename;       // File name or template.
+        bool           _append;         // Append to existing files.
+        bool           _keep;           // Keep existing files.
+        Report*        _report;         // Where to report errors from the background thread.
+        volatile bool  _is_open;        // Recording is in progress.
+        volatile bool  _error;          // A write error occured in the background thread.
+
+        // Current file, accessed only in the writing context (background thread with write-behind).
+        TSFileOutput   _file;           // Current output file.
+        uint64_t       _segment_bytes;  // Size of current segment.
+        Time           _segment_start;  // Creation time of current segment.
+        PID            _pcr_pid;        // Reference PID for PCR-based segmentation.
+        uint64_t       _segment_pcr;    // First PCR in current segment.
+        bool           _segment_pcr_ok; // _segment_pcr is valid.
+        TSPacketIndex  _index;          // Index of current file.
+        UString        _index_name;     // Name of index file of current file.
+        TSSparseEncoder _encoder;       // Sparse encoder of current file.
+        TSPacketVector _units;          // Encoded sparse units.
+
+        // Write-behind buffer.
+        TSPacketQueue  _queue;          // Packet buffer between the application and the background thread.
+        TSPacketVector _chunk;          // Packets to write in the background thread.
+
+        // Statistics.
+        mutable Mutex  _mutex;          // Protect the statistics.
+        Statistics     _stats;          // Recording statistics.
+
+        // Implementation of Thread.
+        virtual void main() override;
+
+        // Write packets in the current file, create new segments when necessary.
+        bool writePackets(const TSPacket* buffer, size_t packet_count, Report& report);
+
+        // Write packets in the current file, in plain or sparse format.
+        bool writeFile(const TSPacket* buffer, size_t packet_count, Report& report);
+
+        // Write the pending sparse units in the current file.
+        bool flushSparse(Report& report);
+
+        // Number of packets which can be written in the current segment.
+        size_t segmentCapacity(const TSPacket* buffer, size_t packet_count);
+
+        // Close the current file, if any, and create the next one.
+        bool nextFile(Report& report);
+
+        // Index written packets and append new index entries to the index file.
+        bool indexPackets(const TSPacket* buffer, size_t packet_count, Report& report);
+
+        // Inaccessible operations
+        TSFileRecorder(const TSFileRecorder&) = delete;
+        TSFileRecorder& operator=(const TSFileRecorder&) = delete;
+    };
+}
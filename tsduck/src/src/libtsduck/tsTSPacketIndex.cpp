@@ -0,0 +1,368 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Index of a transport stream file (.tsidx sidecar files).
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSPacketIndex.h"
+#include "tsMemoryUtils.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const ts::MilliSecond ts::TSPacketIndex::DEFAULT_INTERVAL;
+const size_t ts::TSPacketIndex::HEADER_SIZE;
+const size_t ts::TSPacketIndex::ENTRY_SIZE;
+const uint8_t ts::TSPacketIndex::FORMAT_VERSION;
+#endif
+
+// PCR values wrap up after 2**33 units of 90 kHz.
+#define PCR_WRAP (PTS_DTS_SCALE * SYSTEM_CLOCK_SUBFACTOR)
+
+// A larger difference between two successive PCR's is considered as a discontinuity.
+#define MAX_PCR_DELTA (10 * uint64_t(SYSTEM_CLOCK_FREQ))
+
+// Magic string at start of an index file.
+#define MAGIC      "TSIDX"
+#define MAGIC_SIZE 5
+
+
+//----------------------------------------------------------------------------
+// Constructors.
+//----------------------------------------------------------------------------
+
+ts::TSPacketIndex::Entry::Entry(EntryType type_) :
+    type(type_),
+    pid(PID_NULL),
+    packet(0),
+    time(0),
+    table_id(0),
+    table_id_ext(0),
+    version(0)
+{
+}
+
+ts::TSPacketIndex::TSPacketIndex(MilliSecond interval) :
+    _interval(interval),
+    _packets(0),
+    _pcr_pid(PID_NULL),
+    _last_pcr(0),
+    _time(0),
+    _next_time(0),
+    _pmt_pids(),
+    _video_pcr_pids(),
+    _versions(),
+    _entries()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Build the name of the index file of a transport stream file.
+//----------------------------------------------------------------------------
+
+ts::UString ts::TSPacketIndex::IndexFileName(const UString& filename)
+{
+    return filename + u".tsidx";
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the index, before indexing a new file.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketIndex::reset(MilliSecond interval)
+{
+    if (interval >= 0) {
+        _interval = interval;
+    }
+    _packets = 0;
+    _pcr_pid = PID_NULL;
+    _last_pcr = 0;
+    _time = 0;
+    _next_time = 0;
+    _pmt_pids.reset();
+    _video_pcr_pids.clear();
+    _versions.clear();
+    _entries.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Add an entry at the current packet.
+//----------------------------------------------------------------------------
+
+ts::TSPacketIndex::Entry& ts::TSPacketIndex::addEntry(EntryType type, PID pid)
+{
+    _entries.push_back(Entry(type));
+    Entry& e(_entries.back());
+    e.pid = pid;
+    e.packet = _packets;
+    e.time = _time / SYSTEM_CLOCK_SUBFACTOR;
+    return e;
+}
+
+
+//----------------------------------------------------------------------------
+// Index the next packet of the file.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketIndex::feedPacket(const TSPacket& pkt)
+{
+    const PID pid = pkt.getPID();
+
+    // Track the time on the first PID carrying PCR's.
+    if (pkt.hasPCR() && (_pcr_pid == PID_NULL || pid == _pcr_pid)) {
+        const uint64_t pcr = pkt.getPCR();
+        if (_pcr_pid == PID_NULL) {
+            _pcr_pid = pid;
+        }
+        else {
+            // On discontinuities, the time continues from the previous PCR.
+            const uint64_t delta = pcr >= _last_pcr ? pcr - _last_pcr : PCR_WRAP + pcr - _last_pcr;
+            if (!pkt.getDiscontinuityIndicator() && delta < MAX_PCR_DELTA) {
+                _time += delta;
+            }
+        }
+        _last_pcr = pcr;
+        if (_time >= _next_time) {
+            addEntry(TIME, pid);
+            _next_time = _time + uint64_t(std::max<MilliSecond>(_interval, 1)) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+        }
+    }
+
+    // Random access points, only on the reference PID for time or on a video PID of the same program.
+    // A random access point on another PID (audio, other program) is not a valid place to start.
+    if (pkt.getRandomAccessIndicator() && _pcr_pid != PID_NULL) {
+        const auto it = _video_pcr_pids.find(pid);
+        if (pid == _pcr_pid || (it != _video_pcr_pids.end() && it->second == _pcr_pid)) {
+            addEntry(RAP, pid);
+        }
+    }
+
+    // Track new versions of PSI.
+    if (pkt.getPUSI() && (pid == PID_PAT || pid == PID_CAT || _pmt_pids.test(pid))) {
+        analyzeSection(pkt);
+    }
+
+    _packets++;
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze the start of a PSI section.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketIndex::analyzeSection(const TSPacket& pkt)
+{
+    // Locate the first section which starts in the packet.
+    // Only the header of the section is required, except for the PAT.
+    const uint8_t* payload = pkt.getPayload();
+    const size_t payload_size = pkt.getPayloadSize();
+    if (payload_size < 1 || payload_size < size_t(payload[0]) + 9) {
+        return;
+    }
+    const uint8_t* section = payload + 1 + payload[0];
+    const size_t remain = payload_size - 1 - payload[0];
+
+    // Check that this is a current long section of the expected table.
+    const PID pid = pkt.getPID();
+    const TID tid = section[0];
+    if ((section[1] & 0x80) == 0 ||
+        (section[5] & 0x01) == 0 ||
+        (pid == PID_PAT && tid != TID_PAT) ||
+        (pid == PID_CAT && tid != TID_CAT) ||
+        (pid != PID_PAT && pid != PID_CAT && tid != TID_PMT))
+    {
+        return;
+    }
+
+    const size_t section_size = 3 + (GetUInt16(section + 1) & 0x0FFF);
+    const uint16_t tid_ext = GetUInt16(section + 3);
+    const uint8_t version = (section[5] >> 1) & 0x1F;
+
+    // The first version of each table is not a change.
+    const uint64_t key = (uint64_t(pid) << 24) | (uint64_t(tid) << 16) | tid_ext;
+    const auto it = _versions.find(key);
+    if (it == _versions.end()) {
+        _versions[key] = version;
+    }
+    else if (it->second != version) {
+        it->second = version;
+        Entry& e(addEntry(PSI, pid));
+        e.table_id = tid;
+        e.table_id_ext = tid_ext;
+        e.version = version;
+    }
+
+    // Collect the PMT PID's from a PAT section which is complete in the packet.
+    if (tid == TID_PAT && section_size <= remain && section_size >= 12) {
+        for (size_t i = 8; i + 4 <= section_size - 4; i += 4) {
+            if (GetUInt16(section + i) != 0) {
+                _pmt_pids.set(GetUInt16(section + i + 2) & 0x1FFF);
+            }
+        }
+    }
+
+    // Collect the video PID's and their PCR PID from a PMT section which is complete in the packet.
+    if (tid == TID_PMT && section_size <= remain && section_size >= 16) {
+        const PID pcr_pid = GetUInt16(section + 8) & 0x1FFF;
+        const size_t end = section_size - 4;
+        size_t i = 12 + (GetUInt16(section + 10) & 0x0FFF);
+        while (i + 5 <= end) {
+            if (IsVideoST(section[i])) {
+                _video_pcr_pids[GetUInt16(section + i + 1) & 0x1FFF] = pcr_pid;
+            }
+            i += 5 + (GetUInt16(section + i + 3) & 0x0FFF);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Find the packet where to start reading at a given time.
+//----------------------------------------------------------------------------
+
+bool ts::TSPacketIndex::findTime(MilliSecond time, PacketCounter& packet) const
+{
+    bool has_time = false;
+    bool has_rap = false;
+    for (auto it = _entries.begin(); it != _entries.end() && !(has_time && has_rap); ++it) {
+        has_time = has_time || it->type == TIME;
+        has_rap = has_rap || it->type == RAP;
+    }
+    if (!has_time) {
+        return false;
+    }
+
+    // Random access points are only recorded on the time reference PID or a video PID of the same program.
+    // Before the first random access point or time point, start at the beginning of the file.
+    // Times increase in the index, stop after the requested time.
+    const uint64_t target = uint64_t(std::max<MilliSecond>(time, 0)) * (SYSTEM_CLOCK_SUBFREQ / MilliSecPerSec);
+    const EntryType type = has_rap ? RAP : TIME;
+    packet = 0;
+    for (auto it = _entries.begin(); it != _entries.end() && it->time <= target; ++it) {
+        if (it->type == type) {
+            packet = it->packet;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Find the packet where a PSI change occurs.
+//----------------------------------------------------------------------------
+
+bool ts::TSPacketIndex::findPSIChange(size_t count, PacketCounter& packet) const
+{
+    for (auto it = _entries.begin(); count > 0 && it != _entries.end(); ++it) {
+        if (it->type == PSI && --count == 0) {
+            packet = it->packet;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Serialization.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketIndex::SerializeHeader(ByteBlock& data)
+{
+    data.append(MAGIC, MAGIC_SIZE);
+    data.appendUInt8(FORMAT_VERSION);
+    data.append(uint8_t(0), HEADER_SIZE - MAGIC_SIZE - 1);
+}
+
+void ts::TSPacketIndex::serialize(ByteBlock& data, size_t first) const
+{
+    for (size_t i = first; i < _entries.size(); ++i) {
+        const Entry& e(_entries[i]);
+        data.appendUInt8(uint8_t(e.type << 5) | (e.version & 0x1F));
+        data.appendUInt8(e.table_id);
+        data.appendUInt16(e.pid & 0x1FFF);
+        data.appendUInt8(uint8_t(e.packet >> 32));
+        data.appendUInt32(uint32_t(e.packet));
+        data.appendUInt8(uint8_t(e.time >> 32));
+        data.appendUInt32(uint32_t(e.time));
+        data.appendUInt16(e.table_id_ext);
+    }
+}
+
+bool ts::TSPacketIndex::deserialize(const uint8_t* data, size_t size)
+{
+    reset();
+    if (data == nullptr || size < HEADER_SIZE || ::memcmp(data, MAGIC, MAGIC_SIZE) != 0 || data[MAGIC_SIZE] != FORMAT_VERSION) {
+        return false;
+    }
+    for (size_t i = HEADER_SIZE; i + ENTRY_SIZE <= size; i += ENTRY_SIZE) {
+        const uint8_t* p = data + i;
+        Entry e(EntryType(p[0] >> 5));
+        e.version = p[0] & 0x1F;
+        e.table_id = p[1];
+        e.pid = GetUInt16(p + 2) & 0x1FFF;
+        e.packet = (PacketCounter(p[4]) << 32) | GetUInt32(p + 5);
+        e.time = (uint64_t(p[9]) << 32) | GetUInt32(p + 10);
+        e.table_id_ext = GetUInt16(p + 14);
+        _entries.push_back(e);
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Save and load index files.
+//----------------------------------------------------------------------------
+
+bool ts::TSPacketIndex::save(const UString& filename, Report& report) const
+{
+    ByteBlock data;
+    data.reserve(HEADER_SIZE + ENTRY_SIZE * _entries.size());
+    SerializeHeader(data);
+    serialize(data);
+    return data.saveToFile(filename, &report);
+}
+
+bool ts::TSPacketIndex::load(const UString& filename, Report& report)
+{
+    ByteBlock data;
+    if (!data.loadFromFile(filename, std::numeric_limits<size_t>::max(), &report)) {
+        return false;
+    }
+    else if (!deserialize(data.data(), data.size())) {
+        report.error(u"invalid index file %s", {filename});
+        return false;
+    }
+    else {
+        return true;
+    }
+}
@@ -0,0 +1,256 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Index of a transport stream file (.tsidx sidecar files).
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+#include "tsByteBlock.h"
+#include "tsReport.h"
+
+namespace ts {
+    //!
+    //! Index of a transport stream file, as stored in .tsidx sidecar files.
+    //! @ingroup mpeg
+    //!
+    //! The index maps times, random access points and PSI version changes to packet
+    //! indexes in the file. It is built by feeding all packets of the file, in sequence.
+    //!
+    //! Times are relative to the first PCR in the file. They are measured on the first
+    //! PID carrying PCR's, in units of 90 kHz (PTS units). Discontinuities and wrap-up
+    //! of the PCR's are absorbed, the times in the index always increase.
+    //!
+    //! Binary format: A .tsidx file starts with a 16-byte header, followed by 16-byte
+    //! entries, in increasing order of packet index. All integers are big endian.
+    //!
+    //! Header:
+    //! - 0-4: "TSIDX" (ASCII)
+    //! - 5: format version (currently 1)
+    //! - 6-15: reserved, zero
+    //!
+    //! Entry:
+    //! - 0: entry type (3 bits) and table version (5 bits)
+    //! - 1: table id
+    //! - 2-3: PID (13 bits)
+    //! - 4-8: packet index in file (40 bits)
+    //! - 9-13: time in 90 kHz units (40 bits)
+    //! - 14-15: table id extension
+    //!
+    //! The entries can be appended to an existing file while the transport stream
+    //! is being recorded.
+    //!
+    class TSDUCKDLL TSPacketIndex
+    {
+    public:
+        //!
+        //! Types of index entries.
+        //!
+        enum EntryType : uint8_t {
+            TIME = 1,  //!< Periodic time point, on a packet containing a PCR.
+            RAP  = 2,  //!< Random access point, a packet with random_access_indicator set on the PCR PID or a video PID of the same program.
+            PSI  = 3,  //!< New version of a PAT, CAT or PMT, on the first packet of the section.
+        };
+
+        //!
+        //! An entry in the index.
+        //!
+        struct TSDUCKDLL Entry
+        {
+            EntryType     type;          //!< Entry type.
+            PID           pid;           //!< PID of the packet.
+            PacketCounter packet;        //!< Packet index in the file.
+            uint64_t      time;          //!< Time in 90 kHz units since first PCR in the file.
+            uint8_t       table_id;      //!< Table id (PSI entries only).
+            uint16_t      table_id_ext;  //!< Table id extension (PSI entries only).
+            uint8_t       version;       //!< Table version (PSI entries only).
+
+            //!
+            //! Constructor.
+            //! @param [in] type Entry type.
+            //!
+            Entry(EntryType type = TIME);
+        };
+
+        //!
+        //! Vector of index entries.
+        //!
+        typedef std::vector<Entry> EntryVector;
+
+        //!
+        //! Default interval in milliseconds between TIME entries.
+        //!
+        static const MilliSecond DEFAULT_INTERVAL = 1000;
+
+        //!
+        //! Size in bytes of the header of an index file.
+        //!
+        static const size_t HEADER_SIZE = 16;
+
+        //!
+        //! Size in bytes of an entry in an index file.
+        //!
+        static const size_t ENTRY_SIZE = 16;
+
+        //!
+        //! Current version of the index file format.
+        //!
+        static const uint8_t FORMAT_VERSION = 1;
+
+        //!
+        //! Build the name of the index file of a transport stream file.
+        //! @param [in] filename Name of the transport stream file.
+        //! @return Name of the corresponding index file.
+        //!
+        static UString IndexFileName(const UString& filename);
+
+        //!
+        //! Constructor.
+        //! @param [in] interval Interval in milliseconds between TIME entries.
+        //!
+        TSPacketIndex(MilliSecond interval = DEFAULT_INTERVAL);
+
+        //!
+        //! Reset the index, before indexing a new file.
+        //! @param [in] interval Interval in milliseconds between TIME entries.
+        //! When negative, keep the previous interval.
+        //!
+        void reset(MilliSecond interval = -1);
+
+        //!
+        //! Index the next packet of the file.
+        //! @param [in] pkt The next packet in the file.
+        //!
+        void feedPacket(const TSPacket& pkt);
+
+        //!
+        //! Get the number of indexed packets.
+        //! @return The number of packets which were passed to feedPacket().
+        //!
+        PacketCounter packetCount() const
+        {
+            return _packets;
+        }
+
+        //!
+        //! Get the entries of the index.
+        //! @return A constant reference to the entries.
+        //!
+        const EntryVector& entries() const
+        {
+            return _entries;
+        }
+
+        //!
+        //! Remove the entries from memory, keep the indexing state.
+        //! This is typically used after an incremental save of the entries.
+        //!
+        void clearEntries()
+        {
+            _entries.clear();
+        }
+
+        //!
+        //! Find the packet where to start reading at a given time.
+        //! @param [in] time Time in milliseconds since first PCR in the file.
+        //! @param [out] packet Index of the last random access point at or before @a time.
+        //! Only the random access points on the PID of the time points are used, or on a video
+        //! PID of the program which uses this PID as PCR PID. When there is no such random
+        //! access point in the index, index of the last time point.
+        //! @return True on success, false if the index contains no time information.
+        //!
+        bool findTime(MilliSecond time, PacketCounter& packet) const;
+
+        //!
+        //! Find the packet where a PSI change occurs.
+        //! @param [in] count Rank of the PSI change in the file, starting at 1.
+        //! @param [out] packet Index of the packet where the new version of the PSI starts.
+        //! @return True on success, false if there are not enough PSI changes in the index.
+        //!
+        bool findPSIChange(size_t count, PacketCounter& packet) const;
+
+        //!
+        //! Serialize the header of an index file.
+        //! @param [in,out] data Buffer where the header is appended.
+        //!
+        static void SerializeHeader(ByteBlock& data);
+
+        //!
+        //! Serialize entries of the index.
+        //! @param [in,out] data Buffer where the entries are appended.
+        //! @param [in] first Index of the first entry to serialize.
+        //!
+        void serialize(ByteBlock& data, size_t first = 0) const;
+
+        //!
+        //! Deserialize an index file content.
+        //! @param [in] data Address of the binary index, including the header.
+        //! @param [in] size Size in bytes of the binary index.
+        //! A truncated entry at the end (index being written) is ignored.
+        //! @return True on success, false on invalid format.
+        //!
+        bool deserialize(const uint8_t* data, size_t size);
+
+        //!
+        //! Save the index in a file.
+        //! @param [in] filename Name of the index file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool save(const UString& filename, Report& report) const;
+
+        //!
+        //! Load the index from a file.
+        //! @param [in] filename Name of the index file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool load(const UString& filename, Report& report);
+
+    private:
+        MilliSecond   _interval;    // Interval between TIME entries.
+        PacketCounter _packets;     // Number of indexed packets.
+        PID           _pcr_pid;     // Reference PID for time.
+        uint64_t      _last_pcr;    // Last PCR value on _pcr_pid.
+        uint64_t      _time;        // Current time in PCR units since first PCR.
+        uint64_t      _next_time;   // Time of next TIME entry, in PCR units.
+        PIDSet        _pmt_pids;    // PID's carrying PMT's.
+        std::map<PID, PID> _video_pcr_pids;     // PCR PID of the program, indexed by video PID.
+        std::map<uint64_t, uint8_t> _versions;  // Last version of tables, indexed by PID, table id and table id extension.
+        EntryVector   _entries;     // Index entries.
+
+        // Analyze the start of a PSI section.
+        void analyzeSection(const TSPacket& pkt);
+
+        // Add an entry at the current packet.
+        Entry& addEntry(EntryType type, PID pid);
+    };
+}
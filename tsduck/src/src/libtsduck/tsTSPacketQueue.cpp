@@ -27,6 +27,7 @@
 //
 //----------------------------------------------------------------------------
 
+
 #include "tsTSPacketQueue.h"
 #include "tsGuard.h"
 #include "tsGuardCondition.h"
@@ -40,15 +41,19 @@ TSDUCK_SOURCE;
 ts::TSPacketQueue::TSPacketQueue(size_t size) :
     _eof(false),
     _stopped(false),
+    _readerWaiting(false),
+    _writerWaiting(false),
     _mutex(),
     _enqueued(),
     _dequeued(),
     _buffer(size),
     _pcr(1, 12),
     _inCount(0),
+    _highWater(0),
     _readIndex(0),
     _writeIndex(0),
-    _bitrate(0)
+    _bitrate(0),
+    _pcrBitrate(0)
 {
 }
 
@@ -69,10 +74,15 @@ void ts::TSPacketQueue::reset(size_t size)
 
     _eof = false;
     _stopped = false;
+    _readerWaiting = false;
+    _writerWaiting = false;
+    _pcr.reset();
     _inCount = 0;
+    _highWater = 0;
     _readIndex = 0;
     _writeIndex = 0;
     _bitrate = 0;
+    _pcrBitrate = 0;
 }
 
 
@@ -82,21 +92,33 @@ void ts::TSPacketQueue::reset(size_t size)
 
 size_t ts::TSPacketQueue::bufferSize() const
 {
-    Guard lock(_mutex);
+    // The buffer is resized only in reset(), which cannot be called concurrently.
     return _buffer.size();
 }
 
 
+//----------------------------------------------------------------------------
+// Wake up the other thread if it is waiting on a condition.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketQueue::signal(std::atomic<bool>& waiting, Condition& condition)
+{
+    // The waiting thread sets its flag and checks the queue state while holding
+    // the mutex. Acquiring the mutex here guarantees that the signal is not lost.
+    if (waiting.load()) {
+        GuardCondition lock(_mutex, condition);
+        lock.signal();
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Called by the writer thread to get a write buffer.
 //----------------------------------------------------------------------------
 
 bool ts::TSPacketQueue::lockWriteBuffer(TSPacket*& buffer, size_t& buffer_size, size_t min_size)
 {
-    GuardCondition lock(_mutex, _dequeued);
-
     // Maximum size we can allocate to the write window.
-    assert(_readIndex < _buffer.size());
     assert(_writeIndex < _buffer.size());
     const size_t max_size = _buffer.size() - _writeIndex;
 
@@ -104,25 +126,25 @@ bool ts::TSPacketQueue::lockWriteBuffer(TSPacket*& buffer, size_t& buffer_size,
     // But we also need to wait for at least one packet.
     min_size = std::max<size_t>(1, std::min(min_size, max_size));
 
-    // Wait until we get enough free space.
-    while (!_stopped && _buffer.size() - _inCount < min_size) {
-        lock.waitCondition();
+    // Wait until we get enough free space. Take the mutex only when we need to wait.
+    while (!_stopped && _buffer.size() - _inCount.load() < min_size) {
+        GuardCondition lock(_mutex, _dequeued);
+        _writerWaiting = true;
+        if (!_stopped && _buffer.size() - _inCount.load() < min_size) {
+            lock.waitCondition();
+        }
+        _writerWaiting = false;
     }
 
-    // Return the write window.
+    // Return the write window. It extends up to the first packet which was not yet
+    // consumed or up to the end of the buffer, whichever comes first.
     buffer = &_buffer[_writeIndex];
     if (_stopped) {
         // The reader thread has reported a stop condition, we can no longer write into the buffer.
         buffer_size = 0;
     }
-    else if (_readIndex > _writeIndex) {
-        // The write window extends up to the read index (where packets were not yet consumed).
-        buffer_size = _readIndex - _writeIndex;
-    }
     else {
-        // The write window wraps up at the end of the buffer.
-        // Return only the first contiguous part of the write window.
-        buffer_size = max_size;
+        buffer_size = std::min(max_size, _buffer.size() - _inCount.load());
     }
 
     // A write buffer is returned only when the reader thread does not want to terminate.
@@ -136,12 +158,10 @@ bool ts::TSPacketQueue::lockWriteBuffer(TSPacket*& buffer, size_t& buffer_size,
 
 void ts::TSPacketQueue::releaseWriteBuffer(size_t count)
 {
-    GuardCondition lock(_mutex, _enqueued);
-
     // Verify that the specified size is compatible with the current write window.
-    assert(_readIndex < _buffer.size());
+    // The reader thread can only increase the free space in the meantime.
     assert(_writeIndex < _buffer.size());
-    const size_t max_count = (_readIndex > _writeIndex ? _readIndex : _buffer.size()) - _writeIndex;
+    const size_t max_count = std::min(_buffer.size() - _writeIndex, _buffer.size() - _inCount.load());
 
     // This is a bug in the application to specify more than the max size.
     assert(count <= max_count);
@@ -156,14 +176,21 @@ void ts::TSPacketQueue::releaseWriteBuffer(size_t count)
         for (size_t i = 0; i < count; ++i) {
             _pcr.feedPacket(_buffer[_writeIndex + i]);
         }
+        if (_pcr.bitrateIsValid()) {
+            _pcrBitrate = _pcr.bitrate188();
+        }
     }
 
-    // Mark written packets as part of the buffer.
-    _inCount += count;
+    // Mark written packets as part of the buffer. Only this thread increases the
+    // packet count, so the new count is the maximum until the next release.
     _writeIndex = (_writeIndex + count) % _buffer.size();
+    const size_t level = _inCount.fetch_add(count) + count;
+    if (level > _highWater.load()) {
+        _highWater = level;
+    }
 
     // Signal that packets have been enqueued
-    lock.signal();
+    signal(_readerWaiting, _enqueued);
 }
 
 
@@ -173,14 +200,13 @@ void ts::TSPacketQueue::releaseWriteBuffer(size_t count)
 
 void ts::TSPacketQueue::setBitrate(BitRate bitrate)
 {
-    Guard lock(_mutex);
-
     // Remember the bitrate value.
     _bitrate = bitrate;
 
     // If a specific value is given, reset PCR analysis.
     if (bitrate > 0) {
         _pcr.reset();
+        _pcrBitrate = 0;
     }
 }
 
@@ -191,8 +217,7 @@ void ts::TSPacketQueue::setBitrate(BitRate bitrate)
 
 bool ts::TSPacketQueue::eof() const
 {
-    Guard lock(_mutex);
-    return _eof && _inCount == 0;
+    return _eof && _inCount.load() == 0;
 }
 
 
@@ -202,29 +227,56 @@ bool ts::TSPacketQueue::eof() const
 
 void ts::TSPacketQueue::setEOF()
 {
-    GuardCondition lock(_mutex, _enqueued);
     _eof = true;
 
     // We did not really enqueue packets but if a reader thread is waiting we need to wake it up.
-    lock.signal();
+    signal(_readerWaiting, _enqueued);
 }
 
 
 //----------------------------------------------------------------------------
-// Get bitrate, must be called with mutex held.
+// Get bitrate, either from writer thread or from PCR analysis.
 //----------------------------------------------------------------------------
 
 ts::BitRate ts::TSPacketQueue::getBitrate() const
 {
-    if (_bitrate != 0) {
-        return _bitrate;
-    }
-    else if (_pcr.bitrateIsValid()) {
-        return _pcr.bitrate188();
-    }
-    else {
-        return 0;
-    }
+    const BitRate bitrate = _bitrate.load();
+    return bitrate != 0 ? bitrate : _pcrBitrate.load();
+}
+
+
+//----------------------------------------------------------------------------
+// Called by the reader thread to access the next packets in the buffer.
+//----------------------------------------------------------------------------
+
+bool ts::TSPacketQueue::lockReadBuffer(const TSPacket*& buffer, size_t& buffer_size, BitRate& bitrate, size_t max_size)
+{
+    // Get bitrate, either from writer thread or from PCR analysis.
+    bitrate = getBitrate();
+
+    // Return the contiguous part of the available packets.
+    assert(_readIndex < _buffer.size());
+    buffer = &_buffer[_readIndex];
+    buffer_size = std::min(std::min(_inCount.load(), _buffer.size() - _readIndex), max_size);
+    return buffer_size > 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Called by the reader thread to release packets from lockReadBuffer().
+//----------------------------------------------------------------------------
+
+void ts::TSPacketQueue::releaseReadBuffer(size_t count)
+{
+    // This is a bug in the application to release more than the available packets.
+    assert(count <= _inCount.load());
+    count = std::min(count, _inCount.load());
+
+    _readIndex = (_readIndex + count) % _buffer.size();
+    _inCount -= count;
+
+    // Signal the condition that packets were freed.
+    signal(_writerWaiting, _dequeued);
 }
 
 
@@ -234,27 +286,32 @@ ts::BitRate ts::TSPacketQueue::getBitrate() const
 
 bool ts::TSPacketQueue::getPacket(TSPacket& packet, BitRate& bitrate)
 {
-    GuardCondition lock(_mutex, _dequeued);
+    return readPackets(&packet, 1, bitrate) > 0;
+}
 
-    // Get bitrate, either from reader thread or from PCR analysis.
-    bitrate = getBitrate();
 
-    // Get packet when available.
-    if (_inCount == 0) {
-        // No packet available.
-        return false;
-    }
-    else {
-        // Return next packet.
-        packet = _buffer[_readIndex];
-        _readIndex = (_readIndex + 1) % _buffer.size();
-        _inCount--;
+//----------------------------------------------------------------------------
+// Called by the reader thread to get the next packets without waiting.
+//----------------------------------------------------------------------------
 
-        // Signal the condition that a packet was freed.
-        lock.signal();
+size_t ts::TSPacketQueue::readPackets(TSPacket* buffer, size_t buffer_count, BitRate& bitrate)
+{
+    // Copy the available packets in at most two contiguous parts.
+    size_t count = 0;
+    const TSPacket* data = nullptr;
+    size_t size = 0;
+    for (int part = 0; part < 2 && count < buffer_count && lockReadBuffer(data, size, bitrate, buffer_count - count); ++part) {
+        TSPacket::Copy(buffer + count, data, size);
+        _readIndex = (_readIndex + size) % _buffer.size();
+        _inCount -= size;
+        count += size;
+    }
 
-        return true;
+    // Signal the condition that packets were freed.
+    if (count > 0) {
+        signal(_writerWaiting, _dequeued);
     }
+    return count;
 }
 
 
@@ -264,29 +321,18 @@ bool ts::TSPacketQueue::getPacket(TSPacket& packet, BitRate& bitrate)
 
 bool ts::TSPacketQueue::waitPackets(TSPacket* buffer, size_t buffer_count, size_t& actual_count, BitRate& bitrate)
 {
-    // Clear out params.
-    actual_count = 0;
-
-    // Wait until there is some packet in the buffer.
-    GuardCondition lock(_mutex, _enqueued);
-    while (!_eof && !_stopped && _inCount == 0) {
-        lock.waitCondition();
+    // Wait until there is some packet in the buffer. Take the mutex only when we need to wait.
+    while (!_eof && !_stopped && _inCount.load() == 0) {
+        GuardCondition lock(_mutex, _enqueued);
+        _readerWaiting = true;
+        if (!_eof && !_stopped && _inCount.load() == 0) {
+            lock.waitCondition();
+        }
+        _readerWaiting = false;
     }
 
     // Return as many packets as we can. Ignore eof for now.
-    while (_inCount > 0 && buffer_count > 0) {
-        *buffer++ = _buffer[_readIndex];
-        buffer_count--;
-        actual_count++;
-        _readIndex = (_readIndex + 1) % _buffer.size();
-        _inCount--;
-    }
-
-    // Get bitrate, either from reader thread or from PCR analysis.
-    bitrate = getBitrate();
-
-    // Signal that packets were freed.
-    _dequeued.signal();
+    actual_count = readPackets(buffer, buffer_count, bitrate);
 
     // Return false when no packet is returned. Do not return false immediately
     // when _eof is true, wait for all enqueued packets to be returned.
@@ -300,12 +346,12 @@ bool ts::TSPacketQueue::waitPackets(TSPacket* buffer, size_t buffer_count, size_
 
 void ts::TSPacketQueue::stop()
 {
-    GuardCondition lock(_mutex, _dequeued);
-
     // Report a stop condition.
     _stopped = true;
 
     // Signal the condition that a packet was freed. This is not really freeing
-    // a packet but it means that the writer thread should wake up.
-    lock.signal();
+    // a packet but it means that the writer thread should wake up. The stop
+    // may also come from another thread while the reader thread is waiting.
+    signal(_writerWaiting, _dequeued);
+    signal(_readerWaiting, _enqueued);
 }
@@ -37,6 +37,7 @@
 #include "tsPCRAnalyzer.h"
 #include "tsMutex.h"
 #include "tsCondition.h"
+#include <atomic>
 
 namespace ts {
     //!
@@ -48,8 +49,14 @@ namespace ts {
     //! a write window inside the buffer. When packets have been written into
     //! this buffer, the writer thread calls releaseWriteBuffer().
     //!
-    //! A reader thread consumes packets. The packets are consumed one by one
-    //! and copied out of the buffer using getPacket().
+    //! A reader thread consumes packets. The packets are either copied out of
+    //! the buffer using getPacket(), readPackets() or waitPackets(), or directly
+    //! accessed in the buffer using lockReadBuffer() and releaseReadBuffer().
+    //!
+    //! There must be only one writer thread and one reader thread. The queue is
+    //! lock-free: the reader and writer threads exchange packets using atomic
+    //! counters only. A mutex and conditions are used only when one thread must
+    //! wait for the other one (empty or full queue).
     //!
     //! The input bitrate, if known, is transmitted to the reader thread. If the
     //! writer thread is aware of the exact bitrate, it calls setBitrate() and
@@ -87,6 +94,20 @@ namespace ts {
         //!
         size_t bufferSize() const;
 
+        //!
+        //! Get the number of packets currently in the buffer.
+        //! @return The number of packets which were written and not yet read.
+        //!
+        size_t currentSize() const { return _inCount.load(); }
+
+        //!
+        //! Get the maximum number of packets which were simultaneously in the buffer.
+        //! This fill level can be used to tune the buffer size.
+        //! @return The maximum number of packets which were simultaneously in the buffer
+        //! since the last reset.
+        //!
+        size_t highWaterMark() const { return _highWater.load(); }
+
         //!
         //! Called by the writer thread to get a write buffer.
         //! The writer thread is suspended until enough free space is made in the buffer
@@ -126,7 +147,7 @@ namespace ts {
         //! Check if the reader thread has reported a stop condition.
         //! @return True if the reader thread has reported a stop condition.
         //!
-        bool stopped() const { return _stopped; }
+        bool stopped() const { return _stopped.load(); }
 
         //!
         //! Called by the reader thread to get the next packet without waiting.
@@ -138,6 +159,38 @@ namespace ts {
         //!
         bool getPacket(TSPacket& packet, BitRate& bitrate);
 
+        //!
+        //! Called by the reader thread to get the next packets without waiting.
+        //! The reader thread is never suspended.
+        //! @param [out] buffer Address of packet buffer.
+        //! @param [in] buffer_count Size of @a buffer in number of packets.
+        //! @param [out] bitrate Input bitrate or zero if unknown.
+        //! @return Number of returned packets in @a buffer, zero if none was available
+        //! or an end of file occured.
+        //!
+        size_t readPackets(TSPacket* buffer, size_t buffer_count, BitRate& bitrate);
+
+        //!
+        //! Called by the reader thread to directly access the next packets in the buffer without waiting.
+        //! The reader thread is never suspended. The packets remain in the buffer until
+        //! releaseReadBuffer() is called.
+        //! @param [out] buffer Address of the first available packet in the buffer.
+        //! @param [out] buffer_size Number of contiguous available packets at @a buffer.
+        //! @param [out] bitrate Input bitrate or zero if unknown.
+        //! @param [in] max_size Maximum number of packets to return in the read window.
+        //! @return True if at least one packet is available. False if none was available
+        //! or an end of file occured.
+        //!
+        bool lockReadBuffer(const TSPacket*& buffer, size_t& buffer_size, BitRate& bitrate, size_t max_size = NPOS);
+
+        //!
+        //! Called by the reader thread to release packets which were returned by lockReadBuffer().
+        //! The corresponding space is then available to the writer thread.
+        //! @param [in] count Number of packets to release. Must be no greater than the size
+        //! which was returned by lockReadBuffer().
+        //!
+        void releaseReadBuffer(size_t count);
+
         //!
         //! Called by the reader thread to wait for packets.
         //! The reader thread is suspended until at least one packet is available.
@@ -161,21 +214,28 @@ namespace ts {
         void stop();
 
     private:
-        volatile bool     _eof;         // The writer thread has reported an end of file.
-        volatile bool     _stopped;     // The read thread has reported a stop condition.
-        mutable Mutex     _mutex;       // Protect access to shared data.
-        mutable Condition _enqueued;    // Signaled when packets are inserted.
-        mutable Condition _dequeued;    // Signaled when packets were freed.
-        TSPacketVector    _buffer;      // The packet buffer.
-        PCRAnalyzer       _pcr;         // PCR analyzer to get the bitrate.
-        size_t            _inCount;     // Number of packets currently inside the buffer.
-        size_t            _readIndex;   // Index of next packet to read.
-        size_t            _writeIndex;  // Index of next packet to write.
-        BitRate           _bitrate;     // Bitrate as set by the writer thread.
-
-        // Get bitrate, must be called with mutex held.
+        std::atomic<bool>    _eof;            // The writer thread has reported an end of file.
+        std::atomic<bool>    _stopped;        // The read thread has reported a stop condition.
+        std::atomic<bool>    _readerWaiting;  // The reader thread waits on _enqueued.
+        std::atomic<bool>    _writerWaiting;  // The writer thread waits on _dequeued.
+        mutable Mutex        _mutex;          // Used only to wait for the other thread.
+        mutable Condition    _enqueued;       // Signaled when packets are inserted.
+        mutable Condition    _dequeued;       // Signaled when packets were freed.
+        TSPacketVector       _buffer;         // The packet buffer.
+        PCRAnalyzer          _pcr;            // PCR analyzer to get the bitrate (writer thread only).
+        std::atomic<size_t>  _inCount;        // Number of packets currently inside the buffer.
+        std::atomic<size_t>  _highWater;      // Maximum value of _inCount.
+        size_t               _readIndex;      // Index of next packet to read (reader thread only).
+        size_t               _writeIndex;     // Index of next packet to write (writer thread only).
+        std::atomic<BitRate> _bitrate;        // Bitrate as set by the writer thread.
+        std::atomic<BitRate> _pcrBitrate;     // Bitrate from PCR analysis, zero if unknown.
+
+        // Get bitrate, either from writer thread or from PCR analysis.
         BitRate getBitrate() const;
 
+        // Wake up the other thread if it is waiting on a condition.
+        void signal(std::atomic<bool>& waiting, Condition& condition);
+
         // Inaccessible operations
         TSPacketQueue(const TSPacketQueue&) = delete;
         TSPacketQueue& operator=(const TSPacketQueue&) = delete;
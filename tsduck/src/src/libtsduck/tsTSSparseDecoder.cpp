@@ -0,0 +1,163 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Decoder of sparse transport stream files, without null packets.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSSparseDecoder.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::TSSparseDecoder::TSSparseDecoder() :
+    _sparse(false),
+    _map(),
+    _map_offset(0),
+    _described(0),
+    _nulls(0),
+    _trailing(0),
+    _null(),
+    _errors(0),
+    _checkpoint()
+{
+    _null = NullPacket;
+}
+
+void ts::TSSparseDecoder::reset()
+{
+    _sparse = false;
+    _map_offset = 0;
+    _described = 0;
+    _nulls = 0;
+    _trailing = 0;
+    _null = NullPacket;
+    _errors = 0;
+    _checkpoint = TSSparseEncoder::Checkpoint();
+}
+
+
+//----------------------------------------------------------------------------
+// Read the next null run length in the last map.
+//----------------------------------------------------------------------------
+
+ts::PacketCounter ts::TSSparseDecoder::nextGap()
+{
+    PacketCounter gap = 0;
+    while (_map_offset < PKT_SIZE) {
+        const uint8_t b = _map.b[_map_offset++];
+        gap = (gap << 7) | (b & 0x7F);
+        if ((b & 0x80) == 0) {
+            return gap;
+        }
+    }
+    // Truncated value, corrupted map.
+    return 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Decode units from a sparse file.
+//----------------------------------------------------------------------------
+
+size_t ts::TSSparseDecoder::decode(const TSPacket*& units, size_t& unit_count, TSPacket* buffer, size_t max_packets)
+{
+    size_t count = 0;
+
+    while (count < max_packets) {
+
+        // Output pending null packets first.
+        if (_nulls > 0) {
+            const size_t n = size_t(std::min<PacketCounter>(_nulls, max_packets - count));
+            for (size_t i = 0; i < n; ++i) {
+                buffer[count++] = _null;
+            }
+            _nulls -= n;
+            continue;
+        }
+        if (unit_count == 0) {
+            break;
+        }
+
+        const TSPacket& unit(*units);
+        units++;
+        unit_count--;
+
+        if (TSSparseEncoder::IsMap(unit)) {
+            if (_described > 0) {
+                // Previous map not completed, some units are missing.
+                _errors++;
+            }
+            _sparse = true;
+            _map = unit;
+            _map_offset = TSSparseEncoder::MAP_HEADER_SIZE;
+            _described = GetUInt16(_map.b + 42);
+            _trailing = GetUInt32(_map.b + 44);
+            ::memset(_null.b + 4, _map.b[6], PKT_SIZE - 4);
+            _checkpoint.index = GetUInt64(_map.b + 8);
+            _checkpoint.utc = MilliSecond(GetUInt64(_map.b + 16));
+            _checkpoint.pcr = GetUInt64(_map.b + 24);
+            _checkpoint.pcr_index = GetUInt64(_map.b + 32);
+            _checkpoint.pcr_pid = GetUInt16(_map.b + 40) & 0x1FFF;
+            if (_described > 0) {
+                _nulls = nextGap();
+            }
+            else {
+                _nulls = _trailing;
+                _trailing = 0;
+            }
+        }
+        else if (unit.b[0] != SYNC_BYTE) {
+            // Neither a map nor a packet.
+            _errors++;
+        }
+        else if (!_sparse || _described == 0) {
+            // Not (yet) a sparse file, the units are plain packets.
+            // In a sparse file, this is a stored packet after the last described one (corrupted file).
+            buffer[count++] = unit;
+            if (_sparse) {
+                _errors++;
+            }
+        }
+        else {
+            buffer[count++] = unit;
+            if (--_described > 0) {
+                _nulls = nextGap();
+            }
+            else {
+                _nulls = _trailing;
+                _trailing = 0;
+            }
+        }
+    }
+    return count;
+}
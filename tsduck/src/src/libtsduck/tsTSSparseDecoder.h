@@ -0,0 +1,108 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Decoder of sparse transport stream files, without null packets.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSSparseEncoder.h"
+
+namespace ts {
+    //!
+    //! Decoder of sparse transport stream files, without null packets.
+    //! @ingroup mpeg
+    //!
+    //! The decoder rebuilds the original transport stream, including the null
+    //! packets which were elided by TSSparseEncoder. See TSSparseEncoder for the
+    //! format of sparse files.
+    //!
+    //! Units are returned unmodified up to the first map. Thus, a plain transport
+    //! stream file is returned as is. When the decoding starts in the middle of
+    //! a sparse file, the stored packets before the first map are returned
+    //! without their null packets.
+    //!
+    class TSDUCKDLL TSSparseDecoder
+    {
+    public:
+        //!
+        //! Default constructor.
+        //!
+        TSSparseDecoder();
+
+        //!
+        //! Reset the decoder, start a new sparse file.
+        //!
+        void reset();
+
+        //!
+        //! Decode units from a sparse file.
+        //! @param [in,out] units Address of the first unit to decode. Updated to the first unused unit.
+        //! @param [in,out] unit_count Number of units to decode. Updated to the number of unused units.
+        //! @param [out] buffer Address of the buffer for decoded packets.
+        //! @param [in] max_packets Size of @a buffer in packets.
+        //! @return The number of decoded packets in @a buffer. Zero means that all units were
+        //! decoded and no more null packet is pending.
+        //!
+        size_t decode(const TSPacket*& units, size_t& unit_count, TSPacket* buffer, size_t max_packets);
+
+        //!
+        //! Check if the input is a sparse file.
+        //! @return True when at least one map was found.
+        //!
+        bool isSparse() const { return _sparse; }
+
+        //!
+        //! Get the checkpoint from the last map.
+        //! @return A constant reference to the last checkpoint.
+        //!
+        const TSSparseEncoder::Checkpoint& checkpoint() const { return _checkpoint; }
+
+        //!
+        //! Get the number of invalid or unexpected units in the sparse file.
+        //! @return The number of invalid units.
+        //!
+        PacketCounter errors() const { return _errors; }
+
+    private:
+        bool          _sparse;      // A map was found.
+        TSPacket      _map;         // Last map.
+        size_t        _map_offset;  // Offset of next null run in last map.
+        size_t        _described;   // Number of remaining stored packets which are described by the last map.
+        PacketCounter _nulls;       // Number of pending null packets before the next stored packet.
+        PacketCounter _trailing;    // Number of null packets after the last described packet.
+        TSPacket      _null;        // Null packet template.
+        PacketCounter _errors;      // Number of invalid units.
+        TSSparseEncoder::Checkpoint _checkpoint;
+
+        // Read the next null run length in the last map.
+        PacketCounter nextGap();
+    };
+}
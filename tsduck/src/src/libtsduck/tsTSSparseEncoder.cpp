@@ -0,0 +1,239 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Encoder of sparse transport stream files, without null packets.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSSparseEncoder.h"
+#include "tsTime.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSSparseEncoder::MAP_HEADER_SIZE;
+const uint8_t ts::TSSparseEncoder::MAP_VERSION;
+const uint32_t ts::TSSparseEncoder::MAX_TRAILING_NULLS;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructors.
+//----------------------------------------------------------------------------
+
+ts::TSSparseEncoder::Checkpoint::Checkpoint() :
+    index(0),
+    utc(0),
+    pcr(INVALID_PCR),
+    pcr_index(0),
+    pcr_pid(PID_NULL)
+{
+}
+
+ts::TSSparseEncoder::TSSparseEncoder() :
+    _index(0),
+    _units(0),
+    _gap(0),
+    _fill(0xFF),
+    _last_pcr(),
+    _map_open(false),
+    _map(),
+    _map_size(0),
+    _map_count(0),
+    _stored()
+{
+}
+
+void ts::TSSparseEncoder::reset()
+{
+    _index = 0;
+    _units = 0;
+    _gap = 0;
+    _fill = 0xFF;
+    _last_pcr = Checkpoint();
+    _map_open = false;
+    _map_size = 0;
+    _map_count = 0;
+    _stored.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Static helpers.
+//----------------------------------------------------------------------------
+
+bool ts::TSSparseEncoder::IsMap(const TSPacket& unit)
+{
+    return unit.b[0] == 0x00 && unit.b[1] == 'T' && unit.b[2] == 'S' && unit.b[3] == 'S' && unit.b[4] == 'P' && unit.b[5] == MAP_VERSION;
+}
+
+bool ts::TSSparseEncoder::IsElidable(const TSPacket& pkt, uint8_t& fill)
+{
+    // Header: PID 0x1FFF, payload only, CC zero, followed by 184 identical bytes.
+    if (pkt.b[0] != SYNC_BYTE || pkt.b[1] != 0x1F || pkt.b[2] != 0xFF || pkt.b[3] != 0x10) {
+        return false;
+    }
+    fill = pkt.b[4];
+    for (size_t i = 5; i < PKT_SIZE; ++i) {
+        if (pkt.b[i] != fill) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Encode TS packets.
+//----------------------------------------------------------------------------
+
+void ts::TSSparseEncoder::encode(const TSPacket* buffer, size_t packet_count, TSPacketVector& out)
+{
+    for (size_t i = 0; i < packet_count; ++i) {
+        const TSPacket& pkt(buffer[i]);
+        uint8_t fill = 0;
+
+        if (IsElidable(pkt, fill)) {
+            // A map describes null packets with only one payload byte. Close it on change.
+            if (fill != _fill) {
+                if (_map_open || _gap > 0) {
+                    if (!_map_open) {
+                        openMap();
+                    }
+                    closeMap(out, _gap);
+                    _gap = 0;
+                }
+                _fill = fill;
+            }
+            _gap++;
+            _index++;
+            // Force a checkpoint in long stuffing periods.
+            if (_gap >= MAX_TRAILING_NULLS) {
+                if (!_map_open) {
+                    openMap();
+                }
+                closeMap(out, _gap);
+                _gap = 0;
+            }
+        }
+        else {
+            // Stored packet, preceded by the current null run.
+            if (!_map_open) {
+                openMap();
+            }
+            if (!addGap(_gap)) {
+                // The map is full, the null run goes into the next one.
+                closeMap(out, 0);
+                openMap();
+                addGap(_gap);
+            }
+            _stored.push_back(pkt);
+            _map_count++;
+            _gap = 0;
+            if (pkt.hasPCR()) {
+                _last_pcr.pcr = pkt.getPCR();
+                _last_pcr.pcr_index = _index;
+                _last_pcr.pcr_pid = pkt.getPID();
+            }
+            _index++;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Flush all pending packets and null runs.
+//----------------------------------------------------------------------------
+
+void ts::TSSparseEncoder::flush(TSPacketVector& out)
+{
+    if (_map_open || _gap > 0) {
+        if (!_map_open) {
+            openMap();
+        }
+        closeMap(out, _gap);
+        _gap = 0;
+    }
+}
+
+size_t ts::TSSparseEncoder::pendingUnits() const
+{
+    return _map_open ? 1 + _stored.size() : (_gap > 0 ? 1 : 0);
+}
+
+
+//----------------------------------------------------------------------------
+// Map management.
+//----------------------------------------------------------------------------
+
+void ts::TSSparseEncoder::openMap()
+{
+    ::memset(_map.b, 0, PKT_SIZE);
+    _map.b[1] = 'T';
+    _map.b[2] = 'S';
+    _map.b[3] = 'S';
+    _map.b[4] = 'P';
+    _map.b[5] = MAP_VERSION;
+    _map.b[6] = _fill;
+    PutUInt64(_map.b + 8, _index - _gap);
+    PutUInt64(_map.b + 16, uint64_t(Time::CurrentUTC() - Time::UnixEpoch));
+    PutUInt64(_map.b + 24, _last_pcr.pcr);
+    PutUInt64(_map.b + 32, _last_pcr.pcr_index);
+    PutUInt16(_map.b + 40, _last_pcr.pcr_pid);
+    _map_size = MAP_HEADER_SIZE;
+    _map_count = 0;
+    _map_open = true;
+}
+
+void ts::TSSparseEncoder::closeMap(TSPacketVector& out, PacketCounter trailing)
+{
+    PutUInt16(_map.b + 42, uint16_t(_map_count));
+    PutUInt32(_map.b + 44, uint32_t(trailing));
+    out.push_back(_map);
+    out.insert(out.end(), _stored.begin(), _stored.end());
+    _units += 1 + _stored.size();
+    _stored.clear();
+    _map_open = false;
+}
+
+bool ts::TSSparseEncoder::addGap(PacketCounter gap)
+{
+    // Number of 7-bit groups in the value.
+    size_t size = 1;
+    for (PacketCounter v = gap >> 7; v != 0; v >>= 7) {
+        size++;
+    }
+    if (_map_size + size > PKT_SIZE || _map_count >= 0xFFFF) {
+        return false;
+    }
+    // Most significant groups first, continuation bit on all bytes but the last one.
+    for (size_t i = size; i > 0; --i) {
+        _map.b[_map_size++] = uint8_t((gap >> (7 * (i - 1))) & 0x7F) | (i > 1 ? 0x80 : 0x00);
+    }
+    return true;
+}
@@ -0,0 +1,196 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Encoder of sparse transport stream files, without null packets.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+#include "tsMPEG.h"
+
+namespace ts {
+    //!
+    //! Encoder of sparse transport stream files, without null packets.
+    //! @ingroup mpeg
+    //!
+    //! A sparse file contains all packets of the original stream except the stuffing,
+    //! which is run-length coded. Reading it back with TSSparseDecoder rebuilds the exact
+    //! original stream, null packets included.
+    //!
+    //! Only null packets which exactly match a constant template are elided: PID 0x1FFF,
+    //! payload only, continuity counter zero and a payload made of identical bytes (0xFF
+    //! as in the standard, or any other value, see the map format). Other null packets
+    //! are stored as is.
+    //!
+    //! A sparse file is a sequence of 188-byte units. Therefore, the existing packet-based
+    //! file I/O and tools can be used on sparse files. Each unit is either a stored TS
+    //! packet, starting with the 0x47 sync byte, or a "map", starting with a zero byte.
+    //! A map describes the null runs around the next stored packets. It also contains
+    //! a checkpoint: the position of the first described packet in the original stream,
+    //! the system time of the recording and the last PCR before the described packets.
+    //! A sparse file always starts with a map.
+    //!
+    //! Binary format of a map, all integers are big endian:
+    //! - 0: 0x00 (never a sync byte)
+    //! - 1-4: "TSSP" (ASCII)
+    //! - 5: format version (currently 1)
+    //! - 6: payload byte of the elided null packets
+    //! - 7: reserved, zero
+    //! - 8-15: index in the original stream of the first packet which is described by the map
+    //! - 16-23: UTC time of the recording in milliseconds since 1970-01-01 (checkpoint)
+    //! - 24-31: last PCR before the described packets, all ones if there is none
+    //! - 32-39: index in the original stream of the packet carrying the last PCR
+    //! - 40-41: PID of the last PCR
+    //! - 42-43: number N of stored packets which follow the map
+    //! - 44-47: number of null packets after the N stored packets
+    //! - 48-187: N variable-length integers, the number of null packets before
+    //!   each stored packet. Each byte contains 7 bits of value, most significant
+    //!   bits first. The most significant bit of the byte is set when more bytes follow.
+    //!   Unused bytes are zero.
+    //!
+    class TSDUCKDLL TSSparseEncoder
+    {
+    public:
+        //!
+        //! Size in bytes of the map header, before the null run lengths.
+        //!
+        static const size_t MAP_HEADER_SIZE = 48;
+
+        //!
+        //! Format version of the maps.
+        //!
+        static const uint8_t MAP_VERSION = 1;
+
+        //!
+        //! Maximum number of trailing null packets in a map.
+        //! A map is forced after this number of consecutive null packets, providing
+        //! periodic checkpoints even when the stream contains only stuffing.
+        //!
+        static const uint32_t MAX_TRAILING_NULLS = 100000;
+
+        //!
+        //! Checkpoint information which is stored in each map.
+        //!
+        struct TSDUCKDLL Checkpoint
+        {
+            PacketCounter index;      //!< Index in the original stream of the first packet which is described by the map.
+            MilliSecond   utc;        //!< UTC time of the recording in milliseconds since 1970-01-01.
+            uint64_t      pcr;        //!< Last PCR before the described packets, INVALID_PCR if there is none.
+            PacketCounter pcr_index;  //!< Index in the original stream of the packet carrying the last PCR.
+            PID           pcr_pid;    //!< PID of the last PCR, PID_NULL if there is none.
+
+            //!
+            //! Constructor.
+            //!
+            Checkpoint();
+        };
+
+        //!
+        //! Check if a 188-byte unit from a sparse file is a map.
+        //! @param [in] unit A 188-byte unit.
+        //! @return True if @a unit is a valid map.
+        //!
+        static bool IsMap(const TSPacket& unit);
+
+        //!
+        //! Check if a packet is a null packet which can be elided.
+        //! @param [in] pkt A TS packet.
+        //! @param [out] fill The payload byte of the null packet.
+        //! @return True if @a pkt is a null packet which matches the template.
+        //!
+        static bool IsElidable(const TSPacket& pkt, uint8_t& fill);
+
+        //!
+        //! Default constructor.
+        //!
+        TSSparseEncoder();
+
+        //!
+        //! Reset the encoder, start a new sparse file.
+        //! Pending packets, if any, are lost. Call flush() first.
+        //!
+        void reset();
+
+        //!
+        //! Encode TS packets.
+        //! The encoder keeps a map and its stored packets until the map is full.
+        //! @param [in] buffer Address of the first packet to encode.
+        //! @param [in] packet_count Number of packets to encode.
+        //! @param [in,out] out The completed units are appended to this vector.
+        //!
+        void encode(const TSPacket* buffer, size_t packet_count, TSPacketVector& out);
+
+        //!
+        //! Flush all pending packets and null runs, typically at end of file.
+        //! @param [in,out] out The pending units are appended to this vector.
+        //!
+        void flush(TSPacketVector& out);
+
+        //!
+        //! Get the number of pending units, not yet returned by encode().
+        //! @return The number of pending units, including the map.
+        //!
+        size_t pendingUnits() const;
+
+        //!
+        //! Get the number of encoded packets from the original stream.
+        //! @return The number of encoded packets.
+        //!
+        PacketCounter inputPackets() const { return _index; }
+
+        //!
+        //! Get the number of units which were returned by encode() and flush().
+        //! @return The number of output units.
+        //!
+        PacketCounter outputUnits() const { return _units; }
+
+    private:
+        PacketCounter  _index;       // Index in the original stream of the next packet.
+        PacketCounter  _units;       // Number of output units.
+        PacketCounter  _gap;         // Number of null packets since the last stored packet.
+        uint8_t        _fill;        // Payload byte of the last null packet.
+        Checkpoint     _last_pcr;    // Last PCR in the stream (only pcr fields are used).
+        bool           _map_open;    // A map is being built.
+        TSPacket       _map;         // Map which is being built.
+        size_t         _map_size;    // Used bytes in the map.
+        size_t         _map_count;   // Number of stored packets in the map.
+        TSPacketVector _stored;      // Stored packets after the map.
+
+        // Start a new map. The current null run is the first one in the map.
+        void openMap();
+
+        // Complete the current map with trailing nulls and output it with its stored packets.
+        void closeMap(TSPacketVector& out, PacketCounter trailing);
+
+        // Append a null run length in the current map. Return false if the map is full.
+        bool addGap(PacketCounter gap);
+    };
+}
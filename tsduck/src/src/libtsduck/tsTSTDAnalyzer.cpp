@@ -0,0 +1,854 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSTDAnalyzer.h"
+#include "tsTSTDHandlerInterface.h"
+#include "tsBinaryTable.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsSTDDescriptor.h"
+#include "tsSmoothingBufferDescriptor.h"
+#include "tsMultiplexBufferUtilizationDescriptor.h"
+#include <cmath>
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::TSTDAnalyzer::TB_SIZE;
+#endif
+
+const ts::Enumeration ts::TSTDAnalyzer::ViolationNames({
+    {u"TB_overflow",  ts::TSTDAnalyzer::TB_OVERFLOW},
+    {u"MB_overflow",  ts::TSTDAnalyzer::MB_OVERFLOW},
+    {u"EB_overflow",  ts::TSTDAnalyzer::EB_OVERFLOW},
+    {u"EB_underflow", ts::TSTDAnalyzer::EB_UNDERFLOW},
+});
+
+// Buffer model parameters from ISO/IEC 13818-1, section 2.4.2 and ATSC A/52.
+namespace {
+    const ts::BitRate AUDIO_RX          = 2000000;   // Rx for audio streams.
+    const size_t      MPEG_AUDIO_BSIZE  = 3584;      // Size of B for MPEG and AAC audio.
+    const size_t      AC3_AUDIO_BSIZE   = 5696;      // Size of B for AC-3 and E-AC-3 audio.
+    const double      MAX_PCR_JUMP      = 100.0 * (ts::SYSTEM_CLOCK_FREQ / 1000);  // Max interval between PCR's, in PCR units.
+    const double      LEVEL_TOLERANCE   = 0.5;       // Tolerance on buffer levels, in bytes, for rounding errors.
+    const size_t      MAX_ACCESS_UNITS  = 512;       // Max number of access units in buffers before resynchronization.
+
+    // MPEG-2 video profiles and levels from ITU-T H.262, tables 8-12 and 8-14:
+    // Rmax in b/s and VBV_max in bits. High-1440 and High levels use another Rbx and MB size.
+    struct MPEG2Level {
+        uint8_t  pl_code;     // profile_and_level_indication
+        uint32_t rmax;
+        uint32_t vbv_max;
+        bool     high;
+    };
+    const MPEG2Level MPEG2Levels[] = {
+        {0x58,  15000000,  1835008, false},  // Simple@Main
+        {0x4A,   4000000,   475136, false},  // Main@Low
+        {0x48,  15000000,  1835008, false},  // Main@Main
+        {0x46,  60000000,  7340032, true},   // Main@High-1440
+        {0x44,  80000000,  9781248, true},   // Main@High
+        {0x3A,   4000000,   475136, false},  // SNR@Low
+        {0x38,  15000000,  1835008, false},  // SNR@Main
+        {0x26,  60000000,  7340032, true},   // Spatial@High-1440
+        {0x18,  20000000,  2441216, false},  // High@Main
+        {0x16,  80000000,  9781248, true},   // High@High-1440
+        {0x14, 100000000, 12222464, true},   // High@High
+        {0x85,  50000000,  9437184, false},  // 4:2:2@Main
+        {0x82, 300000000, 47185920, true},   // 4:2:2@High
+    };
+
+    // AVC levels from ITU-T H.264, table A-1: MaxBR and MaxCPB, in units of 1000 bits (VCL).
+    struct AVCLevel {
+        int      level;
+        uint32_t max_br;
+        uint32_t max_cpb;
+    };
+    const AVCLevel AVCLevels[] = {
+        { 9,    128,    350},  // Level 1b
+        {10,     64,    175},
+        {11,    192,    500},
+        {12,    384,   1000},
+        {13,    768,   2000},
+        {20,   2000,   2000},
+        {21,   4000,   4000},
+        {22,   4000,   4000},
+        {30,  10000,  10000},
+        {31,  14000,  14000},
+        {32,  20000,  20000},
+        {40,  20000,  25000},
+        {41,  50000,  62500},
+        {42,  50000,  62500},
+        {50, 135000, 135000},
+        {51, 240000, 240000},
+        {52, 240000, 240000},
+    };
+
+    // AVC cpbBrNalFactor from ITU-T H.264, table A-2, depending on profile.
+    uint32_t AVCNalFactor(int profile)
+    {
+        switch (profile) {
+            case 100: return 1500;  // High
+            case 110: return 3600;  // High 10
+            case 122:               // High 4:2:2
+            case 244: return 4800;  // High 4:4:4 Predictive
+            default:  return 1200;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::TSTDAnalyzer::Event::Event() :
+    violation(VIOLATION_COUNT),
+    raised(false),
+    timestamp(0),
+    pid(PID_NULL),
+    service_id(0),
+    details()
+{
+}
+
+ts::TSTDAnalyzer::StreamStatus::StreamStatus() :
+    pid(PID_NULL),
+    service_id(0),
+    stream_type(ST_NULL),
+    simulated(false),
+    has_mb(false),
+    rx(0),
+    rbx(0),
+    tb_size(0),
+    mb_size(0),
+    eb_size(0),
+    tb_level(0),
+    mb_level(0),
+    eb_level(0),
+    tb_max(0),
+    mb_max(0),
+    eb_max(0),
+    access_units(0),
+    violations(),
+    has_ltw(false),
+    ltw_lower(0),
+    ltw_upper(0)
+{
+}
+
+ts::TSTDAnalyzer::Clock::Clock() :
+    has_pcr(false),
+    valid(false),
+    last_raw(0),
+    offset(0),
+    origin(0),
+    pcr(0),
+    index(0),
+    pkt_ticks(0.0),
+    pids()
+{
+}
+
+ts::TSTDAnalyzer::Stream::Stream() :
+    pid(PID_NULL),
+    service_id(0),
+    stream_type(ST_NULL),
+    pcr_pid(PID_NULL),
+    configured(false),
+    leak_method(true),
+    has_mb(false),
+    has_sb(false),
+    sb_size(0),
+    sb_rate(0),
+    has_ltw(false),
+    ltw_lower(0),
+    ltw_upper(0),
+    has_video(false),
+    video_rmax(0),
+    video_rbx(0),
+    video_mb(0),
+    video_eb(0),
+    rx(0),
+    rbx(0),
+    rx_ticks(0.0),
+    rbx_ticks(0.0),
+    tb_size(0.0),
+    mb_size(0.0),
+    eb_size(0.0),
+    tb(0.0),
+    tb_payload(0.0),
+    mb(0.0),
+    eb(0.0),
+    tb_max(0.0),
+    mb_max(0.0),
+    eb_max(0.0),
+    sync(false),
+    started(false),
+    time(0.0),
+    cc(0),
+    access_units(0),
+    aus(),
+    active(),
+    count()
+{
+}
+
+ts::TSTDAnalyzer::TSTDAnalyzer(TSTDHandlerInterface* handler) :
+    _handler(handler),
+    _pid_filter(AllPIDs),
+    _packet_count(0),
+    _violation_count(),
+    _demux(this),
+    _pes_demux(this, NoPID),
+    _streams(),
+    _clocks(),
+    _pid_stream(),
+    _pid_clock()
+{
+    reset();
+}
+
+ts::TSTDAnalyzer::~TSTDAnalyzer()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the analysis context.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::reset()
+{
+    _packet_count = 0;
+    for (size_t i = 0; i < VIOLATION_COUNT; ++i) {
+        _violation_count[i] = 0;
+    }
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        _pid_stream[pid] = nullptr;
+        _pid_clock[pid] = nullptr;
+    }
+    _streams.clear();
+    _clocks.clear();
+    _demux.reset();
+    _demux.setPIDFilter(NoPID);
+    _demux.addPID(PID_PAT);
+    _pes_demux.reset();
+    _pes_demux.setPIDFilter(NoPID);
+}
+
+
+//----------------------------------------------------------------------------
+// Get the simulation status of all elementary streams.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::getStatus(StreamStatusVector& status) const
+{
+    status.clear();
+    status.reserve(_streams.size());
+    for (auto it = _streams.begin(); it != _streams.end(); ++it) {
+        const Stream& st(it->second);
+        status.push_back(StreamStatus());
+        StreamStatus& ss(status.back());
+        ss.pid = st.pid;
+        ss.service_id = st.service_id;
+        ss.stream_type = st.stream_type;
+        ss.simulated = st.configured;
+        ss.has_mb = st.has_mb;
+        ss.rx = st.rx;
+        ss.rbx = st.has_mb ? st.rbx : 0;
+        ss.tb_size = size_t(st.tb_size);
+        ss.mb_size = st.has_mb ? size_t(st.mb_size) : 0;
+        ss.eb_size = size_t(st.eb_size);
+        ss.tb_level = size_t(st.tb);
+        ss.mb_level = size_t(st.mb);
+        ss.eb_level = size_t(st.eb);
+        ss.tb_max = size_t(st.tb_max);
+        ss.mb_max = size_t(st.mb_max);
+        ss.eb_max = size_t(st.eb_max);
+        ss.access_units = st.access_units;
+        for (size_t i = 0; i < VIOLATION_COUNT; ++i) {
+            ss.violations[i] = st.count[i];
+        }
+        ss.has_ltw = st.has_ltw;
+        ss.ltw_lower = st.ltw_lower;
+        ss.ltw_upper = st.ltw_upper;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Analyze a TS packet.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::feedPacket(const TSPacket& pkt)
+{
+    const PacketCounter index = _packet_count++;
+    if (!pkt.hasValidSync() || pkt.getTEI()) {
+        return;
+    }
+
+    const PID pid = pkt.getPID();
+    _demux.feedPacket(pkt);
+    _pes_demux.feedPacket(pkt);
+
+    // Update the time line of the program when the packet contains a PCR.
+    Clock* const clock = _pid_clock[pid];
+    if (clock != nullptr && pkt.hasPCR()) {
+        const bool continuous = processPCR(*clock, pkt, index);
+        for (auto it = clock->pids.begin(); it != clock->pids.end(); ++it) {
+            Stream& st(*_pid_stream[*it]);
+            if (!continuous) {
+                // Time line discontinuity, restart the simulation of all streams in the program.
+                restart(st);
+            }
+            else if (clock->valid && st.configured && st.started) {
+                // Decode access units on time, even when the PID of the stream is sparse.
+                advance(st, *clock, double(clock->pcr));
+            }
+        }
+    }
+
+    // Simulate the elementary stream buffers.
+    Stream* const st = _pid_stream[pid];
+    if (st != nullptr && st->configured && st->pcr_pid < PID_MAX) {
+        const Clock* const stclock = _pid_clock[st->pcr_pid];
+        if (stclock != nullptr && stclock->valid) {
+            processPacket(*st, *stclock, pkt, index);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Process a PCR, return false on time line discontinuity.
+//----------------------------------------------------------------------------
+
+bool ts::TSTDAnalyzer::processPCR(Clock& clock, const TSPacket& pkt, PacketCounter index)
+{
+    const uint64_t raw = pkt.getPCR();
+    const uint64_t wrap = PTS_DTS_SCALE * SYSTEM_CLOCK_SUBFACTOR;
+
+    // Unwrap the PCR on a continuous time line.
+    if (clock.has_pcr && raw < clock.last_raw && clock.last_raw - raw > wrap / 2) {
+        clock.offset += wrap;
+    }
+    const uint64_t pcr = raw + clock.offset;
+
+    bool continuous = clock.has_pcr && !pkt.getDiscontinuityIndicator() && pcr > clock.pcr && index > clock.index;
+    if (continuous && double(pcr - clock.pcr) > MAX_PCR_JUMP) {
+        continuous = false;
+    }
+
+    if (continuous) {
+        // Duration of a packet, at the transport rate between the last two PCR's.
+        clock.pkt_ticks = double(pcr - clock.pcr) / double(index - clock.index);
+        clock.valid = true;
+    }
+    else {
+        // First PCR or discontinuity, restart a new time line.
+        const bool restarted = clock.has_pcr;
+        clock.has_pcr = true;
+        clock.valid = false;
+        clock.offset = 0;
+        clock.origin = raw;
+        clock.pcr = raw;
+        clock.last_raw = raw;
+        clock.index = index;
+        return !restarted;
+    }
+
+    clock.last_raw = raw;
+    clock.pcr = pcr;
+    clock.index = index;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Process a TS packet of an elementary stream.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::processPacket(Stream& st, const Clock& clock, const TSPacket& pkt, PacketCounter index)
+{
+    // Arrival time of the first byte of the packet.
+    const double time = double(clock.pcr) + double(index - clock.index) * clock.pkt_ticks;
+
+    if (!st.started) {
+        st.started = true;
+        st.time = time;
+    }
+    advance(st, clock, time);
+
+    // PES data are not visible in scrambled packets.
+    if (pkt.getScrambling() != SC_CLEAR) {
+        if (st.sync) {
+            restart(st);
+        }
+        return;
+    }
+
+    // Duplicate packets are discarded by the T-STD.
+    const size_t pl_size = pkt.getPayloadSize();
+    if (st.sync && pl_size > 0 && pkt.getCC() == st.cc && !pkt.getDiscontinuityIndicator()) {
+        return;
+    }
+
+    // Each PES packet with a time stamp starts a new access unit.
+    if (pkt.getPUSI() && pl_size >= 6 && (pkt.hasDTS() || pkt.hasPTS())) {
+        const double scale = double(PTS_DTS_SCALE * SYSTEM_CLOCK_SUBFACTOR);
+        const double stamp = double((pkt.hasDTS() ? pkt.getDTS() : pkt.getPTS()) * SYSTEM_CLOCK_SUBFACTOR);
+        const uint8_t* const pl = pkt.getPayload();
+        const size_t pes_length = GetUInt16(pl + 4);
+        if (!st.aus.empty()) {
+            st.aus.back().complete = true;
+        }
+        AccessUnit au;
+        au.dts = stamp + scale * std::floor((time - stamp) / scale + 0.5);  // Unwrap on the time line of the program.
+        au.size = 0.0;
+        au.expected = pes_length == 0 ? 0.0 : double(pes_length + 6);
+        au.complete = false;
+        au.late = false;
+        st.aus.push_back(au);
+        st.sync = true;
+    }
+    if (!st.sync) {
+        return;
+    }
+    if (pl_size > 0) {
+        st.cc = pkt.getCC();
+    }
+
+    // The complete TS packet enters TB, only the PES data are transferred to the next buffers.
+    AccessUnit& au(st.aus.back());
+    au.size += double(pl_size);
+    au.complete = au.expected > 0.0 && au.size >= au.expected;
+    st.tb += double(PKT_SIZE);
+    st.tb_payload += double(pl_size);
+
+    // The packet is received during one packet duration, leak during that time before checking the levels.
+    advance(st, clock, time + clock.pkt_ticks);
+
+    if (st.aus.size() > MAX_ACCESS_UNITS) {
+        // Too many late access units, the model diverged from the stream, resynchronize.
+        restart(st);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Move the simulation of a stream up to a given time.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::advance(Stream& st, const Clock& clock, double time)
+{
+    while (!st.aus.empty() && st.aus.front().dts <= time) {
+        AccessUnit& au(st.aus.front());
+        if (au.dts > st.time) {
+            leak(st, au.dts - st.time);
+            st.time = au.dts;
+            checkLevels(st, clock);
+        }
+        if (au.complete && st.eb + LEVEL_TOLERANCE >= au.size) {
+            // The access unit is instantaneously removed from EB, at its decoding time or later.
+            const bool late = au.late;
+            st.eb = std::max(0.0, st.eb - au.size);
+            st.access_units++;
+            st.aus.pop_front();
+            if (!late) {
+                setViolation(st, clock, EB_UNDERFLOW, false);
+            }
+        }
+        else {
+            // Not all data of the access unit are in EB, its decoding is delayed.
+            if (!au.late) {
+                au.late = true;
+                setViolation(st, clock, EB_UNDERFLOW, true,
+                             UString::Format(u"access unit of %'d bytes, %'d bytes in EB at decoding time", {size_t(au.size), size_t(st.eb)}));
+            }
+            break;
+        }
+    }
+    if (time > st.time) {
+        leak(st, time - st.time);
+        st.time = time;
+    }
+    checkLevels(st, clock);
+}
+
+
+//----------------------------------------------------------------------------
+// Leak the buffers of a stream during a given duration.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::leak(Stream& st, double duration)
+{
+    // TB is emptied at rate Rx, TS headers are discarded.
+    if (st.tb > 0.0) {
+        const double out = std::min(st.tb, st.rx_ticks * duration);
+        const double payload = st.tb_payload * out / st.tb;
+        st.tb -= out;
+        st.tb_payload -= payload;
+        if (st.has_mb) {
+            st.mb += payload;
+        }
+        else {
+            st.eb += payload;
+        }
+    }
+
+    // MB is emptied at rate Rbx into EB (leak method).
+    if (st.has_mb && st.mb > 0.0) {
+        const double out = std::min(st.mb, st.rbx_ticks * duration);
+        st.mb -= out;
+        st.eb += out;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Check the levels of the buffers of a stream.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::checkLevels(Stream& st, const Clock& clock)
+{
+    st.tb_max = std::max(st.tb_max, st.tb);
+    st.mb_max = std::max(st.mb_max, st.mb);
+    st.eb_max = std::max(st.eb_max, st.eb);
+
+    if (st.tb > st.tb_size + LEVEL_TOLERANCE) {
+        setViolation(st, clock, TB_OVERFLOW, true, UString::Format(u"TB level %'d bytes, size %'d bytes", {size_t(st.tb), size_t(st.tb_size)}));
+    }
+    else if (st.active[TB_OVERFLOW]) {
+        setViolation(st, clock, TB_OVERFLOW, false);
+    }
+    if (st.has_mb && st.mb > st.mb_size + LEVEL_TOLERANCE) {
+        setViolation(st, clock, MB_OVERFLOW, true, UString::Format(u"MB level %'d bytes, size %'d bytes", {size_t(st.mb), size_t(st.mb_size)}));
+    }
+    else if (st.active[MB_OVERFLOW]) {
+        setViolation(st, clock, MB_OVERFLOW, false);
+    }
+    if (st.eb > st.eb_size + LEVEL_TOLERANCE) {
+        setViolation(st, clock, EB_OVERFLOW, true, UString::Format(u"EB level %'d bytes, size %'d bytes", {size_t(st.eb), size_t(st.eb_size)}));
+    }
+    else if (st.active[EB_OVERFLOW]) {
+        setViolation(st, clock, EB_OVERFLOW, false);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Restart the simulation of a stream with empty buffers.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::restart(Stream& st)
+{
+    st.tb = st.tb_payload = st.mb = st.eb = 0.0;
+    st.sync = false;
+    st.started = false;
+    st.aus.clear();
+
+    // Active violations are meaningless in the new context.
+    const Clock* const clock = st.pcr_pid < PID_MAX ? _pid_clock[st.pcr_pid] : nullptr;
+    for (size_t i = 0; i < VIOLATION_COUNT; ++i) {
+        if (st.active[i] && clock != nullptr) {
+            setViolation(st, *clock, Violation(i), false);
+        }
+        st.active[i] = false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Raise or clear a violation.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::setViolation(Stream& st, const Clock& clock, Violation violation, bool active, const UString& details)
+{
+    if (active == st.active[violation]) {
+        return;
+    }
+    st.active[violation] = active;
+    if (active) {
+        st.count[violation]++;
+        _violation_count[violation]++;
+    }
+    if (_handler != nullptr) {
+        Event event;
+        event.violation = violation;
+        event.raised = active;
+        event.timestamp = NanoSecond((st.time - double(clock.origin)) * 1000.0 / double(SYSTEM_CLOCK_FREQ / 1000000));
+        event.pid = st.pid;
+        event.service_id = st.service_id;
+        event.details = details;
+        _handler->handleTSTDEvent(*this, event);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Set the buffer model of a stream.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::configure(Stream& st, BitRate rx, BitRate rbx, size_t mb_size, size_t eb_size)
+{
+    st.configured = true;
+    st.has_mb = mb_size > 0;
+    st.rx = rx;
+    st.rbx = rbx;
+    st.rx_ticks = double(rx) / (8.0 * SYSTEM_CLOCK_FREQ);
+    st.rbx_ticks = double(rbx) / (8.0 * SYSTEM_CLOCK_FREQ);
+    st.tb_size = double(TB_SIZE);
+    st.mb_size = double(mb_size);
+    st.eb_size = double(eb_size);
+}
+
+void ts::TSTDAnalyzer::setVideoModel(Stream& st, BitRate rmax, BitRate rbx, size_t mb_size, size_t eb_size)
+{
+    st.has_video = true;
+    st.video_rmax = rmax;
+    st.video_rbx = rbx;
+    st.video_mb = mb_size;
+    st.video_eb = eb_size;
+    configureVideo(st);
+}
+
+void ts::TSTDAnalyzer::configureVideo(Stream& st)
+{
+    size_t mb_size = st.video_mb;
+    BitRate rbx = st.video_rbx;
+
+    if (st.has_sb) {
+        mb_size = st.sb_size;
+        if (st.sb_rate > 0) {
+            rbx = st.sb_rate;
+        }
+    }
+    if (!st.leak_method) {
+        // With the vbv_delay method, MB is considered as transparent.
+        mb_size = 0;
+        rbx = 0;
+    }
+    configure(st, BitRate(1.2 * st.video_rmax), rbx, mb_size, st.video_eb);
+}
+
+
+//----------------------------------------------------------------------------
+// Attach a stream to the time line of a PCR PID.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::attach(Stream& st, PID pcr_pid)
+{
+    if (st.pcr_pid != pcr_pid && st.pcr_pid < PID_MAX && _pid_clock[st.pcr_pid] != nullptr) {
+        std::vector<PID>& pids(_pid_clock[st.pcr_pid]->pids);
+        pids.erase(std::remove(pids.begin(), pids.end(), st.pid), pids.end());
+    }
+    if (pcr_pid < PID_NULL) {
+        if (_pid_clock[pcr_pid] == nullptr) {
+            _pid_clock[pcr_pid] = &_clocks[pcr_pid];
+        }
+        std::vector<PID>& pids(_pid_clock[pcr_pid]->pids);
+        if (std::find(pids.begin(), pids.end(), st.pid) == pids.end()) {
+            pids.push_back(st.pid);
+        }
+    }
+    st.pcr_pid = pcr_pid;
+}
+
+
+//----------------------------------------------------------------------------
+// Process a PMT.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::processPMT(const PMT& pmt)
+{
+    for (auto it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
+        const PID pid = it->first;
+        const PMT::Stream& es(it->second);
+        if (!_pid_filter.test(pid)) {
+            continue;
+        }
+
+        // Create or update the stream.
+        Stream& st(_streams[pid]);
+        _pid_stream[pid] = &st;
+        if (st.stream_type != es.stream_type || st.pcr_pid != pmt.pcr_pid) {
+            restart(st);
+            st.configured = false;
+            st.has_video = false;
+        }
+        st.pid = pid;
+        st.service_id = pmt.service_id;
+        st.stream_type = es.stream_type;
+        attach(st, pmt.pcr_pid);
+
+        // Buffer-related descriptors, the defaults apply when a PMT update removes them.
+        st.leak_method = true;
+        st.has_sb = false;
+        st.has_ltw = false;
+        size_t index = es.descs.search(DID_STD);
+        if (index < es.descs.count()) {
+            const STDDescriptor desc(*es.descs[index]);
+            st.leak_method = !desc.isValid() || desc.leak_valid;
+        }
+        index = es.descs.search(DID_SMOOTH_BUF);
+        if (index < es.descs.count()) {
+            const SmoothingBufferDescriptor desc(*es.descs[index]);
+            st.has_sb = desc.isValid();
+            st.sb_size = desc.sb_size;
+            st.sb_rate = BitRate(desc.sb_leak_rate * 400);
+        }
+        index = es.descs.search(DID_MUX_BUF_USE);
+        if (index < es.descs.count()) {
+            const MultiplexBufferUtilizationDescriptor desc(*es.descs[index]);
+            st.has_ltw = desc.isValid() && desc.LTW_offset_lower_bound.set() && desc.LTW_offset_upper_bound.set();
+            st.ltw_lower = desc.LTW_offset_lower_bound.value(0);
+            st.ltw_upper = desc.LTW_offset_upper_bound.value(0);
+        }
+
+        // Buffer model, depending on the stream type.
+        switch (es.stream_type) {
+            case ST_MPEG1_AUDIO:
+            case ST_MPEG2_AUDIO:
+            case ST_AAC_AUDIO:
+            case ST_MPEG4_AUDIO:
+                configure(st, AUDIO_RX, 0, 0, MPEG_AUDIO_BSIZE);
+                break;
+            case ST_AC3_AUDIO:
+            case ST_EAC3_AUDIO:
+                configure(st, AUDIO_RX, 0, 0, AC3_AUDIO_BSIZE);
+                break;
+            case ST_PES_PRIV:
+                if (es.descs.search(DID_AC3) < es.descs.count() || es.descs.search(DID_ENHANCED_AC3) < es.descs.count()) {
+                    configure(st, AUDIO_RX, 0, 0, AC3_AUDIO_BSIZE);
+                }
+                break;
+            case ST_MPEG1_VIDEO:
+            case ST_MPEG2_VIDEO:
+            case ST_AVC_VIDEO:
+                // The buffer model depends on the video attributes, configured later.
+                // When they are already known, apply the new descriptors.
+                _pes_demux.addPID(pid);
+                if (st.has_video) {
+                    configureVideo(st);
+                }
+                break;
+            default:
+                // Not simulated.
+                break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux when a complete table is available.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    switch (table.tableId()) {
+        case TID_PAT: {
+            const PAT pat(table);
+            if (pat.isValid()) {
+                for (auto it = pat.pmts.begin(); it != pat.pmts.end(); ++it) {
+                    _demux.addPID(it->second);
+                }
+            }
+            break;
+        }
+        case TID_PMT: {
+            const PMT pmt(table);
+            if (pmt.isValid()) {
+                processPMT(pmt);
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the PES demux when video attributes are found.
+//----------------------------------------------------------------------------
+
+void ts::TSTDAnalyzer::handleNewVideoAttributes(PESDemux& demux, const PESPacket& packet, const VideoAttributes& attr)
+{
+    Stream* const st = _pid_stream[packet.getSourcePID()];
+    if (st == nullptr || !attr.isValid() || attr.maximumBitRate() == 0 || attr.vbvSize() == 0 ||
+        (st->stream_type != ST_MPEG1_VIDEO && st->stream_type != ST_MPEG2_VIDEO))
+    {
+        return;
+    }
+
+    // EB is the vbv_buffer_size from the sequence header.
+    const size_t eb_size = attr.vbvSize() / 8;
+
+    // MPEG-2 video: Rmax and VBV_max from the profile and level, ISO/IEC 13818-1, section 2.4.2.3.
+    for (size_t i = 0; i < sizeof(MPEG2Levels) / sizeof(MPEG2Levels[0]); ++i) {
+        const MPEG2Level& level(MPEG2Levels[i]);
+        if (level.pl_code == attr.profileAndLevel()) {
+            const double rmax = double(level.rmax);
+            const size_t bs = size_t((0.004 * rmax + rmax / 750.0) / 8.0);  // BSmux + BSoh
+            if (level.high) {
+                // Rbx is min(1.05 * Res, Rmax), MB is BSmux + BSoh.
+                setVideoModel(*st, level.rmax, std::min(BitRate(1.05 * double(attr.maximumBitRate())), BitRate(level.rmax)), bs, eb_size);
+            }
+            else {
+                // Rbx is Rmax, MB also contains the unused part of the VBV.
+                const size_t vbv_max = level.vbv_max / 8;
+                setVideoModel(*st, level.rmax, level.rmax, bs + (vbv_max > eb_size ? vbv_max - eb_size : 0), eb_size);
+            }
+            return;
+        }
+    }
+
+    // MPEG-1 video or unknown profile and level: Rmax is the bit_rate from the sequence header.
+    const BitRate rmax = attr.maximumBitRate();
+    setVideoModel(*st, rmax, rmax, size_t((0.004 * double(rmax) + double(rmax) / 750.0) / 8.0), eb_size);
+}
+
+void ts::TSTDAnalyzer::handleNewAVCAttributes(PESDemux& demux, const PESPacket& packet, const AVCAttributes& attr)
+{
+    Stream* const st = _pid_stream[packet.getSourcePID()];
+    if (st != nullptr && attr.isValid() && st->stream_type == ST_AVC_VIDEO) {
+        for (size_t i = 0; i < sizeof(AVCLevels) / sizeof(AVCLevels[0]); ++i) {
+            if (AVCLevels[i].level == attr.level()) {
+                // Rmax and EB from MaxBR and MaxCPB of the level, at NAL level. Rbx is 1.2 * Rmax.
+                // MB is BSmux + BSoh, with a minimum rate of 2 Mb/s.
+                const uint32_t factor = AVCNalFactor(attr.profile());
+                const BitRate rmax = BitRate(AVCLevels[i].max_br * factor);
+                const double rate = std::max(double(rmax), 2000000.0);
+                setVideoModel(*st, rmax, BitRate(1.2 * double(rmax)), size_t((0.004 * rate + rate / 750.0) / 8.0), size_t(AVCLevels[i].max_cpb) * factor / 8);
+                break;
+            }
+        }
+    }
+}
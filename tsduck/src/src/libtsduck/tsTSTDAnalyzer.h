@@ -0,0 +1,343 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream system target decoder (T-STD) buffer simulation.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsSectionDemux.h"
+#include "tsPESDemux.h"
+#include "tsEnumeration.h"
+#include "tsTSPacket.h"
+
+namespace ts {
+
+    class TSTDHandlerInterface;
+    class PMT;
+
+    //!
+    //! Transport stream system target decoder (T-STD) buffer simulation.
+    //! @ingroup mpeg
+    //!
+    //! This class simulates the buffers of the T-STD model of ISO/IEC 13818-1,
+    //! section 2.4.2, for each audio and video elementary stream of a transport
+    //! stream: the transport buffer TB, the multiplex buffer MB (video only) and
+    //! the elementary stream buffer EB (B for audio).
+    //!
+    //! The time line of each program is extrapolated from its PCR's. TS packets
+    //! enter TB at their arrival time. TB is emptied at rate Rx into MB, MB is
+    //! emptied at rate Rbx into EB (leak method) and each access unit is removed
+    //! from EB at its decoding time (DTS, or PTS when there is no DTS). All
+    //! computations are done incrementally, with a constant amount of work per
+    //! packet.
+    //!
+    //! The buffer sizes and leak rates are computed from the stream type and
+    //! from the video attributes (MPEG-1 sequence header, MPEG-2 and AVC profile and
+    //! level), as found in the stream. They can be overridden by a smoothing_buffer_descriptor
+    //! in the PMT. When an STD_descriptor indicates that the vbv_delay method is
+    //! used (leak_valid_flag = 0), MB is considered as transparent and only TB and EB
+    //! are checked. The multiplex_buffer_utilization_descriptor is collected and
+    //! reported but is not checked.
+    //!
+    //! Simplifications: each PES packet is considered as one access unit, which
+    //! is exact for most video streams but is pessimistic for audio PES packets
+    //! containing several frames. HEVC and other elementary streams are not simulated.
+    //!
+    //! Violations are reported as events to an application-defined handler. A
+    //! violation is raised when a buffer overflows or underflows and is cleared
+    //! when the buffer is back to normal.
+    //!
+    class TSDUCKDLL TSTDAnalyzer: private TableHandlerInterface, private PESHandlerInterface
+    {
+    public:
+        //!
+        //! T-STD buffer violations.
+        //!
+        enum Violation {
+            TB_OVERFLOW,      //!< Transport buffer overflow.
+            MB_OVERFLOW,      //!< Multiplex buffer overflow.
+            EB_OVERFLOW,      //!< Elementary stream buffer overflow.
+            EB_UNDERFLOW,     //!< Elementary stream buffer underflow, access unit not completely received at decoding time.
+            VIOLATION_COUNT   //!< Number of violations, not a valid violation.
+        };
+
+        //!
+        //! Names of violations.
+        //!
+        static const Enumeration ViolationNames;
+
+        //!
+        //! Description of a violation event.
+        //!
+        struct TSDUCKDLL Event
+        {
+            Violation  violation;  //!< Type of violation.
+            bool       raised;     //!< True when the violation is raised, false when it is cleared.
+            NanoSecond timestamp;  //!< Time of the event on the time line of the program, since its first PCR.
+            PID        pid;        //!< PID of the elementary stream.
+            uint16_t   service_id; //!< Service id of the elementary stream.
+            UString    details;    //!< Human-readable details on a raised violation.
+
+            //!
+            //! Default constructor.
+            //!
+            Event();
+        };
+
+        //!
+        //! Simulation status of one elementary stream.
+        //! Buffer sizes and levels are in bytes, rates in bits/second.
+        //!
+        struct TSDUCKDLL StreamStatus
+        {
+            PID           pid;          //!< PID of the elementary stream.
+            uint16_t      service_id;   //!< Service id.
+            uint8_t       stream_type;  //!< Stream type from the PMT.
+            bool          simulated;    //!< The buffer model of the stream is known and the stream is simulated.
+            bool          has_mb;       //!< The stream has a multiplex buffer (leak method).
+            BitRate       rx;           //!< Leak rate from TB.
+            BitRate       rbx;          //!< Leak rate from MB to EB.
+            size_t        tb_size;      //!< Size of TB.
+            size_t        mb_size;      //!< Size of MB.
+            size_t        eb_size;      //!< Size of EB.
+            size_t        tb_level;     //!< Current level of TB.
+            size_t        mb_level;     //!< Current level of MB.
+            size_t        eb_level;     //!< Current level of EB.
+            size_t        tb_max;       //!< Maximum level of TB.
+            size_t        mb_max;       //!< Maximum level of MB.
+            size_t        eb_max;       //!< Maximum level of EB.
+            PacketCounter access_units; //!< Number of access units which were removed from EB.
+            uint64_t      violations[VIOLATION_COUNT]; //!< Number of violations, per type.
+            bool          has_ltw;      //!< A multiplex_buffer_utilization_descriptor is present.
+            uint16_t      ltw_lower;    //!< LTW offset lower bound, in units of 27 MHz/300 clock periods.
+            uint16_t      ltw_upper;    //!< LTW offset upper bound, in units of 27 MHz/300 clock periods.
+
+            //!
+            //! Default constructor.
+            //!
+            StreamStatus();
+        };
+
+        //!
+        //! A list of stream status.
+        //!
+        typedef std::vector<StreamStatus> StreamStatusVector;
+
+        //!
+        //! Size of the transport buffer TB in bytes, for all elementary streams.
+        //!
+        static const size_t TB_SIZE = 512;
+
+        //!
+        //! Constructor.
+        //! @param [in] handler The object to notify of violation events.
+        //!
+        explicit TSTDAnalyzer(TSTDHandlerInterface* handler = nullptr);
+
+        //!
+        //! Destructor.
+        //!
+        virtual ~TSTDAnalyzer() override;
+
+        //!
+        //! Replace the event handler.
+        //! @param [in] handler The new handler.
+        //!
+        void setHandler(TSTDHandlerInterface* handler) { _handler = handler; }
+
+        //!
+        //! Set the list of elementary stream PID's to simulate.
+        //! By default, all audio and video PID's are simulated.
+        //! @param [in] pids The set of PID's to simulate.
+        //!
+        void setPIDFilter(const PIDSet& pids) { _pid_filter = pids; }
+
+        //!
+        //! Reset the analysis context. The configuration is preserved.
+        //!
+        void reset();
+
+        //!
+        //! Analyze a TS packet.
+        //! @param [in] pkt The TS packet.
+        //!
+        void feedPacket(const TSPacket& pkt);
+
+        //!
+        //! Get the number of analyzed packets.
+        //! @return The number of analyzed packets.
+        //!
+        PacketCounter packetCount() const { return _packet_count; }
+
+        //!
+        //! Get the total number of violations of a given type, on all streams.
+        //! @param [in] violation The violation type.
+        //! @return The number of violations.
+        //!
+        uint64_t violationCount(Violation violation) const { return _violation_count[violation]; }
+
+        //!
+        //! Get the simulation status of all elementary streams, in increasing order of PID.
+        //! @param [out] status Returned status of all elementary streams.
+        //!
+        void getStatus(StreamStatusVector& status) const;
+
+    private:
+        // Time line of a program, extrapolated from its PCR's, in PCR units.
+        struct Clock
+        {
+            bool          has_pcr;    // At least one PCR was received.
+            bool          valid;      // The time line is valid (two PCR's).
+            uint64_t      last_raw;   // Last PCR value, as found in the packet.
+            uint64_t      offset;     // Offset to add to raw PCR's after wrap-around.
+            uint64_t      origin;     // First unwrapped PCR value, origin of event timestamps.
+            uint64_t      pcr;        // Last unwrapped PCR value.
+            PacketCounter index;      // Packet index of last PCR.
+            double        pkt_ticks;  // Duration of a packet, in PCR units.
+            std::vector<PID> pids;    // Elementary streams on this time line.
+
+            Clock();
+        };
+
+        // An access unit in EB, waiting for its decoding time.
+        struct AccessUnit
+        {
+            double dts;       // Decoding time, in PCR units on the time line of the program.
+            double size;      // Size in bytes, growing while the PES packet is received.
+            double expected;  // Expected size from PES_packet_length, zero if unbounded.
+            bool   complete;  // The complete PES packet was received.
+            bool   late;      // The decoding time was missed (EB underflow).
+        };
+
+        // Simulation state of one elementary stream.
+        struct Stream
+        {
+            PID        pid;
+            uint16_t   service_id;
+            uint8_t    stream_type;
+            PID        pcr_pid;      // PCR PID of the program.
+            bool       configured;   // Buffer sizes and leak rates are known.
+            bool       leak_method;  // STD_descriptor leak_valid_flag, MB leaks into EB at rate Rbx.
+            bool       has_mb;       // There is a multiplex buffer (leak method video).
+            bool       has_sb;       // A smoothing_buffer_descriptor is present.
+            size_t     sb_size;      // Smoothing buffer size in bytes.
+            BitRate    sb_rate;      // Smoothing buffer leak rate in b/s.
+            bool       has_ltw;      // A multiplex_buffer_utilization_descriptor is present.
+            uint16_t   ltw_lower;
+            uint16_t   ltw_upper;
+            bool       has_video;    // The default video model is known, from the video attributes.
+            BitRate    video_rmax;   // Default video model: Rmax, Rbx and MB, EB sizes in bytes.
+            BitRate    video_rbx;
+            size_t     video_mb;
+            size_t     video_eb;
+            BitRate    rx;           // Leak rates in b/s.
+            BitRate    rbx;
+            double     rx_ticks;     // Leak rates in bytes per PCR unit.
+            double     rbx_ticks;
+            double     tb_size;      // Buffer sizes in bytes.
+            double     mb_size;
+            double     eb_size;
+            double     tb;           // Buffer levels in bytes.
+            double     tb_payload;   // Part of TB which is PES data, the rest is TS headers.
+            double     mb;
+            double     eb;
+            double     tb_max;       // Maximum levels.
+            double     mb_max;
+            double     eb_max;
+            bool       sync;         // Synchronized on a PES packet start.
+            bool       started;      // The simulation time is valid.
+            double     time;         // Current simulation time, in PCR units.
+            uint8_t    cc;           // Last continuity counter, to discard duplicate packets.
+            PacketCounter access_units;
+            std::deque<AccessUnit> aus; // Access units in the buffers, not yet decoded.
+            bool       active[VIOLATION_COUNT];
+            uint64_t   count[VIOLATION_COUNT];
+
+            Stream();
+        };
+
+        typedef std::map<PID, Stream> StreamMap;
+        typedef std::map<PID, Clock> ClockMap;
+
+        // Private members:
+        TSTDHandlerInterface* _handler;
+        PIDSet                _pid_filter;
+        PacketCounter         _packet_count;
+        uint64_t              _violation_count[VIOLATION_COUNT];
+        SectionDemux          _demux;
+        PESDemux              _pes_demux;    // Used to collect video attributes only.
+        StreamMap             _streams;
+        ClockMap              _clocks;
+        Stream*               _pid_stream[PID_MAX];  // Direct access to streams by PID, null if none.
+        Clock*                _pid_clock[PID_MAX];   // Direct access to clocks by PCR PID, null if none.
+
+        // Process a PMT.
+        void processPMT(const PMT& pmt);
+
+        // Set the buffer model of a stream. The video model is adjusted by the PMT descriptors.
+        void configure(Stream& st, BitRate rx, BitRate rbx, size_t mb_size, size_t eb_size);
+        void setVideoModel(Stream& st, BitRate rmax, BitRate rbx, size_t mb_size, size_t eb_size);
+        void configureVideo(Stream& st);
+
+        // Process a PCR, return false on time line discontinuity.
+        bool processPCR(Clock& clock, const TSPacket& pkt, PacketCounter index);
+
+        // Attach a stream to the time line of a PCR PID.
+        void attach(Stream& st, PID pcr_pid);
+
+        // Process a TS packet of an elementary stream.
+        void processPacket(Stream& st, const Clock& clock, const TSPacket& pkt, PacketCounter index);
+
+        // Move the simulation of a stream up to a given time, decode all access units up to that time.
+        void advance(Stream& st, const Clock& clock, double time);
+
+        // Leak the buffers of a stream during a given duration.
+        void leak(Stream& st, double duration);
+
+        // Check the levels of the buffers of a stream.
+        void checkLevels(Stream& st, const Clock& clock);
+
+        // Restart the simulation of a stream with empty buffers.
+        void restart(Stream& st);
+
+        // Raise or clear a violation, notify the handler on state change.
+        void setViolation(Stream& st, const Clock& clock, Violation violation, bool active, const UString& details = UString());
+
+        // Implementation of TableHandlerInterface and PESHandlerInterface.
+        virtual void handleTable(SectionDemux& demux, const BinaryTable& table) override;
+        virtual void handleNewVideoAttributes(PESDemux& demux, const PESPacket& packet, const VideoAttributes& attr) override;
+        virtual void handleNewAVCAttributes(PESDemux& demux, const PESPacket& packet, const AVCAttributes& attr) override;
+
+        // Inaccessible operations.
+        TSTDAnalyzer(const TSTDAnalyzer&) = delete;
+        TSTDAnalyzer& operator=(const TSTDAnalyzer&) = delete;
+    };
+}
@@ -93,6 +93,11 @@ namespace ts {
                              SocketAddress& destination,
                              const AbortInterface* abort = nullptr,
                              Report& report = CERR) override;
+        virtual bool receive(ReceivedMessage* messages,
+                             size_t max_count,
+                             size_t& ret_count,
+                             const AbortInterface* abort = nullptr,
+                             Report& report = CERR) override;
 
     private:
         bool                    _with_short_options;
@@ -110,6 +115,9 @@ namespace ts {
         SocketAddress           _first_source;       // Socket address of first received packet.
         std::set<SocketAddress> _sources;            // Set of all detected packet sources.
 
+        // Check if a received message matches the filtering criteria.
+        bool checkMessage(const SocketAddress& sender, const SocketAddress& destination, Report& report);
+
         // Unreachable operations
         UDPReceiver(const UDPReceiver&) = delete;
         UDPReceiver& operator=(const UDPReceiver&) = delete;
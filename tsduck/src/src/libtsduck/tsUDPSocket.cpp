@@ -33,8 +33,16 @@
 
 #include "tsUDPSocket.h"
 #include "tsNullReport.h"
+#if defined(TS_LINUX)
+#include <linux/net_tstamp.h>
+#endif
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::UDPSocket::MAX_SEND_COUNT;
+const size_t ts::UDPSocket::MAX_RECEIVE_COUNT;
+#endif
+
 // Furiously idiotic Windows feature, see comment in receiveOne()
 #if defined(TS_WINDOWS)
 volatile ::LPFN_WSARECVMSG ts::UDPSocket::_wsaRevcMsg = 0;
@@ -50,7 +58,17 @@ ts::UDPSocket::UDPSocket(bool auto_open, Report& report) :
     _local_address(),
     _default_destination(),
     _mcast(),
-    _ssmcast()
+    _ssmcast(),
+    _dropped_datagrams(0),
+    _dropped_last(0),
+    _txtime(false)
+#if defined(TS_LINUX)
+    ,
+    _mmsg_headers(),
+    _mmsg_vectors(),
+    _mmsg_senders(),
+    _mmsg_control()
+#endif
 {
     if (auto_open) {
         // Returned value ignored on purpose, the socket is marked as closed in the object on error.
@@ -81,6 +99,9 @@ bool ts::UDPSocket::open(Report& report)
     if (!createSocket(PF_INET, SOCK_DGRAM, IPPROTO_UDP, report)) {
         return false;
     }
+    _dropped_datagrams = 0;
+    _dropped_last = 0;
+    _txtime = false;
 
     // Set the IP_PKTINFO option. This option is used to get the destination address of all
     // UDP packets arriving on this socket. Actual socket option is an int.
@@ -223,6 +244,67 @@ bool ts::UDPSocket::setTOS(int tos, Report& report)
 }
 
 
+//----------------------------------------------------------------------------
+// Enable or disable kernel timestamps on incoming messages.
+//----------------------------------------------------------------------------
+
+bool ts::UDPSocket::setReceiveTimestamps(bool on, Report& report)
+{
+#if defined(TS_LINUX)
+    int enable = int(on);
+    if (::setsockopt(getSocket(), SOL_SOCKET, SO_TIMESTAMPNS, TS_SOCKOPT_T(&enable), sizeof(enable)) != 0) {
+        report.error(u"socket option SO_TIMESTAMPNS: " + SocketErrorCodeMessage());
+        return false;
+    }
+#endif
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Enable or disable the transmission time of outgoing messages.
+//----------------------------------------------------------------------------
+
+bool ts::UDPSocket::setTransmitTime(bool on, Report& report)
+{
+#if defined(TS_LINUX) && defined(SO_TXTIME)
+    ::sock_txtime param;
+    TS_ZERO(param);
+    param.clockid = CLOCK_MONOTONIC;
+    if (on && ::setsockopt(getSocket(), SOL_SOCKET, SO_TXTIME, TS_SOCKOPT_T(&param), sizeof(param)) != 0) {
+        // Not an error, typically an older kernel, the application falls back to another method.
+        report.debug(u"socket option SO_TXTIME: " + SocketErrorCodeMessage());
+        return false;
+    }
+    _txtime = on;
+    return true;
+#else
+    if (on) {
+        report.debug(u"transmission time of UDP messages is not supported on this system");
+        return false;
+    }
+    return true;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+// Enable or disable the count of dropped incoming datagrams.
+//----------------------------------------------------------------------------
+
+bool ts::UDPSocket::setReceiveDropCounter(bool on, Report& report)
+{
+#if defined(TS_LINUX)
+    int enable = int(on);
+    if (::setsockopt(getSocket(), SOL_SOCKET, SO_RXQ_OVFL, TS_SOCKOPT_T(&enable), sizeof(enable)) != 0) {
+        report.error(u"socket option SO_RXQ_OVFL: " + SocketErrorCodeMessage());
+        return false;
+    }
+#endif
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Enable or disable the broadcast option.
 //----------------------------------------------------------------------------
@@ -398,13 +480,105 @@ bool ts::UDPSocket::send(const void* data, size_t size, const SocketAddress& des
 }
 
 
+//----------------------------------------------------------------------------
+// Send several messages to a destination address and port.
+//----------------------------------------------------------------------------
+
+bool ts::UDPSocket::send(const SentMessage* messages, size_t count, const SocketAddress& dest, Report& report)
+{
+#if defined(TS_LINUX)
+
+    ::sockaddr addr;
+    dest.copy(addr);
+
+    // Work areas for sendmmsg(), on the stack.
+    ::mmsghdr headers[MAX_SEND_COUNT];
+    ::iovec vectors[MAX_SEND_COUNT];
+#if defined(SO_TXTIME)
+    uint8_t control[MAX_SEND_COUNT][CMSG_SPACE(sizeof(uint64_t))];
+    ::timespec now;
+    TS_ZERO(now);
+    if (_txtime && ::clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+        report.error(u"clock_gettime error: %s", {SocketErrorCodeMessage()});
+        return false;
+    }
+    const NanoSecond base = NanoSecond(now.tv_sec) * NanoSecPerSec + NanoSecond(now.tv_nsec);
+#endif
+
+    while (count > 0) {
+
+        // Build the message headers for one system call.
+        const size_t max_count = std::min(count, MAX_SEND_COUNT);
+        for (size_t i = 0; i < max_count; ++i) {
+            ::msghdr& hdr(headers[i].msg_hdr);
+            TS_ZERO(hdr);
+            vectors[i].iov_base = const_cast<void*>(messages[i].data);
+            vectors[i].iov_len = messages[i].size;
+            hdr.msg_name = &addr;
+            hdr.msg_namelen = sizeof(addr);
+            hdr.msg_iov = &vectors[i];
+            hdr.msg_iovlen = 1;
+            headers[i].msg_len = 0;
+#if defined(SO_TXTIME)
+            if (_txtime) {
+                hdr.msg_control = control[i];
+                hdr.msg_controllen = sizeof(control[i]);
+                ::cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_TXTIME;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+                const uint64_t txtime = uint64_t(base + std::max<NanoSecond>(0, messages[i].delay));
+                ::memcpy(CMSG_DATA(cmsg), &txtime, sizeof(txtime));
+            }
+#endif
+        }
+
+        // Send the messages. The system may send less messages than requested.
+        const int sent = ::sendmmsg(getSocket(), headers, ::uint32_t(max_count), 0);
+        if (sent < 0) {
+            const SocketErrorCode err = LastSocketErrorCode();
+            if (err != EINTR) {
+                report.error(u"error sending UDP message: %s", {SocketErrorCodeMessage(err)});
+                return false;
+            }
+        }
+        else {
+            messages += sent;
+            count -= sent;
+        }
+    }
+    return true;
+
+#else
+
+    // Other systems, send messages one by one.
+    for (size_t i = 0; i < count; ++i) {
+        if (!send(messages[i].data, messages[i].size, dest, report)) {
+            return false;
+        }
+    }
+    return true;
+
+#endif
+}
+
+
 //----------------------------------------------------------------------------
 // Receive a message.
-// If abort interface is non-zero, invoke it when I/O is interrupted
-// (in case of user-interrupt, return, otherwise retry).
 // Return true on success, false on error.
 //----------------------------------------------------------------------------
 
+ts::UDPSocket::ReceivedMessage::ReceivedMessage(void* data_, size_t max_size_) :
+    data(data_),
+    max_size(max_size_),
+    size(0),
+    truncated(false),
+    sender(),
+    destination(),
+    timestamp(-1)
+{
+}
+
 bool ts::UDPSocket::receive(void* data,
                             size_t max_size,
                             size_t& ret_size,
@@ -413,19 +587,57 @@ bool ts::UDPSocket::receive(void* data,
                             const AbortInterface* abort,
                             Report& report)
 {
+    ReceivedMessage msg(data, max_size);
+    size_t count = 0;
+    const bool ok = UDPSocket::receive(&msg, 1, count, abort, report);
+    ret_size = msg.size;
+    sender = msg.sender;
+    destination = msg.destination;
+    return ok;
+}
+
+bool ts::UDPSocket::receive(ReceivedMessage* messages, size_t max_count, size_t& ret_count, const AbortInterface* abort, Report& report)
+{
+    ret_count = 0;
+    max_count = std::min(max_count, MAX_RECEIVE_COUNT);
+    if (messages == nullptr || max_count == 0) {
+        return true;
+    }
+
     // Loop on unsollicited interrupts
     for (;;) {
 
-        // Wait for a message.
-        const SocketErrorCode err = receiveOne(data, max_size, ret_size, sender, destination, report);
+        // Wait for at least one message.
+#if defined(TS_LINUX)
+        const SocketErrorCode err = max_count == 1 ? receiveOne(messages[0], report) : receiveMultiple(messages, max_count, ret_count, report);
+        if (max_count == 1 && err == SYS_SUCCESS) {
+            ret_count = 1;
+        }
+#else
+        const SocketErrorCode err = receiveOne(messages[0], report);
+        if (err == SYS_SUCCESS) {
+            ret_count = 1;
+        }
+#endif
 
         if (abort != nullptr && abort->aborting()) {
             // Aborting, no error message.
+            ret_count = 0;
             return false;
         }
         else if (err == SYS_SUCCESS) {
             // Sometimes, we get "successful" empty message coming from nowhere. Ignore them.
-            if (ret_size > 0 || sender.hasAddress()) {
+            size_t count = 0;
+            for (size_t i = 0; i < ret_count; ++i) {
+                if (messages[i].size > 0 || messages[i].sender.hasAddress()) {
+                    if (count < i) {
+                        std::swap(messages[count], messages[i]);
+                    }
+                    count++;
+                }
+            }
+            ret_count = count;
+            if (ret_count > 0) {
                 return true;
             }
         }
@@ -452,12 +664,14 @@ bool ts::UDPSocket::receive(void* data,
 // Perform one receive operation. Hide the system mud.
 //----------------------------------------------------------------------------
 
-ts::SocketErrorCode ts::UDPSocket::receiveOne(void* data, size_t max_size, size_t& ret_size, SocketAddress& sender, SocketAddress& destination, Report& report)
+ts::SocketErrorCode ts::UDPSocket::receiveOne(ReceivedMessage& msg, Report& report)
 {
     // Clear returned values
-    ret_size = 0;
-    sender.clear();
-    destination.clear();
+    msg.size = 0;
+    msg.truncated = false;
+    msg.sender.clear();
+    msg.destination.clear();
+    msg.timestamp = -1;
 
     // Reserve a socket address to receive the sender address.
     ::sockaddr sender_sock;
@@ -496,34 +710,35 @@ ts::SocketErrorCode ts::UDPSocket::receiveOne(void* data, size_t max_size, size_
     // Build an WSABUF pointing to the message.
     ::WSABUF vec;
     TS_ZERO(vec);
-    vec.buf = reinterpret_cast<CHAR*>(data);
-    vec.len = ::ULONG(max_size);
+    vec.buf = reinterpret_cast<CHAR*>(msg.data);
+    vec.len = ::ULONG(msg.max_size);
 
     // Reserve a buffer to receive packet ancillary data.
     ::CHAR ancil_data[1024];
     TS_ZERO(ancil_data);
 
     // Build a WSAMSG for WSARecvMsg.
-    ::WSAMSG msg;
-    TS_ZERO(msg);
-    msg.name = &sender_sock;
-    msg.namelen = sizeof(sender_sock);
-    msg.lpBuffers = &vec;
-    msg.dwBufferCount = 1; // number of WSAMSG
-    msg.Control.buf = ancil_data;
-    msg.Control.len = ::ULONG(sizeof(ancil_data));
+    ::WSAMSG wmsg;
+    TS_ZERO(wmsg);
+    wmsg.name = &sender_sock;
+    wmsg.namelen = sizeof(sender_sock);
+    wmsg.lpBuffers = &vec;
+    wmsg.dwBufferCount = 1; // number of WSAMSG
+    wmsg.Control.buf = ancil_data;
+    wmsg.Control.len = ::ULONG(sizeof(ancil_data));
 
     // Wait for a message.
     ::DWORD insize = 0;
-    if (_wsaRevcMsg(getSocket(), &msg, &insize, 0, 0)  != 0) {
+    if (_wsaRevcMsg(getSocket(), &wmsg, &insize, 0, 0)  != 0) {
         return LastSocketErrorCode();
     }
+    msg.truncated = (wmsg.dwFlags & MSG_PARTIAL) != 0;
 
     // Browse returned ancillary data.
-    for (::WSACMSGHDR* cmsg = WSA_CMSG_FIRSTHDR(&msg); cmsg != 0; cmsg = WSA_CMSG_NXTHDR(&msg, cmsg)) {
+    for (::WSACMSGHDR* cmsg = WSA_CMSG_FIRSTHDR(&wmsg); cmsg != 0; cmsg = WSA_CMSG_NXTHDR(&wmsg, cmsg)) {
         if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
             const ::IN_PKTINFO* info = reinterpret_cast<const ::IN_PKTINFO*>(WSA_CMSG_DATA(cmsg));
-            destination = SocketAddress(info->ipi_addr, _local_address.port());
+            msg.destination = SocketAddress(info->ipi_addr, _local_address.port());
         }
     }
 
@@ -533,8 +748,8 @@ ts::SocketErrorCode ts::UDPSocket::receiveOne(void* data, size_t max_size, size_
     // Build an iovec pointing to the message.
     ::iovec vec;
     TS_ZERO(vec);
-    vec.iov_base = data;
-    vec.iov_len = max_size;
+    vec.iov_base = msg.data;
+    vec.iov_len = msg.max_size;
 
     // Reserve a buffer to receive packet ancillary data.
     uint8_t ancil_data[1024];
@@ -558,18 +773,105 @@ ts::SocketErrorCode ts::UDPSocket::receiveOne(void* data, size_t max_size, size_
     }
 
     // Browse returned ancillary data.
-    for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
-        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO && cmsg->cmsg_len >= sizeof(::in_pktinfo)) {
-            const ::in_pktinfo* info = reinterpret_cast<const ::in_pktinfo*>(CMSG_DATA(cmsg));
-            destination = SocketAddress(info->ipi_addr, _local_address.port());
-        }
-    }
+    msg.truncated = (hdr.msg_flags & MSG_TRUNC) != 0;
+    getAncillaryData(hdr, msg);
 
 #endif // Windows vs. UNIX
 
     // Successfully received a message
-    ret_size = size_t(insize);
-    sender = SocketAddress(sender_sock);
+    msg.size = size_t(insize);
+    msg.sender = SocketAddress(sender_sock);
+
+    return SYS_SUCCESS;
+}
+
+
+#if defined(TS_LINUX)
+
+//----------------------------------------------------------------------------
+// Perform one recvmmsg() system call (Linux only).
+//----------------------------------------------------------------------------
+
+ts::SocketErrorCode ts::UDPSocket::receiveMultiple(ReceivedMessage* messages, size_t max_count, size_t& ret_count, Report& report)
+{
+    // Size of ancillary data area per message.
+    const size_t ancil_size = 256;
+
+    // Allocate the work areas the first time, for the maximum number of messages.
+    if (_mmsg_headers.empty()) {
+        _mmsg_headers.resize(MAX_RECEIVE_COUNT);
+        _mmsg_vectors.resize(MAX_RECEIVE_COUNT);
+        _mmsg_senders.resize(MAX_RECEIVE_COUNT);
+        _mmsg_control.resize(MAX_RECEIVE_COUNT * ancil_size);
+    }
 
+    // Build the message headers.
+    for (size_t i = 0; i < max_count; ++i) {
+        ::msghdr& hdr(_mmsg_headers[i].msg_hdr);
+        TS_ZERO(_mmsg_senders[i]);
+        _mmsg_vectors[i].iov_base = messages[i].data;
+        _mmsg_vectors[i].iov_len = messages[i].max_size;
+        TS_ZERO(hdr);
+        hdr.msg_name = &_mmsg_senders[i];
+        hdr.msg_namelen = sizeof(::sockaddr);
+        hdr.msg_iov = &_mmsg_vectors[i];
+        hdr.msg_iovlen = 1;
+        hdr.msg_control = &_mmsg_control[i * ancil_size];
+        hdr.msg_controllen = ancil_size;
+        _mmsg_headers[i].msg_len = 0;
+    }
+
+    // Wait for the first message, then get all immediately available messages.
+    const int count = ::recvmmsg(getSocket(), &_mmsg_headers[0], ::uint32_t(max_count), MSG_WAITFORONE, nullptr);
+    if (count < 0) {
+        return LastSocketErrorCode();
+    }
+
+    // Analyze all received messages.
+    ret_count = size_t(count);
+    for (size_t i = 0; i < ret_count; ++i) {
+        ReceivedMessage& msg(messages[i]);
+        ::msghdr& hdr(_mmsg_headers[i].msg_hdr);
+        msg.size = _mmsg_headers[i].msg_len;
+        msg.truncated = (hdr.msg_flags & MSG_TRUNC) != 0;
+        msg.sender = SocketAddress(_mmsg_senders[i]);
+        msg.destination.clear();
+        msg.timestamp = -1;
+        getAncillaryData(hdr, msg);
+    }
     return SYS_SUCCESS;
 }
+
+#endif // TS_LINUX
+
+#if !defined(TS_WINDOWS)
+
+//----------------------------------------------------------------------------
+// Analyze the ancillary data of a received message (UNIX systems).
+//----------------------------------------------------------------------------
+
+void ts::UDPSocket::getAncillaryData(::msghdr& hdr, ReceivedMessage& msg)
+{
+    for (::cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO && cmsg->cmsg_len >= sizeof(::in_pktinfo)) {
+            const ::in_pktinfo* info = reinterpret_cast<const ::in_pktinfo*>(CMSG_DATA(cmsg));
+            msg.destination = SocketAddress(info->ipi_addr, _local_address.port());
+        }
+#if defined(TS_LINUX)
+        else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS && cmsg->cmsg_len >= CMSG_LEN(sizeof(::timespec))) {
+            const ::timespec* tspec = reinterpret_cast<const ::timespec*>(CMSG_DATA(cmsg));
+            msg.timestamp = NanoSecond(tspec->tv_sec) * NanoSecPerSec + NanoSecond(tspec->tv_nsec);
+        }
+        else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL && cmsg->cmsg_len >= CMSG_LEN(sizeof(::uint32_t))) {
+            // The system counter is the total number of dropped datagrams since the socket was created.
+            // The counter is in native byte order.
+            ::uint32_t drops = 0;
+            ::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            _dropped_datagrams += ::uint32_t(drops - _dropped_last);
+            _dropped_last = drops;
+        }
+#endif
+    }
+}
+
+#endif // !TS_WINDOWS
@@ -39,6 +39,7 @@
 #include "tsAbortInterface.h"
 #include "tsReport.h"
 #include "tsMemoryUtils.h"
+#include "tsByteBlock.h"
 
 namespace ts {
     //!
@@ -207,6 +208,55 @@ namespace ts {
         //!
         bool setBroadcastIfRequired(const IPAddress destination, Report& report = CERR);
 
+        //!
+        //! Enable or disable the reception of kernel timestamps for incoming messages.
+        //! When enabled, the system records the arrival time of each datagram and the
+        //! multiple-message version of receive() returns it. This is currently
+        //! implemented on Linux only (socket option SO_TIMESTAMPNS). On other systems,
+        //! this method does nothing and no timestamp is returned.
+        //! @param [in] on If true, kernel timestamps are enabled. Otherwise, they are disabled.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //!
+        bool setReceiveTimestamps(bool on, Report& report = CERR);
+
+        //!
+        //! Enable or disable the count of incoming datagrams which are dropped by the system.
+        //! Datagrams are dropped when the socket receive buffer is full. When enabled, the
+        //! drop count is updated by each receive operation, see droppedDatagrams().
+        //! This is currently implemented on Linux only (socket option SO_RXQ_OVFL).
+        //! On other systems, this method does nothing and the drop count remains zero.
+        //! @param [in] on If true, the drop count is enabled. Otherwise, it is disabled.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //!
+        bool setReceiveDropCounter(bool on, Report& report = CERR);
+
+        //!
+        //! Get the number of incoming datagrams which were dropped by the system.
+        //! @return The number of incoming datagrams which were dropped by the system
+        //! because of a socket receive buffer overflow, as known by the last receive
+        //! operation. Always zero when the drop count is not enabled.
+        //! @see setReceiveDropCounter()
+        //!
+        uint64_t droppedDatagrams() const {return _dropped_datagrams;}
+
+        //!
+        //! Enable or disable the transmission time of outgoing messages.
+        //! When enabled, the multiple-message version of send() can specify a transmission
+        //! time for each message and the system delays the messages until that time.
+        //! This is currently implemented on Linux only (socket option SO_TXTIME, using the
+        //! monotonic clock). The transmission time is honored only when the network interface
+        //! uses a compatible queuing discipline such as "fq". Otherwise, messages are sent
+        //! immediately. When the transmission time is not supported, this is not considered
+        //! as an error: the reason is reported at debug level and the application is expected
+        //! to fall back to another pacing method.
+        //! @param [in] on If true, the transmission time is enabled. Otherwise, it is disabled.
+        //! @param [in,out] report Where to report the reason of a failure (debug level).
+        //! @return True on success, false when not supported by the system.
+        //!
+        bool setTransmitTime(bool on, Report& report = CERR);
+
         //!
         //! Join a multicast group.
         //!
@@ -291,6 +341,61 @@ namespace ts {
             return send(data, size, _default_destination, report);
         }
 
+        //!
+        //! Description of one message in a multiple-message send operation.
+        //!
+        struct TSDUCKDLL SentMessage
+        {
+            const void* data;   //!< Address of the message to send.
+            size_t      size;   //!< Size in bytes of the message to send.
+            NanoSecond  delay;  //!< Transmission time, relative to the send() call. Ignored when the transmission time is not enabled.
+
+            //!
+            //! Constructor.
+            //! @param [in] data_ Address of the message to send.
+            //! @param [in] size_ Size in bytes of the message to send.
+            //! @param [in] delay_ Transmission time, relative to the send() call.
+            //!
+            SentMessage(const void* data_ = nullptr, size_t size_ = 0, NanoSecond delay_ = 0) :
+                data(data_),
+                size(size_),
+                delay(delay_)
+            {
+            }
+        };
+
+        //!
+        //! Maximum number of messages in one system call of a multiple-message send operation.
+        //!
+        static const size_t MAX_SEND_COUNT = 64;
+
+        //!
+        //! Send several messages to a destination address and port.
+        //! On Linux, the messages are sent using one system call (sendmmsg) per group
+        //! of MAX_SEND_COUNT messages. On other systems, they are sent one by one.
+        //! @param [in] messages Array of messages to send.
+        //! @param [in] count Number of messages to send.
+        //! @param [in] destination Socket address of the destination.
+        //! Both address and port are mandatory in the socket address.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //! @see setTransmitTime()
+        //!
+        bool send(const SentMessage* messages, size_t count, const SocketAddress& destination, Report& report = CERR);
+
+        //!
+        //! Send several messages to the default destination address and port.
+        //! @param [in] messages Array of messages to send.
+        //! @param [in] count Number of messages to send.
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //! @see setTransmitTime()
+        //!
+        bool send(const SentMessage* messages, size_t count, Report& report = CERR)
+        {
+            return send(messages, count, _default_destination, report);
+        }
+
         //!
         //! Receive a message.
         //!
@@ -314,6 +419,56 @@ namespace ts {
                              const AbortInterface* abort = nullptr,
                              Report& report = CERR);
 
+        //!
+        //! Description of one message in a multiple-message receive operation.
+        //!
+        struct TSDUCKDLL ReceivedMessage
+        {
+            void*         data;         //!< [in] Address of the buffer for the received message.
+            size_t        max_size;     //!< [in] Size in bytes of the reception buffer.
+            size_t        size;         //!< [out] Size in bytes of the received message.
+            bool          truncated;    //!< [out] The message was larger than @a max_size and was truncated.
+            SocketAddress sender;       //!< [out] Socket address of the sender.
+            SocketAddress destination;  //!< [out] Socket address of the packet destination.
+            NanoSecond    timestamp;    //!< [out] Kernel arrival time in nanoseconds since the UNIX epoch, -1 if unknown.
+
+            //!
+            //! Constructor.
+            //! @param [in] data_ Address of the buffer for the received message.
+            //! @param [in] max_size_ Size in bytes of the reception buffer.
+            //!
+            ReceivedMessage(void* data_ = nullptr, size_t max_size_ = 0);
+        };
+
+        //!
+        //! Maximum number of messages in one multiple-message receive operation.
+        //!
+        static const size_t MAX_RECEIVE_COUNT = 64;
+
+        //!
+        //! Receive several messages in one operation.
+        //! The method waits for at least one message and then returns all messages which
+        //! are immediately available, up to @a max_count messages. On Linux, this is done
+        //! using one single system call (recvmmsg). On other systems, only one message is
+        //! returned at a time.
+        //! @param [in,out] messages Array of message descriptions. The input fields of the
+        //! first @a max_count elements must be set by the caller. The output fields of the
+        //! first @a ret_count elements are set on return. Since spurious empty messages are
+        //! ignored, the elements may be reordered: always use the returned @a data field.
+        //! @param [in] max_count Maximum number of messages to receive. Cannot be larger
+        //! than MAX_RECEIVE_COUNT, the excess is ignored.
+        //! @param [out] ret_count Number of received messages.
+        //! @param [in] abort If non-zero, invoked when I/O is interrupted
+        //! (in case of user-interrupt, return, otherwise retry).
+        //! @param [in,out] report Where to report error.
+        //! @return True on success, false on error.
+        //!
+        virtual bool receive(ReceivedMessage* messages,
+                             size_t max_count,
+                             size_t& ret_count,
+                             const AbortInterface* abort = nullptr,
+                             Report& report = CERR);
+
         // Implementation of Socket interface.
         virtual bool open(Report& report = CERR) override;
         virtual bool close(Report& report = CERR) override;
@@ -373,9 +528,28 @@ namespace ts {
         SocketAddress _default_destination;
         MReqSet       _mcast;    // Current set of multicast memberships
         SSMReqSet     _ssmcast;  // Current set of source-specific multicast memberships
+        uint64_t      _dropped_datagrams;  // Number of datagrams dropped by the system
+        uint32_t      _dropped_last;       // Last value of the system drop counter (can wrap up)
+        bool          _txtime;             // Transmission time is enabled on outgoing messages
 
         // Perform one receive operation. Hide the system mud.
-        SocketErrorCode receiveOne(void* data, size_t max_size, size_t& ret_size, SocketAddress& sender, SocketAddress& destination, Report& report);
+        SocketErrorCode receiveOne(ReceivedMessage& msg, Report& report);
+
+#if defined(TS_LINUX)
+        // Perform one recvmmsg() system call.
+        SocketErrorCode receiveMultiple(ReceivedMessage* messages, size_t max_count, size_t& ret_count, Report& report);
+
+        // Work areas for recvmmsg(), allocated on first use.
+        std::vector<::mmsghdr>  _mmsg_headers;
+        std::vector<::iovec>    _mmsg_vectors;
+        std::vector<::sockaddr> _mmsg_senders;
+        ByteBlock               _mmsg_control;
+#endif
+
+#if !defined(TS_WINDOWS)
+        // Analyze the ancillary data of a received message.
+        void getAncillaryData(::msghdr& hdr, ReceivedMessage& msg);
+#endif
 
         // Furiously idiotic Windows feature, see comment in receiveOne()
 #if defined(TS_WINDOWS)
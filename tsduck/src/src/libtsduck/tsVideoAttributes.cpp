@@ -51,6 +51,7 @@ ts::VideoAttributes::VideoAttributes() :
     _fr_div(0),
     _bitrate(0),
     _vbv_size(0),
+    _pl_code(0),
     _waiting(false),
     _sh_hsize(0),
     _sh_vsize(0),
@@ -202,6 +203,7 @@ bool ts::VideoAttributes::moreBinaryData (const void* udata, size_t size)
     else if (data[3] == PST_EXTENSION && size >= 10) {
         // Extension data for MPEG-2
         // Extract fields:
+        uint8_t pl_code = uint8_t((data[4] << 4) | (data[5] >> 4));
         bool progressive = (data[5] & 0x08) != 0;
         bool interlaced = !progressive;
         uint8_t cf_code = (data[5] >> 1) & 0x03;
@@ -230,7 +232,7 @@ bool ts::VideoAttributes::moreBinaryData (const void* udata, size_t size)
             _ar_code != _sh_ar_code || _progressive != progressive ||
             _interlaced != interlaced || _cf_code != cf_code ||
             _fr_num != fr_num || _fr_div != fr_div || _bitrate != bitrate ||
-            _vbv_size != vbv_size;
+            _vbv_size != vbv_size || _pl_code != pl_code;
 
         // Commit final values
         _hsize = hsize;
@@ -243,6 +245,7 @@ bool ts::VideoAttributes::moreBinaryData (const void* udata, size_t size)
         _fr_div = fr_div;
         _bitrate = bitrate;
         _vbv_size = vbv_size;
+        _pl_code = pl_code;
 
         _waiting = false;
         _is_valid = true;
@@ -255,7 +258,7 @@ bool ts::VideoAttributes::moreBinaryData (const void* udata, size_t size)
         bool changed = !_is_valid || _hsize != _sh_hsize || _vsize != _sh_vsize ||
             _ar_code != _sh_ar_code || _progressive || _interlaced || _cf_code != 0 ||
             _fr_num != fr_num || _fr_div != fr_div || _bitrate != _sh_bitrate ||
-            _vbv_size != _sh_vbv_size;
+            _vbv_size != _sh_vbv_size || _pl_code != 0;
 
         _hsize = _sh_hsize;
         _vsize = _sh_vsize;
@@ -266,7 +269,8 @@ bool ts::VideoAttributes::moreBinaryData (const void* udata, size_t size)
         _fr_num = fr_num;
         _fr_div = fr_div;
         _bitrate = _sh_bitrate;
-        _vbv_size = _sh_bitrate;
+        _vbv_size = _sh_vbv_size;
+        _pl_code = 0;
 
         _waiting = false;
         _is_valid = true;
@@ -164,6 +164,13 @@ namespace ts {
         //!
         size_t vbvSize() const {return _is_valid ? _vbv_size * 16 * 1024: 0;}
 
+        //!
+        //! Get the profile and level indication of MPEG-2 video.
+        //! @return The profile_and_level_indication from the sequence extension
+        //! (ISO/IEC 13818-2, section 8.2), zero for MPEG-1 video.
+        //!
+        uint8_t profileAndLevel() const {return _is_valid ? _pl_code : 0;}
+
     private:
         // Actual values, when _is_valid == true
         size_t  _hsize;       // Horizontal size in pixel
@@ -176,6 +183,7 @@ namespace ts {
         size_t  _fr_div;      // Frame rate divider
         BitRate _bitrate;     // Maximum bit rate
         size_t  _vbv_size;    // Video Buffering Verifier size in bits
+        uint8_t _pl_code;     // Profile and level indication, zero for MPEG-1
 
         // Temporary values from a "sequence header" unit
         bool    _waiting;     // Previous unit was a "sequence header"
@@ -82,6 +82,7 @@
 #include "tsBetterSystemRandomGenerator.h"
 #include "tsBinaryTable.h"
 #include "tsBitRateRegulator.h"
+#include "tsBitrateTimeSeries.h"
 #include "tsBitStream.h"
 #include "tsBlockCipher.h"
 #include "tsBouquetNameDescriptor.h"
@@ -190,6 +191,7 @@
 #include "tsINT.h"
 #include "tsIntegerUtils.h"
 #include "tsInterruptHandler.h"
+#include "tsIOUring.h"
 #include "tsIPAddress.h"
 #include "tsIPAddressMask.h"
 #include "tsIPMACGenericStreamLocationDescriptor.h"
@@ -205,6 +207,7 @@
 #include "tsLinkageDescriptor.h"
 #include "tsLNB.h"
 #include "tsLocalTimeOffsetDescriptor.h"
+#include "tsLogHistogram.h"
 #include "tsLogicalChannelNumberDescriptor.h"
 #include "tsMACAddress.h"
 #include "tsMain.h"
@@ -214,6 +217,9 @@
 #include "tsMessageDescriptor.h"
 #include "tsMessagePriorityQueue.h"
 #include "tsMessageQueue.h"
+#include "tsMetricsProviderInterface.h"
+#include "tsMetricsServer.h"
+#include "tsMetricsWriter.h"
 #include "tsMJD.h"
 #include "tsModulation.h"
 #include "tsMonotonic.h"
@@ -248,6 +254,7 @@
 #include "tsParentalRatingDescriptor.h"
 #include "tsPartialTransportStreamDescriptor.h"
 #include "tsPAT.h"
+#include "tsPcapFile.h"
 #include "tsPCR.h"
 #include "tsPCRAnalyzer.h"
 #include "tsPCRRegulator.h"
@@ -284,6 +291,7 @@
 #include "tsResidentBuffer.h"
 #include "tsRingNode.h"
 #include "tsRST.h"
+#include "tsRTPReorderBuffer.h"
 #include "tsS2SatelliteDeliverySystemDescriptor.h"
 #include "tsSafePtr.h"
 #include "tsSatelliteDeliverySystemDescriptor.h"
@@ -309,6 +317,7 @@
 #include "tsSHA256.h"
 #include "tsSHA512.h"
 #include "tsSharedLibrary.h"
+#include "tsSharedMemoryRing.h"
 #include "tsShortEventDescriptor.h"
 #include "tsSimpleApplicationBoundaryDescriptor.h"
 #include "tsSimpleApplicationLocationDescriptor.h"
@@ -399,6 +408,8 @@
 #include "tstlvStreamMessage.h"
 #include "tsTLVSyntax.h"
 #include "tsTOT.h"
+#include "tsTR101290Analyzer.h"
+#include "tsTR101290HandlerInterface.h"
 #include "tsTransportProtocolDescriptor.h"
 #include "tsTransportStreamDescriptor.h"
 #include "tsTransportStreamId.h"
@@ -410,11 +421,17 @@
 #include "tsTSFileInputBuffered.h"
 #include "tsTSFileOutput.h"
 #include "tsTSFileOutputResync.h"
+#include "tsTSFileRecorder.h"
 #include "tsTSPacket.h"
+#include "tsTSPacketIndex.h"
 #include "tsTSPacketQueue.h"
 #include "tsTSScanner.h"
 #include "tsTSScrambling.h"
+#include "tsTSSparseDecoder.h"
+#include "tsTSSparseEncoder.h"
 #include "tsTSSpeedMetrics.h"
+#include "tsTSTDAnalyzer.h"
+#include "tsTSTDHandlerInterface.h"
 #include "tsTuner.h"
 #include "tsTunerArgs.h"
 #include "tsTunerParameters.h"
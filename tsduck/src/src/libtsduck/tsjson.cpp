@@ -182,6 +182,14 @@ ts::UString ts::json::Value::printed(size_t indent, Report& report) const
     return str;
 }
 
+ts::UString ts::json::Value::oneLiner(Report& report) const
+{
+    // New lines in strings are escaped, the remaining ones are formatting only.
+    UString str(printed(0, report));
+    str.remove(u'\n');
+    return str;
+}
+
 
 //----------------------------------------------------------------------------
 // Format a JSON object.
@@ -144,6 +144,11 @@ namespace ts {
             //! @return The formatted JSON text.
             //!
             virtual UString printed(size_t indent = 2, Report& report = NULLREP) const;
+            //! Format the value as JSON text on one single line.
+            //! This is typically used for "JSON lines" streams, one value per line.
+            //! @param [in,out] report Where to report errors.
+            //! @return The formatted JSON text, without new line.
+            virtual UString oneLiner(Report& report = NULLREP) const;
             //!
             //! Check if this instance a is JSON null literal.
             //! @return True if this instance a is JSON null literal.
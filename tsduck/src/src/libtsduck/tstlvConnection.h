@@ -154,6 +154,8 @@ namespace ts {
             size_t          _invalid_msg_count;
             MUTEX           _send_mutex;
             MUTEX           _receive_mutex;
+            ByteBlock       _send_buffer;     // Reused for all sent messages, protected by _send_mutex
+            ByteBlock       _receive_buffer;  // Reused for all received messages, protected by _receive_mutex
 
             Connection(const Connection&) = delete;
             Connection& operator=(const Connection&) = delete;
@@ -46,7 +46,9 @@ ts::tlv::Connection<MUTEX>::Connection(const Protocol* protocol, bool auto_error
     _max_invalid_msg(max_invalid_msg),
     _invalid_msg_count(0),
     _send_mutex(),
-    _receive_mutex()
+    _receive_mutex(),
+    _send_buffer(),
+    _receive_buffer()
 {
 }
 
@@ -88,14 +90,18 @@ bool ts::tlv::Connection<MUTEX>::send(const Message& msg, Report& report)
 template <class MUTEX>
 bool ts::tlv::Connection<MUTEX>::send(const Message& msg, Logger& logger)
 {
-    logger.log(msg, u"sending message to " + peerName());
-
-    ByteBlockPtr bbp(new ByteBlock);
-    Serializer serial(bbp);
-    msg.serialize(serial);
+    // Build the log comment only when the message is actually logged.
+    if (logger.report().maxSeverity() >= logger.severity(msg.tag())) {
+        logger.log(msg, u"sending message to " + peerName());
+    }
 
+    // Serialize the message in the reusable send buffer. After the first
+    // messages, the buffer has reached its maximum size and is no longer reallocated.
     Guard lock(_send_mutex);
-    return SuperClass::send(bbp->data(), bbp->size(), logger.report());
+    _send_buffer.clear();
+    Serializer serial(_send_buffer);
+    msg.serialize(serial);
+    return SuperClass::send(_send_buffer.data(), _send_buffer.size(), logger.report());
 }
 
 
@@ -119,11 +125,16 @@ bool ts::tlv::Connection<MUTEX>::receive(MessagePtr& msg, const AbortInterface*
 
     // Loop until a valid message is received
     for (;;) {
-        ByteBlock bb(header_size);
+        MessagePtr resp;
+        bool valid = false;
 
-        // Receive complete message
+        // Receive and analyze a complete message. The message is received in a reusable
+        // buffer and the message factory directly works on this buffer. The message object
+        // is built before releasing the buffer.
         {
             Guard lock(_receive_mutex);
+            ByteBlock& bb(_receive_buffer);
+            bb.resize(header_size);
 
             // Read message header
             if (!SuperClass::receive(bb.data(), header_size, abort, logger.report())) {
@@ -136,29 +147,35 @@ bool ts::tlv::Connection<MUTEX>::receive(MessagePtr& msg, const AbortInterface*
             if (!SuperClass::receive(bb.data() + header_size, length, abort, logger.report())) {
                 return false;
             }
+
+            // Analyze the message
+            MessageFactory mf(bb.data(), bb.size(), _protocol);
+            valid = mf.errorStatus() == tlv::OK;
+            if (valid) {
+                _invalid_msg_count = 0;
+                mf.factory(msg);
+            }
+            else {
+                // Received an invalid message
+                _invalid_msg_count++;
+                msg.clear();
+                if (_auto_error_response) {
+                    mf.buildErrorResponse(resp);
+                }
+            }
         }
 
-        // Analyze the message
-        MessageFactory mf(bb.data(), bb.size(), _protocol);
-        if (mf.errorStatus() == tlv::OK) {
-            _invalid_msg_count = 0;
-            mf.factory(msg);
-            if (!msg.isNull()) {
+        // Process a valid message.
+        if (valid) {
+            if (!msg.isNull() && logger.report().maxSeverity() >= logger.severity(msg->tag())) {
                 logger.log(*msg, u"received message from " + peerName());
             }
             return true;
         }
 
-        // Received an invalid message
-        _invalid_msg_count++;
-
         // Send back an error message if necessary
-        if (_auto_error_response) {
-            MessagePtr resp;
-            mf.buildErrorResponse(resp);
-            if (!send(*resp, logger.report())) {
-                return false;
-            }
+        if (!resp.isNull() && !send(*resp, logger.report())) {
+            return false;
         }
 
         // If invalid message max has been reached, break the connection
@@ -49,7 +49,8 @@ ts::tlv::MessageFactory::MessageFactory(const void* addr, size_t size, const Pro
     _error_info_is_offset(false),
     _protocol_version(0),
     _command_tag(0),
-    _params()
+    _params(),
+    _compounds()
 {
     analyzeMessage();
 }
@@ -63,7 +64,8 @@ ts::tlv::MessageFactory::MessageFactory(const ByteBlock &bb, const Protocol* pro
     _error_info_is_offset(false),
     _protocol_version(0),
     _command_tag(0),
-    _params()
+    _params(),
+    _compounds()
 {
     analyzeMessage();
 }
@@ -159,6 +161,10 @@ void ts::tlv::MessageFactory::analyzeMessage()
         return;
     }
 
+    // Each parameter uses at least a tag and a length field. Reserve the
+    // maximum number of parameters once to avoid reallocations.
+    _params.reserve(params_length / (sizeof(TAG) + sizeof(LENGTH)));
+
     // Analyze the parameters
     tlv::Analyzer parm_anl (params_list, params_length);
 
@@ -186,23 +192,21 @@ void ts::tlv::MessageFactory::analyzeMessage()
         if (parm_it->second.compound != nullptr) {
 
             // The parameter is a compound TLV, analyze it.
-            // Store the parameter value in the multimap for this command.
-            // Analyze the compound parameter.
-
-            ParameterMultimap::iterator it =
-                _params.insert (ParameterMultimap::value_type (parm_tag,
-                    ExtParameter (tlv_addr, tlv_size, value_addr, value_length,
-                                  new MessageFactory (tlv_addr, tlv_size, parm_it->second.compound))));
+            MessageFactory* compound = new MessageFactory(tlv_addr, tlv_size, parm_it->second.compound);
+            _compounds.push_back(MessageFactoryPtr(compound));
 
             // Check if the analysis is successful
-            if ((_error_status = it->second.compound->_error_status) != OK) {
-                _error_info = it->second.compound->_error_info;
-                _error_info_is_offset = it->second.compound->_error_info_is_offset;
+            if ((_error_status = compound->_error_status) != OK) {
+                _error_info = compound->_error_info;
+                _error_info_is_offset = compound->_error_info_is_offset;
                 if (_error_info_is_offset) {
                     _error_info += uint16_t ((uint8_t*)(tlv_addr) - _msg_base); // offset
                 }
                 return;
             }
+
+            // Store the parameter value for this command.
+            addParameter(ExtParameter(parm_tag, tlv_addr, tlv_size, value_addr, value_length, compound));
         }
         else if (value_length < parm_it->second.min_size || value_length > parm_it->second.max_size) {
 
@@ -216,10 +220,8 @@ void ts::tlv::MessageFactory::analyzeMessage()
         else {
 
             // The parameter is not a compound TLV and its length is fine.
-            // Store the parameter value in the multimap for this command
-
-            _params.insert (ParameterMultimap::value_type (parm_tag,
-                ExtParameter (tlv_addr, tlv_size, value_addr, value_length)));
+            // Store the parameter value for this command.
+            addParameter(ExtParameter(parm_tag, tlv_addr, tlv_size, value_addr, value_length));
         }
 
         // Advance to next parameter
@@ -248,7 +250,7 @@ void ts::tlv::MessageFactory::analyzeMessage()
         // Protocol-defined parameter properties:
         const Protocol::Parameter& desc = parm_it->second;
         // Number of actual occurences in current command:
-        size_t count = _params.count (tag);
+        size_t count = this->count(tag);
 
         if (count < desc.min_count || count > desc.max_count) {
             if (count == 0 && desc.min_count > 0) {
@@ -265,18 +267,53 @@ void ts::tlv::MessageFactory::analyzeMessage()
 }
 
 
+//----------------------------------------------------------------------------
+// Store a parameter, keeping the parameters sorted by tag and, for one tag,
+// in order of occurence. Parameters are usually grouped by tag in messages,
+// so the insertion point is generally the end of the vector.
+//----------------------------------------------------------------------------
+
+namespace {
+    template <class PARAM>
+    bool LessTag(const PARAM& p1, const PARAM& p2)
+    {
+        return p1.tag < p2.tag;
+    }
+}
+
+void ts::tlv::MessageFactory::addParameter(const ExtParameter& param)
+{
+    if (_params.empty() || _params.back().tag <= param.tag) {
+        _params.push_back(param);
+    }
+    else {
+        _params.insert(std::upper_bound(_params.begin(), _params.end(), param, LessTag<ExtParameter>), param);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the range of all occurences of a parameter.
+//----------------------------------------------------------------------------
+
+ts::tlv::MessageFactory::ParameterRange ts::tlv::MessageFactory::range(TAG tag) const
+{
+    return std::equal_range(_params.begin(), _params.end(), ExtParameter(tag), LessTag<ExtParameter>);
+}
+
+
 //----------------------------------------------------------------------------
 // Get location of the first occurence of a parameter:
 //----------------------------------------------------------------------------
 
 void ts::tlv::MessageFactory::get(TAG tag, Parameter& param) const
 {
-    ParameterMultimap::const_iterator it = _params.find(tag);
-    if (it == _params.end()) {
+    const ParameterRange r(range(tag));
+    if (r.first == r.second) {
         throw DeserializationInternalError(UString::Format(u"No parameter 0x%X in message", {tag}));
     }
     else {
-        param = it->second;
+        param = *r.first;
     }
 }
 
@@ -288,13 +325,12 @@ void ts::tlv::MessageFactory::get(TAG tag, Parameter& param) const
 void ts::tlv::MessageFactory::get(TAG tag, std::vector<Parameter>& param) const
 {
     // Reinitialize result vector
+    const ParameterRange r(range(tag));
     param.clear();
-    param.reserve (_params.count (tag));
+    param.reserve(r.second - r.first);
     // Fill vector with parameter values
-    ParameterMultimap::const_iterator it = _params.lower_bound(tag);
-    ParameterMultimap::const_iterator last = _params.upper_bound (tag);
-    for (; it != last; ++it) {
-        param.push_back(it->second);
+    for (ParameterVector::const_iterator it = r.first; it != r.second; ++it) {
+        param.push_back(*it);
     }
 }
 
@@ -306,14 +342,13 @@ void ts::tlv::MessageFactory::get(TAG tag, std::vector<Parameter>& param) const
 void ts::tlv::MessageFactory::get(TAG tag, std::vector<bool>& param) const
 {
     // Reinitialize result vector
-    param.clear ();
-    param.reserve(_params.count(tag));
+    const ParameterRange r(range(tag));
+    param.clear();
+    param.reserve(r.second - r.first);
     // Fill vector with parameter values
-    ParameterMultimap::const_iterator it = _params.lower_bound(tag);
-    ParameterMultimap::const_iterator last = _params.upper_bound(tag);
-    for (; it != last; ++it) {
-        checkParamSize<uint8_t> (tag, it);
-        param.push_back(GetUInt8(it->second.addr) != 0);
+    for (ParameterVector::const_iterator it = r.first; it != r.second; ++it) {
+        checkParamSize<uint8_t>(tag, it);
+        param.push_back(GetUInt8(it->addr) != 0);
     }
 }
 
@@ -325,13 +360,13 @@ void ts::tlv::MessageFactory::get(TAG tag, std::vector<bool>& param) const
 void ts::tlv::MessageFactory::get(TAG tag, std::vector<std::string>& param) const
 {
     // Reinitialize result vector
-    param.clear ();
-    param.resize(_params.count(tag));
+    const ParameterRange r(range(tag));
+    param.clear();
+    param.resize(r.second - r.first);
     // Fill vector with parameter values
-    ParameterMultimap::const_iterator it = _params.lower_bound(tag);
-    ParameterMultimap::const_iterator last = _params.upper_bound(tag);
-    for (int i = 0; it != last; ++it, ++i) {
-        param[i].assign(static_cast<const char*> (it->second.addr), it->second.length);
+    ParameterVector::const_iterator it = r.first;
+    for (size_t i = 0; it != r.second; ++it, ++i) {
+        param[i].assign(static_cast<const char*>(it->addr), it->length);
     }
 }
 
@@ -342,15 +377,15 @@ void ts::tlv::MessageFactory::get(TAG tag, std::vector<std::string>& param) cons
 
 void ts::tlv::MessageFactory::getCompound(TAG tag, MessagePtr& param) const
 {
-    ParameterMultimap::const_iterator it = _params.find(tag);
-    if (it == _params.end()) {
+    const ParameterRange r(range(tag));
+    if (r.first == r.second) {
         throw DeserializationInternalError(UString::Format(u"No parameter 0x%X in message", {tag}));
     }
-    else if (it->second.compound.isNull()) {
+    else if (r.first->compound == nullptr) {
         throw DeserializationInternalError(UString::Format(u"Parameter 0x%X is not a compound TLV", {tag}));
     }
     else {
-        it->second.compound->factory(param);
+        r.first->compound->factory(param);
     }
 }
 
@@ -362,17 +397,17 @@ void ts::tlv::MessageFactory::getCompound(TAG tag, MessagePtr& param) const
 void ts::tlv::MessageFactory::getCompound(TAG tag, std::vector<MessagePtr>& param) const
 {
     // Reinitialize result vector
-    param.clear ();
-    param.resize(_params.count(tag));
+    const ParameterRange r(range(tag));
+    param.clear();
+    param.resize(r.second - r.first);
     // Fill vector with parameter values
-    ParameterMultimap::const_iterator it = _params.lower_bound(tag);
-    ParameterMultimap::const_iterator last = _params.upper_bound(tag);
-    for (int i = 0; it != last; ++it, ++i) {
-        if (it->second.compound.isNull()) {
+    ParameterVector::const_iterator it = r.first;
+    for (size_t i = 0; it != r.second; ++it, ++i) {
+        if (it->compound == nullptr) {
             throw DeserializationInternalError(UString::Format(u"Occurence %d of parameter 0x%X not a compound TLV", {i, tag}));
         }
         else {
-            it->second.compound->factory(param[i]);
+            it->compound->factory(param[i]);
         }
     }
 }
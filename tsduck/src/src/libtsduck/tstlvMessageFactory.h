@@ -49,6 +49,10 @@ namespace ts {
         //! Factory class for TLV messages
         //! @ingroup tlv
         //!
+        //! A message factory is a view over a binary message. The message is
+        //! never copied, all parameter locations point into the original buffer
+        //! which must remain valid and unmodified while the factory is used.
+        //!
         //! The following methods should be used by the application
         //! to deserialize messages:
         //! - Constructors
@@ -202,7 +206,8 @@ namespace ts {
             //!
             size_t count(TAG tag) const
             {
-                return _params.count(tag);
+                const ParameterRange r(range(tag));
+                return size_t(r.second - r.first);
             }
 
             //!
@@ -321,19 +326,22 @@ namespace ts {
 
             // Internal description of a parameter.
             // Include the description of compound TLV parameter.
-            // When compound.isNull(), this is not a compound TLV parameter.
+            // When compound is null, this is not a compound TLV parameter.
             struct ExtParameter : public Parameter
             {
                 // Public fields:
-                MessageFactoryPtr compound; // for compound TLV parameter
+                TAG                   tag;      // Parameter tag
+                const MessageFactory* compound; // For compound TLV parameter, owned by _compounds
 
                 // Constructor:
-                ExtParameter(const void*     tlv_addr_ = nullptr,
-                             size_t          tlv_size_ = 0,
-                             const void*     addr_ = nullptr,
-                             LENGTH          length_ = 0,
-                             MessageFactory* compound_ = nullptr) :
+                ExtParameter(TAG                   tag_ = 0,
+                             const void*           tlv_addr_ = nullptr,
+                             size_t                tlv_size_ = 0,
+                             const void*           addr_ = nullptr,
+                             LENGTH                length_ = 0,
+                             const MessageFactory* compound_ = nullptr) :
                     Parameter(tlv_addr_, tlv_size_, addr_, length_),
+                    tag(tag_),
                     compound(compound_)
                 {
                 }
@@ -349,9 +357,21 @@ namespace ts {
             VERSION         _protocol_version;
             TAG             _command_tag;
 
-            // Location of actual parameters. Point into the message block.
-            typedef std::multimap <TAG, ExtParameter> ParameterMultimap;
-            ParameterMultimap _params;
+            // Location of actual parameters. Point into the message block, nothing is copied.
+            // The vector is sorted by tag and, for one tag, keeps the order of occurence in
+            // the message. It is allocated once per message, instead of one node per parameter.
+            typedef std::vector<ExtParameter> ParameterVector;
+            typedef std::pair<ParameterVector::const_iterator, ParameterVector::const_iterator> ParameterRange;
+            ParameterVector _params;
+
+            // Analyzed compound TLV parameters (there is none in most protocols).
+            std::vector<MessageFactoryPtr> _compounds;
+
+            // Get the range of all occurences of a parameter in _params.
+            ParameterRange range(TAG tag) const;
+
+            // Store a parameter in _params.
+            void addParameter(const ExtParameter& param);
 
             // Analyze the TLV message, called by constructors.
             void analyzeMessage();
@@ -364,7 +384,7 @@ namespace ts {
             // Should never throw an exception, except bug in the
             // constructor of the Message subclasses.
             template <typename T>
-            void checkParamSize(TAG, const ParameterMultimap::const_iterator&) const;
+            void checkParamSize(TAG, const ParameterVector::const_iterator&) const;
         };
 
         // Template specializations for performance.
@@ -41,12 +41,12 @@
 //----------------------------------------------------------------------------
 
 template <typename T>
-void ts::tlv::MessageFactory::checkParamSize(TAG tag, const ParameterMultimap::const_iterator& it) const
+void ts::tlv::MessageFactory::checkParamSize(TAG tag, const ParameterVector::const_iterator& it) const
 {
     const size_t expected = dataSize<T>();
-    if (it->second.length != expected) {
+    if (it->length != expected) {
         throw DeserializationInternalError(
-            UString::Format(u"Bad size for parameter 0x%X in message, expected %d bytes, found %d", {tag, expected, it->second.length}));
+            UString::Format(u"Bad size for parameter 0x%X in message, expected %d bytes, found %d", {tag, expected, it->length}));
     }
 }
 
@@ -58,13 +58,13 @@ void ts::tlv::MessageFactory::checkParamSize(TAG tag, const ParameterMultimap::c
 template <typename INT, typename std::enable_if<std::is_integral<INT>::value>::type*>
 INT ts::tlv::MessageFactory::get(TAG tag) const
 {
-    ParameterMultimap::const_iterator it = _params.find(tag);
-    if (it == _params.end()) {
+    const ParameterRange r(range(tag));
+    if (r.first == r.second) {
         throw DeserializationInternalError(UString::Format(u"No parameter 0x%X in message", {tag}));
     }
     else {
-        checkParamSize<INT>(tag, it);
-        return GetInt<INT>(it->second.addr);
+        checkParamSize<INT>(tag, r.first);
+        return GetInt<INT>(r.first->addr);
     }
 }
 
@@ -77,14 +77,13 @@ template <typename INT, typename std::enable_if<std::is_integral<INT>::value>::t
 void ts::tlv::MessageFactory::get(TAG tag, std::vector<INT>& param) const
 {
     // Reinitialize result vector
+    const ParameterRange r(range(tag));
     param.clear();
-    param.reserve(_params.count(tag));
+    param.reserve(r.second - r.first);
     // Fill vector with parameter values
-    ParameterMultimap::const_iterator it = _params.lower_bound(tag);
-    ParameterMultimap::const_iterator last = _params.upper_bound (tag);
-    for (; it != last; ++it) {
+    for (ParameterVector::const_iterator it = r.first; it != r.second; ++it) {
         checkParamSize<INT>(tag, it);
-        param.push_back(GetInt<INT>(it->second.addr));
+        param.push_back(GetInt<INT>(it->addr));
     }
 }
 
@@ -117,17 +116,17 @@ template <class MSG>
 void ts::tlv::MessageFactory::getCompound(TAG tag, std::vector<MSG>& param) const
 {
     // Reinitialize result vector
+    const ParameterRange r(range(tag));
     param.clear();
     // Fill vector with parameter values
-    ParameterMultimap::const_iterator it = _params.lower_bound(tag);
-    ParameterMultimap::const_iterator last = _params.upper_bound(tag);
-    for (int i = 0; it != last; ++it, ++i) {
-        if (it->second.compound.isNull()) {
+    ParameterVector::const_iterator it = r.first;
+    for (int i = 0; it != r.second; ++it, ++i) {
+        if (it->compound == nullptr) {
             throw DeserializationInternalError(UString::Format(u"Occurence %d of parameter 0x%X not a compound TLV", {i, tag}));
         }
         else {
             MessagePtr gen;
-            it->second.compound->factory(gen);
+            it->compound->factory(gen);
             MSG* msg = dynamic_cast<MSG*> (gen.pointer());
             if (msg == 0) {
                 throw DeserializationInternalError(UString::Format(u"Wrong compound TLV type for occurence %d of parameter 0x%X", {i, tag}));
@@ -45,11 +45,17 @@ namespace ts {
         //! A DVB message is serialized in TLV into a ByteBlock.
         //! A Serializer is always associated to a ByteBlock.
         //!
+        //! The message is appended to the existing content of the ByteBlock.
+        //! To avoid a memory allocation for each message, an application may
+        //! reuse the same ByteBlock for all messages, clearing it before each
+        //! serialization. The capacity of the ByteBlock is preserved.
+        //!
         class TSDUCKDLL Serializer
         {
         private:
             // Private members:
-            ByteBlockPtr _bb;    // Associated binary block
+            ByteBlockPtr _bbp;   // Reference to the binary block, when constructed from a safe pointer
+            ByteBlock* _bb;      // Associated binary block, used for serialization
             int _length_offset;  // Location of TLV "length" field
 
         public:
@@ -57,10 +63,25 @@ namespace ts {
             //! Constructor.
             //! Associates an existing message block.
             //! @param [in] bb Safe pointer to an existing message block.
-            //! The messages will be serialized in this block.
+            //! The messages will be serialized in this block. The serializer
+            //! keeps a reference to the block.
             //!
             Serializer(const ByteBlockPtr& bb) :
-                _bb(bb),
+                _bbp(bb),
+                _bb(bb.pointer()),
+                _length_offset(-1)
+            {
+            }
+
+            //!
+            //! Constructor.
+            //! Associates an existing message block, owned by the caller.
+            //! @param [in,out] bb An existing message block. The messages will be serialized
+            //! in this block. The block must remain valid as long as the Serializer is used.
+            //!
+            Serializer(ByteBlock& bb) :
+                _bbp(),
+                _bb(&bb),
                 _length_offset(-1)
             {
             }
@@ -72,6 +93,7 @@ namespace ts {
             //! @param [in] s Another serializer, will use the same byte block for serialization.
             //!
             Serializer(const Serializer& s) :
+                _bbp(s._bbp),
                 _bb(s._bb),
                 _length_offset(-1)
             {
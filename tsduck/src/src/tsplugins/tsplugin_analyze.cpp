@@ -36,6 +36,8 @@
 #include "tsPluginRepository.h"
 #include "tsTSAnalyzerReport.h"
 #include "tsTSSpeedMetrics.h"
+#include "tsUDPSocket.h"
+#include "tsTCPConnection.h"
 #include "tsSysUtils.h"
 TSDUCK_SOURCE;
 
@@ -60,6 +62,11 @@ namespace ts {
         std::ostream*     _output;
         NanoSecond        _output_interval;
         bool              _multiple_output;
+        bool              _delta;            // Produce JSON lines with interval deltas.
+        SocketAddress     _udp_collector;    // Send the JSON lines to this UDP collector.
+        SocketAddress     _tcp_collector;    // Send the JSON lines to this TCP collector.
+        UDPSocket         _udp;
+        TCPConnection     _tcp;
         TSSpeedMetrics    _metrics;
         NanoSecond        _next_report;
         TSAnalyzerReport  _analyzer;
@@ -68,6 +75,8 @@ namespace ts {
         bool openOutput();
         void closeOutput();
         bool produceReport();
+        bool produceDelta();
+        bool sendLine(const UString& line);
 
         // Inaccessible operations
         AnalyzePlugin() = delete;
@@ -91,6 +100,11 @@ ts::AnalyzePlugin::AnalyzePlugin(TSP* tsp_) :
     _output(),
     _output_interval(0),
     _multiple_output(false),
+    _delta(false),
+    _udp_collector(),
+    _tcp_collector(),
+    _udp(false),
+    _tcp(),
     _metrics(),
     _next_report(0),
     _analyzer(),
@@ -99,6 +113,15 @@ ts::AnalyzePlugin::AnalyzePlugin(TSP* tsp_) :
     // Define all standard analysis options.
     _analyzer_options.defineOptions(*this);
 
+    option(u"delta", 'd');
+    help(u"delta",
+         u"With --interval, produce one line of JSON text at each interval, containing the "
+         u"changes since the previous interval: number of packets, bitrates and errors for "
+         u"each PID which received packets and new or modified services and tables. "
+         u"The analysis context is not reset between intervals. A last line is produced "
+         u"at the end of the stream. The lines are written into the --output-file (or "
+         u"the standard output) or sent to a collector (options --tcp or --udp).");
+
     option(u"interval", 'i', POSITIVE);
     help(u"interval",
          u"Produce a new output file at regular intervals. "
@@ -117,6 +140,15 @@ ts::AnalyzePlugin::AnalyzePlugin(TSP* tsp_) :
     help(u"output-file", u"filename",
          u"Specify the output text file for the analysis result. "
          u"By default, use the standard output.");
+
+    option(u"tcp", 0, STRING);
+    help(u"tcp", u"address:port",
+         u"With --delta, send the JSON lines to a TCP collector. "
+         u"If the connection is lost, a new connection is attempted at the next interval.");
+
+    option(u"udp", 0, STRING);
+    help(u"udp", u"address:port",
+         u"With --delta, send each JSON line in one UDP datagram to a collector.");
 }
 
 
@@ -129,9 +161,40 @@ bool ts::AnalyzePlugin::start()
     _output_name = value(u"output-file");
     _output_interval = NanoSecPerSec * intValue<Second>(u"interval", 0);
     _multiple_output = present(u"multiple-files");
+    _delta = present(u"delta");
     _output = _output_name.empty() ? &std::cout : &_output_stream;
     _analyzer_options.load(*this);
     _analyzer.setAnalysisOptions(_analyzer_options);
+    _analyzer.setDeltaTracking(_delta);
+    _udp_collector.clear();
+    _tcp_collector.clear();
+
+    const UString udp(value(u"udp"));
+    const UString tcp(value(u"tcp"));
+    if (!_delta && (!udp.empty() || !tcp.empty())) {
+        tsp->error(u"--tcp and --udp require --delta");
+        return false;
+    }
+    if (_delta && (_output_interval == 0 || _multiple_output)) {
+        tsp->error(u"--delta requires --interval and excludes --multiple-files");
+        return false;
+    }
+    if (!udp.empty() + !tcp.empty() + !_output_name.empty() > 1) {
+        tsp->error(u"--output-file, --tcp and --udp are mutually exclusive");
+        return false;
+    }
+    if (!udp.empty() && (!_udp_collector.resolve(udp, *tsp) || !_udp_collector.hasAddress() || !_udp_collector.hasPort())) {
+        tsp->error(u"invalid UDP collector address %s", {udp});
+        return false;
+    }
+    if (!tcp.empty() && (!_tcp_collector.resolve(tcp, *tsp) || !_tcp_collector.hasAddress() || !_tcp_collector.hasPort())) {
+        tsp->error(u"invalid TCP collector address %s", {tcp});
+        return false;
+    }
+    if (_udp_collector.hasAddress() && (!_udp.open(*tsp) || !_udp.setDefaultDestination(_udp_collector, *tsp))) {
+        _udp.close(NULLREP);
+        return false;
+    }
 
     // For production of multiple reports at regular intervals.
     _metrics.start();
@@ -140,7 +203,8 @@ bool ts::AnalyzePlugin::start()
     // Create the output file. Note that this file is used only in the stop
     // method and could be created there. However, if the file cannot be
     // created, we do not want to wait all along the analysis and finally fail.
-    if (_output_interval == 0 && !openOutput()) {
+    if ((_output_interval == 0 || _delta) && !openOutput()) {
+        _udp.close(NULLREP);
         return false;
     }
 
@@ -214,13 +278,70 @@ bool ts::AnalyzePlugin::produceReport()
 }
 
 
+//----------------------------------------------------------------------------
+// Produce one JSON line with the changes since previous interval.
+//----------------------------------------------------------------------------
+
+bool ts::AnalyzePlugin::produceDelta()
+{
+    // Set last known input bitrate as hint
+    _analyzer.setBitrateHint(tsp->bitrate());
+    return sendLine(_analyzer.jsonDelta(_analyzer_options.title)->oneLiner(*tsp));
+}
+
+
+//----------------------------------------------------------------------------
+// Send one line of text to the output file or collector.
+//----------------------------------------------------------------------------
+
+bool ts::AnalyzePlugin::sendLine(const UString& line)
+{
+    const std::string data(line.toUTF8() + "\n");
+
+    if (_udp_collector.hasAddress()) {
+        // A lost datagram is not an error, the next deltas will be sent anyway.
+        _udp.send(data.data(), data.size(), *tsp);
+    }
+    else if (_tcp_collector.hasAddress()) {
+        // Connect on first line or after a lost connection.
+        if (!_tcp.isConnected() && (!_tcp.open(*tsp) || !_tcp.connect(_tcp_collector, *tsp))) {
+            _tcp.close(NULLREP);
+            tsp->warning(u"cannot connect to collector %s, delta dropped", {_tcp_collector});
+        }
+        else if (!_tcp.send(data.data(), data.size(), *tsp)) {
+            _tcp.disconnect(NULLREP);
+            _tcp.close(NULLREP);
+        }
+    }
+    else {
+        *_output << data << std::flush;
+        if (!*_output) {
+            tsp->error(u"error writing analysis output");
+            return false;
+        }
+    }
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Stop method
 //----------------------------------------------------------------------------
 
 bool ts::AnalyzePlugin::stop()
 {
-    produceReport();
+    if (_delta) {
+        produceDelta();
+        closeOutput();
+        if (_tcp.isConnected()) {
+            _tcp.disconnect(NULLREP);
+        }
+        _tcp.close(NULLREP);
+        _udp.close(NULLREP);
+    }
+    else {
+        produceReport();
+    }
     return true;
 }
 
@@ -236,12 +357,19 @@ ts::ProcessorPlugin::Status ts::AnalyzePlugin::processPacket (TSPacket& pkt, boo
 
     // With --interval, check if it is time to produce a report
     if (_output_interval > 0 && _metrics.processedPacket() && _metrics.sessionNanoSeconds() >= _next_report) {
-        // Time to produce a report.
-        if (!produceReport()) {
+        // Time to produce a report or a delta.
+        if (_delta) {
+            if (!produceDelta()) {
+                return TSP_END;
+            }
+        }
+        else if (!produceReport()) {
             return TSP_END;
         }
-        // Reset analysis context.
-        _analyzer.reset();
+        else {
+            // Reset analysis context.
+            _analyzer.reset();
+        }
         // Compute next report time.
         _next_report += _output_interval;
     }
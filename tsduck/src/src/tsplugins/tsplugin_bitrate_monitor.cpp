@@ -34,6 +34,11 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsBitrateTimeSeries.h"
+#include "tsSectionDemux.h"
+#include "tsSafePtr.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
 #include "tsTime.h"
 TSDUCK_SOURCE;
 
@@ -43,12 +48,13 @@ TSDUCK_SOURCE;
 //----------------------------------------------------------------------------
 
 namespace ts {
-    class BitrateMonitorPlugin: public ProcessorPlugin
+    class BitrateMonitorPlugin: public ProcessorPlugin, private TableHandlerInterface
     {
     public:
         // Implementation of plugin API
         BitrateMonitorPlugin(TSP*);
         virtual bool start() override;
+        virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
 
     private:
@@ -61,25 +67,44 @@ namespace ts {
         // Type indicating status of current bitrate, regarding allowed range
         enum RangeStatus {LOWER, IN_RANGE, GREATER};
 
-        PID         _pid;                  // Monitored PID
+        // Monitoring state of one PID
+        struct PIDMonitor
+        {
+            PID         pid;     // Monitored PID
+            RangeStatus status;  // Status of the last bitrate, regarding allowed range
+        };
+
+        typedef SafePtr<BitrateTimeSeries> BitrateTimeSeriesPtr;
+
+        std::vector<PIDMonitor> _pids;     // Monitored PID's
         BitRate     _min_bitrate;          // Minimum allowed bitrate
         BitRate     _max_bitrate;          // Maximum allowed bitrate
         Second      _periodic_bitrate;     // Report bitrate at regular intervals, even if in range
         Second      _periodic_countdown;   // Countdown to report bitrate
-        RangeStatus _last_bitrate_status;  // Status of the last bitrate, regarding allowed range
         UString     _alarm_command;        // Alarm command name
-        time_t      _last_second;          // Last second number
         size_t      _window_size;          // Size (in seconds) of the time window, used to compute bitrate.
-        bool        _startup;              // Measurement in progress.
-        size_t      _pkt_count_index;      // Index for packet number array.
-        std::vector<PacketCounter> _pkt_count; // Array with the number of packets received during the last time window.
-                                               // Numbers are stored second per second.
+        bool        _all_pids;             // Record the bitrate of all PID's
+        bool        _services;             // Record the bitrate of all services
+        size_t      _max_series;           // Maximum number of recorded PID's and services
+        UString     _csv_file;             // Output CSV file for time series
+        UString     _json_file;            // Output JSON file for time series
+        Second      _dump_interval;        // Interval between dumps of time series
+        Second      _dump_countdown;       // Countdown to dump time series
+        Time        _start_time;           // Origin of time line
+        SectionDemux _demux;               // Demux for services
+        BitrateTimeSeriesPtr _series;      // Bitrate time series
 
         // Run the alarm command.
         void runAlarmCommand(const ts::UString& parameter);
 
-        // Compute bitrate. Report any alarm.
-        void computeBitrate();
+        // Compute bitrates. Report any alarm.
+        void computeBitrate(PIDMonitor& mon);
+
+        // Dump the time series in output files.
+        void dumpSeries();
+
+        // Invoked by the demux when a complete table is available.
+        virtual void handleTable(SectionDemux&, const BinaryTable&) override;
 
         // Inaccessible operations
         BitrateMonitorPlugin() = delete;
@@ -103,46 +128,86 @@ const size_t ts::BitrateMonitorPlugin::DEFAULT_TIME_WINDOW_SIZE;
 //----------------------------------------------------------------------------
 
 ts::BitrateMonitorPlugin::BitrateMonitorPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"Monitor bitrate for a given pid", u"[options] pid"),
-    _pid(PID_NULL),
+    ProcessorPlugin(tsp_, u"Monitor the bitrate of PID's and record bitrate time series of PID's and services", u"[options] [pid ...]"),
+    _pids(),
     _min_bitrate(0),
     _max_bitrate(0),
     _periodic_bitrate(0),
     _periodic_countdown(0),
-    _last_bitrate_status(LOWER),
     _alarm_command(),
-    _last_second(0),
     _window_size(0),
-    _startup(false),
-    _pkt_count_index(0),
-    _pkt_count()
+    _all_pids(false),
+    _services(false),
+    _max_series(0),
+    _csv_file(),
+    _json_file(),
+    _dump_interval(0),
+    _dump_countdown(0),
+    _start_time(),
+    _demux(this),
+    _series()
 {
-    option(u"", 0, PIDVAL, 1, 1);
-    help(u"", u"Specifies the PID to monitor.");
+    option(u"", 0, PIDVAL, 0, UNLIMITED_COUNT);
+    help(u"",
+         u"Specifies the PID's to monitor. The bitrate of each PID is checked against "
+         u"the allowed range (see --min and --max).");
 
     option(u"alarm-command", 'a', STRING);
     help(u"alarm-command", u"'command'",
          u"Command to be run when an alarm is detected (bitrate out of range).");
 
-    option(u"time-interval", 't', UINT16);
-    help(u"time-interval",
-         u"Time interval (in seconds) used to compute the bitrate. "
-         u"Default: " + UString::Decimal(DEFAULT_TIME_WINDOW_SIZE) + u" s.");
-
-    option(u"min", 0, UINT32);
-    help(u"min",
-         u"Set minimum allowed value for bitrate (bits/s). "
-         u"Default: " + UString::Decimal(DEFAULT_BITRATE_MIN) + u" b/s.");
+    option(u"all-pids");
+    help(u"all-pids",
+         u"Record the bitrate time series of all PID's, not only the monitored ones. "
+         u"See --csv-file and --json-file.");
+
+    option(u"csv-file", 0, STRING);
+    help(u"csv-file", u"filename",
+         u"Save the bitrate time series of the transport stream, the recorded PID's and "
+         u"services in the specified file in CSV format. The bitrates are recorded per "
+         u"second over the last hour, per minute over the last day and per hour over the "
+         u"last week. The file is written at the end of the processing and at regular "
+         u"intervals (see --dump-interval).");
+
+    option(u"dump-interval", 0, POSITIVE);
+    help(u"dump-interval", u"seconds",
+         u"With --csv-file or --json-file, rewrite the files at the specified interval. "
+         u"By default, the files are written at the end of the processing only.");
+
+    option(u"json-file", 0, STRING);
+    help(u"json-file", u"filename",
+         u"Save the bitrate time series in the specified file in JSON format. "
+         u"See --csv-file for the content.");
 
     option(u"max", 0, UINT32);
     help(u"max",
          u"Set maximum allowed value for bitrate (bits/s). "
          u"Default: " + UString::Decimal(DEFAULT_BITRATE_MAX) + u" b/s.");
 
+    option(u"max-series", 0, POSITIVE);
+    help(u"max-series",
+         u"Maximum number of recorded PID's and services. All memory is allocated at startup. "
+         u"Default: " + UString::Decimal(BitrateTimeSeries::DEFAULT_MAX_SERIES) + u".");
+
+    option(u"min", 0, UINT32);
+    help(u"min",
+         u"Set minimum allowed value for bitrate (bits/s). "
+         u"Default: " + UString::Decimal(DEFAULT_BITRATE_MIN) + u" b/s.");
+
     option(u"periodic-bitrate", 'p', POSITIVE);
     help(u"periodic-bitrate",
          u"Always report bitrate at the specific interval in seconds, even if the "
          u"bitrate is in range.");
+
+    option(u"services");
+    help(u"services",
+         u"Record the bitrate time series of all services. The bitrate of a service is "
+         u"the sum of the bitrates of its PMT, PCR and elementary stream PID's.");
+
+    option(u"time-interval", 't', UINT16);
+    help(u"time-interval",
+         u"Time interval (in seconds) used to compute the bitrate. "
+         u"Default: " + UString::Decimal(DEFAULT_TIME_WINDOW_SIZE) + u" s.");
 }
 
 
@@ -154,34 +219,135 @@ bool ts::BitrateMonitorPlugin::start()
 {
     // Get command line arguments
     _alarm_command = value(u"alarm-command");
-    _pid = intValue<PID>(u"", PID_NULL);
-    _window_size = intValue(u"time-interval", DEFAULT_TIME_WINDOW_SIZE);
+    _window_size = std::max<size_t>(1, intValue(u"time-interval", DEFAULT_TIME_WINDOW_SIZE));
     _min_bitrate = intValue(u"min", DEFAULT_BITRATE_MIN);
     _max_bitrate = intValue(u"max", DEFAULT_BITRATE_MAX);
     _periodic_bitrate = intValue(u"periodic-bitrate", 0);
+    _all_pids = present(u"all-pids");
+    _services = present(u"services");
+    _max_series = intValue<size_t>(u"max-series", BitrateTimeSeries::DEFAULT_MAX_SERIES);
+    _csv_file = value(u"csv-file");
+    _json_file = value(u"json-file");
+    _dump_interval = intValue(u"dump-interval", 0);
+
+    _pids.clear();
+    for (size_t i = 0; i < count(u""); ++i) {
+        const PIDMonitor mon = {intValue<PID>(u"", PID_NULL, i), IN_RANGE};
+        _pids.push_back(mon);
+    }
 
     if (_min_bitrate > _max_bitrate) {
         tsp->error(u"bad parameters, bitrate min (%'d) > max (%'d), exiting", {_min_bitrate, _max_bitrate});
         return false;
     }
+    if (_pids.empty() && _csv_file.empty() && _json_file.empty()) {
+        tsp->error(u"specify at least one PID to monitor, --csv-file or --json-file");
+        return false;
+    }
 
-    // Initialize array wick packets count.
-    _pkt_count.resize(_window_size);
-    _pkt_count_index = 0;
+    // Allocate the time series, the monitored time window must fit in the one-second buckets.
+    _series = new BitrateTimeSeries(_max_series, std::max(_window_size, BitrateTimeSeries::DEFAULT_SECONDS));
+    _start_time = Time::CurrentUTC();
+    _series->reset(_start_time);
+    _series->setAutoPIDs(_all_pids);
+    for (auto it = _pids.begin(); it != _pids.end(); ++it) {
+        if (!_series->addPID(it->pid)) {
+            tsp->error(u"too many PID's, increase --max-series");
+            return false;
+        }
+    }
 
-    for (uint16_t i = 0; i < _pkt_count.size(); i++) {
-        _pkt_count[i] = 0;
+    // Collect the PID's of all services.
+    _demux.reset();
+    if (_services) {
+        _demux.addPID(PID_PAT);
     }
 
     _periodic_countdown = _periodic_bitrate;
-    _last_bitrate_status = IN_RANGE;
-    _last_second = ::time(nullptr);
-    _startup = true;
+    _dump_countdown = _dump_interval;
 
     return true;
 }
 
 
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::BitrateMonitorPlugin::stop()
+{
+    dumpSeries();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Dump the time series in output files.
+//----------------------------------------------------------------------------
+
+void ts::BitrateMonitorPlugin::dumpSeries()
+{
+    if (!_series.isNull() && !_csv_file.empty()) {
+        std::ofstream file(_csv_file.toUTF8().c_str());
+        if (file) {
+            _series->reportCSV(file);
+        }
+        else {
+            tsp->error(u"cannot create file %s", {_csv_file});
+        }
+    }
+    if (!_series.isNull() && !_json_file.empty()) {
+        std::ofstream file(_json_file.toUTF8().c_str());
+        if (file) {
+            file << _series->toJSON()->printed() << std::endl;
+        }
+        else {
+            tsp->error(u"cannot create file %s", {_json_file});
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the demux when a complete table is available.
+//----------------------------------------------------------------------------
+
+void ts::BitrateMonitorPlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
+{
+    switch (table.tableId()) {
+        case TID_PAT: {
+            const PAT pat(table);
+            if (pat.isValid()) {
+                for (auto it = pat.pmts.begin(); it != pat.pmts.end(); ++it) {
+                    _demux.addPID(it->second);
+                }
+            }
+            break;
+        }
+        case TID_PMT: {
+            const PMT pmt(table);
+            if (pmt.isValid()) {
+                PIDSet pids;
+                pids.set(table.sourcePID());
+                if (pmt.pcr_pid != PID_NULL) {
+                    pids.set(pmt.pcr_pid);
+                }
+                for (auto it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
+                    pids.set(it->first);
+                }
+                if (!_series->setService(pmt.service_id, pids)) {
+                    tsp->warning(u"too many PID's and services, service 0x%X (%d) not recorded, increase --max-series", {pmt.service_id, pmt.service_id});
+                }
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Run the alarm command, if one was specified as the plugin option.
 // The given string parameter describes the alarm.
@@ -201,26 +367,18 @@ void ts::BitrateMonitorPlugin::runAlarmCommand(const ts::UString& parameter)
 
 
 //----------------------------------------------------------------------------
-// Compute bitrate for the monitored PID. Report an alarm if the bitrate
+// Compute bitrate for a monitored PID. Report an alarm if the bitrate
 // is out of allowed range, or back in it.
 //----------------------------------------------------------------------------
 
-void ts::BitrateMonitorPlugin::computeBitrate()
+void ts::BitrateMonitorPlugin::computeBitrate(PIDMonitor& mon)
 {
-    // Bitrate is computed with the following formula :
-    // (Sum of packets received during the last time window) * (packet size) / (time window)
-
-    PacketCounter total_pkt_count = 0;
-    for (uint16_t i = 0; i < _pkt_count.size(); i++) {
-        total_pkt_count  += _pkt_count[i];
-    }
-
-    const BitRate bitrate = BitRate(total_pkt_count * PKT_SIZE * 8 / _pkt_count.size());
+    // Bitrate is the average of the one-second bitrates during the last time window.
+    const BitRate bitrate = _series->pidBitrate(mon.pid, BitrateTimeSeries::SECONDS, _window_size);
 
     // Periodic bitrate display.
-    if (_periodic_bitrate > 0 && --_periodic_countdown <= 0) {
-        _periodic_countdown = _periodic_bitrate;
-        tsp->info(u"%s, pid %d (0x%X), bitrate: %'d bits/s", {Time::CurrentLocalTime().format(Time::DATE | Time::TIME), _pid, _pid, bitrate});
+    if (_periodic_bitrate > 0 && _periodic_countdown <= 0) {
+        tsp->info(u"%s, pid %d (0x%X), bitrate: %'d bits/s", {Time::CurrentLocalTime().format(Time::DATE | Time::TIME), mon.pid, mon.pid, bitrate});
     }
 
     // Check the bitrate value, regarding the allowed range.
@@ -236,8 +394,8 @@ void ts::BitrateMonitorPlugin::computeBitrate()
     }
 
     // Report an error, if the bitrate status has changed.
-    if (new_bitrate_status != _last_bitrate_status) {
-        ts::UString alarmMessage(UString::Format(u"pid %d (0x%X) - bitrate (%'d bits/s)", {_pid, _pid, bitrate}));
+    if (new_bitrate_status != mon.status) {
+        ts::UString alarmMessage(UString::Format(u"pid %d (0x%X) - bitrate (%'d bits/s)", {mon.pid, mon.pid, bitrate}));
         switch (new_bitrate_status) {
             case LOWER:
                 alarmMessage += UString::Format(u" is lower than allowed minimum (%'d bits/s)", {_min_bitrate});
@@ -258,7 +416,7 @@ void ts::BitrateMonitorPlugin::computeBitrate()
         runAlarmCommand(alarmMessage);
 
         // Update status
-        _last_bitrate_status = new_bitrate_status;
+        mon.status = new_bitrate_status;
     }
 }
 
@@ -269,35 +427,31 @@ void ts::BitrateMonitorPlugin::computeBitrate()
 
 ts::ProcessorPlugin::Status ts::BitrateMonitorPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
 {
-    time_t now = ::time(nullptr);
-
     // NOTE : the computation method used here is meaningful only if at least
     // one packet is received per second (whatever its PID).
 
-    // New second : compute the bitrate for the last time window
-    if (now > _last_second) {
-
-        // Bitrate computation is done only when the packet counter
-        // array if fully filled (to avoid bad values at startup).
-        if (!_startup) {
-            computeBitrate();
+    _demux.feedPacket(pkt);
+
+    // New second : compute the bitrate for the last time window.
+    if (_series->feedPacket(pkt, Time::CurrentUTC() - _start_time)) {
+
+        // Bitrate computation is done only when the time window
+        // is fully filled (to avoid bad values at startup).
+        if (_series->bucketCount(BitrateTimeSeries::SECONDS) >= _window_size) {
+            --_periodic_countdown;
+            for (auto it = _pids.begin(); it != _pids.end(); ++it) {
+                computeBitrate(*it);
+            }
+            if (_periodic_countdown <= 0) {
+                _periodic_countdown = _periodic_bitrate;
+            }
         }
 
-        // update index, and reset packet count.
-        _pkt_count_index = (_pkt_count_index + 1) % _pkt_count.size();
-        _pkt_count[_pkt_count_index] = 0;
-
-        // We are no more at startup if the index cycles.
-        if (_startup) {
-            _startup = !(_pkt_count_index == 0);
+        // Periodic dump of time series.
+        if (_dump_interval > 0 && --_dump_countdown <= 0) {
+            _dump_countdown = _dump_interval;
+            dumpSeries();
         }
-
-        _last_second = now;
-    }
-
-    // If packet's PID matches, increment the number of packets received during the current second.
-    if (pkt.getPID() == _pid) {
-        _pkt_count[_pkt_count_index]++;
     }
 
     // Pass all packets
@@ -34,6 +34,7 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include <atomic>
 TSDUCK_SOURCE;
 
 
@@ -49,6 +50,7 @@ namespace ts {
         ContinuityPlugin(TSP*);
         virtual bool start() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual void getMetrics(MetricsWriter&) override;
 
     private:
         UString       _tag;             // Message tag
@@ -56,6 +58,8 @@ namespace ts {
         int           _log_level;       // Log level for discontinuity messages
         PacketCounter _packet_count;    // TS packet count
         PIDSet        _pids;            // PID values to check or fix
+        std::atomic<PacketCounter> _errors;   // Number of discontinuities
+        std::atomic<PacketCounter> _missing;  // Number of missing packets
         uint8_t       _oldCC[PID_MAX];  // Continuity counter by PID (input)
         uint8_t       _newCC[PID_MAX];  // Continuity counter by PID (output)
 
@@ -80,7 +84,9 @@ ts::ContinuityPlugin::ContinuityPlugin(TSP* tsp_) :
     _fix(),
     _log_level(Severity::Info),
     _packet_count(0),
-    _pids()
+    _pids(),
+    _errors(0),
+    _missing(0)
 {
     option(u"fix", 'f');
     help(u"fix",
@@ -145,7 +151,10 @@ ts::ProcessorPlugin::Status ts::ContinuityPlugin::processPacket(TSPacket& pkt, b
 
         // Check if the CC is incorrect.
         if (_oldCC[pid] < 16 && !duplicated && ((_oldCC[pid] + 1) & 0x0F) != cc) {
-            tsp->log(_log_level, u"%sTS: %'d, PID: 0x%X, missing: %d", {_tag, _packet_count, pid, (cc < _oldCC[pid] ? 16 : 0) + cc - _oldCC[pid] - 1});
+            const int missing = (cc < _oldCC[pid] ? 16 : 0) + cc - _oldCC[pid] - 1;
+            tsp->log(_log_level, u"%sTS: %'d, PID: 0x%X, missing: %d", {_tag, _packet_count, pid, missing});
+            _errors.fetch_add(1, std::memory_order_relaxed);
+            _missing.fetch_add(missing, std::memory_order_relaxed);
         }
 
         // Fix CC if requested. Fixes are propagated all along the PID.
@@ -160,3 +169,14 @@ ts::ProcessorPlugin::Status ts::ContinuityPlugin::processPacket(TSPacket& pkt, b
     _packet_count++;
     return TSP_OK;
 }
+
+
+//----------------------------------------------------------------------------
+// Plugin-specific metrics, invoked from the metrics server thread.
+//----------------------------------------------------------------------------
+
+void ts::ContinuityPlugin::getMetrics(MetricsWriter& writer)
+{
+    writer.counter(u"cc_errors_total", u"Number of continuity counter errors.", _errors.load(std::memory_order_relaxed));
+    writer.counter(u"cc_missing_packets_total", u"Number of missing packets according to continuity counters.", _missing.load(std::memory_order_relaxed));
+}
@@ -36,8 +36,13 @@
 #include "tsPluginRepository.h"
 #include "tsTSFileOutput.h"
 #include "tsTSFileInput.h"
+#include "tsTSFileRecorder.h"
+#include "tsTSPacketIndex.h"
+#include "tsTSSparseDecoder.h"
 TSDUCK_SOURCE;
 
+#define DEF_IO_DEPTH 4  // Default number of asynchronous I/O in flight
+
 
 //----------------------------------------------------------------------------
 // Plugin definition
@@ -61,8 +66,25 @@ namespace ts {
         size_t        _current_file;
         size_t        _repeat_count;
         uint64_t      _start_offset;
+        MilliSecond   _seek_time;
+        size_t        _seek_psi;
         TSFileInput   _file;
         volatile bool _aborted;
+        bool          _first_read;   // Next read is the first one in the current file.
+        bool          _sparse;       // Current file is a sparse file.
+        TSSparseDecoder _decoder;    // Decoder of sparse files.
+        TSPacketVector _units;       // Units from a sparse file.
+        size_t        _units_next;   // Index of next unit to decode.
+        size_t        _units_count;  // Number of units to decode.
+
+        // Open an input file, seek according to its index if required.
+        bool openFile(const UString& name);
+
+        // Close the current input file.
+        bool closeFile();
+
+        // Read packets from the current file, detect and decode sparse files.
+        size_t readFile(TSPacket* buffer, size_t max_packets);
 
         // Inaccessible operations
         FileInput() = delete;
@@ -80,7 +102,7 @@ namespace ts {
         virtual bool stop() override;
         virtual bool send(const TSPacket*, size_t) override;
     private:
-        TSFileOutput _file;
+        TSFileRecorder _file;
 
         // Inaccessible operations
         FileOutput() = delete;
@@ -112,6 +134,12 @@ TSPLUGIN_DECLARE_INPUT(file, ts::FileInput)
 TSPLUGIN_DECLARE_OUTPUT(file, ts::FileOutput)
 TSPLUGIN_DECLARE_PROCESSOR(file, ts::FileProcessor)
 
+// Define and load the asynchronous I/O options, common to all file plugins.
+namespace {
+    void DefineAsyncOptions(ts::Args&);
+    void LoadAsyncOptions(ts::Args&, size_t& depth, size_t& block_size, bool& direct);
+}
+
 
 //----------------------------------------------------------------------------
 // Input constructor
@@ -123,15 +151,27 @@ ts::FileInput::FileInput(TSP* tsp_) :
     _current_file(0),
     _repeat_count(1),
     _start_offset(0),
+    _seek_time(-1),
+    _seek_psi(0),
     _file(),
-    _aborted(true)
+    _aborted(true),
+    _first_read(false),
+    _sparse(false),
+    _decoder(),
+    _units(),
+    _units_next(0),
+    _units_count(0)
 {
     option(u"", 0, STRING, 0, UNLIMITED_COUNT);
-    help(u"", u"Name of the input files. The files are read in sequence. Use standard input by default.");
+    help(u"",
+         u"Name of the input files. The files are read in sequence. Use standard input by default. "
+         u"Sparse files, as created by the option --sparse of the output plugin file, are "
+         u"automatically detected and the original stream is rebuilt, including null packets.");
 
     option(u"byte-offset", 'b', UNSIGNED);
     help(u"byte-offset",
          u"Start reading each file at the specified byte offset (default: 0). "
+         u"In a sparse file, the null packets are restored from the first map after this offset. "
          u"This option is allowed only if the input file is a regular file.");
 
     option(u"infinite", 'i');
@@ -139,6 +179,15 @@ ts::FileInput::FileInput(TSP* tsp_) :
          u"Repeat the playout of the file infinitely (default: only once). "
          u"This option is allowed only if the input file is a regular file.");
 
+    DefineAsyncOptions(*this);
+
+    option(u"memory-map", 'm');
+    help(u"memory-map",
+         u"Read the files through a memory mapping (UNIX only). The system cache is "
+         u"directly accessed and the next part of the file is prefetched while the current "
+         u"one is read. This applies to regular files only, other files are read as usual. "
+         u"Mutually exclusive with --io-uring.");
+
     option(u"packet-offset", 'p', UNSIGNED);
     help(u"packet-offset",
          u"Start reading each file at the specified TS packet (default: 0). "
@@ -149,6 +198,20 @@ ts::FileInput::FileInput(TSP* tsp_) :
          u"Repeat the playout of each file the specified number of times "
          u"(default: only once). This option is allowed only if the "
          u"input file is a regular file.");
+
+    option(u"seek-psi-change", 0, POSITIVE);
+    help(u"seek-psi-change",
+         u"Start reading each file at the specified change of PSI (new version of a PAT, CAT "
+         u"or PMT), starting at 1. The position of the PSI changes is read from the index "
+         u"file, named after the input file with an additional .tsidx suffix. See the command "
+         u"tsindex and the option --index of the output plugin file.");
+
+    option(u"seek-time", 0, UNSIGNED);
+    help(u"seek-time",
+         u"Start reading each file at the specified time in milliseconds, relative to the first PCR "
+         u"in the file. The reading starts at the last random access point before that time, "
+         u"as found in the index file, named after the input file with an additional .tsidx "
+         u"suffix. See the command tsindex and the option --index of the output plugin file.");
 }
 
 
@@ -166,8 +229,55 @@ ts::FileOutput::FileOutput(TSP* tsp_) :
     option(u"append", 'a');
     help(u"append", u"If the file already exists, append to the end of the file. By default, existing files are overwritten.");
 
+    DefineAsyncOptions(*this);
+
+    option(u"index", 'i');
+    help(u"index",
+         u"Build an index file for each output file. The index is named after the output file "
+         u"with an additional .tsidx suffix. It is incrementally written during the recording. "
+         u"It contains the time, random access points and PSI changes in the file and can be "
+         u"used by the options --seek-time and --seek-psi-change of the input plugin file. "
+         u"Incompatible with --append.");
+
     option(u"keep", 'k');
     help(u"keep", u"Keep existing file (abort if the specified file already exists). By default, existing files are overwritten.");
+
+    option(u"max-duration", 0, POSITIVE);
+    help(u"max-duration",
+         u"Specify a maximum duration in seconds of each output file. After the specified "
+         u"duration, the output file is closed and another one is created. The local date and time "
+         u"of creation and a sequence number are added to the file name. Example: if the specified "
+         u"file name is foo.ts, the files are named like foo-YYYYMMDD-hhmmss-NNNNNN.ts.");
+
+    option(u"max-size", 0, UNSIGNED);
+    help(u"max-size",
+         u"Specify a maximum size in bytes of each output file. When the size is reached, "
+         u"the output file is closed and another one is created, as with --max-duration. "
+         u"The files are always cut on a packet boundary.");
+
+    option(u"pcr-based");
+    help(u"pcr-based",
+         u"With --max-duration, measure the duration of the files using the PCR's from the "
+         u"first PID carrying PCR's instead of the system time. Each output file starts with "
+         u"a packet containing a PCR.");
+
+    option(u"sparse", 's');
+    help(u"sparse",
+         u"Write sparse files, without null packets. The null packets are run-length coded and the "
+         u"file contains periodic checkpoints with the recording time and the last PCR. The input "
+         u"plugin file automatically detects sparse files and rebuilds the exact original stream, "
+         u"stuffing included. With --max-size, the size applies to the sparse files. "
+         u"Incompatible with --index.");
+
+    option(u"write-behind", 'w');
+    help(u"write-behind",
+         u"Write the files in a background thread. The packets are buffered and a slow storage "
+         u"does not immediately slow down the complete processing chain.");
+
+    option(u"write-behind-size", 0, POSITIVE);
+    help(u"write-behind-size",
+         u"With --write-behind, specify the size of the buffer in TS packets. "
+         u"The default is " + UString::Decimal(TSFileRecorder::DEFAULT_BUFFER_SIZE) + u" packets.");
 }
 
 
@@ -185,11 +295,52 @@ ts::FileProcessor::FileProcessor(TSP* tsp_) :
     option(u"append", 'a');
     help(u"append", u"If the file already exists, append to the end of the file. By default, existing files are overwritten.");
 
+    DefineAsyncOptions(*this);
+
     option(u"keep", 'k');
     help(u"keep", u"Keep existing file (abort if the specified file already exists). By default, existing files are overwritten.");
 }
 
 
+//----------------------------------------------------------------------------
+// Asynchronous I/O options, common to all file plugins.
+//----------------------------------------------------------------------------
+
+namespace {
+    void DefineAsyncOptions(ts::Args& args)
+    {
+        args.option(u"direct-io");
+        args.help(u"direct-io",
+                  u"With --io-uring, use direct I/O (O_DIRECT), bypassing the system cache. "
+                  u"If the file system does not support direct I/O, the system cache is used.");
+
+        args.option(u"io-block-size", 0, ts::Args::INTEGER, 0, 1, ts::PKT_SIZE, 256 * 1024 * 1024);
+        args.help(u"io-block-size",
+                  u"With --io-uring, specify the size in bytes of each I/O operation. "
+                  u"The default is 1,048,576 bytes.");
+
+        args.option(u"io-depth", 0, ts::Args::POSITIVE);
+        args.help(u"io-depth",
+                  u"With --io-uring, specify the number of I/O operations in flight. "
+                  u"The default is " TS_STRINGIFY(DEF_IO_DEPTH) u".");
+
+        args.option(u"io-uring");
+        args.help(u"io-uring",
+                  u"Use asynchronous I/O with io_uring (Linux only). Several large I/O operations "
+                  u"are kept in flight, reducing the impact of the storage latency. This applies "
+                  u"to regular files only. If io_uring is not supported by the system, the usual "
+                  u"synchronous I/O are used.");
+    }
+
+    void LoadAsyncOptions(ts::Args& args, size_t& depth, size_t& block_size, bool& direct)
+    {
+        depth = args.present(u"io-uring") ? args.intValue<size_t>(u"io-depth", DEF_IO_DEPTH) : 0;
+        block_size = args.intValue<size_t>(u"io-block-size", ts::TSFileInput::DEFAULT_ASYNC_BLOCK_SIZE);
+        direct = args.present(u"direct-io");
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Input plugin methods
 //----------------------------------------------------------------------------
@@ -199,11 +350,32 @@ bool ts::FileInput::getOptions()
     getValues(_filenames);
     _repeat_count = present(u"infinite") ? 0 : intValue<size_t>(u"repeat", 1);
     _start_offset = intValue<uint64_t>(u"byte-offset", intValue<uint64_t>(u"packet-offset", 0) * PKT_SIZE);
+    _seek_time = intValue<MilliSecond>(u"seek-time", -1);
+    _seek_psi = intValue<size_t>(u"seek-psi-change", 0);
+
+    size_t depth = 0;
+    size_t block_size = 0;
+    bool direct = false;
+    LoadAsyncOptions(*this, depth, block_size, direct);
+    _file.setAsyncIO(depth, block_size, direct);
+    _file.setMemoryMap(present(u"memory-map"));
 
     if (_filenames.size() > 1 && _repeat_count == 0) {
         tsp->error(u"specifying --infinite is meaningless with more than one file");
         return false;
     }
+    if (depth > 0 && present(u"memory-map")) {
+        tsp->error(u"--io-uring and --memory-map are mutually exclusive");
+        return false;
+    }
+    if (int(present(u"byte-offset")) + int(present(u"packet-offset")) + int(_seek_time >= 0) + int(_seek_psi > 0) > 1) {
+        tsp->error(u"--byte-offset, --packet-offset, --seek-time and --seek-psi-change are mutually exclusive");
+        return false;
+    }
+    if (_filenames.empty() && (_seek_time >= 0 || _seek_psi > 0)) {
+        tsp->error(u"--seek-time and --seek-psi-change require an input file name");
+        return false;
+    }
 
     return true;
 }
@@ -220,14 +392,51 @@ bool ts::FileInput::start()
     // Open first input file.
     _aborted = false;
     _current_file = 0;
-    return _file.open(first, _repeat_count, _start_offset, *tsp);
+    return openFile(first);
 }
 
-bool ts::FileInput::stop()
+bool ts::FileInput::openFile(const UString& name)
+{
+    uint64_t offset = _start_offset;
+
+    // Get the start position from the index of the file.
+    if (_seek_time >= 0 || _seek_psi > 0) {
+        const UString index_name(TSPacketIndex::IndexFileName(name));
+        TSPacketIndex index;
+        PacketCounter packet = 0;
+        if (!index.load(index_name, *tsp)) {
+            return false;
+        }
+        else if (_seek_time >= 0 && !index.findTime(_seek_time, packet)) {
+            tsp->error(u"no time information in %s", {index_name});
+            return false;
+        }
+        else if (_seek_psi > 0 && !index.findPSIChange(_seek_psi, packet)) {
+            tsp->error(u"PSI change #%d not found in %s", {_seek_psi, index_name});
+            return false;
+        }
+        tsp->verbose(u"starting %s at packet %'d", {name, packet});
+        offset = packet * PKT_SIZE;
+    }
+
+    _first_read = true;
+    _sparse = false;
+    return _file.open(name, _repeat_count, offset, *tsp);
+}
+
+bool ts::FileInput::closeFile()
 {
+    if (_sparse && _decoder.errors() > 0) {
+        tsp->warning(u"%'d invalid units in sparse file", {_decoder.errors()});
+    }
     return _file.close(*tsp);
 }
 
+bool ts::FileInput::stop()
+{
+    return closeFile();
+}
+
 bool ts::FileInput::abortInput()
 {
     // Abort current operations on the file.
@@ -242,7 +451,7 @@ size_t ts::FileInput::receive(TSPacket* buffer, size_t max_packets)
     for (;;) {
 
         // Read some packets from current file.
-        size_t count = _file.read(buffer, max_packets, *tsp);
+        size_t count = readFile(buffer, max_packets);
         if (count > 0 || _aborted) {
             // Got packets, return them.
             return count;
@@ -254,9 +463,60 @@ size_t ts::FileInput::receive(TSPacket* buffer, size_t max_packets)
         }
 
         // Open the next file.
-        _file.close(*tsp);
+        closeFile();
         tsp->verbose(u"reading file %s", {_filenames[_current_file]});
-        if (!_file.open(_filenames[_current_file], _repeat_count, _start_offset, *tsp)) {
+        if (!openFile(_filenames[_current_file])) {
+            return 0;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Read packets from the current file, detect and decode sparse files.
+//----------------------------------------------------------------------------
+
+size_t ts::FileInput::readFile(TSPacket* buffer, size_t max_packets)
+{
+    if (!_sparse) {
+        const size_t count = _file.read(buffer, max_packets, *tsp);
+        if (!_first_read || count == 0) {
+            return count;
+        }
+
+        // Look for a sparse map in the first units of the file. Maps never start with a sync byte.
+        _first_read = false;
+        size_t i = 0;
+        while (i < count && !TSSparseEncoder::IsMap(buffer[i])) {
+            ++i;
+        }
+        if (i >= count) {
+            return count;
+        }
+
+        // This is a sparse file, decode the units which were already read.
+        tsp->verbose(u"sparse file detected, restoring null packets");
+        _sparse = true;
+        _decoder.reset();
+        _units.resize(std::max(count, max_packets));
+        TSPacket::Copy(&_units[0], buffer, count);
+        _units_next = 0;
+        _units_count = count;
+    }
+
+    for (;;) {
+        const TSPacket* units = &_units[_units_next];
+        const size_t previous = _units_count;
+        const size_t count = _decoder.decode(units, _units_count, buffer, max_packets);
+        _units_next += previous - _units_count;
+        if (count > 0) {
+            return count;
+        }
+
+        // All units were decoded, read the next ones.
+        _units_next = 0;
+        _units_count = _file.read(&_units[0], _units.size(), *tsp);
+        if (_units_count == 0) {
             return 0;
         }
     }
@@ -269,12 +529,49 @@ size_t ts::FileInput::receive(TSPacket* buffer, size_t max_packets)
 
 bool ts::FileOutput::start()
 {
+    size_t depth = 0;
+    size_t block_size = 0;
+    bool direct = false;
+    LoadAsyncOptions(*this, depth, block_size, direct);
+    _file.setAsyncIO(depth, block_size, direct);
+    _file.setSegmentation(intValue<uint64_t>(u"max-size"), intValue<MilliSecond>(u"max-duration") * MilliSecPerSec, present(u"pcr-based"));
+    _file.setWriteBehind(present(u"write-behind") ? intValue<size_t>(u"write-behind-size", TSFileRecorder::DEFAULT_BUFFER_SIZE) : 0);
+    _file.setIndex(present(u"index"));
+    _file.setSparse(present(u"sparse"));
+    if (present(u"index") && present(u"append")) {
+        tsp->error(u"--index and --append are mutually exclusive");
+        return false;
+    }
+    if (present(u"index") && present(u"sparse")) {
+        tsp->error(u"--index and --sparse are mutually exclusive");
+        return false;
+    }
     return _file.open(value(u""), present(u"append"), present(u"keep"), *tsp);
 }
 
 bool ts::FileOutput::stop()
 {
-    return _file.close(*tsp);
+    const bool ok = _file.close(*tsp);
+
+    // Report recording statistics.
+    TSFileRecorder::Statistics stats;
+    _file.getStatistics(stats);
+    const LogHistogram& lat(stats.write_latency);
+    if (_file.isSegmented()) {
+        tsp->verbose(u"wrote %'d packets in %'d files", {stats.packets, stats.files});
+    }
+    if (present(u"sparse") && stats.packets > 0) {
+        tsp->verbose(u"sparse recording: %'d packets stored in %'d units (%d%%)", {stats.packets, stats.units, (100 * stats.units) / stats.packets});
+    }
+    if (lat.count() > 0) {
+        tsp->verbose(u"write latency (us): mean: %'d, p99: %'d, max: %'d", {uint64_t(lat.mean()), lat.percentile(99.0), lat.maximum()});
+    }
+    if (stats.buffer_size > 0) {
+        // When the buffer was full, the storage was too slow and the processing chain was slowed down.
+        tsp->log(stats.high_water >= stats.buffer_size ? Severity::Warning : Severity::Verbose,
+                 u"write-behind buffer high-water mark: %'d packets (%d%%)", {stats.high_water, (100 * stats.high_water) / stats.buffer_size});
+    }
+    return ok;
 }
 
 bool ts::FileOutput::send(const TSPacket* buffer, size_t packet_count)
@@ -289,6 +586,11 @@ bool ts::FileOutput::send(const TSPacket* buffer, size_t packet_count)
 
 bool ts::FileProcessor::start()
 {
+    size_t depth = 0;
+    size_t block_size = 0;
+    bool direct = false;
+    LoadAsyncOptions(*this, depth, block_size, direct);
+    _file.setAsyncIO(depth, block_size, direct);
     return _file.open(value(u""), present(u"append"), present(u"keep"), *tsp);
 }
 
@@ -37,9 +37,14 @@
 #include "tsIPUtils.h"
 #include "tsUDPSocket.h"
 #include "tsUDPReceiver.h"
+#include "tsRTPReorderBuffer.h"
+#include "tsSystemRandomGenerator.h"
 #include "tsSysUtils.h"
+#include "tsIntegerUtils.h"
 #include "tsTime.h"
+#include "tsMonotonic.h"
 #include "tsNullReport.h"
+#include <atomic>
 TSDUCK_SOURCE;
 
 // Grouping TS packets in UDP packets
@@ -48,6 +53,11 @@ TSDUCK_SOURCE;
 #define MAX_PACKET_BURST   128  // ~ 48 kB
 #define MAX_IP_SIZE      65536
 
+// Pacing of UDP output messages (in nanoseconds).
+
+#define TXTIME_LEAD      10000000  // 10 ms, messages are passed in advance to the system with --txtime
+#define MAX_PACING_LATE 100000000  // 100 ms, resynchronize pacing when late by more than this
+
 
 //----------------------------------------------------------------------------
 // Plugin definition
@@ -69,6 +79,7 @@ namespace ts {
         virtual BitRate getBitrate() override;
         virtual size_t receive(TSPacket*, size_t) override;
         virtual bool abortInput() override;
+        virtual void getMetrics(MetricsWriter&) override;
 
     private:
         UDPReceiver   _sock;               // Incoming socket with associated command line options
@@ -81,9 +92,30 @@ namespace ts {
         PacketCounter _packets_0;          // Number of received packets since _start_0
         Time          _start_1;            // Start of previous bitrate evaluation period
         PacketCounter _packets_1;          // Number of received packets since _start_1
-        size_t        _inbuf_count;        // Remaining TS packets in inbuf
-        size_t        _inbuf_next;         // Index in inbuf of next TS packet to return
-        uint8_t       _inbuf[MAX_IP_SIZE]; // Input buffer
+        std::atomic<uint64_t> _dropped;    // Number of datagrams dropped by the system, as last reported
+        NanoSecond    _reorder_latency;    // Maximum latency of RTP reordering, zero if no reordering
+        bool          _reorder;            // Reorder RTP messages
+        RTPReorderBuffer _rtp;             // RTP reordering buffer
+        size_t        _max_datagram;       // Size of largest received datagram, zero if unknown
+        size_t        _msg_count;          // Number of received messages in _msg
+        size_t        _msg_next;           // Index in _msg of next message to process
+        size_t        _inbuf_count;        // Remaining TS packets in current message
+        const uint8_t* _inbuf_next;        // Address of next TS packet to return in current message
+        uint8_t       _inbuf[MAX_IP_SIZE]; // Input buffer, shared by all messages of a batch
+        UDPSocket::ReceivedMessage _msg[UDPSocket::MAX_RECEIVE_COUNT]; // Batch of received messages
+
+        // Receive a new batch of UDP messages.
+        bool receiveMessages();
+
+        // Move to the next message to process in the current batch. Return false if there is none.
+        bool nextMessage();
+
+        // Insert a received message in the RTP reordering buffer. Return false if the message
+        // cannot be reordered and must be processed directly.
+        bool insertRTP(const UDPSocket::ReceivedMessage& msg);
+
+        // Evaluate the real-time input bitrate after receiving new packets.
+        void evaluateBitrate(size_t packets, NanoSecond timestamp);
 
         // Inaccessible operations
         IPInput() = delete;
@@ -104,8 +136,25 @@ namespace ts {
         virtual bool send(const TSPacket*, size_t) override;
 
     private:
-        UDPSocket _sock;        // Outgoing socket
-        size_t    _pkt_burst;   // Number of TS packets per UDP message
+        UDPSocket  _sock;           // Outgoing socket
+        size_t     _pkt_burst;      // Number of TS packets per UDP message
+        bool       _rtp;            // Use RTP encapsulation
+        uint8_t    _rtp_pt;         // RTP payload type
+        uint16_t   _rtp_sequence;   // RTP sequence number of next message
+        uint32_t   _rtp_ssrc;       // RTP synchronization source identifier
+        PID        _pcr_pid;        // PID containing PCR's for RTP timestamps, PID_NULL if not yet known
+        uint64_t   _last_pcr;       // Last PCR value in _pcr_pid
+        PacketCounter _pkt_since_pcr; // Number of packets after _last_pcr
+        ByteBlock  _rtp_buffer;     // Buffer for the RTP messages of a group, one slot per message
+        bool       _pacing;         // Spread UDP messages evenly at the TS bitrate
+        bool       _txtime;         // Use system transmission time for pacing
+        bool       _unknown_rate;   // Already reported unknown bitrate with pacing
+        bool       _due_valid;      // _next_due is valid
+        Monotonic  _next_due;       // Transmission time of next UDP message with pacing
+        UDPSocket::SentMessage _msg[UDPSocket::MAX_SEND_COUNT]; // Group of messages to send
+
+        // Build the UDP message at the given index in _msg with some TS packets.
+        void buildMessage(size_t index, const TSPacket* pkt, size_t count, NanoSecond delay, BitRate bitrate);
 
         // Inaccessible operations
         IPOutput() = delete;
@@ -135,9 +184,17 @@ ts::IPInput::IPInput(TSP* tsp_) :
     _packets_0(0),
     _start_1(Time::Epoch),
     _packets_1(0),
+    _dropped(0),
+    _reorder_latency(0),
+    _reorder(false),
+    _rtp(),
+    _max_datagram(0),
+    _msg_count(0),
+    _msg_next(0),
     _inbuf_count(0),
-    _inbuf_next(0),
-    _inbuf()
+    _inbuf_next(nullptr),
+    _inbuf(),
+    _msg()
 {
     // Add UDP receiver common options.
     _sock.defineOptions(*this);
@@ -154,6 +211,16 @@ ts::IPInput::IPInput(TSP* tsp_) :
          u"basis. The value specifies the number of seconds between two evaluations. "
          u"By default, the real-time input bitrate is never evaluated and the input "
          u"bitrate is evaluated from the PCR in the input packets.");
+
+    option(u"reorder-latency", 0, POSITIVE);
+    help(u"reorder-latency",
+         u"When the TS packets are encapsulated in RTP, reorder the incoming messages "
+         u"according to their RTP sequence numbers. The value specifies the maximum time "
+         u"in milliseconds a message is held while waiting for a missing one. After that "
+         u"time, the missing message is considered as lost. The reordering buffer is sized "
+         u"according to this latency and the input bitrate. The RTP statistics (lost, "
+         u"reordered, duplicated messages) are reported when the plugin stops. By default, "
+         u"the messages are processed in their order of arrival.");
 }
 
 
@@ -164,7 +231,21 @@ ts::IPInput::IPInput(TSP* tsp_) :
 ts::IPOutput::IPOutput(TSP* tsp_) :
     OutputPlugin(tsp_, u"Send TS packets using UDP/IP, multicast or unicast", u"[options] address:port"),
     _sock(false, *tsp_),
-    _pkt_burst(DEF_PACKET_BURST)
+    _pkt_burst(DEF_PACKET_BURST),
+    _rtp(false),
+    _rtp_pt(RTP_PT_MP2T),
+    _rtp_sequence(0),
+    _rtp_ssrc(0),
+    _pcr_pid(PID_NULL),
+    _last_pcr(0),
+    _pkt_since_pcr(0),
+    _rtp_buffer(),
+    _pacing(false),
+    _txtime(false),
+    _unknown_rate(false),
+    _due_valid(false),
+    _next_due(),
+    _msg()
 {
     option(u"", 0, STRING, 1, 1);
     help(u"",
@@ -185,6 +266,48 @@ ts::IPOutput::IPOutput(TSP* tsp_) :
          u"The default is " TS_STRINGIFY(DEF_PACKET_BURST) u", the maximum is "
          TS_STRINGIFY(MAX_PACKET_BURST) u".");
 
+    option(u"pacing");
+    help(u"pacing",
+         u"Spread the UDP messages evenly in time, at the bitrate of the transport stream. "
+         u"By default, the UDP messages are sent as soon as the TS packets are available, "
+         u"possibly in bursts. Pacing avoids bursts which could overflow the buffers of "
+         u"the receivers. The bitrate of the transport stream must be known, typically "
+         u"from the PCR's.");
+
+    option(u"txtime");
+    help(u"txtime",
+         u"With --pacing, let the system schedule the transmission of each UDP message "
+         u"(socket option SO_TXTIME, Linux only). This is more precise than the software "
+         u"pacing but requires a compatible queuing discipline on the network interface, "
+         u"typically \"fq\". If SO_TXTIME is not supported, the software pacing is used.");
+
+    option(u"pcr-pid", 0, PIDVAL);
+    help(u"pcr-pid",
+         u"With --rtp, specify the PID containing the PCR's which are used to compute "
+         u"the RTP timestamps. By default, use the first PID containing PCR's.");
+
+    option(u"payload-type", 0, INTEGER, 0, 1, 0, 127);
+    help(u"payload-type",
+         u"With --rtp, specify the payload type. "
+         u"The default is 33, as defined in RFC 3551 for MPEG-2 transport streams.");
+
+    option(u"rtp", 'r');
+    help(u"rtp",
+         u"Use the Real-time Transport Protocol (RTP, RFC 3550 and RFC 2250) in UDP messages. "
+         u"The RTP timestamps are derived from the PCR's, using the 90 kHz clock of MPEG-2 "
+         u"transport streams. By default, the TS packets are sent in UDP messages without "
+         u"encapsulation.");
+
+    option(u"ssrc-identifier", 0, UINT32);
+    help(u"ssrc-identifier",
+         u"With --rtp, specify the synchronization source (SSRC) identifier. "
+         u"By default, a random value is used.");
+
+    option(u"start-sequence-number", 0, UINT16);
+    help(u"start-sequence-number",
+         u"With --rtp, specify the initial sequence number. "
+         u"By default, a random value is used.");
+
     option(u"tos", 's', INTEGER, 0, 1, 1, 255);
     help(u"tos",
          u"Specifies the TOS (Type-Of-Service) socket option. Setting this value "
@@ -208,6 +331,7 @@ bool ts::IPInput::getOptions()
     // Get command line arguments
     _eval_time = MilliSecPerSec * intValue<MilliSecond>(u"evaluation-interval", 0);
     _display_time = MilliSecPerSec * intValue<MilliSecond>(u"display-interval", 0);
+    _reorder_latency = NanoSecPerMilliSec * intValue<NanoSecond>(u"reorder-latency", 0);
     return _sock.load(*this);
 }
 
@@ -218,14 +342,25 @@ bool ts::IPInput::getOptions()
 
 bool ts::IPInput::start()
 {
-    // Create UDP socket
+    // Create UDP socket. When the bitrate is evaluated, use kernel timestamps of UDP
+    // messages instead of the time when the messages are processed by the plugin.
     if (!_sock.open(*tsp)) {
         return false;
     }
+    if (_eval_time > 0 && !_sock.setReceiveTimestamps(true, *tsp)) {
+        _sock.close(*tsp);
+        return false;
+    }
 
     // Socket now ready.
     // Initialize working data.
-    _inbuf_count = _inbuf_next = 0;
+    _dropped = 0;
+    _max_datagram = 0;
+    _msg_count = _msg_next = 0;
+    _inbuf_count = 0;
+    _inbuf_next = nullptr;
+    _reorder = _reorder_latency > 0;
+    _rtp.reset(RTPReorderBuffer::DEFAULT_CAPACITY, _reorder_latency);
     _start = _start_0 = _start_1 = _next_display = Time::Epoch;
     _packets = _packets_0 = _packets_1 = 0;
 
@@ -239,6 +374,15 @@ bool ts::IPInput::start()
 
 bool ts::IPInput::stop()
 {
+    if (_sock.droppedDatagrams() > 0) {
+        tsp->warning(u"%'d UDP messages were dropped by the system", {_sock.droppedDatagrams()});
+    }
+    if (_reorder) {
+        const RTPReorderBuffer::Statistics& st(_rtp.statistics());
+        tsp->log(st.lost > 0 || st.late > 0 ? Severity::Warning : Severity::Verbose,
+                 u"RTP: %'d messages received, %'d lost, %'d reordered, %'d duplicated, %'d too late, %'d sequence discontinuities",
+                 {st.received, st.lost, st.reordered, st.duplicated, st.late, st.resync});
+    }
     _sock.close(*tsp);
     return true;
 }
@@ -264,6 +408,16 @@ bool ts::IPInput::abortInput()
     return true;
 }
 
+
+//----------------------------------------------------------------------------
+// Plugin-specific metrics, invoked from the metrics server thread.
+//----------------------------------------------------------------------------
+
+void ts::IPInput::getMetrics(MetricsWriter& writer)
+{
+    writer.counter(u"udp_dropped_datagrams_total", u"Number of incoming UDP datagrams dropped by the system.", _dropped.load(std::memory_order_relaxed));
+}
+
 //----------------------------------------------------------------------------
 // Input bitrate evaluation method
 //----------------------------------------------------------------------------
@@ -284,126 +438,210 @@ ts::BitRate ts::IPInput::getBitrate()
 
 
 //----------------------------------------------------------------------------
-// Input method
+// Receive a new batch of UDP messages.
 //----------------------------------------------------------------------------
 
-size_t ts::IPInput::receive(TSPacket* buffer, size_t max_packets)
+bool ts::IPInput::receiveMessages()
 {
-    // Check if we receive new packets or process remain of previous buffer.
-    bool new_packets = false;
-
-    // If there is no remaining packet in the input buffer, wait for a UDP
-    // message. Loop until we get some TS packets.
-    while (_inbuf_count <= 0) {
-
-        // Wait for a UDP message
-        SocketAddress sender;
-        SocketAddress destination;
-        size_t insize;
-        if (!_sock.receive(_inbuf, sizeof(_inbuf), insize, sender, destination, tsp, *tsp)) {
-            return 0;
+    // Split the input buffer in slots, one per UDP message. As long as the size of the
+    // messages is unknown, receive one message at a time in the complete buffer. Then,
+    // use slots which are large enough for the largest received message, with some margin.
+    // In the usual case of 7 TS packets per message, up to 21 messages are received at once.
+    const size_t slot_size = _max_datagram == 0 ? sizeof(_inbuf) : std::min(sizeof(_inbuf), RoundUp(_max_datagram, size_t(1024)) + 1024);
+    const size_t slot_count = std::min(sizeof(_inbuf) / slot_size, UDPSocket::MAX_RECEIVE_COUNT);
+
+    for (size_t i = 0; i < slot_count; ++i) {
+        _msg[i].data = _inbuf + i * slot_size;
+        _msg[i].max_size = slot_size;
+    }
+
+    // Wait for UDP messages.
+    _msg_count = _msg_next = 0;
+    if (!_sock.receive(_msg, slot_count, _msg_count, tsp, *tsp)) {
+        return false;
+    }
+
+    // Check the size of the received messages.
+    for (size_t i = 0; i < _msg_count; ++i) {
+        if (_msg[i].truncated) {
+            // Truncated message, its end is lost. Revert to one message at a time to get its actual size.
+            tsp->warning(u"truncated UDP message from %s, slot size was %'d bytes", {_msg[i].sender, slot_size});
+            _max_datagram = 0;
+            break;
         }
+        _max_datagram = std::max(_max_datagram, _msg[i].size);
+    }
 
-        // Locate the TS packets inside the UDP message. Basically, we
-        // expect the message to contain only TS packets. However, we
-        // will face the following situations:
-        // - Presence of a header preceeding the first TS packet (typically
-        //   when the TS packets are encapsulated in RTP).
-        // - Presence of a truncated packet at the end of message.
-
-        // To face the first situation, we look backward from the end of
-        // the message, looking for a 0x47 sync byte every 188 bytes, going
-        // backward.
-
-        const uint8_t* p;
-        for (p = _inbuf + insize; p >= _inbuf + PKT_SIZE && p[-int(PKT_SIZE)] == SYNC_BYTE; p -= PKT_SIZE) {}
-
-        if (p < _inbuf + insize) {
-            // Some packets were found
-            _inbuf_next = p - _inbuf;
-            _inbuf_count = (_inbuf + insize - p) / PKT_SIZE;
-            new_packets = true;
-            break; // exit receive loop
+    // The RTP reordering buffer must hold all messages which are received during the latency.
+    // Twice the number of messages at the current bitrate is used, as a margin for bursts.
+    const BitRate bitrate = tsp->bitrate();
+    if (_reorder && bitrate > 0 && _max_datagram > 0) {
+        const size_t capacity = size_t(2 * uint64_t(_reorder_latency / NanoSecPerMilliSec) * bitrate / (8 * MilliSecPerSec * _max_datagram)) + 1;
+        if (capacity > _rtp.capacity()) {
+            _rtp.growCapacity(capacity);
+            tsp->debug(u"RTP reordering buffer resized to %'d messages", {_rtp.capacity()});
         }
+    }
 
-        // If no TS packet is found using the first method, we restart from
-        // the beginning of the message, looking for a 0x47 sync byte every
-        // 188 bytes, going forward. If we find this pattern, followed by
-        // less than 188 bytes, then we have found a sequence of TS packets.
-
-        const uint8_t* max = _inbuf + insize - PKT_SIZE; // max address for a TS packet
-        _inbuf_count = 0;
-
-        for (p = _inbuf; p <= max; p++) {
-            if (*p == SYNC_BYTE) {
-                // Verify that we get a 0x47 sync byte every 188 bytes up
-                // to the end of message (not leaving more than one truncated
-                // TS packet at the end of the message).
-                const uint8_t* end;
-                for (end = p; end <= max && *end == SYNC_BYTE; end += PKT_SIZE) {}
-                if (end > max) {
-                    // Less than 188 bytes after last packet. Consider we are OK
-                    _inbuf_next = p - _inbuf;
-                    _inbuf_count = (end - p) / PKT_SIZE;
-                    new_packets = true;
-                    break; // exit packet search loop
-                }
-            }
+    // Report new datagrams which were dropped by the system.
+    if (_sock.droppedDatagrams() > _dropped) {
+        if (_dropped == 0) {
+            tsp->warning(u"UDP messages are dropped by the system, consider increasing the socket buffer size (--buffer-size)");
         }
+        tsp->debug(u"%'d UDP messages dropped by the system", {_sock.droppedDatagrams() - _dropped});
+        _dropped = _sock.droppedDatagrams();
+    }
+
+    return true;
+}
 
-        if (new_packets) {
-            break; // exit receive loop
+
+//----------------------------------------------------------------------------
+// Move to the next message to process in the current batch.
+//----------------------------------------------------------------------------
+
+bool ts::IPInput::nextMessage()
+{
+    const UDPSocket::ReceivedMessage* msg = nullptr;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    // With RTP reordering, the received messages are inserted one by one in the
+    // reordering buffer until a message can be extracted in sequence order.
+    for (;;) {
+        if (_reorder && _rtp.next(data, size, Monotonic(true))) {
+            break;
+        }
+        if (_msg_next >= _msg_count) {
+            // All received messages are processed.
+            return false;
+        }
+        msg = &_msg[_msg_next++];
+        if (!_reorder || !insertRTP(*msg)) {
+            data = reinterpret_cast<const uint8_t*>(msg->data);
+            size = msg->size;
+            break;
         }
+        msg = nullptr;
+    }
 
-        // No TS packet found in UDP message, wait for another one.
-        tsp->debug(u"no TS packet in message from %s, %s bytes", {sender, insize});
+    size_t start = 0;
+    if (!LocateTSPackets(data, size, start, _inbuf_count)) {
+        tsp->debug(u"no TS packet in message, %s bytes", {size});
     }
+    _inbuf_next = data + start;
 
-    // If new packets were received, we may need to re-evaluate the real-time input bitrate.
-    if (new_packets && _eval_time > 0) {
+    // The bitrate of reordered messages is evaluated when they are received.
+    if (_eval_time > 0 && msg != nullptr) {
+        evaluateBitrate(_inbuf_count, msg->timestamp);
+    }
+    return true;
+}
 
-        const Time now(Time::CurrentUTC());
 
-        // Detect start time
-        if (_packets == 0) {
-            _start = _start_0 = _start_1 = now;
-            if (_display_time > 0) {
-                _next_display = now + _display_time;
-            }
+//----------------------------------------------------------------------------
+// Insert a received message in the RTP reordering buffer.
+//----------------------------------------------------------------------------
+
+bool ts::IPInput::insertRTP(const UDPSocket::ReceivedMessage& msg)
+{
+    size_t offset = 0;
+    size_t size = 0;
+    uint16_t sequence = 0;
+
+    if (!GetRTPPayload(msg.data, msg.size, offset, size, sequence)) {
+        if (_rtp.statistics().received == 0) {
+            // Not an RTP stream, no need to reorder.
+            tsp->warning(u"UDP messages from %s are not RTP, cannot reorder them", {msg.sender});
+            _reorder = false;
+            return false;
         }
+        tsp->debug(u"invalid RTP message from %s, %d bytes", {msg.sender, msg.size});
+    }
+    else if (_rtp.insert(sequence, reinterpret_cast<const uint8_t*>(msg.data) + offset, size, Monotonic(true)) && _eval_time > 0) {
+        // The payload of an RTP/MP2T message contains an integral number of TS packets.
+        evaluateBitrate(size / PKT_SIZE, msg.timestamp);
+    }
+    return true;
+}
 
-        // Count packets
-        _packets += _inbuf_count;
-        _packets_0 += _inbuf_count;
-        _packets_1 += _inbuf_count;
 
-        // Detect new evaluation period
-        if (now >= _start_1 + _eval_time) {
-            _start_0 = _start_1;
-            _packets_0 = _packets_1;
-            _start_1 = now;
-            _packets_1 = 0;
+//----------------------------------------------------------------------------
+// Evaluate the real-time input bitrate after receiving new packets.
+//----------------------------------------------------------------------------
 
+void ts::IPInput::evaluateBitrate(size_t packets, NanoSecond timestamp)
+{
+    // Use the kernel timestamp of the UDP message when available.
+    const Time now(timestamp >= 0 ? Time::UnixEpoch + timestamp / NanoSecPerMilliSec : Time::CurrentUTC());
+
+    // Detect start time
+    if (_packets == 0) {
+        _start = _start_0 = _start_1 = now;
+        if (_display_time > 0) {
+            _next_display = now + _display_time;
         }
+    }
 
-        // Check if evaluated bitrate should be displayed
-        if (_display_time > 0 && now >= _next_display) {
-            _next_display += _display_time;
-            const MilliSecond ms_current = Time::CurrentUTC() - _start_0;
-            const MilliSecond ms_total = Time::CurrentUTC() - _start;
-            const BitRate br_current = ms_current == 0 ? 0 : BitRate((_packets_0 * PKT_SIZE * 8 * MilliSecPerSec) / ms_current);
-            const BitRate br_average = ms_total == 0 ? 0 : BitRate((_packets * PKT_SIZE * 8 * MilliSecPerSec) / ms_total);
-            tsp->info(u"IP input bitrate: %s, average: %s", {
-                br_current == 0 ? u"undefined" : UString::Decimal(br_current) + u" b/s",
-                br_average == 0 ? u"undefined" : UString::Decimal(br_average) + u" b/s"});
-        }
+    // Count packets
+    _packets += packets;
+    _packets_0 += packets;
+    _packets_1 += packets;
+
+    // Detect new evaluation period
+    if (now >= _start_1 + _eval_time) {
+        _start_0 = _start_1;
+        _packets_0 = _packets_1;
+        _start_1 = now;
+        _packets_1 = 0;
+    }
+
+    // Check if evaluated bitrate should be displayed
+    if (_display_time > 0 && now >= _next_display) {
+        _next_display += _display_time;
+        const MilliSecond ms_current = now - _start_0;
+        const MilliSecond ms_total = now - _start;
+        const BitRate br_current = ms_current == 0 ? 0 : BitRate((_packets_0 * PKT_SIZE * 8 * MilliSecPerSec) / ms_current);
+        const BitRate br_average = ms_total == 0 ? 0 : BitRate((_packets * PKT_SIZE * 8 * MilliSecPerSec) / ms_total);
+        tsp->info(u"IP input bitrate: %s, average: %s", {
+            br_current == 0 ? u"undefined" : UString::Decimal(br_current) + u" b/s",
+            br_average == 0 ? u"undefined" : UString::Decimal(br_average) + u" b/s"});
     }
+}
+
+
+//----------------------------------------------------------------------------
+// Input method
+//----------------------------------------------------------------------------
 
-    // Return packets from the input buffer
-    size_t pkt_cnt = std::min(_inbuf_count, max_packets);
-    TSPacket::Copy(buffer, _inbuf + _inbuf_next, pkt_cnt);
-    _inbuf_count -= pkt_cnt;
-    _inbuf_next += pkt_cnt * PKT_SIZE;
+size_t ts::IPInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    size_t pkt_cnt = 0;
+
+    // Fill the packet buffer with the content of as many messages as possible.
+    // Wait for new messages only when no packet at all is available.
+    while (pkt_cnt < max_packets) {
+
+        // If there is no remaining packet in the current message, move to next message.
+        while (_inbuf_count == 0 && nextMessage()) {}
+
+        // Return packets from the current message.
+        if (_inbuf_count > 0) {
+            const size_t count = std::min(_inbuf_count, max_packets - pkt_cnt);
+            TSPacket::Copy(buffer + pkt_cnt, _inbuf_next, count);
+            _inbuf_count -= count;
+            _inbuf_next += count * PKT_SIZE;
+            pkt_cnt += count;
+        }
+        else if (pkt_cnt > 0) {
+            // All received messages are processed, return what we have.
+            break;
+        }
+        else if (!receiveMessages()) {
+            // No packet at all and error while receiving messages.
+            return 0;
+        }
+    }
 
     return pkt_cnt;
 }
@@ -421,6 +659,25 @@ bool ts::IPOutput::start()
     const int ttl = intValue(u"ttl", 0);
     const int tos = intValue(u"tos", -1);
     _pkt_burst = intValue(u"packet-burst", DEF_PACKET_BURST);
+    _pacing = present(u"pacing");
+    _txtime = _pacing && present(u"txtime");
+    _unknown_rate = false;
+    _due_valid = false;
+    _rtp = present(u"rtp");
+    _rtp_pt = intValue<uint8_t>(u"payload-type", RTP_PT_MP2T);
+    _pcr_pid = intValue<PID>(u"pcr-pid", PID_NULL);
+    _last_pcr = 0;
+    _pkt_since_pcr = 0;
+    _rtp_buffer.resize(_rtp ? UDPSocket::MAX_SEND_COUNT * (RTP_HEADER_SIZE + _pkt_burst * PKT_SIZE) : 0);
+
+    // Random initial sequence number and SSRC by default (RFC 3550, section 5.1).
+    SystemRandomGenerator prng;
+    if (!prng.read(&_rtp_sequence, sizeof(_rtp_sequence)) || !prng.read(&_rtp_ssrc, sizeof(_rtp_ssrc))) {
+        _rtp_sequence = 0;
+        _rtp_ssrc = 0;
+    }
+    _rtp_sequence = intValue<uint16_t>(u"start-sequence-number", _rtp_sequence);
+    _rtp_ssrc = intValue<uint32_t>(u"ssrc-identifier", _rtp_ssrc);
 
     // Create UDP socket
     bool ok = _sock.open(*tsp);
@@ -435,6 +692,15 @@ bool ts::IPOutput::start()
         }
     }
 
+    // Use the system transmission time if possible, software pacing otherwise.
+    if (ok && _txtime && !_sock.setTransmitTime(true, *tsp)) {
+        tsp->verbose(u"SO_TXTIME not available, using software pacing");
+        _txtime = false;
+    }
+    if (ok && _pacing && !_txtime) {
+        Monotonic::SetPrecision(NanoSecPerMilliSec);
+    }
+
     return ok;
 }
 
@@ -466,16 +732,99 @@ ts::IPOutput::~IPOutput()
 
 bool ts::IPOutput::send(const TSPacket* pkt, size_t packet_count)
 {
-    // Send TS packets in UDP messages, grouped according to burst size.
+    // Pacing is possible only when the bitrate is known.
+    const BitRate bitrate = tsp->bitrate();
+    const bool paced = _pacing && bitrate > 0;
+    if (_pacing && bitrate == 0 && !_unknown_rate) {
+        tsp->warning(u"unknown bitrate, UDP messages are not paced");
+        _unknown_rate = true;
+    }
 
+    // With system transmission time, the messages are passed in advance to the system.
+    const NanoSecond lead = _txtime ? TXTIME_LEAD : 0;
+
+    // Send TS packets in UDP messages, grouped according to burst size.
     while (packet_count > 0) {
-        size_t count = std::min(packet_count, _pkt_burst);
-        if (!_sock.send(pkt, count * PKT_SIZE, *tsp)) {
+
+        size_t msg_count = 0;
+
+        if (!paced) {
+            // No pacing, send as many UDP messages as possible in one system call.
+            while (packet_count > 0 && msg_count < UDPSocket::MAX_SEND_COUNT) {
+                const size_t count = std::min(packet_count, _pkt_burst);
+                buildMessage(msg_count++, pkt, count, 0, bitrate);
+                pkt += count;
+                packet_count -= count;
+            }
+        }
+        else {
+            // Pacing, resynchronize when late, typically after an input interruption.
+            const Monotonic now(true);
+            if (!_due_valid || now - _next_due > MAX_PACING_LATE) {
+                _next_due = now;
+                _due_valid = true;
+            }
+
+            // Get all UDP messages which are due now (or within the lead time).
+            while (packet_count > 0 && msg_count < UDPSocket::MAX_SEND_COUNT && _next_due - now <= lead) {
+                const size_t count = std::min(packet_count, _pkt_burst);
+                buildMessage(msg_count++, pkt, count, _next_due - now, bitrate);
+                _next_due += (NanoSecond(count * PKT_SIZE * 8) * NanoSecPerSec) / NanoSecond(bitrate);
+                pkt += count;
+                packet_count -= count;
+            }
+
+            // If no message is due yet, wait for the next one.
+            if (msg_count == 0) {
+                Monotonic wakeup(_next_due);
+                wakeup -= lead;
+                wakeup.wait();
+                continue;
+            }
+        }
+
+        if (!_sock.send(_msg, msg_count, *tsp)) {
             return false;
         }
-        pkt += count;
-        packet_count -= count;
     }
 
     return true;
 }
+
+
+//----------------------------------------------------------------------------
+// Build the UDP message at the given index in _msg with some TS packets.
+//----------------------------------------------------------------------------
+
+void ts::IPOutput::buildMessage(size_t index, const TSPacket* pkt, size_t count, NanoSecond delay, BitRate bitrate)
+{
+    // Without RTP, the TS packets are directly sent from the packet buffer.
+    if (!_rtp) {
+        _msg[index] = UDPSocket::SentMessage(pkt, count * PKT_SIZE, delay);
+        return;
+    }
+
+    // The RTP timestamp is the time of the first packet in the message, using the 90 kHz
+    // clock. Extrapolate the last PCR at the position of the packet, using the TS bitrate.
+    // Before the first PCR, the timestamps start from zero.
+    uint64_t pcr = _last_pcr;
+    if (bitrate > 0) {
+        pcr += (_pkt_since_pcr * PKT_SIZE * 8 * SYSTEM_CLOCK_FREQ) / bitrate;
+    }
+
+    // Build the RTP message in its slot of the RTP buffer.
+    uint8_t* const data = _rtp_buffer.data() + index * (RTP_HEADER_SIZE + _pkt_burst * PKT_SIZE);
+    BuildRTPHeader(data, _rtp_pt, _rtp_sequence++, uint32_t(pcr / SYSTEM_CLOCK_SUBFACTOR), _rtp_ssrc);
+    ::memcpy(data + RTP_HEADER_SIZE, pkt, count * PKT_SIZE);
+    _msg[index] = UDPSocket::SentMessage(data, RTP_HEADER_SIZE + count * PKT_SIZE, delay);
+
+    // Collect the PCR's for the next timestamps.
+    for (size_t i = 0; i < count; ++i) {
+        if (pkt[i].hasPCR() && (_pcr_pid == PID_NULL || pkt[i].getPID() == _pcr_pid)) {
+            _pcr_pid = pkt[i].getPID();
+            _last_pcr = pkt[i].getPCR();
+            _pkt_since_pcr = 0;
+        }
+        _pkt_since_pcr++;
+    }
+}
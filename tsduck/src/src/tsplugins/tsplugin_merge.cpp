@@ -46,6 +46,7 @@
 TSDUCK_SOURCE;
 
 #define DEFAULT_MAX_QUEUED_PACKETS  1000            // Default size in packet of the inter-thread queue.
+#define MAX_READ_WINDOW             64              // Max number of packets to access at a time in the inter-thread queue.
 #define SERVER_THREAD_STACK_SIZE    (128 * 1024)    // Size in byte of the thread stack.
 #define DEMUX_MAIN                  1               // Id of the demux from the main TS.
 #define DEMUX_MERGE                 2               // Id of the demux from the secondary TS to merge.
@@ -94,6 +95,9 @@ namespace ts {
         PacketCounter     _pkt_count;         // Packet counter in the main stream.
         ForkPipe          _pipe;              // Executed command.
         TSPacketQueue     _queue;             // TS packet queur from merge to main.
+        const TSPacket*   _window;            // Current read window in _queue.
+        size_t            _window_size;       // Number of packets in _window.
+        size_t            _window_next;       // Index of next packet to read in _window.
         PIDSet            _main_pids;         // Set of detected PID's in main stream.
         PIDSet            _merge_pids;        // Set of detected PID's in merged stream that we pass in main stream.
         PIDContextMap     _pcr_pids;          // Description of PID's with PCR's from the merged stream.
@@ -165,6 +169,9 @@ ts::MergePlugin::MergePlugin(TSP* tsp_) :
     _pkt_count(0),
     _pipe(),
     _queue(),
+    _window(nullptr),
+    _window_size(0),
+    _window_next(0),
     _main_pids(),
     _merge_pids(),
     _pcr_pids(),
@@ -202,7 +209,9 @@ ts::MergePlugin::MergePlugin(TSP* tsp_) :
     help(u"max-queue",
          u"Specify the maximum number of queued TS packets before their "
          u"insertion into the stream. The default is " +
-         UString::Decimal(DEFAULT_MAX_QUEUED_PACKETS) + u".");
+         UString::Decimal(DEFAULT_MAX_QUEUED_PACKETS) + u". "
+         u"In verbose mode, the maximum number of packets which were actually queued "
+         u"is reported at the end of the processing, as a hint to adjust this value.");
 
     option(u"no-pcr-restamp");
     help(u"no-pcr-restamp",
@@ -267,6 +276,8 @@ bool ts::MergePlugin::start()
 
     // Resize the inter-thread packet queue.
     _queue.reset(max_queue);
+    _window = nullptr;
+    _window_size = _window_next = 0;
 
     // Configure the demux. We need to analyze and modify the PAT, CAT and SDT
     // from the two transport streams.
@@ -369,6 +380,9 @@ bool ts::MergePlugin::stop()
 
     // Wait for actual thread termination.
     Thread::waitForTermination();
+
+    // Report the queue usage to help tuning --max-queue.
+    tsp->verbose(u"max queue usage: %'d packets, queue size: %'d packets", {_queue.highWaterMark(), _queue.bufferSize()});
     return true;
 }
 
@@ -498,19 +512,27 @@ ts::ProcessorPlugin::Status ts::MergePlugin::processPacket(TSPacket& pkt, bool&
 
 ts::ProcessorPlugin::Status ts::MergePlugin::processMergePacket(TSPacket& pkt)
 {
-    BitRate merge_bitrate = 0;
-
-    // Replace current null packet in main stream with next packet from merged stream.
-    if (!_queue.getPacket(pkt, merge_bitrate)) {
-        // No packet available, keep original null packet.
-        if (!_got_eof && _queue.eof()) {
-            // Report end of input stream once.
-            _got_eof = true;
-            tsp->verbose(u"end of merged stream");
+    // Directly access the packets from the merged stream in the inter-thread queue.
+    // The packets are released when the current read window is exhausted.
+    if (_window_next >= _window_size) {
+        _queue.releaseReadBuffer(_window_size);
+        _window_size = _window_next = 0;
+        BitRate merge_bitrate = 0;
+        if (!_queue.lockReadBuffer(_window, _window_size, merge_bitrate, MAX_READ_WINDOW)) {
+            // No packet available, keep original null packet.
+            _window_size = 0;
+            if (!_got_eof && _queue.eof()) {
+                // Report end of input stream once.
+                _got_eof = true;
+                tsp->verbose(u"end of merged stream");
+            }
+            return TSP_OK;
         }
-        return TSP_OK;
     }
 
+    // Replace current null packet in main stream with next packet from merged stream.
+    pkt = _window[_window_next++];
+
     // Demux sections from the merged stream.
     // This is required only to merge PSI/SI.
     if (_merge_psi) {
@@ -0,0 +1,318 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Read TS packets from UDP datagrams in a pcap or pcap-ng capture file.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsPcapFile.h"
+#include "tsIPUtils.h"
+#include "tsMonotonic.h"
+TSDUCK_SOURCE;
+
+// Maximum wait time in timed mode before checking abort.
+#define MAX_TIMED_WAIT (100 * NanoSecPerMilliSec)
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class PcapInput: public InputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        PcapInput(TSP*);
+        virtual bool getOptions() override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual BitRate getBitrate() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+        virtual bool abortInput() override;
+
+    private:
+        UString        _filename;     // Capture file name.
+        SocketAddress  _destination;  // Selected UDP destination, may be partially specified.
+        SocketAddress  _source;       // Selected UDP source, may be partially specified.
+        bool           _auto_dest;    // Use the destination of the first UDP datagram containing TS packets.
+        bool           _timed;        // Follow the capture timestamps.
+        volatile bool  _aborted;      // Abort requested.
+        PcapFile       _file;         // Capture file.
+        MicroSecond    _first_ts;     // Capture timestamp of first datagram.
+        MicroSecond    _last_ts;      // Capture timestamp of last datagram.
+        Monotonic      _start;        // System time of first datagram (timed mode).
+        PacketCounter  _packets;      // Number of returned TS packets.
+        PacketCounter  _datagrams;    // Number of UDP datagrams containing TS packets.
+        PacketCounter  _rtp_lost;     // Number of lost RTP datagrams (sequence gaps).
+        bool           _rtp_valid;    // The last RTP sequence number is valid.
+        uint16_t       _rtp_seq;      // Last RTP sequence number.
+        MicroSecond    _max_gap;      // Maximum interval between two datagrams.
+        const uint8_t* _pkt_next;     // Next TS packet in current datagram.
+        size_t         _pkt_count;    // Remaining TS packets in current datagram.
+        bool           _pkt_wait;     // Must wait for the capture time of current datagram.
+
+        // Move to the next UDP datagram containing TS packets. Return false on end of file or error.
+        bool nextDatagram();
+
+        // Inaccessible operations
+        PcapInput() = delete;
+        PcapInput(const PcapInput&) = delete;
+        PcapInput& operator=(const PcapInput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(pcap, ts::PcapInput)
+
+
+//----------------------------------------------------------------------------
+// Input constructor
+//----------------------------------------------------------------------------
+
+ts::PcapInput::PcapInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Read TS packets from UDP datagrams in a pcap or pcap-ng file", u"[options] [file-name]"),
+    _filename(),
+    _destination(),
+    _source(),
+    _auto_dest(false),
+    _timed(false),
+    _aborted(false),
+    _file(),
+    _first_ts(0),
+    _last_ts(0),
+    _start(),
+    _packets(0),
+    _datagrams(0),
+    _rtp_lost(0),
+    _rtp_valid(false),
+    _rtp_seq(0),
+    _max_gap(0),
+    _pkt_next(nullptr),
+    _pkt_count(0),
+    _pkt_wait(false)
+{
+    option(u"", 0, STRING, 0, 1);
+    help(u"",
+         u"Name of the capture file, in pcap or pcap-ng format, as produced by tcpdump "
+         u"or Wireshark. If the parameter is omitted, is an empty string or a dash (\"-\"), "
+         u"the standard input is used.");
+
+    option(u"destination", 'd', STRING);
+    help(u"destination", u"[address][:port]",
+         u"Filter the UDP datagrams based on the specified destination IP address and/or "
+         u"UDP port. By default, the destination of the first UDP datagram containing "
+         u"TS packets is used and all datagrams with another destination are ignored.");
+
+    option(u"source", 's', STRING);
+    help(u"source", u"[address][:port]",
+         u"Filter the UDP datagrams based on the specified source IP address and/or "
+         u"UDP port. By default, all sources are accepted.");
+
+    option(u"timed", 't');
+    help(u"timed",
+         u"Follow the timestamps of the capture file: the TS packets are returned at "
+         u"the same relative time as they were captured, reproducing the original network "
+         u"timing and jitter. By default, the file is read as fast as possible.");
+}
+
+
+//----------------------------------------------------------------------------
+// Input methods
+//----------------------------------------------------------------------------
+
+bool ts::PcapInput::getOptions()
+{
+    _filename = value(u"");
+    if (_filename == u"-") {
+        _filename.clear();
+    }
+    _timed = present(u"timed");
+    _auto_dest = !present(u"destination");
+    _destination.clear();
+    _source.clear();
+    return (_auto_dest || _destination.resolve(value(u"destination"), *tsp)) &&
+           (!present(u"source") || _source.resolve(value(u"source"), *tsp));
+}
+
+bool ts::PcapInput::start()
+{
+    _aborted = false;
+    _first_ts = _last_ts = _max_gap = 0;
+    _packets = _datagrams = _rtp_lost = 0;
+    _rtp_valid = false;
+    _rtp_seq = 0;
+    _pkt_next = nullptr;
+    _pkt_count = 0;
+    _pkt_wait = false;
+    if (_auto_dest) {
+        _destination.clear();
+    }
+    return _file.open(_filename, *tsp);
+}
+
+bool ts::PcapInput::stop()
+{
+    tsp->verbose(u"%'d TS packets in %'d UDP datagrams, %'d captured frames, %'d lost RTP datagrams, max interval between datagrams: %'d us",
+                 {_packets, _datagrams, _file.frameCount(), _rtp_lost, _max_gap});
+    _file.close();
+    return true;
+}
+
+bool ts::PcapInput::abortInput()
+{
+    _aborted = true;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// The bitrate is computed from the capture timestamps, not the reading time.
+//----------------------------------------------------------------------------
+
+ts::BitRate ts::PcapInput::getBitrate()
+{
+    const MicroSecond duration = _last_ts - _first_ts;
+    return duration <= 0 ? 0 : BitRate((_packets * PKT_SIZE * 8 * MicroSecPerSec) / duration);
+}
+
+
+//----------------------------------------------------------------------------
+// Move to the next UDP datagram containing TS packets.
+//----------------------------------------------------------------------------
+
+bool ts::PcapInput::nextDatagram()
+{
+    SocketAddress source;
+    SocketAddress destination;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    MicroSecond timestamp = 0;
+
+    while (!_aborted && _file.readUDP(source, destination, data, size, timestamp, *tsp)) {
+
+        // Filter the datagrams.
+        if (!_source.match(source) || !_destination.match(destination)) {
+            continue;
+        }
+
+        // Locate the TS packets, with or without RTP header.
+        size_t rtp_offset = 0;
+        size_t rtp_size = 0;
+        uint16_t sequence = 0;
+        const bool rtp = GetRTPPayload(data, size, rtp_offset, rtp_size, sequence) && rtp_size > 0 && rtp_size % PKT_SIZE == 0 && data[rtp_offset] == SYNC_BYTE;
+        size_t start = 0;
+        size_t count = 0;
+        if (rtp) {
+            start = rtp_offset;
+            count = rtp_size / PKT_SIZE;
+        }
+        else if (!LocateTSPackets(data, size, start, count)) {
+            continue;
+        }
+
+        // Select the first destination when unspecified.
+        if (_auto_dest && !_destination.hasAddress()) {
+            _destination = destination;
+            tsp->verbose(u"using UDP destination %s", {_destination});
+        }
+
+        // Count lost RTP datagrams.
+        if (rtp) {
+            if (_rtp_valid && sequence != uint16_t(_rtp_seq + 1)) {
+                _rtp_lost += uint16_t(sequence - _rtp_seq - 1);
+            }
+            _rtp_valid = true;
+            _rtp_seq = sequence;
+        }
+
+        // Timing of the datagram.
+        if (_datagrams++ == 0) {
+            _first_ts = timestamp;
+            _start.getSystemTime();
+        }
+        else {
+            _max_gap = std::max(_max_gap, timestamp - _last_ts);
+        }
+        _last_ts = timestamp;
+
+        _pkt_next = data + start;
+        _pkt_count = count;
+        _pkt_wait = _timed;
+        return true;
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Input method
+//----------------------------------------------------------------------------
+
+size_t ts::PcapInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    size_t count = 0;
+
+    while (count < max_packets && !_aborted) {
+
+        // Get the next datagram when the current one is exhausted.
+        if (_pkt_count == 0 && !nextDatagram()) {
+            break;
+        }
+
+        // In timed mode, wait for the capture time of the datagram. Return immediately
+        // what we already have when the datagram is not yet due.
+        if (_pkt_wait) {
+            Monotonic due(_start);
+            due += (_last_ts - _first_ts) * NanoSecPerMicroSec;
+            if (count > 0 && Monotonic(true) < due) {
+                break;
+            }
+            for (Monotonic now(true); !_aborted && now < due; now.getSystemTime()) {
+                Monotonic until(now);
+                until += std::min<NanoSecond>(due - now, MAX_TIMED_WAIT);
+                until.wait();
+            }
+            _pkt_wait = false;
+        }
+
+        // Return packets from the current datagram.
+        const size_t n = std::min(_pkt_count, max_packets - count);
+        TSPacket::Copy(buffer + count, _pkt_next, n);
+        _pkt_next += n * PKT_SIZE;
+        _pkt_count -= n;
+        count += n;
+    }
+
+    _packets += count;
+    return count;
+}
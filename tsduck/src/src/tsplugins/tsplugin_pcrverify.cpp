@@ -34,6 +34,8 @@
 
 #include "tsPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsPCRAnalyzer.h"
+#include "tsMonotonic.h"
 #include "tsTime.h"
 TSDUCK_SOURCE;
 
@@ -78,6 +80,19 @@ namespace ts {
         PacketCounter _nb_pcr_nok;       // Number of PCR with jitter
         PacketCounter _nb_pcr_unchecked; // Number of unchecked PCR (no previous ref)
         PIDContext    _stats[PID_MAX];   // Per-PID statistics
+        bool          _statistics;       // Report PCR histograms
+        bool          _json;             // Report PCR histograms in JSON format
+        bool          _realtime;         // Real-time input, the arrival times are meaningful for PCR jitter
+        NanoSecond    _interval;         // Interval between periodic reports (0 means none)
+        UString       _output_name;      // Output file name for PCR histograms (empty means stdout)
+        std::ofstream _output_stream;    // Output stream file
+        std::ostream* _output;           // Reference to actual output stream file
+        PCRAnalyzer   _analyzer;         // Collect PCR histograms
+        Monotonic     _start_time;       // Reference for packet arrival times
+        NanoSecond    _next_report;      // Arrival time of next periodic report
+
+        // Report PCR histograms.
+        void reportStatistics(bool period);
 
         // PCR units per micro-second
         static const int64_t PCR_PER_MICRO_SEC = int64_t (SYSTEM_CLOCK_FREQ) / MicroSecPerSec;
@@ -116,7 +131,17 @@ ts::PCRVerifyPlugin::PCRVerifyPlugin(TSP* tsp_) :
     _nb_pcr_ok(0),
     _nb_pcr_nok(0),
     _nb_pcr_unchecked(0),
-    _stats()
+    _stats(),
+    _statistics(false),
+    _json(false),
+    _realtime(false),
+    _interval(0),
+    _output_name(),
+    _output_stream(),
+    _output(nullptr),
+    _analyzer(),
+    _start_time(),
+    _next_report(0)
 {
     option(u"absolute", 'a');
     help(u"absolute",
@@ -128,6 +153,12 @@ ts::PCRVerifyPlugin::PCRVerifyPlugin(TSP* tsp_) :
          u"Verify the PCR's according to this transport bitrate. By default, "
          u"use the input bitrate as reported by the input device.");
 
+    option(u"interval", 'i', POSITIVE);
+    help(u"interval", u"seconds",
+         u"With --statistics, produce a report of the PCR histograms at regular intervals. "
+         u"Each periodic report contains the measurements from the last interval only. "
+         u"The final report at end of stream contains all measurements.");
+
     option(u"jitter-max", 'j', UNSIGNED);
     help(u"jitter-max",
          u"Maximum allowed jitter. PCR's with a higher jitter are reported, others "
@@ -136,12 +167,34 @@ ts::PCRVerifyPlugin::PCRVerifyPlugin(TSP* tsp_) :
          UString::Decimal(DEFAULT_JITTER_MAX) + u" PCR units or " +
          UString::Decimal(DEFAULT_JITTER_MAX_US) + u" micro-seconds.");
 
+    option(u"json");
+    help(u"json",
+         u"With --statistics, produce the PCR histograms in JSON format. "
+         u"Periodic reports (see --interval) are produced as one JSON line each.");
+
+    option(u"output-file", 'o', STRING);
+    help(u"output-file", u"filename",
+         u"With --statistics, store the PCR histograms in the specified file. "
+         u"By default, the report is written on standard output.");
+
     option(u"pid", 'p', PIDVAL, 0, UNLIMITED_COUNT);
     help(u"pid",
          u"PID filter: select packets with this PID value. "
          u"Several -p or --pid options may be specified. "
          u"Without -p or --pid option, PCR's from all PID's are used.");
 
+    option(u"statistics", 's');
+    help(u"statistics",
+         u"Collect histograms of PCR intervals, PCR accuracy and PCR jitter for each PID "
+         u"and report them at end of stream. The PCR accuracy is the difference between "
+         u"the PCR interval and the interval which is expected from the average transport "
+         u"bitrate. The PCR jitter is the difference between the PCR interval and the "
+         u"interval between the arrival times of the two packets in tsp. The PCR jitter "
+         u"is measured only with real-time input (see tsp option --realtime). With "
+         u"files or other non real-time inputs, the arrival times in tsp only reflect "
+         u"the processing speed and the PCR jitter is not reported. "
+         u"All values are reported in nano-seconds.");
+
     option(u"time-stamp", 't');
     help(u"time-stamp", u"Display time of each event.");
 }
@@ -158,6 +211,10 @@ bool ts::PCRVerifyPlugin::start()
     _bitrate = intValue<BitRate>(u"bitrate", 0);
     _time_stamp = present(u"time-stamp");
     getIntValues(_pid_list, u"pid", true);
+    _statistics = present(u"statistics");
+    _json = present(u"json");
+    _interval = intValue<NanoSecond>(u"interval", 0) * NanoSecPerSec;
+    _output_name = value(u"output-file");
 
     if (!_absolute) {
         // Convert _jitter_max from micro-second to PCR units
@@ -175,6 +232,29 @@ bool ts::PCRVerifyPlugin::start()
         _stats[i].last_pcr_packet = 0;
     }
 
+    // Initialize PCR histograms.
+    if (_statistics) {
+        _analyzer.reset();
+        _analyzer.setStatistics(true);
+        _realtime = tsp->realtime();
+        if (!_realtime) {
+            tsp->verbose(u"input is not real-time, PCR jitter is not measured");
+        }
+        _start_time.getSystemTime();
+        _next_report = _interval;
+        if (_output_name.empty()) {
+            _output = &std::cout;
+        }
+        else {
+            _output = &_output_stream;
+            _output_stream.open(_output_name.toUTF8().c_str());
+            if (!_output_stream) {
+                tsp->error(u"cannot create file %s", {_output_name});
+                return false;
+            }
+        }
+    }
+
     return true;
 }
 
@@ -189,10 +269,37 @@ bool ts::PCRVerifyPlugin::stop()
     tsp->info(u"%'d PCR OK, %'d with jitter > %'d (%'d micro-seconds), %'d unchecked",
               {_nb_pcr_ok, _nb_pcr_nok, _jitter_max, _jitter_max / PCR_PER_MICRO_SEC, _nb_pcr_unchecked});
 
+    // Display PCR histograms.
+    if (_statistics) {
+        reportStatistics(false);
+        if (!_output_name.empty()) {
+            _output_stream.close();
+        }
+    }
+
     return true;
 }
 
 
+//----------------------------------------------------------------------------
+// Report PCR histograms.
+//----------------------------------------------------------------------------
+
+void ts::PCRVerifyPlugin::reportStatistics(bool period)
+{
+    if (_json) {
+        json::ValuePtr pids(_analyzer.jsonStatistics(period, _pid_list));
+        *_output << (period ? pids->oneLiner(*tsp) : pids->printed(2, *tsp)) << std::endl;
+    }
+    else {
+        *_output << "* " << (period ? "Periodic" : "Final") << " PCR statistics, "
+                 << Time::CurrentLocalTime().format(Time::DATE | Time::TIME)
+                 << (_realtime ? "" : ", PCR jitter not measured on non real-time input") << std::endl;
+        _analyzer.reportStatistics(*_output, period, _pid_list, u"  ");
+    }
+}
+
+
 
 
 //----------------------------------------------------------------------------
@@ -238,6 +345,18 @@ ts::ProcessorPlugin::Status ts::PCRVerifyPlugin::processPacket(TSPacket& pkt, bo
 {
     const size_t pid = pkt.getPID();
 
+    // Collect PCR histograms, using the arrival time of the packet in this plugin.
+    if (_statistics) {
+        Monotonic now(true);
+        const NanoSecond arrival = now - _start_time;
+        _analyzer.feedPacket(pkt, _realtime ? arrival : -1);
+        if (_interval > 0 && arrival >= _next_report) {
+            reportStatistics(true);
+            _analyzer.restartPeriod();
+            _next_report = arrival - arrival % _interval + _interval;
+        }
+    }
+
     // Check if this PID shall be filtered and packet has a PCR
     if (_pid_list[pid] && pkt.hasPCR()) {
 
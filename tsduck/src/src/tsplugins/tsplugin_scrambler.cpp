@@ -44,6 +44,8 @@
 #include "tsBetterSystemRandomGenerator.h"
 #include "tsCADescriptor.h"
 #include "tsScramblingDescriptor.h"
+#include "tsMonotonic.h"
+#include <atomic>
 TSDUCK_SOURCE;
 
 #define DEFAULT_ECM_BITRATE 30000
@@ -104,6 +106,7 @@ namespace ts {
         virtual bool start() override;
         virtual bool stop() override;
         virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual void getMetrics(MetricsWriter&) override;
 
     private:
         // Description of a crypto-period.
@@ -135,13 +138,14 @@ namespace ts {
             bool initScramblerKey() const;
 
         private:
-            ScramblerPlugin* _plugin;         // Reference to scrambler plugin
-            uint16_t         _cp_number;      // Crypto-period number
-            volatile bool    _ecm_ok;         // _ecm field is valid
-            TSPacketVector   _ecm;            // Packetized ECM
-            size_t           _ecm_pkt_index;  // Next ECM packet to insert in TS
-            ByteBlock        _cw_current;
-            ByteBlock        _cw_next;
+            ScramblerPlugin*        _plugin;         // Reference to scrambler plugin
+            uint16_t                _cp_number;      // Crypto-period number
+            volatile bool           _ecm_ok;         // _ecm field is valid
+            TSPacketVector          _ecm;            // Packetized ECM
+            size_t                  _ecm_pkt_index;  // Next ECM packet to insert in TS
+            std::atomic<NanoSecond> _ecm_request;    // Time of ECM request to the ECMG, relative to _ecm_origin
+            ByteBlock               _cw_current;
+            ByteBlock               _cw_next;
 
             // Generate the ECM for a crypto-period.
             // With --synchronous, the ECM is directly generated. Otherwise,
@@ -199,6 +203,13 @@ namespace ts {
         TSScrambling      _scrambling;          // Scrambler
         CyclingPacketizer _pzer_pmt;            // Packetizer for modified PMT
 
+        // ECMG statistics, updated by the thread which receives the ECM's, read by the metrics server.
+        Monotonic               _ecm_origin;        // Time origin of ECM requests, set before connecting to the ECMG.
+        std::atomic<uint64_t>   _ecm_responses;     // Number of ECM responses from the ECMG.
+        std::atomic<NanoSecond> _ecm_latency_last;  // Latency of last ECM response.
+        std::atomic<NanoSecond> _ecm_latency_max;   // Maximum latency of ECM responses.
+        std::atomic<NanoSecond> _ecm_latency_sum;   // Sum of latencies of all ECM responses.
+
         // Return current/next CryptoPeriod for CW or ECM
         CryptoPeriod& currentCW()  { return _cp[_current_cw]; }
         CryptoPeriod& nextCW()     { return _cp[(_current_cw + 1) & 0x01]; }
@@ -273,7 +284,12 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
     _current_cw(0),
     _current_ecm(0),
     _scrambling(*tsp),
-    _pzer_pmt()
+    _pzer_pmt(),
+    _ecm_origin(),
+    _ecm_responses(0),
+    _ecm_latency_last(0),
+    _ecm_latency_max(0),
+    _ecm_latency_sum(0)
 {
     option(u"", 0, STRING, 0, 1);
     help(u"",
@@ -433,6 +449,7 @@ bool ts::ScramblerPlugin::start()
     _partial_clear = 0;
     _update_pmt = false;
     _delay_start = 0;
+    _ecm_origin.getSystemTime();
 
     // Initialize ECMG.
     if (_need_ecm) {
@@ -502,6 +519,20 @@ bool ts::ScramblerPlugin::stop()
 }
 
 
+//----------------------------------------------------------------------------
+// Plugin-specific metrics, invoked from the metrics server thread.
+//----------------------------------------------------------------------------
+
+void ts::ScramblerPlugin::getMetrics(MetricsWriter& writer)
+{
+    const double ns = double(NanoSecPerSec);
+    writer.counter(u"ecmg_responses_total", u"Number of ECM responses from the ECMG.", _ecm_responses.load());
+    writer.counter(u"ecmg_latency_seconds_total", u"Cumulated latency of all ECM responses from the ECMG.", double(_ecm_latency_sum.load()) / ns);
+    writer.gauge(u"ecmg_latency_seconds", u"Latency of the last ECM response from the ECMG.", double(_ecm_latency_last.load()) / ns);
+    writer.gauge(u"ecmg_latency_max_seconds", u"Maximum latency of ECM responses from the ECMG.", double(_ecm_latency_max.load()) / ns);
+}
+
+
 //----------------------------------------------------------------------------
 //  This method processes the PMT of the service.
 //----------------------------------------------------------------------------
@@ -850,6 +881,7 @@ ts::ScramblerPlugin::CryptoPeriod::CryptoPeriod() :
     _ecm_ok(false),
     _ecm(),
     _ecm_pkt_index(0),
+    _ecm_request(0),
     _cw_current(),
     _cw_next()
 {
@@ -910,6 +942,7 @@ bool ts::ScramblerPlugin::CryptoPeriod::initScramblerKey() const
 void ts::ScramblerPlugin::CryptoPeriod::generateECM()
 {
     _ecm_ok = false;
+    _ecm_request = Monotonic(true) - _plugin->_ecm_origin;
 
     if (_plugin->_synchronous_ecmg) {
         // Synchronous ECM generation
@@ -948,6 +981,15 @@ void ts::ScramblerPlugin::CryptoPeriod::generateECM()
 
 void ts::ScramblerPlugin::CryptoPeriod::handleECM(const ecmgscs::ECMResponse& response)
 {
+    // Update ECMG statistics. The ECM responses are received by one single thread.
+    // The request time is atomic since it is set by the plugin thread.
+    const NanoSecond latency = (Monotonic(true) - _plugin->_ecm_origin) - _ecm_request;
+    _plugin->_ecm_latency_last = latency;
+    _plugin->_ecm_latency_sum += latency;
+    if (latency > _plugin->_ecm_latency_max) {
+        _plugin->_ecm_latency_max = latency;
+    }
+    _plugin->_ecm_responses++;
     if (_plugin->_channel_status.section_TSpkt_flag == 0) {
         // ECMG returns ECM in section format
         SectionPtr sp(new Section(response.ECM_datagram));
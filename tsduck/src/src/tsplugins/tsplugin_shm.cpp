@@ -0,0 +1,261 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Shared memory ring input / output
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsSharedMemoryRing.h"
+#include "tsSysUtils.h"
+#include "tsNullReport.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+
+    // Input plugin
+    class ShmInput: public InputPlugin, private AbortInterface
+    {
+    public:
+        // Implementation of plugin API
+        ShmInput(TSP*);
+        virtual bool getOptions() override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual BitRate getBitrate() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+        virtual bool abortInput() override;
+
+    private:
+        UString          _name;     // Ring name.
+        MilliSecond      _wait;     // Max time to wait for the ring creation.
+        SharedMemoryRing _ring;     // The shared memory ring.
+        volatile bool    _aborted;  // Abort requested.
+
+        // Implementation of AbortInterface.
+        virtual bool aborting() const override;
+
+        // Inaccessible operations
+        ShmInput() = delete;
+        ShmInput(const ShmInput&) = delete;
+        ShmInput& operator=(const ShmInput&) = delete;
+    };
+
+    // Output plugin
+    class ShmOutput: public OutputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        ShmOutput(TSP*);
+        virtual bool getOptions() override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool send(const TSPacket*, size_t) override;
+
+    private:
+        UString          _name;         // Ring name.
+        size_t           _size;         // Ring size in packets.
+        size_t           _max_readers;  // Max number of readers.
+        size_t           _wait_readers; // Number of readers to wait for before first packet.
+        bool             _started;      // Packets already sent.
+        SharedMemoryRing _ring;         // The shared memory ring.
+
+        // Inaccessible operations
+        ShmOutput() = delete;
+        ShmOutput(const ShmOutput&) = delete;
+        ShmOutput& operator=(const ShmOutput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(shm, ts::ShmInput)
+TSPLUGIN_DECLARE_OUTPUT(shm, ts::ShmOutput)
+
+
+//----------------------------------------------------------------------------
+// Input constructor
+//----------------------------------------------------------------------------
+
+ts::ShmInput::ShmInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Receive TS packets from a shared memory ring", u"[options] name"),
+    _name(),
+    _wait(0),
+    _ring(),
+    _aborted(false)
+{
+    option(u"", 0, STRING, 1, 1);
+    help(u"",
+         u"Name of the shared memory ring. The ring is created by another tsp process "
+         u"using the output plugin shm with the same name. Several tsp processes can "
+         u"simultaneously receive the packets from the same ring. Each of them receives "
+         u"all packets which are written after it attached to the ring.");
+
+    option(u"wait-creation", 'w', UNSIGNED);
+    help(u"wait-creation",
+         u"Maximum number of milliseconds to wait for the creation of the ring by the "
+         u"writer process. The default is 5000 ms.");
+}
+
+
+//----------------------------------------------------------------------------
+// Output constructor
+//----------------------------------------------------------------------------
+
+ts::ShmOutput::ShmOutput(TSP* tsp_) :
+    OutputPlugin(tsp_, u"Send TS packets to a shared memory ring", u"[options] name"),
+    _name(),
+    _size(0),
+    _max_readers(0),
+    _wait_readers(0),
+    _started(false),
+    _ring()
+{
+    option(u"", 0, STRING, 1, 1);
+    help(u"",
+         u"Name of the shared memory ring. The ring is created by this plugin and is "
+         u"deleted at the end of the processing. The packets are received by other tsp "
+         u"processes using the input plugin shm with the same name.");
+
+    option(u"max-readers", 'm', POSITIVE);
+    help(u"max-readers",
+         u"Maximum number of simultaneous readers of the ring. The default is " +
+         UString::Decimal(SharedMemoryRing::DEFAULT_MAX_READERS) + u".");
+
+    option(u"packets", 'p', POSITIVE);
+    help(u"packets",
+         u"Size of the ring in TS packets. The default is " +
+         UString::Decimal(SharedMemoryRing::DEFAULT_SIZE) + u" packets.");
+
+    option(u"wait-readers", 'w', UNSIGNED);
+    help(u"wait-readers",
+         u"Number of readers to wait for before sending the first packets. When the ring "
+         u"is full, the output is blocked until all readers have read the oldest packets. "
+         u"When there is no reader, the packets are lost. The default is 1.");
+}
+
+
+//----------------------------------------------------------------------------
+// Input methods
+//----------------------------------------------------------------------------
+
+bool ts::ShmInput::getOptions()
+{
+    _name = value(u"");
+    _wait = intValue<MilliSecond>(u"wait-creation", 5000);
+    return true;
+}
+
+bool ts::ShmInput::start()
+{
+    // The ring may not yet exist if the writer process is started at the same time.
+    _aborted = false;
+    for (MilliSecond waited = 0; !_ring.open(_name, waited < _wait ? static_cast<Report&>(NULLREP) : *tsp); waited += 100) {
+        if (waited >= _wait || aborting()) {
+            return false;
+        }
+        SleepThread(100);
+    }
+    return true;
+}
+
+bool ts::ShmInput::stop()
+{
+    _ring.close(*tsp);
+    return true;
+}
+
+bool ts::ShmInput::abortInput()
+{
+    _aborted = true;
+    return true;
+}
+
+bool ts::ShmInput::aborting() const
+{
+    return _aborted || tsp->aborting();
+}
+
+ts::BitRate ts::ShmInput::getBitrate()
+{
+    return _ring.bitrate();
+}
+
+size_t ts::ShmInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    return _ring.read(buffer, max_packets, *tsp, this);
+}
+
+
+//----------------------------------------------------------------------------
+// Output methods
+//----------------------------------------------------------------------------
+
+bool ts::ShmOutput::getOptions()
+{
+    _name = value(u"");
+    _size = intValue<size_t>(u"packets", SharedMemoryRing::DEFAULT_SIZE);
+    _max_readers = intValue<size_t>(u"max-readers", SharedMemoryRing::DEFAULT_MAX_READERS);
+    _wait_readers = intValue<size_t>(u"wait-readers", 1);
+    if (_wait_readers > _max_readers) {
+        tsp->error(u"--wait-readers cannot be greater than --max-readers");
+        return false;
+    }
+    return true;
+}
+
+bool ts::ShmOutput::start()
+{
+    _started = false;
+    return _ring.create(_name, _size, _max_readers, *tsp);
+}
+
+bool ts::ShmOutput::stop()
+{
+    return _ring.close(*tsp);
+}
+
+bool ts::ShmOutput::send(const TSPacket* buffer, size_t packet_count)
+{
+    // Wait for the first readers before sending the first packets.
+    if (!_started) {
+        tsp->verbose(u"waiting for %d readers on shared memory ring %s", {_wait_readers, _name});
+        if (!_ring.waitReaders(_wait_readers, *tsp, tsp)) {
+            return false;
+        }
+        _started = true;
+    }
+    return _ring.write(buffer, packet_count, tsp->bitrate(), *tsp, tsp);
+}
@@ -0,0 +1,568 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  TCP input / output
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsTCPConnection.h"
+#include "tsTCPServer.h"
+#include "tsSysUtils.h"
+#include "tsMonotonic.h"
+#include "tsNullReport.h"
+TSDUCK_SOURCE;
+
+#define DEF_BUFFER_SIZE     (4 * 1024 * 1024)  // Default socket buffer size
+#define DEF_RECONNECT_DELAY 1000               // Default delay between client connection attempts, in milliseconds
+#define STALL_THRESHOLD     10000000           // 10 ms, a socket operation which blocks longer is a stall
+
+
+//----------------------------------------------------------------------------
+// TCP session, common to the input and output plugins.
+//----------------------------------------------------------------------------
+
+namespace {
+    class TCPSession
+    {
+    public:
+        // Constructor.
+        TCPSession(ts::TSP* tsp, const ts::UChar* role);
+
+        // Define and load the common command line options.
+        static void DefineOptions(ts::Args& args);
+        bool loadOptions(ts::Args& args);
+
+        // Socket tuning for the output plugin.
+        void setOutputTuning(bool no_delay, bool cork);
+
+        // Start and stop the session (start listening in server mode).
+        bool start();
+        void stop();
+
+        // Establish a connection: connect to the server or wait for a client.
+        // In reconnect mode, retry until success or abort.
+        bool connect();
+
+        // Close the current connection. In reconnect mode, return true if a new one may be tried.
+        bool disconnect();
+
+        // Abort any blocking operation from another thread.
+        void abort();
+
+        // Send or receive data on the current connection, account throughput and stalls.
+        bool send(const void* data, size_t size);
+        bool receive(void* data, size_t max_size, size_t& ret_size);
+
+        // Connection state.
+        bool isConnected() const { return _conn.isConnected(); }
+        bool aborted() const { return _aborted || _tsp->aborting(); }
+
+        // Report statistics.
+        void reportStatistics();
+
+    private:
+        ts::TSP*          _tsp;
+        const ts::UChar*  _role;
+        bool              _listen;           // Server mode.
+        bool              _reconnect;        // Reconnect on disconnection.
+        ts::MilliSecond   _reconnect_delay;  // Delay between client connection attempts.
+        size_t            _buffer_size;      // Socket buffer size.
+        bool              _no_delay;         // Set TCP_NODELAY.
+        bool              _cork;             // Set TCP_CORK.
+        ts::SocketAddress _address;          // Server address.
+        ts::TCPServer     _server;           // Listening socket in server mode.
+        ts::TCPConnection _conn;             // Current connection.
+        volatile bool     _aborted;          // Abort requested.
+        ts::Monotonic     _start;            // Time of first connection.
+        bool              _started;          // _start is valid.
+        uint64_t          _bytes;            // Transferred bytes.
+        size_t            _connections;      // Number of successful connections.
+        uint64_t          _stalls;           // Number of blocking operations longer than the threshold.
+        ts::NanoSecond    _stall_time;       // Cumulated duration of stalls.
+
+        // Where to report errors, unless they are expected.
+        ts::Report& report(bool quiet) { return quiet ? static_cast<ts::Report&>(NULLREP) : *_tsp; }
+
+        // Wait between connection attempts, return false on abort.
+        bool waitRetry();
+
+        // Account a transfer.
+        void account(size_t size, const ts::Monotonic& start);
+
+        // Inaccessible operations.
+        TCPSession(const TCPSession&) = delete;
+        TCPSession& operator=(const TCPSession&) = delete;
+    };
+}
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+
+    // Input plugin
+    class TCPInput: public InputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        TCPInput(TSP*);
+        virtual bool getOptions() override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual size_t receive(TSPacket*, size_t) override;
+        virtual bool abortInput() override;
+    private:
+        TCPSession _session;
+        TSPacket   _partial;       // Partial packet at end of last receive.
+        size_t     _partial_size;  // Size in bytes of _partial.
+
+        // Inaccessible operations
+        TCPInput() = delete;
+        TCPInput(const TCPInput&) = delete;
+        TCPInput& operator=(const TCPInput&) = delete;
+    };
+
+    // Output plugin
+    class TCPOutput: public OutputPlugin
+    {
+    public:
+        // Implementation of plugin API
+        TCPOutput(TSP*);
+        virtual bool getOptions() override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool send(const TSPacket*, size_t) override;
+    private:
+        TCPSession _session;
+
+        // Inaccessible operations
+        TCPOutput() = delete;
+        TCPOutput(const TCPOutput&) = delete;
+        TCPOutput& operator=(const TCPOutput&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_INPUT(tcp, ts::TCPInput)
+TSPLUGIN_DECLARE_OUTPUT(tcp, ts::TCPOutput)
+
+
+//----------------------------------------------------------------------------
+// TCP session: options.
+//----------------------------------------------------------------------------
+
+TCPSession::TCPSession(ts::TSP* tsp, const ts::UChar* role) :
+    _tsp(tsp),
+    _role(role),
+    _listen(false),
+    _reconnect(false),
+    _reconnect_delay(DEF_RECONNECT_DELAY),
+    _buffer_size(DEF_BUFFER_SIZE),
+    _no_delay(false),
+    _cork(false),
+    _address(),
+    _server(),
+    _conn(),
+    _aborted(false),
+    _start(),
+    _started(false),
+    _bytes(0),
+    _connections(0),
+    _stalls(0),
+    _stall_time(0)
+{
+}
+
+void TCPSession::DefineOptions(ts::Args& args)
+{
+    args.option(u"", 0, ts::Args::STRING, 1, 1);
+    args.help(u"",
+              u"The parameter [address:]port describes the TCP server. In client mode (the default), "
+              u"the address is mandatory and the plugin connects to this server. With --listen, the "
+              u"plugin is the server and waits for a client on this port. The optional address then "
+              u"selects a local interface.");
+
+    args.option(u"buffer-size", 'b', ts::Args::POSITIVE);
+    args.help(u"buffer-size",
+              u"Size in bytes of the socket send and receive buffers. Large buffers absorb the "
+              u"variations of the network throughput. The default is " + ts::UString::Decimal(DEF_BUFFER_SIZE) + u" bytes.");
+
+    args.option(u"listen", 'l');
+    args.help(u"listen", u"Act as TCP server and wait for a client connection. By default, act as TCP client.");
+
+    args.option(u"reconnect", 'r');
+    args.help(u"reconnect",
+              u"When the connection is lost, reconnect to the server in client mode or wait for "
+              u"a new client with --listen. By default, the plugin terminates on disconnection.");
+
+    args.option(u"reconnect-delay", 0, ts::Args::POSITIVE);
+    args.help(u"reconnect-delay",
+              u"In client mode with --reconnect, delay in milliseconds between two connection attempts. "
+              u"The default is " TS_STRINGIFY(DEF_RECONNECT_DELAY) u" ms.");
+}
+
+bool TCPSession::loadOptions(ts::Args& args)
+{
+    _listen = args.present(u"listen");
+    _reconnect = args.present(u"reconnect");
+    _reconnect_delay = args.intValue<ts::MilliSecond>(u"reconnect-delay", DEF_RECONNECT_DELAY);
+    _buffer_size = args.intValue<size_t>(u"buffer-size", DEF_BUFFER_SIZE);
+
+    if (!_address.resolve(args.value(u""), *_tsp)) {
+        return false;
+    }
+    if (!_address.hasPort()) {
+        _tsp->error(u"no port specified in %s", {args.value(u"")});
+        return false;
+    }
+    if (!_listen && !_address.hasAddress()) {
+        _tsp->error(u"no server address specified in %s", {args.value(u"")});
+        return false;
+    }
+    return true;
+}
+
+void TCPSession::setOutputTuning(bool no_delay, bool cork)
+{
+    _no_delay = no_delay;
+    _cork = cork;
+}
+
+
+//----------------------------------------------------------------------------
+// TCP session: connection management.
+//----------------------------------------------------------------------------
+
+bool TCPSession::start()
+{
+    _aborted = false;
+    _started = false;
+    _bytes = 0;
+    _connections = 0;
+    _stalls = 0;
+    _stall_time = 0;
+
+    // In server mode, start listening. The client is accepted on first I/O.
+    if (_listen) {
+        if (!_server.open(*_tsp)) {
+            return false;
+        }
+        // The buffer sizes are inherited by the accepted connections.
+        if (!_server.reusePort(true, *_tsp) ||
+            !_server.setSendBufferSize(_buffer_size, *_tsp) ||
+            !_server.setReceiveBufferSize(_buffer_size, *_tsp) ||
+            !_server.bind(_address, *_tsp) ||
+            !_server.listen(1, *_tsp))
+        {
+            _server.close(NULLREP);
+            return false;
+        }
+    }
+    return true;
+}
+
+void TCPSession::stop()
+{
+    _conn.disconnect(NULLREP);
+    _conn.close(NULLREP);
+    if (_server.isOpen()) {
+        _server.close(NULLREP);
+    }
+}
+
+void TCPSession::abort()
+{
+    _aborted = true;
+    _conn.close(NULLREP);
+    if (_server.isOpen()) {
+        _server.close(NULLREP);
+    }
+}
+
+bool TCPSession::waitRetry()
+{
+    for (ts::MilliSecond remain = _reconnect_delay; remain > 0 && !aborted(); remain -= 100) {
+        ts::SleepThread(std::min<ts::MilliSecond>(remain, 100));
+    }
+    return !aborted();
+}
+
+bool TCPSession::connect()
+{
+    while (!aborted()) {
+        bool ok = false;
+        if (_listen) {
+            // Wait for a client. The server socket is closed on abort.
+            ts::SocketAddress client;
+            _tsp->verbose(u"waiting for a client on %s", {_address});
+            ok = _server.accept(_conn, client, report(aborted()));
+            if (ok) {
+                _tsp->verbose(u"%s connected", {client});
+            }
+        }
+        else {
+            ok = _conn.open(*_tsp) &&
+                _conn.setSendBufferSize(_buffer_size, *_tsp) &&
+                _conn.setReceiveBufferSize(_buffer_size, *_tsp) &&
+                _conn.connect(_address, report(_reconnect));
+            if (ok) {
+                _tsp->verbose(u"connected to %s", {_address});
+            }
+            else if (_reconnect) {
+                _tsp->debug(u"cannot connect to %s, retrying", {_address});
+            }
+        }
+
+        // Output tuning.
+        ok = ok && (!_no_delay || _conn.setNoDelay(true, *_tsp)) && (!_cork || _conn.setCork(true, *_tsp));
+
+        if (ok) {
+            if (!_started) {
+                _start.getSystemTime();
+                _started = true;
+            }
+            _connections++;
+            return true;
+        }
+        _conn.close(NULLREP);
+        if (aborted() || !_reconnect || (!_listen && !waitRetry())) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool TCPSession::disconnect()
+{
+    _conn.disconnect(NULLREP);
+    _conn.close(NULLREP);
+    if (aborted()) {
+        return false;
+    }
+    else if (_reconnect) {
+        _tsp->verbose(u"connection closed, reconnecting");
+        return true;
+    }
+    else {
+        _tsp->verbose(u"connection closed");
+        return false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// TCP session: data transfer.
+//----------------------------------------------------------------------------
+
+void TCPSession::account(size_t size, const ts::Monotonic& start)
+{
+    const ts::NanoSecond duration = ts::Monotonic(true) - start;
+    if (duration >= STALL_THRESHOLD) {
+        _stalls++;
+        _stall_time += duration;
+    }
+    _bytes += size;
+}
+
+bool TCPSession::send(const void* data, size_t size)
+{
+    // The complete packet window is sent in one system call.
+    const ts::Monotonic start(true);
+    const bool ok = _conn.send(data, size, report(aborted()));
+    account(ok ? size : 0, start);
+    return ok;
+}
+
+bool TCPSession::receive(void* data, size_t max_size, size_t& ret_size)
+{
+    const ts::Monotonic start(true);
+    const bool ok = _conn.receive(data, max_size, ret_size, _tsp, report(aborted()));
+    account(ok ? ret_size : 0, start);
+    return ok;
+}
+
+void TCPSession::reportStatistics()
+{
+    if (_started) {
+        const ts::NanoSecond duration = ts::Monotonic(true) - _start;
+        const uint64_t bitrate = duration <= 0 ? 0 : uint64_t((8 * _bytes * ts::NanoSecPerSec) / uint64_t(duration));
+        _tsp->verbose(u"%s %'d bytes in %'d connections, average %'d b/s", {_role, _bytes, _connections, bitrate});
+        _tsp->verbose(u"%'d stalls of more than %d ms, total stall time: %'d ms", {_stalls, STALL_THRESHOLD / ts::NanoSecPerMilliSec, _stall_time / ts::NanoSecPerMilliSec});
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Input plugin
+//----------------------------------------------------------------------------
+
+ts::TCPInput::TCPInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Receive TS packets from a TCP connection", u"[options] [address:]port"),
+    _session(tsp, u"received"),
+    _partial(),
+    _partial_size(0)
+{
+    TCPSession::DefineOptions(*this);
+}
+
+bool ts::TCPInput::getOptions()
+{
+    return _session.loadOptions(*this);
+}
+
+bool ts::TCPInput::start()
+{
+    _partial_size = 0;
+    return _session.start();
+}
+
+bool ts::TCPInput::stop()
+{
+    _session.stop();
+    _session.reportStatistics();
+    return true;
+}
+
+bool ts::TCPInput::abortInput()
+{
+    _session.abort();
+    return true;
+}
+
+size_t ts::TCPInput::receive(TSPacket* buffer, size_t max_packets)
+{
+    uint8_t* const data = buffer->b;
+    const size_t max_size = max_packets * PKT_SIZE;
+
+    for (;;) {
+        if (!_session.isConnected()) {
+            _partial_size = 0;
+            if (!_session.connect()) {
+                return 0;
+            }
+        }
+
+        // Restore the partial packet from the previous call, receive at least one complete packet.
+        size_t size = _partial_size;
+        ::memcpy(data, _partial.b, size);
+        bool ok = true;
+        while (ok && size < PKT_SIZE) {
+            size_t ret = 0;
+            ok = _session.receive(data + size, max_size - size, ret);
+            size += ret;
+        }
+
+        // Keep the trailing partial packet for the next call.
+        const size_t count = size / PKT_SIZE;
+        _partial_size = size % PKT_SIZE;
+        ::memcpy(_partial.b, data + count * PKT_SIZE, _partial_size);
+
+        // Check the synchronization of the stream.
+        for (size_t i = 0; ok && i < count; ++i) {
+            if (buffer[i].b[0] != SYNC_BYTE) {
+                tsp->error(u"synchronization lost after %'d packets", {i});
+                ok = false;
+            }
+        }
+        if (ok) {
+            return count;
+        }
+
+        // Connection lost or broken stream.
+        if (!_session.disconnect()) {
+            return 0;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Output plugin
+//----------------------------------------------------------------------------
+
+ts::TCPOutput::TCPOutput(TSP* tsp_) :
+    OutputPlugin(tsp_, u"Send TS packets over a TCP connection", u"[options] [address:]port"),
+    _session(tsp, u"sent")
+{
+    TCPSession::DefineOptions(*this);
+
+    option(u"cork", 'c');
+    help(u"cork",
+         u"Send only full TCP segments, maximizing the network efficiency on high bitrate links. "
+         u"Partial segments are delayed up to 200 ms. Not supported on Windows. "
+         u"Incompatible with --no-delay.");
+
+    option(u"no-delay", 'n');
+    help(u"no-delay",
+         u"Send the packets immediately, without waiting to group them with the next ones "
+         u"(TCP_NODELAY). This reduces the latency at low bitrates. Incompatible with --cork.");
+}
+
+bool ts::TCPOutput::getOptions()
+{
+    if (present(u"cork") && present(u"no-delay")) {
+        tsp->error(u"--cork and --no-delay are mutually exclusive");
+        return false;
+    }
+    _session.setOutputTuning(present(u"no-delay"), present(u"cork"));
+    return _session.loadOptions(*this);
+}
+
+bool ts::TCPOutput::start()
+{
+    return _session.start();
+}
+
+bool ts::TCPOutput::stop()
+{
+    _session.stop();
+    _session.reportStatistics();
+    return true;
+}
+
+bool ts::TCPOutput::send(const TSPacket* buffer, size_t packet_count)
+{
+    // After a reconnection, the complete window is sent to the new peer.
+    for (;;) {
+        if (!_session.isConnected() && !_session.connect()) {
+            return false;
+        }
+        if (_session.send(buffer, packet_count * PKT_SIZE)) {
+            return true;
+        }
+        if (!_session.disconnect()) {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,272 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Real-time ETSI TR 101 290 monitoring.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsTR101290Analyzer.h"
+#include "tsTR101290HandlerInterface.h"
+#include "tsTime.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class TR101290Plugin: public ProcessorPlugin, private TR101290HandlerInterface
+    {
+    public:
+        // Implementation of plugin API
+        TR101290Plugin(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual Status processPacket(TSPacket&, bool&, bool&) override;
+
+    private:
+        UString          _output_name;   // Output file name for events.
+        std::ofstream    _output_stream; // Output file.
+        BitRate          _user_bitrate;  // User-specified bitrate (zero if unspecified).
+        bool             _summary;       // Display error counters at end.
+        BitRate          _bitrate;       // Bitrate of current time base.
+        PacketCounter    _base_packet;   // Packet index of current time base.
+        NanoSecond       _base_time;     // Stream time of current time base.
+        NanoSecond       _last_time;     // Stream time of last packet.
+        Time             _start_time;    // Wall clock time at start, when bitrate is unknown.
+        TR101290Analyzer _analyzer;      // TR 101 290 engine.
+
+        // Compute the stream time of the current packet.
+        NanoSecond streamTime();
+
+        // Implementation of TR101290HandlerInterface.
+        virtual void handleTR101290Event(TR101290Analyzer& analyzer, const TR101290Analyzer::Event& event) override;
+
+        // Inaccessible operations
+        TR101290Plugin() = delete;
+        TR101290Plugin(const TR101290Plugin&) = delete;
+        TR101290Plugin& operator=(const TR101290Plugin&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_PROCESSOR(tr101290, ts::TR101290Plugin)
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::TR101290Plugin::TR101290Plugin(TSP* tsp_) :
+    ProcessorPlugin(tsp_, u"Monitor the transport stream according to ETSI TR 101 290", u"[options]"),
+    _output_name(),
+    _output_stream(),
+    _user_bitrate(0),
+    _summary(false),
+    _bitrate(0),
+    _base_packet(0),
+    _base_time(0),
+    _last_time(0),
+    _start_time(),
+    _analyzer(this)
+{
+    option(u"bitrate", 'b', POSITIVE);
+    help(u"bitrate",
+         u"Specify the transport stream bitrate in bits/second. All timeouts are evaluated "
+         u"on the time line of the stream, computed from the number of packets and the bitrate. "
+         u"By default, use the bitrate as reported by the input device or the previous plugins. "
+         u"When the bitrate is unknown, the wall clock time is used.");
+
+    option(u"disable", 'd', TR101290Analyzer::IndicatorNames, 0, UNLIMITED_COUNT);
+    help(u"disable",
+         u"Disable the specified indicator. No alarm is reported for it. "
+         u"Several --disable options may be specified.");
+
+    option(u"hold-time", 'h', POSITIVE);
+    help(u"hold-time",
+         u"Specify the hold time of event-type alarms in milliseconds. An alarm such as a "
+         u"continuity error is cleared when no new error occurs during that time. "
+         u"The default is " + UString::Decimal(TR101290Analyzer::DEFAULT_HOLD_TIME / NanoSecPerMilliSec) + u" ms.");
+
+    option(u"output-file", 'o', STRING);
+    help(u"output-file", u"filename",
+         u"Specify the output file for the alarm events. By default, the events are logged as information messages.");
+
+    option(u"pid-timeout", 'p', POSITIVE);
+    help(u"pid-timeout",
+         u"Specify the timeout in milliseconds after which a PID which is referenced in a PMT "
+         u"is reported as missing (PID_error). "
+         u"The default is " + UString::Decimal(TR101290Analyzer::DEFAULT_PID_TIMEOUT / NanoSecPerMilliSec) + u" ms.");
+
+    option(u"summary", 's');
+    help(u"summary", u"Display the error counters of all indicators at end of processing.");
+}
+
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::TR101290Plugin::start()
+{
+    _output_name = value(u"output-file");
+    _user_bitrate = intValue<BitRate>(u"bitrate", 0);
+    _summary = present(u"summary");
+
+    _analyzer.reset();
+    _analyzer.setHoldTime(intValue<MilliSecond>(u"hold-time", TR101290Analyzer::DEFAULT_HOLD_TIME / NanoSecPerMilliSec) * NanoSecPerMilliSec);
+    _analyzer.setPIDTimeout(intValue<MilliSecond>(u"pid-timeout", TR101290Analyzer::DEFAULT_PID_TIMEOUT / NanoSecPerMilliSec) * NanoSecPerMilliSec);
+    for (size_t i = 0; i < TR101290Analyzer::INDICATOR_COUNT; ++i) {
+        _analyzer.setIndicator(TR101290Analyzer::Indicator(i), true);
+    }
+    for (size_t i = 0; i < count(u"disable"); ++i) {
+        _analyzer.setIndicator(TR101290Analyzer::Indicator(intValue<int>(u"disable", 0, i)), false);
+    }
+
+    _bitrate = 0;
+    _base_packet = 0;
+    _base_time = _last_time = 0;
+    _start_time = Time::CurrentUTC();
+
+    if (!_output_name.empty()) {
+        _output_stream.open(_output_name.toUTF8().c_str());
+        if (!_output_stream) {
+            tsp->error(u"cannot create file %s", {_output_name});
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::TR101290Plugin::stop()
+{
+    if (_summary) {
+        UStringList lines;
+        lines.push_back(UString::Format(u"TR 101 290 summary, %'d packets analyzed:", {_analyzer.packetCount()}));
+        for (size_t i = 0; i < TR101290Analyzer::INDICATOR_COUNT; ++i) {
+            const TR101290Analyzer::Indicator ind = TR101290Analyzer::Indicator(i);
+            lines.push_back(UString::Format(u"  %d. %-34s %11'd%s",
+                                            {TR101290Analyzer::Priority(ind),
+                                             TR101290Analyzer::IndicatorNames.name(ind),
+                                             _analyzer.errorCount(ind),
+                                             _analyzer.isEnabled(ind) ? u"" : u" (disabled)"}));
+        }
+        for (auto it = lines.begin(); it != lines.end(); ++it) {
+            if (_output_stream.is_open()) {
+                _output_stream << *it << std::endl;
+            }
+            else {
+                tsp->info(*it);
+            }
+        }
+    }
+    if (_output_stream.is_open()) {
+        _output_stream.close();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the stream time of the current packet.
+//----------------------------------------------------------------------------
+
+ts::NanoSecond ts::TR101290Plugin::streamTime()
+{
+    const PacketCounter index = _analyzer.packetCount();
+    const BitRate bitrate = _user_bitrate != 0 ? _user_bitrate : tsp->bitrate();
+
+    // Rebase the time line when the bitrate changes.
+    if (bitrate != _bitrate) {
+        _bitrate = bitrate;
+        _base_packet = index;
+        _base_time = _last_time;
+        _start_time = Time::CurrentUTC();
+    }
+
+    NanoSecond now = 0;
+    if (_bitrate != 0) {
+        now = _base_time + NanoSecond(double(index - _base_packet) * PKT_SIZE_BITS * NanoSecPerSec / _bitrate);
+    }
+    else {
+        now = _base_time + (Time::CurrentUTC() - _start_time) * NanoSecPerMilliSec;
+    }
+    _last_time = std::max(now, _last_time);
+    return _last_time;
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing method
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::TR101290Plugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    _analyzer.feedPacket(pkt, streamTime());
+    return TSP_OK;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the analyzer when an alarm is raised or cleared.
+//----------------------------------------------------------------------------
+
+void ts::TR101290Plugin::handleTR101290Event(TR101290Analyzer& analyzer, const TR101290Analyzer::Event& event)
+{
+    const MilliSecond ms = event.timestamp / NanoSecPerMilliSec;
+    UString line(UString::Format(u"%d.%03d s, %s %d. %s", {ms / 1000, ms % 1000, event.raised ? u"raised" : u"cleared",
+                                                         TR101290Analyzer::Priority(event.indicator),
+                                                         TR101290Analyzer::IndicatorNames.name(event.indicator)}));
+    if (event.pid < PID_MAX) {
+        line.append(UString::Format(u", PID 0x%X (%d)", {event.pid, event.pid}));
+    }
+    if (event.has_service) {
+        line.append(UString::Format(u", service 0x%X (%d)", {event.service_id, event.service_id}));
+    }
+    if (!event.details.empty()) {
+        line.append(u", ");
+        line.append(event.details);
+    }
+
+    if (_output_stream.is_open()) {
+        _output_stream << line << std::endl;
+    }
+    else {
+        tsp->info(line);
+    }
+}
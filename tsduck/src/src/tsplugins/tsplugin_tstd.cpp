@@ -0,0 +1,284 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  T-STD buffer model verification.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPlugin.h"
+#include "tsPluginRepository.h"
+#include "tsTSTDAnalyzer.h"
+#include "tsTSTDHandlerInterface.h"
+#include "tsMetricsWriter.h"
+#include "tsNames.h"
+#include "tsTime.h"
+#include <atomic>
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class TSTDPlugin: public ProcessorPlugin, private TSTDHandlerInterface
+    {
+    public:
+        // Implementation of plugin API
+        TSTDPlugin(TSP*);
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual Status processPacket(TSPacket&, bool&, bool&) override;
+        virtual void getMetrics(MetricsWriter&) override;
+
+    private:
+        UString       _output_name;    // Output file name for events.
+        std::ofstream _output_stream;  // Output file.
+        bool          _summary;        // Display buffer statistics at end.
+        Second        _interval;       // Interval between buffer status reports.
+        Time          _next_report;    // Wall clock time of next status report.
+        TSTDAnalyzer  _analyzer;       // T-STD simulation engine.
+        std::atomic<uint64_t> _violations[TSTDAnalyzer::VIOLATION_COUNT];  // Published to the metrics server.
+
+        // Display a line on the output file or the log.
+        void display(const UString& line);
+
+        // Display the buffer status of all simulated streams.
+        void displayStatus(bool final);
+
+        // Implementation of TSTDHandlerInterface.
+        virtual void handleTSTDEvent(TSTDAnalyzer& analyzer, const TSTDAnalyzer::Event& event) override;
+
+        // Inaccessible operations
+        TSTDPlugin() = delete;
+        TSTDPlugin(const TSTDPlugin&) = delete;
+        TSTDPlugin& operator=(const TSTDPlugin&) = delete;
+    };
+}
+
+TSPLUGIN_DECLARE_VERSION
+TSPLUGIN_DECLARE_PROCESSOR(tstd, ts::TSTDPlugin)
+
+// Number of packets between two checks of the wall clock for --interval.
+namespace {
+    const ts::PacketCounter CLOCK_CHECK_PACKETS = 1000;
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::TSTDPlugin::TSTDPlugin(TSP* tsp_) :
+    ProcessorPlugin(tsp_, u"Verify the T-STD buffer model of audio and video streams", u"[options]"),
+    _output_name(),
+    _output_stream(),
+    _summary(false),
+    _interval(0),
+    _next_report(),
+    _analyzer(this),
+    _violations()
+{
+    option(u"interval", 'i', POSITIVE);
+    help(u"interval", u"seconds",
+         u"Periodically display the buffer levels of all simulated elementary streams. "
+         u"By default, only the violations are reported.");
+
+    option(u"output-file", 'o', STRING);
+    help(u"output-file", u"filename",
+         u"Specify the output file for the violation events and the buffer levels. "
+         u"By default, they are logged as information messages.");
+
+    option(u"pid", 'p', PIDVAL, 0, UNLIMITED_COUNT);
+    help(u"pid", u"pid1[-pid2]",
+         u"Simulate the T-STD buffers for the specified elementary stream PID's only. "
+         u"Several --pid options may be specified. By default, all audio and video PID's are simulated.");
+
+    option(u"summary", 's');
+    help(u"summary", u"Display the buffer statistics and violation counters of all streams at end of processing.");
+}
+
+
+//----------------------------------------------------------------------------
+// Start method
+//----------------------------------------------------------------------------
+
+bool ts::TSTDPlugin::start()
+{
+    _output_name = value(u"output-file");
+    _summary = present(u"summary");
+    _interval = intValue<Second>(u"interval", 0);
+
+    PIDSet pids;
+    getIntValues(pids, u"pid", true);
+    _analyzer.setPIDFilter(pids);
+    _analyzer.reset();
+    for (size_t i = 0; i < TSTDAnalyzer::VIOLATION_COUNT; ++i) {
+        _violations[i] = 0;
+    }
+    _next_report = Time::CurrentUTC() + _interval * MilliSecPerSec;
+
+    if (!_output_name.empty()) {
+        _output_stream.open(_output_name.toUTF8().c_str());
+        if (!_output_stream) {
+            tsp->error(u"cannot create file %s", {_output_name});
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::TSTDPlugin::stop()
+{
+    if (_summary) {
+        displayStatus(true);
+    }
+    if (_output_stream.is_open()) {
+        _output_stream.close();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing method
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::TSTDPlugin::processPacket(TSPacket& pkt, bool& flush, bool& bitrate_changed)
+{
+    _analyzer.feedPacket(pkt);
+
+    if (_interval > 0 && _analyzer.packetCount() % CLOCK_CHECK_PACKETS == 0) {
+        const Time now(Time::CurrentUTC());
+        if (now >= _next_report) {
+            _next_report = now + _interval * MilliSecPerSec;
+            displayStatus(false);
+        }
+    }
+    return TSP_OK;
+}
+
+
+//----------------------------------------------------------------------------
+// Display a line on the output file or the log.
+//----------------------------------------------------------------------------
+
+void ts::TSTDPlugin::display(const UString& line)
+{
+    if (_output_stream.is_open()) {
+        _output_stream << line << std::endl;
+    }
+    else {
+        tsp->info(line);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Display the buffer status of all simulated streams.
+//----------------------------------------------------------------------------
+
+void ts::TSTDPlugin::displayStatus(bool final)
+{
+    TSTDAnalyzer::StreamStatusVector status;
+    _analyzer.getStatus(status);
+
+    if (final) {
+        display(UString::Format(u"T-STD summary, %'d packets analyzed:", {_analyzer.packetCount()}));
+    }
+    for (auto it = status.begin(); it != status.end(); ++it) {
+        if (!it->simulated) {
+            if (final) {
+                display(UString::Format(u"  PID 0x%X (%d), %s, not simulated", {it->pid, it->pid, names::StreamType(it->stream_type)}));
+            }
+            continue;
+        }
+        UString line(UString::Format(u"  PID 0x%X (%d), %s, Rx: %'d b/s", {it->pid, it->pid, names::StreamType(it->stream_type), it->rx}));
+        if (it->has_mb) {
+            line.append(UString::Format(u", Rbx: %'d b/s", {it->rbx}));
+        }
+        display(line);
+        display(UString::Format(u"    TB: %'d / %'d bytes (max %'d)", {it->tb_level, it->tb_size, it->tb_max}));
+        if (it->has_mb) {
+            display(UString::Format(u"    MB: %'d / %'d bytes (max %'d)", {it->mb_level, it->mb_size, it->mb_max}));
+        }
+        display(UString::Format(u"    EB: %'d / %'d bytes (max %'d), %'d access units", {it->eb_level, it->eb_size, it->eb_max, it->access_units}));
+        if (it->has_ltw) {
+            display(UString::Format(u"    LTW offset bounds: %'d to %'d (27 MHz/300)", {it->ltw_lower, it->ltw_upper}));
+        }
+        line.assign(u"    Violations:");
+        for (size_t i = 0; i < TSTDAnalyzer::VIOLATION_COUNT; ++i) {
+            line.append(UString::Format(u"%s %s: %'d", {i == 0 ? u"" : u",", TSTDAnalyzer::ViolationNames.name(int(i)), it->violations[i]}));
+        }
+        display(line);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the analyzer when a violation is raised or cleared.
+//----------------------------------------------------------------------------
+
+void ts::TSTDPlugin::handleTSTDEvent(TSTDAnalyzer& analyzer, const TSTDAnalyzer::Event& event)
+{
+    if (event.raised) {
+        _violations[event.violation].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const MilliSecond ms = event.timestamp / NanoSecPerMilliSec;
+    UString line(UString::Format(u"%d.%03d s, %s %s, PID 0x%X (%d), service 0x%X (%d)",
+                                 {ms / 1000, ms % 1000, event.raised ? u"raised" : u"cleared",
+                                  TSTDAnalyzer::ViolationNames.name(event.violation),
+                                  event.pid, event.pid, event.service_id, event.service_id}));
+    if (!event.details.empty()) {
+        line.append(u", ");
+        line.append(event.details);
+    }
+    display(line);
+}
+
+
+//----------------------------------------------------------------------------
+// Publish the violation counters to the metrics server.
+//----------------------------------------------------------------------------
+
+void ts::TSTDPlugin::getMetrics(MetricsWriter& writer)
+{
+    for (size_t i = 0; i < TSTDAnalyzer::VIOLATION_COUNT; ++i) {
+        writer.counter(u"tstd_" + TSTDAnalyzer::ViolationNames.name(int(i)).toLower() + u"_total",
+                       u"Number of T-STD buffer violations of type " + TSTDAnalyzer::ViolationNames.name(int(i)) + u".",
+                       _violations[i].load(std::memory_order_relaxed));
+    }
+}
@@ -34,9 +34,21 @@
 #include "tsMain.h"
 #include "tsTSAnalyzerReport.h"
 #include "tsTSAnalyzerOptions.h"
-#include "tsInputRedirector.h"
+#include "tsTSFileInput.h"
+#include "tsReport.h"
+#include "tsSysUtils.h"
+#include "tsThread.h"
 TSDUCK_SOURCE;
 
+// Maximum number of packets to read at a time.
+#define READ_PACKETS 1024
+
+// Default number of packets to demux before each chunk in parallel analysis.
+#define DEFAULT_WARM_UP 100000
+
+// Minimum number of packets per chunk in parallel analysis.
+#define MIN_CHUNK_PACKETS 10000
+
 
 //----------------------------------------------------------------------------
 //  Command line options
@@ -48,6 +60,8 @@ struct Options: public ts::Args
 
     ts::BitRate           bitrate;   // Expected bitrate (188-byte packets)
     ts::UString           infile;    // Input file name
+    size_t                threads;   // Number of analysis threads.
+    ts::PacketCounter     warm_up;   // Number of packets to demux before each chunk.
     ts::TSAnalyzerOptions analysis;  // Analysis options.
 };
 
@@ -55,6 +69,8 @@ Options::Options(int argc, char *argv[]) :
     ts::Args(u"Analyze the structure of a transport stream", u"[options] [filename]"),
     bitrate(0),
     infile(),
+    threads(1),
+    warm_up(DEFAULT_WARM_UP),
     analysis()
 {
     // Define all standard analysis options.
@@ -69,16 +85,206 @@ Options::Options(int argc, char *argv[]) :
          u"(based on 188-byte packets). By default, the bitrate is "
          u"evaluated using the PCR in the transport stream.");
 
+    option(u"threads", 'j', INTEGER, 0, 1, 1, 1024);
+    help(u"threads",
+         u"Number of threads which analyze the input file in parallel. "
+         u"The file is split into contiguous chunks, one per thread, which are "
+         u"analyzed independently and the results are merged in file order. "
+         u"This requires a regular file, not the standard input. "
+         u"The default is 1, a sequential analysis.");
+
+    option(u"warm-up", 0, UNSIGNED);
+    help(u"warm-up",
+         u"With --threads, number of packets before each chunk which are demuxed "
+         u"without being counted, to collect the PSI/SI which describe the streams "
+         u"of the chunk. The default is " TS_USTRINGIFY(DEFAULT_WARM_UP) u" packets.");
+
     analyze(argc, argv);
 
     infile = value(u"");
     bitrate = intValue<ts::BitRate>(u"bitrate");
+    threads = intValue<size_t>(u"threads", 1);
+    warm_up = intValue<ts::PacketCounter>(u"warm-up", DEFAULT_WARM_UP);
     analysis.load(*this);
 
+    if (threads > 1 && infile.empty()) {
+        error(u"--threads requires an input file name");
+    }
+
     exitOnError();
 }
 
 
+//----------------------------------------------------------------------------
+//  Messages of one chunk, replayed with their severity after the analysis.
+//----------------------------------------------------------------------------
+
+class ChunkLog: public ts::Report
+{
+public:
+    // Constructor.
+    ChunkLog(int max_severity) : ts::Report(max_severity), _messages(), _errors(false) {}
+
+    // Check if errors were logged.
+    bool hasErrors() const { return _errors; }
+
+    // Replay all messages on another report.
+    void replay(ts::Report& report) const
+    {
+        for (auto it = _messages.begin(); it != _messages.end(); ++it) {
+            report.log(it->first, it->second);
+        }
+    }
+
+protected:
+    virtual void writeLog(int severity, const ts::UString& message) override
+    {
+        _messages.push_back(std::make_pair(severity, message));
+        _errors = _errors || severity <= ts::Severity::Error;
+    }
+
+private:
+    std::list<std::pair<int, ts::UString>> _messages;
+    bool _errors;
+};
+
+
+//----------------------------------------------------------------------------
+//  Analysis of one chunk of the input file, in a separate thread.
+//----------------------------------------------------------------------------
+
+class ChunkAnalyzer: public ts::Thread
+{
+public:
+    // Constructor: analyze count packets, starting at packet index start.
+    ChunkAnalyzer(const Options& opt, ts::PacketCounter start, ts::PacketCounter count);
+    virtual ~ChunkAnalyzer() override;
+
+    ts::TSAnalyzerReport analyzer;   // Analysis of the chunk.
+    ChunkLog             log;        // Messages from the chunk, displayed after the analysis.
+    bool                 success;    // False if the file could not be read.
+    bool                 sync;       // False if synchronization was lost in the chunk.
+    ts::PacketCounter    sync_index; // Index of packet where synchronization was lost.
+    uint8_t              sync_byte;  // Invalid sync byte.
+
+private:
+    const Options&    _opt;
+    ts::PacketCounter _start;
+    ts::PacketCounter _count;
+
+    virtual void main() override;
+
+    ChunkAnalyzer() = delete;
+    ChunkAnalyzer(const ChunkAnalyzer&) = delete;
+    ChunkAnalyzer& operator=(const ChunkAnalyzer&) = delete;
+};
+
+ChunkAnalyzer::ChunkAnalyzer(const Options& opt, ts::PacketCounter start, ts::PacketCounter count) :
+    ts::Thread(),
+    analyzer(opt.bitrate),
+    log(opt.maxSeverity()),
+    success(true),
+    sync(true),
+    sync_index(0),
+    sync_byte(0),
+    _opt(opt),
+    _start(start),
+    _count(count)
+{
+    analyzer.setAnalysisOptions(opt.analysis);
+}
+
+ChunkAnalyzer::~ChunkAnalyzer()
+{
+    waitForTermination();
+}
+
+void ChunkAnalyzer::main()
+{
+    // The demux are warmed up with packets from the end of the previous chunk.
+    const ts::PacketCounter warm_start = _start > _opt.warm_up ? _start - _opt.warm_up : 0;
+    ts::PacketCounter warm_count = _start - warm_start;
+
+    ts::TSFileInput file;
+    file.setMemoryMap(true);
+    if (!file.open(_opt.infile, 1, warm_start * ts::PKT_SIZE, log)) {
+        success = sync = false;
+        return;
+    }
+
+    analyzer.setPacketIndex(_start);
+
+    const ts::TSPacket* pkt = nullptr;
+    size_t count = 0;
+    while (sync && _count > 0 && (count = file.readMapped(pkt, READ_PACKETS, log)) > 0) {
+        // Synchronization losses in the warm-up area are reported by the previous chunk.
+        for (; warm_count > 0 && count > 0; ++pkt, --count, --warm_count) {
+            analyzer.warmUp(*pkt);
+        }
+        for (; sync && _count > 0 && count > 0; ++pkt, --count, --_count) {
+            if ((sync = pkt->hasValidSync())) {
+                analyzer.feedPacket(*pkt);
+            }
+            else {
+                sync_index = warm_start + file.getPacketCount() - count;
+                sync_byte = pkt->b[0];
+            }
+        }
+    }
+    file.close(log);
+    success = !log.hasErrors();
+}
+
+
+//----------------------------------------------------------------------------
+//  Parallel analysis of a regular file.
+//----------------------------------------------------------------------------
+
+bool ParallelAnalysis(Options& opt, ts::TSAnalyzerReport& analyzer)
+{
+    const int64_t size = ts::GetFileSize(opt.infile);
+    if (size < 0) {
+        opt.error(u"cannot get size of %s", {opt.infile});
+        return false;
+    }
+
+    // Split the file in contiguous chunks of packets, not too small.
+    const ts::PacketCounter total = ts::PacketCounter(size) / ts::PKT_SIZE;
+    const size_t count = size_t(std::max<ts::PacketCounter>(1, std::min<ts::PacketCounter>(opt.threads, total / MIN_CHUNK_PACKETS)));
+    const ts::PacketCounter chunk = (total + count - 1) / count;
+    opt.verbose(u"analyzing %'d packets in %d chunks of %'d packets", {total, count, chunk});
+
+    std::vector<ChunkAnalyzer*> chunks;
+    for (size_t i = 0; i < count; ++i) {
+        const ts::PacketCounter start = i * chunk;
+        chunks.push_back(new ChunkAnalyzer(opt, start, std::min(chunk, total - start)));
+    }
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        chunks[i]->start();
+    }
+
+    // Merge the analyses in file order, up to the first synchronization loss or error.
+    bool success = true;
+    bool sync = true;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        chunks[i]->waitForTermination();
+        if (success && sync) {
+            chunks[i]->log.replay(opt);
+            success = chunks[i]->success;
+            sync = chunks[i]->sync;
+            if (success) {
+                analyzer.merge(chunks[i]->analyzer);
+                if (!sync) {
+                    opt.error(u"synchronization lost after %'d packets, got 0x%X instead of 0x%X at start of TS packet", {chunks[i]->sync_index, chunks[i]->sync_byte, ts::SYNC_BYTE});
+                }
+            }
+        }
+        delete chunks[i];
+    }
+    return success;
+}
+
+
 //----------------------------------------------------------------------------
 //  Program entry point
 //----------------------------------------------------------------------------
@@ -87,14 +293,38 @@ int MainCode(int argc, char *argv[])
 {
     Options opt(argc, argv);
     ts::TSAnalyzerReport analyzer(opt.bitrate);
-    ts::InputRedirector input(opt.infile, opt);
-    ts::TSPacket pkt;
+    ts::TSFileInput file;
 
     analyzer.setAnalysisOptions(opt.analysis);
 
-    while (pkt.read(std::cin, true, opt)) {
-        analyzer.feedPacket(pkt);
+    if (opt.threads > 1) {
+        if (!ParallelAnalysis(opt, analyzer)) {
+            return EXIT_FAILURE;
+        }
+        analyzer.report(std::cout, opt.analysis);
+        return EXIT_SUCCESS;
+    }
+
+    // Read packets directly from a memory mapping of the file, when possible.
+    file.setMemoryMap(true);
+    if (!file.open(opt.infile, 1, 0, opt)) {
+        return EXIT_FAILURE;
+    }
+
+    const ts::TSPacket* pkt = nullptr;
+    size_t count = 0;
+    bool sync = true;
+    while (sync && (count = file.readMapped(pkt, READ_PACKETS, opt)) > 0) {
+        for (; sync && count > 0; ++pkt, --count) {
+            if ((sync = pkt->hasValidSync())) {
+                analyzer.feedPacket(*pkt);
+            }
+            else {
+                opt.error(u"synchronization lost after %'d packets, got 0x%X instead of 0x%X at start of TS packet", {file.getPacketCount() - count, pkt->b[0], ts::SYNC_BYTE});
+            }
+        }
     }
+    file.close(opt);
 
     analyzer.report(std::cout, opt.analysis);
 
@@ -32,10 +32,57 @@
 //----------------------------------------------------------------------------
 
 #include "tsMain.h"
-#include "tsInputRedirector.h"
+#include "tsTSFileInput.h"
 #include "tsPCRAnalyzer.h"
+#include "tsSysUtils.h"
+#include <cmath>
 TSDUCK_SOURCE;
 
+// Maximum number of packets to read at a time.
+#define READ_PACKETS 1024
+
+// Default maximum number of sampling points in sampled mode.
+#define DEFAULT_SAMPLES 64
+
+// Default relative precision in sampled mode, in parts per million.
+#define DEFAULT_PRECISION 1000
+
+// Minimum number of valid sampling points before estimating the precision.
+#define MIN_SAMPLES 4
+
+// Maximum number of packets to read at one sampling point.
+#define MAX_SAMPLE_PACKETS 1000000
+
+// Factor of the standard error for a 95% confidence interval: two-sided 95% quantile
+// of the Student t distribution for a number of degrees of freedom. Between two entries,
+// the value for the lower number of degrees of freedom is used, which is conservative.
+namespace {
+    const struct {
+        size_t df;
+        double t;
+    } StudentQuantiles[] = {
+        {1, 12.706}, {2, 4.303}, {3, 3.182}, {4, 2.776}, {5, 2.571}, {6, 2.447}, {7, 2.365},
+        {8, 2.306}, {9, 2.262}, {10, 2.228}, {11, 2.201}, {12, 2.179}, {13, 2.160}, {14, 2.145},
+        {15, 2.131}, {16, 2.120}, {17, 2.110}, {18, 2.101}, {19, 2.093}, {20, 2.086}, {21, 2.080},
+        {22, 2.074}, {23, 2.069}, {24, 2.064}, {25, 2.060}, {26, 2.056}, {27, 2.052}, {28, 2.048},
+        {29, 2.045}, {30, 2.042}, {40, 2.021}, {60, 2.000}, {120, 1.980},
+    };
+
+    double ConfidenceFactor(size_t df)
+    {
+        const size_t count = sizeof(StudentQuantiles) / sizeof(StudentQuantiles[0]);
+        if (df > 1000) {
+            return 1.960;  // Normal distribution.
+        }
+        for (size_t i = count; i > 0; --i) {
+            if (StudentQuantiles[i - 1].df <= df) {
+                return StudentQuantiles[i - 1].t;
+            }
+        }
+        return StudentQuantiles[0].t;
+    }
+}
+
 
 //----------------------------------------------------------------------------
 //  Command line options
@@ -53,6 +100,12 @@ struct Options: public ts::Args
     bool        full;          // Full analysis
     bool        value_only;    // Output value only
     bool        ignore_errors; // Ignore TS errors
+    bool        statistics;    // Display PCR histograms
+    bool        json;          // Display PCR histograms in JSON format
+    bool        sampling;      // Sampled analysis at several points in the file
+    bool        streaming;     // Display refined values after each sampling point
+    size_t      samples;       // Max number of sampling points
+    uint32_t    precision;     // Relative precision in sampled mode (ppm)
     ts::UString infile;        // Input file name
 };
 
@@ -66,6 +119,12 @@ Options::Options(int argc, char *argv[]) :
     full(false),
     value_only(false),
     ignore_errors(false),
+    statistics(false),
+    json(false),
+    sampling(false),
+    streaming(false),
+    samples(0),
+    precision(0),
     infile()
 {
     option(u"", 0, STRING, 0, 1);
@@ -93,12 +152,49 @@ Options::Options(int argc, char *argv[]) :
          u"is evaluated. When errors are ignored, the bitrate of the received stream is "
          u"evaluated, missing packets being considered as non-existent.");
 
+    option(u"json", 'j');
+    help(u"json",
+         u"Same as --statistics but display the PCR histograms in JSON format.");
+
     option(u"min-pcr", 0, POSITIVE);
     help(u"min-pcr", u"p analysis when that number of PCR are read from the required minimum number of PID (default: 64).");
 
     option(u"min-pid", 0, INTEGER, 0, 1, 1, ts::PID_MAX);
     help(u"min-pid", u"Minimum number of PID's to get PCR from (default: 1).");
 
+    option(u"precision", 0, POSITIVE);
+    help(u"precision", u"ppm",
+         u"With --sampling, stop reading the file when the 95% confidence margin of the "
+         u"TS bitrate is lower than this relative value, in parts per million. "
+         u"The default is " + ts::UString::Decimal(DEFAULT_PRECISION) + u" ppm (0.1%).");
+
+    option(u"samples", 0, INTEGER, 0, 1, MIN_SAMPLES, UNLIMITED_VALUE);
+    help(u"samples",
+         u"With --sampling, maximum number of sampling points in the file. "
+         u"The default is " + ts::UString::Decimal(DEFAULT_SAMPLES) + u".");
+
+    option(u"sampling");
+    help(u"sampling",
+         u"Fast estimation on large files. Instead of reading the complete file, read PCR's "
+         u"at several points which are spread across the file (the input must be a regular "
+         u"file). At each sampling point, the reading stops when enough PCR information has "
+         u"been collected (see --min-pcr and --min-pid). The global and per-PID bitrates are "
+         u"estimated with a 95% confidence margin. The analysis stops when the requested "
+         u"precision is reached (see --precision) or after the maximum number of sampling "
+         u"points (see --samples).");
+
+    option(u"statistics", 's');
+    help(u"statistics",
+         u"Analyze all packets in the input file (as with --all) and display the "
+         u"histograms of PCR intervals and PCR accuracy for each PID, in nano-seconds. "
+         u"The PCR accuracy is the difference between the PCR interval and the interval "
+         u"which is expected from the average transport bitrate. Since the arrival times "
+         u"of the packets are unknown in a file, the PCR jitter is not available.");
+
+    option(u"streaming");
+    help(u"streaming",
+         u"With --sampling, display the refined estimation after each sampling point.");
+
     option(u"value-only", 'v');
     help(u"value-only",
          u"Display only the bitrate value, in bits/seconds, based on "
@@ -108,18 +204,290 @@ Options::Options(int argc, char *argv[]) :
 
     infile = value(u"");
     full = present(u"full");
-    all = full || present(u"all");
+    json = present(u"json");
+    statistics = json || present(u"statistics");
+    all = full || statistics || present(u"all");
     value_only = present(u"value-only");
     min_pcr = intValue<uint32_t>(u"min-pcr", 64);
     min_pid = intValue<uint16_t>(u"min-pid", 1);
     use_dts = present(u"dts");
     pcr_name = use_dts ? u"DTS" : u"PCR";
     ignore_errors = present(u"ignore-errors");
+    sampling = present(u"sampling");
+    streaming = present(u"streaming");
+    samples = intValue<size_t>(u"samples", DEFAULT_SAMPLES);
+    precision = intValue<uint32_t>(u"precision", DEFAULT_PRECISION);
+
+    if (sampling && infile.empty()) {
+        error(u"--sampling requires a regular file, not the standard input");
+    }
+    if (sampling && statistics) {
+        error(u"--sampling cannot be used with --statistics or --json");
+    }
 
     exitOnError();
 }
 
 
+//----------------------------------------------------------------------------
+//  Estimation of the bitrates from several sampling points.
+//----------------------------------------------------------------------------
+
+class BitrateSampler
+{
+public:
+    // Constructor.
+    BitrateSampler();
+
+    // Add the result of the PCR analysis at one sampling point.
+    void addSample(const ts::PCRAnalyzer& zer);
+
+    // Number of valid sampling points.
+    size_t sampleCount() const { return _count; }
+
+    // Estimated bitrate and half-width of its 95% confidence interval, for the TS or one PID.
+    double bitrate() const;
+    double margin() const;
+    double bitrate(ts::PID pid) const;
+    double margin(ts::PID pid) const;
+
+    // Check if a PID was found in any sampling point.
+    bool hasPID(ts::PID pid) const { return _share_sum[pid] > 0.0; }
+
+private:
+    size_t _count;                      // Number of sampling points.
+    double _duration_sum;               // Sum of 1/bitrate, the duration of one bit at each sampling point.
+    double _duration_sum2;              // Sum of squares of 1/bitrate.
+    double _share_sum[ts::PID_MAX];     // Sum of packet shares of each PID at each sampling point.
+    double _share_sum2[ts::PID_MAX];    // Sum of squares of packet shares.
+
+    // Half-width of the 95% confidence interval of the mean, from a sum and sum of squares.
+    double meanMargin(double sum, double sum2) const;
+};
+
+BitrateSampler::BitrateSampler() :
+    _count(0),
+    _duration_sum(0.0),
+    _duration_sum2(0.0),
+    _share_sum(),
+    _share_sum2()
+{
+}
+
+void BitrateSampler::addSample(const ts::PCRAnalyzer& zer)
+{
+    ts::PCRAnalyzer::Status status;
+    zer.getStatus(status);
+    if (status.bitrate_valid && status.bitrate_188 > 0 && status.packet_count > 0) {
+        _count++;
+        const double duration = 1.0 / double(status.bitrate_188);
+        _duration_sum += duration;
+        _duration_sum2 += duration * duration;
+        for (ts::PID pid = 0; pid < ts::PID_MAX; ++pid) {
+            const double share = double(zer.packetCount(pid)) / double(status.packet_count);
+            _share_sum[pid] += share;
+            _share_sum2[pid] += share * share;
+        }
+    }
+}
+
+double BitrateSampler::meanMargin(double sum, double sum2) const
+{
+    if (_count < 2) {
+        return 0.0;
+    }
+    const double mean = sum / double(_count);
+    const double variance = std::max(0.0, (sum2 - double(_count) * mean * mean) / double(_count - 1));
+    return ConfidenceFactor(_count - 1) * std::sqrt(variance / double(_count));
+}
+
+// The sampling points are evenly spread in bytes, not in time. The average
+// bitrate of the file is the total size over the total duration, meaning the
+// harmonic mean of the bitrates at all sampling points.
+double BitrateSampler::bitrate() const
+{
+    return _duration_sum > 0.0 ? double(_count) / _duration_sum : 0.0;
+}
+
+// Margin of 1/mean(duration), derived from the margin of the mean duration.
+double BitrateSampler::margin() const
+{
+    const double rate = bitrate();
+    return rate * rate * meanMargin(_duration_sum, _duration_sum2);
+}
+
+double BitrateSampler::bitrate(ts::PID pid) const
+{
+    return _count == 0 ? 0.0 : bitrate() * _share_sum[pid] / double(_count);
+}
+
+// The relative margins of the TS bitrate and the PID share are combined.
+double BitrateSampler::margin(ts::PID pid) const
+{
+    const double rate = bitrate();
+    const double share = _count == 0 ? 0.0 : _share_sum[pid] / double(_count);
+    if (rate <= 0.0 || share <= 0.0) {
+        return 0.0;
+    }
+    const double rel_rate = margin() / rate;
+    const double rel_share = meanMargin(_share_sum[pid], _share_sum2[pid]) / share;
+    return bitrate(pid) * std::sqrt(rel_rate * rel_rate + rel_share * rel_share);
+}
+
+
+//----------------------------------------------------------------------------
+//  Sampled analysis of a regular file.
+//----------------------------------------------------------------------------
+
+namespace {
+
+    // Position of sampling point index in [0..1[. Successive indexes are spread
+    // over the whole interval by bit reversal (van der Corput sequence): 0, 1/2,
+    // 1/4, 3/4, 1/8, ... so that the estimation is global even after a few points.
+    double SamplingPosition(size_t index)
+    {
+        double pos = 0.0;
+        for (double weight = 0.5; index != 0; index >>= 1, weight /= 2) {
+            if ((index & 1) != 0) {
+                pos += weight;
+            }
+        }
+        return pos;
+    }
+
+    // Display the TS bitrate with its confidence margin.
+    ts::UString SampledBitrate(const BitrateSampler& sampler)
+    {
+        const uint64_t rate = uint64_t(sampler.bitrate() + 0.5);
+        return ts::UString::Format(u"%'d b/s (188-byte), %'d b/s (204-byte), +/- %'d b/s, %d samples",
+                                   {rate, (rate * ts::PKT_RS_SIZE) / ts::PKT_SIZE, uint64_t(sampler.margin() + 0.5), sampler.sampleCount()});
+    }
+
+    int SampledAnalysis(Options& opt)
+    {
+        const int64_t size = ts::GetFileSize(opt.infile);
+        if (size < 0) {
+            opt.error(u"cannot get size of %s", {opt.infile});
+            return EXIT_FAILURE;
+        }
+
+        ts::TSFileInput file;
+        file.setMemoryMap(true);
+        if (!file.open(opt.infile, 0, opt)) {
+            return EXIT_FAILURE;
+        }
+
+        // Read sampling points until the required precision is reached.
+        const ts::PacketCounter total = ts::PacketCounter(size) / ts::PKT_SIZE;
+        BitrateSampler sampler;
+        ts::PCRAnalyzer zer(opt.min_pid, opt.min_pcr);
+        zer.setIgnoreErrors(opt.ignore_errors);
+        if (opt.use_dts) {
+            zer.resetAndUseDTS(opt.min_pid, opt.min_pcr);
+        }
+        bool sync = true;
+
+        for (size_t index = 0; sync && index < opt.samples; ++index) {
+
+            // Start of sampling point, in packets.
+            const ts::PacketCounter start = ts::PacketCounter(SamplingPosition(index) * double(total));
+            if (!file.seek(start, opt)) {
+                break;
+            }
+
+            // Restart a fresh PCR analysis at each sampling point.
+            zer.reset();
+
+            const ts::TSPacket* pkt = nullptr;
+            size_t count = 0;
+            ts::PacketCounter remain = MAX_SAMPLE_PACKETS;
+            bool more = true;
+            while (more && (count = file.readMapped(pkt, size_t(std::min<ts::PacketCounter>(READ_PACKETS, remain)), opt)) > 0) {
+                remain -= count;
+                for (; more && count > 0; ++pkt, --count) {
+                    if (!pkt->hasValidSync()) {
+                        opt.error(u"synchronization lost after %'d packets, got 0x%X instead of 0x%X at start of TS packet", {start + MAX_SAMPLE_PACKETS - remain - count, pkt->b[0], ts::SYNC_BYTE});
+                        more = sync = false;
+                    }
+                    else {
+                        more = !zer.feedPacket(*pkt);
+                    }
+                }
+                more = more && remain > 0;
+            }
+
+            // Accumulate the result of the sampling point.
+            sampler.addSample(zer);
+            if (!zer.bitrateIsValid()) {
+                opt.verbose(u"insufficient %s at packet %'d", {opt.pcr_name, start});
+            }
+            else if (opt.streaming && opt.value_only) {
+                std::cout << uint64_t(sampler.bitrate() + 0.5) << std::endl;
+            }
+            else if (opt.streaming) {
+                std::cout << ts::UString::Format(u"Sample at packet %'d: %'d b/s, TS bitrate: ", {start, zer.bitrate188()}) << SampledBitrate(sampler) << std::endl;
+            }
+
+            // Stop when the requested precision is reached.
+            if (sampler.sampleCount() >= MIN_SAMPLES && sampler.margin() * 1000000.0 <= sampler.bitrate() * double(opt.precision)) {
+                break;
+            }
+        }
+        file.close(opt);
+
+        // Display results.
+        if (sampler.sampleCount() == 0) {
+            opt.error(u"cannot compute transport bitrate, insufficient %s", {opt.pcr_name});
+            return EXIT_FAILURE;
+        }
+        if (opt.streaming) {
+            return EXIT_SUCCESS;
+        }
+        if (opt.value_only) {
+            std::cout << uint64_t(sampler.bitrate() + 0.5) << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        std::cout << "TS bitrate" << (opt.full ? "     " : "") << ": " << SampledBitrate(sampler) << std::endl;
+
+        if (opt.full) {
+            std::cout << std::endl
+                      << "PID              Bitrate (188-byte)         Margin" << std::endl
+                      << "-------------  --------------------  -------------" << std::endl;
+            for (ts::PID pid = 0; pid < ts::PID_MAX; pid++) {
+                if (sampler.hasPID(pid)) {
+                    std::cout << ts::UString::Format(u"%4d (0x%04X)  %16'd b/s  %9'd b/s", {pid, pid, uint64_t(sampler.bitrate(pid) + 0.5), uint64_t(sampler.margin(pid) + 0.5)})
+                              << std::endl;
+                }
+            }
+            std::cout << std::endl;
+        }
+
+        return EXIT_SUCCESS;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Display PCR histograms, when requested.
+//----------------------------------------------------------------------------
+
+namespace {
+    void DisplayStatistics(const Options& opt, const ts::PCRAnalyzer& zer)
+    {
+        if (opt.json) {
+            std::cout << zer.jsonStatistics()->printed() << std::endl;
+        }
+        else if (opt.statistics) {
+            std::cout << "PCR statistics (nano-seconds)" << std::endl
+                      << "-----------------------------" << std::endl;
+            zer.reportStatistics(std::cout);
+            std::cout << std::endl;
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 //  Program entry point
 //----------------------------------------------------------------------------
@@ -127,18 +495,42 @@ Options::Options(int argc, char *argv[]) :
 int MainCode(int argc, char *argv[])
 {
     Options opt(argc, argv);
+    if (opt.sampling) {
+        return SampledAnalysis(opt);
+    }
+
     ts::PCRAnalyzer zer(opt.min_pid, opt.min_pcr);
-    ts::InputRedirector input(opt.infile, opt);
-    ts::TSPacket pkt;
+    ts::TSFileInput file;
 
     // Configure the PCR analyzer.
     zer.setIgnoreErrors(opt.ignore_errors);
+    zer.setStatistics(opt.statistics);
     if (opt.use_dts) {
         zer.resetAndUseDTS(opt.min_pid, opt.min_pcr);
     }
 
+    // Read packets directly from a memory mapping of the file, when possible.
+    file.setMemoryMap(true);
+    if (!file.open(opt.infile, 1, 0, opt)) {
+        return EXIT_FAILURE;
+    }
+
     // Read all packets in the file and pass them to the PCR analyzer.
-    while (pkt.read(std::cin, true, opt) && (!zer.feedPacket(pkt) || opt.all)) {}
+    const ts::TSPacket* pkt = nullptr;
+    size_t count = 0;
+    bool more = true;
+    while (more && (count = file.readMapped(pkt, READ_PACKETS, opt)) > 0) {
+        for (; more && count > 0; ++pkt, --count) {
+            if (!pkt->hasValidSync()) {
+                opt.error(u"synchronization lost after %'d packets, got 0x%X instead of 0x%X at start of TS packet", {file.getPacketCount() - count, pkt->b[0], ts::SYNC_BYTE});
+                more = false;
+            }
+            else {
+                more = !zer.feedPacket(*pkt) || opt.all;
+            }
+        }
+    }
+    file.close(opt);
 
     // Display results.
     ts::PCRAnalyzer::Status status;
@@ -153,6 +545,7 @@ int MainCode(int argc, char *argv[])
 
     if (opt.value_only) {
         std::cout << status.bitrate_188 << std::endl;
+        DisplayStatistics(opt, zer);
         return EXIT_SUCCESS;
     }
 
@@ -187,6 +580,7 @@ int MainCode(int argc, char *argv[])
         std::cout << std::endl;
     }
 
+    DisplayStatistics(opt, zer);
     return EXIT_SUCCESS;
 }
 
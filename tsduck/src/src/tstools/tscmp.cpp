@@ -34,6 +34,9 @@
 #include "tsMain.h"
 #include "tsMemoryUtils.h"
 #include "tsTSFileInputBuffered.h"
+#include "tsMessageQueue.h"
+#include "tsReportBuffer.h"
+#include "tsThread.h"
 #include "tsBinaryTable.h"
 #include "tsSection.h"
 #include "tsPMT.h"
@@ -42,6 +45,18 @@ TSDUCK_SOURCE;
 
 #define DEFAULT_BUFFERED_PACKETS 10000
 
+// Default number of packets to search ahead when resynchronizing files.
+#define DEFAULT_RESYNC_WINDOW 10000
+
+// Default number of consecutive identical packets to declare files resynchronized.
+#define DEFAULT_RESYNC_PACKETS 8
+
+// Number of packets per block which is read by background reader threads.
+#define READER_BLOCK_PACKETS 8192
+
+// Maximum number of blocks which are read ahead by background reader threads.
+#define READER_MAX_BLOCKS 8
+
 
 //----------------------------------------------------------------------------
 //  Command line options
@@ -66,6 +81,9 @@ struct Options: public ts::Args
     bool        pid_ignore;
     bool        cc_ignore;
     bool        continue_all;
+    bool        resync;
+    size_t      resync_window;
+    size_t      resync_packets;
 };
 
 Options::Options(int argc, char *argv[]) :
@@ -84,7 +102,10 @@ Options::Options(int argc, char *argv[]) :
     pcr_ignore(false),
     pid_ignore(false),
     cc_ignore(false),
-    continue_all(false)
+    continue_all(false),
+    resync(false),
+    resync_window(0),
+    resync_packets(0)
 {
     option(u"", 0, STRING, 2, 2);
     help(u"", u"MPEG capture files to be compared.");
@@ -126,6 +147,28 @@ Options::Options(int argc, char *argv[]) :
          u"Do not output any message. The process simply terminates with a success "
          u"status if the files are identical and a failure status if they differ.");
 
+    option(u"resync", 'r');
+    help(u"resync",
+         u"Compare files which may have gained or lost packets. Identical areas are compared "
+         u"in large blocks which are read in the background. When packets differ, the files are "
+         u"resynchronized by searching matching packets ahead in both files (see --resync-window "
+         u"and --resync-packets). The comparison always continues up to the end of files and "
+         u"reports ranges of packets which were inserted in the second file, dropped from the "
+         u"first file or modified. This option is incompatible with --dump and --subset.");
+
+    option(u"resync-packets", 0, INTEGER, 0, 1, 1, UNLIMITED_VALUE);
+    help(u"resync-packets",
+         u"With --resync, number of consecutive identical packets which are required to "
+         u"declare that the two files are synchronized again. "
+         u"The default is " + ts::UString::Decimal(DEFAULT_RESYNC_PACKETS) + u" packets.");
+
+    option(u"resync-window", 0, INTEGER, 0, 1, 1, UNLIMITED_VALUE);
+    help(u"resync-window",
+         u"With --resync, maximum number of packets to search ahead in each file to find the "
+         u"resynchronization point. When no matching packets are found, the complete windows "
+         u"are reported as modified. "
+         u"The default is " + ts::UString::Decimal(DEFAULT_RESYNC_WINDOW) + u" packets.");
+
     option(u"subset", 's');
     help(u"subset",
          u"Specifies that the second file is a subset of the first one. This means "
@@ -156,6 +199,9 @@ Options::Options(int argc, char *argv[]) :
     pid_ignore = present(u"pid-ignore");
     cc_ignore = present(u"cc-ignore");
     continue_all = present(u"continue");
+    resync = present(u"resync");
+    resync_window = intValue<size_t>(u"resync-window", DEFAULT_RESYNC_WINDOW);
+    resync_packets = intValue<size_t>(u"resync-packets", DEFAULT_RESYNC_PACKETS);
     quiet = present(u"quiet");
     normalized = !quiet && present(u"normalized");
     dump = !quiet && present(u"dump");
@@ -163,6 +209,12 @@ Options::Options(int argc, char *argv[]) :
     if (quiet) {
         setMaxSeverity(ts::Severity::Info);
     }
+    if (resync && subset) {
+        error(u"--resync and --subset are mutually exclusive");
+    }
+    if (resync && dump) {
+        error(u"--resync and --dump are mutually exclusive");
+    }
 
     dump_flags =
         ts::TSPacket::DUMP_TS_HEADER |    // Format TS headers
@@ -194,6 +246,10 @@ public:
     // Compare two TS packets, return equal
     bool compare(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, Options& opt);
 
+    // Get the area of a non-null packet which is compared according to options.
+    // Ignored fields are cleared in a copy of the packet when necessary.
+    static const uint8_t* ComparedArea(const ts::TSPacket& pkt, ts::TSPacket& copy, size_t& size, const Options& opt);
+
 private:
     // Compare two TS memory regions, return equal
     bool compare(const uint8_t* mem1, size_t size1, const uint8_t* mem2, size_t size2);
@@ -248,42 +304,490 @@ bool Comparator::compare(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, Opt
         compare(pkt1.b, ts::PKT_SIZE, pkt2.b, ts::PKT_SIZE);
         return equal = pkt1.getPID() == ts::PID_NULL && pkt2.getPID() == ts::PID_NULL;
     }
-    else if (opt.payload_only) {
+    else {
+        ts::TSPacket p1, p2;
+        size_t size1 = 0, size2 = 0;
+        const uint8_t* const area1 = ComparedArea(pkt1, p1, size1, opt);
+        const uint8_t* const area2 = ComparedArea(pkt2, p2, size2, opt);
+        return compare(area1, size1, area2, size2);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Get the area of a non-null packet which is compared according to options.
+//----------------------------------------------------------------------------
+
+const uint8_t* Comparator::ComparedArea(const ts::TSPacket& pkt, ts::TSPacket& copy, size_t& size, const Options& opt)
+{
+    if (opt.payload_only) {
         // Compare payload only
-        return compare(pkt1.getPayload(), pkt1.getPayloadSize(), pkt2.getPayload(), pkt2.getPayloadSize());
+        size = pkt.getPayloadSize();
+        return pkt.getPayload();
     }
     else if (!opt.pcr_ignore && !opt.pid_ignore && !opt.cc_ignore) {
         // Compare full original packets
-        return compare(pkt1.b, ts::PKT_SIZE, pkt2.b, ts::PKT_SIZE);
+        size = ts::PKT_SIZE;
+        return pkt.b;
     }
     else {
-        // Some fields should be ignored, reset them to zero in local copies
-        ts::TSPacket p1, p2;
-        p1 = pkt1;
-        p2 = pkt2;
+        // Some fields should be ignored, reset them to zero in a local copy
+        copy = pkt;
         if (opt.pcr_ignore) {
-            if (p1.hasPCR()) {
-                p1.setPCR(0);
+            if (copy.hasPCR()) {
+                copy.setPCR(0);
             }
-            if (p1.hasOPCR()) {
-                p1.setOPCR(0);
-            }
-            if (p2.hasPCR()) {
-                p2.setPCR(0);
-            }
-            if (p2.hasOPCR()) {
-                p2.setOPCR(0);
+            if (copy.hasOPCR()) {
+                copy.setOPCR(0);
             }
         }
         if (opt.pid_ignore) {
-            p1.setPID(ts::PID_NULL);
-            p2.setPID(ts::PID_NULL);
+            copy.setPID(ts::PID_NULL);
         }
         if (opt.cc_ignore) {
-            p1.setCC(0);
-            p2.setCC(0);
+            copy.setCC(0);
+        }
+        size = ts::PKT_SIZE;
+        return copy.b;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  File reader with background read-ahead, used with --resync.
+//----------------------------------------------------------------------------
+
+class FileReader: private ts::Thread
+{
+public:
+    // Constructor.
+    FileReader(const Options& opt, const ts::UString& filename);
+    virtual ~FileReader() override;
+
+    // Open the file and start reading in the background.
+    bool open(ts::Report& report);
+
+    // Get at least count packets in the lookahead buffer, unless at end of file.
+    // Return the number of available packets.
+    size_t fill(size_t count);
+
+    // Drop packets from the lookahead buffer.
+    void consume(size_t count);
+
+    // Contiguous available packets in the lookahead buffer.
+    const ts::TSPacket* packets() const { return &_buffer[_start]; }
+    size_t available() const { return _end - _start; }
+
+    // Check if the end of file has been reached (all packets are in the lookahead buffer).
+    bool endOfFile() const { return _eof; }
+
+    // Index in the file of the first available packet.
+    ts::PacketCounter index() const { return _index; }
+
+    // File name.
+    ts::UString fileName() const { return _file.getFileName(); }
+
+    // Errors from the reader thread.
+    ts::ReportBuffer<ts::Mutex> log;
+
+private:
+    typedef std::vector<ts::TSPacket> PacketBlock;
+    typedef ts::MessageQueue<PacketBlock, ts::Mutex> BlockQueue;
+
+    const Options&            _opt;
+    ts::UString               _filename;
+    ts::TSFileInput           _file;
+    BlockQueue                _queue;      // Blocks of packets from the reader thread, null block at end of file.
+    volatile bool             _terminate;  // Request to terminate the reader thread.
+    bool                      _eof;        // End of file reached in lookahead buffer.
+    std::vector<ts::TSPacket> _buffer;     // Lookahead buffer.
+    size_t                    _start;      // Index of first available packet in _buffer.
+    size_t                    _end;        // Index after last available packet in _buffer.
+    ts::PacketCounter         _index;      // Index in file of first available packet.
+
+    virtual void main() override;
+
+    FileReader() = delete;
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+};
+
+FileReader::FileReader(const Options& opt, const ts::UString& filename) :
+    ts::Thread(),
+    log(opt.maxSeverity()),
+    _opt(opt),
+    _filename(filename),
+    _file(),
+    _queue(READER_MAX_BLOCKS),
+    _terminate(false),
+    _eof(false),
+    _buffer(),
+    _start(0),
+    _end(0),
+    _index(0)
+{
+}
+
+FileReader::~FileReader()
+{
+    // Make sure the reader thread is not blocked on a full queue.
+    _terminate = true;
+    _queue.clear();
+    waitForTermination();
+    _file.close(log);
+}
+
+bool FileReader::open(ts::Report& report)
+{
+    _file.setMemoryMap(true);
+    return _file.open(_filename, 1, _opt.byte_offset, report) && start();
+}
+
+void FileReader::main()
+{
+    bool more = true;
+    while (more && !_terminate) {
+        BlockQueue::MessagePtr block(new PacketBlock(READER_BLOCK_PACKETS));
+        const size_t count = _file.read(block->data(), block->size(), log);
+        if (count == 0) {
+            // End of file, signaled by a null block.
+            block.clear();
+            more = false;
+        }
+        else {
+            block->resize(count);
+        }
+        // Wait for free space in the queue, unless termination is requested.
+        while (!_terminate && !_queue.enqueue(block, 100)) {
+        }
+    }
+}
+
+size_t FileReader::fill(size_t count)
+{
+    while (!_eof && _end - _start < count) {
+        BlockQueue::MessagePtr block;
+        _queue.dequeue(block);
+        if (block.isNull()) {
+            _eof = true;
+        }
+        else {
+            // Make room at end of lookahead buffer.
+            if (_end + block->size() > _buffer.size()) {
+                if (_start > 0) {
+                    std::copy(_buffer.begin() + _start, _buffer.begin() + _end, _buffer.begin());
+                    _end -= _start;
+                    _start = 0;
+                }
+                if (_end + block->size() > _buffer.size()) {
+                    _buffer.resize(_end + block->size());
+                }
+            }
+            std::copy(block->begin(), block->end(), _buffer.begin() + _end);
+            _end += block->size();
+        }
+    }
+    return _end - _start;
+}
+
+void FileReader::consume(size_t count)
+{
+    count = std::min(count, _end - _start);
+    _start += count;
+    _index += count;
+    if (_start == _end) {
+        _start = _end = 0;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Comparison of files with resynchronization (--resync).
+//----------------------------------------------------------------------------
+
+class ResyncComparator
+{
+public:
+    // Constructor.
+    ResyncComparator(Options& opt, FileReader& file1, FileReader& file2);
+
+    // Compare the two files up to the end, return true if they are identical.
+    bool compare();
+
+private:
+    // Kinds of differing ranges of packets.
+    enum RangeKind {INSERTED, DROPPED, MODIFIED};
+
+    // A range of differing packets, count1 packets in file 1, count2 packets in file 2.
+    struct Range
+    {
+        RangeKind         kind;
+        ts::PacketCounter start1;
+        ts::PacketCounter count1;
+        ts::PacketCounter start2;
+        ts::PacketCounter count2;
+    };
+
+    Options&          _opt;
+    FileReader&       _file1;
+    FileReader&       _file2;
+    bool              _pending;          // There is a pending range in _range.
+    Range             _range;            // Last differing range, not yet reported.
+    ts::PacketCounter _ranges[3];        // Number of ranges per kind.
+    ts::PacketCounter _packets1[3];      // Number of packets in file 1 per kind.
+    ts::PacketCounter _packets2[3];      // Number of packets in file 2 per kind.
+    std::vector<uint64_t> _hash1;        // Hash values of lookahead packets in file 1.
+    std::vector<uint64_t> _hash2;        // Hash values of lookahead packets in file 2.
+
+    // Compare two packets according to options.
+    bool equal(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2) const;
+
+    // Hash value of a packet, consistent with equal(): equal packets have equal hash values.
+    // All null packets have a zero hash value, other packets have a non-zero hash value.
+    uint64_t hash(const ts::TSPacket& pkt) const;
+
+    // Search the resynchronization point after differing packets, consume the differing packets.
+    void resynchronize();
+
+    // Add a differing range, merge it with the pending one when contiguous.
+    void addRange(ts::PacketCounter count1, ts::PacketCounter count2);
+
+    // Report the pending range, if any.
+    void flushRange();
+
+    // Format a number of packets or ranges, with singular or plural.
+    static ts::UString Packets(ts::PacketCounter count) { return ts::UString::Format(u"%'d packet%s", {count, count == 1 ? u"" : u"s"}); }
+    static ts::UString Ranges(ts::PacketCounter count) { return ts::UString::Format(u"%'d range%s", {count, count == 1 ? u"" : u"s"}); }
+
+    ResyncComparator() = delete;
+    ResyncComparator(const ResyncComparator&) = delete;
+    ResyncComparator& operator=(const ResyncComparator&) = delete;
+};
+
+ResyncComparator::ResyncComparator(Options& opt, FileReader& file1, FileReader& file2) :
+    _opt(opt),
+    _file1(file1),
+    _file2(file2),
+    _pending(false),
+    _range(),
+    _ranges(),
+    _packets1(),
+    _packets2(),
+    _hash1(),
+    _hash2()
+{
+}
+
+bool ResyncComparator::equal(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2) const
+{
+    return ::memcmp(pkt1.b, pkt2.b, ts::PKT_SIZE) == 0 || Comparator(pkt1, pkt2, _opt).equal;
+}
+
+uint64_t ResyncComparator::hash(const ts::TSPacket& pkt) const
+{
+    // All null packets are identical, whatever their content and the options (see Comparator).
+    // With --pid-ignore, the PID of non-null packets is cleared in the compared area only.
+    if (pkt.getPID() == ts::PID_NULL) {
+        return 0;
+    }
+
+    // Hash exactly the area which is compared by Comparator.
+    ts::TSPacket copy;
+    size_t size = 0;
+    const uint8_t* const data = Comparator::ComparedArea(pkt, copy, size, _opt);
+
+    // FNV-1a, 64 bits.
+    uint64_t h = TS_UCONST64(0xCBF29CE484222325);
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ data[i]) * TS_UCONST64(0x00000100000001B3);
+    }
+    return h == 0 ? 1 : h;
+}
+
+bool ResyncComparator::compare()
+{
+    for (;;) {
+        const size_t count1 = _file1.fill(READER_BLOCK_PACKETS);
+        const size_t count2 = _file2.fill(READER_BLOCK_PACKETS);
+
+        // At end of one file, all remaining packets in the other one are dropped or inserted.
+        if (count1 == 0 || count2 == 0) {
+            while (_file1.fill(1) > 0 || _file2.fill(1) > 0) {
+                const size_t rest1 = _file1.available();
+                const size_t rest2 = _file2.available();
+                _file1.consume(rest1);
+                _file2.consume(rest2);
+                addRange(rest1, rest2);
+            }
+            break;
+        }
+
+        // Fast path: compare the largest identical area at once.
+        const ts::TSPacket* pkt1 = _file1.packets();
+        const ts::TSPacket* pkt2 = _file2.packets();
+        const size_t count = std::min(count1, count2);
+        if (::memcmp(pkt1, pkt2, count * ts::PKT_SIZE) == 0) {
+            _file1.consume(count);
+            _file2.consume(count);
+            continue;
+        }
+
+        // Skip identical packets up to the first difference.
+        size_t same = 0;
+        while (same < count && equal(pkt1[same], pkt2[same])) {
+            same++;
+        }
+        _file1.consume(same);
+        _file2.consume(same);
+        if (same < count) {
+            if (_opt.quiet) {
+                return false;
+            }
+            resynchronize();
+        }
+    }
+    flushRange();
+
+    const ts::PacketCounter ranges = _ranges[INSERTED] + _ranges[DROPPED] + _ranges[MODIFIED];
+    if (_opt.normalized) {
+        std::cout << "total:packets1=" << _file1.index()
+                  << ":packets2=" << _file2.index()
+                  << ":diff=" << ranges
+                  << ":inserted=" << _packets2[INSERTED]
+                  << ":insertedranges=" << _ranges[INSERTED]
+                  << ":dropped=" << _packets1[DROPPED]
+                  << ":droppedranges=" << _ranges[DROPPED]
+                  << ":modified1=" << _packets1[MODIFIED]
+                  << ":modified2=" << _packets2[MODIFIED]
+                  << ":modifiedranges=" << _ranges[MODIFIED]
+                  << ":" << std::endl;
+    }
+    else if (_opt.verbose()) {
+        std::cout << ts::UString::Format(u"* Read %'d and %s, %s inserted in %s, %s dropped in %s, %'d/%'d packet%s modified in %s",
+                                         {_file1.index(), Packets(_file2.index()),
+                                          Packets(_packets2[INSERTED]), Ranges(_ranges[INSERTED]),
+                                          Packets(_packets1[DROPPED]), Ranges(_ranges[DROPPED]),
+                                          _packets1[MODIFIED], _packets2[MODIFIED],
+                                          _packets1[MODIFIED] == 1 && _packets2[MODIFIED] == 1 ? u"" : u"s",
+                                          Ranges(_ranges[MODIFIED])})
+                  << std::endl;
+    }
+    return ranges == 0;
+}
+
+void ResyncComparator::resynchronize()
+{
+    // Load and hash the lookahead windows of both files.
+    const size_t window = _opt.resync_window + _opt.resync_packets;
+    const size_t count1 = _file1.fill(window);
+    const size_t count2 = _file2.fill(window);
+    const ts::TSPacket* pkt1 = _file1.packets();
+    const ts::TSPacket* pkt2 = _file2.packets();
+
+    _hash1.resize(std::min(count1, window));
+    _hash2.resize(std::min(count2, window));
+    for (size_t i = 0; i < _hash1.size(); ++i) {
+        _hash1[i] = hash(pkt1[i]);
+    }
+    for (size_t i = 0; i < _hash2.size(); ++i) {
+        _hash2[i] = hash(pkt2[i]);
+    }
+
+    // Index the candidate anchor packets in file 2. Null packets are too frequent to be anchors.
+    const size_t max1 = std::min(_hash1.size(), _opt.resync_window);
+    const size_t max2 = std::min(_hash2.size(), _opt.resync_window);
+    std::map<uint64_t, std::vector<size_t>> anchors;
+    for (size_t i2 = 0; i2 < max2; ++i2) {
+        if (_hash2[i2] != 0) {
+            anchors[_hash2[i2]].push_back(i2);
+        }
+    }
+
+    // Find the closest resynchronization point (i1, i2), minimizing i1 + i2.
+    size_t best1 = max1;
+    size_t best2 = max2;
+    for (size_t i1 = 0; i1 < max1 && i1 < best1 + best2; ++i1) {
+        const auto it = _hash1[i1] == 0 ? anchors.end() : anchors.find(_hash1[i1]);
+        if (it != anchors.end()) {
+            for (auto i2 = it->second.begin(); i2 != it->second.end() && i1 + *i2 < best1 + best2; ++i2) {
+                // Check that enough consecutive packets are identical.
+                size_t k = 0;
+                while (k < _opt.resync_packets && i1 + k < _hash1.size() && *i2 + k < _hash2.size() &&
+                       _hash1[i1 + k] == _hash2[*i2 + k] && equal(pkt1[i1 + k], pkt2[*i2 + k]))
+                {
+                    k++;
+                }
+                // Also accept shorter sequences up to the end of both files.
+                if (k == _opt.resync_packets || (i1 + k == count1 && *i2 + k == count2 && _file1.endOfFile() && _file2.endOfFile())) {
+                    best1 = i1;
+                    best2 = *i2;
+                }
+            }
+        }
+    }
+
+    // Report and skip the differing packets. When not resynchronized, the complete windows are modified.
+    _file1.consume(best1);
+    _file2.consume(best2);
+    addRange(best1, best2);
+}
+
+void ResyncComparator::addRange(ts::PacketCounter count1, ts::PacketCounter count2)
+{
+    const RangeKind kind = count1 == 0 ? INSERTED : (count2 == 0 ? DROPPED : MODIFIED);
+    const ts::PacketCounter start1 = _file1.index() - count1;
+    const ts::PacketCounter start2 = _file2.index() - count2;
+
+    // Contiguous differences of the same kind are merged.
+    if (_pending && _range.kind == kind && _range.start1 + _range.count1 == start1 && _range.start2 + _range.count2 == start2) {
+        _range.count1 += count1;
+        _range.count2 += count2;
+    }
+    else {
+        flushRange();
+        _pending = true;
+        _range.kind = kind;
+        _range.start1 = start1;
+        _range.count1 = count1;
+        _range.start2 = start2;
+        _range.count2 = count2;
+    }
+}
+
+void ResyncComparator::flushRange()
+{
+    if (_pending) {
+        _pending = false;
+        _ranges[_range.kind]++;
+        _packets1[_range.kind] += _range.count1;
+        _packets2[_range.kind] += _range.count2;
+
+        if (_opt.normalized) {
+            std::cout << (_range.kind == INSERTED ? "inserted" : (_range.kind == DROPPED ? "dropped" : "modified"))
+                      << ":packet1=" << _range.start1
+                      << ":count1=" << _range.count1
+                      << ":packet2=" << _range.start2
+                      << ":count2=" << _range.count2
+                      << ":" << std::endl;
+        }
+        else if (!_opt.quiet) {
+            switch (_range.kind) {
+                case INSERTED:
+                    std::cout << ts::UString::Format(u"* Inserted %s in %s at packet %'d, before packet %'d in %s",
+                                                     {Packets(_range.count2), _file2.fileName(), _range.start2, _range.start1, _file1.fileName()});
+                    break;
+                case DROPPED:
+                    std::cout << ts::UString::Format(u"* Dropped %s from %s at packet %'d, before packet %'d in %s",
+                                                     {Packets(_range.count1), _file1.fileName(), _range.start1, _range.start2, _file2.fileName()});
+                    break;
+                case MODIFIED:
+                default:
+                    std::cout << ts::UString::Format(u"* Modified %s in %s at packet %'d, replaced by %s in %s at packet %'d",
+                                                     {Packets(_range.count1), _file1.fileName(), _range.start1, Packets(_range.count2), _file2.fileName(), _range.start2});
+                    break;
+            }
+            std::cout << std::endl;
         }
-        return compare(p1.b, ts::PKT_SIZE, p2.b, ts::PKT_SIZE);
     }
 }
 
@@ -295,10 +799,38 @@ bool Comparator::compare(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, Opt
 int MainCode(int argc, char *argv[])
 {
     Options opt (argc, argv);
+
+    // Comparison with resynchronization.
+    if (opt.resync) {
+        FileReader reader1(opt, opt.filename1);
+        FileReader reader2(opt, opt.filename2);
+        if (!reader1.open(opt) || !reader2.open(opt)) {
+            return EXIT_FAILURE;
+        }
+        if (opt.normalized) {
+            std::cout << "file:file=1:filename=" << reader1.fileName() << ":" << std::endl
+                      << "file:file=2:filename=" << reader2.fileName() << ":" << std::endl;
+        }
+        else if (opt.verbose()) {
+            std::cout << "* Comparing " << reader1.fileName() << " and " << reader2.fileName() << std::endl;
+        }
+        ResyncComparator comp(opt, reader1, reader2);
+        const bool same = comp.compare();
+        if (!reader1.log.emptyMessages()) {
+            opt.error(reader1.log.getMessages());
+        }
+        if (!reader2.log.emptyMessages()) {
+            opt.error(reader2.log.getMessages());
+        }
+        return same && opt.valid() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     ts::TSFileInputBuffered file1(opt.buffered_packets);
     ts::TSFileInputBuffered file2(opt.buffered_packets);
 
-    // Open files
+    // Open files, read through a memory mapping when possible.
+    file1.setMemoryMap(true);
+    file2.setMemoryMap(true);
     file1.open(opt.filename1, 1, opt.byte_offset, opt);
     file2.open(opt.filename2, 1, opt.byte_offset, opt);
     opt.exitOnError();
@@ -0,0 +1,962 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Load generator and latency benchmark for DVB SimulCrypt ECMG.
+//
+//----------------------------------------------------------------------------
+
+#include "tsMain.h"
+#include "tsAsyncReport.h"
+#include "tsECMGSCS.h"
+#include "tsEMMGMUX.h"
+#include "tsTCPServer.h"
+#include "tstlvConnection.h"
+#include "tstlvMessageFactory.h"
+#include "tsGuardCondition.h"
+#include "tsLogHistogram.h"
+#include "tsMonotonic.h"
+#include "tsSysUtils.h"
+#include "tsThread.h"
+TSDUCK_SOURCE;
+
+namespace {
+    // Command line default arguments.
+    static const size_t      DEFAULT_CHANNELS   = 1;
+    static const size_t      DEFAULT_STREAMS    = 1;
+    static const uint32_t    DEFAULT_RATE       = 10;
+    static const size_t      DEFAULT_WINDOW     = 16;
+    static const ts::Second  DEFAULT_DURATION   = 10;
+    static const size_t      DEFAULT_CW_SIZE    = 8;
+    static const size_t      DEFAULT_ITERATIONS = 100000;
+
+    // Stack size for execution of the various threads.
+    static const size_t THREAD_STACK_SIZE = 128 * 1024;
+
+    // Timeout for responses from ECMG during setup and final drain.
+    static const ts::MilliSecond RESPONSE_TIMEOUT = 5000;
+
+    // Number of timestamp slots per stream, must be a power of 2, larger than the max window.
+    static const size_t TIMESTAMP_SLOTS = 1024;
+
+    // Instantiation of a TCP connection in a multi-thread context for TLV messages.
+    typedef ts::tlv::Connection<ts::Mutex> ECMGConnection;
+    typedef ts::SafePtr<ECMGConnection, ts::Mutex> ECMGConnectionPtr;
+}
+
+
+//----------------------------------------------------------------------------
+//  Command line options
+//----------------------------------------------------------------------------
+
+struct LoadOptions: public ts::Args
+{
+    LoadOptions(int argc, char *argv[]);
+
+    bool              codec;           // Benchmark the TLV codec only, no network.
+    size_t            iterations;      // Number of iterations in codec mode.
+    bool              local;           // Use a built-in stub ECMG.
+    ts::SocketAddress ecmgAddress;     // Address of the target ECMG.
+    size_t            channels;        // Number of channels (one TCP connection per channel).
+    size_t            streams;         // Number of streams per channel.
+    uint32_t          rate;            // Number of CW_provision per second and per stream, zero means unlimited.
+    size_t            window;          // Max number of outstanding requests per stream.
+    ts::Second        duration;        // Test duration.
+    size_t            cwSize;          // Size in bytes of control words.
+    ts::ByteBlock     accessCriteria;  // Access criteria to send in CW_provision.
+    uint32_t          superCasId;      // Super_CAS_id for channel_setup.
+    uint16_t          firstChannelId;  // ECM_channel_id of first channel.
+    ts::MilliSecond   stubCompTime;    // ECM computation time in built-in stub ECMG.
+    ts::tlv::VERSION  version;         // ECMG <=> SCS protocol version.
+};
+
+LoadOptions::LoadOptions(int argc, char *argv[]) :
+    ts::Args(u"Load generator and latency benchmark for DVB SimulCrypt ECMG", u"[options]"),
+    codec(false),
+    iterations(0),
+    local(false),
+    ecmgAddress(),
+    channels(0),
+    streams(0),
+    rate(0),
+    window(0),
+    duration(0),
+    cwSize(0),
+    accessCriteria(),
+    superCasId(0),
+    firstChannelId(0),
+    stubCompTime(0),
+    version(0)
+{
+    setIntro(u"This command opens many channels and streams on a DVB SimulCrypt compliant ECMG "
+             u"and sends CW_provision messages at a given rate. At the end of the test, it reports "
+             u"the throughput of ECM generation and the distribution of the response latency. "
+             u"The target ECMG is either a remote one (--ecmg) or a built-in stub ECMG (--local) "
+             u"which measures the performance of the TSDuck protocol stack only.");
+
+    option(u"access-criteria", 'a', STRING);
+    help(u"access-criteria",
+         u"Specifies the access criteria which are sent in each CW_provision. "
+         u"The value must be a suite of hexadecimal digits. Default: no access criteria.");
+
+    option(u"channels", 'c', POSITIVE);
+    help(u"channels",
+         u"Number of ECM channels to open. Each channel uses a distinct TCP connection. "
+         u"Default: " + ts::UString::Decimal(DEFAULT_CHANNELS) + u".");
+
+    option(u"channel-id", 0, UINT16);
+    help(u"channel-id",
+         u"ECM_channel_id of the first channel. The subsequent channels use consecutive values. Default: 1.");
+
+    option(u"codec", 0);
+    help(u"codec",
+         u"Do not connect to any ECMG. Only measure the throughput of the TLV serialization "
+         u"and message factories for typical ECMG <=> SCS and EMMG <=> MUX data messages.");
+
+    option(u"comp-time", 0, UNSIGNED);
+    help(u"comp-time",
+         u"With --local, specify the emulated ECM computation time in milliseconds "
+         u"of the built-in stub ECMG. Default: 0.");
+
+    option(u"cw-size", 0, INTEGER, 0, 1, 1, 64);
+    help(u"cw-size", u"Size in bytes of the control words. Default: " + ts::UString::Decimal(DEFAULT_CW_SIZE) + u" bytes.");
+
+    option(u"duration", 'd', POSITIVE);
+    help(u"duration", u"seconds", u"Duration of the test in seconds. Default: " + ts::UString::Decimal(DEFAULT_DURATION) + u" seconds.");
+
+    option(u"ecmg", 'e', STRING);
+    help(u"ecmg", u"host:port", u"Specify the ECM Generator host name and port.");
+
+    option(u"ecmg-scs-version", 'v', INTEGER, 0, 1, 2, 3);
+    help(u"ecmg-scs-version",
+         u"Specifies the version of the ECMG <=> SCS DVB SimulCrypt protocol. "
+         u"Valid values are 2 and 3. The default is 2.");
+
+    option(u"iterations", 'i', POSITIVE);
+    help(u"iterations",
+         u"With --codec, number of messages to serialize and analyze for each message type. "
+         u"Default: " + ts::UString::Decimal(DEFAULT_ITERATIONS) + u".");
+
+    option(u"local", 'l');
+    help(u"local",
+         u"Start a built-in stub ECMG on the loopback interface and use it as target. "
+         u"The stub ECMG returns precomputed ECM's and accepts any channel or stream.");
+
+    option(u"rate", 'r', UINT32);
+    help(u"rate",
+         u"Number of CW_provision messages per second and per stream. The messages are evenly "
+         u"spread over time. The latency is measured from the scheduled sending time, not the "
+         u"actual one, so that a slow ECMG is not hidden by a late sender. The value zero means "
+         u"as fast as possible, with at most --window outstanding requests per stream. "
+         u"Default: " + ts::UString::Decimal(DEFAULT_RATE) + u" messages per second.");
+
+    option(u"streams", 's', POSITIVE);
+    help(u"streams", u"Number of ECM streams per channel. Default: " + ts::UString::Decimal(DEFAULT_STREAMS) + u".");
+
+    option(u"super-cas-id", 0, UINT32);
+    help(u"super-cas-id", u"Specify the DVB SimulCrypt Super_CAS_Id. Default: 0.");
+
+    option(u"window", 'w', INTEGER, 0, 1, 1, TIMESTAMP_SLOTS / 2);
+    help(u"window",
+         u"Maximum number of outstanding CW_provision messages per stream. When the limit is reached, "
+         u"the sender waits for ECM responses. Default: " + ts::UString::Decimal(DEFAULT_WINDOW) + u".");
+
+    analyze(argc, argv);
+
+    codec = present(u"codec");
+    iterations = intValue<size_t>(u"iterations", DEFAULT_ITERATIONS);
+    local = present(u"local");
+    channels = intValue<size_t>(u"channels", DEFAULT_CHANNELS);
+    streams = intValue<size_t>(u"streams", DEFAULT_STREAMS);
+    rate = intValue<uint32_t>(u"rate", DEFAULT_RATE);
+    window = intValue<size_t>(u"window", DEFAULT_WINDOW);
+    duration = intValue<ts::Second>(u"duration", DEFAULT_DURATION);
+    cwSize = intValue<size_t>(u"cw-size", DEFAULT_CW_SIZE);
+    superCasId = intValue<uint32_t>(u"super-cas-id", 0);
+    firstChannelId = intValue<uint16_t>(u"channel-id", 1);
+    stubCompTime = intValue<ts::MilliSecond>(u"comp-time", 0);
+    version = intValue<ts::tlv::VERSION>(u"ecmg-scs-version", 2);
+
+    if (!value(u"access-criteria").hexaDecode(accessCriteria)) {
+        error(u"invalid access criteria, specify an even number of hexa digits");
+    }
+
+    const ts::UString ecmg(value(u"ecmg"));
+    if (!codec && !local && ecmg.empty()) {
+        error(u"specify one of --ecmg, --local or --codec");
+    }
+    else if (int(codec) + int(local) + int(!ecmg.empty()) > 1) {
+        error(u"--ecmg, --local and --codec are mutually exclusive");
+    }
+    else if (!ecmg.empty() && ecmgAddress.resolve(ecmg, *this) && (!ecmgAddress.hasAddress() || !ecmgAddress.hasPort())) {
+        error(u"missing ECMG address or port");
+    }
+    if (size_t(firstChannelId) + channels > 0x10000) {
+        error(u"too many channels starting at channel id %d", {firstChannelId});
+    }
+
+    // Specify which ECMG <=> SCS version to use.
+    ts::ecmgscs::Protocol::Instance()->setVersion(version);
+
+    exitOnError();
+}
+
+
+//----------------------------------------------------------------------------
+// A minimal stub ECMG, running in the same process.
+//----------------------------------------------------------------------------
+
+class StubECMG: public ts::Thread
+{
+public:
+    // Constructor.
+    StubECMG(const LoadOptions& opt, ts::Report& report);
+
+    // Start the stub ECMG, return its actual server address in addr.
+    bool open(ts::SocketAddress& addr);
+
+    // Stop the stub ECMG, wait for the termination of all sessions.
+    void close();
+
+private:
+    // A thread which manages one client connection.
+    class Session: public ts::Thread
+    {
+    public:
+        Session(StubECMG* stub, const ECMGConnectionPtr& conn);
+        virtual void main() override;
+        // Disconnect the client, if still connected, to terminate the session.
+        void stop() { _conn->disconnect(NULLREP); }
+    private:
+        StubECMG*         _stub;
+        ECMGConnectionPtr _conn;
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+    };
+
+    const LoadOptions& _opt;
+    ts::Report&        _report;
+    ts::TCPServer      _server;
+    ts::SocketAddress  _address;    // Actual server address.
+    ts::ByteBlock      _ecm;        // Precomputed ECM, one TS packet.
+    volatile bool      _terminate;
+    std::list<ts::SafePtr<Session>> _sessions;  // Only accessed by the server thread until it terminates.
+
+    // Main code of the server thread.
+    virtual void main() override;
+
+    // Inaccessible operations.
+    StubECMG(const StubECMG&) = delete;
+    StubECMG& operator=(const StubECMG&) = delete;
+};
+
+StubECMG::StubECMG(const LoadOptions& opt, ts::Report& report) :
+    ts::Thread(ts::ThreadAttributes().setStackSize(THREAD_STACK_SIZE)),
+    _opt(opt),
+    _report(report),
+    _server(),
+    _address(),
+    _ecm(ts::PKT_SIZE, 0xFF),
+    _terminate(false),
+    _sessions()
+{
+    // Fake ECM packet on PID 0x1FFF, content is irrelevant for the SCS.
+    _ecm[0] = ts::SYNC_BYTE;
+    _ecm[1] = 0x5F;
+    _ecm[2] = 0xFF;
+    _ecm[3] = 0x10;
+}
+
+bool StubECMG::open(ts::SocketAddress& addr)
+{
+    // Listen on an ephemeral port on the loopback interface.
+    if (!_server.open(_report) ||
+        !_server.reusePort(true, _report) ||
+        !_server.bind(ts::SocketAddress(ts::IPAddress::LocalHost, ts::SocketAddress::AnyPort), _report) ||
+        !_server.listen(int(_opt.channels), _report) ||
+        !_server.getLocalAddress(_address, _report))
+    {
+        _server.close(NULLREP);
+        return false;
+    }
+    addr = _address;
+    _report.verbose(u"stub ECMG listening on %s", {addr});
+    return start();
+}
+
+void StubECMG::close()
+{
+    // Closing the server socket does not always unblock accept(), connect once to wake it up.
+    _terminate = true;
+    ts::TCPConnection wakeup;
+    if (wakeup.open(NULLREP)) {
+        wakeup.connect(_address, NULLREP);
+        wakeup.close(NULLREP);
+    }
+    waitForTermination();
+    _server.close(NULLREP);
+
+    // The sessions use the stub and its report, they must terminate before returning.
+    for (auto it = _sessions.begin(); it != _sessions.end(); ++it) {
+        (*it)->stop();
+        (*it)->waitForTermination();
+    }
+    _sessions.clear();
+}
+
+void StubECMG::main()
+{
+    while (!_terminate) {
+        ts::SocketAddress clientAddress;
+        ECMGConnectionPtr conn(new ECMGConnection(ts::ecmgscs::Protocol::Instance(), true, 3));
+        ts::CheckNonNull(conn.pointer());
+        if (!_server.accept(*conn, clientAddress, _report) || _terminate) {
+            break;
+        }
+        // The session thread terminates when the client disconnects, it is deallocated in close().
+        ts::SafePtr<Session> session(new Session(this, conn));
+        ts::CheckNonNull(session.pointer());
+        _sessions.push_back(session);
+        session->start();
+    }
+}
+
+StubECMG::Session::Session(StubECMG* stub, const ECMGConnectionPtr& conn) :
+    ts::Thread(ts::ThreadAttributes().setStackSize(THREAD_STACK_SIZE)),
+    _stub(stub),
+    _conn(conn)
+{
+}
+
+void StubECMG::Session::main()
+{
+    ts::tlv::Logger logger(ts::Severity::Debug, &_stub->_report);
+    ts::tlv::MessagePtr msg;
+    bool ok = true;
+
+    // Reply to all requests, without any check.
+    while (ok && _conn->receive(msg, nullptr, logger)) {
+        switch (msg->tag()) {
+            case ts::ecmgscs::Tags::channel_setup:
+            case ts::ecmgscs::Tags::channel_test: {
+                const ts::tlv::ChannelMessage* req = dynamic_cast<const ts::tlv::ChannelMessage*>(msg.pointer());
+                assert(req != nullptr);
+                ts::ecmgscs::ChannelStatus resp;
+                resp.channel_id = req->channel_id;
+                resp.section_TSpkt_flag = true;
+                resp.CW_per_msg = 2;
+                resp.lead_CW = 1;
+                resp.max_comp_time = uint16_t(_stub->_opt.stubCompTime + 100);
+                ok = _conn->send(resp, logger);
+                break;
+            }
+            case ts::ecmgscs::Tags::stream_setup:
+            case ts::ecmgscs::Tags::stream_test: {
+                const ts::tlv::StreamMessage* req = dynamic_cast<const ts::tlv::StreamMessage*>(msg.pointer());
+                assert(req != nullptr);
+                ts::ecmgscs::StreamStatus resp;
+                resp.channel_id = req->channel_id;
+                resp.stream_id = req->stream_id;
+                const ts::ecmgscs::StreamSetup* setup = dynamic_cast<const ts::ecmgscs::StreamSetup*>(msg.pointer());
+                resp.ECM_id = setup == nullptr ? 0 : setup->ECM_id;
+                ok = _conn->send(resp, logger);
+                break;
+            }
+            case ts::ecmgscs::Tags::stream_close_request: {
+                const ts::tlv::StreamMessage* req = dynamic_cast<const ts::tlv::StreamMessage*>(msg.pointer());
+                assert(req != nullptr);
+                ts::ecmgscs::StreamCloseResponse resp;
+                resp.channel_id = req->channel_id;
+                resp.stream_id = req->stream_id;
+                ok = _conn->send(resp, logger);
+                break;
+            }
+            case ts::ecmgscs::Tags::CW_provision: {
+                const ts::ecmgscs::CWProvision* req = dynamic_cast<const ts::ecmgscs::CWProvision*>(msg.pointer());
+                assert(req != nullptr);
+                ts::ecmgscs::ECMResponse resp;
+                resp.channel_id = req->channel_id;
+                resp.stream_id = req->stream_id;
+                resp.CP_number = req->CP_number;
+                resp.ECM_datagram = _stub->_ecm;
+                if (_stub->_opt.stubCompTime > 0) {
+                    ts::SleepThread(_stub->_opt.stubCompTime);
+                }
+                ok = _conn->send(resp, logger);
+                break;
+            }
+            default: {
+                // Silently ignore other messages (channel_close, errors, etc.)
+                break;
+            }
+        }
+    }
+    _conn->disconnect(NULLREP);
+    _conn->close(NULLREP);
+}
+
+
+//----------------------------------------------------------------------------
+// Statistics for one channel or for the complete test.
+//----------------------------------------------------------------------------
+
+struct LoadStatistics
+{
+    LoadStatistics();
+    void merge(const LoadStatistics& other);
+
+    uint64_t          requests;      // Number of sent CW_provision.
+    uint64_t          responses;     // Number of received ECM_response.
+    uint64_t          errors;        // Number of received error messages.
+    uint64_t          unexpected;    // Number of unexpected responses.
+    ts::LogHistogram  ecmLatency;    // CW_provision => ECM_response latency in microseconds.
+    ts::LogHistogram  setupLatency;  // channel_setup and stream_setup latency in microseconds.
+};
+
+LoadStatistics::LoadStatistics() :
+    requests(0),
+    responses(0),
+    errors(0),
+    unexpected(0),
+    ecmLatency(),
+    setupLatency()
+{
+}
+
+void LoadStatistics::merge(const LoadStatistics& other)
+{
+    requests += other.requests;
+    responses += other.responses;
+    errors += other.errors;
+    unexpected += other.unexpected;
+    ecmLatency.merge(other.ecmLatency);
+    setupLatency.merge(other.setupLatency);
+}
+
+
+//----------------------------------------------------------------------------
+// A class which drives one ECM channel with several streams.
+// The object is a thread which sends CW_provision messages.
+// A separate internal thread receives the responses.
+//----------------------------------------------------------------------------
+
+class LoadChannel: public ts::Thread
+{
+public:
+    // Constructor.
+    LoadChannel(const LoadOptions& opt, const ts::SocketAddress& ecmg, uint16_t channelId, const ts::Monotonic& start, ts::Report& report);
+
+    // Get the statistics, after thread termination.
+    const LoadStatistics& statistics() const { return _stats; }
+
+    // Check if the channel was successfully established.
+    bool established() const { return _established; }
+
+private:
+    // Receiver thread.
+    class Receiver: public ts::Thread
+    {
+    public:
+        Receiver(LoadChannel* channel);
+        virtual void main() override;
+    private:
+        LoadChannel* _channel;
+        Receiver(const Receiver&) = delete;
+        Receiver& operator=(const Receiver&) = delete;
+    };
+
+    // State of one stream.
+    struct StreamState
+    {
+        StreamState();
+        uint16_t              cpNumber;     // Next CP number to send.
+        size_t                outstanding;  // Number of requests without response.
+        std::vector<int64_t>  sentAt;       // Request time in nanoseconds, indexed by CP number, -1 if none.
+    };
+
+    const LoadOptions&        _opt;
+    const ts::SocketAddress   _ecmg;
+    const uint16_t            _channelId;
+    const ts::Monotonic       _start;       // Common time reference for all channels.
+    ts::Report&               _report;
+    ts::tlv::Logger           _logger;
+    ECMGConnection            _conn;
+    Receiver                  _receiver;
+    ts::Mutex                 _mutex;       // Protect the stream states.
+    ts::Condition             _ack;         // Signaled when a response is received.
+    std::vector<StreamState>  _streams;
+    bool                      _established;
+    volatile bool             _closing;
+    LoadStatistics            _stats;       // Updated by sender and receiver in distinct fields.
+
+    // Main code of the sender thread.
+    virtual void main() override;
+
+    // Establish the channel and all streams. Synchronous exchanges before starting the receiver.
+    bool setup();
+    bool exchange(const ts::tlv::Message& request, ts::tlv::TAG expected);
+
+    // Send one CW_provision on a stream.
+    bool sendCWProvision(size_t stream, int64_t scheduled);
+
+    // Process an ECM response in the receiver thread.
+    void handleResponse(uint16_t streamId, uint16_t cpNumber, bool error);
+
+    // Current time in nanoseconds, relative to the common start.
+    int64_t now() const { return ts::Monotonic(true) - _start; }
+
+    // Inaccessible operations.
+    LoadChannel(const LoadChannel&) = delete;
+    LoadChannel& operator=(const LoadChannel&) = delete;
+};
+
+LoadChannel::StreamState::StreamState() :
+    cpNumber(0),
+    outstanding(0),
+    sentAt(TIMESTAMP_SLOTS, -1)
+{
+}
+
+LoadChannel::LoadChannel(const LoadOptions& opt, const ts::SocketAddress& ecmg, uint16_t channelId, const ts::Monotonic& start, ts::Report& report) :
+    ts::Thread(ts::ThreadAttributes().setStackSize(THREAD_STACK_SIZE)),
+    _opt(opt),
+    _ecmg(ecmg),
+    _channelId(channelId),
+    _start(start),
+    _report(report),
+    _logger(ts::Severity::Debug, &report),
+    _conn(ts::ecmgscs::Protocol::Instance(), true, 3),
+    _receiver(this),
+    _mutex(),
+    _ack(),
+    _streams(opt.streams),
+    _established(false),
+    _closing(false),
+    _stats()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Establish the channel and all streams.
+//----------------------------------------------------------------------------
+
+bool LoadChannel::exchange(const ts::tlv::Message& request, ts::tlv::TAG expected)
+{
+    const int64_t start = now();
+    ts::tlv::MessagePtr msg;
+    if (!_conn.send(request, _logger) || !_conn.receive(msg, nullptr, _logger)) {
+        return false;
+    }
+    if (msg->tag() != expected) {
+        _report.error(u"channel %d: unexpected response from ECMG:\n%s", {_channelId, msg->dump(4)});
+        return false;
+    }
+    _stats.setupLatency.add(uint64_t(now() - start) / ts::NanoSecPerMicroSec);
+    return true;
+}
+
+bool LoadChannel::setup()
+{
+    // Flawfinder: ignore: this is our open(), not ::open().
+    if (!_conn.open(_report) || !_conn.connect(_ecmg, _report)) {
+        return false;
+    }
+
+    // Small requests and responses, disable Nagle algorithm.
+    _conn.setNoDelay(true, _report);
+
+    ts::ecmgscs::ChannelSetup channelSetup;
+    channelSetup.channel_id = _channelId;
+    channelSetup.Super_CAS_id = _opt.superCasId;
+    if (!exchange(channelSetup, ts::ecmgscs::Tags::channel_status)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < _streams.size(); ++i) {
+        ts::ecmgscs::StreamSetup streamSetup;
+        streamSetup.channel_id = _channelId;
+        streamSetup.stream_id = uint16_t(i);
+        streamSetup.ECM_id = uint16_t((size_t(_channelId) * _streams.size() + i) & 0xFFFF);
+        streamSetup.nominal_CP_duration = 100;
+        if (!exchange(streamSetup, ts::ecmgscs::Tags::stream_status)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Send one CW_provision on a stream.
+//----------------------------------------------------------------------------
+
+bool LoadChannel::sendCWProvision(size_t stream, int64_t scheduled)
+{
+    StreamState& state(_streams[stream]);
+
+    // Wait for a free slot in the window of outstanding requests.
+    uint16_t cp = 0;
+    {
+        ts::GuardCondition lock(_mutex, _ack);
+        while (state.outstanding >= _opt.window && !_closing) {
+            if (!lock.waitCondition(RESPONSE_TIMEOUT)) {
+                _report.error(u"channel %d, stream %d: ECM response timeout", {_channelId, stream});
+                return false;
+            }
+        }
+        if (_closing) {
+            return false;
+        }
+        cp = state.cpNumber++;
+        state.outstanding++;
+        state.sentAt[cp & (TIMESTAMP_SLOTS - 1)] = scheduled < 0 ? now() : scheduled;
+    }
+
+    ts::ecmgscs::CWProvision msg;
+    msg.channel_id = _channelId;
+    msg.stream_id = uint16_t(stream);
+    msg.CP_number = cp;
+    msg.CP_CW_combination.push_back(ts::ecmgscs::CPCWCombination(cp, ts::ByteBlock(_opt.cwSize, uint8_t(cp))));
+    msg.CP_CW_combination.push_back(ts::ecmgscs::CPCWCombination(uint16_t(cp + 1), ts::ByteBlock(_opt.cwSize, uint8_t(cp + 1))));
+    msg.has_CP_duration = true;
+    msg.CP_duration = 100;
+    msg.has_access_criteria = !_opt.accessCriteria.empty();
+    msg.access_criteria = _opt.accessCriteria;
+
+    _stats.requests++;
+    return _conn.send(msg, _logger);
+}
+
+
+//----------------------------------------------------------------------------
+// Main code of the sender thread.
+//----------------------------------------------------------------------------
+
+void LoadChannel::main()
+{
+    if (!setup()) {
+        _conn.disconnect(NULLREP);
+        _conn.close(NULLREP);
+        return;
+    }
+    _established = true;
+    _receiver.start();
+
+    // Interval between two requests in this channel, all streams interleaved.
+    const int64_t interval = _opt.rate == 0 ? 0 : ts::NanoSecPerSec / (int64_t(_opt.rate) * int64_t(_streams.size()));
+    const int64_t end = now() + _opt.duration * ts::NanoSecPerSec;
+
+    // Spread the first request of each channel over the first interval.
+    int64_t next = now() + (interval * (_channelId - _opt.firstChannelId)) / int64_t(_opt.channels);
+
+    bool ok = true;
+    for (size_t stream = 0; ok && next < end; stream = (stream + 1) % _streams.size()) {
+        if (interval > 0) {
+            ts::Monotonic due(_start);
+            due += next;
+            due.wait();
+            ok = sendCWProvision(stream, next);
+            next += interval;
+        }
+        else {
+            ok = sendCWProvision(stream, -1);
+            next = now();
+        }
+    }
+
+    // Wait for the last responses.
+    {
+        ts::GuardCondition lock(_mutex, _ack);
+        for (size_t i = 0; ok && i < _streams.size(); ++i) {
+            while (ok && _streams[i].outstanding > 0) {
+                ok = lock.waitCondition(RESPONSE_TIMEOUT);
+            }
+        }
+        _closing = true;
+    }
+
+    // Close all streams and the channel. The ECMG is not required to answer channel_close.
+    for (size_t i = 0; i < _streams.size(); ++i) {
+        ts::ecmgscs::StreamCloseRequest close;
+        close.channel_id = _channelId;
+        close.stream_id = uint16_t(i);
+        _conn.send(close, _logger);
+    }
+    ts::ecmgscs::ChannelClose close;
+    close.channel_id = _channelId;
+    _conn.send(close, _logger);
+
+    // Give a chance to the ECMG to process the close messages before disconnecting.
+    ts::SleepThread(100);
+    _conn.disconnect(NULLREP);
+    _receiver.waitForTermination();
+    _conn.close(NULLREP);
+}
+
+
+//----------------------------------------------------------------------------
+// Receiver thread.
+//----------------------------------------------------------------------------
+
+LoadChannel::Receiver::Receiver(LoadChannel* channel) :
+    ts::Thread(ts::ThreadAttributes().setStackSize(THREAD_STACK_SIZE)),
+    _channel(channel)
+{
+}
+
+void LoadChannel::Receiver::main()
+{
+    ts::tlv::MessagePtr msg;
+    bool ok = true;
+    while (ok && _channel->_conn.receive(msg, nullptr, _channel->_logger)) {
+        switch (msg->tag()) {
+            case ts::ecmgscs::Tags::ECM_response: {
+                const ts::ecmgscs::ECMResponse* resp = dynamic_cast<const ts::ecmgscs::ECMResponse*>(msg.pointer());
+                assert(resp != nullptr);
+                _channel->handleResponse(resp->stream_id, resp->CP_number, false);
+                break;
+            }
+            case ts::ecmgscs::Tags::stream_error: {
+                const ts::ecmgscs::StreamError* resp = dynamic_cast<const ts::ecmgscs::StreamError*>(msg.pointer());
+                assert(resp != nullptr);
+                _channel->_report.error(u"channel %d: error from ECMG:\n%s", {_channel->_channelId, resp->dump(4)});
+                _channel->handleResponse(resp->stream_id, 0, true);
+                break;
+            }
+            case ts::ecmgscs::Tags::channel_error: {
+                _channel->_report.error(u"channel %d: error from ECMG:\n%s", {_channel->_channelId, msg->dump(4)});
+                _channel->_stats.errors++;
+                break;
+            }
+            case ts::ecmgscs::Tags::channel_test: {
+                ts::ecmgscs::ChannelStatus resp;
+                resp.channel_id = _channel->_channelId;
+                ok = _channel->_conn.send(resp, _channel->_logger);
+                break;
+            }
+            case ts::ecmgscs::Tags::stream_test: {
+                const ts::tlv::StreamMessage* req = dynamic_cast<const ts::tlv::StreamMessage*>(msg.pointer());
+                assert(req != nullptr);
+                ts::ecmgscs::StreamStatus resp;
+                resp.channel_id = _channel->_channelId;
+                resp.stream_id = req->stream_id;
+                ok = _channel->_conn.send(resp, _channel->_logger);
+                break;
+            }
+            default: {
+                // Responses to close requests and unsollicited status are ignored.
+                break;
+            }
+        }
+    }
+}
+
+void LoadChannel::handleResponse(uint16_t streamId, uint16_t cpNumber, bool error)
+{
+    int64_t latency = -1;
+    {
+        ts::GuardCondition lock(_mutex, _ack);
+        if (streamId < _streams.size() && _streams[streamId].outstanding > 0) {
+            // The window is smaller than the number of slots, a pending CP number is not overwritten.
+            StreamState& state(_streams[streamId]);
+            int64_t& sentAt(state.sentAt[cpNumber & (TIMESTAMP_SLOTS - 1)]);
+            if (!error && sentAt >= 0) {
+                latency = now() - sentAt;
+                sentAt = -1;
+            }
+            state.outstanding--;
+            lock.signal();
+        }
+    }
+    if (error) {
+        _stats.errors++;
+    }
+    else if (latency < 0) {
+        _stats.unexpected++;
+    }
+    else {
+        _stats.responses++;
+        _stats.ecmLatency.add(uint64_t(latency) / ts::NanoSecPerMicroSec);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Display a latency histogram.
+//----------------------------------------------------------------------------
+
+namespace {
+    void DisplayLatency(ts::Report& report, const ts::UString& title, const ts::LogHistogram& h)
+    {
+        if (h.count() > 0) {
+            report.info(u"%s (us): min: %'d, mean: %'d, p50: %'d, p99: %'d, p999: %'d, max: %'d",
+                        {title, h.minimum(), uint64_t(h.mean()), h.percentile(50.0), h.percentile(99.0), h.percentile(99.9), h.maximum()});
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Benchmark of the TLV codec only.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Serialize and analyze one message many times, report the throughput.
+    void BenchmarkMessage(ts::Report& report, size_t iterations, const ts::UString& name, const ts::tlv::Message& msg, const ts::tlv::Protocol* protocol)
+    {
+        size_t bytes = 0;
+        size_t errors = 0;
+        ts::ByteBlock bb;
+        const ts::Monotonic start(true);
+
+        // Reuse the same serialization buffer, as done by tlv::Connection.
+        for (size_t i = 0; i < iterations; ++i) {
+            bb.clear();
+            ts::tlv::Serializer zer(bb);
+            msg.serialize(zer);
+            bytes += bb.size();
+
+            ts::tlv::MessageFactory mf(bb.data(), bb.size(), protocol);
+            ts::tlv::MessagePtr out;
+            if (mf.errorStatus() == ts::tlv::OK) {
+                mf.factory(out);
+            }
+            if (out.isNull()) {
+                errors++;
+            }
+        }
+
+        const ts::NanoSecond elapsed = std::max<ts::NanoSecond>(1, ts::Monotonic(true) - start);
+        report.info(u"%s: %'d messages, %'d bytes, %'d ns/message, %'d messages/s%s",
+                    {name, iterations, bytes, elapsed / ts::NanoSecond(iterations),
+                     (ts::NanoSecPerSec * ts::NanoSecond(iterations)) / elapsed,
+                     errors == 0 ? ts::UString() : ts::UString::Format(u", %'d errors", {errors})});
+    }
+
+    void BenchmarkCodec(LoadOptions& opt)
+    {
+        ts::ecmgscs::CWProvision cw;
+        cw.channel_id = opt.firstChannelId;
+        cw.stream_id = 1;
+        cw.CP_number = 12;
+        cw.CP_CW_combination.push_back(ts::ecmgscs::CPCWCombination(12, ts::ByteBlock(opt.cwSize, 0x12)));
+        cw.CP_CW_combination.push_back(ts::ecmgscs::CPCWCombination(13, ts::ByteBlock(opt.cwSize, 0x13)));
+        cw.has_CP_duration = true;
+        cw.CP_duration = 100;
+        cw.has_access_criteria = !opt.accessCriteria.empty();
+        cw.access_criteria = opt.accessCriteria;
+        BenchmarkMessage(opt, opt.iterations, u"CW_provision", cw, ts::ecmgscs::Protocol::Instance());
+
+        ts::ecmgscs::ECMResponse ecm;
+        ecm.channel_id = opt.firstChannelId;
+        ecm.stream_id = 1;
+        ecm.CP_number = 12;
+        ecm.ECM_datagram.resize(ts::PKT_SIZE, 0xFF);
+        BenchmarkMessage(opt, opt.iterations, u"ECM_response", ecm, ts::ecmgscs::Protocol::Instance());
+
+        ts::emmgmux::DataProvision data;
+        data.channel_id = 1;
+        data.stream_id = 1;
+        data.client_id = opt.superCasId;
+        data.data_id = 1;
+        for (size_t i = 0; i < 7; ++i) {
+            data.datagram.push_back(ts::ByteBlockPtr(new ts::ByteBlock(ts::PKT_SIZE, 0xFF)));
+        }
+        BenchmarkMessage(opt, opt.iterations, u"data_provision", data, ts::emmgmux::Protocol::Instance());
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Program entry point
+//----------------------------------------------------------------------------
+
+int MainCode(int argc, char *argv[])
+{
+    LoadOptions opt(argc, argv);
+
+    // Codec benchmark only, no network.
+    if (opt.codec) {
+        BenchmarkCodec(opt);
+        return EXIT_SUCCESS;
+    }
+
+    // All threads report through an asynchronous report.
+    ts::AsyncReport report(opt.maxSeverity());
+
+    // Start the stub ECMG when necessary.
+    StubECMG stub(opt, report);
+    ts::SocketAddress ecmgAddress(opt.ecmgAddress);
+    if (opt.local && !stub.open(ecmgAddress)) {
+        return EXIT_FAILURE;
+    }
+
+    // Request a fine timer resolution for pacing.
+    ts::Monotonic::SetPrecision(100 * ts::NanoSecPerMicroSec);
+
+    // Create and start all channels.
+    report.verbose(u"starting %d channels, %d streams per channel, %d CW_provision/s per stream",
+                   {opt.channels, opt.streams, opt.rate});
+    const ts::Monotonic start(true);
+    std::vector<ts::SafePtr<LoadChannel>> channels(opt.channels);
+    for (size_t i = 0; i < channels.size(); ++i) {
+        channels[i] = new LoadChannel(opt, ecmgAddress, uint16_t(opt.firstChannelId + i), start, report);
+        channels[i]->start();
+    }
+
+    // Wait for all channels to complete and collect statistics.
+    LoadStatistics stats;
+    size_t established = 0;
+    for (size_t i = 0; i < channels.size(); ++i) {
+        channels[i]->waitForTermination();
+        stats.merge(channels[i]->statistics());
+        if (channels[i]->established()) {
+            established++;
+        }
+    }
+    const ts::NanoSecond elapsed = std::max<ts::NanoSecond>(1, ts::Monotonic(true) - start);
+
+    if (opt.local) {
+        stub.close();
+    }
+
+    // Final report.
+    report.info(u"channels: %'d/%'d established, streams: %'d, duration: %'d ms",
+                {established, opt.channels, established * opt.streams, elapsed / ts::NanoSecPerMilliSec});
+    report.info(u"CW_provision: %'d, ECM_response: %'d, errors: %'d, unexpected: %'d, lost: %'d",
+                {stats.requests, stats.responses, stats.errors, stats.unexpected,
+                 stats.requests - std::min(stats.requests, stats.responses + stats.errors)});
+    report.info(u"throughput: %'d ECM/s", {(ts::NanoSecPerSec * ts::NanoSecond(stats.responses)) / elapsed});
+    DisplayLatency(report, u"ECM latency", stats.ecmLatency);
+    DisplayLatency(report, u"setup latency", stats.setupLatency);
+
+    return established == opt.channels && stats.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+TS_MAIN(MainCode)
@@ -0,0 +1,158 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Build index files of transport stream files.
+//
+//----------------------------------------------------------------------------
+
+#include "tsMain.h"
+#include "tsTSFileInput.h"
+#include "tsTSPacketIndex.h"
+#include "tsNames.h"
+TSDUCK_SOURCE;
+
+// Maximum number of packets to read at a time.
+#define READ_PACKETS 1024
+
+
+//----------------------------------------------------------------------------
+//  Command line options
+//----------------------------------------------------------------------------
+
+struct Options: public ts::Args
+{
+    Options(int argc, char *argv[]);
+
+    ts::UStringVector infiles;   // Input file names
+    ts::MilliSecond   interval;  // Interval between time entries
+    bool              list;      // List index entries
+};
+
+Options::Options(int argc, char *argv[]) :
+    Args(u"Build index files of transport stream files", u"[options] filename ..."),
+    infiles(),
+    interval(0),
+    list(false)
+{
+    option(u"", 0, STRING, 1, UNLIMITED_COUNT);
+    help(u"",
+         u"Transport stream files to index. For each file, the index is written in a "
+         u"file with the same name and an additional .tsidx suffix.");
+
+    option(u"interval", 'i', POSITIVE);
+    help(u"interval",
+         u"Interval in milliseconds between two time entries in the index. "
+         u"The default is " + ts::UString::Decimal(ts::TSPacketIndex::DEFAULT_INTERVAL) + u" ms.");
+
+    option(u"list", 'l');
+    help(u"list", u"List the content of the index on standard output.");
+
+    analyze(argc, argv);
+
+    getValues(infiles);
+    interval = intValue<ts::MilliSecond>(u"interval", ts::TSPacketIndex::DEFAULT_INTERVAL);
+    list = present(u"list");
+
+    exitOnError();
+}
+
+
+//----------------------------------------------------------------------------
+//  Build the index of one file.
+//----------------------------------------------------------------------------
+
+namespace {
+    bool IndexFile(Options& opt, const ts::UString& filename)
+    {
+        ts::TSPacketIndex index(opt.interval);
+        ts::TSFileInput file;
+
+        // Read packets directly from a memory mapping of the file, when possible.
+        file.setMemoryMap(true);
+        if (!file.open(filename, 1, 0, opt)) {
+            return false;
+        }
+
+        const ts::TSPacket* pkt = nullptr;
+        size_t count = 0;
+        bool ok = true;
+        while (ok && (count = file.readMapped(pkt, READ_PACKETS, opt)) > 0) {
+            for (; ok && count > 0; ++pkt, --count) {
+                if (pkt->hasValidSync()) {
+                    index.feedPacket(*pkt);
+                }
+                else {
+                    opt.error(u"%s: synchronization lost after %'d packets", {filename, index.packetCount()});
+                    ok = false;
+                }
+            }
+        }
+        file.close(opt);
+
+        const ts::UString index_name(ts::TSPacketIndex::IndexFileName(filename));
+        ok = ok && index.save(index_name, opt);
+        if (ok) {
+            opt.verbose(u"%s: %'d packets, %'d index entries", {filename, index.packetCount(), index.entries().size()});
+        }
+
+        // List the index content.
+        if (ok && opt.list) {
+            std::cout << "Index of " << filename << std::endl
+                      << "Type  Time (ms)        Packet    PID  Table" << std::endl;
+            for (ts::TSPacketIndex::EntryVector::const_iterator it = index.entries().begin(); it != index.entries().end(); ++it) {
+                const ts::UChar* type = it->type == ts::TSPacketIndex::TIME ? u"TIME" : (it->type == ts::TSPacketIndex::RAP ? u"RAP " : u"PSI ");
+                std::cout << ts::UString::Format(u"%s  %9d  %12d  0x%04X", {type, it->time / 90, it->packet, it->pid});
+                if (it->type == ts::TSPacketIndex::PSI) {
+                    std::cout << "  " << ts::names::TID(it->table_id)
+                              << ts::UString::Format(u", id 0x%04X, version %d", {it->table_id_ext, it->version});
+                }
+                std::cout << std::endl;
+            }
+        }
+        return ok;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Program entry point
+//----------------------------------------------------------------------------
+
+int MainCode(int argc, char *argv[])
+{
+    Options opt(argc, argv);
+    bool ok = true;
+
+    for (ts::UStringVector::const_iterator it = opt.infiles.begin(); it != opt.infiles.end(); ++it) {
+        ok = IndexFile(opt, *it) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+TS_MAIN(MainCode)
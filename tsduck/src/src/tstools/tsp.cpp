@@ -35,10 +35,12 @@
 #include "tspOptions.h"
 #include "tspInputExecutor.h"
 #include "tspOutputExecutor.h"
+#include "tspOutputBranch.h"
 #include "tspProcessorExecutor.h"
 #include "tsPluginRepository.h"
 #include "tsAsyncReport.h"
 #include "tsSystemMonitor.h"
+#include "tsMetricsServer.h"
 #include "tsMonotonic.h"
 #include "tsResidentBuffer.h"
 #include "tsOutputPager.h"
@@ -93,6 +95,68 @@ void ts::tsp::TSPInterruptHandler::handleInterrupt()
 }
 
 
+//----------------------------------------------------------------------------
+//  Metrics provider for the metrics server.
+//----------------------------------------------------------------------------
+
+namespace ts {
+    namespace tsp {
+        class TSPMetrics: public MetricsProviderInterface
+        {
+        public:
+            TSPMetrics(PluginExecutor* first_plugin, const std::vector<OutputBranch*>& branches, size_t buffer_packets);
+            virtual void getMetrics(MetricsWriter& writer) override;
+        private:
+            PluginExecutor*                   _first_plugin;
+            const std::vector<OutputBranch*>& _branches;
+            const size_t                      _buffer_packets;
+
+            // Add the labels of a plugin in the chain.
+            static void SetLabels(MetricsWriter& writer, PluginThread* thread, size_t index);
+
+            // Inaccessible operations
+            TSPMetrics(const TSPMetrics&) = delete;
+            TSPMetrics& operator=(const TSPMetrics&) = delete;
+        };
+    }
+}
+
+ts::tsp::TSPMetrics::TSPMetrics(PluginExecutor* first_plugin, const std::vector<OutputBranch*>& branches, size_t buffer_packets) :
+    _first_plugin(first_plugin),
+    _branches(branches),
+    _buffer_packets(buffer_packets)
+{
+}
+
+void ts::tsp::TSPMetrics::SetLabels(MetricsWriter& writer, PluginThread* thread, size_t index)
+{
+    const PluginType type = thread->plugin()->type();
+    writer.setLabel(u"index", int64_t(index));
+    writer.setLabel(u"plugin", thread->pluginName());
+    writer.setLabel(u"type", type == INPUT_PLUGIN ? u"input" : (type == OUTPUT_PLUGIN ? u"output" : u"processor"));
+}
+
+void ts::tsp::TSPMetrics::getMetrics(MetricsWriter& writer)
+{
+    // The ring of executors and the list of additional outputs do not change while
+    // the server is active. All published statistics are read without locking.
+    writer.gauge(u"buffer_size_packets", u"Size of the global packet buffer in TS packets.", int64_t(_buffer_packets));
+
+    size_t index = 0;
+    PluginExecutor* proc = _first_plugin;
+    do {
+        SetLabels(writer, proc, index++);
+        proc->getMetrics(writer);
+    } while ((proc = proc->ringNext<PluginExecutor>()) != _first_plugin);
+
+    for (auto it = _branches.begin(); it != _branches.end(); ++it) {
+        SetLabels(writer, *it, index++);
+        (*it)->getMetrics(writer);
+    }
+    writer.clearLabels();
+}
+
+
 //----------------------------------------------------------------------------
 //  Program main code.
 //----------------------------------------------------------------------------
@@ -106,7 +170,7 @@ int MainCode(int argc, char *argv[])
     ts::tsp::Options opt(argc, argv);
     CERR.setMaxSeverity(opt.maxSeverity());
     assert(opt.inputs.size() == 1);
-    assert(opt.outputs.size() == 1);
+    assert(!opt.outputs.empty());
 
     // Get the repository of plugins.
     ts::PluginRepository* plugins = ts::PluginRepository::Instance();
@@ -160,6 +224,23 @@ int MainCode(int argc, char *argv[])
     // Check if at least one plugin prefers real-time defaults.
     bool realtime = opt.realtime == ts::TRUE || input->isRealTime() || output->isRealTime();
 
+    // Additional output plugins are executed in their own threads, outside the ring of executors.
+    // They are fed by the main output executor. Blocking outputs have the same priority as the main
+    // output since they hold the packet buffer. Dropping outputs do not and use a normal priority.
+    std::vector<ts::tsp::OutputBranch*> branches;
+    for (size_t i = 1; i < opt.outputs.size(); ++i) {
+        const bool drop = opt.drop_outputs.find(i) != opt.drop_outputs.end();
+        ts::ThreadAttributes attr;
+        if (!drop) {
+            attr.setPriority(ts::ThreadAttributes::GetHighPriority());
+        }
+        ts::tsp::OutputBranch* branch = new ts::tsp::OutputBranch(&opt, &opt.outputs[i], attr, global_mutex, drop, opt.drop_queue_pkt);
+        branch->setLogName(ts::UString::Format(u"%s[%d]", {branch->pluginName(), i + 1}));
+        branches.push_back(branch);
+        output->addBranch(branch);
+        realtime = realtime || (branch->plugin() != nullptr && branch->plugin()->isRealTime());
+    }
+
     for (auto it = opt.plugins.begin(); it != opt.plugins.end(); ++it) {
         ts::tsp::PluginExecutor* p = new ts::tsp::ProcessorExecutor(&opt, &*it, ts::ThreadAttributes(), global_mutex);
         p->ringInsertBefore(output);
@@ -194,6 +275,14 @@ int MainCode(int argc, char *argv[])
             return EXIT_FAILURE;
         }
     } while ((proc = proc->ringNext<ts::tsp::PluginExecutor>()) != input);
+    for (auto it = branches.begin(); it != branches.end(); ++it) {
+        (*it)->setReport(&report);
+        (*it)->setMaxSeverity(report.maxSeverity());
+        (*it)->setRealTimeForAll(realtime);
+        if (!(*it)->plugin()->getOptions()) {
+            return EXIT_FAILURE;
+        }
+    }
 
     // Allocate a memory-resident buffer of TS packets
     ts::ResidentBuffer<ts::TSPacket> packet_buffer(opt.bufsize / ts::PKT_SIZE);
@@ -224,6 +313,11 @@ int MainCode(int argc, char *argv[])
     if (!output->plugin()->start()) {
         return EXIT_FAILURE;
     }
+    for (auto it = branches.begin(); it != branches.end(); ++it) {
+        if (!(*it)->plugin()->start()) {
+            return EXIT_FAILURE;
+        }
+    }
 
     // Use a Ctrl+C interrupt handler
     ts::tsp::TSPInterruptHandler interrupt_handler(&report, input);
@@ -235,7 +329,18 @@ int MainCode(int argc, char *argv[])
         monitor.start();
     }
 
-    // Create all plugin executors threads.
+    // Create the metrics server if required.
+    ts::tsp::TSPMetrics metrics(input, branches, packet_buffer.count());
+    ts::MetricsServer metrics_server(&metrics, u"tsp", report);
+    if (opt.metrics_server.hasPort() && !metrics_server.open(opt.metrics_server)) {
+        return EXIT_FAILURE;
+    }
+
+    // Create all plugin executors threads. The additional output threads are
+    // started first since they must be ready when the main output feeds them.
+    for (auto it = branches.begin(); it != branches.end(); ++it) {
+        (*it)->start();
+    }
     proc = input;
     do {
         proc->start();
@@ -247,6 +352,15 @@ int MainCode(int argc, char *argv[])
         proc->waitForTermination();
     } while ((proc = proc->ringNext<ts::tsp::PluginExecutor>()) != input);
 
+    // Stop the metrics server before deallocating the plugins.
+    metrics_server.close();
+
+    // Deallocate additional outputs. Their threads were terminated by the main output executor.
+    for (auto it = branches.begin(); it != branches.end(); ++it) {
+        delete *it;
+    }
+    branches.clear();
+
     // Deallocate all plugins and plugin executor
     bool last;
     proc = input;
@@ -42,6 +42,7 @@ TSDUCK_SOURCE;
 #define DEF_MAX_FLUSH_PKT_RT    1000  // packets
 #define DEF_MAX_INPUT_PKT_OFL      0  // packets
 #define DEF_MAX_INPUT_PKT_RT    1000  // packets
+#define DEF_DROP_QUEUE_PKT     10000  // packets
 
 // Options for --list-processor.
 const ts::Enumeration ts::tsp::Options::ListProcessorEnum({
@@ -57,7 +58,7 @@ const ts::Enumeration ts::tsp::Options::ListProcessorEnum({
 //----------------------------------------------------------------------------
 
 ts::tsp::Options::Options(int argc, char *argv[]) :
-    ArgsWithPlugins(0, 1, 0, UNLIMITED_COUNT, 0, 1),
+    ArgsWithPlugins(0, 1, 0, UNLIMITED_COUNT, 0, UNLIMITED_COUNT),
     timed_log(false),
     list_proc_flags(0),
     monitor(false),
@@ -73,14 +74,17 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
     instuff_stop(0),
     bitrate(0),
     bitrate_adj(0),
-    realtime(MAYBE)
+    realtime(MAYBE),
+    drop_outputs(),
+    drop_queue_pkt(0),
+    metrics_server()
 {
     setDescription(u"MPEG transport stream processor using a chain of plugins");
 
     setSyntax(u"[tsp-options] \\\n"
               u"    [-I input-name [input-options]] \\\n"
               u"    [-P processor-name [processor-options]] ... \\\n"
-              u"    [-O output-name [output-options]]");
+              u"    [-O output-name [output-options]] ...");
 
     option(u"add-input-stuffing", 'a', STRING);
     help(u"add-input-stuffing", u"nullpkt/inpkt",
@@ -122,6 +126,23 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
          u"the buffer between the input and output devices. The default "
          u"is " TS_USTRINGIFY(DEF_BUFSIZE_MB) u" MB.");
 
+    option(u"drop-output", 0, POSITIVE, 0, UNLIMITED_COUNT);
+    help(u"drop-output", u"index",
+         u"Specify that the output plugin at the given index (starting at 1 for the "
+         u"first -O option) never slows down the processing. When this output is too "
+         u"slow, packets are dropped for this output only. By default, when several "
+         u"output plugins are specified, each output plugin receives all packets and "
+         u"the processing waits for the slowest one. The first output plugin always "
+         u"receives all packets. If a dropping output fails, it is stopped and the "
+         u"processing continues with the other outputs. The failure of any other output "
+         u"terminates the processing. Several --drop-output options may be specified.");
+
+    option(u"drop-output-packets", 0, POSITIVE);
+    help(u"drop-output-packets",
+         u"Specify the size in packets of the private buffer of each output plugin "
+         u"which is specified with --drop-output. Packets are dropped for this output "
+         u"when its buffer is full. The default is " TS_USTRINGIFY(DEF_DROP_QUEUE_PKT) u" packets.");
+
     option(u"ignore-joint-termination", 'i');
     help(u"ignore-joint-termination",
          u"Ignore all --joint-termination options in plugins. "
@@ -163,6 +184,15 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
          u"as it can, depending on the free space in the buffer. In real-time mode, "
          u"the default is " + UString::Decimal(DEF_MAX_INPUT_PKT_RT) + u" packets.");
 
+    option(u"metrics-server", 0, STRING);
+    help(u"metrics-server", u"[address:]port",
+         u"Start an HTTP server which exposes the tsp metrics in Prometheus text format "
+         u"on path /metrics. The metrics include the packet counters, buffer occupancy and "
+         u"bitrate of each plugin, as well as plugin-specific metrics such as continuity "
+         u"errors or dropped datagrams. The metrics are collected without interfering with "
+         u"the packet processing. If the IP address is omitted, the server listens on the "
+         u"loopback interface only. By default, there is no metrics server.");
+
     option(u"monitor", 'm');
     help(u"monitor",
          u"Continuously monitor the system resources which are used by tsp. "
@@ -209,6 +239,11 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
     log_msg_count = intValue<size_t>(u"log-message-count", AsyncReport::MAX_LOG_MESSAGES);
     ignore_jt = present(u"ignore-joint-termination");
     realtime = tristateValue(u"realtime");
+    drop_queue_pkt = intValue<size_t>(u"drop-output-packets", DEF_DROP_QUEUE_PKT);
+
+    if (present(u"metrics-server") && metrics_server.resolve(value(u"metrics-server"), *this) && !metrics_server.hasPort()) {
+        error(u"missing TCP port number in --metrics-server");
+    }
 
     if (present(u"add-input-stuffing") && !value(u"add-input-stuffing").scan(u"%d/%d", {&instuff_nullpkt, &instuff_inpkt})) {
         error(u"invalid value for --add-input-stuffing, use \"nullpkt/inpkt\" format");
@@ -224,6 +259,20 @@ ts::tsp::Options::Options(int argc, char *argv[]) :
         outputs.push_back(PluginOptions(OUTPUT_PLUGIN, u"file"));
     }
 
+    // Indexes of the output plugins which drop packets.
+    for (size_t n = 0; n < count(u"drop-output"); ++n) {
+        const size_t index = intValue<size_t>(u"drop-output", 0, n);
+        if (index == 1) {
+            error(u"the first output plugin cannot drop packets");
+        }
+        else if (index > outputs.size()) {
+            error(u"invalid --drop-output %d, there are only %d output plugins", {index, outputs.size()});
+        }
+        else {
+            drop_outputs.insert(index - 1);
+        }
+    }
+
     // Debug display
     if (maxSeverity() >= 2) {
         display(std::cerr);
@@ -263,9 +312,11 @@ std::ostream& ts::tsp::Options::display(std::ostream& strm, const UString& margi
          << margin << "  --bitrate-adjust-interval: " << UString::Decimal(bitrate_adj) << " milliseconds" << std::endl
          << margin << "  --buffer-size-mb: " << UString::Decimal(bufsize) << " bytes" << std::endl
          << margin << "  --debug: " << maxSeverity() << std::endl
+         << margin << "  --drop-output-packets: " << UString::Decimal(drop_queue_pkt) << std::endl
          << margin << "  --list-processors: " << list_proc_flags << std::endl
          << margin << "  --max-flushed-packets: " << UString::Decimal(max_flush_pkt) << std::endl
          << margin << "  --max-input-packets: " << UString::Decimal(max_input_pkt) << std::endl
+         << margin << "  --metrics-server: " << metrics_server << std::endl
          << margin << "  --realtime: " << UString::TristateTrueFalse(realtime) << std::endl
          << margin << "  --monitor: " << monitor << std::endl
          << margin << "  --verbose: " << verbose() << std::endl
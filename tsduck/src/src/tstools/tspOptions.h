@@ -36,6 +36,7 @@
 #include "tsArgs.h"
 #include "tsArgsWithPlugins.h"
 #include "tsDisplayInterface.h"
+#include "tsSocketAddress.h"
 
 namespace ts {
     //!
@@ -73,6 +74,9 @@ namespace ts {
             BitRate       bitrate;         //!< Fixed input bitrate.
             MilliSecond   bitrate_adj;     //!< Bitrate adjust interval.
             Tristate      realtime;        //!< Use real-time options.
+            std::set<size_t> drop_outputs; //!< Indexes in @a outputs of the output plugins which drop packets when too slow.
+            size_t        drop_queue_pkt;  //!< Size in packets of the private queue of output plugins which drop packets.
+            SocketAddress metrics_server;  //!< Local address of the HTTP metrics server, no server if the port is unset.
 
             //!
             //! Apply default values to options which were not specified on the command line.
@@ -0,0 +1,234 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor: Execution context of an additional output plugin
+//
+//----------------------------------------------------------------------------
+
+#include "tspOutputBranch.h"
+#include "tsGuardCondition.h"
+#include "tsGuard.h"
+TSDUCK_SOURCE;
+
+// Number of packets to read at a time from the private queue of a dropping branch.
+#define BRANCH_READ_PACKETS 1024
+
+
+//----------------------------------------------------------------------------
+// Constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::tsp::OutputBranch::OutputBranch(Options* options,
+                                    const PluginOptions* pl_options,
+                                    const ThreadAttributes& attributes,
+                                    Mutex& global_mutex,
+                                    bool drop,
+                                    size_t queue_size) :
+
+    JointTermination(options, pl_options, attributes, global_mutex),
+    _output(dynamic_cast<OutputPlugin*>(PluginThread::plugin())),
+    _drop(drop),
+    _queue(drop ? queue_size : 1),
+    _dropped(0),
+    _sent(0),
+    _mutex(),
+    _work(),
+    _done(),
+    _pkt(nullptr),
+    _pkt_cnt(0),
+    _terminate(false),
+    _failed(false)
+{
+}
+
+ts::tsp::OutputBranch::~OutputBranch()
+{
+    // Make sure the thread is terminated before destroying the synchronization objects.
+    waitForTermination();
+}
+
+
+//----------------------------------------------------------------------------
+// Submit packets to the output plugin of this branch.
+//----------------------------------------------------------------------------
+
+void ts::tsp::OutputBranch::submit(const TSPacket* buffer, size_t count, BitRate bitrate)
+{
+    if (count == 0 || _failed) {
+        return;
+    }
+
+    if (_drop) {
+        // Copy as many packets as possible in the private queue, drop the rest.
+        // We are the only writer, the free space can only grow, lockWriteBuffer() never blocks.
+        _queue.setBitrate(bitrate);
+        while (count > 0 && _queue.bufferSize() > _queue.currentSize()) {
+            TSPacket* wbuf = nullptr;
+            size_t wsize = 0;
+            if (!_queue.lockWriteBuffer(wbuf, wsize) || wsize == 0) {
+                break;
+            }
+            wsize = std::min(wsize, count);
+            TSPacket::Copy(wbuf, buffer, wsize);
+            _queue.releaseWriteBuffer(wsize);
+            buffer += wsize;
+            count -= wsize;
+        }
+        _dropped += count;
+        publishDroppedCount(_dropped);
+        publishBufferedCount(_queue.currentSize());
+    }
+    else {
+        // Let the branch thread send the packets directly from the packet buffer.
+        Guard lock(_mutex);
+        assert(_pkt_cnt == 0);
+        _pkt = buffer;
+        _pkt_cnt = count;
+        _tsp_bitrate = bitrate;
+        publishBitrate(bitrate);
+        _work.signal();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Wait until all packets which were submitted to a blocking branch are sent.
+//----------------------------------------------------------------------------
+
+bool ts::tsp::OutputBranch::waitCompletion()
+{
+    if (_drop) {
+        // A failed dropping branch is simply stopped, it never fails the chain.
+        return true;
+    }
+    else {
+        GuardCondition lock(_mutex, _done);
+        while (_pkt_cnt > 0 && !_failed) {
+            lock.waitCondition();
+        }
+        return !_failed;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Terminate the branch thread and stop the output plugin.
+//----------------------------------------------------------------------------
+
+void ts::tsp::OutputBranch::terminate(bool aborted)
+{
+    if (aborted) {
+        _tsp_aborting = true;
+    }
+    if (_drop) {
+        if (aborted) {
+            _queue.stop();
+        }
+        else {
+            _queue.setEOF();
+        }
+    }
+    else {
+        Guard lock(_mutex);
+        _terminate = true;
+        _work.signal();
+    }
+    waitForTermination();
+    _output->stop();
+
+    if (_dropped > 0) {
+        warning(u"%'d packets dropped, output was too slow", {_dropped});
+    }
+    debug(u"output branch terminated after %'d packets", {_sent});
+}
+
+
+//----------------------------------------------------------------------------
+// Output branch thread
+//----------------------------------------------------------------------------
+
+void ts::tsp::OutputBranch::main()
+{
+    debug(u"output branch thread started");
+
+    if (_drop) {
+        // Send packets from the private queue until end of input or abort.
+        TSPacketVector buffer(BRANCH_READ_PACKETS);
+        size_t count = 0;
+        while (!_tsp_aborting && _queue.waitPackets(buffer.data(), buffer.size(), count, _tsp_bitrate)) {
+            if (!_output->send(buffer.data(), count)) {
+                _failed = true;
+                // Stop the queue, the OutputExecutor will no longer submit packets.
+                // The rest of the processing chain continues without this output.
+                _queue.stop();
+                error(u"output failed, this dropping output is stopped, other outputs continue");
+                break;
+            }
+            _sent += count;
+            publishPacketCount(_sent);
+            publishBitrate(_tsp_bitrate);
+        }
+    }
+    else {
+        // Send packets which are directly submitted from the packet buffer.
+        for (;;) {
+            const TSPacket* pkt = nullptr;
+            size_t count = 0;
+            {
+                GuardCondition lock(_mutex, _work);
+                while (_pkt_cnt == 0 && !_terminate) {
+                    lock.waitCondition();
+                }
+                if (_pkt_cnt == 0) {
+                    break; // terminated
+                }
+                pkt = _pkt;
+                count = _pkt_cnt;
+            }
+
+            // Send packets outside the mutex.
+            const bool ok = _output->send(pkt, count);
+            if (ok) {
+                _sent += count;
+                publishPacketCount(_sent);
+            }
+
+            // Signal completion.
+            GuardCondition lock(_mutex, _done);
+            _pkt_cnt = 0;
+            _failed = !ok;
+            lock.signal();
+            if (!ok) {
+                break;
+            }
+        }
+    }
+
+    debug(u"output branch thread %s", {_failed ? u"failed" : u"terminated"});
+}
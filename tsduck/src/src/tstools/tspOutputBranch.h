@@ -0,0 +1,158 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream processor: Execution context of an additional output plugin
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tspJointTermination.h"
+#include "tsTSPacketQueue.h"
+#include "tsCondition.h"
+#include "tsMutex.h"
+
+namespace ts {
+    namespace tsp {
+        //!
+        //! Execution context of an additional tsp output plugin.
+        //!
+        //! When several output plugins are specified, the first one is executed by the
+        //! ts::tsp::OutputExecutor in the ring of plugin executors. Each additional output
+        //! plugin is executed by an OutputBranch in its own thread. The OutputExecutor
+        //! submits each contiguous range of packets to all branches.
+        //!
+        //! A blocking branch directly reads the packets from the global packet buffer.
+        //! The OutputExecutor waits for the completion of all blocking branches before
+        //! passing the packets back to the input plugin.
+        //!
+        //! A dropping branch copies the packets in a private queue and never blocks
+        //! the OutputExecutor. When the queue is full, the packets are dropped for this
+        //! output only.
+        //!
+        //! @ingroup plugin
+        //!
+        class OutputBranch: public JointTermination
+        {
+        public:
+            //!
+            //! Constructor.
+            //! @param [in,out] options Command line options for tsp.
+            //! @param [in] pl_options Command line options for this plugin.
+            //! @param [in] attributes Creation attributes for the thread executing this plugin.
+            //! @param [in,out] global_mutex Global mutex to synchronize access to the packet buffer.
+            //! @param [in] drop If true, drop packets when this output is too slow.
+            //! If false, the processing of the whole chain waits for this output.
+            //! @param [in] queue_size Size in packets of the private queue of a dropping branch.
+            //!
+            OutputBranch(Options* options,
+                         const PluginOptions* pl_options,
+                         const ThreadAttributes& attributes,
+                         Mutex& global_mutex,
+                         bool drop,
+                         size_t queue_size);
+
+            //!
+            //! Destructor.
+            //!
+            virtual ~OutputBranch() override;
+
+            //!
+            //! Access the shared library API.
+            //! @return Address of the plugin interface.
+            //!
+            OutputPlugin* plugin() {return _output;}
+
+            //!
+            //! Inform if all plugins should use defaults for real-time.
+            //! @param [in] on True if all plugins should use defaults for real-time.
+            //!
+            void setRealTimeForAll(bool on) {_use_realtime = on;}
+
+            //!
+            //! Check if this branch drops packets when it is too slow.
+            //! @return True if this branch drops packets, false if it blocks.
+            //!
+            bool isDropping() const {return _drop;}
+
+            //!
+            //! Submit packets to the output plugin of this branch.
+            //! Invoked from the OutputExecutor thread. Never blocks. With a blocking branch,
+            //! the packets must remain unmodified until waitCompletion() returns.
+            //! @param [in] buffer Address of contiguous packets to send.
+            //! @param [in] count Number of packets to send.
+            //! @param [in] bitrate Current bitrate of the stream.
+            //!
+            void submit(const TSPacket* buffer, size_t count, BitRate bitrate);
+
+            //!
+            //! Wait until all packets which were submitted to a blocking branch are sent.
+            //! Return immediately on a dropping branch.
+            //! @return True on success, false if the output plugin of a blocking branch
+            //! has failed. Always true on a dropping branch: a failed dropping branch
+            //! is stopped without failing the processing chain.
+            //!
+            bool waitCompletion();
+
+            //!
+            //! Terminate the branch thread, wait for its completion and stop the output plugin.
+            //! @param [in] aborted If true, the processing is aborted, pending packets are not sent.
+            //!
+            void terminate(bool aborted);
+
+            //!
+            //! Get the number of packets which were dropped because this output was too slow.
+            //! @return The number of dropped packets.
+            //!
+            PacketCounter droppedPackets() const {return _dropped;}
+
+        private:
+            OutputPlugin*   _output;
+            const bool      _drop;      // Drop packets when this output is too slow.
+            TSPacketQueue   _queue;     // Private packet queue of a dropping branch.
+            PacketCounter   _dropped;   // Number of packets dropped for this output.
+            PacketCounter   _sent;      // Number of packets sent on this output.
+            Mutex           _mutex;     // Protect the following fields.
+            Condition       _work;      // Signaled when packets are submitted or at termination.
+            Condition       _done;      // Signaled when submitted packets are sent.
+            const TSPacket* _pkt;       // Submitted packets (blocking branch).
+            size_t          _pkt_cnt;   // Number of submitted packets (blocking branch).
+            bool            _terminate; // Branch thread shall terminate.
+            volatile bool   _failed;    // The output plugin has failed.
+
+            // Inherited from Thread
+            virtual void main() override;
+
+            // Inaccessible operations
+            OutputBranch() = delete;
+            OutputBranch(const OutputBranch&) = delete;
+            OutputBranch& operator=(const OutputBranch&) = delete;
+        };
+    }
+}
@@ -45,7 +45,8 @@ ts::tsp::OutputExecutor::OutputExecutor(Options* options,
                                         Mutex& global_mutex) :
 
     PluginExecutor(options, pl_options, attributes, global_mutex),
-    _output(dynamic_cast<OutputPlugin*>(PluginThread::plugin()))
+    _output(dynamic_cast<OutputPlugin*>(PluginThread::plugin())),
+    _branches()
 {
 }
 
@@ -105,8 +106,17 @@ void ts::tsp::OutputExecutor::main()
             for (out_cnt = 0; out_cnt < pkt_remain && pkt[out_cnt].b[0] != 0; out_cnt++) {}
 
             // Output a contiguous range of non-dropped packets.
+            // The additional outputs, if any, send the same packets in parallel.
+            // We must wait for all blocking outputs before releasing the packets.
             if (out_cnt > 0) {
-                if (!_output->send(pkt, out_cnt)) {
+                for (auto it = _branches.begin(); it != _branches.end(); ++it) {
+                    (*it)->submit(pkt, out_cnt, _tsp_bitrate);
+                }
+                bool ok = _output->send(pkt, out_cnt);
+                for (auto it = _branches.begin(); it != _branches.end(); ++it) {
+                    ok = (*it)->waitCompletion() && ok;
+                }
+                if (!ok) {
                     aborted = true;
                     break;
                 }
@@ -123,8 +133,11 @@ void ts::tsp::OutputExecutor::main()
 
     } while (!aborted);
 
-    // Close the output processor
+    // Close the output processor and all additional outputs.
     _output->stop();
+    for (auto it = _branches.begin(); it != _branches.end(); ++it) {
+        (*it)->terminate(_tsp_aborting);
+    }
 
     debug(u"output thread %s after %'d packets (%'d output)", {aborted ? u"aborted" : u"terminated", totalPackets(), output_packets});
 }
@@ -34,6 +34,7 @@
 
 #pragma once
 #include "tspPluginExecutor.h"
+#include "tspOutputBranch.h"
 
 namespace ts {
     namespace tsp {
@@ -63,8 +64,17 @@ namespace ts {
             //!
             OutputPlugin* plugin() {return _output;}
 
+            //!
+            //! Add an additional output plugin which receives the same packets.
+            //! Must be invoked before starting the executor thread.
+            //! @param [in] branch Execution context of the additional output plugin.
+            //! The branch thread is terminated by this executor at the end of the processing.
+            //!
+            void addBranch(OutputBranch* branch) {_branches.push_back(branch);}
+
         private:
             OutputPlugin* _output;
+            std::vector<OutputBranch*> _branches;  // Additional output plugins.
 
             // Inherited from Thread
             virtual void main() override;
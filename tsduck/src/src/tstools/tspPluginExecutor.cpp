@@ -118,6 +118,17 @@ bool ts::tsp::PluginExecutor::passPackets(size_t count,     // of packets to pas
     next->_input_end = next->_input_end || input_end;
     next->_bitrate = bitrate;
 
+    // Publish statistics for the metrics server. The packet area of the input
+    // plugin contains free packets, not packets which are buffered for it.
+    publishPacketCount(totalPackets());
+    publishBitrate(_tsp_bitrate);
+    if (plugin()->type() != INPUT_PLUGIN) {
+        publishBufferedCount(_pkt_cnt);
+    }
+    if (next->plugin()->type() != INPUT_PLUGIN) {
+        next->publishBufferedCount(next->_pkt_cnt);
+    }
+
     // Wake the next processor when there is some data
     if (count > 0 || input_end) {
         next->_to_do.signal();
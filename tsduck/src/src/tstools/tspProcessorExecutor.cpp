@@ -164,6 +164,7 @@ void ts::tsp::ProcessorExecutor::main()
             // too long before two output operations.
 
             if (flush_request || pkt_done == pkt_cnt || (_options->max_flush_pkt > 0 && pkt_flush % _options->max_flush_pkt == 0)) {
+                publishDroppedCount(dropped_packets);
                 aborted = !passPackets(pkt_flush, output_bitrate, pkt_done == pkt_cnt && input_end, aborted);
                 pkt_flush = 0;
             }
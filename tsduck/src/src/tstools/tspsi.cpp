@@ -32,10 +32,13 @@
 //----------------------------------------------------------------------------
 
 #include "tsMain.h"
-#include "tsInputRedirector.h"
+#include "tsTSFileInput.h"
 #include "tsPSILogger.h"
 TSDUCK_SOURCE;
 
+// Maximum number of packets to read at a time.
+#define READ_PACKETS 1024
+
 // With static link, enforce a reference to MPEG/DVB structures.
 #if defined(TSDUCK_STATIC_LIBRARY)
 #include "tsStaticReferencesDVB.h"
@@ -85,15 +88,31 @@ Options::Options(int argc, char *argv[]) :
 int MainCode(int argc, char *argv[])
 {
     Options opt(argc, argv);
-    ts::InputRedirector input(opt.infile, opt);
+    ts::TSFileInput file;
     ts::TablesDisplay display(opt.display, opt);
     ts::PSILogger logger(opt.logger, display, opt);
-    ts::TSPacket pkt;
+
+    // Read packets directly from a memory mapping of the file, when possible.
+    file.setMemoryMap(true);
+    if (!file.open(opt.infile, 1, 0, opt)) {
+        return EXIT_FAILURE;
+    }
 
     // Read all packets in the file and pass them to the logger
-    while (!logger.completed() && pkt.read(std::cin, true, opt)) {
-        logger.feedPacket(pkt);
+    const ts::TSPacket* pkt = nullptr;
+    size_t count = 0;
+    bool sync = true;
+    while (sync && !logger.completed() && (count = file.readMapped(pkt, READ_PACKETS, opt)) > 0) {
+        for (; sync && !logger.completed() && count > 0; ++pkt, --count) {
+            if ((sync = pkt->hasValidSync())) {
+                logger.feedPacket(*pkt);
+            }
+            else {
+                opt.error(u"synchronization lost after %'d packets, got 0x%X instead of 0x%X at start of TS packet", {file.getPacketCount() - count, pkt->b[0], ts::SYNC_BYTE});
+            }
+        }
     }
+    file.close(opt);
 
     // Report errors
     if (opt.verbose()) {
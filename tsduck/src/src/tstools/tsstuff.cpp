@@ -430,7 +430,8 @@ void Stuffer::evaluateNextStuffing()
 
 void Stuffer::stuff()
 {
-    // Open input file
+    // Open input file, read through a memory mapping when possible.
+    _input.setMemoryMap(true);
     if (!_input.open(_opt.input_file, 1, 0, _opt)) {
         fatalError();
     }
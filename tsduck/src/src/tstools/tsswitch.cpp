@@ -57,6 +57,7 @@
 #include "tsswitchCommandListener.h"
 #include "tsPluginRepository.h"
 #include "tsSystemMonitor.h"
+#include "tsMetricsServer.h"
 #include "tsAsyncReport.h"
 #include "tsCerrReport.h"
 TSDUCK_SOURCE;
@@ -102,6 +103,12 @@ int MainCode(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    // If a metrics server is specified, start an HTTP server thread.
+    ts::MetricsServer metricsServer(&core, u"tsswitch", log);
+    if (opt.metricsServer.hasPort() && !metricsServer.open(opt.metricsServer)) {
+        return EXIT_FAILURE;
+    }
+
     // Start the processing.
     if (!core.start()) {
         return EXIT_FAILURE;
@@ -109,6 +116,7 @@ int MainCode(int argc, char *argv[])
 
     // Wait for completion.
     core.waitForTermination();
+    metricsServer.close();
     return EXIT_SUCCESS;
 }
 
@@ -49,6 +49,7 @@ ts::tsswitch::Core::Core(Options& opt, Report& log) :
     _curPlugin(_opt.firstInput),
     _curCycle(0),
     _terminate(false),
+    _curPluginMetric(_opt.firstInput),
     _actions(),
     _events()
 {
@@ -101,6 +102,7 @@ bool ts::tsswitch::Core::start()
     // Start with the designated first input plugin.
     assert(_opt.firstInput < _inputs.size());
     _curPlugin = _opt.firstInput;
+    _curPluginMetric = _curPlugin;
 
     // Start all input threads (but do not open the input "devices").
     bool success = true;
@@ -400,6 +402,7 @@ void ts::tsswitch::Core::execute(const Action& event)
             }
             case SET_CURRENT: {
                 _curPlugin = action.index;
+                _curPluginMetric = _curPlugin;
                 break;
             }
             case WAIT_STARTED:
@@ -618,3 +621,28 @@ void ts::tsswitch::Core::waitForTermination()
         _inputs[i]->waitForTermination();
     }
 }
+
+
+//----------------------------------------------------------------------------
+// Collect the metrics of tsswitch and all its plugins.
+//----------------------------------------------------------------------------
+
+void ts::tsswitch::Core::getMetrics(MetricsWriter& writer)
+{
+    // The plugin executors are never modified while tsswitch is running.
+    // All published statistics are read without locking.
+    writer.gauge(u"current_input", u"Index of the current input plugin.", int64_t(_curPluginMetric.load()));
+
+    for (size_t i = 0; i < _inputs.size(); ++i) {
+        writer.setLabel(u"index", int64_t(i));
+        writer.setLabel(u"plugin", _inputs[i]->pluginName());
+        writer.setLabel(u"type", u"input");
+        _inputs[i]->getMetrics(writer);
+    }
+
+    writer.clearLabels();
+    writer.setLabel(u"plugin", _output.pluginName());
+    writer.setLabel(u"type", u"output");
+    _output.getMetrics(writer);
+    writer.clearLabels();
+}
@@ -39,6 +39,8 @@
 #include "tsMutex.h"
 #include "tsCondition.h"
 #include "tsWatchDog.h"
+#include "tsMetricsProviderInterface.h"
+#include <atomic>
 
 namespace ts {
     //!
@@ -49,7 +51,7 @@ namespace ts {
         //! Input switch (tsswitch) core engine.
         //! @ingroup plugin
         //!
-        class Core: private WatchDogHandlerInterface
+        class Core: public MetricsProviderInterface, private WatchDogHandlerInterface
         {
         public:
             //!
@@ -139,6 +141,13 @@ namespace ts {
             //!
             bool outputSent(size_t pluginIndex, size_t count);
 
+            //!
+            //! Collect the metrics of tsswitch and all its plugins.
+            //! Invoked in the context of the metrics server thread, without locking.
+            //! @param [in,out] writer The metrics writer where the metrics are added.
+            //!
+            virtual void getMetrics(MetricsWriter& writer) override;
+
         private:
             // Upon reception of an event (end of input, remote command, etc), there
             // is a list of actions to execute which depends on the switch policy.
@@ -191,6 +200,7 @@ namespace ts {
             size_t              _curPlugin;       // Index of current input plugin.
             size_t              _curCycle;        // Current input cycle number.
             volatile bool       _terminate;       // Terminate complete processing.
+            std::atomic<size_t> _curPluginMetric; // Copy of _curPlugin for the metrics server.
             ActionQueue         _actions;         // Sequential queue list of actions to execute.
             ActionSet           _events;          // Pending events, waiting to be cleared.
 
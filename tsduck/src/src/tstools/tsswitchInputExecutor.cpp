@@ -148,6 +148,7 @@ void ts::tsswitch::InputExecutor::freeOutput(size_t count)
     _outFirst = (_outFirst + count) % _buffer.size();
     _outCount -= count;
     _outputInUse = false;
+    publishBufferedCount(_outCount);
     lock.signal();
 }
 
@@ -160,6 +161,10 @@ void ts::tsswitch::InputExecutor::main()
 {
     debug(u"input thread started");
 
+    // Cumulated statistics over all input sessions.
+    PacketCounter totalPackets = 0;
+    PacketCounter droppedPackets = 0;
+
     // Main loop. Each iteration is a complete input session.
     for (;;) {
 
@@ -221,6 +226,8 @@ void ts::tsswitch::InputExecutor::main()
                         assert(freeCount <= _outCount);
                         _outFirst = (_outFirst + freeCount) % _buffer.size();
                         _outCount -= freeCount;
+                        droppedPackets += freeCount;
+                        publishDroppedCount(droppedPackets);
                     }
                 }
                 // Exit input when termination is requested.
@@ -247,7 +254,10 @@ void ts::tsswitch::InputExecutor::main()
             {
                 Guard lock(_mutex);
                 _outCount += inCount;
+                publishBufferedCount(_outCount);
             }
+            totalPackets += inCount;
+            publishPacketCount(totalPackets);
             _core.inputReceived(_pluginIndex);
         }
 
@@ -263,6 +273,7 @@ void ts::tsswitch::InputExecutor::main()
             // And reset the output part of the buffer.
             _outFirst = 0;
             _outCount = 0;
+            publishBufferedCount(0);
         }
 
         // End of input session.
@@ -60,6 +60,7 @@ ts::tsswitch::Options::Options(int argc, char *argv[]) :
     sockBuffer(0),
     remoteServer(),
     allowedRemote(),
+    metricsServer(),
     receiveTimeout(0)
 {
     setDescription(u"TS input source switch using remote control");
@@ -129,6 +130,14 @@ ts::tsswitch::Options::Options(int argc, char *argv[]) :
          u"Specify the maximum number of TS packets to write at a time. "
          u"The default is " + UString::Decimal(DEFAULT_MAX_OUTPUT_PACKETS) + u" packets.");
 
+    option(u"metrics-server", 0, STRING);
+    help(u"metrics-server", u"[address:]port",
+         u"Start an HTTP server which exposes the tsswitch metrics in Prometheus text format "
+         u"on path /metrics. The metrics include the current input and the packet counters "
+         u"and buffer occupancy of each plugin, as well as plugin-specific metrics. If the IP "
+         u"address is omitted, the server listens on the loopback interface only. "
+         u"By default, there is no metrics server.");
+
     option(u"monitor", 'm');
     help(u"monitor",
          u"Continuously monitor the system resources which are used by tsswitch. "
@@ -226,6 +235,11 @@ ts::tsswitch::Options::Options(int argc, char *argv[]) :
         error(u"missing UDP port number in --remote");
     }
 
+    // Resolve metrics server address.
+    if (present(u"metrics-server") && metricsServer.resolve(value(u"metrics-server"), *this) && !metricsServer.hasPort()) {
+        error(u"missing TCP port number in --metrics-server");
+    }
+
     // Resolve all allowed remote.
     UStringVector remotes;
     getValues(remotes, u"allow");
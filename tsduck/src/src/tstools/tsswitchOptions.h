@@ -65,6 +65,7 @@ namespace ts {
             size_t        sockBuffer;        //!< Socket buffer size.
             SocketAddress remoteServer;      //!< UDP server addres for remote control.
             IPAddressSet  allowedRemote;     //!< Set of allowed remotes.
+            SocketAddress metricsServer;     //!< Local address of the HTTP metrics server.
             MilliSecond   receiveTimeout;    //!< Receive timeout before switch (0=none).
 
             //!
@@ -63,6 +63,7 @@ void ts::tsswitch::OutputExecutor::main()
     size_t pluginIndex = 0;
     TSPacket* first = nullptr;
     size_t count = 0;
+    PacketCounter totalPackets = 0;
 
     // Loop until there are packets to output.
     while (!_terminate && _core.getOutputArea(pluginIndex, first, count)) {
@@ -71,6 +72,10 @@ void ts::tsswitch::OutputExecutor::main()
 
             // Output the packets.
             const bool success = _output->send(first, count);
+            if (success) {
+                totalPackets += count;
+                publishPacketCount(totalPackets);
+            }
 
             // Signal to the input plugin that the buffer can be reused..
             _core.outputSent(pluginIndex, count);
@@ -0,0 +1,278 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::BitrateTimeSeries
+//
+//----------------------------------------------------------------------------
+
+#include "tsBitrateTimeSeries.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class BitrateTimeSeriesTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testResolutions();
+    void testMaxSeries();
+    void testGap();
+    void testLongGap();
+    void testLateSeries();
+
+    CPPUNIT_TEST_SUITE(BitrateTimeSeriesTest);
+    CPPUNIT_TEST(testResolutions);
+    CPPUNIT_TEST(testMaxSeries);
+    CPPUNIT_TEST(testGap);
+    CPPUNIT_TEST(testLongGap);
+    CPPUNIT_TEST(testLateSeries);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    static void Feed(ts::BitrateTimeSeries& series, ts::PID pid, size_t count, ts::MilliSecond time);
+    static std::string CSV(const ts::BitrateTimeSeries& series);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BitrateTimeSeriesTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void BitrateTimeSeriesTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void BitrateTimeSeriesTest::tearDown()
+{
+}
+
+// Feed count packets in one PID at a given time.
+void BitrateTimeSeriesTest::Feed(ts::BitrateTimeSeries& series, ts::PID pid, size_t count, ts::MilliSecond time)
+{
+    ts::TSPacket pkt;
+    pkt = ts::NullPacket;
+    pkt.setPID(pid);
+    for (size_t i = 0; i < count; ++i) {
+        series.feedPacket(pkt, time);
+    }
+}
+
+
+// Export a time series in CSV format.
+std::string BitrateTimeSeriesTest::CSV(const ts::BitrateTimeSeries& series)
+{
+    std::ostringstream strm;
+    series.reportCSV(strm);
+    return strm.str();
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void BitrateTimeSeriesTest::testResolutions()
+{
+    ts::BitrateTimeSeries series(4, 10, 5, 3);
+    CPPUNIT_ASSERT(series.addPID(100));
+    ts::PIDSet pids;
+    pids.set(100);
+    pids.set(101);
+    CPPUNIT_ASSERT(series.setService(1, pids));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), series.seriesCount());
+
+    // In second s: s+1 packets in PID 100, 2 packets in PID 101, 1 packet in PID 200.
+    for (ts::MilliSecond s = 0; s < 120; ++s) {
+        Feed(series, 100, size_t(s + 1), s * 1000);
+        Feed(series, 101, 2, s * 1000 + 500);
+        Feed(series, 200, 1, s * 1000 + 999);
+    }
+    CPPUNIT_ASSERT(series.advance(120000));
+    CPPUNIT_ASSERT(!series.advance(120500));
+
+    CPPUNIT_ASSERT(series.hasPID(100));
+    CPPUNIT_ASSERT(!series.hasPID(101));
+    CPPUNIT_ASSERT(!series.hasPID(200));
+    CPPUNIT_ASSERT_EQUAL(size_t(10), series.bucketCount(ts::BitrateTimeSeries::SECONDS));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), series.bucketCount(ts::BitrateTimeSeries::MINUTES));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), series.bucketCount(ts::BitrateTimeSeries::HOURS));
+
+    // Last second and last 10 seconds.
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(120 * 1504), series.pidBitrate(100));
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(1155 * 1504 / 10), series.pidBitrate(100, ts::BitrateTimeSeries::SECONDS, 10));
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(122 * 1504), series.serviceBitrate(1));
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(123 * 1504), series.tsBitrate());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(0), series.pidBitrate(200));
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(0), series.serviceBitrate(2));
+
+    // Minutes, with min and max one-second bitrates.
+    std::vector<ts::BitrateTimeSeries::Bucket> buckets;
+    CPPUNIT_ASSERT(series.getPIDBuckets(buckets, 100, ts::BitrateTimeSeries::MINUTES));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), buckets.size());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(30 * 1504 + 752), buckets[0].bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(1504), buckets[0].min_bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(60 * 1504), buckets[0].max_bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(90 * 1504 + 752), buckets[1].bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(61 * 1504), buckets[1].min_bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(120 * 1504), buckets[1].max_bitrate);
+
+    // Seconds, from oldest to newest.
+    CPPUNIT_ASSERT(series.getPIDBuckets(buckets, 100, ts::BitrateTimeSeries::SECONDS));
+    CPPUNIT_ASSERT_EQUAL(size_t(10), buckets.size());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(111 * 1504), buckets[0].bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(120 * 1504), buckets[9].bitrate);
+
+    // Export: header + 10 seconds + 2 minutes, 3 series each.
+    std::ostringstream strm;
+    series.reportCSV(strm);
+    const std::string csv(strm.str());
+    CPPUNIT_ASSERT_EQUAL(size_t(1 + 12 * 3), size_t(std::count(csv.begin(), csv.end(), '\n')));
+    const ts::json::ValuePtr json(series.toJSON());
+    CPPUNIT_ASSERT_EQUAL(size_t(3), json->value(u"minutes").value(u"series").size());
+    CPPUNIT_ASSERT_EQUAL(int64_t(61 * 1504), json->value(u"minutes").value(u"series").at(1).value(u"min-bitrate").at(1).toInteger());
+}
+
+void BitrateTimeSeriesTest::testMaxSeries()
+{
+    ts::BitrateTimeSeries series(2, 10, 5, 3);
+    series.setAutoPIDs(true);
+    Feed(series, 10, 1, 0);
+    Feed(series, 11, 1, 0);
+    Feed(series, 12, 1, 0);
+    CPPUNIT_ASSERT(series.hasPID(10));
+    CPPUNIT_ASSERT(series.hasPID(11));
+    CPPUNIT_ASSERT(!series.hasPID(12));
+    CPPUNIT_ASSERT(!series.addPID(13));
+    CPPUNIT_ASSERT(!series.setService(1, ts::AllPIDs));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), series.seriesCount());
+
+    series.reset();
+    CPPUNIT_ASSERT_EQUAL(size_t(0), series.seriesCount());
+    CPPUNIT_ASSERT(!series.hasPID(10));
+    CPPUNIT_ASSERT(series.addPID(13));
+}
+
+void BitrateTimeSeriesTest::testGap()
+{
+    ts::BitrateTimeSeries series(2, 10, 5, 3);
+    series.addPID(100);
+    Feed(series, 100, 10, 0);
+    Feed(series, 100, 10, 5500);
+    CPPUNIT_ASSERT(series.advance(6000));
+
+    std::vector<ts::BitrateTimeSeries::Bucket> buckets;
+    CPPUNIT_ASSERT(series.getPIDBuckets(buckets, 100, ts::BitrateTimeSeries::SECONDS));
+    CPPUNIT_ASSERT_EQUAL(size_t(6), buckets.size());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(10 * 1504), buckets[0].bitrate);
+    for (size_t i = 1; i < 5; ++i) {
+        CPPUNIT_ASSERT_EQUAL(ts::BitRate(0), buckets[i].bitrate);
+    }
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(10 * 1504), buckets[5].bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(20 * 1504 / 6), series.pidBitrate(100, ts::BitrateTimeSeries::SECONDS, 6));
+}
+
+void BitrateTimeSeriesTest::testLongGap()
+{
+    // Same packets in two series, one advances one second at a time, the other one jumps.
+    const ts::Time start(2018, 1, 1, 0, 0);
+    ts::BitrateTimeSeries step(2, 10, 5, 3);
+    ts::BitrateTimeSeries jump(2, 10, 5, 3);
+    step.reset(start);
+    jump.reset(start);
+    step.addPID(100);
+    jump.addPID(100);
+
+    // Partial minute and hour before the gap, then partial minute after a gap of more than 3 hours.
+    const ts::MilliSecond resume = 3 * ts::MilliSecPerHour + 17 * ts::MilliSecPerMin + 42 * ts::MilliSecPerSec;
+    for (ts::MilliSecond s = 0; s < 90; ++s) {
+        Feed(step, 100, size_t(s % 7 + 1), s * 1000);
+        Feed(jump, 100, size_t(s % 7 + 1), s * 1000);
+        Feed(step, 101, 3, s * 1000 + 500);
+        Feed(jump, 101, 3, s * 1000 + 500);
+    }
+    for (ts::MilliSecond t = 90000; t <= resume; t += 1000) {
+        step.advance(t);
+    }
+    CPPUNIT_ASSERT(jump.advance(resume));
+    for (ts::MilliSecond s = 0; s < 30; ++s) {
+        Feed(step, 100, size_t(s + 1), resume + s * 1000);
+        Feed(jump, 100, size_t(s + 1), resume + s * 1000);
+    }
+    step.advance(resume + 30000);
+    jump.advance(resume + 30000);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(3), jump.bucketCount(ts::BitrateTimeSeries::HOURS));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), jump.bucketCount(ts::BitrateTimeSeries::MINUTES));
+    CPPUNIT_ASSERT_EQUAL(size_t(10), jump.bucketCount(ts::BitrateTimeSeries::SECONDS));
+    CPPUNIT_ASSERT_EQUAL(CSV(step), CSV(jump));
+}
+
+void BitrateTimeSeriesTest::testLateSeries()
+{
+    ts::BitrateTimeSeries series(3, 10, 5, 3);
+    Feed(series, 100, 10, 0);
+    Feed(series, 100, 10, 1000);
+
+    // Added in the middle of second 1, recorded from second 2.
+    CPPUNIT_ASSERT(series.addPID(100));
+    Feed(series, 100, 10, 1500);
+    Feed(series, 100, 20, 2000);
+    CPPUNIT_ASSERT(series.advance(3000));
+
+    std::vector<ts::BitrateTimeSeries::Bucket> buckets;
+    CPPUNIT_ASSERT(series.getPIDBuckets(buckets, 100, ts::BitrateTimeSeries::SECONDS));
+    CPPUNIT_ASSERT_EQUAL(size_t(3), buckets.size());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(0), buckets[0].bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(0), buckets[1].bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(20 * 1504), buckets[2].bitrate);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(20 * 1504), series.tsBitrate(ts::BitrateTimeSeries::SECONDS, 1));
+
+    // Added at the start of a second, before any packet of that second, recorded immediately.
+    CPPUNIT_ASSERT(series.addPID(200));
+    Feed(series, 200, 5, 3000);
+    CPPUNIT_ASSERT(series.advance(4000));
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(5 * 1504), series.pidBitrate(200));
+
+    // Automatically added PID's are recorded from their first packet.
+    series.setAutoPIDs(true);
+    Feed(series, 100, 1, 4000);
+    Feed(series, 300, 7, 4500);
+    CPPUNIT_ASSERT(series.advance(5000));
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(7 * 1504), series.pidBitrate(300));
+}
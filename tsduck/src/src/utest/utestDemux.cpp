@@ -91,6 +91,7 @@ public:
     void testTDT();
     void testTOT();
     void testHEVC();
+    void testSyncLost();
 
     CPPUNIT_TEST_SUITE(DemuxTest);
     CPPUNIT_TEST(testPAT);
@@ -104,6 +105,7 @@ public:
     CPPUNIT_TEST(testTDT);
     CPPUNIT_TEST(testTOT);
     CPPUNIT_TEST(testHEVC);
+    CPPUNIT_TEST(testSyncLost);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -486,3 +488,27 @@ void DemuxTest::testHEVC()
 {
     TEST_TABLE("PMT with HEVC descriptor", pmt_hevc);
 }
+
+void DemuxTest::testSyncLost()
+{
+    // A table in several packets with contiguous continuity counters.
+    const ts::TSPacket* pkt = reinterpret_cast<const ts::TSPacket*>(psi_bat_cplus_packets);
+    const size_t count = sizeof(psi_bat_cplus_packets) / ts::PKT_SIZE;
+    CPPUNIT_ASSERT(count > 1);
+
+    ts::StandaloneTableDemux demux1(ts::AllPIDs);
+    for (size_t i = 0; i < count; ++i) {
+        demux1.feedPacket(pkt[i]);
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(1), demux1.tableCount());
+
+    // After a declared loss of synchronization, the partial section is dropped,
+    // even if the continuity counters look correct.
+    ts::StandaloneTableDemux demux2(ts::AllPIDs);
+    demux2.feedPacket(pkt[0]);
+    demux2.syncLost();
+    for (size_t i = 1; i < count; ++i) {
+        demux2.feedPacket(pkt[i]);
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(0), demux2.tableCount());
+}
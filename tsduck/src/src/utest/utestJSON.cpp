@@ -115,6 +115,8 @@ void JsonTest::testSimple()
         u"  }\n"
         u"]",
         jv->printed());
+
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"[true,{\"ab\": 67,\"foo\": \"bar\"}]", jv->oneLiner());
 }
 
 void JsonTest::testGitHub()
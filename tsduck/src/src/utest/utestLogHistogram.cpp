@@ -0,0 +1,147 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::LogHistogram
+//
+//----------------------------------------------------------------------------
+
+#include "tsLogHistogram.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class LogHistogramTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testBuckets();
+    void testStatistics();
+    void testMerge();
+
+    CPPUNIT_TEST_SUITE(LogHistogramTest);
+    CPPUNIT_TEST(testBuckets);
+    CPPUNIT_TEST(testStatistics);
+    CPPUNIT_TEST(testMerge);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LogHistogramTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void LogHistogramTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void LogHistogramTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void LogHistogramTest::testBuckets()
+{
+    // Small values are exact.
+    for (uint64_t v = 0; v < 16; ++v) {
+        CPPUNIT_ASSERT_EQUAL(size_t(v), ts::LogHistogram::BucketIndex(v));
+        CPPUNIT_ASSERT_EQUAL(v, ts::LogHistogram::BucketLowerBound(size_t(v)));
+        CPPUNIT_ASSERT_EQUAL(v, ts::LogHistogram::BucketUpperBound(size_t(v)));
+    }
+
+    // Buckets are contiguous and each value is within the bounds of its bucket.
+    for (size_t i = 1; i < ts::LogHistogram::BUCKET_COUNT; ++i) {
+        CPPUNIT_ASSERT_EQUAL(ts::LogHistogram::BucketUpperBound(i - 1) + 1, ts::LogHistogram::BucketLowerBound(i));
+        CPPUNIT_ASSERT_EQUAL(i, ts::LogHistogram::BucketIndex(ts::LogHistogram::BucketLowerBound(i)));
+        CPPUNIT_ASSERT_EQUAL(i, ts::LogHistogram::BucketIndex(ts::LogHistogram::BucketUpperBound(i)));
+    }
+
+    CPPUNIT_ASSERT_EQUAL(size_t(16), ts::LogHistogram::BucketIndex(16));
+    CPPUNIT_ASSERT_EQUAL(size_t(32), ts::LogHistogram::BucketIndex(32));
+    CPPUNIT_ASSERT_EQUAL(size_t(32), ts::LogHistogram::BucketIndex(33));
+    CPPUNIT_ASSERT_EQUAL(ts::LogHistogram::BUCKET_COUNT - 1, ts::LogHistogram::BucketIndex(TS_UCONST64(0xFFFFFFFFFFFFFFFF)));
+    CPPUNIT_ASSERT_EQUAL(TS_UCONST64(0xFFFFFFFFFFFFFFFF), ts::LogHistogram::BucketUpperBound(ts::LogHistogram::BUCKET_COUNT - 1));
+}
+
+void LogHistogramTest::testStatistics()
+{
+    ts::LogHistogram h;
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), h.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), h.percentile(50.0));
+
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        h.add(v);
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1000), h.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), h.minimum());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1000), h.maximum());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(500.5, h.mean(), 0.001);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), h.percentile(0.0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1000), h.percentile(100.0));
+
+    // Percentiles are within the precision of the buckets.
+    const uint64_t p50 = h.percentile(50.0);
+    CPPUNIT_ASSERT(p50 >= 500 && p50 <= 500 + 500 / 16);
+    const uint64_t p99 = h.percentile(99.0);
+    CPPUNIT_ASSERT(p99 >= 990 && p99 <= 1000);
+
+    h.reset();
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), h.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), h.maximum());
+}
+
+void LogHistogramTest::testMerge()
+{
+    ts::LogHistogram h1;
+    ts::LogHistogram h2;
+
+    h1.add(10, 5);
+    h2.add(2000, 5);
+    h2.add(3);
+    h1.merge(h2);
+
+    CPPUNIT_ASSERT_EQUAL(uint64_t(11), h1.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3), h1.minimum());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2000), h1.maximum());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(10), h1.percentile(50.0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2000), h1.percentile(99.0));
+}
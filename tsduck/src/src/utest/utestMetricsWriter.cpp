@@ -0,0 +1,128 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::MetricsWriter
+//
+//----------------------------------------------------------------------------
+
+#include "tsMetricsWriter.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class MetricsWriterTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testFamilies();
+    void testEscape();
+
+    CPPUNIT_TEST_SUITE(MetricsWriterTest);
+    CPPUNIT_TEST(testFamilies);
+    CPPUNIT_TEST(testEscape);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MetricsWriterTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void MetricsWriterTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void MetricsWriterTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void MetricsWriterTest::testFamilies()
+{
+    ts::MetricsWriter writer(u"app");
+
+    // Samples of the same family are grouped, in order of first insertion.
+    writer.gauge(u"size", u"Buffer size.", int64_t(100));
+    writer.setLabel(u"plugin", u"a");
+    writer.setLabel(u"index", 0);
+    writer.counter(u"packets_total", u"Packets.", uint64_t(1234));
+    writer.gauge(u"rate", u"", 1.5);
+    writer.setLabel(u"plugin", u"b");
+    writer.setLabel(u"index", 1);
+    writer.counter(u"packets_total", u"Ignored.", uint64_t(5678));
+    writer.clearLabels();
+    writer.counter(u"seconds_total", u"Time.", 0.25);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(4), writer.familyCount());
+    CPPUNIT_ASSERT_EQUAL(std::string(
+        "# HELP app_size Buffer size.\n"
+        "# TYPE app_size gauge\n"
+        "app_size 100\n"
+        "# HELP app_packets_total Packets.\n"
+        "# TYPE app_packets_total counter\n"
+        "app_packets_total{plugin=\"a\",index=\"0\"} 1234\n"
+        "app_packets_total{plugin=\"b\",index=\"1\"} 5678\n"
+        "# TYPE app_rate gauge\n"
+        "app_rate{plugin=\"a\",index=\"0\"} 1.5\n"
+        "# HELP app_seconds_total Time.\n"
+        "# TYPE app_seconds_total counter\n"
+        "app_seconds_total 0.25\n"),
+        writer.toText());
+
+    writer.clear();
+    CPPUNIT_ASSERT_EQUAL(size_t(0), writer.familyCount());
+    CPPUNIT_ASSERT(writer.toText().empty());
+}
+
+void MetricsWriterTest::testEscape()
+{
+    ts::MetricsWriter writer;
+    writer.setLabel(u"name", u"a\"b\\c\nd");
+    writer.gauge(u"value", u"Line1\nLine2 \"quoted\"", int64_t(-3));
+
+    CPPUNIT_ASSERT_EQUAL(std::string(
+        "# HELP value Line1\\nLine2 \"quoted\"\n"
+        "# TYPE value gauge\n"
+        "value{name=\"a\\\"b\\\\c\\nd\"} -3\n"),
+        writer.toText());
+}
@@ -69,6 +69,7 @@ public:
     void testTCPSocket();
     void testUDPSocket();
     void testIPHeader();
+    void testRTPHeader();
 
     CPPUNIT_TEST_SUITE(NetworkingTest);
     CPPUNIT_TEST(testIPAddressConstructors);
@@ -81,6 +82,7 @@ public:
     CPPUNIT_TEST(testTCPSocket);
     CPPUNIT_TEST(testUDPSocket);
     CPPUNIT_TEST(testIPHeader);
+    CPPUNIT_TEST(testRTPHeader);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -702,3 +704,39 @@ void NetworkingTest::testIPHeader()
     CPPUNIT_ASSERT(ts::VerifyIPHeaderChecksum(header, sizeof(header)));
     CPPUNIT_ASSERT_EQUAL(uint16_t(0x328B), ts::IPHeaderChecksum(header, sizeof(header)));
 }
+
+// Test RTP header
+void NetworkingTest::testRTPHeader()
+{
+    uint8_t msg[ts::RTP_HEADER_SIZE + 20];
+    ::memset(msg, 0xAA, sizeof(msg));
+    ts::BuildRTPHeader(msg, ts::RTP_PT_MP2T, 0x1234, 0x89ABCDEF, 0x01020304);
+
+    static const uint8_t reference_header[] = {
+        0x80, 0x21, 0x12, 0x34, 0x89, 0xAB, 0xCD, 0xEF, 0x01, 0x02, 0x03, 0x04,
+    };
+    CPPUNIT_ASSERT_EQUAL(0, ::memcmp(msg, reference_header, sizeof(reference_header)));
+
+    size_t offset = 0;
+    size_t size = 0;
+    uint16_t sequence = 0;
+    CPPUNIT_ASSERT(ts::GetRTPPayload(msg, sizeof(msg), offset, size, sequence));
+    CPPUNIT_ASSERT_EQUAL(ts::RTP_HEADER_SIZE, offset);
+    CPPUNIT_ASSERT_EQUAL(size_t(20), size);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(0x1234), sequence);
+
+    // One CSRC, one extension word and 3 bytes of padding.
+    msg[0] = 0xB1;
+    msg[ts::RTP_HEADER_SIZE + 4 + 2] = 0x00;
+    msg[ts::RTP_HEADER_SIZE + 4 + 3] = 0x01;
+    msg[sizeof(msg) - 1] = 3;
+    CPPUNIT_ASSERT(ts::GetRTPPayload(msg, sizeof(msg), offset, size, sequence));
+    CPPUNIT_ASSERT_EQUAL(ts::RTP_HEADER_SIZE + 12, offset);
+    CPPUNIT_ASSERT_EQUAL(size_t(5), size);
+
+    // Not RTP or truncated header.
+    msg[0] = 0x47;
+    CPPUNIT_ASSERT(!ts::GetRTPPayload(msg, sizeof(msg), offset, size, sequence));
+    msg[0] = 0x80;
+    CPPUNIT_ASSERT(!ts::GetRTPPayload(msg, ts::RTP_HEADER_SIZE - 1, offset, size, sequence));
+}
@@ -0,0 +1,193 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::PCRAnalyzer
+//
+//----------------------------------------------------------------------------
+
+#include "tsPCRAnalyzer.h"
+#include "tsPCR.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class PCRAnalyzerTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testStatistics();
+
+    CPPUNIT_TEST_SUITE(PCRAnalyzerTest);
+    CPPUNIT_TEST(testStatistics);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    uint64_t _index;
+
+    // Send one packet: a PCR every 10 packets, otherwise a null packet.
+    // The PCR packet arrives late by the specified number of nanoseconds.
+    void sendPacket(ts::PCRAnalyzer& analyzer, ts::NanoSecond late);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PCRAnalyzerTest);
+
+// Stream model: one packet every 100 microseconds (15.04 Mb/s), one PCR every millisecond.
+namespace {
+    const ts::PID        PCR_PID = 100;
+    const ts::NanoSecond PKT_NANOSECONDS = 100000;
+    const uint64_t       PKT_TICKS = ts::SYSTEM_CLOCK_FREQ / 10000;
+    const uint64_t       PCR_INTERVAL_NS = 1000000;
+    const ts::NanoSecond LATE_NANOSECONDS = 50000;
+}
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void PCRAnalyzerTest::setUp()
+{
+    _index = 0;
+}
+
+// Test suite cleanup method.
+void PCRAnalyzerTest::tearDown()
+{
+}
+
+void PCRAnalyzerTest::sendPacket(ts::PCRAnalyzer& analyzer, ts::NanoSecond late)
+{
+    ts::TSPacket pkt;
+    pkt.copyFrom(ts::NullPacket.b);
+    ts::NanoSecond arrival = ts::NanoSecond(_index) * PKT_NANOSECONDS;
+
+    if (_index % 10 == 0) {
+        // Adaptation field only, with PCR.
+        pkt.setPID(PCR_PID);
+        pkt.b[3] = 0x20;
+        pkt.b[4] = 183;
+        pkt.b[5] = 0x10;
+        // A zero PCR is considered as invalid by the analyzer, start later.
+        ts::PutPCR(pkt.b + 6, (_index + 10) * PKT_TICKS);
+        arrival += late;
+    }
+    analyzer.feedPacket(pkt, arrival);
+    _index++;
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void PCRAnalyzerTest::testStatistics()
+{
+    ts::PCRAnalyzer analyzer;
+    analyzer.setStatistics(true);
+    CPPUNIT_ASSERT(analyzer.statistics(PCR_PID) == nullptr);
+
+    // First period: 200 PCR's, one PCR out of 10 arrives late.
+    // Each late PCR gives two jittered intervals, 20% of all intervals.
+    for (size_t i = 0; i < 2000; ++i) {
+        sendPacket(analyzer, i % 100 == 50 ? LATE_NANOSECONDS : 0);
+    }
+    CPPUNIT_ASSERT(analyzer.bitrateIsValid());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(15040000), analyzer.bitrate188());
+
+    const ts::PCRAnalyzer::PCRStatistics* all = analyzer.statistics(PCR_PID);
+    const ts::PCRAnalyzer::PCRStatistics* period = analyzer.statistics(PCR_PID, true);
+    CPPUNIT_ASSERT(all != nullptr);
+    CPPUNIT_ASSERT(period != nullptr);
+    CPPUNIT_ASSERT(analyzer.statistics(ts::PID_NULL) == nullptr);
+
+    CPPUNIT_ASSERT_EQUAL(uint64_t(199), all->interval.count());
+    CPPUNIT_ASSERT_EQUAL(PCR_INTERVAL_NS, all->interval.minimum());
+    CPPUNIT_ASSERT_EQUAL(PCR_INTERVAL_NS, all->interval.maximum());
+    CPPUNIT_ASSERT_EQUAL(PCR_INTERVAL_NS, all->interval.percentile(50.0));
+    CPPUNIT_ASSERT_EQUAL(PCR_INTERVAL_NS, all->interval.percentile(99.9));
+
+    CPPUNIT_ASSERT_EQUAL(uint64_t(199), all->jitter.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), all->jitter.minimum());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(LATE_NANOSECONDS), all->jitter.maximum());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), all->jitter.percentile(50.0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), all->jitter.percentile(75.0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(LATE_NANOSECONDS), all->jitter.percentile(90.0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(LATE_NANOSECONDS), all->jitter.percentile(99.0));
+
+    // Constant bitrate, the PCR's are exactly where they are expected.
+    CPPUNIT_ASSERT(all->accuracy.count() > 0);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), all->accuracy.maximum());
+
+    // No new period yet, same values.
+    CPPUNIT_ASSERT_EQUAL(all->interval.count(), period->interval.count());
+    CPPUNIT_ASSERT_EQUAL(all->jitter.maximum(), period->jitter.maximum());
+
+    // Second period: 100 PCR's without jitter.
+    analyzer.restartPeriod();
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), period->interval.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), period->jitter.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(199), all->interval.count());
+    for (size_t i = 0; i < 1000; ++i) {
+        sendPacket(analyzer, 0);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(uint64_t(100), period->interval.count());
+    CPPUNIT_ASSERT_EQUAL(PCR_INTERVAL_NS, period->interval.percentile(90.0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(100), period->jitter.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), period->jitter.maximum());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), period->jitter.percentile(99.9));
+
+    CPPUNIT_ASSERT_EQUAL(uint64_t(299), all->interval.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(299), all->jitter.count());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(LATE_NANOSECONDS), all->jitter.maximum());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(LATE_NANOSECONDS), all->jitter.percentile(99.0));
+
+    // Reports.
+    std::ostringstream text;
+    analyzer.reportStatistics(text, true);
+    utest::Out() << "PCRAnalyzerTest: period statistics:" << std::endl << text.str();
+    CPPUNIT_ASSERT(text.str().find("PID 0x0064 (100), 100 PCR intervals") != std::string::npos);
+
+    const ts::json::ValuePtr json(analyzer.jsonStatistics());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), json->size());
+    const ts::json::Value& pid(json->at(0));
+    CPPUNIT_ASSERT_EQUAL(int64_t(PCR_PID), pid.value(u"pid").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(299), pid.value(u"interval-ns").value(u"count").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(PCR_INTERVAL_NS), pid.value(u"interval-ns").value(u"p50").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(LATE_NANOSECONDS), pid.value(u"jitter-ns").value(u"max").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(LATE_NANOSECONDS), pid.value(u"jitter-ns").value(u"p99").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(0), pid.value(u"jitter-ns").value(u"p50").toInteger());
+}
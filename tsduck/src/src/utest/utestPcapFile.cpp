@@ -0,0 +1,274 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::PcapFile
+//
+//----------------------------------------------------------------------------
+
+#include "tsPcapFile.h"
+#include "tsIPUtils.h"
+#include "tsIntegerUtils.h"
+#include "tsSysUtils.h"
+#include "tsNullReport.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class PcapFileTest: public CppUnit::TestFixture
+{
+public:
+    PcapFileTest();
+
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testPcap();
+    void testPcapNG();
+
+    CPPUNIT_TEST_SUITE(PcapFileTest);
+    CPPUNIT_TEST(testPcap);
+    CPPUNIT_TEST(testPcapNG);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    ts::UString _tempFile;
+
+    // Build an IPv4 packet.
+    static ts::ByteBlock IPPacket(uint8_t protocol, uint16_t fragment, uint16_t src_port, uint16_t dst_port, const ts::ByteBlock& payload);
+
+    // Build an Ethernet frame with an optional VLAN tag.
+    static ts::ByteBlock EthernetFrame(const ts::ByteBlock& ip, bool vlan);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PcapFileTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+PcapFileTest::PcapFileTest() :
+    _tempFile()
+{
+}
+
+// Test suite initialization method.
+void PcapFileTest::setUp()
+{
+    _tempFile = ts::TempFile(u".pcap");
+}
+
+// Test suite cleanup method.
+void PcapFileTest::tearDown()
+{
+    ts::DeleteFile(_tempFile);
+}
+
+ts::ByteBlock PcapFileTest::IPPacket(uint8_t protocol, uint16_t fragment, uint16_t src_port, uint16_t dst_port, const ts::ByteBlock& payload)
+{
+    ts::ByteBlock ip;
+    ip.appendUInt8(0x45);
+    ip.appendUInt8(0);
+    ip.appendUInt16BE(uint16_t(ts::IPv4_MIN_HEADER_SIZE + ts::UDP_HEADER_SIZE + payload.size()));
+    ip.appendUInt16BE(0);
+    ip.appendUInt16BE(fragment);
+    ip.appendUInt8(64);
+    ip.appendUInt8(protocol);
+    ip.appendUInt16BE(0);
+    ip.appendUInt32BE(0x0A000001);  // 10.0.0.1
+    ip.appendUInt32BE(0xEF010101);  // 239.1.1.1
+    ts::UpdateIPHeaderChecksum(ip.data(), ip.size());
+    ip.appendUInt16BE(src_port);
+    ip.appendUInt16BE(dst_port);
+    ip.appendUInt16BE(uint16_t(ts::UDP_HEADER_SIZE + payload.size()));
+    ip.appendUInt16BE(0);
+    ip.append(payload);
+    return ip;
+}
+
+ts::ByteBlock PcapFileTest::EthernetFrame(const ts::ByteBlock& ip, bool vlan)
+{
+    ts::ByteBlock eth(12, 0xFF);
+    if (vlan) {
+        eth.appendUInt16BE(0x8100);
+        eth.appendUInt16BE(10);
+    }
+    eth.appendUInt16BE(0x0800);
+    eth.append(ip);
+    eth.append(uint8_t(0), 6); // Ethernet padding
+    return eth;
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+// Big endian pcap file with nanosecond timestamps.
+void PcapFileTest::testPcap()
+{
+    const ts::ByteBlock payload(20, 0x47);
+    ts::ByteBlock frames[3];
+    frames[0] = EthernetFrame(IPPacket(ts::IPv4_PROTO_TCP, 0, 1000, 2000, payload), false);
+    frames[1] = EthernetFrame(IPPacket(ts::IPv4_PROTO_UDP, 0x2000, 1000, 2000, payload), false);
+    frames[2] = EthernetFrame(IPPacket(ts::IPv4_PROTO_UDP, 0, 1000, 2000, payload), true);
+
+    ts::ByteBlock file;
+    file.appendUInt32BE(0xA1B23C4D);
+    file.appendUInt16BE(2);
+    file.appendUInt16BE(4);
+    file.appendUInt32BE(0);
+    file.appendUInt32BE(0);
+    file.appendUInt32BE(65535);
+    file.appendUInt32BE(ts::PcapFile::LINKTYPE_ETHERNET);
+    for (size_t i = 0; i < 3; ++i) {
+        file.appendUInt32BE(1000 + uint32_t(i));
+        file.appendUInt32BE(123456789);
+        file.appendUInt32BE(uint32_t(frames[i].size()));
+        file.appendUInt32BE(uint32_t(frames[i].size()));
+        file.append(frames[i]);
+    }
+    CPPUNIT_ASSERT(file.saveToFile(_tempFile));
+
+    ts::PcapFile pcap;
+    ts::SocketAddress source;
+    ts::SocketAddress destination;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    ts::MicroSecond timestamp = 0;
+
+    CPPUNIT_ASSERT(pcap.open(_tempFile, NULLREP));
+    CPPUNIT_ASSERT(!pcap.isPcapNG());
+    CPPUNIT_ASSERT(pcap.readUDP(source, destination, data, size, timestamp, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::MicroSecond(1002123456), timestamp);
+    CPPUNIT_ASSERT_EQUAL(payload.size(), size);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(0x47), data[0]);
+    CPPUNIT_ASSERT_EQUAL(ts::UString(u"10.0.0.1:1000"), source.toString());
+    CPPUNIT_ASSERT_EQUAL(ts::UString(u"239.1.1.1:2000"), destination.toString());
+    CPPUNIT_ASSERT(!pcap.readUDP(source, destination, data, size, timestamp, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(3), pcap.frameCount());
+    pcap.close();
+    CPPUNIT_ASSERT(!pcap.isOpen());
+}
+
+// Little endian pcap-ng file with three interfaces.
+void PcapFileTest::testPcapNG()
+{
+    const ts::ByteBlock payload(40, 0x47);
+    const ts::ByteBlock eth(EthernetFrame(IPPacket(ts::IPv4_PROTO_UDP, 0, 1000, 2000, payload), false));
+    const ts::ByteBlock raw(IPPacket(ts::IPv4_PROTO_UDP, 0, 3000, 4000, payload));
+
+    ts::ByteBlock file;
+
+    // Section header block.
+    file.appendUInt32LE(0x0A0D0D0A);
+    file.appendUInt32LE(28);
+    file.appendUInt32LE(0x1A2B3C4D);
+    file.appendUInt16LE(1);
+    file.appendUInt16LE(0);
+    file.appendUInt64LE(~uint64_t(0));
+    file.appendUInt32LE(28);
+
+    // Interface 0: Ethernet, default microsecond resolution.
+    file.appendUInt32LE(1);
+    file.appendUInt32LE(20);
+    file.appendUInt16LE(ts::PcapFile::LINKTYPE_ETHERNET);
+    file.appendUInt16LE(0);
+    file.appendUInt32LE(65535);
+    file.appendUInt32LE(20);
+
+    // Interface 1: raw IPv4, millisecond resolution.
+    file.appendUInt32LE(1);
+    file.appendUInt32LE(32);
+    file.appendUInt16LE(ts::PcapFile::LINKTYPE_IPV4);
+    file.appendUInt16LE(0);
+    file.appendUInt32LE(65535);
+    file.appendUInt16LE(9);  // if_tsresol
+    file.appendUInt16LE(1);
+    file.appendUInt32LE(3);
+    file.appendUInt32LE(0);  // opt_endofopt
+    file.appendUInt32LE(32);
+
+    // Interface 2: raw IPv4, 2^-48 second resolution.
+    file.appendUInt32LE(1);
+    file.appendUInt32LE(32);
+    file.appendUInt16LE(ts::PcapFile::LINKTYPE_IPV4);
+    file.appendUInt16LE(0);
+    file.appendUInt32LE(65535);
+    file.appendUInt16LE(9);  // if_tsresol
+    file.appendUInt16LE(1);
+    file.appendUInt32LE(0x80 | 48);
+    file.appendUInt32LE(0);  // opt_endofopt
+    file.appendUInt32LE(32);
+
+    // Enhanced packet blocks, one per interface.
+    // Timestamp of interface 2 is 3.5 seconds: the fraction of second overflows 64 bits when multiplied by 10^6.
+    const ts::ByteBlock* frames[3] = {&eth, &raw, &raw};
+    const uint64_t stamps[3] = {5000, 5000, uint64_t(7) << 47};
+    for (uint32_t i = 0; i < 3; ++i) {
+        const size_t padded = ts::RoundUp<size_t>(frames[i]->size(), 4);
+        file.appendUInt32LE(6);
+        file.appendUInt32LE(uint32_t(32 + padded));
+        file.appendUInt32LE(i);
+        file.appendUInt32LE(uint32_t(stamps[i] >> 32));
+        file.appendUInt32LE(uint32_t(stamps[i]));
+        file.appendUInt32LE(uint32_t(frames[i]->size()));
+        file.appendUInt32LE(uint32_t(frames[i]->size()));
+        file.append(*frames[i]);
+        file.append(uint8_t(0), padded - frames[i]->size());
+        file.appendUInt32LE(uint32_t(32 + padded));
+    }
+    CPPUNIT_ASSERT(file.saveToFile(_tempFile));
+
+    ts::PcapFile pcap;
+    ts::SocketAddress source;
+    ts::SocketAddress destination;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    ts::MicroSecond timestamp = 0;
+
+    CPPUNIT_ASSERT(pcap.open(_tempFile, NULLREP));
+    CPPUNIT_ASSERT(pcap.isPcapNG());
+    CPPUNIT_ASSERT(pcap.readUDP(source, destination, data, size, timestamp, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::MicroSecond(5000), timestamp);
+    CPPUNIT_ASSERT_EQUAL(payload.size(), size);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(2000), destination.port());
+    CPPUNIT_ASSERT(pcap.readUDP(source, destination, data, size, timestamp, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::MicroSecond(5000000), timestamp);
+    CPPUNIT_ASSERT_EQUAL(payload.size(), size);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(4000), destination.port());
+    CPPUNIT_ASSERT(pcap.readUDP(source, destination, data, size, timestamp, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::MicroSecond(3500000), timestamp);
+    CPPUNIT_ASSERT(!pcap.readUDP(source, destination, data, size, timestamp, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(3), pcap.frameCount());
+}
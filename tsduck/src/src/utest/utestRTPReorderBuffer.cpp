@@ -0,0 +1,371 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::RTPReorderBuffer
+//
+//----------------------------------------------------------------------------
+
+#include "tsRTPReorderBuffer.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class RTPReorderBufferTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testInOrder();
+    void testReorder();
+    void testLoss();
+    void testLateDuplicate();
+    void testWrapResync();
+    void testLossWhileWaiting();
+    void testOverflow();
+    void testGrowCapacity();
+
+    CPPUNIT_TEST_SUITE(RTPReorderBufferTest);
+    CPPUNIT_TEST(testInOrder);
+    CPPUNIT_TEST(testReorder);
+    CPPUNIT_TEST(testLoss);
+    CPPUNIT_TEST(testLateDuplicate);
+    CPPUNIT_TEST(testWrapResync);
+    CPPUNIT_TEST(testLossWhileWaiting);
+    CPPUNIT_TEST(testOverflow);
+    CPPUNIT_TEST(testGrowCapacity);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    // Insert a one-byte message containing the LSB of the sequence number.
+    static bool Insert(ts::RTPReorderBuffer& buffer, uint16_t sequence, const ts::Monotonic& time);
+    // Extract next message and return its content, -1 if none.
+    static int Next(ts::RTPReorderBuffer& buffer, const ts::Monotonic& time);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RTPReorderBufferTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void RTPReorderBufferTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void RTPReorderBufferTest::tearDown()
+{
+}
+
+bool RTPReorderBufferTest::Insert(ts::RTPReorderBuffer& buffer, uint16_t sequence, const ts::Monotonic& time)
+{
+    const uint8_t data = uint8_t(sequence);
+    return buffer.insert(sequence, &data, 1, time);
+}
+
+int RTPReorderBufferTest::Next(ts::RTPReorderBuffer& buffer, const ts::Monotonic& time)
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    if (buffer.next(data, size, time)) {
+        CPPUNIT_ASSERT(data != nullptr);
+        CPPUNIT_ASSERT_EQUAL(size_t(1), size);
+        return data[0];
+    }
+    else {
+        CPPUNIT_ASSERT_EQUAL(size_t(0), size);
+        return -1;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void RTPReorderBufferTest::testInOrder()
+{
+    const ts::Monotonic t0;
+    ts::RTPReorderBuffer buffer(16, 100 * ts::NanoSecPerMilliSec);
+
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    for (uint16_t seq = 100; seq < 150; ++seq) {
+        CPPUNIT_ASSERT(Insert(buffer, seq, t0));
+        CPPUNIT_ASSERT_EQUAL(size_t(1), buffer.count());
+        CPPUNIT_ASSERT_EQUAL(int(seq & 0xFF), Next(buffer, t0));
+        CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    }
+
+    const ts::RTPReorderBuffer::Statistics& stats(buffer.statistics());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(50), stats.received);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(50), stats.delivered);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.lost);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.reordered);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.late);
+}
+
+void RTPReorderBufferTest::testReorder()
+{
+    const ts::Monotonic t0;
+    ts::RTPReorderBuffer buffer(16, 100 * ts::NanoSecPerMilliSec);
+
+    // Received: 1 3 4 2 5, delivered: 1 2 3 4 5
+    CPPUNIT_ASSERT(Insert(buffer, 1, t0));
+    CPPUNIT_ASSERT_EQUAL(1, Next(buffer, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 3, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 4, t0));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), buffer.count());
+    CPPUNIT_ASSERT(Insert(buffer, 2, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 5, t0));
+    CPPUNIT_ASSERT_EQUAL(2, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(3, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(4, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(5, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+
+    const ts::RTPReorderBuffer::Statistics& stats(buffer.statistics());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(5), stats.received);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(5), stats.delivered);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.lost);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.reordered);
+}
+
+void RTPReorderBufferTest::testLoss()
+{
+    const ts::Monotonic t0;
+    ts::Monotonic t1(t0);
+    t1 += 50 * ts::NanoSecPerMilliSec;
+    ts::Monotonic t2(t0);
+    t2 += 100 * ts::NanoSecPerMilliSec;
+
+    ts::RTPReorderBuffer buffer(16, 100 * ts::NanoSecPerMilliSec);
+
+    // Received: 10 13 14, 11 and 12 are lost.
+    CPPUNIT_ASSERT(Insert(buffer, 10, t0));
+    CPPUNIT_ASSERT_EQUAL(10, Next(buffer, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 13, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 14, t1));
+
+    // Waiting for the missing messages until the latency expires.
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t1));
+    CPPUNIT_ASSERT_EQUAL(13, Next(buffer, t2));
+    CPPUNIT_ASSERT_EQUAL(14, Next(buffer, t2));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t2));
+
+    const ts::RTPReorderBuffer::Statistics& stats(buffer.statistics());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3), stats.received);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3), stats.delivered);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), stats.lost);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.reordered);
+
+    // With a zero latency, missing messages are immediately skipped.
+    buffer.reset(16, 0);
+    CPPUNIT_ASSERT(Insert(buffer, 20, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 22, t0));
+    CPPUNIT_ASSERT_EQUAL(20, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(22, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), buffer.statistics().lost);
+}
+
+void RTPReorderBufferTest::testLateDuplicate()
+{
+    const ts::Monotonic t0;
+    ts::Monotonic t1(t0);
+    t1 += 200 * ts::NanoSecPerMilliSec;
+
+    ts::RTPReorderBuffer buffer(16, 100 * ts::NanoSecPerMilliSec);
+
+    CPPUNIT_ASSERT(Insert(buffer, 1, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 3, t0));
+    CPPUNIT_ASSERT(!Insert(buffer, 3, t0));
+    CPPUNIT_ASSERT_EQUAL(1, Next(buffer, t1));
+    CPPUNIT_ASSERT_EQUAL(3, Next(buffer, t1));
+
+    // Too late, 2 was declared lost, 1 was already delivered.
+    CPPUNIT_ASSERT(!Insert(buffer, 2, t1));
+    CPPUNIT_ASSERT(!Insert(buffer, 1, t1));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t1));
+
+    const ts::RTPReorderBuffer::Statistics& stats(buffer.statistics());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), stats.received);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.duplicated);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), stats.late);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.lost);
+}
+
+void RTPReorderBufferTest::testWrapResync()
+{
+    const ts::Monotonic t0;
+    ts::RTPReorderBuffer buffer(10, 100 * ts::NanoSecPerMilliSec);
+
+    // Reordering around the wrap of sequence numbers.
+    CPPUNIT_ASSERT(Insert(buffer, 0xFFFE, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 0x0000, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 0xFFFF, t0));
+    CPPUNIT_ASSERT_EQUAL(0xFE, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(0xFF, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(0x00, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), buffer.statistics().reordered);
+
+    // A jump larger than twice the capacity (rounded up to 16) restarts the buffer,
+    // after delivering the waiting message without waiting for the missing one.
+    CPPUNIT_ASSERT(Insert(buffer, 0x0002, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 0x1234, t0));
+    CPPUNIT_ASSERT_EQUAL(0x02, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(0x34, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+
+    // A backward jump discards the waiting messages.
+    CPPUNIT_ASSERT(Insert(buffer, 0x1236, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 0x0100, t0));
+    CPPUNIT_ASSERT_EQUAL(0x00, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+
+    const ts::RTPReorderBuffer::Statistics& stats(buffer.statistics());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), stats.resync);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.discarded);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.lost);
+}
+
+void RTPReorderBufferTest::testLossWhileWaiting()
+{
+    const ts::Monotonic t0;
+    ts::Monotonic t1(t0);
+    t1 += 50 * ts::NanoSecPerMilliSec;
+    ts::Monotonic t2(t0);
+    t2 += 100 * ts::NanoSecPerMilliSec;
+    ts::Monotonic t3(t1);
+    t3 += 100 * ts::NanoSecPerMilliSec;
+
+    ts::RTPReorderBuffer buffer(16, 100 * ts::NanoSecPerMilliSec);
+
+    // Received: 1 3 5, 2 and 4 are lost. The latency of each missing
+    // message is evaluated from the first waiting message after it.
+    CPPUNIT_ASSERT(Insert(buffer, 1, t0));
+    CPPUNIT_ASSERT_EQUAL(1, Next(buffer, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 3, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 5, t1));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t1));
+    CPPUNIT_ASSERT_EQUAL(3, Next(buffer, t2));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t2));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), buffer.statistics().lost);
+
+    // 4 is still missing, a late 2 is dropped.
+    CPPUNIT_ASSERT(!Insert(buffer, 2, t2));
+    CPPUNIT_ASSERT_EQUAL(5, Next(buffer, t3));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t3));
+
+    const ts::RTPReorderBuffer::Statistics& stats(buffer.statistics());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3), stats.received);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(3), stats.delivered);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), stats.lost);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.late);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), buffer.count());
+}
+
+void RTPReorderBufferTest::testOverflow()
+{
+    const ts::Monotonic t0;
+    ts::Monotonic t1(t0);
+    t1 += 100 * ts::NanoSecPerMilliSec;
+
+    ts::RTPReorderBuffer buffer(16, 100 * ts::NanoSecPerMilliSec);
+
+    // 2 is missing and the buffer is full. The next message releases 2
+    // and all waiting messages are delivered in order, without waiting.
+    CPPUNIT_ASSERT(Insert(buffer, 1, t0));
+    CPPUNIT_ASSERT_EQUAL(1, Next(buffer, t0));
+    for (uint16_t seq = 3; seq < 18; ++seq) {
+        CPPUNIT_ASSERT(Insert(buffer, seq, t0));
+    }
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 18, t0));
+    for (int seq = 3; seq <= 18; ++seq) {
+        CPPUNIT_ASSERT_EQUAL(seq, Next(buffer, t0));
+    }
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), buffer.statistics().lost);
+
+    // 19 is missing, 20 is waiting, 40 is beyond the capacity. 20 is delivered
+    // first, 21 to 24 are lost, 25 to 39 are waited for during the latency.
+    CPPUNIT_ASSERT(Insert(buffer, 20, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 40, t0));
+    CPPUNIT_ASSERT_EQUAL(20, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(6), buffer.statistics().lost);
+    CPPUNIT_ASSERT(Insert(buffer, 30, t0));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(30, Next(buffer, t1));
+    CPPUNIT_ASSERT_EQUAL(40, Next(buffer, t1));
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t1));
+
+    const ts::RTPReorderBuffer::Statistics& stats(buffer.statistics());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(20), stats.received);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(20), stats.delivered);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(20), stats.lost);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.discarded);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.resync);
+}
+
+void RTPReorderBufferTest::testGrowCapacity()
+{
+    const ts::Monotonic t0;
+    ts::RTPReorderBuffer buffer(16, 100 * ts::NanoSecPerMilliSec);
+    CPPUNIT_ASSERT_EQUAL(size_t(16), buffer.capacity());
+
+    // The waiting messages are kept when the capacity grows.
+    CPPUNIT_ASSERT(Insert(buffer, 1, t0));
+    CPPUNIT_ASSERT_EQUAL(1, Next(buffer, t0));
+    for (uint16_t seq = 3; seq < 18; ++seq) {
+        CPPUNIT_ASSERT(Insert(buffer, seq, t0));
+    }
+    buffer.growCapacity(100);
+    CPPUNIT_ASSERT_EQUAL(size_t(128), buffer.capacity());
+    CPPUNIT_ASSERT_EQUAL(size_t(15), buffer.count());
+    CPPUNIT_ASSERT(Insert(buffer, 18, t0));
+    CPPUNIT_ASSERT(Insert(buffer, 2, t0));
+    for (int seq = 2; seq <= 18; ++seq) {
+        CPPUNIT_ASSERT_EQUAL(seq, Next(buffer, t0));
+    }
+    CPPUNIT_ASSERT_EQUAL(-1, Next(buffer, t0));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), buffer.statistics().lost);
+
+    // Never shrink.
+    buffer.growCapacity(10);
+    CPPUNIT_ASSERT_EQUAL(size_t(128), buffer.capacity());
+}
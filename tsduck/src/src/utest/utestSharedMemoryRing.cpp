@@ -0,0 +1,329 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::SharedMemoryRing
+//
+//----------------------------------------------------------------------------
+
+#include "tsSharedMemoryRing.h"
+#include "tsSysUtils.h"
+#include "tsNullReport.h"
+#include "utestCppUnitThread.h"
+#if defined(TS_UNIX)
+#include <sys/wait.h>
+#endif
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class SharedMemoryRingTest: public CppUnit::TestFixture
+{
+public:
+    SharedMemoryRingTest();
+
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testReaders();
+    void testTransfer();
+    void testOverrun();
+    void testSlotReuse();
+
+    CPPUNIT_TEST_SUITE(SharedMemoryRingTest);
+    CPPUNIT_TEST(testReaders);
+    CPPUNIT_TEST(testTransfer);
+    CPPUNIT_TEST(testOverrun);
+    CPPUNIT_TEST(testSlotReuse);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    ts::UString _name;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SharedMemoryRingTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+SharedMemoryRingTest::SharedMemoryRingTest() :
+    _name(ts::UString::Format(u"tsduck-utest-ring-%d", {ts::CurrentProcessId()}))
+{
+}
+
+// Test suite initialization method.
+void SharedMemoryRingTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void SharedMemoryRingTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void SharedMemoryRingTest::testReaders()
+{
+#if defined(TS_UNIX)
+    ts::SharedMemoryRing writer;
+    ts::SharedMemoryRing reader1;
+    ts::SharedMemoryRing reader2;
+
+    CPPUNIT_ASSERT(!reader1.open(_name, NULLREP));
+    CPPUNIT_ASSERT(writer.create(_name, 100, 1, NULLREP));
+    CPPUNIT_ASSERT(writer.isWriter());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), writer.readerCount());
+
+    CPPUNIT_ASSERT(reader1.open(_name, NULLREP));
+    CPPUNIT_ASSERT(!reader1.isWriter());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), writer.readerCount());
+    CPPUNIT_ASSERT(writer.waitReaders(1, NULLREP));
+
+    // Only one reader slot.
+    CPPUNIT_ASSERT(!reader2.open(_name, NULLREP));
+    CPPUNIT_ASSERT(reader1.close(NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), writer.readerCount());
+    CPPUNIT_ASSERT(reader2.open(_name, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), writer.readerCount());
+
+    // End of file after the writer closed the ring.
+    ts::TSPacket pkt;
+    CPPUNIT_ASSERT(writer.write(&ts::NullPacket, 1, 0, NULLREP));
+    CPPUNIT_ASSERT(writer.close(NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), reader2.read(&pkt, 1, NULLREP));
+    CPPUNIT_ASSERT(pkt == ts::NullPacket);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), reader2.read(&pkt, 1, NULLREP));
+    CPPUNIT_ASSERT(reader2.close(NULLREP));
+    CPPUNIT_ASSERT(!reader1.open(_name, NULLREP));
+#endif
+}
+
+// Thread for testTransfer()
+namespace {
+    class SharedMemoryRingTestThread: public utest::CppUnitThread
+    {
+    private:
+        ts::SharedMemoryRing& _ring;
+        size_t _count;
+    public:
+        SharedMemoryRingTestThread(ts::SharedMemoryRing& ring, size_t count) :
+            utest::CppUnitThread(),
+            _ring(ring),
+            _count(count)
+        {
+        }
+
+        virtual ~SharedMemoryRingTestThread() override
+        {
+            waitForTermination();
+        }
+
+        virtual void test() override
+        {
+            // Read packets with consecutive contents until end of file.
+            ts::TSPacket buffer[17];
+            size_t total = 0;
+            size_t count = 0;
+            while ((count = _ring.read(buffer, 17, NULLREP)) > 0) {
+                for (size_t i = 0; i < count; ++i) {
+                    CPPUNIT_ASSERT_EQUAL(uint32_t(total++), ts::GetUInt32(buffer[i].b + 4));
+                }
+            }
+            CPPUNIT_ASSERT_EQUAL(_count, total);
+            CPPUNIT_ASSERT_EQUAL(ts::BitRate(1234567), _ring.bitrate());
+        }
+    };
+}
+
+void SharedMemoryRingTest::testTransfer()
+{
+#if defined(TS_UNIX)
+    const size_t count = 10000;
+    ts::TSPacketVector packets(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i] = ts::NullPacket;
+        ts::PutUInt32(packets[i].b + 4, uint32_t(i));
+    }
+
+    // The ring is much smaller than the data, the writer waits for the readers.
+    ts::SharedMemoryRing writer;
+    ts::SharedMemoryRing reader1;
+    ts::SharedMemoryRing reader2;
+    CPPUNIT_ASSERT(writer.create(_name, 100, 4, NULLREP));
+    CPPUNIT_ASSERT(reader1.open(_name, NULLREP));
+    CPPUNIT_ASSERT(reader2.open(_name, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), writer.readerCount());
+    {
+        SharedMemoryRingTestThread thread1(reader1, count);
+        SharedMemoryRingTestThread thread2(reader2, count);
+        CPPUNIT_ASSERT(thread1.start());
+        CPPUNIT_ASSERT(thread2.start());
+        for (size_t i = 0; i < count; i += 30) {
+            CPPUNIT_ASSERT(writer.write(&packets[i], std::min<size_t>(30, count - i), 1234567, NULLREP));
+        }
+        CPPUNIT_ASSERT(writer.close(NULLREP));
+    }
+    CPPUNIT_ASSERT(reader1.close(NULLREP));
+    CPPUNIT_ASSERT(reader2.close(NULLREP));
+#endif
+}
+
+void SharedMemoryRingTest::testOverrun()
+{
+#if defined(TS_UNIX)
+    const size_t count = 300;
+    ts::TSPacketVector packets(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i] = ts::NullPacket;
+        ts::PutUInt32(packets[i].b + 4, uint32_t(i));
+    }
+
+    ts::SharedMemoryRing writer;
+    CPPUNIT_ASSERT(writer.create(_name, 100, 1, NULLREP));
+
+    // The reader attaches in a first child process which forks a second child and exits.
+    // The second child keeps reading, but the reader slot refers to a dead process.
+    // The writer no longer waits for it and overwrites the unread packets. The second
+    // child is not our child, it returns its status through a pipe.
+    int start[2];
+    int result[2];
+    CPPUNIT_ASSERT(::pipe(start) == 0);
+    CPPUNIT_ASSERT(::pipe(result) == 0);
+    const pid_t pid = ::fork();
+    CPPUNIT_ASSERT(pid >= 0);
+    if (pid == 0) {
+        ts::SharedMemoryRing reader;
+        if (!reader.open(_name, NULLREP)) {
+            ::_exit(1);
+        }
+        if (::fork() != 0) {
+            ::_exit(0);
+        }
+        // Wait for the writer to complete, then read everything.
+        char status = 0;
+        ::close(start[1]);
+        if (::read(start[0], &status, 1) != 1) {
+            status = 1;
+        }
+        ts::TSPacket buffer[100];
+        size_t total = 0;
+        size_t n = 0;
+        while (status == 0 && total < 100 && (n = reader.read(buffer + total, 100 - total, NULLREP)) > 0) {
+            for (size_t i = 0; i < n; ++i) {
+                if (ts::GetUInt32(buffer[total + i].b + 4) != uint32_t(200 + total + i)) {
+                    status = 2;
+                }
+            }
+            total += n;
+        }
+        if (status == 0 && (total != 100 || reader.lostPackets() != 200)) {
+            status = 3;
+        }
+        TS_UNUSED ::ssize_t unused = ::write(result[1], &status, 1);
+        ::_exit(0);
+    }
+
+    // Wait for the termination of the first child, the reader is attached.
+    int wstatus = 0;
+    CPPUNIT_ASSERT(::waitpid(pid, &wstatus, 0) == pid);
+    CPPUNIT_ASSERT(WIFEXITED(wstatus));
+    CPPUNIT_ASSERT_EQUAL(0, WEXITSTATUS(wstatus));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), writer.readerCount());
+
+    // The writer detects the dead reader after a timeout and overwrites the unread packets.
+    CPPUNIT_ASSERT(writer.write(packets.data(), count, 0, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), writer.readerCount());
+
+    // Let the second child read the ring and get its status.
+    char status = 0;
+    CPPUNIT_ASSERT(::write(start[1], &status, 1) == 1);
+    CPPUNIT_ASSERT(::read(result[0], &status, 1) == 1);
+    CPPUNIT_ASSERT_EQUAL(0, int(status));
+    CPPUNIT_ASSERT(writer.close(NULLREP));
+
+    ::close(start[0]);
+    ::close(start[1]);
+    ::close(result[0]);
+    ::close(result[1]);
+#endif
+}
+
+void SharedMemoryRingTest::testSlotReuse()
+{
+#if defined(TS_UNIX)
+    const size_t count = 200;
+    ts::TSPacketVector packets(count, ts::NullPacket);
+
+    ts::SharedMemoryRing writer;
+    CPPUNIT_ASSERT(writer.create(_name, 100, 1, NULLREP));
+
+    // A child process attaches as reader and dies without detaching.
+    const pid_t pid = ::fork();
+    CPPUNIT_ASSERT(pid >= 0);
+    if (pid == 0) {
+        ts::SharedMemoryRing reader;
+        ::_exit(reader.open(_name, NULLREP) ? 0 : 1);
+    }
+    int wstatus = 0;
+    CPPUNIT_ASSERT(::waitpid(pid, &wstatus, 0) == pid);
+    CPPUNIT_ASSERT(WIFEXITED(wstatus));
+    CPPUNIT_ASSERT_EQUAL(0, WEXITSTATUS(wstatus));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), writer.readerCount());
+
+    // The writer purges the dead reader when the ring is full.
+    CPPUNIT_ASSERT(writer.write(packets.data(), count, 0, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), writer.readerCount());
+
+    // The purged slot is not immediately reusable, then it is.
+    ts::SharedMemoryRing reader;
+    CPPUNIT_ASSERT(!reader.open(_name, NULLREP));
+    ts::SleepThread(1100);
+    CPPUNIT_ASSERT(reader.open(_name, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), writer.readerCount());
+
+    // The new reader gets the new packets.
+    ts::TSPacket pkt(ts::NullPacket);
+    ts::PutUInt32(pkt.b + 4, 12345);
+    CPPUNIT_ASSERT(writer.write(&pkt, 1, 0, NULLREP));
+    ts::TSPacket buffer;
+    CPPUNIT_ASSERT_EQUAL(size_t(1), reader.read(&buffer, 1, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(uint32_t(12345), ts::GetUInt32(buffer.b + 4));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(0), reader.lostPackets());
+    CPPUNIT_ASSERT(reader.close(NULLREP));
+    CPPUNIT_ASSERT(writer.close(NULLREP));
+#endif
+}
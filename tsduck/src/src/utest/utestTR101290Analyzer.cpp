@@ -0,0 +1,522 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::TR101290Analyzer
+//
+//----------------------------------------------------------------------------
+
+#include "tsTR101290Analyzer.h"
+#include "tsTR101290HandlerInterface.h"
+#include "tsOneShotPacketizer.h"
+#include "tsBinaryTable.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsPCR.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class TR101290AnalyzerTest: public CppUnit::TestFixture, private ts::TR101290HandlerInterface
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testContinuity();
+    void testSyncLoss();
+    void testTimers();
+    void testPCRRepetition();
+    void testPCRDiscontinuity();
+    void testPCRAccuracy();
+    void testPMT();
+    void testPID();
+    void testPTS();
+    void testUnreferencedPID();
+
+    CPPUNIT_TEST_SUITE(TR101290AnalyzerTest);
+    CPPUNIT_TEST(testContinuity);
+    CPPUNIT_TEST(testSyncLoss);
+    CPPUNIT_TEST(testTimers);
+    CPPUNIT_TEST(testPCRRepetition);
+    CPPUNIT_TEST(testPCRDiscontinuity);
+    CPPUNIT_TEST(testPCRAccuracy);
+    CPPUNIT_TEST(testPMT);
+    CPPUNIT_TEST(testPID);
+    CPPUNIT_TEST(testPTS);
+    CPPUNIT_TEST(testUnreferencedPID);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::vector<ts::TR101290Analyzer::Event> _events;
+    uint8_t _cc[ts::PID_MAX];
+    virtual void handleTR101290Event(ts::TR101290Analyzer& analyzer, const ts::TR101290Analyzer::Event& event) override;
+    static void MakePacket(ts::TSPacket& pkt, ts::PID pid, uint8_t cc);
+
+    // Send a packet with payload, optionally with a PTS, with a continuous CC.
+    void sendPacket(ts::TR101290Analyzer& analyzer, ts::PID pid, ts::NanoSecond time, bool pts = false);
+
+    // Send a packet with a PCR and no payload.
+    void sendPCR(ts::TR101290Analyzer& analyzer, ts::PID pid, ts::NanoSecond time, uint64_t pcr, bool discontinuity = false);
+
+    // Send a table with a continuous CC.
+    void sendTable(ts::TR101290Analyzer& analyzer, ts::PID pid, const ts::AbstractTable& table, ts::NanoSecond time);
+
+    // Send a PAT and a PMT, service 1 with PMT PID 1000, PCR PID 100, audio PID 101, private data PID 102.
+    void sendPSI(ts::TR101290Analyzer& analyzer, ts::NanoSecond time);
+
+    // Check that the last event is a given alarm.
+    void checkLastEvent(ts::TR101290Analyzer::Indicator indicator, ts::PID pid, bool raised);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TR101290AnalyzerTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void TR101290AnalyzerTest::setUp()
+{
+    _events.clear();
+    ::memset(_cc, 0, sizeof(_cc));
+}
+
+// Test suite cleanup method.
+void TR101290AnalyzerTest::tearDown()
+{
+}
+
+void TR101290AnalyzerTest::handleTR101290Event(ts::TR101290Analyzer& analyzer, const ts::TR101290Analyzer::Event& event)
+{
+    utest::Out() << "TR101290AnalyzerTest: " << (event.raised ? "raised " : "cleared ")
+                 << ts::TR101290Analyzer::IndicatorNames.name(event.indicator)
+                 << " at " << event.timestamp << " ns, " << event.details << std::endl;
+    _events.push_back(event);
+}
+
+void TR101290AnalyzerTest::MakePacket(ts::TSPacket& pkt, ts::PID pid, uint8_t cc)
+{
+    pkt.copyFrom(ts::NullPacket.b);
+    pkt.setPID(pid);
+    pkt.setCC(cc);
+}
+
+void TR101290AnalyzerTest::sendPacket(ts::TR101290Analyzer& analyzer, ts::PID pid, ts::NanoSecond time, bool pts)
+{
+    ts::TSPacket pkt;
+    MakePacket(pkt, pid, _cc[pid]++ & ts::CC_MASK);
+    if (pts) {
+        static const uint8_t header[] = {0x00, 0x00, 0x01, 0xC0, 0x00, 0x00, 0x80, 0x80, 0x05, 0x21, 0x00, 0x01, 0x00, 0x01};
+        pkt.setPUSI();
+        ::memcpy(pkt.b + 4, header, sizeof(header));
+        pkt.setPTS(uint64_t(time / (ts::NanoSecPerSec / 90000)));
+    }
+    analyzer.feedPacket(pkt, time);
+}
+
+void TR101290AnalyzerTest::sendPCR(ts::TR101290Analyzer& analyzer, ts::PID pid, ts::NanoSecond time, uint64_t pcr, bool discontinuity)
+{
+    ts::TSPacket pkt;
+    MakePacket(pkt, pid, _cc[pid] & ts::CC_MASK);
+    pkt.b[3] = 0x20 | (pkt.b[3] & 0x0F);
+    pkt.b[4] = 183;
+    pkt.b[5] = discontinuity ? 0x90 : 0x10;
+    ts::PutPCR(pkt.b + 6, pcr);
+    analyzer.feedPacket(pkt, time);
+}
+
+void TR101290AnalyzerTest::sendTable(ts::TR101290Analyzer& analyzer, ts::PID pid, const ts::AbstractTable& table, ts::NanoSecond time)
+{
+    ts::BinaryTable bin;
+    ts::TSPacketVector packets;
+    ts::OneShotPacketizer pzer(pid, true);
+    table.serialize(bin);
+    pzer.setNextContinuityCounter(_cc[pid]);
+    pzer.addTable(bin);
+    pzer.getPackets(packets);
+    _cc[pid] = pzer.nextContinuityCounter();
+    for (auto it = packets.begin(); it != packets.end(); ++it) {
+        analyzer.feedPacket(*it, time);
+    }
+}
+
+void TR101290AnalyzerTest::sendPSI(ts::TR101290Analyzer& analyzer, ts::NanoSecond time)
+{
+    ts::PAT pat(0, true, 1);
+    pat.pmts[1] = 1000;
+    ts::PMT pmt(0, true, 1, 100);
+    pmt.streams[101].stream_type = ts::ST_MPEG1_AUDIO;
+    pmt.streams[102].stream_type = ts::ST_PES_PRIV;
+    sendTable(analyzer, ts::PID_PAT, pat, time);
+    sendTable(analyzer, 1000, pmt, time);
+}
+
+void TR101290AnalyzerTest::checkLastEvent(ts::TR101290Analyzer::Indicator indicator, ts::PID pid, bool raised)
+{
+    CPPUNIT_ASSERT(!_events.empty());
+    CPPUNIT_ASSERT_EQUAL(indicator, _events.back().indicator);
+    CPPUNIT_ASSERT_EQUAL(pid, _events.back().pid);
+    CPPUNIT_ASSERT_EQUAL(raised, _events.back().raised);
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void TR101290AnalyzerTest::testContinuity()
+{
+    ts::TR101290Analyzer analyzer(this);
+    ts::TSPacket pkt;
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+
+    // Disable timers on missing tables.
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::UNREFERENCED_PID, false);
+
+    MakePacket(pkt, 100, 0);
+    analyzer.feedPacket(pkt, 0);
+    MakePacket(pkt, 100, 1);
+    analyzer.feedPacket(pkt, 1 * ms);
+    analyzer.feedPacket(pkt, 2 * ms);  // one duplicate is allowed
+    CPPUNIT_ASSERT(_events.empty());
+    analyzer.feedPacket(pkt, 3 * ms);  // second duplicate is an error
+    MakePacket(pkt, 100, 5);
+    analyzer.feedPacket(pkt, 4 * ms);  // missing packets
+
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), analyzer.errorCount(ts::TR101290Analyzer::CONTINUITY_COUNT_ERROR));
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::CONTINUITY_COUNT_ERROR));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), _events.size());
+    CPPUNIT_ASSERT(_events[0].raised);
+    CPPUNIT_ASSERT_EQUAL(ts::TR101290Analyzer::CONTINUITY_COUNT_ERROR, _events[0].indicator);
+    CPPUNIT_ASSERT_EQUAL(ts::PID(100), _events[0].pid);
+
+    // The alarm is cleared after the hold time without error.
+    MakePacket(pkt, 100, 6);
+    analyzer.feedPacket(pkt, 500 * ms);
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::CONTINUITY_COUNT_ERROR));
+    MakePacket(pkt, 100, 7);
+    analyzer.feedPacket(pkt, 1100 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::CONTINUITY_COUNT_ERROR));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), _events.size());
+    CPPUNIT_ASSERT(!_events[1].raised);
+    CPPUNIT_ASSERT_EQUAL(ts::TR101290Analyzer::CONTINUITY_COUNT_ERROR, _events[1].indicator);
+}
+
+void TR101290AnalyzerTest::testSyncLoss()
+{
+    ts::TR101290Analyzer analyzer(this);
+    ts::TSPacket pkt;
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::UNREFERENCED_PID, false);
+
+    MakePacket(pkt, ts::PID_NULL, 0);
+    analyzer.feedPacket(pkt, 0);
+    pkt.b[0] = 0x00;
+    analyzer.feedPacket(pkt, 1 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::TS_SYNC_LOSS));
+    analyzer.feedPacket(pkt, 2 * ms);
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::TS_SYNC_LOSS));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), analyzer.errorCount(ts::TR101290Analyzer::SYNC_BYTE_ERROR));
+
+    // Five correct sync bytes are required to recover.
+    pkt.b[0] = ts::SYNC_BYTE;
+    for (int i = 0; i < 4; ++i) {
+        analyzer.feedPacket(pkt, (3 + i) * ms);
+    }
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::TS_SYNC_LOSS));
+    analyzer.feedPacket(pkt, 7 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::TS_SYNC_LOSS));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.errorCount(ts::TR101290Analyzer::TS_SYNC_LOSS));
+}
+
+void TR101290AnalyzerTest::testTimers()
+{
+    ts::TR101290Analyzer analyzer(this);
+    ts::TSPacket pkt;
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+
+    // Without PAT, a PAT_error is reported after 500 ms, then every 500 ms.
+    MakePacket(pkt, ts::PID_NULL, 0);
+    analyzer.feedPacket(pkt, 0);
+    analyzer.feedPacket(pkt, 490 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::PAT_ERROR));
+    analyzer.feedPacket(pkt, 510 * ms);
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::PAT_ERROR));
+    analyzer.checkTimers(1020 * ms);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), analyzer.errorCount(ts::TR101290Analyzer::PAT_ERROR));
+
+    // Timer-type alarms are not cleared by the hold time.
+    analyzer.checkTimers(1990 * ms);
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::PAT_ERROR));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), analyzer.errorCount(ts::TR101290Analyzer::SDT_ERROR));
+    analyzer.checkTimers(2010 * ms);
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::SDT_ERROR));
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::EIT_ERROR));
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::NIT_ERROR));
+
+    // Disabled indicators are not counted.
+    analyzer.reset();
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.feedPacket(pkt, 0);
+    analyzer.checkTimers(2000 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::PAT_ERROR));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), analyzer.errorCount(ts::TR101290Analyzer::PAT_ERROR));
+}
+
+void TR101290AnalyzerTest::testPCRRepetition()
+{
+    ts::TR101290Analyzer analyzer(this);
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+    const uint64_t pcr_ms = ts::SYSTEM_CLOCK_FREQ / 1000;
+
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::UNREFERENCED_PID, false);
+
+    // One PCR every 20 ms.
+    for (int i = 0; i <= 5; ++i) {
+        sendPCR(analyzer, 100, 20 * i * ms, 20 * i * pcr_ms);
+    }
+    CPPUNIT_ASSERT(_events.empty());
+
+    // No PCR for more than 40 ms.
+    sendPacket(analyzer, 101, 130 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::PCR_REPETITION_ERROR));
+    sendPacket(analyzer, 101, 150 * ms);
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::PCR_REPETITION_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PCR_REPETITION_ERROR, 100, true);
+
+    // The alarm is cleared when the PCR reappears.
+    sendPCR(analyzer, 100, 160 * ms, 160 * pcr_ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::PCR_REPETITION_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PCR_REPETITION_ERROR, 100, false);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.errorCount(ts::TR101290Analyzer::PCR_REPETITION_ERROR));
+}
+
+void TR101290AnalyzerTest::testPCRDiscontinuity()
+{
+    ts::TR101290Analyzer analyzer(this);
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+    const uint64_t pcr_ms = ts::SYSTEM_CLOCK_FREQ / 1000;
+
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::UNREFERENCED_PID, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PCR_REPETITION_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PCR_ACCURACY_ERROR, false);
+
+    sendPCR(analyzer, 100, 0, 0);
+    sendPCR(analyzer, 100, 20 * ms, 20 * pcr_ms);
+
+    // A declared discontinuity is not an error.
+    sendPCR(analyzer, 100, 40 * ms, 5000 * pcr_ms, true);
+    sendPCR(analyzer, 100, 60 * ms, 5020 * pcr_ms);
+    CPPUNIT_ASSERT(_events.empty());
+
+    // Forward and backward jumps without discontinuity indicator.
+    sendPCR(analyzer, 100, 80 * ms, 5200 * pcr_ms);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.errorCount(ts::TR101290Analyzer::PCR_DISCONTINUITY_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PCR_DISCONTINUITY_ERROR, 100, true);
+    sendPCR(analyzer, 100, 100 * ms, 1000 * pcr_ms);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), analyzer.errorCount(ts::TR101290Analyzer::PCR_DISCONTINUITY_ERROR));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), _events.size());
+}
+
+void TR101290AnalyzerTest::testPCRAccuracy()
+{
+    ts::TR101290Analyzer analyzer(this);
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+    const uint64_t pcr_ms = ts::SYSTEM_CLOCK_FREQ / 1000;
+
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::UNREFERENCED_PID, false);
+
+    // One packet per millisecond, one PCR every 10 packets.
+    int index = 0;
+    for (; index < 100; ++index) {
+        if (index % 10 == 0) {
+            sendPCR(analyzer, 100, index * ms, index * pcr_ms);
+        }
+        else {
+            sendPacket(analyzer, 101, index * ms);
+        }
+    }
+    CPPUNIT_ASSERT(_events.empty());
+
+    // A PCR which is 1 us late, more than the 500 ns tolerance.
+    sendPCR(analyzer, 100, index * ms, index * pcr_ms + 27);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.errorCount(ts::TR101290Analyzer::PCR_ACCURACY_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PCR_ACCURACY_ERROR, 100, true);
+
+    // The analysis restarts from the inaccurate PCR, no new error on a regular stream.
+    // The alarm is cleared after the hold time.
+    for (++index; index < 1200; ++index) {
+        if (index % 10 == 0) {
+            sendPCR(analyzer, 100, index * ms, index * pcr_ms + 27);
+        }
+        else {
+            sendPacket(analyzer, 101, index * ms);
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.errorCount(ts::TR101290Analyzer::PCR_ACCURACY_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PCR_ACCURACY_ERROR, 100, false);
+}
+
+void TR101290AnalyzerTest::testPMT()
+{
+    ts::TR101290Analyzer analyzer(this);
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+
+    // A PAT without PMT.
+    ts::PAT pat(0, true, 1);
+    pat.pmts[1] = 1000;
+    sendTable(analyzer, ts::PID_PAT, pat, 0);
+    sendPacket(analyzer, ts::PID_NULL, 490 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::PMT_ERROR));
+    sendPacket(analyzer, ts::PID_NULL, 510 * ms);
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::PMT_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PMT_ERROR, 1000, true);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(1), _events.back().service_id);
+
+    // The alarm is cleared when the PMT is received.
+    sendPSI(analyzer, 600 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::PMT_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PMT_ERROR, 1000, false);
+
+    // A scrambled PMT packet is an error.
+    ts::TSPacket pkt;
+    MakePacket(pkt, 1000, _cc[1000]++ & ts::CC_MASK);
+    pkt.setScrambling(ts::SC_EVEN_KEY);
+    analyzer.feedPacket(pkt, 700 * ms);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(2), analyzer.errorCount(ts::TR101290Analyzer::PMT_ERROR));
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::PMT_ERROR));
+}
+
+void TR101290AnalyzerTest::testPID()
+{
+    ts::TR101290Analyzer analyzer(this);
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PMT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PCR_REPETITION_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PTS_ERROR, false);
+    analyzer.setPIDTimeout(1000 * ms);
+
+    // Referenced PID 102 is regularly present, then missing for more than 1 second.
+    sendPSI(analyzer, 0);
+    for (int i = 0; i < 10; ++i) {
+        sendPacket(analyzer, 101, 100 * i * ms);
+        sendPacket(analyzer, 102, 100 * i * ms);
+    }
+    CPPUNIT_ASSERT(_events.empty());
+    for (int i = 10; i < 20; ++i) {
+        sendPacket(analyzer, 101, 100 * i * ms);
+    }
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::PID_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PID_ERROR, 102, true);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(1), _events.back().service_id);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.errorCount(ts::TR101290Analyzer::PID_ERROR));
+
+    // The alarm is cleared when the PID reappears.
+    sendPacket(analyzer, 102, 1950 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::PID_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PID_ERROR, 102, false);
+}
+
+void TR101290AnalyzerTest::testPTS()
+{
+    ts::TR101290Analyzer analyzer(this);
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PMT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PCR_REPETITION_ERROR, false);
+
+    // Audio PID 101 has a PTS every 100 ms, then no PTS for more than 700 ms.
+    sendPSI(analyzer, 0);
+    for (int i = 0; i < 10; ++i) {
+        sendPacket(analyzer, 101, 100 * i * ms, true);
+        sendPacket(analyzer, 102, 100 * i * ms);
+    }
+    CPPUNIT_ASSERT(_events.empty());
+    for (int i = 10; i < 18; ++i) {
+        sendPacket(analyzer, 101, 100 * i * ms);
+        sendPacket(analyzer, 102, 100 * i * ms);
+    }
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::PTS_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PTS_ERROR, 101, true);
+
+    // PTS are not checked on the private data PID. The alarm is cleared when the PTS reappear.
+    sendPacket(analyzer, 101, 1800 * ms, true);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::PTS_ERROR));
+    checkLastEvent(ts::TR101290Analyzer::PTS_ERROR, 101, false);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.errorCount(ts::TR101290Analyzer::PTS_ERROR));
+}
+
+void TR101290AnalyzerTest::testUnreferencedPID()
+{
+    ts::TR101290Analyzer analyzer(this);
+    const ts::NanoSecond ms = ts::NanoSecPerMilliSec;
+
+    analyzer.setIndicator(ts::TR101290Analyzer::PAT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PMT_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PCR_REPETITION_ERROR, false);
+    analyzer.setIndicator(ts::TR101290Analyzer::PTS_ERROR, false);
+
+    // PID 300 is not referenced, the referenced PID 102 is not reported.
+    sendPSI(analyzer, 0);
+    for (int i = 0; i < 5; ++i) {
+        sendPacket(analyzer, 102, 100 * i * ms);
+        sendPacket(analyzer, 300, 100 * i * ms);
+    }
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::UNREFERENCED_PID));
+    sendPacket(analyzer, 300, 510 * ms);
+    CPPUNIT_ASSERT(analyzer.isActive(ts::TR101290Analyzer::UNREFERENCED_PID));
+    checkLastEvent(ts::TR101290Analyzer::UNREFERENCED_PID, 300, true);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), _events.size());
+
+    // The alarm is cleared when a new PMT references the PID.
+    ts::PMT pmt(1, true, 1, 100);
+    pmt.streams[101].stream_type = ts::ST_MPEG1_AUDIO;
+    pmt.streams[102].stream_type = ts::ST_PES_PRIV;
+    pmt.streams[300].stream_type = ts::ST_PES_PRIV;
+    sendTable(analyzer, 1000, pmt, 600 * ms);
+    CPPUNIT_ASSERT(!analyzer.isActive(ts::TR101290Analyzer::UNREFERENCED_PID));
+    checkLastEvent(ts::TR101290Analyzer::UNREFERENCED_PID, 300, false);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.errorCount(ts::TR101290Analyzer::UNREFERENCED_PID));
+}
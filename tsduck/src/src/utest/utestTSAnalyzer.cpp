@@ -0,0 +1,550 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::TSAnalyzer
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSAnalyzer.h"
+#include "tsTSAnalyzerReport.h"
+#include "tsOneShotPacketizer.h"
+#include "tsBinaryTable.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsSDT.h"
+#include "tsTDT.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class TSAnalyzerTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testAnalysisLevels();
+    void testMerge();
+    void testMergeMinimal();
+    void testJSONReport();
+    void testJSONDelta();
+
+    CPPUNIT_TEST_SUITE(TSAnalyzerTest);
+    CPPUNIT_TEST(testAnalysisLevels);
+    CPPUNIT_TEST(testMerge);
+    CPPUNIT_TEST(testMergeMinimal);
+    CPPUNIT_TEST(testJSONReport);
+    CPPUNIT_TEST(testJSONDelta);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    ts::TSPacketVector _packets;
+
+    // Compare the analysis of the stream in one piece and in two merged chunks.
+    void checkMerge(ts::TSAnalyzerOptions::AnalysisLevel level, size_t split);
+
+    // Number of packets of a PID in a range of the stream.
+    uint64_t countPackets(ts::PID pid, size_t first, size_t last) const;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TSAnalyzerTest);
+
+// Stream model: one service, PAT and PMT every 100 packets, SDT every 2000 packets,
+// TDT every 5000 packets, the other packets are private data. With reduced analysis
+// levels, a sampling window of 200 packets starts every 1000 packets.
+namespace {
+    const size_t        PACKET_COUNT = 60000;
+    const uint16_t      SERVICE_ID = 1;
+    const ts::PID       PMT_PID = 0x0100;
+    const ts::PID       DATA_PID = 0x0200;
+    const ts::PacketCounter SAMPLING_PERIOD = 1000;
+    const ts::PacketCounter SAMPLING_WINDOW = 200;
+
+    // A subclass of TSAnalyzer which gives access to the analysis contexts.
+    class Analyzer: public ts::TSAnalyzer
+    {
+    public:
+        using ts::TSAnalyzer::ETIDContext;
+        using ts::TSAnalyzer::ServiceContextMap;
+
+        Analyzer(ts::TSAnalyzerOptions::AnalysisLevel level = ts::TSAnalyzerOptions::FULL_ANALYSIS)
+        {
+            setAnalysisLevel(level, SAMPLING_PERIOD, SAMPLING_WINDOW);
+        }
+
+        uint64_t packetCount()
+        {
+            recomputeStatistics();
+            return _ts_pkt_cnt;
+        }
+
+        uint64_t pidPackets(ts::PID pid) const
+        {
+            const PIDContextMap::const_iterator it(_pids.find(pid));
+            return it == _pids.end() ? 0 : it->second->ts_pkt_cnt;
+        }
+
+        uint64_t pidDiscontinuities(ts::PID pid) const
+        {
+            const PIDContextMap::const_iterator it(_pids.find(pid));
+            return it == _pids.end() ? 0 : it->second->unexp_discont;
+        }
+
+        const ServiceContextMap& services() const
+        {
+            return _services;
+        }
+
+        const ETIDContext* table(ts::PID pid, ts::TID tid) const
+        {
+            const PIDContextMap::const_iterator it(_pids.find(pid));
+            if (it != _pids.end()) {
+                for (ETIDContextMap::const_iterator et = it->second->sections.begin(); et != it->second->sections.end(); ++et) {
+                    if (et->first.tid() == tid) {
+                        return et->second.pointer();
+                    }
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    // Packetize a table in exactly one packet.
+    ts::TSPacket OnePacket(ts::PID pid, const ts::AbstractTable& table)
+    {
+        ts::BinaryTable bin;
+        table.serialize(bin);
+        ts::OneShotPacketizer pzer(pid, true);
+        pzer.addTable(bin);
+        ts::TSPacketVector packets;
+        pzer.getPackets(packets);
+        CPPUNIT_ASSERT_EQUAL(size_t(1), packets.size());
+        return packets[0];
+    }
+
+    // Parse a JSON text, as produced by the analyzer report.
+    ts::json::ValuePtr ParseJSON(const ts::UString& text)
+    {
+        ts::json::ValuePtr value;
+        CPPUNIT_ASSERT(ts::json::Parse(value, text));
+        CPPUNIT_ASSERT(!value.isNull());
+        CPPUNIT_ASSERT(value->isObject());
+        return value;
+    }
+
+    // Find the element of a JSON array of objects with a given numeric field, a null value if not found.
+    const ts::json::Value& FindObject(const ts::json::Value& array, const ts::UString& field, int64_t value)
+    {
+        CPPUNIT_ASSERT(array.isArray());
+        for (size_t i = 0; i < array.size(); ++i) {
+            if (array.at(i).value(field).toInteger(-1) == value) {
+                return array.at(i);
+            }
+        }
+        return array.at(array.size());
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void TSAnalyzerTest::setUp()
+{
+    ts::PAT pat(0, true, 1);
+    pat.pmts[SERVICE_ID] = PMT_PID;
+    ts::PMT pmt(0, true, SERVICE_ID, ts::PID_NULL);
+    pmt.streams[DATA_PID].stream_type = ts::ST_PRIV_SECT;
+    ts::SDT sdt(true, 0, true, 1, 2);
+    sdt.services[SERVICE_ID].setName(u"Test");
+    ts::TDT tdt(ts::Time(2019, 1, 1, 0, 0));
+
+    const ts::TSPacket pat_pkt(OnePacket(ts::PID_PAT, pat));
+    const ts::TSPacket pmt_pkt(OnePacket(PMT_PID, pmt));
+    const ts::TSPacket sdt_pkt(OnePacket(ts::PID_SDT, sdt));
+    const ts::TSPacket tdt_pkt(OnePacket(ts::PID_TDT, tdt));
+    ts::TSPacket data_pkt(ts::NullPacket);
+    data_pkt.setPID(DATA_PID);
+
+    uint8_t cc[ts::PID_MAX] = {0};
+    _packets.resize(PACKET_COUNT);
+    for (size_t i = 0; i < PACKET_COUNT; ++i) {
+        ts::TSPacket& pkt(_packets[i]);
+        if (i % 100 == 0) {
+            pkt = pat_pkt;
+        }
+        else if (i % 100 == 50) {
+            pkt = pmt_pkt;
+        }
+        else if (i % 2000 == 70) {
+            pkt = sdt_pkt;
+        }
+        else if (i % 5000 == 20) {
+            pkt = tdt_pkt;
+        }
+        else {
+            pkt = data_pkt;
+        }
+        pkt.setCC(cc[pkt.getPID()]++ & 0x0F);
+    }
+}
+
+// Test suite cleanup method.
+void TSAnalyzerTest::tearDown()
+{
+    _packets.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void TSAnalyzerTest::testAnalysisLevels()
+{
+    Analyzer full(ts::TSAnalyzerOptions::FULL_ANALYSIS);
+    Analyzer light(ts::TSAnalyzerOptions::LIGHT_ANALYSIS);
+    Analyzer minimal(ts::TSAnalyzerOptions::MINIMAL_ANALYSIS);
+    for (size_t i = 0; i < _packets.size(); ++i) {
+        full.feedPacket(_packets[i]);
+        light.feedPacket(_packets[i]);
+        minimal.feedPacket(_packets[i]);
+    }
+
+    // Packets are counted at all levels.
+    CPPUNIT_ASSERT_EQUAL(uint64_t(PACKET_COUNT), full.packetCount());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(PACKET_COUNT), light.packetCount());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(PACKET_COUNT), minimal.packetCount());
+    const ts::PID pids[] = {ts::PID_PAT, PMT_PID, ts::PID_SDT, ts::PID_TDT, DATA_PID};
+    for (size_t i = 0; i < sizeof(pids) / sizeof(pids[0]); ++i) {
+        CPPUNIT_ASSERT(full.pidPackets(pids[i]) > 0);
+        CPPUNIT_ASSERT_EQUAL(full.pidPackets(pids[i]), light.pidPackets(pids[i]));
+        CPPUNIT_ASSERT_EQUAL(full.pidPackets(pids[i]), minimal.pidPackets(pids[i]));
+    }
+
+    // Services are found at all levels.
+    const Analyzer* const all[] = {&full, &light, &minimal};
+    for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); ++i) {
+        CPPUNIT_ASSERT_EQUAL(size_t(1), all[i]->services().size());
+        const Analyzer::ServiceContextMap::const_iterator srv(all[i]->services().find(SERVICE_ID));
+        CPPUNIT_ASSERT(srv != all[i]->services().end());
+        CPPUNIT_ASSERT_EQUAL(PMT_PID, srv->second->pmt_pid);
+        CPPUNIT_ASSERT_USTRINGS_EQUAL(u"Test", srv->second->name);
+    }
+
+    // Tables: expected count and repetition interval with a full analysis.
+    struct TableRef {
+        ts::PID  pid;
+        ts::TID  tid;
+        uint64_t count;
+        uint64_t repetition;
+    };
+    const TableRef refs[] = {
+        {ts::PID_PAT, ts::TID_PAT, PACKET_COUNT / 100,  100},
+        {PMT_PID,     ts::TID_PMT, PACKET_COUNT / 100,  100},
+        {ts::PID_SDT, ts::TID_SDT_ACT, PACKET_COUNT / 2000, 2000},
+        {ts::PID_TDT, ts::TID_TDT, PACKET_COUNT / 5000, 5000},
+    };
+
+    for (size_t i = 0; i < sizeof(refs) / sizeof(refs[0]); ++i) {
+        const TableRef& ref(refs[i]);
+        const Analyzer::ETIDContext* f = full.table(ref.pid, ref.tid);
+        const Analyzer::ETIDContext* l = light.table(ref.pid, ref.tid);
+        const Analyzer::ETIDContext* m = minimal.table(ref.pid, ref.tid);
+        CPPUNIT_ASSERT(f != nullptr);
+        CPPUNIT_ASSERT(l != nullptr);
+        CPPUNIT_ASSERT(m != nullptr);
+        utest::Out() << "TSAnalyzerTest: PID " << ref.pid << ", TID " << int(ref.tid)
+                     << ": full " << f->table_count << "/" << f->repetition_ts
+                     << ", light " << l->table_count << "/" << l->repetition_ts
+                     << ", minimal " << m->table_count << "/" << m->repetition_ts
+                     << " (" << m->skipped_count << " skipped)" << std::endl;
+
+        // Full analysis.
+        CPPUNIT_ASSERT_EQUAL(ref.count, f->table_count);
+        CPPUNIT_ASSERT_EQUAL(ref.repetition, f->repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(ref.repetition, f->min_repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(ref.repetition, f->max_repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(0), f->skipped_count);
+
+        // Light analysis: all PSI/SI are analyzed, same results as full analysis.
+        CPPUNIT_ASSERT_EQUAL(f->table_count, l->table_count);
+        CPPUNIT_ASSERT_EQUAL(f->repetition_ts, l->repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(f->min_repetition_ts, l->min_repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(f->max_repetition_ts, l->max_repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(uint64_t(0), l->skipped_count);
+
+        // Minimal analysis: only tables in sampling windows are seen, intervals which span
+        // unsampled packets are skipped, all other intervals are true repetition intervals.
+        CPPUNIT_ASSERT(m->table_count > 0);
+        CPPUNIT_ASSERT(m->table_count <= f->table_count);
+        CPPUNIT_ASSERT(m->skipped_count > 0);
+        CPPUNIT_ASSERT(m->skipped_count < m->table_count);
+        if (ref.repetition < SAMPLING_WINDOW) {
+            CPPUNIT_ASSERT_EQUAL(f->repetition_ts, m->repetition_ts);
+            CPPUNIT_ASSERT_EQUAL(f->min_repetition_ts, m->min_repetition_ts);
+            CPPUNIT_ASSERT_EQUAL(f->max_repetition_ts, m->max_repetition_ts);
+        }
+        else {
+            // All occurences are in sampling windows but no repetition interval can be measured.
+            CPPUNIT_ASSERT_EQUAL(f->table_count, m->table_count);
+            CPPUNIT_ASSERT_EQUAL(m->table_count - 1, m->skipped_count);
+            CPPUNIT_ASSERT_EQUAL(uint64_t(0), m->repetition_ts);
+        }
+    }
+}
+
+void TSAnalyzerTest::testMerge()
+{
+    checkMerge(ts::TSAnalyzerOptions::FULL_ANALYSIS, 31234);
+}
+
+void TSAnalyzerTest::testMergeMinimal()
+{
+    // The chunk boundary is outside, then inside, a sampling window.
+    checkMerge(ts::TSAnalyzerOptions::MINIMAL_ANALYSIS, 31234);
+    checkMerge(ts::TSAnalyzerOptions::MINIMAL_ANALYSIS, 31110);
+}
+
+void TSAnalyzerTest::checkMerge(ts::TSAnalyzerOptions::AnalysisLevel level, size_t split)
+{
+    // Analyze the stream in one piece.
+    Analyzer whole(level);
+    for (size_t i = 0; i < _packets.size(); ++i) {
+        whole.feedPacket(_packets[i]);
+    }
+
+    // Analyze the stream in two chunks, in the middle of table repetition intervals.
+    // The second chunk is warmed up with packets from the end of the first one.
+    const size_t warm_up = 5000;
+    Analyzer first(level);
+    Analyzer second(level);
+    for (size_t i = 0; i < split; ++i) {
+        first.feedPacket(_packets[i]);
+    }
+    second.setPacketIndex(split);
+    for (size_t i = split - warm_up; i < split; ++i) {
+        second.warmUp(_packets[i]);
+    }
+    for (size_t i = split; i < _packets.size(); ++i) {
+        second.feedPacket(_packets[i]);
+    }
+    first.merge(second);
+
+    // Packet counts, no continuity error at the chunk boundary.
+    CPPUNIT_ASSERT_EQUAL(uint64_t(PACKET_COUNT), whole.packetCount());
+    CPPUNIT_ASSERT_EQUAL(whole.packetCount(), first.packetCount());
+    const ts::PID pids[] = {ts::PID_PAT, PMT_PID, ts::PID_SDT, ts::PID_TDT, DATA_PID};
+    for (size_t i = 0; i < sizeof(pids) / sizeof(pids[0]); ++i) {
+        CPPUNIT_ASSERT(whole.pidPackets(pids[i]) > 0);
+        CPPUNIT_ASSERT_EQUAL(whole.pidPackets(pids[i]), first.pidPackets(pids[i]));
+        CPPUNIT_ASSERT_EQUAL(uint64_t(0), whole.pidDiscontinuities(pids[i]));
+        CPPUNIT_ASSERT_EQUAL(uint64_t(0), first.pidDiscontinuities(pids[i]));
+    }
+
+    // Services.
+    CPPUNIT_ASSERT_EQUAL(size_t(1), whole.services().size());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), first.services().size());
+    const Analyzer::ServiceContextMap::const_iterator srv(first.services().find(SERVICE_ID));
+    CPPUNIT_ASSERT(srv != first.services().end());
+    CPPUNIT_ASSERT_EQUAL(PMT_PID, srv->second->pmt_pid);
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"Test", srv->second->name);
+
+    // Tables, including the repetition intervals across the chunk boundary.
+    const ts::PID tpids[] = {ts::PID_PAT, PMT_PID, ts::PID_SDT, ts::PID_TDT};
+    const ts::TID tids[] = {ts::TID_PAT, ts::TID_PMT, ts::TID_SDT_ACT, ts::TID_TDT};
+    for (size_t i = 0; i < sizeof(tids) / sizeof(tids[0]); ++i) {
+        const Analyzer::ETIDContext* w = whole.table(tpids[i], tids[i]);
+        const Analyzer::ETIDContext* m = first.table(tpids[i], tids[i]);
+        CPPUNIT_ASSERT(w != nullptr);
+        CPPUNIT_ASSERT(m != nullptr);
+        utest::Out() << "TSAnalyzerTest: level " << int(level) << ", split " << split
+                     << ", PID " << tpids[i] << ", TID " << int(tids[i])
+                     << ": whole " << w->table_count << "/" << w->repetition_ts
+                     << ", merged " << m->table_count << "/" << m->repetition_ts << std::endl;
+        CPPUNIT_ASSERT(w->table_count > 1);
+        CPPUNIT_ASSERT_EQUAL(w->table_count, m->table_count);
+        CPPUNIT_ASSERT_EQUAL(w->skipped_count, m->skipped_count);
+        CPPUNIT_ASSERT_EQUAL(w->skipped_ts, m->skipped_ts);
+        CPPUNIT_ASSERT_EQUAL(w->section_count, m->section_count);
+        CPPUNIT_ASSERT_EQUAL(w->repetition_ts, m->repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(w->min_repetition_ts, m->min_repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(w->max_repetition_ts, m->max_repetition_ts);
+        CPPUNIT_ASSERT_EQUAL(w->first_pkt, m->first_pkt);
+        CPPUNIT_ASSERT_EQUAL(w->last_pkt, m->last_pkt);
+        CPPUNIT_ASSERT(w->versions == m->versions);
+    }
+}
+
+uint64_t TSAnalyzerTest::countPackets(ts::PID pid, size_t first, size_t last) const
+{
+    uint64_t count = 0;
+    for (size_t i = first; i < last; ++i) {
+        count += _packets[i].getPID() == pid;
+    }
+    return count;
+}
+
+void TSAnalyzerTest::testJSONReport()
+{
+    // Without PCR, the bitrate is the hint.
+    ts::TSAnalyzerReport report(10000000);
+    for (size_t i = 0; i < _packets.size(); ++i) {
+        report.feedPacket(_packets[i]);
+    }
+
+    std::ostringstream text;
+    report.reportJSON(text, u"test");
+    const ts::json::ValuePtr root(ParseJSON(ts::UString::FromUTF8(text.str())));
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"test", root->value(u"title").toString());
+
+    const ts::json::Value& jts(root->value(u"ts"));
+    CPPUNIT_ASSERT_EQUAL(int64_t(PACKET_COUNT), jts.value(u"packets").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(PACKET_COUNT * ts::PKT_SIZE), jts.value(u"bytes").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(10000000), jts.value(u"bitrate").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(PACKET_COUNT * ts::PKT_SIZE * 8 * 1000 / 10000000), jts.value(u"duration-ms").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(1), jts.value(u"id").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(1), jts.value(u"services").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(5), jts.value(u"pids").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(0), jts.value(u"transport-errors").toInteger());
+
+    // Service.
+    const ts::json::Value& services(root->value(u"services"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), services.size());
+    const ts::json::Value& srv(FindObject(services, u"id", SERVICE_ID));
+    CPPUNIT_ASSERT(srv.isObject());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"Test", srv.value(u"name").toString());
+    CPPUNIT_ASSERT_EQUAL(int64_t(PMT_PID), srv.value(u"pmt-pid").toInteger());
+    CPPUNIT_ASSERT(srv.value(u"scrambled").isFalse());
+
+    // PID's.
+    const ts::json::Value& pids(root->value(u"pids"));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), pids.size());
+    const ts::PID pid_list[] = {ts::PID_PAT, PMT_PID, ts::PID_SDT, ts::PID_TDT, DATA_PID};
+    for (size_t i = 0; i < sizeof(pid_list) / sizeof(pid_list[0]); ++i) {
+        const ts::json::Value& pid(FindObject(pids, u"id", pid_list[i]));
+        CPPUNIT_ASSERT(pid.isObject());
+        CPPUNIT_ASSERT_EQUAL(int64_t(countPackets(pid_list[i], 0, _packets.size())), pid.value(u"packets").toInteger());
+        CPPUNIT_ASSERT_EQUAL(int64_t(0), pid.value(u"discontinuities").toInteger());
+    }
+    CPPUNIT_ASSERT(FindObject(pids, u"id", PMT_PID).value(u"pmt").isTrue());
+    CPPUNIT_ASSERT(FindObject(pids, u"id", DATA_PID).value(u"referenced").isTrue());
+    CPPUNIT_ASSERT_EQUAL(int64_t(SERVICE_ID), FindObject(pids, u"id", DATA_PID).value(u"services").at(0).toInteger());
+
+    // Tables.
+    const ts::json::Value& tables(root->value(u"tables"));
+    const ts::json::Value& pat(FindObject(tables, u"tid", ts::TID_PAT));
+    CPPUNIT_ASSERT(pat.isObject());
+    CPPUNIT_ASSERT_EQUAL(int64_t(ts::PID_PAT), pat.value(u"pid").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(PACKET_COUNT / 100), pat.value(u"tables").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(100), pat.value(u"repetition-pkt").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(100 * ts::PKT_SIZE * 8 * 1000 / 10000000), pat.value(u"repetition-ms").toInteger());
+    const ts::json::Value& sdt(FindObject(tables, u"tid", ts::TID_SDT_ACT));
+    CPPUNIT_ASSERT(sdt.isObject());
+    CPPUNIT_ASSERT_EQUAL(int64_t(PACKET_COUNT / 2000), sdt.value(u"tables").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(2000), sdt.value(u"repetition-pkt").toInteger());
+}
+
+void TSAnalyzerTest::testJSONDelta()
+{
+    // In the second half of the stream, the PMT has a new version.
+    const size_t half = PACKET_COUNT / 2;
+    ts::PMT pmt(1, true, SERVICE_ID, ts::PID_NULL);
+    pmt.streams[DATA_PID].stream_type = ts::ST_PRIV_SECT;
+    const ts::TSPacket pmt_pkt(OnePacket(PMT_PID, pmt));
+    for (size_t i = half; i < _packets.size(); ++i) {
+        if (_packets[i].getPID() == PMT_PID) {
+            const uint8_t cc = _packets[i].getCC();
+            _packets[i] = pmt_pkt;
+            _packets[i].setCC(cc);
+        }
+    }
+
+    ts::TSAnalyzerReport report(10000000);
+    report.setDeltaTracking(true);
+
+    // First delta: all PID's, the service and the tables are new.
+    for (size_t i = 0; i < half; ++i) {
+        report.feedPacket(_packets[i]);
+    }
+    const ts::json::ValuePtr delta1(ParseJSON(report.jsonDelta(u"delta")->oneLiner()));
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"delta", delta1->value(u"title").toString());
+    CPPUNIT_ASSERT_EQUAL(int64_t(half), delta1->value(u"ts").value(u"packets").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(half), delta1->value(u"ts").value(u"total-packets").toInteger());
+
+    const ts::json::Value& pids1(delta1->value(u"pids"));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), pids1.size());
+    const ts::json::Value& data1(FindObject(pids1, u"id", DATA_PID));
+    CPPUNIT_ASSERT(data1.isObject());
+    CPPUNIT_ASSERT(data1.value(u"new").isTrue());
+    CPPUNIT_ASSERT_EQUAL(int64_t(countPackets(DATA_PID, 0, half)), data1.value(u"packets").toInteger());
+
+    const ts::json::Value& services1(delta1->value(u"services"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), services1.size());
+    CPPUNIT_ASSERT_USTRINGS_EQUAL(u"Test", FindObject(services1, u"id", SERVICE_ID).value(u"name").toString());
+
+    const ts::json::Value& tables1(delta1->value(u"tables"));
+    const ts::json::Value& pmt1(FindObject(tables1, u"tid", ts::TID_PMT));
+    CPPUNIT_ASSERT(pmt1.isObject());
+    CPPUNIT_ASSERT(pmt1.value(u"new").isTrue());
+    CPPUNIT_ASSERT_EQUAL(int64_t(0), pmt1.value(u"last-version").toInteger());
+    CPPUNIT_ASSERT(FindObject(tables1, u"tid", ts::TID_PAT).isObject());
+
+    // Second delta: only the counters of the interval and the new PMT version.
+    for (size_t i = half; i < _packets.size(); ++i) {
+        report.feedPacket(_packets[i]);
+    }
+    const ts::json::ValuePtr delta2(ParseJSON(report.jsonDelta()->oneLiner()));
+    CPPUNIT_ASSERT_EQUAL(int64_t(PACKET_COUNT - half), delta2->value(u"ts").value(u"packets").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(PACKET_COUNT), delta2->value(u"ts").value(u"total-packets").toInteger());
+
+    const ts::json::Value& pids2(delta2->value(u"pids"));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), pids2.size());
+    const ts::json::Value& data2(FindObject(pids2, u"id", DATA_PID));
+    CPPUNIT_ASSERT(data2.isObject());
+    CPPUNIT_ASSERT(data2.value(u"new").isFalse());
+    CPPUNIT_ASSERT_EQUAL(int64_t(countPackets(DATA_PID, half, _packets.size())), data2.value(u"packets").toInteger());
+    CPPUNIT_ASSERT_EQUAL(int64_t(0), data2.value(u"discontinuities").toInteger());
+
+    const ts::json::Value& services2(delta2->value(u"services"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), services2.size());
+
+    const ts::json::Value& tables2(delta2->value(u"tables"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), tables2.size());
+    const ts::json::Value& pmt2(FindObject(tables2, u"tid", ts::TID_PMT));
+    CPPUNIT_ASSERT(pmt2.isObject());
+    CPPUNIT_ASSERT(pmt2.value(u"new").isFalse());
+    CPPUNIT_ASSERT_EQUAL(int64_t(1), pmt2.value(u"last-version").toInteger());
+}
@@ -0,0 +1,400 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for TS file input and output.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSFileInput.h"
+#include "tsTSFileInputBuffered.h"
+#include "tsTSFileRecorder.h"
+#include "tsTSPacketIndex.h"
+#include "tsOneShotPacketizer.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsTSFileOutput.h"
+#include "tsSysUtils.h"
+#include "tsNullReport.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class TSFileTest: public CppUnit::TestFixture
+{
+public:
+    TSFileTest();
+
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testSyncIO();
+    void testAsyncIO();
+    void testMemoryMap();
+    void testBufferedMap();
+    void testRecorder();
+    void testIndex();
+
+    CPPUNIT_TEST_SUITE(TSFileTest);
+    CPPUNIT_TEST(testSyncIO);
+    CPPUNIT_TEST(testAsyncIO);
+    CPPUNIT_TEST(testMemoryMap);
+    CPPUNIT_TEST(testBufferedMap);
+    CPPUNIT_TEST(testRecorder);
+    CPPUNIT_TEST(testIndex);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    ts::UString _tempFile;
+
+    // Write and read back a file using the specified I/O parameters.
+    void writeRead(size_t depth, size_t block_size, bool direct);
+
+    // Write a file with distinct packets.
+    void writeFile(ts::TSPacketVector& packets, size_t count);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TSFileTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+TSFileTest::TSFileTest() :
+    _tempFile()
+{
+}
+
+// Test suite initialization method.
+void TSFileTest::setUp()
+{
+    _tempFile = ts::TempFile(u".ts");
+}
+
+// Test suite cleanup method.
+void TSFileTest::tearDown()
+{
+    ts::DeleteFile(_tempFile);
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void TSFileTest::testSyncIO()
+{
+    writeRead(0, 0, false);
+}
+
+void TSFileTest::testAsyncIO()
+{
+    // The block sizes are not multiples of the packet size. When io_uring is
+    // not supported by the system, this is a test of the fallback.
+    writeRead(3, 10000, false);
+    writeRead(2, 8192, true);
+    writeRead(5, 1024 * 1024, true);
+}
+
+void TSFileTest::testMemoryMap()
+{
+    const size_t count = 1000;
+    ts::TSPacketVector packets;
+    writeFile(packets, count);
+
+    // Read twice without copy, starting at packet 10, with small read-ahead windows.
+    const size_t start = 10;
+    ts::TSFileInput in;
+    in.setMemoryMap(true, 4096);
+    CPPUNIT_ASSERT(in.open(_tempFile, 2, start * ts::PKT_SIZE, NULLREP));
+#if defined(TS_UNIX)
+    CPPUNIT_ASSERT(in.isMemoryMapped());
+#endif
+
+    const ts::TSPacket* data = nullptr;
+    size_t total = 0;
+    size_t got = 0;
+    while ((got = in.readMapped(data, 64, NULLREP)) > 0) {
+        CPPUNIT_ASSERT(got <= 64);
+        for (size_t i = 0; i < got; ++i) {
+            CPPUNIT_ASSERT(data[i] == packets[start + (total + i) % (count - start)]);
+        }
+        total += got;
+    }
+    CPPUNIT_ASSERT_EQUAL(2 * (count - start), total);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(total), in.getPacketCount());
+    CPPUNIT_ASSERT(in.close(NULLREP));
+    CPPUNIT_ASSERT(!in.isMemoryMapped());
+
+    // Copy from the mapping in rewindable mode.
+    ts::TSPacketVector input(count);
+    CPPUNIT_ASSERT(in.open(_tempFile, 0, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(300), in.read(&input[0], 300, NULLREP));
+    CPPUNIT_ASSERT(in.seek(900, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(100), in.read(&input[300], 300, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), in.read(&input[400], 300, NULLREP));
+    CPPUNIT_ASSERT(in.close(NULLREP));
+    for (size_t i = 0; i < 400; ++i) {
+        CPPUNIT_ASSERT(input[i] == packets[i < 300 ? i : i + 600]);
+    }
+}
+
+void TSFileTest::testBufferedMap()
+{
+    const size_t count = 1000;
+    ts::TSPacketVector packets;
+    writeFile(packets, count);
+
+    ts::TSFileInputBuffered in(100);
+    in.setMemoryMap(true);
+    CPPUNIT_ASSERT(in.open(_tempFile, 1, 0, NULLREP));
+
+    const ts::TSPacket* data = nullptr;
+    CPPUNIT_ASSERT_EQUAL(size_t(250), in.readMapped(data, 250, NULLREP));
+    CPPUNIT_ASSERT(data[249] == packets[249]);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(250), in.getPacketCount());
+
+    // Seek back in the buffer, packets are returned from the buffer.
+    CPPUNIT_ASSERT(in.seekBackward(30, NULLREP));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(220), in.getPacketCount());
+    CPPUNIT_ASSERT_EQUAL(size_t(30), in.readMapped(data, 50, NULLREP));
+    for (size_t i = 0; i < 30; ++i) {
+        CPPUNIT_ASSERT(data[i] == packets[220 + i]);
+    }
+
+    // Then from the file again.
+    CPPUNIT_ASSERT_EQUAL(size_t(50), in.readMapped(data, 50, NULLREP));
+    CPPUNIT_ASSERT(data[0] == packets[250]);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(300), in.getPacketCount());
+    CPPUNIT_ASSERT(in.close(NULLREP));
+}
+
+void TSFileTest::testRecorder()
+{
+    const size_t count = 1000;
+    ts::TSPacketVector packets(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i] = ts::NullPacket;
+        ts::PutUInt32(packets[i].b + 4, uint32_t(i));
+    }
+
+    // Segments of 300 packets, plus some bytes which are not a complete packet.
+    // Use a write-behind buffer which is smaller than the written blocks.
+    ts::TSFileRecorder rec;
+    rec.setSegmentation(300 * ts::PKT_SIZE + 100, 0);
+    rec.setWriteBehind(64);
+    CPPUNIT_ASSERT(rec.isSegmented());
+    CPPUNIT_ASSERT(rec.open(_tempFile, false, false, NULLREP));
+    for (size_t i = 0; i < count; i += 150) {
+        CPPUNIT_ASSERT(rec.write(&packets[i], std::min<size_t>(150, count - i), NULLREP));
+    }
+    CPPUNIT_ASSERT(rec.close(NULLREP));
+
+    ts::TSFileRecorder::Statistics stats;
+    rec.getStatistics(stats);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(count), stats.packets);
+    CPPUNIT_ASSERT_EQUAL(size_t(4), stats.files);
+    CPPUNIT_ASSERT_EQUAL(size_t(64), stats.buffer_size);
+    CPPUNIT_ASSERT(stats.high_water <= 64);
+    CPPUNIT_ASSERT(stats.write_latency.count() > 0);
+
+    // The segments are sorted in sequence order.
+    ts::UStringVector files;
+    CPPUNIT_ASSERT(ts::ExpandWildcard(files, ts::PathPrefix(_tempFile) + u"-*" + ts::PathSuffix(_tempFile)));
+    CPPUNIT_ASSERT_EQUAL(size_t(4), files.size());
+    std::sort(files.begin(), files.end());
+
+    size_t total = 0;
+    for (size_t f = 0; f < files.size(); ++f) {
+        CPPUNIT_ASSERT_EQUAL(int64_t((f < 3 ? 300 : 100) * ts::PKT_SIZE), ts::GetFileSize(files[f]));
+        ts::TSFileInput in;
+        CPPUNIT_ASSERT(in.open(files[f], 1, 0, NULLREP));
+        ts::TSPacket pkt;
+        while (in.read(&pkt, 1, NULLREP) == 1) {
+            CPPUNIT_ASSERT(pkt == packets[total++]);
+        }
+        CPPUNIT_ASSERT(in.close(NULLREP));
+        ts::DeleteFile(files[f]);
+    }
+    CPPUNIT_ASSERT_EQUAL(count, total);
+}
+
+void TSFileTest::testIndex()
+{
+    // One PCR every 10 packets, 100 ms apart, a random access point every 100 packets.
+    // A PAT in packets 5 (version 0) and 505 (version 1), a PMT in packet 6.
+    // Random access points on the video PID in packet 305 and on the audio PID in packet 255.
+    const size_t count = 1000;
+    ts::TSPacketVector packets(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i] = ts::NullPacket;
+        if (i % 10 == 0) {
+            packets[i].setPID(0x0100);
+            packets[i].b[3] = 0x20;
+            packets[i].b[4] = 183;
+            packets[i].b[5] = i % 100 == 0 ? 0x50 : 0x10;
+            ::memset(packets[i].b + 12, 0xFF, ts::PKT_SIZE - 12);
+            packets[i].setPCR(uint64_t(i / 10) * (ts::SYSTEM_CLOCK_FREQ / 10));
+        }
+        else if (i == 5 || i == 505) {
+            ts::PAT pat(i == 5 ? 0 : 1, true, 0x1234);
+            pat.pmts[1] = 0x0200;
+            ts::OneShotPacketizer pzer(ts::PID_PAT);
+            pzer.addTable(pat);
+            ts::TSPacketVector pat_packets;
+            pzer.getPackets(pat_packets);
+            CPPUNIT_ASSERT_EQUAL(size_t(1), pat_packets.size());
+            packets[i] = pat_packets[0];
+        }
+        else if (i == 6) {
+            ts::PMT pmt(0, true, 1, 0x0100);
+            pmt.streams[0x0101].stream_type = ts::ST_MPEG2_VIDEO;
+            pmt.streams[0x0102].stream_type = ts::ST_MPEG2_AUDIO;
+            ts::OneShotPacketizer pzer(0x0200);
+            pzer.addTable(pmt);
+            ts::TSPacketVector pmt_packets;
+            pzer.getPackets(pmt_packets);
+            CPPUNIT_ASSERT_EQUAL(size_t(1), pmt_packets.size());
+            packets[i] = pmt_packets[0];
+        }
+        else if (i == 255 || i == 305) {
+            packets[i].setPID(i == 255 ? 0x0102 : 0x0101);
+            packets[i].b[3] = 0x30;
+            packets[i].b[4] = 1;
+            packets[i].b[5] = 0x40;
+        }
+    }
+
+    // Record the file with its index.
+    ts::TSFileRecorder rec;
+    rec.setIndex(true);
+    CPPUNIT_ASSERT(rec.open(_tempFile, false, false, NULLREP));
+    for (size_t i = 0; i < count; i += 150) {
+        CPPUNIT_ASSERT(rec.write(&packets[i], std::min<size_t>(150, count - i), NULLREP));
+    }
+    CPPUNIT_ASSERT(rec.close(NULLREP));
+
+    const ts::UString index_name(ts::TSPacketIndex::IndexFileName(_tempFile));
+    CPPUNIT_ASSERT_EQUAL(int64_t(ts::TSPacketIndex::HEADER_SIZE + 22 * ts::TSPacketIndex::ENTRY_SIZE), ts::GetFileSize(index_name));
+
+    ts::TSPacketIndex index;
+    CPPUNIT_ASSERT(index.load(index_name, NULLREP));
+    ts::DeleteFile(index_name);
+    CPPUNIT_ASSERT_EQUAL(size_t(22), index.entries().size());
+
+    const ts::TSPacketIndex::Entry& psi(index.entries()[13]);
+    CPPUNIT_ASSERT_EQUAL(ts::TSPacketIndex::PSI, psi.type);
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(505), psi.packet);
+    CPPUNIT_ASSERT_EQUAL(ts::PID(ts::PID_PAT), psi.pid);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(ts::TID_PAT), psi.table_id);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(0x1234), psi.table_id_ext);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(1), psi.version);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(450000), psi.time);
+
+    ts::PacketCounter packet = 0;
+    CPPUNIT_ASSERT(index.findTime(2500, packet));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(200), packet);
+    CPPUNIT_ASSERT(index.findTime(3500, packet));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(305), packet);
+    CPPUNIT_ASSERT(index.findTime(60000, packet));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(900), packet);
+    CPPUNIT_ASSERT(index.findPSIChange(1, packet));
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(505), packet);
+    CPPUNIT_ASSERT(!index.findPSIChange(2, packet));
+
+    // Same index when built in memory.
+    ts::TSPacketIndex mem;
+    for (size_t i = 0; i < count; ++i) {
+        mem.feedPacket(packets[i]);
+    }
+    ts::ByteBlock data1, data2;
+    index.serialize(data1);
+    mem.serialize(data2);
+    CPPUNIT_ASSERT(data1 == data2);
+}
+
+void TSFileTest::writeFile(ts::TSPacketVector& packets, size_t count)
+{
+    // Build packets with distinct contents.
+    packets.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i] = ts::NullPacket;
+        ts::PutUInt32(packets[i].b + 4, uint32_t(i));
+    }
+
+    ts::TSFileOutput out;
+    CPPUNIT_ASSERT(out.open(_tempFile, false, false, NULLREP));
+    CPPUNIT_ASSERT(out.write(&packets[0], count, NULLREP));
+    CPPUNIT_ASSERT(out.close(NULLREP));
+}
+
+void TSFileTest::writeRead(size_t depth, size_t block_size, bool direct)
+{
+    // Build packets with distinct contents.
+    const size_t count = 1000;
+    ts::TSPacketVector packets(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i] = ts::NullPacket;
+        ts::PutUInt32(packets[i].b + 4, uint32_t(i));
+    }
+
+    ts::TSFileOutput out;
+    out.setAsyncIO(depth, block_size, direct);
+    CPPUNIT_ASSERT(out.open(_tempFile, false, false, NULLREP));
+    for (size_t i = 0; i < count; i += 7) {
+        CPPUNIT_ASSERT(out.write(&packets[i], std::min<size_t>(7, count - i), NULLREP));
+    }
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(count), out.getPacketCount());
+    CPPUNIT_ASSERT(out.close(NULLREP));
+    CPPUNIT_ASSERT_EQUAL(int64_t(count * ts::PKT_SIZE), ts::GetFileSize(_tempFile));
+
+    // Read twice, starting at packet 10.
+    const size_t start = 10;
+    ts::TSFileInput in;
+    in.setAsyncIO(depth, block_size, direct);
+    CPPUNIT_ASSERT(in.open(_tempFile, 2, start * ts::PKT_SIZE, NULLREP));
+
+    ts::TSPacketVector input(2 * count);
+    size_t total = 0;
+    size_t got = 0;
+    while ((got = in.read(&input[total], std::min<size_t>(100, input.size() - total), NULLREP)) > 0) {
+        total += got;
+    }
+    CPPUNIT_ASSERT(in.close(NULLREP));
+    CPPUNIT_ASSERT_EQUAL(2 * (count - start), total);
+
+    for (size_t i = 0; i < total; ++i) {
+        CPPUNIT_ASSERT(input[i] == packets[start + i % (count - start)]);
+    }
+}
@@ -0,0 +1,220 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::TSPacketQueue
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSPacketQueue.h"
+#include "utestCppUnitThread.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class TSPacketQueueTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testSingleThread();
+    void testTransfer();
+
+    CPPUNIT_TEST_SUITE(TSPacketQueueTest);
+    CPPUNIT_TEST(testSingleThread);
+    CPPUNIT_TEST(testTransfer);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TSPacketQueueTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void TSPacketQueueTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void TSPacketQueueTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void TSPacketQueueTest::testSingleThread()
+{
+    ts::TSPacketQueue queue(10);
+    ts::TSPacket* wbuf = nullptr;
+    const ts::TSPacket* rbuf = nullptr;
+    size_t size = 0;
+    ts::BitRate bitrate = 0;
+    ts::TSPacket pkt[10];
+
+    CPPUNIT_ASSERT_EQUAL(size_t(10), queue.bufferSize());
+    CPPUNIT_ASSERT(!queue.lockReadBuffer(rbuf, size, bitrate));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), size);
+
+    // Write 7 packets, read 5 of them.
+    CPPUNIT_ASSERT(queue.lockWriteBuffer(wbuf, size));
+    CPPUNIT_ASSERT_EQUAL(size_t(10), size);
+    for (size_t i = 0; i < 7; ++i) {
+        wbuf[i] = ts::NullPacket;
+        wbuf[i].b[4] = uint8_t(i);
+    }
+    queue.setBitrate(1000000);
+    queue.releaseWriteBuffer(7);
+    CPPUNIT_ASSERT_EQUAL(size_t(7), queue.currentSize());
+    CPPUNIT_ASSERT_EQUAL(size_t(5), queue.readPackets(pkt, 5, bitrate));
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(1000000), bitrate);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(4), pkt[4].b[4]);
+
+    // The write window stops at the end of the buffer.
+    CPPUNIT_ASSERT(queue.lockWriteBuffer(wbuf, size));
+    CPPUNIT_ASSERT_EQUAL(size_t(3), size);
+    for (size_t i = 0; i < 3; ++i) {
+        wbuf[i] = ts::NullPacket;
+        wbuf[i].b[4] = uint8_t(7 + i);
+    }
+    queue.releaseWriteBuffer(3);
+    CPPUNIT_ASSERT(queue.lockWriteBuffer(wbuf, size));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), size);
+    wbuf[0] = ts::NullPacket;
+    wbuf[0].b[4] = 10;
+    queue.releaseWriteBuffer(1);
+    CPPUNIT_ASSERT_EQUAL(size_t(6), queue.currentSize());
+    CPPUNIT_ASSERT_EQUAL(size_t(7), queue.highWaterMark());
+
+    // The read window stops at the end of the buffer.
+    CPPUNIT_ASSERT(queue.lockReadBuffer(rbuf, size, bitrate, 2));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), size);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(5), rbuf[0].b[4]);
+    queue.releaseReadBuffer(1);
+    CPPUNIT_ASSERT(queue.lockReadBuffer(rbuf, size, bitrate));
+    CPPUNIT_ASSERT_EQUAL(size_t(4), size);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(6), rbuf[0].b[4]);
+    queue.releaseReadBuffer(4);
+    CPPUNIT_ASSERT(queue.getPacket(pkt[0], bitrate));
+    CPPUNIT_ASSERT_EQUAL(uint8_t(10), pkt[0].b[4]);
+    CPPUNIT_ASSERT(!queue.getPacket(pkt[0], bitrate));
+
+    // End of file.
+    CPPUNIT_ASSERT(!queue.eof());
+    queue.setEOF();
+    CPPUNIT_ASSERT(queue.eof());
+    CPPUNIT_ASSERT(!queue.waitPackets(pkt, 10, size, bitrate));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), size);
+}
+
+// Thread for testTransfer()
+namespace {
+    class TSPacketQueueTestThread: public utest::CppUnitThread
+    {
+    private:
+        ts::TSPacketQueue& _queue;
+        size_t _count;
+    public:
+        TSPacketQueueTestThread(ts::TSPacketQueue& queue, size_t count) :
+            utest::CppUnitThread(),
+            _queue(queue),
+            _count(count)
+        {
+        }
+
+        virtual ~TSPacketQueueTestThread() override
+        {
+            waitForTermination();
+        }
+
+        virtual void test() override
+        {
+            // Write packets with consecutive contents, using various write sizes.
+            size_t total = 0;
+            while (total < _count) {
+                ts::TSPacket* buffer = nullptr;
+                size_t size = 0;
+                CPPUNIT_ASSERT(_queue.lockWriteBuffer(buffer, size, 1 + total % 13));
+                size = std::min(std::min(size, 1 + total % 17), _count - total);
+                for (size_t i = 0; i < size; ++i) {
+                    buffer[i] = ts::NullPacket;
+                    ts::PutUInt32(buffer[i].b + 4, uint32_t(total++));
+                }
+                _queue.releaseWriteBuffer(size);
+            }
+            _queue.setEOF();
+        }
+    };
+}
+
+void TSPacketQueueTest::testTransfer()
+{
+    const size_t count = 100000;
+    ts::TSPacketQueue queue(100);
+    TSPacketQueueTestThread thread(queue, count);
+    CPPUNIT_ASSERT(thread.start());
+
+    // Read packets using all read methods.
+    size_t total = 0;
+    ts::TSPacket buffer[20];
+    ts::BitRate bitrate = 0;
+    for (int method = 0; !queue.eof(); method = (method + 1) % 3) {
+        size_t size = 0;
+        const ts::TSPacket* data = nullptr;
+        switch (method) {
+            case 0:
+                queue.waitPackets(buffer, 20, size, bitrate);
+                data = buffer;
+                break;
+            case 1:
+                size = queue.readPackets(buffer, 7, bitrate);
+                data = buffer;
+                break;
+            default:
+                queue.lockReadBuffer(data, size, bitrate, 11);
+                break;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            CPPUNIT_ASSERT_EQUAL(uint32_t(total++), ts::GetUInt32(data[i].b + 4));
+        }
+        if (method == 2) {
+            queue.releaseReadBuffer(size);
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(count, total);
+    CPPUNIT_ASSERT(queue.highWaterMark() <= 100);
+}
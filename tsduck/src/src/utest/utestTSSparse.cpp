@@ -0,0 +1,196 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for sparse transport stream files.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSSparseEncoder.h"
+#include "tsTSSparseDecoder.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class TSSparseTest: public CppUnit::TestFixture
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testRoundTrip();
+    void testPlain();
+
+    CPPUNIT_TEST_SUITE(TSSparseTest);
+    CPPUNIT_TEST(testRoundTrip);
+    CPPUNIT_TEST(testPlain);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TSSparseTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void TSSparseTest::setUp()
+{
+}
+
+// Test suite cleanup method.
+void TSSparseTest::tearDown()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Append a data packet with a sequence number in the payload.
+    void AddData(ts::TSPacketVector& ts, uint32_t seq)
+    {
+        ts::TSPacket pkt;
+        pkt = ts::NullPacket;
+        pkt.setPID(100);
+        ts::PutUInt32(pkt.b + 4, seq);
+        ts.push_back(pkt);
+    }
+
+    // Append null packets.
+    void AddNull(ts::TSPacketVector& ts, size_t count, uint8_t fill = 0xFF, uint8_t cc = 0)
+    {
+        ts::TSPacket pkt;
+        pkt = ts::NullPacket;
+        ::memset(pkt.b + 4, fill, ts::PKT_SIZE - 4);
+        pkt.setCC(cc);
+        ts.insert(ts.end(), count, pkt);
+    }
+
+    // Encode in chunks of various sizes.
+    void Encode(const ts::TSPacketVector& ts, ts::TSPacketVector& units)
+    {
+        ts::TSSparseEncoder encoder;
+        size_t chunk = 1;
+        for (size_t i = 0; i < ts.size(); i += chunk, chunk = chunk % 97 + 13) {
+            encoder.encode(&ts[i], std::min(chunk, ts.size() - i), units);
+        }
+        encoder.flush(units);
+        CPPUNIT_ASSERT_EQUAL(size_t(0), encoder.pendingUnits());
+        CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(ts.size()), encoder.inputPackets());
+        CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(units.size()), encoder.outputUnits());
+    }
+
+    // Decode with output buffers of various sizes.
+    void Decode(const ts::TSPacketVector& units, ts::TSPacketVector& ts, ts::TSSparseDecoder& decoder)
+    {
+        ts::TSPacket buffer[50];
+        size_t max = 1;
+        const ts::TSPacket* in = units.empty() ? nullptr : &units[0];
+        size_t in_count = units.size();
+        for (;;) {
+            const size_t count = decoder.decode(in, in_count, buffer, max);
+            if (count == 0) {
+                break;
+            }
+            ts.insert(ts.end(), buffer, buffer + count);
+            max = max % 50 + 1;
+        }
+        CPPUNIT_ASSERT_EQUAL(size_t(0), in_count);
+    }
+}
+
+void TSSparseTest::testRoundTrip()
+{
+    ts::TSPacketVector ts;
+    uint32_t seq = 0;
+
+    AddNull(ts, 5);
+    for (size_t i = 0; i < 1000; ++i) {
+        AddData(ts, seq++);
+        AddNull(ts, i % 3);
+    }
+    AddNull(ts, 300);                                    // multi-byte run length
+    AddData(ts, seq++);
+    AddNull(ts, 250000);                                 // more than MAX_TRAILING_NULLS
+    AddData(ts, seq++);
+    AddNull(ts, 10, 0x00);                               // other payload byte
+    AddData(ts, seq++);
+    AddNull(ts, 3, 0x00, 5);                             // not elidable, CC not zero
+    AddNull(ts, 7);
+
+    ts::TSPacketVector units;
+    Encode(ts, units);
+    CPPUNIT_ASSERT(!units.empty());
+    CPPUNIT_ASSERT(ts::TSSparseEncoder::IsMap(units[0]));
+
+    // Stored packets are the data packets and the non-elidable nulls, plus the maps.
+    size_t maps = 0;
+    for (size_t i = 0; i < units.size(); ++i) {
+        maps += ts::TSSparseEncoder::IsMap(units[i]);
+    }
+    CPPUNIT_ASSERT_EQUAL(units.size(), maps + seq + 3);
+    CPPUNIT_ASSERT(maps < 20);
+
+    ts::TSSparseDecoder decoder;
+    ts::TSPacketVector ts2;
+    Decode(units, ts2, decoder);
+    CPPUNIT_ASSERT(decoder.isSparse());
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(0), decoder.errors());
+    CPPUNIT_ASSERT_EQUAL(ts.size(), ts2.size());
+    for (size_t i = 0; i < ts.size(); ++i) {
+        CPPUNIT_ASSERT(ts[i] == ts2[i]);
+    }
+    CPPUNIT_ASSERT(decoder.checkpoint().index > 250000);
+}
+
+void TSSparseTest::testPlain()
+{
+    ts::TSPacketVector ts;
+    for (uint32_t i = 0; i < 100; ++i) {
+        AddData(ts, i);
+        AddNull(ts, 1);
+    }
+
+    // A plain transport stream is returned unmodified.
+    ts::TSSparseDecoder decoder;
+    ts::TSPacketVector ts2;
+    Decode(ts, ts2, decoder);
+    CPPUNIT_ASSERT(!decoder.isSparse());
+    CPPUNIT_ASSERT_EQUAL(ts.size(), ts2.size());
+    for (size_t i = 0; i < ts.size(); ++i) {
+        CPPUNIT_ASSERT(ts[i] == ts2[i]);
+    }
+}
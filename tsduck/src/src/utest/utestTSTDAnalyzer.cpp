@@ -0,0 +1,453 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2018, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  CppUnit test suite for class ts::TSTDAnalyzer
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSTDAnalyzer.h"
+#include "tsTSTDHandlerInterface.h"
+#include "tsOneShotPacketizer.h"
+#include "tsBinaryTable.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsSmoothingBufferDescriptor.h"
+#include "tsPCR.h"
+#include "utestCppUnitTest.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+// Stream model: one packet per millisecond, PCR PID 100, audio PID 101, video PID 102.
+namespace {
+    const ts::PID  PCR_PID = 100;
+    const ts::PID  AUDIO_PID = 101;
+    const ts::PID  VIDEO_PID = 102;
+    const uint64_t PKT_TICKS = ts::SYSTEM_CLOCK_FREQ / 1000;
+}
+
+class TSTDAnalyzerTest: public CppUnit::TestFixture, private ts::TSTDHandlerInterface
+{
+public:
+    virtual void setUp() override;
+    virtual void tearDown() override;
+
+    void testNominal();
+    void testOverflow();
+    void testUnderflow();
+    void testDiscontinuity();
+    void testVideoMB();
+    void testTBOverflow();
+
+    CPPUNIT_TEST_SUITE(TSTDAnalyzerTest);
+    CPPUNIT_TEST(testNominal);
+    CPPUNIT_TEST(testOverflow);
+    CPPUNIT_TEST(testUnderflow);
+    CPPUNIT_TEST(testDiscontinuity);
+    CPPUNIT_TEST(testVideoMB);
+    CPPUNIT_TEST(testTBOverflow);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::vector<ts::TSTDAnalyzer::Event> _events;
+    uint64_t _index;
+    uint64_t _base;
+    bool     _discontinuity;
+    uint8_t  _cc;
+    uint8_t  _pmt_cc;
+    uint8_t  _video[170];
+
+    virtual void handleTSTDEvent(ts::TSTDAnalyzer& analyzer, const ts::TSTDAnalyzer::Event& event) override;
+
+    // Build the PMT of the test stream, with one elementary stream.
+    static ts::PMT makePMT(uint8_t version, ts::PID pid, uint8_t stream_type);
+
+    // Send a PMT to an analyzer.
+    void sendPMT(ts::TSTDAnalyzer& analyzer, const ts::PMT& pmt);
+
+    // Send PSI and the first two PCR's to an analyzer.
+    void startStream(ts::TSTDAnalyzer& analyzer, const ts::PMT& pmt = makePMT(0, AUDIO_PID, ts::ST_MPEG1_AUDIO));
+
+    // Build the content of the video PES packets: sequence header, MPEG-2 sequence extension if pl_code is not zero.
+    void setVideo(uint32_t bitrate, uint32_t vbv_size, uint8_t pl_code);
+
+    // Send one packet: a PCR every 10 packets, otherwise an audio or video PES packet when pts_offset_ms is not negative.
+    void sendPacket(ts::TSTDAnalyzer& analyzer, int64_t pts_offset_ms, ts::PID pid = AUDIO_PID);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TSTDAnalyzerTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void TSTDAnalyzerTest::setUp()
+{
+    _events.clear();
+    _index = 0;
+    _base = 0;
+    _discontinuity = false;
+    _cc = 0;
+    _pmt_cc = 0;
+    ::memset(_video, 0, sizeof(_video));
+}
+
+// Test suite cleanup method.
+void TSTDAnalyzerTest::tearDown()
+{
+}
+
+void TSTDAnalyzerTest::handleTSTDEvent(ts::TSTDAnalyzer& analyzer, const ts::TSTDAnalyzer::Event& event)
+{
+    utest::Out() << "TSTDAnalyzerTest: " << (event.raised ? "raised " : "cleared ")
+                 << ts::TSTDAnalyzer::ViolationNames.name(event.violation)
+                 << " at " << event.timestamp << " ns, " << event.details << std::endl;
+    _events.push_back(event);
+}
+
+ts::PMT TSTDAnalyzerTest::makePMT(uint8_t version, ts::PID pid, uint8_t stream_type)
+{
+    ts::PMT pmt(version, true, 1, PCR_PID);
+    pmt.streams[pid].stream_type = stream_type;
+    return pmt;
+}
+
+void TSTDAnalyzerTest::sendPMT(ts::TSTDAnalyzer& analyzer, const ts::PMT& pmt)
+{
+    ts::BinaryTable table;
+    ts::TSPacketVector packets;
+    ts::OneShotPacketizer pzer(1000, true);
+    pmt.serialize(table);
+    pzer.setNextContinuityCounter(_pmt_cc);
+    pzer.addTable(table);
+    pzer.getPackets(packets);
+    _pmt_cc = pzer.nextContinuityCounter();
+    for (auto it = packets.begin(); it != packets.end(); ++it) {
+        analyzer.feedPacket(*it);
+        _index++;
+    }
+}
+
+void TSTDAnalyzerTest::startStream(ts::TSTDAnalyzer& analyzer, const ts::PMT& pmt)
+{
+    ts::PAT pat(0, true, 1);
+    pat.pmts[1] = 1000;
+
+    ts::BinaryTable pat_table;
+    ts::TSPacketVector pat_packets;
+    ts::OneShotPacketizer pat_pzer(ts::PID_PAT, true);
+    pat.serialize(pat_table);
+    pat_pzer.addTable(pat_table);
+    pat_pzer.getPackets(pat_packets);
+    for (auto it = pat_packets.begin(); it != pat_packets.end(); ++it) {
+        analyzer.feedPacket(*it);
+        _index++;
+    }
+    sendPMT(analyzer, pmt);
+
+    // Align on a PCR position.
+    while (_index % 10 != 0) {
+        sendPacket(analyzer, -1);
+    }
+    for (int i = 0; i < 11; ++i) {
+        sendPacket(analyzer, -1);
+    }
+}
+
+void TSTDAnalyzerTest::setVideo(uint32_t bitrate, uint32_t vbv_size, uint8_t pl_code)
+{
+    // Sequence header: 720x576, 4:3, 25 Hz, bit_rate in units of 400 b/s, vbv_buffer_size in units of 16 kbits.
+    static const uint8_t header[] = {0x00, 0x00, 0x01, 0xB3, 0x2D, 0x02, 0x40, 0x23};
+    ::memset(_video, 0, sizeof(_video));
+    ::memcpy(_video, header, sizeof(header));
+    ts::PutUInt32(_video + 8, ((bitrate / 400) << 14) | 0x2000 | ((vbv_size / (16 * 1024)) << 3));
+    if (pl_code != 0) {
+        // Sequence extension: progressive 4:2:0.
+        static const uint8_t ext[] = {0x00, 0x00, 0x01, 0xB5};
+        ::memcpy(_video + 12, ext, sizeof(ext));
+        _video[16] = uint8_t(0x10 | (pl_code >> 4));
+        _video[17] = uint8_t((pl_code << 4) | 0x0A);
+    }
+    else {
+        // MPEG-1 video: group of pictures.
+        static const uint8_t gop[] = {0x00, 0x00, 0x01, 0xB8};
+        ::memcpy(_video + 12, gop, sizeof(gop));
+    }
+}
+
+void TSTDAnalyzerTest::sendPacket(ts::TSTDAnalyzer& analyzer, int64_t pts_offset_ms, ts::PID pid)
+{
+    ts::TSPacket pkt;
+    pkt.copyFrom(ts::NullPacket.b);
+    const uint64_t now = _base + _index * PKT_TICKS;
+
+    if (_index % 10 == 0) {
+        // Adaptation field only, with PCR.
+        pkt.setPID(PCR_PID);
+        pkt.b[3] = 0x20;
+        pkt.b[4] = 183;
+        pkt.b[5] = _discontinuity ? 0x90 : 0x10;
+        ts::PutPCR(pkt.b + 6, now);
+        _discontinuity = false;
+    }
+    else if (pts_offset_ms >= 0) {
+        // One complete PES packet: 14-byte header with PTS, 170 bytes of data.
+        static const uint8_t header[] = {0x00, 0x00, 0x01, 0xC0, 0x00, 178, 0x80, 0x80, 0x05, 0x21, 0x00, 0x01, 0x00, 0x01};
+        pkt.setPID(pid);
+        pkt.setPUSI();
+        pkt.setCC(_cc++ & ts::CC_MASK);
+        ::memcpy(pkt.b + 4, header, sizeof(header));
+        if (pid == VIDEO_PID) {
+            pkt.b[7] = 0xE0;
+            ::memcpy(pkt.b + 4 + sizeof(header), _video, sizeof(_video));
+        }
+        pkt.setPTS((now + uint64_t(pts_offset_ms) * PKT_TICKS) / ts::SYSTEM_CLOCK_SUBFACTOR);
+    }
+    analyzer.feedPacket(pkt);
+    _index++;
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void TSTDAnalyzerTest::testNominal()
+{
+    ts::TSTDAnalyzer analyzer(this);
+    startStream(analyzer);
+
+    // One access unit every 5 ms, decoded 50 ms after arrival.
+    for (int i = 0; i < 1000; ++i) {
+        sendPacket(analyzer, i % 5 == 1 ? 50 : -1);
+    }
+    CPPUNIT_ASSERT(_events.empty());
+
+    ts::TSTDAnalyzer::StreamStatusVector status;
+    analyzer.getStatus(status);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), status.size());
+    CPPUNIT_ASSERT_EQUAL(AUDIO_PID, status[0].pid);
+    CPPUNIT_ASSERT(status[0].simulated);
+    CPPUNIT_ASSERT(!status[0].has_mb);
+    CPPUNIT_ASSERT_EQUAL(size_t(512), status[0].tb_size);
+    CPPUNIT_ASSERT_EQUAL(size_t(3584), status[0].eb_size);
+    CPPUNIT_ASSERT(status[0].access_units > 150);
+    CPPUNIT_ASSERT(status[0].eb_max > 0);
+    CPPUNIT_ASSERT(status[0].eb_max < status[0].eb_size);
+}
+
+void TSTDAnalyzerTest::testOverflow()
+{
+    ts::TSTDAnalyzer analyzer(this);
+    startStream(analyzer);
+
+    // Access units are decoded much too late, EB fills up.
+    for (int i = 0; i < 200; ++i) {
+        sendPacket(analyzer, i % 2 == 1 ? 1000 : -1);
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.violationCount(ts::TSTDAnalyzer::EB_OVERFLOW));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), analyzer.violationCount(ts::TSTDAnalyzer::EB_UNDERFLOW));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), _events.size());
+    CPPUNIT_ASSERT(_events[0].raised);
+    CPPUNIT_ASSERT_EQUAL(ts::TSTDAnalyzer::EB_OVERFLOW, _events[0].violation);
+    CPPUNIT_ASSERT_EQUAL(AUDIO_PID, _events[0].pid);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(1), _events[0].service_id);
+}
+
+void TSTDAnalyzerTest::testUnderflow()
+{
+    ts::TSTDAnalyzer analyzer(this);
+    startStream(analyzer);
+
+    // An access unit arrives at its decoding time, it cannot be completely in EB.
+    sendPacket(analyzer, 0);
+    for (int i = 0; i < 20; ++i) {
+        sendPacket(analyzer, -1);
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.violationCount(ts::TSTDAnalyzer::EB_UNDERFLOW));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), _events.size());
+    CPPUNIT_ASSERT(_events[0].raised);
+    CPPUNIT_ASSERT_EQUAL(ts::TSTDAnalyzer::EB_UNDERFLOW, _events[0].violation);
+
+    // The violation is cleared when an access unit is decoded on time.
+    sendPacket(analyzer, 10);
+    for (int i = 0; i < 20; ++i) {
+        sendPacket(analyzer, -1);
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(2), _events.size());
+    CPPUNIT_ASSERT(!_events[1].raised);
+    CPPUNIT_ASSERT_EQUAL(ts::TSTDAnalyzer::EB_UNDERFLOW, _events[1].violation);
+
+    ts::TSTDAnalyzer::StreamStatusVector status;
+    analyzer.getStatus(status);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), status.size());
+    CPPUNIT_ASSERT_EQUAL(ts::PacketCounter(2), status[0].access_units);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), status[0].violations[ts::TSTDAnalyzer::EB_UNDERFLOW]);
+}
+
+void TSTDAnalyzerTest::testDiscontinuity()
+{
+    ts::TSTDAnalyzer analyzer(this);
+    startStream(analyzer);
+
+    // Raise an underflow.
+    sendPacket(analyzer, 0);
+    for (int i = 0; i < 20; ++i) {
+        sendPacket(analyzer, -1);
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(1), _events.size());
+    CPPUNIT_ASSERT(_events[0].raised);
+
+    // PCR discontinuity, backward on a new time base: the active violation is cleared.
+    while (_index % 10 != 0) {
+        sendPacket(analyzer, -1);
+    }
+    _base = 0;
+    _discontinuity = true;
+    _index = 10;
+    for (int i = 0; i < 20; ++i) {
+        sendPacket(analyzer, -1);
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(2), _events.size());
+    CPPUNIT_ASSERT(!_events[1].raised);
+    CPPUNIT_ASSERT_EQUAL(ts::TSTDAnalyzer::EB_UNDERFLOW, _events[1].violation);
+
+    // The simulation restarts on the new time base, without violation.
+    for (int i = 0; i < 1000; ++i) {
+        sendPacket(analyzer, i % 5 == 1 ? 50 : -1);
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(2), _events.size());
+
+    // Restart on a forward jump without discontinuity indicator.
+    _base += 10 * ts::SYSTEM_CLOCK_FREQ;
+    for (int i = 0; i < 1000; ++i) {
+        sendPacket(analyzer, i % 5 == 1 ? 50 : -1);
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(2), _events.size());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.violationCount(ts::TSTDAnalyzer::EB_UNDERFLOW));
+
+    ts::TSTDAnalyzer::StreamStatusVector status;
+    analyzer.getStatus(status);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), status.size());
+    CPPUNIT_ASSERT(status[0].access_units > 350);
+}
+
+void TSTDAnalyzerTest::testVideoMB()
+{
+    ts::TSTDAnalyzer analyzer(this);
+    startStream(analyzer, makePMT(0, VIDEO_PID, ts::ST_MPEG2_VIDEO));
+
+    // MPEG-2 video, Main profile at Main level, 8 Mb/s, vbv_buffer_size 100 x 16 kbits.
+    setVideo(8000000, 100 * 16 * 1024, 0x48);
+    for (int i = 0; i < 200; ++i) {
+        sendPacket(analyzer, i % 5 == 1 ? 100 : -1, VIDEO_PID);
+    }
+    CPPUNIT_ASSERT(_events.empty());
+
+    // Rx = 1.2 * Rmax, Rbx = Rmax, MB = BSmux + BSoh + VBV_max - vbv_buffer_size, from Rmax = 15 Mb/s and VBV_max = 1835008 bits.
+    ts::TSTDAnalyzer::StreamStatusVector status;
+    analyzer.getStatus(status);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), status.size());
+    CPPUNIT_ASSERT(status[0].simulated);
+    CPPUNIT_ASSERT(status[0].has_mb);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(18000000), status[0].rx);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(15000000), status[0].rbx);
+    CPPUNIT_ASSERT_EQUAL(size_t(10000 + (1835008 - 1638400) / 8), status[0].mb_size);
+    CPPUNIT_ASSERT_EQUAL(size_t(1638400 / 8), status[0].eb_size);
+    CPPUNIT_ASSERT(status[0].access_units > 10);
+
+    // A PMT update adds a small and slow smoothing buffer, the configured stream uses it immediately.
+    ts::PMT pmt(makePMT(1, VIDEO_PID, ts::ST_MPEG2_VIDEO));
+    ts::SmoothingBufferDescriptor sb;
+    sb.sb_leak_rate = 1;
+    sb.sb_size = 1000;
+    pmt.streams[VIDEO_PID].descs.add(sb);
+    sendPMT(analyzer, pmt);
+    analyzer.getStatus(status);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), status.size());
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(400), status[0].rbx);
+    CPPUNIT_ASSERT_EQUAL(size_t(1000), status[0].mb_size);
+
+    for (int i = 0; i < 50; ++i) {
+        sendPacket(analyzer, i % 5 == 1 ? 100 : -1, VIDEO_PID);
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.violationCount(ts::TSTDAnalyzer::MB_OVERFLOW));
+
+    // A PMT update removes the descriptor, the default model is restored and MB drains.
+    _events.clear();
+    sendPMT(analyzer, makePMT(2, VIDEO_PID, ts::ST_MPEG2_VIDEO));
+    analyzer.getStatus(status);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(15000000), status[0].rbx);
+    CPPUNIT_ASSERT_EQUAL(size_t(10000 + (1835008 - 1638400) / 8), status[0].mb_size);
+
+    for (int i = 0; i < 50; ++i) {
+        sendPacket(analyzer, -1);
+    }
+    bool cleared = false;
+    for (auto it = _events.begin(); it != _events.end(); ++it) {
+        cleared = cleared || (!it->raised && it->violation == ts::TSTDAnalyzer::MB_OVERFLOW);
+    }
+    CPPUNIT_ASSERT(cleared);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.violationCount(ts::TSTDAnalyzer::MB_OVERFLOW));
+}
+
+void TSTDAnalyzerTest::testTBOverflow()
+{
+    ts::TSTDAnalyzer analyzer(this);
+    startStream(analyzer, makePMT(0, VIDEO_PID, ts::ST_MPEG1_VIDEO));
+
+    // MPEG-1 video at 100 kb/s: Rx = 120 kb/s, much less than one packet per millisecond.
+    setVideo(100000, 20 * 16 * 1024, 0);
+    for (int i = 0; i < 40; ++i) {
+        sendPacket(analyzer, i % 20 == 1 ? 1000 : -1, VIDEO_PID);
+    }
+    CPPUNIT_ASSERT(_events.empty());
+
+    ts::TSTDAnalyzer::StreamStatusVector status;
+    analyzer.getStatus(status);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), status.size());
+    CPPUNIT_ASSERT(status[0].simulated);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(120000), status[0].rx);
+    CPPUNIT_ASSERT_EQUAL(ts::BitRate(100000), status[0].rbx);
+
+    // A burst of video packets.
+    for (int i = 0; i < 5; ++i) {
+        sendPacket(analyzer, 1000, VIDEO_PID);
+    }
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), analyzer.violationCount(ts::TSTDAnalyzer::TB_OVERFLOW));
+    CPPUNIT_ASSERT(!_events.empty());
+    CPPUNIT_ASSERT(_events[0].raised);
+    CPPUNIT_ASSERT_EQUAL(ts::TSTDAnalyzer::TB_OVERFLOW, _events[0].violation);
+    CPPUNIT_ASSERT_EQUAL(VIDEO_PID, _events[0].pid);
+}
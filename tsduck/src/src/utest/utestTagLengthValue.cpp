@@ -52,12 +52,16 @@ public:
     void testEMMG();
     void testECMGError();
     void testEMMGError();
+    void testReuseBuffer();
+    void testParameterOrder();
 
     CPPUNIT_TEST_SUITE(TagLengthValueTest);
     CPPUNIT_TEST(testECMG);
     CPPUNIT_TEST(testEMMG);
     CPPUNIT_TEST(testECMGError);
     CPPUNIT_TEST(testEMMGError);
+    CPPUNIT_TEST(testReuseBuffer);
+    CPPUNIT_TEST(testParameterOrder);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -347,3 +351,76 @@ void TagLengthValueTest::testEMMGError()
     utest::Out() << "TagLengthValueTest::testEMMGError: dump" << std::endl << str << std::endl;
     CPPUNIT_ASSERT_USTRINGS_EQUAL(refString, str);
 }
+
+void TagLengthValueTest::testReuseBuffer()
+{
+    ts::ecmgscs::StreamCloseRequest msg1;
+    msg1.channel_id = 0x1234;
+    msg1.stream_id = 0x5678;
+
+    ts::ecmgscs::ChannelTest msg2;
+    msg2.channel_id = 0x0102;
+
+    // Serialize two messages, one after the other, in the same buffer.
+    ts::ByteBlock data;
+    {
+        ts::tlv::Serializer zer(data);
+        msg1.serialize(zer);
+    }
+    const ts::ByteBlock ref1(data);
+    const uint8_t* const base = data.data();
+
+    data.clear();
+    {
+        ts::tlv::Serializer zer(data);
+        msg2.serialize(zer);
+    }
+    CPPUNIT_ASSERT(data.size() < ref1.size());
+    CPPUNIT_ASSERT(data.data() == base);
+
+    // Same result as a serialization in a new block.
+    ts::ByteBlockPtr ref2(new ts::ByteBlock);
+    ts::tlv::Serializer zer2(ref2);
+    msg2.serialize(zer2);
+    CPPUNIT_ASSERT(data == *ref2);
+
+    // The factory works directly on the serialized buffer.
+    ts::tlv::MessageFactory fac(ref1, ts::ecmgscs::Protocol::Instance());
+    CPPUNIT_ASSERT_EQUAL(ts::tlv::OK, fac.errorStatus());
+    ts::tlv::MessageFactory::Parameter param;
+    fac.get(ts::ecmgscs::Tags::ECM_stream_id, param);
+    CPPUNIT_ASSERT(param.addr >= ref1.data() && param.addr < ref1.data() + ref1.size());
+    CPPUNIT_ASSERT_EQUAL(uint16_t(0x5678), ts::GetUInt16(param.addr));
+}
+
+void TagLengthValueTest::testParameterOrder()
+{
+    // A stream_error with interleaved repeated parameters.
+    static uint8_t refData[] = {
+        0x03,
+        0x01, 0x16, 0x00, 0x2C,
+        0x70, 0x00, 0x00, 0x02, 0x00, 0x0F,
+        0x00, 0x03, 0x00, 0x02, 0x00, 0x02,
+        0x70, 0x01, 0x00, 0x02, 0x12, 0x34,
+        0x70, 0x00, 0x00, 0x02, 0x00, 0x14,
+        0x00, 0x01, 0x00, 0x04, 0x00, 0x00, 0x00, 0x04,
+        0x00, 0x04, 0x00, 0x02, 0x00, 0x03,
+        0x70, 0x01, 0x00, 0x02, 0x56, 0x78,
+    };
+
+    ts::tlv::MessageFactory fac(refData, sizeof(refData), ts::emmgmux::Protocol::Instance());
+    CPPUNIT_ASSERT_EQUAL(ts::tlv::OK, fac.errorStatus());
+    CPPUNIT_ASSERT_EQUAL(size_t(2), fac.count(ts::emmgmux::Tags::error_status));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), fac.count(ts::emmgmux::Tags::error_information));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), fac.count(ts::emmgmux::Tags::client_id));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), fac.count(ts::emmgmux::Tags::data_id));
+
+    ts::tlv::MessagePtr msg(fac.factory());
+    ts::emmgmux::StreamError* ptr = dynamic_cast<ts::emmgmux::StreamError*>(msg.pointer());
+    CPPUNIT_ASSERT(ptr != nullptr);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(4), ptr->client_id);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(2), ptr->channel_id);
+    CPPUNIT_ASSERT_EQUAL(uint16_t(3), ptr->stream_id);
+    CPPUNIT_ASSERT_EQUAL(std::vector<uint16_t>({0x000F, 0x0014}), ptr->error_status);
+    CPPUNIT_ASSERT_EQUAL(std::vector<uint16_t>({0x1234, 0x5678}), ptr->error_information);
+}